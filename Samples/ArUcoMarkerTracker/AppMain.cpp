@@ -27,8 +27,42 @@ namespace ArUcoMarkerTracker
         int y;
     };
 
+    //
+    // Samples the unit plane of a camera at the center of each of its pixels.
+    // The intrinsics of the visible light cameras do not change, so this is
+    // done once per camera, rather than calling into the intrinsics for each
+    // corner of each marker detected.
+    //
+    std::shared_ptr<const Io::UnprojectionLut> CreateUnprojectionLut(
+        HoloLensForCV::CameraIntrinsics^ cameraIntrinsics)
+    {
+        auto unprojectionLut =
+            std::make_shared<Io::UnprojectionLut>();
+
+        unprojectionLut->Sample(
+            cameraIntrinsics->ImageWidth,
+            cameraIntrinsics->ImageHeight,
+            [cameraIntrinsics](float u, float v, float* x, float* y)
+            {
+                Windows::Foundation::Point uv = { u, v }, xy;
+
+                if (!cameraIntrinsics->MapImagePointToCameraUnitPlane(uv, &xy))
+                {
+                    return false;
+                }
+
+                *x = xy.X;
+                *y = xy.Y;
+
+                return true;
+            });
+
+        return unprojectionLut;
+    }
+
     std::map<int32_t, DetectedMarker> DetectArUcoMarkers(
-        HoloLensForCV::SensorFrame^ frame)
+        HoloLensForCV::SensorFrame^ frame,
+        const Io::UnprojectionLut& unprojectionLut)
     {
         std::map<int32_t, DetectedMarker> detectedMarkers;
 
@@ -105,22 +139,17 @@ namespace ArUcoMarkerTracker
                     detectedMarker.y = static_cast<int>(markerCorners[j].y);
                     detectedMarker.point = camPinhole;
 
-                    Windows::Foundation::Point uv;
-
-                    uv.X = static_cast<float>(markerCorners[j].x);
-                    uv.Y = static_cast<float>(markerCorners[j].y);
-
-                    Windows::Foundation::Point xy;
+                    Eigen::Vector3f dirCam;
 
-                    if (!frame->SensorStreamingCameraIntrinsics->MapImagePointToCameraUnitPlane(uv, &xy))
+                    if (!unprojectionLut.MapImagePointToCameraUnitPlane(
+                            markerCorners[j].x,
+                            markerCorners[j].y,
+                            &dirCam[0],
+                            &dirCam[1]))
                     {
                         continue;
                     }
 
-                    Eigen::Vector3f dirCam;
-
-                    dirCam[0] = xy.X;
-                    dirCam[1] = xy.Y;
                     dirCam[2] = 1.0f;
 
                     detectedMarker.dir =
@@ -143,7 +172,9 @@ namespace ArUcoMarkerTracker
 
     std::map<int32_t, TrackedMarker> TrackArUcoMarkers(
         HoloLensForCV::SensorFrame^ leftFrame,
-        HoloLensForCV::SensorFrame^ rightFrame)
+        const Io::UnprojectionLut& leftUnprojectionLut,
+        HoloLensForCV::SensorFrame^ rightFrame,
+        const Io::UnprojectionLut& rightUnprojectionLut)
     {
         std::map<int32_t, TrackedMarker> trackedMarkers;
 
@@ -156,8 +187,8 @@ namespace ArUcoMarkerTracker
 
         auto leftCamToOrigin = leftCamToRef * leftFrame->FrameToOrigin;
 
-        auto leftDetections = DetectArUcoMarkers(leftFrame);
-        auto rightDetections = DetectArUcoMarkers(rightFrame);
+        auto leftDetections = DetectArUcoMarkers(leftFrame, leftUnprojectionLut);
+        auto rightDetections = DetectArUcoMarkers(rightFrame, rightUnprojectionLut);
 
         for (auto leftDetectionIterator : leftDetections)
         {
@@ -251,22 +282,17 @@ namespace ArUcoMarkerTracker
     {
         const float c_timestampTolerance = 0.001f;
 
-        auto commonTime = _multiFrameBuffer->GetTimestampForSensorPair(
-            HoloLensForCV::SensorType::VisibleLightLeftFront,
-            HoloLensForCV::SensorType::VisibleLightRightFront,
-            c_timestampTolerance);
+        auto sensors =
+            ref new Platform::Array<HoloLensForCV::SensorType>(2);
 
-        HoloLensForCV::SensorFrame^ leftFrame = _multiFrameBuffer->GetFrameForTime(
-            HoloLensForCV::SensorType::VisibleLightLeftFront,
-            commonTime,
-            c_timestampTolerance);
+        sensors[0] = HoloLensForCV::SensorType::VisibleLightLeftFront;
+        sensors[1] = HoloLensForCV::SensorType::VisibleLightRightFront;
 
-        HoloLensForCV::SensorFrame^ rightFrame = _multiFrameBuffer->GetFrameForTime(
-            HoloLensForCV::SensorType::VisibleLightRightFront,
-            commonTime,
+        HoloLensForCV::SensorFrameTuple^ frameTuple = _multiFrameBuffer->GetLatestFrameTuple(
+            sensors,
             c_timestampTolerance);
 
-        if (!leftFrame || !rightFrame)
+        if (!frameTuple)
         {
 #if 0
             dbg::trace(L"AppMain::OnUpdateFor3DTracking: ref of depth frame missing");
@@ -275,6 +301,9 @@ namespace ArUcoMarkerTracker
             return;
         }
 
+        HoloLensForCV::SensorFrame^ leftFrame = frameTuple->Frames->GetAt(0);
+        HoloLensForCV::SensorFrame^ rightFrame = frameTuple->Frames->GetAt(1);
+
         auto timeDiff100ns = leftFrame->Timestamp.UniversalTime - rightFrame->Timestamp.UniversalTime;
 
         if (std::abs(timeDiff100ns * 1e-7f) > 2e-3f)
@@ -308,9 +337,24 @@ namespace ArUcoMarkerTracker
 
         concurrency::create_task([this, leftFrame, rightFrame]()
         {
+            //
+            // Only one marker update runs at a time, so the LUTs are created
+            // without a lock.
+            //
+            if (nullptr == _leftUnprojectionLut)
+            {
+                _leftUnprojectionLut = CreateUnprojectionLut(
+                    leftFrame->SensorStreamingCameraIntrinsics);
+
+                _rightUnprojectionLut = CreateUnprojectionLut(
+                    rightFrame->SensorStreamingCameraIntrinsics);
+            }
+
             auto trackedMarkers = TrackArUcoMarkers(
                 leftFrame,
-                rightFrame);
+                *_leftUnprojectionLut,
+                rightFrame,
+                *_rightUnprojectionLut);
 
             {
                 std::lock_guard<std::mutex> guard(_markerRenderersMutex);
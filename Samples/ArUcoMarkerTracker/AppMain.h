@@ -51,6 +51,10 @@ namespace ArUcoMarkerTracker
         std::mutex _markerRenderersMutex;
         volatile long _markerUpdatesInProgress{ 0 };
 
+        // Of the left and right front cameras, created by the first marker update.
+        std::shared_ptr<const Io::UnprojectionLut> _leftUnprojectionLut;
+        std::shared_ptr<const Io::UnprojectionLut> _rightUnprojectionLut;
+
         // Selected HoloLens media frame source group
         HoloLensForCV::MediaFrameSourceGroupType _selectedHoloLensMediaFrameSourceGroupType;
         HoloLensForCV::MediaFrameSourceGroup^ _holoLensMediaFrameSourceGroup;
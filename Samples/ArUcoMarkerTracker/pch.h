@@ -44,6 +44,7 @@
 #include <DirectXHelpers.h>
 
 #include <Debugging/All.h>
+#include <Io/UnprojectionLut.h>
 #include <Graphics/All.h>
 #include <Rendering/All.h>
 #include <Holographic/All.h>
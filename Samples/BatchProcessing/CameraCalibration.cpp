@@ -18,57 +18,33 @@ namespace BatchProcessing
     {
         std::vector<HoloLensCameraCalibration> cameraCalibrations;
 
-        std::vector<byte> cameraCalibrationBuffer =
-            Io::ReadDataSync(
-                recordingFolder,
-                L"camera_calibration.csv");
+        Io::MemoryMappedFile cameraCalibrationFile(
+            recordingFolder,
+            L"camera_calibration.csv");
 
-        std::istringstream cameraCalibrationStream(
-            std::string(
-                reinterpret_cast<char*>(&cameraCalibrationBuffer[0]),
-                cameraCalibrationBuffer.size()));
-
-        std::string line;
-        std::vector<std::string> tokens;
-        std::vector<char> lineBuffer;
+        Io::CsvReader cameraCalibrationReader(
+            cameraCalibrationFile.GetData(),
+            cameraCalibrationFile.GetSize());
 
         bool csvFileHeaderSeen = false;
 
-        while (std::getline(cameraCalibrationStream, line))
+        while (cameraCalibrationReader.ReadRecord())
         {
-            //
-            // Skip comments and empty lines
-            //
-            line.erase(
-                line.find_last_not_of(
-                    " \t\r\n") + 1);
-
-            if (line.empty() || line[0] == '#')
-            {
-                continue;
-            }
-
-            Io::TokenizeString(
-                line,
-                "," /* delimiter */,
-                tokens,
-                lineBuffer);
-
             ASSERT(
                 1 /* SensorName */ +
                 2 /* FocalLength.[x|y] */ +
                 2 /* PrincipalPoint.[x|y] */ +
                 3 /* RadialDistortion.[x|y|z] */ +
-                2 /* TangentialDistortion.[x|y] */ == tokens.size());
+                2 /* TangentialDistortion.[x|y] */ == cameraCalibrationReader.GetFieldCount());
 
             //
             // Skip the CSV file header
             //
             if (!csvFileHeaderSeen)
             {
-                ASSERT(0 == strcmp(tokens[0].c_str(), "SensorName"));
-                ASSERT(0 == strcmp(tokens[1].c_str(), "FocalLength.x"));
-                ASSERT(0 == strcmp(tokens[9].c_str(), "TangentialDistortion.y"));
+                ASSERT(cameraCalibrationReader.GetField(0) == "SensorName");
+                ASSERT(cameraCalibrationReader.GetField(1) == "FocalLength.x");
+                ASSERT(cameraCalibrationReader.GetField(9) == "TangentialDistortion.y");
 
                 csvFileHeaderSeen = true;
 
@@ -79,7 +55,7 @@ namespace BatchProcessing
 
             cameraCalibration.SensorName =
                 Utf8ToUtf16(
-                    tokens[0]);
+                    cameraCalibrationReader.GetField(0).ToString());
 
             float* intrinsicParameters[9] =
             {
@@ -97,9 +73,8 @@ namespace BatchProcessing
             for (size_t i = 0; i < _countof(intrinsicParameters); ++i)
             {
                 *intrinsicParameters[i] =
-                    static_cast<float>(
-                        std::atof(
-                            tokens[i + 1].c_str()));
+                    cameraCalibrationReader.GetFloat(
+                        i + 1);
             }
 
             cameraCalibrations.emplace_back(
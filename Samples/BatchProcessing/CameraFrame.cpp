@@ -13,19 +13,203 @@
 
 namespace BatchProcessing
 {
+    namespace
+    {
+        //
+        // Skips whitespace and comments in a PNM header and parses the next
+        // decimal number.
+        //
+        int32_t ReadPortableAnymapHeaderValue(
+            _In_ const uint8_t* data,
+            _In_ const size_t dataSize,
+            _Inout_ size_t& position)
+        {
+            while (position < dataSize)
+            {
+                if ('#' == data[position])
+                {
+                    while (position < dataSize && '\n' != data[position])
+                    {
+                        ++position;
+                    }
+                }
+                else if (isspace(data[position]))
+                {
+                    ++position;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            int32_t value = 0;
+
+            ASSERT(position < dataSize && isdigit(data[position]));
+
+            while (position < dataSize && isdigit(data[position]))
+            {
+                value = value * 10 + (data[position] - '0');
+                ++position;
+            }
+
+            return value;
+        }
+
+        //
+        // Decodes the binary PGM (P5) and PPM (P6) images written by the
+        // recorder. Color images are converted to BGRA. Note that the
+        // recorder stores 16-bit samples in little endian byte order.
+        //
+        cv::Mat DecodePortableAnymap(
+            _In_ const uint8_t* data,
+            _In_ const size_t dataSize)
+        {
+            ASSERT(dataSize > 2 && 'P' == data[0]);
+            ASSERT('5' == data[1] || '6' == data[1]);
+
+            const bool isColor = ('6' == data[1]);
+
+            size_t position = 2;
+
+            const int32_t width =
+                ReadPortableAnymapHeaderValue(data, dataSize, position);
+
+            const int32_t height =
+                ReadPortableAnymapHeaderValue(data, dataSize, position);
+
+            const int32_t maxValue =
+                ReadPortableAnymapHeaderValue(data, dataSize, position);
+
+            // A single whitespace character separates the header from the pixels.
+            ++position;
+
+            const int32_t type =
+                isColor ? CV_8UC3 : (maxValue > 255 ? CV_16UC1 : CV_8UC1);
+
+            const cv::Mat pixels(
+                height /* _rows */,
+                width /* _cols */,
+                type,
+                const_cast<uint8_t*>(data + position),
+                cv::Mat::AUTO_STEP);
+
+            ASSERT(position + pixels.total() * pixels.elemSize() <= dataSize);
+
+            cv::Mat image;
+
+            if (isColor)
+            {
+                cv::cvtColor(
+                    pixels,
+                    image,
+                    cv::COLOR_RGB2BGRA);
+            }
+            else
+            {
+                image = pixels.clone();
+            }
+
+            return image;
+        }
+
+        //
+        // Frames recorded with a storage codec other than raw are wrapped in a
+        // compressed frame header; restore the original bitmap before decoding.
+        //
+        cv::Mat DecodeRecordedFrame(
+            _In_ const uint8_t* data,
+            _In_ const size_t dataSize)
+        {
+            if (!Io::IsCompressedFrame(data, dataSize))
+            {
+                return DecodePortableAnymap(
+                    data,
+                    dataSize);
+            }
+
+            std::vector<uint8_t> bitmapFile;
+
+            Io::DecompressFrame(
+                data,
+                dataSize,
+                bitmapFile);
+
+            return DecodePortableAnymap(
+                bitmapFile.data(),
+                bitmapFile.size());
+        }
+
+        bool FileExists(
+            _In_ Windows::Storage::StorageFolder^ folder,
+            _In_ const std::wstring& fileName)
+        {
+            HANDLE file = nullptr;
+
+            if (FAILED(Io::GetStorageFolderHandleAccess(folder)->Create(
+                fileName.c_str() /* fileName */,
+                HCO_OPEN_EXISTING /* creationOptions */,
+                HAO_READ /* accessOptions */,
+                HSO_SHARE_READ /* sharingOptions */,
+                HO_NONE /* options */,
+                nullptr /* oplockBreakingHandler */,
+                &file)))
+            {
+                return false;
+            }
+
+            CloseHandle(
+                file);
+
+            return true;
+        }
+    }
+
     void HoloLensCameraFrame::Load()
     {
-        std::vector<byte> imageBuffer =
-            Io::ReadDataSync(
-                RecordingFolder,
-                FileName);
-
-        Image = cv::Mat(
-            Height /* _rows */,
-            Width /* _cols */,
-            PixelFormat,
-            imageBuffer.data(),
-            cv::Mat::AUTO_STEP).clone();
+        if (nullptr != RecordingArchive)
+        {
+            Io::TarEntry imageEntry;
+
+            //
+            // The index written next to the tarball locates the frame by its
+            // timestamp without walking the headers of the archive.
+            //
+            if (0 == RecordingArchive->GetIndex().GetRecordCount() ||
+                !RecordingArchive->FindFrameEntry(Timestamp, &imageEntry))
+            {
+                ASSERT(RecordingArchive->FindEntry(
+                    Utf16ToUtf8(FileName),
+                    &imageEntry));
+            }
+
+            //
+            // Decode straight from the mapped archive; nothing is extracted
+            // unless the frame was compressed.
+            //
+            Io::TarEntryView imageView =
+                RecordingArchive->MapEntry(
+                    imageEntry);
+
+            Image = DecodeRecordedFrame(
+                imageView.GetData(),
+                imageView.GetSize());
+        }
+        else
+        {
+            std::vector<byte> imageBuffer =
+                Io::ReadDataSync(
+                    RecordingFolder,
+                    FileName);
+
+            Image = DecodeRecordedFrame(
+                imageBuffer.data(),
+                imageBuffer.size());
+        }
+
+        Width = Image.cols;
+        Height = Image.rows;
+        PixelFormat = Image.type();
     }
 
     void HoloLensCameraFrame::Unload()
@@ -39,59 +223,86 @@ namespace BatchProcessing
     {
         std::vector<HoloLensCameraFrame> cameraFrames;
 
-        std::vector<byte> cameraFramesBuffer =
-            Io::ReadDataSync(
-                recordingFolder,
-                manifestFileName);
+        //
+        // The recorder stores the images next to the manifest in a tarball
+        // with the same base name.
+        //
+        std::shared_ptr<Io::TarReader> recordingArchive;
 
-        std::istringstream cameraFramesStream(
-            std::string(
-                reinterpret_cast<char*>(&cameraFramesBuffer[0]),
-                cameraFramesBuffer.size()));
+        {
+            const std::wstring archiveFileName =
+                manifestFileName.substr(0, manifestFileName.find_last_of(L'.')) + L".tar";
 
-        std::string line;
-        std::vector<std::string> tokens;
-        std::vector<char> lineBuffer;
+            if (FileExists(recordingFolder, archiveFileName))
+            {
+                recordingArchive =
+                    std::make_shared<Io::TarReader>(
+                        recordingFolder,
+                        archiveFileName);
 
-        bool csvFileHeaderSeen = false;
+                const std::wstring indexFileName =
+                    archiveFileName + L".idx";
+
+                if (FileExists(recordingFolder, indexFileName))
+                {
+                    recordingArchive->LoadIndex(
+                        recordingFolder,
+                        indexFileName);
+                }
+            }
+        }
+
+        //
+        // Recordings made with the pose log enabled also carry the frame
+        // transforms in binary form (e.g. pv.poselog for pv.csv).
+        //
+        std::unique_ptr<Io::PoseLogReader> poseLog;
 
-        while (std::getline(cameraFramesStream, line))
         {
-            //
-            // Skip comments and empty lines
-            //
-            line.erase(
-                line.find_last_not_of(
-                    " \t\r\n") + 1);
+            const std::wstring poseLogFileName =
+                manifestFileName.substr(0, manifestFileName.find_last_of(L'.')) + L".poselog";
 
-            if (line.empty() || line[0] == '#')
+            if (FileExists(recordingFolder, poseLogFileName))
             {
-                continue;
+                poseLog.reset(
+                    new Io::PoseLogReader(
+                        recordingFolder,
+                        poseLogFileName));
             }
+        }
 
-            Io::TokenizeString(
-                line,
-                "," /* delimiter */,
-                tokens,
-                lineBuffer);
+        //
+        // The manifest is parsed in place from the mapped file.
+        //
+        Io::MemoryMappedFile cameraFramesFile(
+            recordingFolder,
+            manifestFileName);
+
+        Io::CsvReader cameraFramesReader(
+            cameraFramesFile.GetData(),
+            cameraFramesFile.GetSize());
+
+        bool csvFileHeaderSeen = false;
 
+        while (cameraFramesReader.ReadRecord())
+        {
             ASSERT(
                 1 /* Timestamp */ +
                 1 /* ImageFileName */ +
                 16 /* FrameToOrigin.m(1..4)(1..4) */ +
                 16 /* CameraViewTransform.m(1..4)(1..4) */ +
-                16 /* CameraProjectionTransform.m(1..4)(1..4) */ == tokens.size());
+                16 /* CameraProjectionTransform.m(1..4)(1..4) */ == cameraFramesReader.GetFieldCount());
 
             //
             // Skip the CSV file header
             //
             if (!csvFileHeaderSeen)
             {
-                ASSERT(0 == strcmp(tokens[0].c_str(), "Timestamp"));
-                ASSERT(0 == strcmp(tokens[1].c_str(), "ImageFileName"));
-                ASSERT(0 == strcmp(tokens[17].c_str(), "FrameToOrigin.m44"));
-                ASSERT(0 == strcmp(tokens[33].c_str(), "CameraViewTransform.m44"));
-                ASSERT(0 == strcmp(tokens[49].c_str(), "CameraProjectionTransform.m44"));
+                ASSERT(cameraFramesReader.GetField(0) == "Timestamp");
+                ASSERT(cameraFramesReader.GetField(1) == "ImageFileName");
+                ASSERT(cameraFramesReader.GetField(17) == "FrameToOrigin.m44");
+                ASSERT(cameraFramesReader.GetField(33) == "CameraViewTransform.m44");
+                ASSERT(cameraFramesReader.GetField(49) == "CameraProjectionTransform.m44");
 
                 csvFileHeaderSeen = true;
 
@@ -101,74 +312,89 @@ namespace BatchProcessing
             HoloLensCameraFrame cameraFrame;
 
             cameraFrame.Timestamp =
-                std::atoll(
-                    tokens[0].c_str());
+                cameraFramesReader.GetUInt64(0);
 
             cameraFrame.RecordingFolder =
                 recordingFolder;
 
+            cameraFrame.RecordingArchive =
+                recordingArchive;
+
             cameraFrame.FileName =
                 Utf8ToUtf16(
-                    tokens[1]);
+                    cameraFramesReader.GetField(1).ToString());
 
             cameraFrame.FrameToOrigin =
-                cv::Mat::eye(
+                cv::Mat(
                     4 /* rows */,
                     4 /* cols */,
                     CV_32F /* type */);
 
             cameraFrame.CameraViewTransform =
-                cv::Mat::eye(
+                cv::Mat(
                     4 /* rows */,
                     4 /* cols */,
                     CV_32F /* type */);
 
             cameraFrame.CameraProjectionTransform =
-                cv::Mat::eye(
+                cv::Mat(
                     4 /* rows */,
                     4 /* cols */,
                     CV_32F /* type */);
 
-            //
-            // FrameToOrigin follows the timestamp and image file name fields:
-            //
-            for (int32_t j = 0; j < 4; ++j)
-            {
-                for (int32_t i = 0; i < 4; ++i)
-                {
-                    cameraFrame.FrameToOrigin.at<float>(j, i) =
-                        static_cast<float>(
-                            std::atof(
-                                tokens[j * 4 + i + 2].c_str()));
-                }
-            }
+            const Io::PoseLogRecord* poseLogRecord =
+                (nullptr != poseLog) ?
+                    poseLog->FindRecord(cameraFrame.Timestamp) : nullptr;
 
-            for (int32_t j = 0; j < 4; ++j)
+            if (nullptr != poseLogRecord)
             {
-                for (int32_t i = 0; i < 4; ++i)
-                {
-                    cameraFrame.CameraViewTransform.at<float>(j, i) =
-                        static_cast<float>(
-                            std::atof(
-                                tokens[j * 4 + i + 2].c_str()));
-                }
-            }
+                //
+                // Take the exact transforms from the binary pose log rather
+                // than parsing their text representation.
+                //
+                memcpy(
+                    cameraFrame.FrameToOrigin.ptr<float>(),
+                    poseLogRecord->FrameToOrigin,
+                    sizeof(poseLogRecord->FrameToOrigin));
+
+                memcpy(
+                    cameraFrame.CameraViewTransform.ptr<float>(),
+                    poseLogRecord->CameraViewTransform,
+                    sizeof(poseLogRecord->CameraViewTransform));
 
-            for (int32_t j = 0; j < 4; ++j)
+                memcpy(
+                    cameraFrame.CameraProjectionTransform.ptr<float>(),
+                    poseLogRecord->CameraProjectionTransform,
+                    sizeof(poseLogRecord->CameraProjectionTransform));
+            }
+            else
             {
-                for (int32_t i = 0; i < 4; ++i)
-                {
-                    cameraFrame.CameraProjectionTransform.at<float>(j, i) =
-                        static_cast<float>(
-                            std::atof(
-                                tokens[j * 4 + i + 2].c_str()));
-                }
+                //
+                // The row-major matrices follow the timestamp and image file
+                // name fields and are parsed straight into the matrix storage.
+                //
+                cameraFramesReader.GetFloats(
+                    2 /* firstIndex */,
+                    16 /* count */,
+                    cameraFrame.FrameToOrigin.ptr<float>());
+
+                cameraFramesReader.GetFloats(
+                    18 /* firstIndex */,
+                    16 /* count */,
+                    cameraFrame.CameraViewTransform.ptr<float>());
+
+                cameraFramesReader.GetFloats(
+                    34 /* firstIndex */,
+                    16 /* count */,
+                    cameraFrame.CameraProjectionTransform.ptr<float>());
             }
 
-            //TODO: add the width/height/pixel format to the manifest or camera calibration CSV
+            //
+            // Updated from the image header when the frame is loaded.
+            //
             cameraFrame.Width = 1280;
             cameraFrame.Height = 720;
-            cameraFrame.PixelFormat = CV_8SC4; // BGRA
+            cameraFrame.PixelFormat = CV_8UC4; // BGRA
 
             cameraFrames.emplace_back(
                 std::move(
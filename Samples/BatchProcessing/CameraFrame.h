@@ -20,6 +20,7 @@ namespace BatchProcessing
     {
         uint64_t Timestamp;
         Windows::Storage::StorageFolder^ RecordingFolder;
+        std::shared_ptr<Io::TarReader> RecordingArchive;
         std::wstring FileName;
         cv::Mat FrameToOrigin;
         cv::Mat CameraViewTransform;
@@ -38,6 +39,10 @@ namespace BatchProcessing
     // and returns a list of camera frames. Does not load the camera
     // images -- call HoloLensCameraFrame::Load for that to happen.
     //
+    // The images are read straight from the tarball next to the
+    // manifest (e.g. pv.tar for pv.csv) when it is present, and from
+    // the extracted files otherwise.
+    //
     std::vector<HoloLensCameraFrame> DiscoverCameraFrames(
         _In_ Windows::Storage::StorageFolder^ recordingFolder,
         _In_ const std::wstring& manifestFileName);
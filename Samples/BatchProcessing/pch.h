@@ -13,12 +13,14 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <sstream>
 
 #include <collection.h>
 #include <ppltasks.h>
 
 #include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
 
 #include <Debugging/All.h>
 #include <Io/All.h>
@@ -26,6 +26,15 @@ using namespace Windows::UI::Xaml::Navigation;
 namespace ComputeOnDesktop
 {
     MainPage::MainPage()
+        : _imagePool(
+            [](const Io::FramePoolKey& key)
+            {
+                return cv::Mat(
+                    key.Height,
+                    key.Width,
+                    key.Format);
+            },
+            2 /* maximumBuffersPerKey */)
     {
         InitializeComponent();
     }
@@ -72,6 +81,11 @@ namespace ComputeOnDesktop
                 ref new HoloLensForCV::SensorFrameReceiver(
                     pvCameraSocket);
 
+            //
+            // Frames are released once displayed, along with their bitmap.
+            //
+            receiver->FramePoolCapacity = 4;
+
             ReceiverLoop(
                 receiver);
         });
@@ -118,7 +132,7 @@ namespace ComputeOnDesktop
                     concurrency::create_task(
                         imageSource->SetBitmapAsync(sensorFrame->SoftwareBitmap)
                     ).then(
-                        [this, imageSource]()
+                        [this, imageSource, sensorFrame]()
                     {
                         _pvImage->Source = imageSource;
 
@@ -145,30 +159,37 @@ namespace ComputeOnDesktop
             sensorFrame,
             wrappedImage);
 
-        cv::Mat blurredImage;
+        Io::FramePoolKey imageKey;
+
+        imageKey.Width = wrappedImage.cols;
+        imageKey.Height = wrappedImage.rows;
+        imageKey.Format = wrappedImage.type();
+
+        std::shared_ptr<cv::Mat> blurredImage =
+            _imagePool.Acquire(
+                imageKey);
 
         cv::medianBlur(
             wrappedImage,
-            blurredImage,
+            *blurredImage,
             3 /* ksize */);
 
-        cv::Mat cannyImage;
+        imageKey.Format = CV_8UC1;
+
+        std::shared_ptr<cv::Mat> cannyImage =
+            _imagePool.Acquire(
+                imageKey);
 
         cv::Canny(
-            blurredImage,
-            cannyImage,
+            *blurredImage,
+            *cannyImage,
             50.0,
             200.0);
 
-        for (int32_t y = 0; y < blurredImage.rows; ++y)
-        {
-            for (int32_t x = 0; x < blurredImage.cols; ++x)
-            {
-                if (cannyImage.at<uint8_t>(y, x) > 64)
-                {
-                    wrappedImage.at<uint32_t>(y, x) = 0xFF00FF00;
-                }
-            }
-        }
+        rmcv::OverlayMask(
+            *cannyImage,
+            64 /* threshold */,
+            0xFF00FF00 /* colorBGRA */,
+            wrappedImage);
     }
 }
@@ -28,5 +28,11 @@ namespace ComputeOnDesktop
 
         void OnFrameReceived(
             HoloLensForCV::SensorFrame^ sensorFrame);
+
+    private:
+        //
+        // Intermediate images of the frame processing, recycled across frames.
+        //
+        Io::FramePool<cv::Mat> _imagePool;
     };
 }
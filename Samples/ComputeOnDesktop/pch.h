@@ -43,6 +43,7 @@
 #define DBG_ENABLE_VERBOSE_LOGGING 1
 
 #include <Debugging/All.h>
+#include <Io/FramePool.h>
 #include <Graphics/All.h>
 #include <Rendering/All.h>
 #include <OpenCVHelpers/All.h>
@@ -21,7 +21,6 @@ namespace ComputeOnDevice
         , _selectedHoloLensMediaFrameSourceGroupType(
             HoloLensForCV::MediaFrameSourceGroupType::PhotoVideoCamera)
         , _holoLensMediaFrameSourceGroupStarted(false)
-        , _undistortMapsInitialized(false)
         , _isActiveRenderer(false)
     {
     }
@@ -121,60 +120,44 @@ namespace ComputeOnDevice
             latestFrame,
             wrappedImage);
 
-        if (!_undistortMapsInitialized)
+        if (_undistortDownscaleMap.IsEmpty())
         {
             Windows::Media::Devices::Core::CameraIntrinsics^ cameraIntrinsics =
                 latestFrame->CoreCameraIntrinsics;
 
             if (nullptr != cameraIntrinsics)
             {
-                cv::Mat cameraMatrix(3, 3, CV_64FC1);
-
-                cv::setIdentity(cameraMatrix);
-
-                cameraMatrix.at<double>(0, 0) = cameraIntrinsics->FocalLength.x;
-                cameraMatrix.at<double>(1, 1) = cameraIntrinsics->FocalLength.y;
-                cameraMatrix.at<double>(0, 2) = cameraIntrinsics->PrincipalPoint.x;
-                cameraMatrix.at<double>(1, 2) = cameraIntrinsics->PrincipalPoint.y;
-
-                cv::Mat distCoeffs(5, 1, CV_64FC1);
-
-                distCoeffs.at<double>(0, 0) = cameraIntrinsics->RadialDistortion.x;
-                distCoeffs.at<double>(1, 0) = cameraIntrinsics->RadialDistortion.y;
-                distCoeffs.at<double>(2, 0) = cameraIntrinsics->TangentialDistortion.x;
-                distCoeffs.at<double>(3, 0) = cameraIntrinsics->TangentialDistortion.y;
-                distCoeffs.at<double>(4, 0) = cameraIntrinsics->RadialDistortion.z;
-
-                cv::initUndistortRectifyMap(
-                    cameraMatrix,
-                    distCoeffs,
-                    cv::Mat_<double>::eye(3, 3) /* R */,
-                    cameraMatrix,
+                cv::Matx33d cameraMatrix =
+                    cv::Matx33d::eye();
+
+                cameraMatrix(0, 0) = cameraIntrinsics->FocalLength.x;
+                cameraMatrix(1, 1) = cameraIntrinsics->FocalLength.y;
+                cameraMatrix(0, 2) = cameraIntrinsics->PrincipalPoint.x;
+                cameraMatrix(1, 2) = cameraIntrinsics->PrincipalPoint.y;
+
+                const cv::Vec<double, 5> distortionCoefficients(
+                    cameraIntrinsics->RadialDistortion.x,
+                    cameraIntrinsics->RadialDistortion.y,
+                    cameraIntrinsics->TangentialDistortion.x,
+                    cameraIntrinsics->TangentialDistortion.y,
+                    cameraIntrinsics->RadialDistortion.z);
+
+                _undistortDownscaleMap.Create(
                     cv::Size(wrappedImage.cols, wrappedImage.rows),
-                    CV_32FC1 /* type */,
-                    _undistortMap1,
-                    _undistortMap2);
-
-                _undistortMapsInitialized = true;
+                    cameraMatrix,
+                    distortionCoefficients);
             }
         }
 
-        if (_undistortMapsInitialized)
+        if (!_undistortDownscaleMap.IsEmpty())
         {
-            cv::remap(
+            //
+            // Undistorts the image and halves its resolution in a single pass,
+            // rather than remapping it at full resolution before resizing it.
+            //
+            _undistortDownscaleMap.Apply(
                 wrappedImage,
-                _undistortedPVCameraImage,
-                _undistortMap1,
-                _undistortMap2,
-                cv::INTER_LINEAR);
-
-            cv::resize(
-                _undistortedPVCameraImage,
-                _resizedPVCameraImage,
-                cv::Size(),
-                0.5 /* fx */,
-                0.5 /* fy */,
-                cv::INTER_AREA);
+                _resizedPVCameraImage);
         }
         else
         {
@@ -198,16 +181,11 @@ namespace ComputeOnDevice
             50.0,
             200.0);
 
-        for (int32_t y = 0; y < _blurredPVCameraImage.rows; ++y)
-        {
-            for (int32_t x = 0; x < _blurredPVCameraImage.cols; ++x)
-            {
-                if (_cannyPVCameraImage.at<uint8_t>(y, x) > 64)
-                {
-                    *(_blurredPVCameraImage.ptr<uint32_t>(y, x)) = 0xFFFF00FF;
-                }
-            }
-        }
+        rmcv::OverlayMask(
+            _cannyPVCameraImage,
+            64 /* threshold */,
+            0xFFFF00FF /* colorBGRA */,
+            _blurredPVCameraImage);
 
         OpenCVHelpers::CreateOrUpdateTexture2D(
             _deviceResources,
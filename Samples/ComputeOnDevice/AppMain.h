@@ -57,11 +57,8 @@ namespace ComputeOnDevice
 
         Windows::Foundation::DateTime _latestSelectedCameraTimestamp;
 
-        cv::Mat _undistortMap1;
-        cv::Mat _undistortMap2;
-        bool _undistortMapsInitialized;
+        rmcv::UndistortDownscaleMap _undistortDownscaleMap;
 
-        cv::Mat _undistortedPVCameraImage;
         cv::Mat _resizedPVCameraImage;
         cv::Mat _blurredPVCameraImage;
         cv::Mat _cannyPVCameraImage;
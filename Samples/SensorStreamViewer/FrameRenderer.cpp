@@ -12,6 +12,7 @@
 #include "pch.h"
 #include <cmath>
 #include <MemoryBuffer.h>
+#include <Io/PseudoColor.h>
 #include "FrameRenderer.h"
 
 using namespace SensorStreaming;
@@ -114,76 +115,113 @@ static ColorBGRA GenerateInfraredRampLookupTable(UINT32 index, UINT32 size)
 static LookupTable<ColorBGRA, 1024> colorLookupTable(GeneratePseudoColorLookupTable);
 static LookupTable<ColorBGRA, 1024> infraredLookupTable(GenerateInfraredRampLookupTable);
 
-static ColorBGRA PseudoColor(float value)
+// Packs a color like the BGRA pixels read as uint32_t.
+static uint32_t PackColor(const ColorBGRA& color)
 {
-    return colorLookupTable.GetValue(value);
+    return static_cast<uint32_t>(color.B) |
+        (static_cast<uint32_t>(color.G) << 8) |
+        (static_cast<uint32_t>(color.R) << 16) |
+        (static_cast<uint32_t>(color.A) << 24);
 }
 
-static ColorBGRA InfraredColor(float value)
-{
-    return infraredLookupTable.GetValue(value);
-}
+// Color of the pixels without a valid value.
+static const uint32_t invalidColor = PackColor({ 0xFF, 0x00, 0x00, 0x7F });
 
-// Maps each pixel in a scanline from a 16 bit depth value to a pseudo-color pixel.
-static void PseudoColorForDepth(int pixelWidth, byte* inputRowBytes, byte* outputRowBytes, float depthScale, float minReliableDepth, float maxReliableDepth)
+// Initializes the pseudo-color table of 16 bit depth values, in millimeters.
+static Io::PseudoColorTable<uint16_t> CreateDepthColorTable(float minReliableDepth, float maxReliableDepth)
 {
-    // Visualize space in front of your desktop, in meters.
-    const float rangeReciprocal = 1.0f / (maxReliableDepth - minReliableDepth);
+    Io::PseudoColorRange range = {};
 
-    UINT16* inputRow = reinterpret_cast<UINT16*>(inputRowBytes);
-    ColorBGRA* outputRow = reinterpret_cast<ColorBGRA*>(outputRowBytes);
-    for (int x = 0; x < pixelWidth; x++)
-    {
-        // Map invalid depth values to transparent pixels.
-        // This happens when depth information cannot be calculated, e.g. when objects are too close.
-        if (inputRow[x] == 0 || inputRow[x] > 4000)
-        {
-            outputRow[x] = { 0xFF, 0x00, 0x00, 0x7F };
-        }
-        else
-        {
-            const float depth = static_cast<float>(inputRow[x]) * depthScale;
-            const float alpha = (depth - minReliableDepth) * rangeReciprocal;
-            outputRow[x] = PseudoColor(alpha);
-        }
-    }
+    range.Scale = 1.0f / 1000.0f;
+    range.Minimum = minReliableDepth;
+    range.Maximum = maxReliableDepth;
+
+    // Map invalid depth values to transparent pixels.
+    // This happens when depth information cannot be calculated, e.g. when objects are too close.
+    range.MinimumValid = 1;
+    range.MaximumValid = 4000;
+    range.InvalidColor = invalidColor;
+
+    return Io::PseudoColorTable<uint16_t>(
+        range,
+        [](float value) { return PackColor(colorLookupTable.GetValue(value)); });
 }
 
-// Maps each pixel in a scanline from a 16 bit infrared value to a pseudo-color pixel.
-static void PseudoColorFor16BitInfrared(int pixelWidth, byte* inputRowBytes, byte* outputRowBytes)
+// Initializes the pseudo-color table of 8 or 16 bit infrared values.
+template<typename TValue>
+static Io::PseudoColorTable<TValue> CreateInfraredColorTable()
 {
-    UINT16* inputRow = reinterpret_cast<UINT16*>(inputRowBytes);
-    ColorBGRA* outputRow = reinterpret_cast<ColorBGRA*>(outputRowBytes);
-    const float rangeReciprocal = 1.0f / static_cast<float>(UINT16_MAX);
-    for (int x = 0; x < pixelWidth; x++)
-    {
-        if (inputRow[x] == 0)
-        {
-            outputRow[x] = { 0xFF, 0x00, 0x00, 0x7F };
-        }
-        else
-        {
-            outputRow[x] = InfraredColor(inputRow[x] * rangeReciprocal);
-        }
-    }
+    const uint32_t maxValue = (std::numeric_limits<TValue>::max)();
+
+    Io::PseudoColorRange range = {};
+
+    range.Scale = 1.0f / static_cast<float>(maxValue);
+    range.Minimum = 0.0f;
+    range.Maximum = 1.0f;
+    range.MinimumValid = 1;
+    range.MaximumValid = maxValue;
+    range.InvalidColor = invalidColor;
+
+    return Io::PseudoColorTable<TValue>(
+        range,
+        [](float value) { return PackColor(infraredLookupTable.GetValue(value)); });
 }
 
-// Maps each pixel in a scanline from a 8 bit infrared value to a pseudo-color pixel.
-static void PseudoColorFor8BitInfrared(int pixelWidth, byte* inputRowBytes, byte* outputRowBytes)
+// Pseudo-color tables, holding the color of every value the sensors may return.
+static const Io::PseudoColorTable<uint16_t> longThrowDepthColorTable = CreateDepthColorTable(0.5f, 4.0f);
+static const Io::PseudoColorTable<uint16_t> shortThrowDepthColorTable = CreateDepthColorTable(0.2f, 1.0f);
+static const Io::PseudoColorTable<uint16_t> infrared16BitColorTable = CreateInfraredColorTable<uint16_t>();
+static const Io::PseudoColorTable<uint8_t> infrared8BitColorTable = CreateInfraredColorTable<uint8_t>();
+
+// Maps each pixel of a Gray8 or Gray16 bitmap to its pseudo-color.
+template<typename TValue>
+static SoftwareBitmap^ PseudoColorBitmap(SoftwareBitmap^ inputBitmap, const Io::PseudoColorTable<TValue>& colorTable)
 {
-    ColorBGRA* outputRow = reinterpret_cast<ColorBGRA*>(outputRowBytes);
-    const float rangeReciprocal = 1.0f / static_cast<float>(UINT8_MAX);
-    for (int x = 0; x < pixelWidth; x++)
-    {
-        if (inputRowBytes[x] == 0)
-        {
-            outputRow[x] = { 0xFF, 0x00, 0x00, 0x7F };
-        }
-        else
-        {
-            outputRow[x] = InfraredColor(inputRowBytes[x] * rangeReciprocal);
-        }
-    }
+    // XAML Image control only supports premultiplied Bgra8 format.
+    SoftwareBitmap^ outputBitmap = ref new SoftwareBitmap(
+        BitmapPixelFormat::Bgra8,
+        inputBitmap->PixelWidth,
+        inputBitmap->PixelHeight,
+        BitmapAlphaMode::Premultiplied);
+
+    BitmapBuffer^ input = inputBitmap->LockBuffer(BitmapBufferAccessMode::Read);
+    BitmapBuffer^ output = outputBitmap->LockBuffer(BitmapBufferAccessMode::Write);
+
+    // Get stride values to calculate buffer position for a given pixel x and y position.
+    int inputStride = input->GetPlaneDescription(0).Stride;
+    int outputStride = output->GetPlaneDescription(0).Stride;
+
+    int pixelWidth = inputBitmap->PixelWidth;
+    int pixelHeight = inputBitmap->PixelHeight;
+
+    IMemoryBufferReference^ inputReference = input->CreateReference();
+    IMemoryBufferReference^ outputReference = output->CreateReference();
+
+    // Get input and output byte access buffers.
+    byte* inputBytes;
+    UINT32 inputCapacity;
+    AsComPtr<IMemoryBufferByteAccess>(inputReference)->GetBuffer(&inputBytes, &inputCapacity);
+
+    byte* outputBytes;
+    UINT32 outputCapacity;
+    AsComPtr<IMemoryBufferByteAccess>(outputReference)->GetBuffer(&outputBytes, &outputCapacity);
+
+    // Look up the color of every pixel.
+    colorTable.Apply(
+        inputBytes,
+        static_cast<size_t>(inputStride),
+        static_cast<uint32_t>(pixelWidth),
+        static_cast<uint32_t>(pixelHeight),
+        outputBytes,
+        static_cast<size_t>(outputStride));
+
+    // Close objects that need closing.
+    delete outputReference;
+    delete inputReference;
+    delete output;
+    delete input;
+
+    return outputBitmap;
 }
 
 FrameRenderer::FrameRenderer(Image^ imageElement)
@@ -332,27 +370,16 @@ SoftwareBitmap^ FrameRenderer::ConvertToDisplayableImage(VideoMediaFrame^ inputF
 
             if (inputBitmap->BitmapPixelFormat == BitmapPixelFormat::Gray16)
             {
-                using namespace std::placeholders;
-
-                // Use a special pseudo color to render 16 bits depth frame.
-                // Since we must scale the output appropriately we use std::bind to
-                // create a function that takes the depth scale as input but also matches
-                // the required signature.
-                const float depthScale = 1.0f / 1000.0f;
-                float minReliableDepth, maxReliableDepth;
-
+                // Use a special pseudo color to render 16 bits depth frame, scaled
+                // to the reliable range of the sensor.
                 if (m_sensorName == L"Long Throw ToF Depth")
                 {
-                    minReliableDepth = 0.5f;
-                    maxReliableDepth = 4.0f;
+                    return PseudoColorBitmap(inputBitmap, longThrowDepthColorTable);
                 }
                 else
                 {
-                    minReliableDepth = 0.2f;
-                    maxReliableDepth = 1.0f;
+                    return PseudoColorBitmap(inputBitmap, shortThrowDepthColorTable);
                 }
-
-                return TransformBitmap(inputBitmap, std::bind(&PseudoColorForDepth, _1, _2, _3, depthScale, minReliableDepth, maxReliableDepth));
             }
             else
             {
@@ -367,11 +394,11 @@ SoftwareBitmap^ FrameRenderer::ConvertToDisplayableImage(VideoMediaFrame^ inputF
             {
             case BitmapPixelFormat::Gray8:
                 // Use pseudo color to render 8 bits frames.
-                return TransformBitmap(inputBitmap, PseudoColorFor8BitInfrared);
+                return PseudoColorBitmap(inputBitmap, infrared8BitColorTable);
 
             case BitmapPixelFormat::Gray16:
                 // Use pseudo color to render 16 bits frames.
-                return TransformBitmap(inputBitmap, PseudoColorFor16BitInfrared);
+                return PseudoColorBitmap(inputBitmap, infrared16BitColorTable);
 
             default:
                 OutputDebugStringW(L"Infrared format should have been Gray8 or Gray16.\r\n");
@@ -501,52 +528,3 @@ SoftwareBitmap^ FrameRenderer::DeepCopyBitmap(SoftwareBitmap^ inputBitmap)
 
     return outputBitmap;
 }
-
-SoftwareBitmap^ FrameRenderer::TransformBitmap(SoftwareBitmap^ inputBitmap, TransformScanline pixelTransformation)
-{
-    // XAML Image control only supports premultiplied Bgra8 format.
-    SoftwareBitmap^ outputBitmap = ref new SoftwareBitmap(
-        BitmapPixelFormat::Bgra8,
-        inputBitmap->PixelWidth,
-        inputBitmap->PixelHeight,
-        BitmapAlphaMode::Premultiplied);
-
-    BitmapBuffer^ input = inputBitmap->LockBuffer(BitmapBufferAccessMode::Read);
-    BitmapBuffer^ output = outputBitmap->LockBuffer(BitmapBufferAccessMode::Write);
-
-    // Get stride values to calculate buffer position for a given pixel x and y position.
-    int inputStride = input->GetPlaneDescription(0).Stride;
-    int outputStride = output->GetPlaneDescription(0).Stride;
-
-    int pixelWidth = inputBitmap->PixelWidth;
-    int pixelHeight = inputBitmap->PixelHeight;
-
-    IMemoryBufferReference^ inputReference = input->CreateReference();
-    IMemoryBufferReference^ outputReference = output->CreateReference();
-
-    // Get input and output byte access buffers.
-    byte* inputBytes;
-    UINT32 inputCapacity;
-    AsComPtr<IMemoryBufferByteAccess>(inputReference)->GetBuffer(&inputBytes, &inputCapacity);
-
-    byte* outputBytes;
-    UINT32 outputCapacity;
-    AsComPtr<IMemoryBufferByteAccess>(outputReference)->GetBuffer(&outputBytes, &outputCapacity);
-
-    // Iterate over all pixels, and store the converted value.
-    for (int y = 0; y < pixelHeight; y++)
-    {
-        byte* inputRowBytes = inputBytes + y * inputStride;
-        byte* outputRowBytes = outputBytes + y * outputStride;
-
-        pixelTransformation(pixelWidth, inputRowBytes, outputRowBytes);
-    }
-
-    // Close objects that need closing.
-    delete outputReference;
-    delete inputReference;
-    delete output;
-    delete input;
-
-    return outputBitmap;
-}
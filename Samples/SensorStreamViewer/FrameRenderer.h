@@ -15,9 +15,6 @@
 
 namespace SensorStreaming
 {
-    // Function type used to map a scanline of pixels to an alternate pixel format.
-    typedef std::function<void(int, byte*, byte*)> TransformScanline;
-
     public ref class FrameRenderer sealed
     {
     public:
@@ -41,14 +38,6 @@ namespace SensorStreaming
             Windows::Media::Capture::Frames::MediaFrameFormat^ format);
 
     private: // Private static methods.
-        /// <summary>
-        /// Transforms pixels of inputBitmap to an output bitmap using the supplied pixel transformation method.
-        /// Returns nullptr if translation fails.
-        /// </summary>
-        static Windows::Graphics::Imaging::SoftwareBitmap^ TransformBitmap(
-            Windows::Graphics::Imaging::SoftwareBitmap^ inputBitmap,
-            TransformScanline pixelTransformation);
-
         static Windows::Graphics::Imaging::SoftwareBitmap^ TransformVlcBitmap(
             Windows::Graphics::Imaging::SoftwareBitmap^ inputBitmap);
 
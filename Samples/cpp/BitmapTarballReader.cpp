@@ -0,0 +1,207 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "BitmapTarballReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace SensorStream
+{
+    namespace
+    {
+        //
+        // Skips the whitespace before a bitmap header field, returning false
+        // at the end of the file.
+        //
+        bool ParseBitmapNumber(
+            const uint8_t* data,
+            size_t size,
+            size_t* offset,
+            uint32_t* value)
+        {
+            while (*offset < size && isspace(data[*offset]))
+            {
+                ++*offset;
+            }
+
+            if (*offset == size || !isdigit(data[*offset]))
+            {
+                return false;
+            }
+
+            *value = 0;
+
+            while (*offset < size && isdigit(data[*offset]))
+            {
+                *value = *value * 10 + (data[*offset] - '0');
+                ++*offset;
+            }
+
+            return *offset < size;
+        }
+
+        //
+        // "P5\n<width> <height>\n<maximum value>\n" or "P6\n...", then the
+        // pixels. Returns false if the file isn't such a bitmap, or is
+        // truncated.
+        //
+        bool ParseBitmap(
+            const uint8_t* data,
+            const size_t size,
+            RecordedBitmap* bitmap)
+        {
+            if (size < 2 || 'P' != data[0] || ('5' != data[1] && '6' != data[1]))
+            {
+                return false;
+            }
+
+            size_t offset = 2;
+            uint32_t maximumValue = 0;
+
+            if (!ParseBitmapNumber(data, size, &offset, &bitmap->ImageWidth) ||
+                !ParseBitmapNumber(data, size, &offset, &bitmap->ImageHeight) ||
+                !ParseBitmapNumber(data, size, &offset, &maximumValue))
+            {
+                return false;
+            }
+
+            // A single whitespace character separates the header from the pixels.
+            ++offset;
+
+            bitmap->BytesPerPixel =
+                ('6' == data[1]) ? 3 : (maximumValue > 255) ? 2 : 1;
+
+            bitmap->Header = data;
+            bitmap->HeaderSize = offset;
+            bitmap->Pixels = data + offset;
+            bitmap->PixelDataSize = size - offset;
+
+            return bitmap->PixelDataSize ==
+                static_cast<size_t>(bitmap->ImageWidth) * bitmap->ImageHeight * bitmap->BytesPerPixel;
+        }
+    }
+
+    BitmapTarballReader::BitmapTarballReader()
+        : _tarball(nullptr)
+        , _skippedFileCount(0)
+    {
+    }
+
+    BitmapTarballReader::~BitmapTarballReader()
+    {
+        if (nullptr != _tarball)
+        {
+            fclose(_tarball);
+        }
+    }
+
+    bool BitmapTarballReader::Open(
+        const std::string& tarballPath)
+    {
+        _tarball = fopen(tarballPath.c_str(), "rb");
+
+        if (nullptr == _tarball ||
+            0 != fseeko(_tarball, 0, SEEK_END))
+        {
+            _error = "failed to open " + tarballPath + ": " + strerror(errno);
+
+            return false;
+        }
+
+        const uint64_t tarballSize =
+            static_cast<uint64_t>(ftello(_tarball));
+
+        FILE* tarball = _tarball;
+
+        _scanner.reset(
+            new Io::TarArchiveScanner(
+                tarballSize,
+                [tarball](uint64_t offset, void* buffer, size_t size)
+                {
+                    if (0 != fseeko(tarball, static_cast<off_t>(offset), SEEK_SET) ||
+                        size != fread(buffer, 1, size, tarball))
+                    {
+                        throw std::runtime_error("failed to read the tarball");
+                    }
+                }));
+
+        return true;
+    }
+
+    bool BitmapTarballReader::ReadBitmap(
+        RecordedBitmap* bitmap)
+    {
+        Io::TarEntry entry;
+
+        while (_scanner->ReadNextEntry(&entry))
+        {
+            //
+            // Frames are stored as <sensor>\<timestamp>.pgm, or .ppm for the
+            // photo video camera, with the suffix of their codec if they are
+            // compressed.
+            //
+            const std::string& name = entry.FileName;
+
+            const size_t baseName = name.find_last_of("\\/");
+
+            const std::string extension =
+                name.substr(std::min(name.size(), name.find('.', (std::string::npos == baseName) ? 0 : baseName)));
+
+            if ('0' != entry.Type && '\0' != entry.Type)
+            {
+                continue;
+            }
+
+            if (".pgm" != extension && ".ppm" != extension)
+            {
+                ++_skippedFileCount;
+
+                continue;
+            }
+
+            _buffer.resize(
+                static_cast<size_t>(entry.DataSize));
+
+            _scanner->ReadEntryData(
+                entry,
+                0 /* offset */,
+                _buffer.data(),
+                _buffer.size());
+
+            if (!ParseBitmap(_buffer.data(), _buffer.size(), bitmap))
+            {
+                ++_skippedFileCount;
+
+                continue;
+            }
+
+            bitmap->SensorName =
+                (std::string::npos == baseName) ? std::string() : name.substr(0, baseName);
+
+            bitmap->Timestamp =
+                strtoull(name.c_str() + ((std::string::npos == baseName) ? 0 : baseName + 1), nullptr, 10);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void BitmapTarballReader::Rewind()
+    {
+        _scanner->Rewind();
+    }
+}
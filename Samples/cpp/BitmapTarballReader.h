@@ -0,0 +1,98 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <Io/TarArchive.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SensorStream
+{
+    //
+    // A PGM or PPM file of a tarball. The header and the pixels are only valid
+    // until the next bitmap is read.
+    //
+    struct RecordedBitmap
+    {
+        // The folder of the file in the tarball, e.g. "vlc_lf".
+        std::string SensorName;
+
+        uint64_t Timestamp;
+
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+
+        //
+        // 3 for PPM files, 2 for Gray16 PGM files, whose pixels are little
+        // endian, as the recorder stores them.
+        //
+        uint32_t BytesPerPixel;
+
+        // The bitmap file header, e.g. "P5\n448 450\n65535\n".
+        const uint8_t* Header;
+        size_t HeaderSize;
+
+        const uint8_t* Pixels;
+        size_t PixelDataSize;
+    };
+
+    //
+    // Reads the PGM and PPM files of a tarball of HoloLensForCV's
+    // SensorFrameRecorder in archive order, through an Io::TarArchiveScanner.
+    // Other files, including frames stored with a compression codec, are
+    // skipped. Malformed tarballs throw, like the scanner.
+    //
+    class BitmapTarballReader
+    {
+    public:
+        BitmapTarballReader();
+        ~BitmapTarballReader();
+
+        BitmapTarballReader(const BitmapTarballReader&) = delete;
+        BitmapTarballReader& operator=(const BitmapTarballReader&) = delete;
+
+        bool Open(
+            const std::string& tarballPath);
+
+        //
+        // Returns false after the last bitmap of the tarball.
+        //
+        bool ReadBitmap(
+            RecordedBitmap* bitmap);
+
+        // Starts over from the first bitmap.
+        void Rewind();
+
+        const std::string& GetError() const
+        {
+            return _error;
+        }
+
+        uint64_t GetSkippedFileCount() const
+        {
+            return _skippedFileCount;
+        }
+
+    private:
+        FILE* _tarball;
+        std::string _error;
+
+        std::unique_ptr<Io::TarArchiveScanner> _scanner;
+
+        std::vector<uint8_t> _buffer;
+        uint64_t _skippedFileCount;
+    };
+}
@@ -0,0 +1,378 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "DatagramReceiver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace SensorStream
+{
+    namespace
+    {
+        const size_t c_maximumDatagramSize = 64 * 1024;
+        const size_t c_maximumPendingFrames = 8;
+
+        const int c_receiveBufferSize = 8 * 1024 * 1024;
+
+        //
+        // The server drops subscribers it hasn't heard from in 5 seconds. Waits
+        // are bounded so that Close is noticed.
+        //
+        const std::chrono::milliseconds c_subscriptionPeriod(1000);
+        const std::chrono::milliseconds c_maximumWait(100);
+    }
+
+    DatagramReceiver::DatagramReceiver(
+        FrameBufferPool& pool,
+        std::chrono::milliseconds deadline)
+        : _pool(pool)
+        , _socket(-1)
+        , _closing(false)
+        , _reassembler(
+            deadline,
+            c_maximumPendingFrames,
+            ProtocolHeaderLength + ProtocolMaximumExtendedHeaderLength +
+                ProtocolMaximumExtensionsLength + pool.GetPayloadCapacity())
+        , _datagram(c_maximumDatagramSize)
+        , _framesReceived(0)
+        , _framesDropped(0)
+        , _framesTooLarge(0)
+        , _framesMalformed(0)
+        , _bytesReceived(0)
+    {
+    }
+
+    DatagramReceiver::~DatagramReceiver()
+    {
+        if (_socket >= 0)
+        {
+            close(_socket);
+        }
+    }
+
+    bool DatagramReceiver::Connect(
+        const char* host,
+        uint16_t port)
+    {
+        addrinfo hints = {};
+
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        addrinfo* addresses = nullptr;
+
+        const int result =
+            getaddrinfo(host, std::to_string(port).c_str(), &hints, &addresses);
+
+        if (0 != result)
+        {
+            _error = gai_strerror(result);
+
+            return false;
+        }
+
+        int connectedSocket = -1;
+
+        for (addrinfo* address = addresses; nullptr != address; address = address->ai_next)
+        {
+            const int candidate =
+                socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+            if (candidate < 0)
+            {
+                continue;
+            }
+
+            //
+            // Only the server's datagrams get through a connected socket.
+            //
+            if (0 == connect(candidate, address->ai_addr, address->ai_addrlen))
+            {
+                connectedSocket = candidate;
+                break;
+            }
+
+            _error = strerror(errno);
+
+            close(candidate);
+        }
+
+        freeaddrinfo(addresses);
+
+        if (connectedSocket < 0)
+        {
+            return false;
+        }
+
+        //
+        // The datagrams of a frame arrive in a burst.
+        //
+        setsockopt(
+            connectedSocket,
+            SOL_SOCKET,
+            SO_RCVBUF,
+            &c_receiveBufferSize,
+            sizeof(c_receiveBufferSize));
+
+        if (_socket >= 0)
+        {
+            close(_socket);
+        }
+
+        _socket = connectedSocket;
+        _closing = false;
+        _error.clear();
+
+        Subscribe();
+
+        return true;
+    }
+
+    FramePtr DatagramReceiver::ReceiveFrame()
+    {
+        while (!_closing)
+        {
+            Io::DatagramReassembler::Clock::time_point now =
+                Io::DatagramReassembler::Clock::now();
+
+            if (now - _lastSubscriptionTime >= c_subscriptionPeriod)
+            {
+                Subscribe();
+            }
+
+            Io::DatagramReassembler::Clock::time_point until =
+                std::min(
+                    _lastSubscriptionTime + c_subscriptionPeriod,
+                    now + c_maximumWait);
+
+            {
+                std::lock_guard<std::mutex> lock(_reassemblerMutex);
+
+                while (_reassembler.TryGetFrame(now, &_frame))
+                {
+                    FramePtr frame =
+                        TakeFrame();
+
+                    if (nullptr != frame)
+                    {
+                        return frame;
+                    }
+                }
+
+                Io::DatagramReassembler::Clock::time_point deadline;
+
+                if (_reassembler.GetNextDeadline(&deadline))
+                {
+                    until = std::min(until, deadline);
+                }
+            }
+
+            if (!ReceiveDatagrams(until))
+            {
+                return FramePtr();
+            }
+        }
+
+        _error = "closed";
+
+        return FramePtr();
+    }
+
+    void DatagramReceiver::Close()
+    {
+        _closing = true;
+    }
+
+    DatagramReceiverStatistics DatagramReceiver::GetStatistics() const
+    {
+        DatagramReceiverStatistics statistics;
+
+        {
+            std::lock_guard<std::mutex> lock(_reassemblerMutex);
+
+            statistics.Datagrams = _reassembler.GetStatistics();
+        }
+
+        statistics.FramesReceived = _framesReceived;
+        statistics.FramesDropped = _framesDropped;
+        statistics.FramesTooLarge = _framesTooLarge;
+        statistics.FramesMalformed = _framesMalformed;
+        statistics.BytesReceived = _bytesReceived;
+
+        return statistics;
+    }
+
+    void DatagramReceiver::Subscribe()
+    {
+        uint8_t subscription[sizeof(Io::DatagramSubscribeCookie)];
+
+        for (size_t i = 0; i < sizeof(subscription); ++i)
+        {
+            subscription[i] = static_cast<uint8_t>(Io::DatagramSubscribeCookie >> (8 * i));
+        }
+
+        //
+        // A lost subscription is made up for by the next one.
+        //
+        send(
+            _socket,
+            subscription,
+            sizeof(subscription),
+            0);
+
+        _lastSubscriptionTime =
+            Io::DatagramReassembler::Clock::now();
+    }
+
+    bool DatagramReceiver::ReceiveDatagrams(
+        Io::DatagramReassembler::Clock::time_point until)
+    {
+        const auto timeout =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                until - Io::DatagramReassembler::Clock::now());
+
+        pollfd descriptor = {};
+
+        descriptor.fd = _socket;
+        descriptor.events = POLLIN;
+
+        // Rounded up, so that deadlines have passed when poll times out.
+        const int pollResult =
+            poll(&descriptor, 1, std::max<int>(0, static_cast<int>(timeout.count()) + 1));
+
+        if (pollResult <= 0)
+        {
+            if (pollResult < 0 && EINTR != errno)
+            {
+                _error = std::string("failed to wait for datagrams: ") + strerror(errno);
+
+                return false;
+            }
+
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lock(_reassemblerMutex);
+
+        for (;;)
+        {
+            const ssize_t bytesReceived =
+                recv(_socket, _datagram.data(), _datagram.size(), MSG_DONTWAIT);
+
+            if (bytesReceived < 0)
+            {
+                //
+                // The server isn't listening (yet): keep subscribing.
+                //
+                if (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno || ECONNREFUSED == errno)
+                {
+                    return true;
+                }
+
+                _error = std::string("failed to receive a datagram: ") + strerror(errno);
+
+                return false;
+            }
+
+            _reassembler.AddDatagram(
+                _datagram.data(),
+                static_cast<size_t>(bytesReceived),
+                Io::DatagramReassembler::Clock::now());
+        }
+    }
+
+    FramePtr DatagramReceiver::TakeFrame()
+    {
+        FrameHeader header;
+
+        size_t headerLength =
+            ProtocolHeaderLength;
+
+        bool isWellFormed =
+            _frame.size() >= headerLength &&
+            ParseHeader(_frame.data(), &header);
+
+        if (isWellFormed)
+        {
+            headerLength +=
+                GetExtendedHeaderLength(header.VersionMinor);
+
+            isWellFormed =
+                _frame.size() >= headerLength &&
+                ParseExtendedFields(_frame.data() + ProtocolHeaderLength, &header) &&
+                _frame.size() == headerLength + header.ExtensionsLength + header.PayloadLength;
+        }
+
+        if (!isWellFormed)
+        {
+            ++_framesMalformed;
+
+            return FramePtr();
+        }
+
+        _bytesReceived += _frame.size();
+
+        if (header.PayloadLength > _pool.GetPayloadCapacity())
+        {
+            ++_framesTooLarge;
+
+            return FramePtr();
+        }
+
+        FramePtr frame =
+            _pool.TryAcquire();
+
+        if (nullptr == frame)
+        {
+            ++_framesDropped;
+
+            return FramePtr();
+        }
+
+        //
+        // The extension storage of a pooled frame only grows, so that it stops
+        // allocating after the first few frames.
+        //
+        if (frame->_extensionsStorage.size() < header.ExtensionsLength)
+        {
+            frame->_extensionsStorage.resize(
+                header.ExtensionsLength);
+        }
+
+        frame->Header = header;
+        frame->Extensions = frame->_extensionsStorage.data();
+
+        std::copy_n(
+            _frame.data() + headerLength,
+            header.ExtensionsLength,
+            frame->_extensionsStorage.data());
+
+        std::copy_n(
+            _frame.data() + headerLength + header.ExtensionsLength,
+            header.PayloadLength,
+            frame->Payload);
+
+        ++_framesReceived;
+
+        return frame;
+    }
+}
@@ -0,0 +1,125 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include "FrameBufferPool.h"
+
+#include <Io/DatagramFraming.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace SensorStream
+{
+    struct DatagramReceiverStatistics
+    {
+        Io::DatagramReassemblyStatistics Datagrams;
+
+        uint64_t FramesReceived;
+
+        // Reassembled frames skipped because no pooled frame was free, or
+        // because their payload didn't fit in one.
+        uint64_t FramesDropped;
+        uint64_t FramesTooLarge;
+
+        // Reassembled frames whose header was inconsistent with their length.
+        uint64_t FramesMalformed;
+
+        uint64_t BytesReceived;
+    };
+
+    //
+    // Receives the frames of a HoloLensForCV datagram streaming server into the
+    // frames of a pool. Frames that lose a datagram are dropped once their
+    // deadline has passed, rather than holding back the frames that follow.
+    //
+    class DatagramReceiver
+    {
+    public:
+        explicit DatagramReceiver(
+            FrameBufferPool& pool,
+            std::chrono::milliseconds deadline = std::chrono::milliseconds(50));
+
+        ~DatagramReceiver();
+
+        DatagramReceiver(const DatagramReceiver&) = delete;
+        DatagramReceiver& operator=(const DatagramReceiver&) = delete;
+
+        //
+        // Subscribes to the stream of the server. The subscription is renewed
+        // while frames are being received.
+        //
+        bool Connect(
+            const char* host,
+            uint16_t port);
+
+        //
+        // Blocks until the next frame has been reassembled. Returns nullptr once
+        // the receiver is closed or the socket fails; see GetError.
+        //
+        FramePtr ReceiveFrame();
+
+        //
+        // Unblocks ReceiveFrame. May be called from any thread.
+        //
+        void Close();
+
+        DatagramReceiverStatistics GetStatistics() const;
+
+        const std::string& GetError() const
+        {
+            return _error;
+        }
+
+    private:
+        void Subscribe();
+
+        //
+        // Waits for datagrams until the given time, and adds those that arrived
+        // to the reassembler. Returns false if the socket failed.
+        //
+        bool ReceiveDatagrams(
+            Io::DatagramReassembler::Clock::time_point until);
+
+        //
+        // Copies a reassembled frame into a pooled frame.
+        //
+        FramePtr TakeFrame();
+
+    private:
+        FrameBufferPool& _pool;
+
+        int _socket;
+        std::atomic<bool> _closing;
+        std::string _error;
+
+        Io::DatagramReassembler::Clock::time_point _lastSubscriptionTime;
+
+        mutable std::mutex _reassemblerMutex;
+        Io::DatagramReassembler _reassembler;
+
+        std::vector<uint8_t> _datagram;
+        std::vector<uint8_t> _frame;
+
+        std::atomic<uint64_t> _framesReceived;
+        std::atomic<uint64_t> _framesDropped;
+        std::atomic<uint64_t> _framesTooLarge;
+        std::atomic<uint64_t> _framesMalformed;
+        std::atomic<uint64_t> _bytesReceived;
+    };
+}
@@ -0,0 +1,191 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "FrameBufferPool.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace SensorStream
+{
+    void FrameReleaser::operator()(
+        Frame* frame) const
+    {
+        frame->_pool->Release(
+            frame);
+    }
+
+    FrameBufferPool::FrameBufferPool(
+        size_t frameCount,
+        size_t payloadCapacity,
+        size_t alignment)
+        : _frameCount(frameCount)
+        , _payloadCapacity(payloadCapacity)
+        , _storage(nullptr)
+        , _cellMask(0)
+        , _enqueuePosition(0)
+        , _dequeuePosition(0)
+    {
+        assert(frameCount > 0);
+        assert(alignment >= sizeof(void*) && 0 == (alignment & (alignment - 1)));
+
+        const size_t payloadStride =
+            (payloadCapacity + alignment - 1) & ~(alignment - 1);
+
+        void* storage = nullptr;
+
+        if (0 != posix_memalign(&storage, alignment, payloadStride * frameCount))
+        {
+            throw std::bad_alloc();
+        }
+
+        _storage = static_cast<uint8_t*>(storage);
+
+        size_t cellCount = 1;
+
+        while (cellCount < frameCount)
+        {
+            cellCount <<= 1;
+        }
+
+        _cellMask = cellCount - 1;
+        _cells.reset(new Cell[cellCount]);
+
+        for (size_t i = 0; i < cellCount; ++i)
+        {
+            _cells[i].Sequence.store(i, std::memory_order_relaxed);
+            _cells[i].Value = nullptr;
+        }
+
+        _frames.reset(new Frame[frameCount]);
+
+        for (size_t i = 0; i < frameCount; ++i)
+        {
+            Frame& frame = _frames[i];
+
+            frame.Header = FrameHeader();
+            frame.Extensions = nullptr;
+            frame.Payload = nullptr;
+            frame._pool = this;
+            frame._payloadStorage = _storage + i * payloadStride;
+
+            TryEnqueue(
+                &frame);
+        }
+    }
+
+    FrameBufferPool::~FrameBufferPool()
+    {
+        free(_storage);
+    }
+
+    FramePtr FrameBufferPool::TryAcquire()
+    {
+        Frame* frame = TryDequeue();
+
+        if (nullptr != frame)
+        {
+            frame->Payload = frame->_payloadStorage;
+        }
+
+        return FramePtr(frame);
+    }
+
+    void FrameBufferPool::Release(
+        Frame* frame)
+    {
+        //
+        // There are as many cells as frames, so there is always room.
+        //
+        const bool enqueued =
+            TryEnqueue(frame);
+
+        assert(enqueued);
+        (void)enqueued;
+    }
+
+    bool FrameBufferPool::TryEnqueue(
+        Frame* frame)
+    {
+        size_t position =
+            _enqueuePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Cell& cell = _cells[position & _cellMask];
+
+            const size_t sequence =
+                cell.Sequence.load(std::memory_order_acquire);
+
+            const intptr_t difference =
+                static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (0 == difference)
+            {
+                if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.Value = frame;
+                    cell.Sequence.store(position + 1, std::memory_order_release);
+
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Frame* FrameBufferPool::TryDequeue()
+    {
+        size_t position =
+            _dequeuePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Cell& cell = _cells[position & _cellMask];
+
+            const size_t sequence =
+                cell.Sequence.load(std::memory_order_acquire);
+
+            const intptr_t difference =
+                static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+            if (0 == difference)
+            {
+                if (_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    Frame* frame = cell.Value;
+
+                    cell.Sequence.store(position + _cellMask + 1, std::memory_order_release);
+
+                    return frame;
+                }
+            }
+            else if (difference < 0)
+            {
+                return nullptr;
+            }
+            else
+            {
+                position = _dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
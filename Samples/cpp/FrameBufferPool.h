@@ -0,0 +1,129 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include "SensorStreamProtocol.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace SensorStream
+{
+    class FrameBufferPool;
+
+    //
+    // A received frame. The payload is the image, compressed if
+    // Header.PayloadCodec isn't Raw.
+    //
+    struct Frame
+    {
+        FrameHeader Header;
+
+        // Header.ExtensionsLength bytes (see Io/FrameHeaderExtensions.h).
+        const uint8_t* Extensions;
+
+        // Header.PayloadLength bytes, aligned to the alignment of the pool.
+        uint8_t* Payload;
+
+    private:
+        friend class FrameBufferPool;
+        friend class SensorStreamReceiver;
+        friend class DatagramReceiver;
+        friend struct FrameReleaser;
+
+        FrameBufferPool* _pool;
+        uint8_t* _payloadStorage;
+        std::vector<uint8_t> _extensionsStorage;
+    };
+
+    struct FrameReleaser
+    {
+        void operator()(
+            Frame* frame) const;
+    };
+
+    //
+    // Returns the frame to its pool when dropped.
+    //
+    typedef std::unique_ptr<Frame, FrameReleaser> FramePtr;
+
+    //
+    // Fixed set of frames whose payload buffers are allocated once, up front.
+    // Frames are acquired and released without locks or allocations, and may
+    // be released from any thread. The pool must outlive its frames.
+    //
+    class FrameBufferPool
+    {
+    public:
+        FrameBufferPool(
+            size_t frameCount,
+            size_t payloadCapacity,
+            size_t alignment = 64);
+
+        ~FrameBufferPool();
+
+        FrameBufferPool(const FrameBufferPool&) = delete;
+        FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+
+        //
+        // Returns nullptr if all the frames are in use.
+        //
+        FramePtr TryAcquire();
+
+        size_t GetFrameCount() const
+        {
+            return _frameCount;
+        }
+
+        size_t GetPayloadCapacity() const
+        {
+            return _payloadCapacity;
+        }
+
+    private:
+        friend struct FrameReleaser;
+
+        void Release(
+            Frame* frame);
+
+        //
+        // The free frames are kept in a bounded multi-producer multi-consumer
+        // queue (D. Vyukov's), whose sequence numbers rule out ABA problems.
+        //
+        struct Cell
+        {
+            std::atomic<size_t> Sequence;
+            Frame* Value;
+        };
+
+        bool TryEnqueue(
+            Frame* frame);
+
+        Frame* TryDequeue();
+
+    private:
+        const size_t _frameCount;
+        const size_t _payloadCapacity;
+
+        uint8_t* _storage;
+        std::unique_ptr<Frame[]> _frames;
+
+        std::unique_ptr<Cell[]> _cells;
+        size_t _cellMask;
+
+        alignas(64) std::atomic<size_t> _enqueuePosition;
+        alignas(64) std::atomic<size_t> _dequeuePosition;
+    };
+}
@@ -0,0 +1,96 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include "FrameBufferPool.h"
+
+namespace SensorStream
+{
+    //
+    // Lock-free single-producer single-consumer queue of frames, to hand frames
+    // from the receiving thread to a processing thread.
+    //
+    class FrameQueue
+    {
+    public:
+        explicit FrameQueue(
+            size_t capacity)
+            : _slots(new Frame*[capacity + 1])
+            , _slotCount(capacity + 1)
+            , _head(0)
+            , _tail(0)
+        {
+        }
+
+        ~FrameQueue()
+        {
+            while (nullptr != TryPop())
+            {
+            }
+        }
+
+        FrameQueue(const FrameQueue&) = delete;
+        FrameQueue& operator=(const FrameQueue&) = delete;
+
+        //
+        // Producer side. Leaves the frame with the caller if the queue is full.
+        //
+        bool TryPush(
+            FramePtr& frame)
+        {
+            const size_t tail =
+                _tail.load(std::memory_order_relaxed);
+
+            const size_t nextTail =
+                (tail + 1 == _slotCount) ? 0 : tail + 1;
+
+            if (nextTail == _head.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            _slots[tail] = frame.release();
+            _tail.store(nextTail, std::memory_order_release);
+
+            return true;
+        }
+
+        //
+        // Consumer side. Returns nullptr if the queue is empty.
+        //
+        FramePtr TryPop()
+        {
+            const size_t head =
+                _head.load(std::memory_order_relaxed);
+
+            if (head == _tail.load(std::memory_order_acquire))
+            {
+                return FramePtr();
+            }
+
+            Frame* frame = _slots[head];
+
+            _head.store((head + 1 == _slotCount) ? 0 : head + 1, std::memory_order_release);
+
+            return FramePtr(frame);
+        }
+
+    private:
+        std::unique_ptr<Frame*[]> _slots;
+        const size_t _slotCount;
+
+        alignas(64) std::atomic<size_t> _head;
+        alignas(64) std::atomic<size_t> _tail;
+    };
+}
@@ -0,0 +1,506 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "LoopbackServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace SensorStream
+{
+    namespace
+    {
+        //
+        // Resumes partial writes where they stopped.
+        //
+        bool SendAll(
+            int socket,
+            const uint8_t* data,
+            size_t size)
+        {
+            while (size > 0)
+            {
+                const ssize_t bytesSent =
+                    send(socket, data, size, MSG_NOSIGNAL);
+
+                if (bytesSent < 0)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+
+                    return false;
+                }
+
+                data += bytesSent;
+                size -= static_cast<size_t>(bytesSent);
+            }
+
+            return true;
+        }
+    }
+
+    LoopbackServer::LoopbackServer(
+        const LoopbackServerOptions& options)
+        : _options(options)
+        , _listener(-1)
+        , _port(0)
+        , _stopping(false)
+        , _framesSent(0)
+        , _fanOut(options.MaximumClients)
+        , _framesQueued(0)
+        , _streamEnded(false)
+        , _header()
+    {
+        _header.Cookie = ProtocolCookie;
+        _header.VersionMajor = ProtocolVersionMajor;
+        _header.VersionMinor = _options.VersionMinor;
+        _header.FrameType = _options.FrameType;
+        _header.ImageWidth = _options.ImageWidth;
+        _header.ImageHeight = _options.ImageHeight;
+        _header.PixelStride = _options.PixelStride;
+        _header.RowStride = _options.ImageWidth * _options.PixelStride;
+        _header.PayloadCodec = Codec::Raw;
+        _header.PayloadLength = _options.ImageHeight * _header.RowStride;
+
+        if (_options.VersionMinor >= ProtocolVersionMinorWithoutCompression)
+        {
+            _header.ExtensionsLength = _options.ExtensionsLength;
+        }
+
+        uint8_t headerData[ProtocolHeaderLength + ProtocolMaximumExtendedHeaderLength];
+
+        _headerLength =
+            WriteHeader(_header, headerData);
+    }
+
+    LoopbackServer::~LoopbackServer()
+    {
+        Stop();
+    }
+
+    bool LoopbackServer::Start()
+    {
+        _listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (_listener < 0)
+        {
+            return false;
+        }
+
+        const int reuseAddress = 1;
+
+        setsockopt(
+            _listener,
+            SOL_SOCKET,
+            SO_REUSEADDR,
+            &reuseAddress,
+            sizeof(reuseAddress));
+
+        sockaddr_in address = {};
+
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(_options.Port);
+
+        socklen_t addressLength = sizeof(address);
+
+        if (0 != bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) ||
+            0 != listen(_listener, static_cast<int>(_options.MaximumClients)) ||
+            0 != getsockname(_listener, reinterpret_cast<sockaddr*>(&address), &addressLength))
+        {
+            close(_listener);
+            _listener = -1;
+
+            return false;
+        }
+
+        _port = ntohs(address.sin_port);
+        _stopping = false;
+
+        _thread = std::thread(
+            [this]()
+            {
+                Serve();
+            });
+
+        _producerThread = std::thread(
+            [this]()
+            {
+                Produce();
+            });
+
+        return true;
+    }
+
+    void LoopbackServer::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_clientsMutex);
+
+            _stopping = true;
+        }
+
+        _clientConnected.notify_all();
+        _frameQueued.notify_all();
+
+        if (_listener >= 0)
+        {
+            shutdown(_listener, SHUT_RDWR);
+        }
+
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+
+        //
+        // Release the producer and the writers waiting on the queues, then the
+        // writers blocked on their sockets.
+        //
+        _fanOut.Close();
+
+        if (_producerThread.joinable())
+        {
+            _producerThread.join();
+        }
+
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+
+        for (const std::shared_ptr<Client>& client : _clients)
+        {
+            if (client->Socket >= 0)
+            {
+                shutdown(client->Socket, SHUT_RDWR);
+            }
+        }
+
+        for (const std::shared_ptr<Client>& client : _clients)
+        {
+            if (client->Thread.joinable())
+            {
+                client->Thread.join();
+            }
+
+            if (client->Socket >= 0)
+            {
+                close(client->Socket);
+                client->Socket = -1;
+            }
+        }
+
+        if (_listener >= 0)
+        {
+            close(_listener);
+            _listener = -1;
+        }
+    }
+
+    std::vector<Io::SendQueueStatistics> LoopbackServer::GetClientStatistics()
+    {
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+
+        std::vector<Io::SendQueueStatistics> statistics;
+
+        for (const std::shared_ptr<Client>& client : _clients)
+        {
+            statistics.push_back(
+                client->Queue->GetStatistics());
+        }
+
+        return statistics;
+    }
+
+    void LoopbackServer::Serve()
+    {
+        while (!_stopping)
+        {
+            const int clientSocket =
+                accept(_listener, nullptr, nullptr);
+
+            if (clientSocket < 0)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+
+                return;
+            }
+
+            RemoveFinishedClients();
+
+            auto client =
+                std::make_shared<Client>();
+
+            client->Socket = clientSocket;
+            client->Finished = false;
+
+            //
+            // Clients that connect once the last frame has been queued are
+            // refused like those beyond the maximum. The writes to a client are
+            // made one at a time by its writer.
+            //
+            bool streamEnded = false;
+
+            {
+                std::lock_guard<std::mutex> lock(_clientsMutex);
+
+                streamEnded = _streamEnded;
+            }
+
+            if (!streamEnded)
+            {
+                client->Queue =
+                    _fanOut.AddClient(
+                        client,
+                        _options.QueueCapacity,
+                        1 /* maximumWritesInFlight */,
+                        _options.Policy);
+            }
+
+            if (nullptr == client->Queue)
+            {
+                close(clientSocket);
+
+                continue;
+            }
+
+            Client* const clientToWriteTo =
+                client.get();
+
+            client->Thread = std::thread(
+                [this, clientToWriteTo]()
+                {
+                    WriteTo(
+                        clientToWriteTo);
+                });
+
+            {
+                std::lock_guard<std::mutex> lock(_clientsMutex);
+
+                _clients.push_back(
+                    std::move(client));
+            }
+
+            _clientConnected.notify_all();
+        }
+    }
+
+    void LoopbackServer::Produce()
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        const size_t payloadOffset =
+            _headerLength + _header.ExtensionsLength;
+
+        // Frames are paced from the first one produced for connected clients.
+        bool isPaced = false;
+        Clock::time_point startTime;
+        uint64_t startFrameIndex = 0;
+
+        for (uint64_t frameIndex = 0;
+             !_stopping && (0 == _options.FrameCount || frameIndex < _options.FrameCount);
+             ++frameIndex)
+        {
+            if (0 == _fanOut.GetClientCount())
+            {
+                std::unique_lock<std::mutex> lock(_clientsMutex);
+
+                _clientConnected.wait(
+                    lock,
+                    [this]() { return _stopping || _fanOut.GetClientCount() > 0; });
+
+                if (_stopping)
+                {
+                    return;
+                }
+
+                isPaced = false;
+            }
+
+            if (!isPaced)
+            {
+                startTime = Clock::now();
+                startFrameIndex = frameIndex;
+                isPaced = true;
+            }
+
+            if (_options.FramesPerSecond > 0.0)
+            {
+                std::this_thread::sleep_until(
+                    startTime +
+                    std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::duration<double>((frameIndex - startFrameIndex) / _options.FramesPerSecond)));
+            }
+
+            std::shared_ptr<std::vector<uint8_t>> frame =
+                AcquireFrameBuffer();
+
+            _header.Timestamp = frameIndex;
+
+            WriteHeader(
+                _header,
+                frame->data());
+
+            memcpy(
+                frame->data() + payloadOffset,
+                &frameIndex,
+                std::min<size_t>(sizeof(frameIndex), _header.PayloadLength));
+
+            //
+            // The frames of the loopback server don't depend on each other.
+            //
+            _fanOut.Push(
+                frame,
+                frame->size(),
+                true /* isKeyframe */);
+
+            {
+                std::lock_guard<std::mutex> lock(_clientsMutex);
+
+                ++_framesQueued;
+            }
+
+            _frameQueued.notify_all();
+
+            ++_framesSent;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_clientsMutex);
+
+            _streamEnded = true;
+        }
+
+        _frameQueued.notify_all();
+    }
+
+    void LoopbackServer::WriteTo(
+        Client* client)
+    {
+        uint64_t framesQueued = 0;
+        bool streamEnded = false;
+
+        while (!streamEnded && !client->Queue->IsClosed())
+        {
+            {
+                std::unique_lock<std::mutex> lock(_clientsMutex);
+
+                _frameQueued.wait(
+                    lock,
+                    [this, framesQueued]() { return _stopping || _streamEnded || _framesQueued != framesQueued; });
+
+                framesQueued = _framesQueued;
+
+                //
+                // The frames queued before the end of the stream are sent
+                // before the client is disconnected.
+                //
+                streamEnded = _stopping || _streamEnded;
+            }
+
+            SharedFrame frame;
+            size_t frameSize = 0;
+
+            while (client->Queue->TryBeginSend(&frame, &frameSize))
+            {
+                const bool succeeded =
+                    SendAll(
+                        client->Socket,
+                        frame->data(),
+                        frameSize);
+
+                //
+                // Lets the producer reuse the buffer of the frame.
+                //
+                frame.reset();
+
+                client->Queue->EndSend(
+                    frameSize,
+                    succeeded);
+
+                if (!succeeded)
+                {
+                    client->Queue->Close();
+
+                    break;
+                }
+            }
+        }
+
+        shutdown(client->Socket, SHUT_RDWR);
+
+        client->Finished = true;
+    }
+
+    std::shared_ptr<std::vector<uint8_t>> LoopbackServer::AcquireFrameBuffer()
+    {
+        //
+        // Only this thread hands out references to the buffers, so a buffer
+        // held by nobody else stays free. The fence orders the writes to it
+        // after the last reads of the writer that released it.
+        //
+        for (const std::shared_ptr<std::vector<uint8_t>>& frameBuffer : _frameBuffers)
+        {
+            if (1 == frameBuffer.use_count())
+            {
+                std::atomic_thread_fence(
+                    std::memory_order_acquire);
+
+                return frameBuffer;
+            }
+        }
+
+        auto frameBuffer =
+            std::make_shared<std::vector<uint8_t>>(
+                _headerLength + _header.ExtensionsLength + _header.PayloadLength);
+
+        uint8_t* payload =
+            frameBuffer->data() + _headerLength + _header.ExtensionsLength;
+
+        for (size_t i = 0; i < _header.PayloadLength; ++i)
+        {
+            payload[i] = static_cast<uint8_t>(i * 7 + i / 4096);
+        }
+
+        _frameBuffers.push_back(
+            frameBuffer);
+
+        return frameBuffer;
+    }
+
+    void LoopbackServer::RemoveFinishedClients()
+    {
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+
+        for (const std::shared_ptr<Client>& client : _clients)
+        {
+            if (client->Finished && client->Thread.joinable())
+            {
+                client->Thread.join();
+
+                close(client->Socket);
+                client->Socket = -1;
+            }
+        }
+    }
+}
@@ -0,0 +1,162 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include "SensorStreamProtocol.h"
+
+#include <Io/FrameFanOut.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SensorStream
+{
+    //
+    // A serialized frame, encoded once and shared by the queues of the clients.
+    //
+    typedef std::shared_ptr<const std::vector<uint8_t>> SharedFrame;
+
+    struct LoopbackServerOptions
+    {
+        // Zero picks a free port; see LoopbackServer::GetPort.
+        uint16_t Port = 0;
+
+        uint16_t FrameType = 1 /* PhotoVideo */;
+        uint32_t ImageWidth = 1280;
+        uint32_t ImageHeight = 720;
+        uint32_t PixelStride = 4;
+
+        // Version 0.2 and 0.3 headers carry a zero-filled extension block of
+        // ExtensionsLength bytes.
+        uint8_t VersionMinor = ProtocolVersionMinorWithoutExtensions;
+        uint32_t ExtensionsLength = 0;
+
+        // Zero streams until the server is stopped. Otherwise the clients are
+        // disconnected once they have been sent the last frame.
+        uint64_t FrameCount = 0;
+
+        // Zero streams as fast as the Block policy lets through, or as fast as
+        // frames can be produced with the other policies.
+        double FramesPerSecond = 0.0;
+
+        // Further connections are closed.
+        uint32_t MaximumClients = 1;
+
+        // Send queue of each client.
+        Io::SendQueuePolicy Policy = Io::SendQueuePolicy::Block;
+        uint32_t QueueCapacity = 4;
+    };
+
+    //
+    // Serves synthetic frames to its clients, to test and benchmark receivers
+    // without a HoloLens. Frames are produced while clients are connected; the
+    // timestamp of each frame is its index, which is also stored in the first 8
+    // bytes of its payload. Each frame is serialized once into a recycled
+    // buffer, and queued for all the clients through the fan-out of the
+    // Shared/Io library, like HoloLensForCV's SensorFrameStreamingServer does.
+    //
+    class LoopbackServer
+    {
+    public:
+        explicit LoopbackServer(
+            const LoopbackServerOptions& options);
+
+        ~LoopbackServer();
+
+        LoopbackServer(const LoopbackServer&) = delete;
+        LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+        bool Start();
+
+        void Stop();
+
+        uint16_t GetPort() const
+        {
+            return _port;
+        }
+
+        //
+        // Frames queued for the clients.
+        //
+        uint64_t GetFramesSent() const
+        {
+            return _framesSent;
+        }
+
+        //
+        // Statistics of every client served, in the order they connected.
+        //
+        std::vector<Io::SendQueueStatistics> GetClientStatistics();
+
+    private:
+        struct Client
+        {
+            int Socket;
+            std::shared_ptr<Io::FrameSendQueue<SharedFrame>> Queue;
+            std::thread Thread;
+            std::atomic<bool> Finished;
+        };
+
+        typedef Io::FrameFanOut<SharedFrame, Client> FanOut;
+
+        void Serve();
+
+        void Produce();
+
+        void WriteTo(
+            Client* client);
+
+        //
+        // A frame buffer that no client queue refers to anymore, or a new one.
+        //
+        std::shared_ptr<std::vector<uint8_t>> AcquireFrameBuffer();
+
+        // Joins the writers of the clients that are gone.
+        void RemoveFinishedClients();
+
+    private:
+        const LoopbackServerOptions _options;
+
+        int _listener;
+        uint16_t _port;
+
+        std::atomic<bool> _stopping;
+        std::atomic<uint64_t> _framesSent;
+        std::thread _thread;
+        std::thread _producerThread;
+
+        FanOut _fanOut;
+
+        std::mutex _clientsMutex;
+        std::condition_variable _clientConnected;
+        std::vector<std::shared_ptr<Client>> _clients;
+
+        //
+        // The writers of the clients wait for frames to be queued, or for the
+        // last one to have been.
+        //
+        std::condition_variable _frameQueued;
+        uint64_t _framesQueued;
+        bool _streamEnded;
+
+        FrameHeader _header;
+        size_t _headerLength;
+        std::vector<std::shared_ptr<std::vector<uint8_t>>> _frameBuffers;
+    };
+}
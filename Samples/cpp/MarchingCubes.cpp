@@ -0,0 +1,147 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "MarchingCubes.h"
+
+namespace SensorStream
+{
+    namespace
+    {
+        //
+        // The corners of each face of the cube, counterclockwise as seen from
+        // outside of the cube.
+        //
+        const uint8_t c_faceCorners[6][4] =
+        {
+            { 0, 4, 6, 2 },     // x = 0
+            { 1, 3, 7, 5 },     // x = 1
+            { 0, 1, 5, 4 },     // y = 0
+            { 2, 6, 7, 3 },     // y = 1
+            { 0, 2, 3, 1 },     // z = 0
+            { 4, 5, 7, 6 },     // z = 1
+        };
+
+        const uint32_t c_noEdge = 0xff;
+
+        uint32_t FindEdge(
+            uint32_t corner,
+            uint32_t otherCorner)
+        {
+            for (uint32_t edge = 0; edge < 12; ++edge)
+            {
+                const uint8_t* corners =
+                    MarchingCubesTable::EdgeCorners[edge];
+
+                if ((corners[0] == corner && corners[1] == otherCorner) ||
+                    (corners[1] == corner && corners[0] == otherCorner))
+                {
+                    return edge;
+                }
+            }
+
+            return c_noEdge;
+        }
+    }
+
+    const uint8_t MarchingCubesTable::EdgeCorners[12][2] =
+    {
+        { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },     // Along x.
+        { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },     // Along y.
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },     // Along z.
+    };
+
+    const MarchingCubesTable& MarchingCubesTable::Get()
+    {
+        static const MarchingCubesTable table;
+
+        return table;
+    }
+
+    MarchingCubesTable::MarchingCubesTable()
+    {
+        for (uint32_t cubeCase = 0; cubeCase < 256; ++cubeCase)
+        {
+            //
+            // Going counterclockwise around a face, the surface enters it where
+            // the corners go from outside to inside, and leaves it where they go
+            // back outside. Each crossed edge is shared by two faces, entered
+            // through one and left through the other, so following the edges
+            // from face to face closes loops around the inside corners.
+            //
+            uint32_t nextEdge[12];
+
+            for (uint32_t edge = 0; edge < 12; ++edge)
+            {
+                nextEdge[edge] = c_noEdge;
+            }
+
+            for (const uint8_t* corners : c_faceCorners)
+            {
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    const uint32_t previous = corners[(i + 3) % 4];
+
+                    if (0 != (cubeCase & (1u << previous)) ||
+                        0 == (cubeCase & (1u << corners[i])))
+                    {
+                        continue;
+                    }
+
+                    uint32_t last = i;
+
+                    while (0 != (cubeCase & (1u << corners[(last + 1) % 4])))
+                    {
+                        last = (last + 1) % 4;
+                    }
+
+                    nextEdge[FindEdge(previous, corners[i])] =
+                        FindEdge(corners[last], corners[(last + 1) % 4]);
+                }
+            }
+
+            //
+            // Fan out each loop into triangles.
+            //
+            uint32_t triangleCount = 0;
+            bool isVisited[12] = {};
+
+            for (uint32_t firstEdge = 0; firstEdge < 12; ++firstEdge)
+            {
+                if (c_noEdge == nextEdge[firstEdge] || isVisited[firstEdge])
+                {
+                    continue;
+                }
+
+                uint32_t loop[12];
+                uint32_t loopLength = 0;
+
+                for (uint32_t edge = firstEdge; !isVisited[edge]; edge = nextEdge[edge])
+                {
+                    isVisited[edge] = true;
+                    loop[loopLength++] = edge;
+                }
+
+                for (uint32_t i = 1; i + 1 < loopLength; ++i)
+                {
+                    _triangles[cubeCase][triangleCount][0] = static_cast<uint8_t>(loop[0]);
+                    _triangles[cubeCase][triangleCount][1] = static_cast<uint8_t>(loop[i]);
+                    _triangles[cubeCase][triangleCount][2] = static_cast<uint8_t>(loop[i + 1]);
+
+                    ++triangleCount;
+                }
+            }
+
+            _triangleCounts[cubeCase] = static_cast<uint8_t>(triangleCount);
+        }
+    }
+}
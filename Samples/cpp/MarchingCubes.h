@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace SensorStream
+{
+    //
+    // Triangles of the marching cubes cases. Corner i of a cube is at
+    // (i & 1, (i >> 1) & 1, (i >> 2) & 1); a case has bit i set when corner i
+    // is inside the surface (negative distance).
+    //
+    // The table is built by walking the faces of the cube rather than typed
+    // in: on each face, the surface crosses the edges between inside and
+    // outside corners, and faces with two opposite inside corners always keep
+    // them apart. Neighboring cubes see the same crossings on the face they
+    // share, so the surface is closed, and its triangles face the outside.
+    //
+    class MarchingCubesTable
+    {
+    public:
+        static const uint32_t MaximumTriangleCount = 12;
+
+        static const MarchingCubesTable& Get();
+
+        //
+        // The two corners of each of the 12 edges of a cube.
+        //
+        static const uint8_t EdgeCorners[12][2];
+
+        uint32_t GetTriangleCount(
+            uint32_t cubeCase) const
+        {
+            return _triangleCounts[cubeCase];
+        }
+
+        //
+        // The edges of the cube on which the triangle's vertices lie.
+        //
+        const uint8_t* GetTriangle(
+            uint32_t cubeCase,
+            uint32_t triangle) const
+        {
+            return _triangles[cubeCase][triangle];
+        }
+
+    private:
+        MarchingCubesTable();
+
+    private:
+        uint8_t _triangleCounts[256];
+        uint8_t _triangles[256][MaximumTriangleCount][3];
+    };
+}
@@ -0,0 +1,435 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "Recording.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace SensorStream
+{
+    namespace
+    {
+        const size_t c_tarBlockSize = 512;
+
+        //
+        // Splits a line of a CSV file at its commas; the recorder doesn't quote
+        // its values.
+        //
+        std::vector<std::string> SplitCsvLine(
+            const std::string& line)
+        {
+            std::vector<std::string> values;
+            size_t begin = 0;
+
+            for (;;)
+            {
+                const size_t end = line.find(',', begin);
+
+                values.push_back(
+                    line.substr(begin, (std::string::npos == end) ? std::string::npos : end - begin));
+
+                if (std::string::npos == end)
+                {
+                    return values;
+                }
+
+                begin = end + 1;
+            }
+        }
+
+        size_t FindColumn(
+            const std::vector<std::string>& columns,
+            const char* name)
+        {
+            for (size_t i = 0; i < columns.size(); ++i)
+            {
+                if (columns[i] == name)
+                {
+                    return i;
+                }
+            }
+
+            return std::string::npos;
+        }
+
+        uint64_t ParseOctal(
+            const char* field,
+            size_t length)
+        {
+            uint64_t value = 0;
+
+            for (size_t i = 0; i < length && field[i] >= '0' && field[i] <= '7'; ++i)
+            {
+                value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+            }
+
+            return value;
+        }
+
+        //
+        // Skips the whitespace after a PGM header field, returning false at the
+        // end of the file.
+        //
+        bool ParseBitmapNumber(
+            const uint8_t* data,
+            size_t size,
+            size_t* offset,
+            uint32_t* value)
+        {
+            while (*offset < size && isspace(data[*offset]))
+            {
+                ++*offset;
+            }
+
+            if (*offset == size || !isdigit(data[*offset]))
+            {
+                return false;
+            }
+
+            *value = 0;
+
+            while (*offset < size && isdigit(data[*offset]))
+            {
+                *value = *value * 10 + (data[*offset] - '0');
+                ++*offset;
+            }
+
+            return *offset < size;
+        }
+    }
+
+    RecordingReader::RecordingReader()
+        : _tarball(nullptr)
+        , _skippedFrameCount(0)
+    {
+    }
+
+    RecordingReader::~RecordingReader()
+    {
+        if (nullptr != _tarball)
+        {
+            fclose(_tarball);
+        }
+    }
+
+    bool RecordingReader::Open(
+        const std::string& recordingFolder,
+        const std::string& sensorName)
+    {
+        if (!ReadPoses(recordingFolder + "/" + sensorName + ".csv"))
+        {
+            return false;
+        }
+
+        const std::string tarballPath =
+            recordingFolder + "/" + sensorName + ".tar";
+
+        _tarball = fopen(tarballPath.c_str(), "rb");
+
+        if (nullptr == _tarball)
+        {
+            return Fail("failed to open " + tarballPath + ": " + strerror(errno));
+        }
+
+        return true;
+    }
+
+    bool RecordingReader::ReadFrame(
+        RecordedFrame* frame)
+    {
+        uint8_t header[c_tarBlockSize];
+
+        for (;;)
+        {
+            if (1 != fread(header, sizeof(header), 1, _tarball))
+            {
+                return ferror(_tarball) ? Fail("failed to read the tarball") : false;
+            }
+
+            // The tarball ends with empty blocks.
+            if ('\0' == header[0])
+            {
+                return false;
+            }
+
+            const char* fileName = reinterpret_cast<const char*>(header);
+            const char type = static_cast<char>(header[156]);
+
+            const uint64_t fileSize =
+                ParseOctal(reinterpret_cast<const char*>(header) + 124, 12);
+
+            const uint64_t paddedFileSize =
+                (fileSize + c_tarBlockSize - 1) / c_tarBlockSize * c_tarBlockSize;
+
+            //
+            // Frames are stored as <sensor>\<timestamp>.pgm, with the suffix of
+            // their codec if they are compressed.
+            //
+            const std::string name(
+                fileName,
+                strnlen(fileName, 100));
+
+            const size_t baseName = name.find_last_of("\\/");
+
+            const std::string extension =
+                name.substr(std::min(name.size(), name.find('.', (std::string::npos == baseName) ? 0 : baseName)));
+
+            const uint64_t timestamp =
+                strtoull(name.c_str() + ((std::string::npos == baseName) ? 0 : baseName + 1), nullptr, 10);
+
+            const auto pose =
+                _poses.find(timestamp);
+
+            if (('0' != type && '\0' != type) || ".pgm" != extension || _poses.end() == pose)
+            {
+                if ('0' == type || '\0' == type)
+                {
+                    ++_skippedFrameCount;
+                }
+
+                if (0 != fseeko(_tarball, static_cast<off_t>(paddedFileSize), SEEK_CUR))
+                {
+                    return Fail("failed to read the tarball");
+                }
+
+                continue;
+            }
+
+            _buffer.resize(
+                static_cast<size_t>(paddedFileSize));
+
+            if (paddedFileSize > 0 && 1 != fread(_buffer.data(), _buffer.size(), 1, _tarball))
+            {
+                return Fail("the tarball is truncated");
+            }
+
+            _buffer.resize(
+                static_cast<size_t>(fileSize));
+
+            frame->Timestamp = timestamp;
+
+            if (!ParseBitmap(frame))
+            {
+                ++_skippedFrameCount;
+
+                continue;
+            }
+
+            memcpy(frame->FrameToOrigin, pose->second.FrameToOrigin, sizeof(frame->FrameToOrigin));
+            memcpy(frame->CameraViewTransform, pose->second.CameraViewTransform, sizeof(frame->CameraViewTransform));
+
+            return true;
+        }
+    }
+
+    bool RecordingReader::ReadPoses(
+        const std::string& csvPath)
+    {
+        FILE* file = fopen(csvPath.c_str(), "rb");
+
+        if (nullptr == file)
+        {
+            return Fail("failed to open " + csvPath + ": " + strerror(errno));
+        }
+
+        std::string text;
+        char chunk[64 * 1024];
+        size_t chunkSize;
+
+        while ((chunkSize = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            text.append(chunk, chunkSize);
+        }
+
+        fclose(file);
+
+        std::vector<std::string> columns;
+        size_t frameToOriginColumn = std::string::npos;
+        size_t cameraViewTransformColumn = std::string::npos;
+
+        for (size_t begin = 0; begin < text.size();)
+        {
+            size_t end = text.find('\n', begin);
+
+            if (std::string::npos == end)
+            {
+                end = text.size();
+            }
+
+            std::string line = text.substr(begin, end - begin);
+
+            begin = end + 1;
+
+            if (!line.empty() && '\r' == line.back())
+            {
+                line.pop_back();
+            }
+
+            if (line.empty())
+            {
+                continue;
+            }
+
+            if (columns.empty())
+            {
+                columns = SplitCsvLine(line);
+                frameToOriginColumn = FindColumn(columns, "FrameToOrigin.m11");
+                cameraViewTransformColumn = FindColumn(columns, "CameraViewTransform.m11");
+
+                if (std::string::npos == frameToOriginColumn ||
+                    std::string::npos == cameraViewTransformColumn ||
+                    frameToOriginColumn + 16 > columns.size() ||
+                    cameraViewTransformColumn + 16 > columns.size())
+                {
+                    return Fail(csvPath + " doesn't have the poses of the frames");
+                }
+
+                continue;
+            }
+
+            const std::vector<std::string> values =
+                SplitCsvLine(line);
+
+            if (values.size() != columns.size())
+            {
+                return Fail(csvPath + " is malformed");
+            }
+
+            Pose pose;
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                pose.FrameToOrigin[i] = strtof(values[frameToOriginColumn + i].c_str(), nullptr);
+                pose.CameraViewTransform[i] = strtof(values[cameraViewTransformColumn + i].c_str(), nullptr);
+            }
+
+            //
+            // The recorder writes zeros for the frames it couldn't locate.
+            //
+            if (0.0f == pose.FrameToOrigin[15])
+            {
+                continue;
+            }
+
+            _poses[strtoull(values[0].c_str(), nullptr, 10)] = pose;
+        }
+
+        return true;
+    }
+
+    bool RecordingReader::ParseBitmap(
+        RecordedFrame* frame) const
+    {
+        //
+        // "P5\n<width> <height>\n<maximum value>\n", then the pixels. Unlike
+        // the Netpbm format, 16-bit pixels are stored little endian, as they
+        // are in memory.
+        //
+        const uint8_t* data = _buffer.data();
+        const size_t size = _buffer.size();
+
+        if (size < 2 || 'P' != data[0] || '5' != data[1])
+        {
+            return false;
+        }
+
+        size_t offset = 2;
+        uint32_t maximumValue = 0;
+
+        if (!ParseBitmapNumber(data, size, &offset, &frame->ImageWidth) ||
+            !ParseBitmapNumber(data, size, &offset, &frame->ImageHeight) ||
+            !ParseBitmapNumber(data, size, &offset, &maximumValue) ||
+            0 == frame->ImageHeight)
+        {
+            return false;
+        }
+
+        // A single whitespace character separates the header from the pixels.
+        ++offset;
+
+        frame->BytesPerPixel = (maximumValue > 255) ? 2 : 1;
+        frame->RowStride = (size - offset) / frame->ImageHeight;
+        frame->Pixels = data + offset;
+
+        return frame->RowStride >= static_cast<size_t>(frame->ImageWidth) * frame->BytesPerPixel;
+    }
+
+    bool RecordingReader::Fail(
+        const std::string& error)
+    {
+        _error = error;
+
+        return false;
+    }
+
+    bool LoadCameraSpaceProjection(
+        const std::string& recordingFolder,
+        const std::string& sensorName,
+        uint32_t imageWidth,
+        uint32_t imageHeight,
+        Io::UnprojectionLut* lut,
+        std::string* error)
+    {
+        const std::string path =
+            recordingFolder + "/" + sensorName + "_camera_space_projection.bin";
+
+        // The centers of the last column and row are extrapolated.
+        if (imageWidth < 2 || imageHeight < 2)
+        {
+            *error = "the frames of " + sensorName + " must be at least 2x2 pixels";
+
+            return false;
+        }
+
+        FILE* file =
+            fopen(path.c_str(), "rb");
+
+        if (nullptr == file)
+        {
+            *error = "failed to open " + path + ": " + strerror(errno);
+
+            return false;
+        }
+
+        //
+        // Read one more point than expected, to reject files of another size.
+        //
+        const size_t pointCount =
+            static_cast<size_t>(imageWidth) * imageHeight;
+
+        std::vector<float> cameraSpaceProjection(
+            2 * (pointCount + 1));
+
+        const size_t pointsRead =
+            fread(cameraSpaceProjection.data(), 2 * sizeof(float), pointCount + 1, file);
+
+        fclose(file);
+
+        if (pointsRead != pointCount)
+        {
+            *error = path + " isn't the projection of a " +
+                std::to_string(imageWidth) + "x" + std::to_string(imageHeight) + " camera";
+
+            return false;
+        }
+
+        lut->AssignCameraSpaceProjection(
+            imageWidth,
+            imageHeight,
+            cameraSpaceProjection.data());
+
+        return true;
+    }
+}
@@ -0,0 +1,136 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include <Io/UnprojectionLut.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SensorStream
+{
+    //
+    // A frame of a recording and its pose. The pixels are only valid until the
+    // next frame is read.
+    //
+    struct RecordedFrame
+    {
+        uint64_t Timestamp;
+
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+
+        //
+        // 2 for Gray16 frames, which are little endian. The pixels follow the
+        // PGM header, and may not be aligned.
+        //
+        uint32_t BytesPerPixel;
+        size_t RowStride;
+        const uint8_t* Pixels;
+
+        //
+        // Row major, transforming row vectors, like
+        // Windows::Foundation::Numerics::float4x4.
+        //
+        float FrameToOrigin[16];
+        float CameraViewTransform[16];
+    };
+
+    //
+    // Reads the frames of a sensor from a recording of HoloLensForCV's
+    // SensorFrameRecorder, as downloaded from the HoloLens: the <sensor>.tar
+    // tarball of the frames' PGM files, and the <sensor>.csv file of their
+    // poses.
+    //
+    // The tarball is read sequentially, so that recordings much larger than the
+    // memory can be streamed. Frames stored with a compression codec, and
+    // frames without a pose, are skipped.
+    //
+    class RecordingReader
+    {
+    public:
+        RecordingReader();
+        ~RecordingReader();
+
+        RecordingReader(const RecordingReader&) = delete;
+        RecordingReader& operator=(const RecordingReader&) = delete;
+
+        bool Open(
+            const std::string& recordingFolder,
+            const std::string& sensorName);
+
+        //
+        // Reads the next frame, in the order they were recorded. Returns false at
+        // the end of the recording, or on error; see GetError.
+        //
+        bool ReadFrame(
+            RecordedFrame* frame);
+
+        const std::string& GetError() const
+        {
+            return _error;
+        }
+
+        uint64_t GetSkippedFrameCount() const
+        {
+            return _skippedFrameCount;
+        }
+
+    private:
+        struct Pose
+        {
+            float FrameToOrigin[16];
+            float CameraViewTransform[16];
+        };
+
+        bool ReadPoses(
+            const std::string& csvPath);
+
+        //
+        // Parses the PGM file read into the buffer. Returns false if it isn't
+        // one.
+        //
+        bool ParseBitmap(
+            RecordedFrame* frame) const;
+
+        bool Fail(
+            const std::string& error);
+
+    private:
+        FILE* _tarball;
+        std::string _error;
+
+        std::unordered_map<uint64_t, Pose> _poses;
+
+        std::vector<uint8_t> _buffer;
+        uint64_t _skippedFrameCount;
+    };
+
+    //
+    // Loads the unprojection LUT of a sensor from the
+    // <sensor>_camera_space_projection.bin file of a recording (see
+    // Io::SampleCameraSpaceProjection), whose frames are imageWidth x
+    // imageHeight pixels.
+    //
+    bool LoadCameraSpaceProjection(
+        const std::string& recordingFolder,
+        const std::string& sensorName,
+        uint32_t imageWidth,
+        uint32_t imageHeight,
+        Io::UnprojectionLut* lut,
+        std::string* error);
+}
@@ -0,0 +1,186 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "SensorStreamProtocol.h"
+
+namespace SensorStream
+{
+    namespace
+    {
+        template <typename T>
+        T ReadLittleEndian(
+            const uint8_t* data)
+        {
+            T value = 0;
+
+            for (size_t i = 0; i < sizeof(T); ++i)
+            {
+                value |= static_cast<T>(data[i]) << (8 * i);
+            }
+
+            return value;
+        }
+
+        template <typename T>
+        uint8_t* WriteLittleEndian(
+            T value,
+            uint8_t* data)
+        {
+            for (size_t i = 0; i < sizeof(T); ++i)
+            {
+                data[i] = static_cast<uint8_t>(value >> (8 * i));
+            }
+
+            return data + sizeof(T);
+        }
+    }
+
+    size_t GetExtendedHeaderLength(
+        uint8_t versionMinor)
+    {
+        size_t extendedHeaderLength = 0;
+
+        if (versionMinor >= ProtocolVersionMinorWithoutCompression)
+        {
+            extendedHeaderLength +=
+                sizeof(uint32_t) /* ExtensionsLength */;
+        }
+
+        if (versionMinor >= ProtocolVersionMinor)
+        {
+            extendedHeaderLength +=
+                sizeof(uint16_t) /* Codec */ +
+                sizeof(uint32_t) /* PayloadLength */;
+        }
+
+        return extendedHeaderLength;
+    }
+
+    bool ParseHeader(
+        const uint8_t* data,
+        FrameHeader* header)
+    {
+        header->Cookie = ReadLittleEndian<uint32_t>(data);
+        header->VersionMajor = data[4];
+        header->VersionMinor = data[5];
+        header->FrameType = ReadLittleEndian<uint16_t>(data + 6);
+        header->Timestamp = ReadLittleEndian<uint64_t>(data + 8);
+        header->ImageWidth = ReadLittleEndian<uint32_t>(data + 16);
+        header->ImageHeight = ReadLittleEndian<uint32_t>(data + 20);
+        header->PixelStride = ReadLittleEndian<uint32_t>(data + 24);
+        header->RowStride = ReadLittleEndian<uint32_t>(data + 28);
+
+        header->ExtensionsLength = 0;
+        header->PayloadCodec = Codec::Raw;
+        header->PayloadLength = 0;
+
+        if (ProtocolCookie != header->Cookie ||
+            ProtocolVersionMajor != header->VersionMajor ||
+            header->VersionMinor < ProtocolVersionMinorWithoutExtensions ||
+            header->VersionMinor > ProtocolVersionMinor)
+        {
+            return false;
+        }
+
+        const uint64_t imageSize =
+            static_cast<uint64_t>(header->ImageHeight) * header->RowStride;
+
+        if (imageSize > UINT32_MAX)
+        {
+            return false;
+        }
+
+        header->PayloadLength =
+            static_cast<uint32_t>(imageSize);
+
+        return true;
+    }
+
+    bool ParseExtendedFields(
+        const uint8_t* data,
+        FrameHeader* header)
+    {
+        const uint32_t imageSize =
+            header->ImageHeight * header->RowStride;
+
+        if (header->VersionMinor >= ProtocolVersionMinorWithoutCompression)
+        {
+            header->ExtensionsLength = ReadLittleEndian<uint32_t>(data);
+            data += sizeof(uint32_t);
+
+            if (header->ExtensionsLength > ProtocolMaximumExtensionsLength)
+            {
+                return false;
+            }
+        }
+
+        if (header->VersionMinor >= ProtocolVersionMinor)
+        {
+            header->PayloadCodec = static_cast<Codec>(ReadLittleEndian<uint16_t>(data));
+            header->PayloadLength = ReadLittleEndian<uint32_t>(data + sizeof(uint16_t));
+
+            //
+            // Servers only compress frames that shrink, but for the keyframes of
+            // the Delta codec.
+            //
+            if (Codec::Raw == header->PayloadCodec)
+            {
+                return imageSize == header->PayloadLength;
+            }
+
+            if (Codec::Delta == header->PayloadCodec)
+            {
+                return
+                    ProtocolDeltaHeaderLength <= header->PayloadLength &&
+                    header->PayloadLength <= imageSize + ProtocolDeltaHeaderLength;
+            }
+
+            return
+                header->PayloadCodec <= Codec::Jpeg &&
+                0 < header->PayloadLength &&
+                header->PayloadLength < imageSize;
+        }
+
+        return true;
+    }
+
+    size_t WriteHeader(
+        const FrameHeader& header,
+        uint8_t* data)
+    {
+        uint8_t* end = data;
+
+        end = WriteLittleEndian(header.Cookie, end);
+        end = WriteLittleEndian(header.VersionMajor, end);
+        end = WriteLittleEndian(header.VersionMinor, end);
+        end = WriteLittleEndian(header.FrameType, end);
+        end = WriteLittleEndian(header.Timestamp, end);
+        end = WriteLittleEndian(header.ImageWidth, end);
+        end = WriteLittleEndian(header.ImageHeight, end);
+        end = WriteLittleEndian(header.PixelStride, end);
+        end = WriteLittleEndian(header.RowStride, end);
+
+        if (header.VersionMinor >= ProtocolVersionMinorWithoutCompression)
+        {
+            end = WriteLittleEndian(header.ExtensionsLength, end);
+        }
+
+        if (header.VersionMinor >= ProtocolVersionMinor)
+        {
+            end = WriteLittleEndian(static_cast<uint16_t>(header.PayloadCodec), end);
+            end = WriteLittleEndian(header.PayloadLength, end);
+        }
+
+        return static_cast<size_t>(end - data);
+    }
+}
@@ -0,0 +1,111 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SensorStream
+{
+    //
+    // Sensor frame stream protocol, as sent by HoloLensForCV's streaming servers
+    // (see Shared/HoloLensForCV/SensorFrameStreamHeader.h). All fields are little
+    // endian.
+    //
+    // Version 0.1 headers are directly followed by the image. Version 0.2 adds a
+    // uint32_t ExtensionsLength and an extension block of that many bytes before
+    // the image; version 0.3 adds a uint16_t Codec and a uint32_t PayloadLength
+    // after the ExtensionsLength, the image being PayloadLength bytes long.
+    //
+    const uint32_t ProtocolCookie = 0x484c524d;
+    const uint8_t ProtocolVersionMajor = 0x00;
+    const uint8_t ProtocolVersionMinor = 0x03;
+    const uint8_t ProtocolVersionMinorWithoutExtensions = 0x01;
+    const uint8_t ProtocolVersionMinorWithoutCompression = 0x02;
+
+    const size_t ProtocolHeaderLength = 32;
+    const size_t ProtocolMaximumExtendedHeaderLength = 10;
+
+    // Matches Io::FrameHeaderExtensionsMaximumLength.
+    const uint32_t ProtocolMaximumExtensionsLength = 32 * 1024 * 1024;
+
+    enum class Codec : uint16_t
+    {
+        Raw = 0,
+        Lz4 = 1,
+        Depth = 2,
+        Jpeg = 3,
+        Delta = 4
+    };
+
+    //
+    // Delta payloads start with a header of a uint8_t Flags (bit 0 set for
+    // keyframes), a uint8_t KeyframeCodec (Raw, Lz4 or Depth) and a uint8_t
+    // BytesPerSample (1 or 2, for the other frames), then a reserved byte.
+    // Keyframes follow it compressed with KeyframeCodec; other frames follow
+    // it as the Io::DeltaCompress differences to the previous frame.
+    //
+    const size_t ProtocolDeltaHeaderLength = 4;
+
+    struct FrameHeader
+    {
+        uint32_t Cookie;
+        uint8_t VersionMajor;
+        uint8_t VersionMinor;
+        uint16_t FrameType;
+        uint64_t Timestamp;
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+        uint32_t PixelStride;
+        uint32_t RowStride;
+
+        // Zero for version 0.1 headers.
+        uint32_t ExtensionsLength;
+
+        // Raw and ImageHeight * RowStride for version 0.1 and 0.2 headers.
+        Codec PayloadCodec;
+        uint32_t PayloadLength;
+    };
+
+    //
+    // Length of the fields following the first ProtocolHeaderLength bytes of a
+    // header of the given version.
+    //
+    size_t GetExtendedHeaderLength(
+        uint8_t versionMinor);
+
+    //
+    // Parses the first ProtocolHeaderLength bytes of a header. Returns false if the
+    // cookie or the version is not supported.
+    //
+    bool ParseHeader(
+        const uint8_t* data,
+        FrameHeader* header);
+
+    //
+    // Parses the GetExtendedHeaderLength(header->VersionMinor) bytes that follow.
+    // Returns false if the lengths they announce are inconsistent with the image.
+    //
+    bool ParseExtendedFields(
+        const uint8_t* data,
+        FrameHeader* header);
+
+    //
+    // Writes the header with the fields of its version, returning the number of
+    // bytes written (at most ProtocolHeaderLength + ProtocolMaximumExtendedHeaderLength).
+    //
+    size_t WriteHeader(
+        const FrameHeader& header,
+        uint8_t* data);
+}
@@ -0,0 +1,462 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "SensorStreamReceiver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace SensorStream
+{
+    namespace
+    {
+        //
+        // Reads smaller than half the buffer go through it, so that a header and
+        // its extended fields usually take a single call to recv; larger reads go
+        // straight to their destination.
+        //
+        const size_t c_readBufferSize = 64 * 1024;
+
+        const int c_receiveBufferSize = 8 * 1024 * 1024;
+    }
+
+    SensorStreamReceiver::SensorStreamReceiver(
+        FrameBufferPool& pool)
+        : _pool(pool)
+        , _socket(-1)
+        , _closing(false)
+        , _readBuffer(new uint8_t[c_readBufferSize])
+        , _readBegin(0)
+        , _readEnd(0)
+        , _framesReceived(0)
+        , _framesDropped(0)
+        , _framesTooLarge(0)
+        , _framesNotQueued(0)
+        , _bytesReceived(0)
+    {
+    }
+
+    SensorStreamReceiver::~SensorStreamReceiver()
+    {
+        const int socket =
+            _socket.exchange(-1);
+
+        if (socket >= 0)
+        {
+            close(socket);
+        }
+    }
+
+    bool SensorStreamReceiver::Connect(
+        const char* host,
+        uint16_t port)
+    {
+        addrinfo hints = {};
+
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addresses = nullptr;
+
+        const int result =
+            getaddrinfo(host, std::to_string(port).c_str(), &hints, &addresses);
+
+        if (0 != result)
+        {
+            _error = gai_strerror(result);
+
+            return false;
+        }
+
+        int connectedSocket = -1;
+
+        for (addrinfo* address = addresses; nullptr != address; address = address->ai_next)
+        {
+            const int candidate =
+                socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+
+            if (candidate < 0)
+            {
+                continue;
+            }
+
+            if (0 == connect(candidate, address->ai_addr, address->ai_addrlen))
+            {
+                connectedSocket = candidate;
+                break;
+            }
+
+            _error = strerror(errno);
+
+            close(candidate);
+        }
+
+        freeaddrinfo(addresses);
+
+        if (connectedSocket < 0)
+        {
+            return false;
+        }
+
+        Attach(
+            connectedSocket);
+
+        return true;
+    }
+
+    void SensorStreamReceiver::Attach(
+        int socket)
+    {
+        //
+        // Large frames arrive in bursts; give the kernel room to buffer one
+        // while the previous one is being handed over.
+        //
+        setsockopt(
+            socket,
+            SOL_SOCKET,
+            SO_RCVBUF,
+            &c_receiveBufferSize,
+            sizeof(c_receiveBufferSize));
+
+        const int previousSocket =
+            _socket.exchange(socket);
+
+        if (previousSocket >= 0)
+        {
+            close(previousSocket);
+        }
+
+        _closing = false;
+        _error.clear();
+        _readBegin = 0;
+        _readEnd = 0;
+    }
+
+    FramePtr SensorStreamReceiver::ReceiveFrame()
+    {
+        uint8_t headerData[ProtocolHeaderLength + ProtocolMaximumExtendedHeaderLength];
+
+        for (;;)
+        {
+            FrameHeader header;
+
+            ReadStatus status =
+                ReadExactly(headerData, ProtocolHeaderLength);
+
+            if (ReadStatus::Succeeded != status)
+            {
+                Fail(status, "failed to receive the frame header");
+
+                return FramePtr();
+            }
+
+            if (!ParseHeader(headerData, &header))
+            {
+                Fail(ReadStatus::Succeeded, "unsupported frame header cookie or version");
+
+                return FramePtr();
+            }
+
+            const size_t extendedHeaderLength =
+                GetExtendedHeaderLength(header.VersionMinor);
+
+            status = ReadExactly(
+                headerData + ProtocolHeaderLength,
+                extendedHeaderLength);
+
+            if (ReadStatus::Succeeded != status)
+            {
+                Fail(status, "failed to receive the frame header");
+
+                return FramePtr();
+            }
+
+            if (!ParseExtendedFields(headerData + ProtocolHeaderLength, &header))
+            {
+                Fail(ReadStatus::Succeeded, "inconsistent extension or payload length");
+
+                return FramePtr();
+            }
+
+            FramePtr frame;
+
+            if (header.PayloadLength <= _pool.GetPayloadCapacity())
+            {
+                frame = _pool.TryAcquire();
+
+                if (nullptr == frame)
+                {
+                    ++_framesDropped;
+                }
+            }
+            else
+            {
+                ++_framesTooLarge;
+            }
+
+            const uint64_t frameSize =
+                ProtocolHeaderLength + extendedHeaderLength +
+                header.ExtensionsLength + header.PayloadLength;
+
+            if (nullptr == frame)
+            {
+                status = Skip(
+                    static_cast<size_t>(header.ExtensionsLength) + header.PayloadLength);
+
+                if (ReadStatus::Succeeded != status)
+                {
+                    Fail(status, "failed to receive the frame");
+
+                    return FramePtr();
+                }
+
+                _bytesReceived += frameSize;
+
+                continue;
+            }
+
+            //
+            // The extension storage of a pooled frame only grows, so that it stops
+            // allocating after the first few frames.
+            //
+            if (frame->_extensionsStorage.size() < header.ExtensionsLength)
+            {
+                frame->_extensionsStorage.resize(
+                    header.ExtensionsLength);
+            }
+
+            frame->Header = header;
+            frame->Extensions = frame->_extensionsStorage.data();
+
+            status = ReadExactly(
+                frame->_extensionsStorage.data(),
+                header.ExtensionsLength);
+
+            if (ReadStatus::Succeeded == status)
+            {
+                status = ReadExactly(
+                    frame->Payload,
+                    header.PayloadLength);
+            }
+
+            if (ReadStatus::Succeeded != status)
+            {
+                Fail(status, "failed to receive the frame");
+
+                return FramePtr();
+            }
+
+            ++_framesReceived;
+            _bytesReceived += frameSize;
+
+            return frame;
+        }
+    }
+
+    void SensorStreamReceiver::Run(
+        const std::function<void(FramePtr)>& onFrame)
+    {
+        for (;;)
+        {
+            FramePtr frame = ReceiveFrame();
+
+            if (nullptr == frame)
+            {
+                return;
+            }
+
+            onFrame(
+                std::move(frame));
+        }
+    }
+
+    void SensorStreamReceiver::Run(
+        FrameQueue& queue)
+    {
+        for (;;)
+        {
+            FramePtr frame = ReceiveFrame();
+
+            if (nullptr == frame)
+            {
+                return;
+            }
+
+            if (!queue.TryPush(frame))
+            {
+                ++_framesNotQueued;
+            }
+        }
+    }
+
+    void SensorStreamReceiver::Close()
+    {
+        _closing = true;
+
+        const int socket =
+            _socket.load();
+
+        if (socket >= 0)
+        {
+            shutdown(
+                socket,
+                SHUT_RDWR);
+        }
+    }
+
+    ReceiverStatistics SensorStreamReceiver::GetStatistics() const
+    {
+        ReceiverStatistics statistics;
+
+        statistics.FramesReceived = _framesReceived;
+        statistics.FramesDropped = _framesDropped;
+        statistics.FramesTooLarge = _framesTooLarge;
+        statistics.FramesNotQueued = _framesNotQueued;
+        statistics.BytesReceived = _bytesReceived;
+
+        return statistics;
+    }
+
+    SensorStreamReceiver::ReadStatus SensorStreamReceiver::ReadExactly(
+        uint8_t* data,
+        size_t size)
+    {
+        while (size > 0)
+        {
+            if (_readBegin == _readEnd)
+            {
+                if (size >= c_readBufferSize / 2)
+                {
+                    const ssize_t bytesRead =
+                        recv(_socket.load(), data, size, MSG_WAITALL);
+
+                    if (bytesRead <= 0)
+                    {
+                        if (bytesRead < 0 && EINTR == errno)
+                        {
+                            continue;
+                        }
+
+                        return (0 == bytesRead) ? ReadStatus::Closed : ReadStatus::Failed;
+                    }
+
+                    data += bytesRead;
+                    size -= static_cast<size_t>(bytesRead);
+
+                    continue;
+                }
+
+                const ReadStatus status =
+                    Fill();
+
+                if (ReadStatus::Succeeded != status)
+                {
+                    return status;
+                }
+            }
+
+            const size_t bytesCopied =
+                std::min(size, _readEnd - _readBegin);
+
+            memcpy(
+                data,
+                _readBuffer.get() + _readBegin,
+                bytesCopied);
+
+            _readBegin += bytesCopied;
+            data += bytesCopied;
+            size -= bytesCopied;
+        }
+
+        return ReadStatus::Succeeded;
+    }
+
+    SensorStreamReceiver::ReadStatus SensorStreamReceiver::Skip(
+        size_t size)
+    {
+        while (size > 0)
+        {
+            if (_readBegin == _readEnd)
+            {
+                const ReadStatus status =
+                    Fill();
+
+                if (ReadStatus::Succeeded != status)
+                {
+                    return status;
+                }
+            }
+
+            const size_t bytesSkipped =
+                std::min(size, _readEnd - _readBegin);
+
+            _readBegin += bytesSkipped;
+            size -= bytesSkipped;
+        }
+
+        return ReadStatus::Succeeded;
+    }
+
+    SensorStreamReceiver::ReadStatus SensorStreamReceiver::Fill()
+    {
+        for (;;)
+        {
+            const ssize_t bytesRead =
+                recv(_socket.load(), _readBuffer.get(), c_readBufferSize, 0);
+
+            if (bytesRead > 0)
+            {
+                _readBegin = 0;
+                _readEnd = static_cast<size_t>(bytesRead);
+
+                return ReadStatus::Succeeded;
+            }
+
+            if (bytesRead < 0 && EINTR == errno)
+            {
+                continue;
+            }
+
+            return (0 == bytesRead) ? ReadStatus::Closed : ReadStatus::Failed;
+        }
+    }
+
+    void SensorStreamReceiver::Fail(
+        ReadStatus status,
+        const char* error)
+    {
+        if (_closing)
+        {
+            _error = "closed";
+        }
+        else if (ReadStatus::Closed == status)
+        {
+            _error = "connection closed by the server";
+        }
+        else if (ReadStatus::Failed == status)
+        {
+            _error = std::string(error) + ": " + strerror(errno);
+        }
+        else
+        {
+            _error = error;
+        }
+    }
+}
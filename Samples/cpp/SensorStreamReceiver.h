@@ -0,0 +1,141 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include "FrameQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace SensorStream
+{
+    struct ReceiverStatistics
+    {
+        uint64_t FramesReceived;
+
+        // Frames skipped because no pooled frame was free, or because their
+        // payload didn't fit in one.
+        uint64_t FramesDropped;
+        uint64_t FramesTooLarge;
+
+        // Frames received but not handed over because the queue was full.
+        uint64_t FramesNotQueued;
+
+        uint64_t BytesReceived;
+    };
+
+    //
+    // Receives the frames of one sensor stream connection into the frames of a
+    // pool. Doesn't allocate once connected: headers are parsed from a reusable
+    // read buffer, and payloads are received straight into the pooled frames.
+    //
+    // Compressed payloads are delivered undecoded. Delta frames only decode
+    // against the frame before them, so a client of a Delta stream must wait
+    // for the next keyframe after a frame was dropped.
+    //
+    class SensorStreamReceiver
+    {
+    public:
+        explicit SensorStreamReceiver(
+            FrameBufferPool& pool);
+
+        ~SensorStreamReceiver();
+
+        SensorStreamReceiver(const SensorStreamReceiver&) = delete;
+        SensorStreamReceiver& operator=(const SensorStreamReceiver&) = delete;
+
+        bool Connect(
+            const char* host,
+            uint16_t port);
+
+        //
+        // Takes ownership of a connected socket.
+        //
+        void Attach(
+            int socket);
+
+        //
+        // Blocks until the next frame has been received. Returns nullptr once
+        // the connection is closed or the stream is malformed; see GetError.
+        //
+        FramePtr ReceiveFrame();
+
+        //
+        // Receives frames until the connection is closed, handing them to the
+        // callback, or to the queue if it has room.
+        //
+        void Run(
+            const std::function<void(FramePtr)>& onFrame);
+
+        void Run(
+            FrameQueue& queue);
+
+        //
+        // Closes the connection, unblocking ReceiveFrame and Run. May be called
+        // from any thread.
+        //
+        void Close();
+
+        ReceiverStatistics GetStatistics() const;
+
+        const std::string& GetError() const
+        {
+            return _error;
+        }
+
+    private:
+        enum class ReadStatus
+        {
+            Succeeded,
+            Closed,
+            Failed
+        };
+
+        ReadStatus ReadExactly(
+            uint8_t* data,
+            size_t size);
+
+        ReadStatus Skip(
+            size_t size);
+
+        ReadStatus Fill();
+
+        //
+        // Records why the stream ended; status is Succeeded for malformed frames.
+        //
+        void Fail(
+            ReadStatus status,
+            const char* error);
+
+    private:
+        FrameBufferPool& _pool;
+
+        std::atomic<int> _socket;
+        std::atomic<bool> _closing;
+        std::string _error;
+
+        std::unique_ptr<uint8_t[]> _readBuffer;
+        size_t _readBegin;
+        size_t _readEnd;
+
+        std::atomic<uint64_t> _framesReceived;
+        std::atomic<uint64_t> _framesDropped;
+        std::atomic<uint64_t> _framesTooLarge;
+        std::atomic<uint64_t> _framesNotQueued;
+        std::atomic<uint64_t> _bytesReceived;
+    };
+}
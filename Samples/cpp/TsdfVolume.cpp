@@ -0,0 +1,963 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "TsdfVolume.h"
+
+#include "MarchingCubes.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SENSOR_STREAM_TSDF_X86 1
+#include <immintrin.h>
+#endif
+
+namespace SensorStream
+{
+    namespace
+    {
+        // Rows of sampled pixels per chunk when allocating blocks.
+        const size_t c_allocationRowsPerChunk = 8;
+
+        // Block keys cached by each chunk to skip the repeated ones.
+        const size_t c_recentBlockKeyCount = 256;
+
+        // Blocks per chunk when updating and meshing blocks.
+        const size_t c_blocksPerChunk = 16;
+
+        //
+        // Cells of the projection grid per pixel of the LUT's center, along
+        // each axis.
+        //
+        const float c_projectionGridCellsPerPixel = 2.0f;
+
+        const int32_t c_blockCoordinateBias = 1 << 20;
+
+        bool IsInTriangle(
+            float x,
+            float y,
+            const float* a,
+            const float* b,
+            const float* c)
+        {
+            const float ab = (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+            const float bc = (c[0] - b[0]) * (y - b[1]) - (c[1] - b[1]) * (x - b[0]);
+            const float ca = (a[0] - c[0]) * (y - c[1]) - (a[1] - c[1]) * (x - c[0]);
+
+            return (ab >= 0.0f && bc >= 0.0f && ca >= 0.0f) ||
+                (ab <= 0.0f && bc <= 0.0f && ca <= 0.0f);
+        }
+
+        //
+        // What the voxel updates need to know about a frame.
+        //
+        struct IntegrationParameters
+        {
+            // Zero where invalid.
+            const float* DepthInMeters;
+
+            const int32_t* ProjectionGrid;
+            uint32_t ProjectionGridWidth;
+            uint32_t ProjectionGridHeight;
+            float ProjectionGridOrigin[2];
+            float ProjectionGridScale;
+
+            float TruncationDistance;
+            float MaximumWeight;
+            bool DepthIsRadial;
+        };
+
+        //
+        // Updates a row of TsdfVolume::BlockSize voxels, the first of which is
+        // at the given camera coordinates, each next one a step further.
+        //
+        typedef void (*IntegrateRowFunction)(
+            const IntegrationParameters& parameters,
+            const float* camera,
+            const float* step,
+            float* distances,
+            float* weights);
+
+        void IntegrateRowScalar(
+            const IntegrationParameters& p,
+            const float* firstCamera,
+            const float* step,
+            float* distances,
+            float* weights)
+        {
+            const float inverseTruncationDistance = 1.0f / p.TruncationDistance;
+
+            for (int32_t x = 0; x < TsdfVolume::BlockSize; ++x)
+            {
+                float camera[3];
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    camera[k] = firstCamera[k] + x * step[k];
+                }
+
+                if (camera[2] <= 0.0f)
+                {
+                    continue;
+                }
+
+                const float inverseZ = 1.0f / camera[2];
+                const float column = (camera[0] * inverseZ - p.ProjectionGridOrigin[0]) * p.ProjectionGridScale;
+                const float row = (camera[1] * inverseZ - p.ProjectionGridOrigin[1]) * p.ProjectionGridScale;
+
+                if (!(column >= 0.0f && column < p.ProjectionGridWidth &&
+                      row >= 0.0f && row < p.ProjectionGridHeight))
+                {
+                    continue;
+                }
+
+                const int32_t pixel = p.ProjectionGrid[
+                    static_cast<size_t>(row) * p.ProjectionGridWidth + static_cast<size_t>(column)];
+
+                if (pixel < 0)
+                {
+                    continue;
+                }
+
+                const float measuredDepth = p.DepthInMeters[pixel];
+
+                const float voxelDepth = p.DepthIsRadial ?
+                    std::sqrt(camera[0] * camera[0] + camera[1] * camera[1] + camera[2] * camera[2]) :
+                    camera[2];
+
+                const float distance = measuredDepth - voxelDepth;
+
+                if (!(measuredDepth > 0.0f) || distance < -p.TruncationDistance)
+                {
+                    continue;
+                }
+
+                const float truncatedDistance =
+                    std::min(distance * inverseTruncationDistance, 1.0f);
+
+                const float weight = weights[x];
+
+                distances[x] = (distances[x] * weight + truncatedDistance) / (weight + 1.0f);
+                weights[x] = std::min(weight + 1.0f, p.MaximumWeight);
+            }
+        }
+
+#if SENSOR_STREAM_TSDF_X86
+        //
+        // The same, a row at a time, gathering the pixels of the voxels.
+        //
+        __attribute__((target("avx2,fma")))
+        void IntegrateRowAvx2(
+            const IntegrationParameters& p,
+            const float* firstCamera,
+            const float* step,
+            float* distances,
+            float* weights)
+        {
+            static_assert(8 == TsdfVolume::BlockSize, "A row of voxels must fill a vector.");
+
+            const __m256 offsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+
+            const __m256 cameraX = _mm256_fmadd_ps(offsets, _mm256_set1_ps(step[0]), _mm256_set1_ps(firstCamera[0]));
+            const __m256 cameraY = _mm256_fmadd_ps(offsets, _mm256_set1_ps(step[1]), _mm256_set1_ps(firstCamera[1]));
+            const __m256 cameraZ = _mm256_fmadd_ps(offsets, _mm256_set1_ps(step[2]), _mm256_set1_ps(firstCamera[2]));
+
+            __m256 valid = _mm256_cmp_ps(cameraZ, zero, _CMP_GT_OQ);
+
+            if (0 == _mm256_movemask_ps(valid))
+            {
+                return;
+            }
+
+            const __m256 inverseZ = _mm256_div_ps(one, cameraZ);
+            const __m256 scale = _mm256_set1_ps(p.ProjectionGridScale);
+
+            const __m256 column = _mm256_mul_ps(
+                _mm256_fmsub_ps(cameraX, inverseZ, _mm256_set1_ps(p.ProjectionGridOrigin[0])), scale);
+
+            const __m256 row = _mm256_mul_ps(
+                _mm256_fmsub_ps(cameraY, inverseZ, _mm256_set1_ps(p.ProjectionGridOrigin[1])), scale);
+
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(column, zero, _CMP_GE_OQ));
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(column, _mm256_set1_ps(static_cast<float>(p.ProjectionGridWidth)), _CMP_LT_OQ));
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(row, zero, _CMP_GE_OQ));
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(row, _mm256_set1_ps(static_cast<float>(p.ProjectionGridHeight)), _CMP_LT_OQ));
+
+            if (0 == _mm256_movemask_ps(valid))
+            {
+                return;
+            }
+
+            const __m256i cell =
+                _mm256_add_epi32(
+                    _mm256_mullo_epi32(
+                        _mm256_cvttps_epi32(_mm256_and_ps(row, valid)),
+                        _mm256_set1_epi32(static_cast<int32_t>(p.ProjectionGridWidth))),
+                    _mm256_cvttps_epi32(_mm256_and_ps(column, valid)));
+
+            const __m256i pixel =
+                _mm256_mask_i32gather_epi32(
+                    _mm256_set1_epi32(-1),
+                    p.ProjectionGrid,
+                    cell,
+                    _mm256_castps_si256(valid),
+                    4);
+
+            valid = _mm256_and_ps(valid, _mm256_castsi256_ps(_mm256_cmpgt_epi32(pixel, _mm256_set1_epi32(-1))));
+
+            const __m256 measuredDepth =
+                _mm256_mask_i32gather_ps(
+                    zero,
+                    p.DepthInMeters,
+                    pixel,
+                    valid,
+                    4);
+
+            const __m256 voxelDepth = p.DepthIsRadial ?
+                _mm256_sqrt_ps(
+                    _mm256_fmadd_ps(cameraX, cameraX, _mm256_fmadd_ps(cameraY, cameraY, _mm256_mul_ps(cameraZ, cameraZ)))) :
+                cameraZ;
+
+            const __m256 distance =
+                _mm256_sub_ps(measuredDepth, voxelDepth);
+
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(measuredDepth, zero, _CMP_GT_OQ));
+            valid = _mm256_and_ps(valid, _mm256_cmp_ps(distance, _mm256_set1_ps(-p.TruncationDistance), _CMP_GE_OQ));
+
+            if (0 == _mm256_movemask_ps(valid))
+            {
+                return;
+            }
+
+            const __m256 truncatedDistance =
+                _mm256_min_ps(_mm256_mul_ps(distance, _mm256_set1_ps(1.0f / p.TruncationDistance)), one);
+
+            const __m256 weight = _mm256_loadu_ps(weights);
+            const __m256 nextWeight = _mm256_add_ps(weight, one);
+
+            const __m256 updatedDistance =
+                _mm256_div_ps(
+                    _mm256_fmadd_ps(_mm256_loadu_ps(distances), weight, truncatedDistance),
+                    nextWeight);
+
+            _mm256_storeu_ps(
+                distances,
+                _mm256_blendv_ps(_mm256_loadu_ps(distances), updatedDistance, valid));
+
+            _mm256_storeu_ps(
+                weights,
+                _mm256_blendv_ps(weight, _mm256_min_ps(nextWeight, _mm256_set1_ps(p.MaximumWeight)), valid));
+        }
+#endif /* SENSOR_STREAM_TSDF_X86 */
+
+        IntegrateRowFunction GetIntegrateRowFunction()
+        {
+#if SENSOR_STREAM_TSDF_X86
+            if (Io::PointCloudIsa::Avx2 == Io::GetPointCloudIsa())
+            {
+                return IntegrateRowAvx2;
+            }
+#endif
+
+            return IntegrateRowScalar;
+        }
+
+        //
+        // Updates the voxels of a block, a row at a time.
+        //
+        void IntegrateBlock(
+            const IntegrationParameters& parameters,
+            IntegrateRowFunction integrateRow,
+            const int32_t* blockCoordinates,
+            float voxelSize,
+            const float* originToCamera,
+            float* distances,
+            float* weights)
+        {
+            const int32_t blockSize = TsdfVolume::BlockSize;
+
+            const float originX = (blockCoordinates[0] * blockSize + 0.5f) * voxelSize;
+
+            float step[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                step[k] = voxelSize * originToCamera[k];
+            }
+
+            for (int32_t z = 0; z < blockSize; ++z)
+            {
+                const float originZ = (blockCoordinates[2] * blockSize + z + 0.5f) * voxelSize;
+
+                for (int32_t y = 0; y < blockSize; ++y)
+                {
+                    const float originY = (blockCoordinates[1] * blockSize + y + 0.5f) * voxelSize;
+
+                    float camera[3];
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        camera[k] =
+                            originX * originToCamera[k] +
+                            originY * originToCamera[4 + k] +
+                            originZ * originToCamera[8 + k] +
+                            originToCamera[12 + k];
+                    }
+
+                    const size_t firstVoxel =
+                        (z * blockSize + y) * blockSize;
+
+                    integrateRow(
+                        parameters,
+                        camera,
+                        step,
+                        distances + firstVoxel,
+                        weights + firstVoxel);
+                }
+            }
+        }
+    }
+
+    bool WritePlyFile(
+        const TriangleMesh& mesh,
+        const char* path,
+        std::string* error)
+    {
+        FILE* file =
+            fopen(path, "wb");
+
+        if (nullptr == file)
+        {
+            *error = std::string("failed to open ") + path + ": " + strerror(errno);
+
+            return false;
+        }
+
+        const size_t vertexCount = mesh.Vertices.size() / 3;
+        const size_t triangleCount = mesh.Triangles.size() / 3;
+
+        // Assumes a little endian host.
+        fprintf(
+            file,
+            "ply\n"
+            "format binary_little_endian 1.0\n"
+            "element vertex %zu\n"
+            "property float x\n"
+            "property float y\n"
+            "property float z\n"
+            "element face %zu\n"
+            "property list uchar uint vertex_indices\n"
+            "end_header\n",
+            vertexCount,
+            triangleCount);
+
+        bool isWritten =
+            fwrite(mesh.Vertices.data(), sizeof(float), mesh.Vertices.size(), file) == mesh.Vertices.size();
+
+        for (size_t i = 0; isWritten && i < triangleCount; ++i)
+        {
+            const uint8_t vertexCountOfFace = 3;
+
+            isWritten =
+                1 == fwrite(&vertexCountOfFace, 1, 1, file) &&
+                3 == fwrite(&mesh.Triangles[3 * i], sizeof(uint32_t), 3, file);
+        }
+
+        isWritten = (0 == fclose(file)) && isWritten;
+
+        if (!isWritten)
+        {
+            *error = std::string("failed to write ") + path;
+        }
+
+        return isWritten;
+    }
+
+    TsdfVolume::TsdfVolume(
+        const Io::UnprojectionLut& lut,
+        const TsdfOptions& options,
+        WorkerPool& workerPool)
+        : _lut(lut)
+        , _options(options)
+        , _workerPool(workerPool)
+        , _frameCount(0)
+        , _projectionGridWidth(0)
+        , _projectionGridHeight(0)
+        , _projectionGridOrigin()
+        , _projectionGridScale(0.0f)
+    {
+        BuildProjectionGrid();
+    }
+
+    void TsdfVolume::Integrate(
+        const uint16_t* depth,
+        size_t depthRowStride,
+        const float cameraToOrigin[16])
+    {
+        ++_frameCount;
+
+        _points.resize(
+            3 * static_cast<size_t>(_lut.GetImageWidth()) * _lut.GetImageHeight());
+
+        Io::UnprojectDepth(
+            _lut,
+            depth,
+            depthRowStride,
+            cameraToOrigin,
+            _options.Depth,
+            _points.data());
+
+        AllocateBlocks(
+            cameraToOrigin);
+
+        //
+        // Depths in meters, with the invalid ones zeroed, to be gathered by
+        // the voxel updates.
+        //
+        const uint32_t imageWidth = _lut.GetImageWidth();
+        const uint16_t minimumDepth = _options.Depth.MinimumDepth;
+        const uint16_t maximumDepth = _options.Depth.MaximumDepth;
+
+        _depthInMeters.resize(
+            static_cast<size_t>(imageWidth) * _lut.GetImageHeight());
+
+        for (uint32_t v = 0; v < _lut.GetImageHeight(); ++v)
+        {
+            const uint16_t* depthRow = reinterpret_cast<const uint16_t*>(
+                reinterpret_cast<const uint8_t*>(depth) + v * depthRowStride);
+
+            float* depthInMetersRow =
+                _depthInMeters.data() + static_cast<size_t>(v) * imageWidth;
+
+            for (uint32_t u = 0; u < imageWidth; ++u)
+            {
+                const uint16_t value = depthRow[u];
+
+                depthInMetersRow[u] = (value >= minimumDepth && value <= maximumDepth) ?
+                    value * _options.Depth.DepthScale : 0.0f;
+            }
+        }
+
+        IntegrationParameters parameters;
+
+        parameters.DepthInMeters = _depthInMeters.data();
+        parameters.ProjectionGrid = _projectionGrid.data();
+        parameters.ProjectionGridWidth = _projectionGridWidth;
+        parameters.ProjectionGridHeight = _projectionGridHeight;
+        parameters.ProjectionGridOrigin[0] = _projectionGridOrigin[0];
+        parameters.ProjectionGridOrigin[1] = _projectionGridOrigin[1];
+        parameters.ProjectionGridScale = _projectionGridScale;
+        parameters.TruncationDistance = _options.TruncationDistance;
+        parameters.MaximumWeight = _options.MaximumWeight;
+        parameters.DepthIsRadial = _options.Depth.DepthIsRadial;
+
+        const IntegrateRowFunction integrateRow =
+            GetIntegrateRowFunction();
+
+        float originToCamera[16];
+
+        Io::InvertRigidTransform(
+            cameraToOrigin,
+            originToCamera);
+
+        _workerPool.ParallelFor(
+            _frameBlocks.size(),
+            c_blocksPerChunk,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    Block& block = *_frameBlocks[i];
+
+                    IntegrateBlock(
+                        parameters,
+                        integrateRow,
+                        block.Coordinates,
+                        _options.VoxelSize,
+                        originToCamera,
+                        block.Distances,
+                        block.Weights);
+                }
+            });
+    }
+
+    void TsdfVolume::ExtractMesh(
+        TriangleMesh* mesh)
+    {
+        std::vector<TriangleMesh> chunkMeshes(
+            (_blocks.size() + c_blocksPerChunk - 1) / c_blocksPerChunk);
+
+        _workerPool.ParallelFor(
+            _blocks.size(),
+            c_blocksPerChunk,
+            [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    ExtractBlockMesh(
+                        _blocks[i],
+                        &chunkMeshes[begin / c_blocksPerChunk]);
+                }
+            });
+
+        mesh->Vertices.clear();
+        mesh->Triangles.clear();
+
+        for (const TriangleMesh& chunkMesh : chunkMeshes)
+        {
+            const uint32_t firstVertex =
+                static_cast<uint32_t>(mesh->Vertices.size() / 3);
+
+            mesh->Vertices.insert(
+                mesh->Vertices.end(),
+                chunkMesh.Vertices.begin(),
+                chunkMesh.Vertices.end());
+
+            for (uint32_t vertex : chunkMesh.Triangles)
+            {
+                mesh->Triangles.push_back(
+                    firstVertex + vertex);
+            }
+        }
+    }
+
+    uint64_t TsdfVolume::GetBlockKey(
+        int32_t x,
+        int32_t y,
+        int32_t z)
+    {
+        const uint64_t mask = (1ull << 21) - 1;
+
+        return
+            ((static_cast<uint64_t>(x + c_blockCoordinateBias) & mask) << 42) |
+            ((static_cast<uint64_t>(y + c_blockCoordinateBias) & mask) << 21) |
+            (static_cast<uint64_t>(z + c_blockCoordinateBias) & mask);
+    }
+
+    const TsdfVolume::Block* TsdfVolume::FindBlock(
+        int32_t x,
+        int32_t y,
+        int32_t z) const
+    {
+        const auto block =
+            _blockIndex.find(GetBlockKey(x, y, z));
+
+        return (_blockIndex.end() != block) ? block->second : nullptr;
+    }
+
+    void TsdfVolume::BuildProjectionGrid()
+    {
+        const uint32_t imageWidth = _lut.GetImageWidth();
+        const uint32_t imageHeight = _lut.GetImageHeight();
+        const float* x = _lut.GetX();
+        const float* y = _lut.GetY();
+
+        //
+        // Size the cells after the distance between the pixels at the center
+        // of the image, and cover the valid points of the LUT.
+        //
+        const size_t center =
+            static_cast<size_t>(imageHeight / 2) * imageWidth + imageWidth / 2;
+
+        const float pixelSize =
+            std::hypot(x[center + 1] - x[center], y[center + 1] - y[center]);
+
+        if (!(pixelSize > 0.0f))
+        {
+            return;
+        }
+
+        float minimum[2] = { INFINITY, INFINITY };
+        float maximum[2] = { -INFINITY, -INFINITY };
+
+        for (size_t i = 0; i < static_cast<size_t>(imageWidth) * imageHeight; ++i)
+        {
+            if (x[i] == x[i])
+            {
+                minimum[0] = std::min(minimum[0], x[i]);
+                minimum[1] = std::min(minimum[1], y[i]);
+                maximum[0] = std::max(maximum[0], x[i]);
+                maximum[1] = std::max(maximum[1], y[i]);
+            }
+        }
+
+        _projectionGridScale = c_projectionGridCellsPerPixel / pixelSize;
+        _projectionGridOrigin[0] = minimum[0];
+        _projectionGridOrigin[1] = minimum[1];
+        _projectionGridWidth = static_cast<uint32_t>((maximum[0] - minimum[0]) * _projectionGridScale) + 1;
+        _projectionGridHeight = static_cast<uint32_t>((maximum[1] - minimum[1]) * _projectionGridScale) + 1;
+
+        _projectionGrid.assign(
+            static_cast<size_t>(_projectionGridWidth) * _projectionGridHeight,
+            -1);
+
+        //
+        // Each cell whose center falls between the points of four neighboring
+        // pixels is covered by the nearest of them.
+        //
+        for (uint32_t v = 0; v + 1 < imageHeight; ++v)
+        {
+            for (uint32_t u = 0; u + 1 < imageWidth; ++u)
+            {
+                const size_t pixels[4] =
+                {
+                    static_cast<size_t>(v) * imageWidth + u,
+                    static_cast<size_t>(v) * imageWidth + u + 1,
+                    static_cast<size_t>(v + 1) * imageWidth + u + 1,
+                    static_cast<size_t>(v + 1) * imageWidth + u
+                };
+
+                float points[4][2];
+                float cellMinimum[2] = { INFINITY, INFINITY };
+                float cellMaximum[2] = { -INFINITY, -INFINITY };
+                bool isValid = true;
+
+                for (int corner = 0; corner < 4; ++corner)
+                {
+                    points[corner][0] = (x[pixels[corner]] - _projectionGridOrigin[0]) * _projectionGridScale;
+                    points[corner][1] = (y[pixels[corner]] - _projectionGridOrigin[1]) * _projectionGridScale;
+
+                    isValid = isValid && (points[corner][0] == points[corner][0]);
+
+                    for (int axis = 0; axis < 2; ++axis)
+                    {
+                        cellMinimum[axis] = std::min(cellMinimum[axis], points[corner][axis]);
+                        cellMaximum[axis] = std::max(cellMaximum[axis], points[corner][axis]);
+                    }
+                }
+
+                if (!isValid)
+                {
+                    continue;
+                }
+
+                const uint32_t firstColumn = static_cast<uint32_t>(std::max(std::ceil(cellMinimum[0] - 0.5f), 0.0f));
+                const uint32_t firstRow = static_cast<uint32_t>(std::max(std::ceil(cellMinimum[1] - 0.5f), 0.0f));
+
+                for (uint32_t row = firstRow; row < _projectionGridHeight && row + 0.5f <= cellMaximum[1]; ++row)
+                {
+                    for (uint32_t column = firstColumn; column < _projectionGridWidth && column + 0.5f <= cellMaximum[0]; ++column)
+                    {
+                        const float cellX = column + 0.5f;
+                        const float cellY = row + 0.5f;
+
+                        if (!IsInTriangle(cellX, cellY, points[0], points[1], points[2]) &&
+                            !IsInTriangle(cellX, cellY, points[0], points[2], points[3]))
+                        {
+                            continue;
+                        }
+
+                        int nearestCorner = 0;
+                        float nearestDistance = INFINITY;
+
+                        for (int corner = 0; corner < 4; ++corner)
+                        {
+                            const float distance =
+                                std::hypot(points[corner][0] - cellX, points[corner][1] - cellY);
+
+                            if (distance < nearestDistance)
+                            {
+                                nearestCorner = corner;
+                                nearestDistance = distance;
+                            }
+                        }
+
+                        _projectionGrid[static_cast<size_t>(row) * _projectionGridWidth + column] =
+                            static_cast<int32_t>(pixels[nearestCorner]);
+                    }
+                }
+            }
+        }
+    }
+
+    void TsdfVolume::AllocateBlocks(
+        const float cameraToOrigin[16])
+    {
+        const uint32_t imageWidth = _lut.GetImageWidth();
+        const uint32_t stride = std::max<uint32_t>(_options.AllocationStride, 1);
+        const size_t sampledRowCount = (_lut.GetImageHeight() + stride - 1) / stride;
+
+        const float blockEdge = _options.VoxelSize * BlockSize;
+        const float inverseBlockEdge = 1.0f / blockEdge;
+
+        //
+        // Sample the band around each point along its ray at least twice per
+        // block, so as not to skip a block.
+        //
+        const int32_t sampleCount =
+            static_cast<int32_t>(std::ceil(4.0f * _options.TruncationDistance / blockEdge)) + 1;
+
+        const float sampleStep =
+            2.0f * _options.TruncationDistance / std::max(sampleCount - 1, 1);
+
+        const float* cameraCenter =
+            cameraToOrigin + 12;
+
+        _blockKeys.resize(
+            (sampledRowCount + c_allocationRowsPerChunk - 1) / c_allocationRowsPerChunk);
+
+        _workerPool.ParallelFor(
+            sampledRowCount,
+            c_allocationRowsPerChunk,
+            [&](size_t begin, size_t end)
+            {
+                std::vector<uint64_t>& keys =
+                    _blockKeys[begin / c_allocationRowsPerChunk];
+
+                keys.clear();
+
+                //
+                // Neighboring points mostly fall in the same blocks: skip the
+                // keys found in a small cache of the recent ones.
+                //
+                uint64_t recentKeys[c_recentBlockKeyCount];
+
+                std::fill_n(recentKeys, c_recentBlockKeyCount, ~0ull);
+
+                for (size_t sampledRow = begin; sampledRow < end; ++sampledRow)
+                {
+                    const float* rowPoints =
+                        _points.data() + 3 * sampledRow * stride * imageWidth;
+
+                    for (uint32_t u = 0; u < imageWidth; u += stride)
+                    {
+                        const float* point = rowPoints + 3 * u;
+
+                        if (point[0] != point[0])
+                        {
+                            continue;
+                        }
+
+                        float ray[3];
+
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            ray[k] = point[k] - cameraCenter[k];
+                        }
+
+                        const float inverseRayLength =
+                            1.0f / std::sqrt(ray[0] * ray[0] + ray[1] * ray[1] + ray[2] * ray[2]);
+
+                        for (int32_t sample = 0; sample < sampleCount; ++sample)
+                        {
+                            const float offset =
+                                (sample * sampleStep - _options.TruncationDistance) * inverseRayLength;
+
+                            int32_t coordinates[3];
+
+                            for (int k = 0; k < 3; ++k)
+                            {
+                                coordinates[k] = static_cast<int32_t>(
+                                    std::floor((point[k] + offset * ray[k]) * inverseBlockEdge));
+                            }
+
+                            const uint64_t key =
+                                GetBlockKey(coordinates[0], coordinates[1], coordinates[2]);
+
+                            uint64_t& recentKey =
+                                recentKeys[BlockKeyHash()(key) % c_recentBlockKeyCount];
+
+                            if (key != recentKey)
+                            {
+                                keys.push_back(key);
+                                recentKey = key;
+                            }
+                        }
+                    }
+                }
+            });
+
+        //
+        // Look the blocks up, and allocate the missing ones, on this thread.
+        //
+        _frameBlocks.clear();
+
+        for (const std::vector<uint64_t>& keys : _blockKeys)
+        {
+            for (const uint64_t key : keys)
+            {
+                Block*& block =
+                    _blockIndex[key];
+
+                if (nullptr == block)
+                {
+                    _blocks.emplace_back();
+
+                    block = &_blocks.back();
+
+                    block->Coordinates[0] = static_cast<int32_t>((key >> 42) & ((1ull << 21) - 1)) - c_blockCoordinateBias;
+                    block->Coordinates[1] = static_cast<int32_t>((key >> 21) & ((1ull << 21) - 1)) - c_blockCoordinateBias;
+                    block->Coordinates[2] = static_cast<int32_t>(key & ((1ull << 21) - 1)) - c_blockCoordinateBias;
+                    block->LastFrame = 0;
+
+                    std::fill_n(block->Distances, VoxelsPerBlock, 1.0f);
+                    std::fill_n(block->Weights, VoxelsPerBlock, 0.0f);
+                }
+
+                if (block->LastFrame != _frameCount)
+                {
+                    block->LastFrame = _frameCount;
+
+                    _frameBlocks.push_back(
+                        block);
+                }
+            }
+        }
+    }
+
+    void TsdfVolume::ExtractBlockMesh(
+        const Block& block,
+        TriangleMesh* mesh) const
+    {
+        const int32_t sampleSize = BlockSize + 1;
+
+        //
+        // The block's voxels, and the first voxels of the blocks after it along
+        // each axis, which close the cubes of its last voxels.
+        //
+        const Block* neighbors[8];
+
+        for (int neighbor = 0; neighbor < 8; ++neighbor)
+        {
+            neighbors[neighbor] = (0 == neighbor) ? &block : FindBlock(
+                block.Coordinates[0] + (neighbor & 1),
+                block.Coordinates[1] + ((neighbor >> 1) & 1),
+                block.Coordinates[2] + ((neighbor >> 2) & 1));
+        }
+
+        struct Sample
+        {
+            float Distance;
+            float Weight;
+        };
+
+        Sample samples[sampleSize * sampleSize * sampleSize];
+
+        for (int32_t z = 0; z < sampleSize; ++z)
+        {
+            for (int32_t y = 0; y < sampleSize; ++y)
+            {
+                for (int32_t x = 0; x < sampleSize; ++x)
+                {
+                    const Block* neighbor =
+                        neighbors[(x / BlockSize) | ((y / BlockSize) << 1) | ((z / BlockSize) << 2)];
+
+                    Sample& sample =
+                        samples[(z * sampleSize + y) * sampleSize + x];
+
+                    if (nullptr == neighbor)
+                    {
+                        sample.Distance = 1.0f;
+                        sample.Weight = 0.0f;
+
+                        continue;
+                    }
+
+                    const size_t voxel =
+                        ((z % BlockSize) * BlockSize + y % BlockSize) * BlockSize + x % BlockSize;
+
+                    sample.Distance = neighbor->Distances[voxel];
+                    sample.Weight = neighbor->Weights[voxel];
+                }
+            }
+        }
+
+        const MarchingCubesTable& table =
+            MarchingCubesTable::Get();
+
+        for (int32_t z = 0; z < BlockSize; ++z)
+        {
+            for (int32_t y = 0; y < BlockSize; ++y)
+            {
+                for (int32_t x = 0; x < BlockSize; ++x)
+                {
+                    float distances[8];
+                    uint32_t cubeCase = 0;
+                    bool isObserved = true;
+
+                    for (uint32_t corner = 0; corner < 8 && isObserved; ++corner)
+                    {
+                        const Sample& sample = samples[
+                            ((z + (corner >> 2)) * sampleSize + y + ((corner >> 1) & 1)) * sampleSize + x + (corner & 1)];
+
+                        distances[corner] = sample.Distance;
+
+                        isObserved =
+                            sample.Weight > 0.0f && std::fabs(sample.Distance) < 1.0f;
+
+                        if (sample.Distance < 0.0f)
+                        {
+                            cubeCase |= 1u << corner;
+                        }
+                    }
+
+                    if (!isObserved || 0 == cubeCase || 0xff == cubeCase)
+                    {
+                        continue;
+                    }
+
+                    uint32_t edgeVertices[12];
+
+                    for (uint32_t& edgeVertex : edgeVertices)
+                    {
+                        edgeVertex = UINT32_MAX;
+                    }
+
+                    for (uint32_t triangle = 0; triangle < table.GetTriangleCount(cubeCase); ++triangle)
+                    {
+                        const uint8_t* edges =
+                            table.GetTriangle(cubeCase, triangle);
+
+                        for (int i = 0; i < 3; ++i)
+                        {
+                            uint32_t& edgeVertex = edgeVertices[edges[i]];
+
+                            if (UINT32_MAX == edgeVertex)
+                            {
+                                const uint8_t* corners =
+                                    MarchingCubesTable::EdgeCorners[edges[i]];
+
+                                const float t =
+                                    distances[corners[0]] / (distances[corners[0]] - distances[corners[1]]);
+
+                                const int32_t local[3] = { x, y, z };
+
+                                edgeVertex =
+                                    static_cast<uint32_t>(mesh->Vertices.size() / 3);
+
+                                for (int k = 0; k < 3; ++k)
+                                {
+                                    const float first = static_cast<float>((corners[0] >> k) & 1);
+                                    const float second = static_cast<float>((corners[1] >> k) & 1);
+
+                                    mesh->Vertices.push_back(
+                                        (block.Coordinates[k] * BlockSize + local[k] + 0.5f + first + t * (second - first)) *
+                                            _options.VoxelSize);
+                                }
+                            }
+
+                            mesh->Triangles.push_back(
+                                edgeVertex);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
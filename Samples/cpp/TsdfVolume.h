@@ -0,0 +1,203 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include "WorkerPool.h"
+
+#include <Io/PointCloud.h>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SensorStream
+{
+    struct TsdfOptions
+    {
+        // Edge of a voxel, in meters.
+        float VoxelSize = 0.01f;
+
+        //
+        // Distance from the surface, in meters, up to which voxels are updated
+        // in front of it, and beyond which they are left alone behind it.
+        //
+        float TruncationDistance = 0.04f;
+
+        // Caps the weight of the past measurements of a voxel.
+        float MaximumWeight = 64.0f;
+
+        //
+        // Only every AllocationStride-th pixel of every AllocationStride-th row
+        // allocates blocks around its point: a block spans many pixels.
+        //
+        uint32_t AllocationStride = 2;
+
+        Io::DepthUnprojectionOptions Depth;
+    };
+
+    //
+    // An indexed triangle mesh, with (x, y, z) vertices.
+    //
+    struct TriangleMesh
+    {
+        std::vector<float> Vertices;
+        std::vector<uint32_t> Triangles;
+    };
+
+    //
+    // Writes a binary PLY file.
+    //
+    bool WritePlyFile(
+        const TriangleMesh& mesh,
+        const char* path,
+        std::string* error);
+
+    //
+    // Truncated signed distance field of the surfaces seen by a depth camera,
+    // fused from its frames. Voxels are allocated in blocks of BlockSize^3
+    // voxels, only around the surfaces, and found through a hash table of their
+    // block coordinates.
+    //
+    // Each frame allocates the blocks around its points, then updates the
+    // voxels of those blocks, split between the threads of the pool: each
+    // voxel is projected into the frame, and its distance to the surface seen
+    // by the pixel it falls on is averaged with its past distances.
+    //
+    // Distances are positive in front of the surfaces, as seen from the
+    // camera, and negative behind them. Not thread safe.
+    //
+    class TsdfVolume
+    {
+    public:
+        static const int32_t BlockSize = 8;
+
+        TsdfVolume(
+            const Io::UnprojectionLut& lut,
+            const TsdfOptions& options,
+            WorkerPool& workerPool);
+
+        TsdfVolume(const TsdfVolume&) = delete;
+        TsdfVolume& operator=(const TsdfVolume&) = delete;
+
+        //
+        // Fuses a Gray16 depth frame as large as the LUT, seen from the given
+        // pose (see ComputeCameraToOrigin). depthRowStride is in bytes.
+        //
+        void Integrate(
+            const uint16_t* depth,
+            size_t depthRowStride,
+            const float cameraToOrigin[16]);
+
+        size_t GetBlockCount() const
+        {
+            return _blocks.size();
+        }
+
+        // Of the voxels, in bytes.
+        size_t GetMemoryUsage() const
+        {
+            return _blocks.size() * sizeof(Block);
+        }
+
+        //
+        // Extracts the zero crossings of the field as a mesh, by marching cubes
+        // between the centers of the voxels. Cubes with a voxel that hasn't been
+        // seen, or whose distance is truncated, are skipped.
+        //
+        void ExtractMesh(
+            TriangleMesh* mesh);
+
+    private:
+        static const int32_t VoxelsPerBlock = BlockSize * BlockSize * BlockSize;
+
+        struct Block
+        {
+            int32_t Coordinates[3];
+
+            // Integrate call that last updated the block.
+            uint64_t LastFrame;
+
+            //
+            // Signed distances over the truncation distance, within [-1, 1], and
+            // weights of the voxels, along x first, then y, then z.
+            //
+            float Distances[VoxelsPerBlock];
+            float Weights[VoxelsPerBlock];
+        };
+
+        struct BlockKeyHash
+        {
+            size_t operator()(
+                uint64_t key) const
+            {
+                key ^= key >> 33;
+                key *= 0xff51afd7ed558ccdull;
+                key ^= key >> 33;
+
+                return static_cast<size_t>(key);
+            }
+        };
+
+        static uint64_t GetBlockKey(
+            int32_t x,
+            int32_t y,
+            int32_t z);
+
+        const Block* FindBlock(
+            int32_t x,
+            int32_t y,
+            int32_t z) const;
+
+        void BuildProjectionGrid();
+
+        void AllocateBlocks(
+            const float cameraToOrigin[16]);
+
+        void ExtractBlockMesh(
+            const Block& block,
+            TriangleMesh* mesh) const;
+
+    private:
+        const Io::UnprojectionLut& _lut;
+        const TsdfOptions _options;
+        WorkerPool& _workerPool;
+
+        // Blocks don't move once allocated.
+        std::deque<Block> _blocks;
+        std::unordered_map<uint64_t, Block*, BlockKeyHash> _blockIndex;
+
+        uint64_t _frameCount;
+
+        //
+        // The frame's depths in meters, zero where invalid, its points, and the
+        // blocks around them.
+        //
+        std::vector<float> _depthInMeters;
+        std::vector<float> _points;
+        std::vector<std::vector<uint64_t>> _blockKeys;
+        std::vector<Block*> _frameBlocks;
+
+        //
+        // Inverse of the LUT: the pixel covering each cell of a grid over the
+        // unit plane, or -1.
+        //
+        std::vector<int32_t> _projectionGrid;
+        uint32_t _projectionGridWidth;
+        uint32_t _projectionGridHeight;
+        float _projectionGridOrigin[2];
+        float _projectionGridScale;
+    };
+}
@@ -0,0 +1,159 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+namespace SensorStream
+{
+    WorkerPool::WorkerPool(
+        size_t threadCount)
+        : _loopIndex(0)
+        , _busyThreadCount(0)
+        , _stopRequested(false)
+        , _body(nullptr)
+        , _count(0)
+        , _chunkSize(1)
+        , _nextIndex(0)
+    {
+        if (0 == threadCount)
+        {
+            threadCount = std::max<size_t>(
+                std::thread::hardware_concurrency(),
+                1);
+        }
+
+        for (size_t i = 1; i < threadCount; ++i)
+        {
+            _threads.emplace_back(
+                [this]()
+                {
+                    Run();
+                });
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            _stopRequested = true;
+        }
+
+        _loopStarted.notify_all();
+
+        for (std::thread& thread : _threads)
+        {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::ParallelFor(
+        size_t count,
+        size_t chunkSize,
+        const std::function<void(size_t, size_t)>& body)
+    {
+        if (0 == count)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            _body = &body;
+            _count = count;
+            _chunkSize = std::max<size_t>(chunkSize, 1);
+            _nextIndex = 0;
+            _busyThreadCount = _threads.size();
+
+            ++_loopIndex;
+        }
+
+        _loopStarted.notify_all();
+
+        RunChunks();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        _loopFinished.wait(
+            lock,
+            [this]()
+            {
+                return 0 == _busyThreadCount;
+            });
+
+        _body = nullptr;
+    }
+
+    void WorkerPool::Run()
+    {
+        uint64_t lastLoopIndex = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+
+                _loopStarted.wait(
+                    lock,
+                    [&]()
+                    {
+                        return _stopRequested || _loopIndex != lastLoopIndex;
+                    });
+
+                if (_stopRequested)
+                {
+                    return;
+                }
+
+                lastLoopIndex = _loopIndex;
+            }
+
+            RunChunks();
+
+            bool isLastThread = false;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                isLastThread = (0 == --_busyThreadCount);
+            }
+
+            if (isLastThread)
+            {
+                _loopFinished.notify_one();
+            }
+        }
+    }
+
+    void WorkerPool::RunChunks()
+    {
+        for (;;)
+        {
+            const size_t begin =
+                _nextIndex.fetch_add(_chunkSize);
+
+            if (begin >= _count)
+            {
+                return;
+            }
+
+            (*_body)(
+                begin,
+                std::min(begin + _chunkSize, _count));
+        }
+    }
+}
@@ -0,0 +1,83 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SensorStream
+{
+    //
+    // A fixed set of threads that split loops between them. The thread calling
+    // ParallelFor takes part in the loop, so a pool of one thread runs loops on
+    // the caller alone.
+    //
+    class WorkerPool
+    {
+    public:
+        //
+        // Zero threads means one per hardware thread.
+        //
+        explicit WorkerPool(
+            size_t threadCount = 0);
+
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        size_t GetThreadCount() const
+        {
+            return _threads.size() + 1;
+        }
+
+        //
+        // Calls body(begin, end) on ranges of at most chunkSize indices covering
+        // [0, count), from all the threads, and returns once they are done. Not
+        // reentrant.
+        //
+        void ParallelFor(
+            size_t count,
+            size_t chunkSize,
+            const std::function<void(size_t, size_t)>& body);
+
+    private:
+        void Run();
+
+        void RunChunks();
+
+    private:
+        std::vector<std::thread> _threads;
+
+        std::mutex _mutex;
+        std::condition_variable _loopStarted;
+        std::condition_variable _loopFinished;
+
+        // Guarded by the mutex.
+        uint64_t _loopIndex;
+        size_t _busyThreadCount;
+        bool _stopRequested;
+
+        // The current loop.
+        const std::function<void(size_t, size_t)>* _body;
+        size_t _count;
+        size_t _chunkSize;
+        std::atomic<size_t> _nextIndex;
+    };
+}
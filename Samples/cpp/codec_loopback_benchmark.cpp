@@ -0,0 +1,1061 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks the lossless codecs of the Shared/Io library that HoloLensForCV's
+// streaming servers compress frames with, then streams synthetic frames of the
+// PV camera, a visible light camera and the long throw depth camera over TCP
+// loopback with each codec, through an emulated link of 50, 100 and 300 Mbit/s.
+// The sender compresses the frames and sends them with version 0.3 headers
+// like SensorFrameStreamingServer, including its fallbacks: JPEG applies to
+// 8-bit images only, the depth codec to 16-bit images only, and frames that
+// don't shrink are sent raw. The receiver decompresses and checks every frame.
+// Reports the frame rate and the encode and decode CPU time per frame.
+//
+// HoloLensForCV encodes JPEG with WIC. Built with -DWITH_LIBJPEG and -ljpeg,
+// the benchmark uses libjpeg instead; otherwise it skips the JPEG runs.
+//
+// Usage: codec_loopback_benchmark [seconds per run] [random cases to check]
+//
+
+#include "SensorStreamProtocol.h"
+
+#include <Io/FrameCodec.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(WITH_LIBJPEG)
+#include <jpeglib.h>
+#endif
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    enum class PixelFormat
+    {
+        Bgra8,
+        Gray8,
+        Gray16
+    };
+
+    struct Sensor
+    {
+        const char* Name;
+        uint16_t FrameType;
+        uint32_t Width;
+        uint32_t Height;
+        PixelFormat Format;
+        SensorStream::Codec Codecs[3];
+    };
+
+    //
+    // The frame types are those of HoloLensForCV::SensorType.
+    //
+    const Sensor c_sensors[] =
+    {
+        { "PV 1280x720 BGRA8", 0, 1280, 720, PixelFormat::Bgra8,
+            { SensorStream::Codec::Raw, SensorStream::Codec::Lz4, SensorStream::Codec::Jpeg } },
+        { "VLC 640x480 Gray8", 5, 640, 480, PixelFormat::Gray8,
+            { SensorStream::Codec::Raw, SensorStream::Codec::Lz4, SensorStream::Codec::Jpeg } },
+        { "Long throw 448x450 Gray16", 3, 448, 450, PixelFormat::Gray16,
+            { SensorStream::Codec::Raw, SensorStream::Codec::Depth, SensorStream::Codec::Lz4 } },
+    };
+
+    const double c_linkMegabitsPerSecond[] = { 50.0, 100.0, 300.0 };
+
+    const size_t c_framesPerSensor = 8;
+
+    const int c_jpegQuality = 90;
+
+    const char* GetCodecName(
+        const SensorStream::Codec codec)
+    {
+        switch (codec)
+        {
+        case SensorStream::Codec::Raw:
+            return "raw";
+        case SensorStream::Codec::Lz4:
+            return "lz4";
+        case SensorStream::Codec::Depth:
+            return "depth";
+        case SensorStream::Codec::Jpeg:
+            return "jpeg";
+        case SensorStream::Codec::Delta:
+            return "delta";
+        }
+
+        return "?";
+    }
+
+    uint32_t NextRandom(
+        uint64_t& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    double GetThreadCpuSeconds()
+    {
+        timespec time;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+        return time.tv_sec + time.tv_nsec * 1e-9;
+    }
+
+    uint32_t GetBytesPerPixel(
+        const PixelFormat format)
+    {
+        return (PixelFormat::Bgra8 == format) ? 4 : (PixelFormat::Gray16 == format) ? 2 : 1;
+    }
+
+    //
+    // Camera images: shading, a few edges moving from frame to frame and a
+    // couple of levels of sensor noise. Depth images: a sloped wall and a box
+    // moving in front of it in millimeters, with noise growing with the
+    // distance and no returns (zero) past the edges of the wall.
+    //
+    std::vector<uint8_t> CreateFrame(
+        const Sensor& sensor,
+        const size_t frameIndex,
+        uint64_t& random)
+    {
+        const uint32_t bytesPerPixel = GetBytesPerPixel(sensor.Format);
+
+        std::vector<uint8_t> frame(static_cast<size_t>(sensor.Width) * sensor.Height * bytesPerPixel);
+
+        const double t = 0.15 * static_cast<double>(frameIndex);
+
+        const uint32_t boxLeft = static_cast<uint32_t>(sensor.Width * (0.2 + 0.03 * frameIndex));
+        const uint32_t boxTop = sensor.Height / 3;
+
+        for (uint32_t y = 0; y < sensor.Height; ++y)
+        {
+            for (uint32_t x = 0; x < sensor.Width; ++x)
+            {
+                const bool inBox =
+                    x >= boxLeft && x < boxLeft + sensor.Width / 4 &&
+                    y >= boxTop && y < boxTop + sensor.Height / 3;
+
+                const size_t pixel = static_cast<size_t>(y) * sensor.Width + x;
+
+                if (PixelFormat::Gray16 == sensor.Format)
+                {
+                    const bool noReturn = x < sensor.Width / 16 || y > sensor.Height * 15 / 16;
+
+                    const double distance = inBox ? 1200.0 : 2600.0 + 1.5 * x - 0.8 * y;
+                    const int noise = static_cast<int>(NextRandom(random) % 9) - 4;
+
+                    const uint16_t value = noReturn ?
+                        0 : static_cast<uint16_t>(distance + noise * distance / 2000.0);
+
+                    memcpy(frame.data() + 2 * pixel, &value, sizeof(value));
+
+                    continue;
+                }
+
+                for (uint32_t channel = 0; channel < std::min<uint32_t>(bytesPerPixel, 3); ++channel)
+                {
+                    const double shading =
+                        110.0 +
+                        50.0 * sin(0.013 * x + t + channel) * cos(0.021 * y - 0.5 * t) +
+                        (inBox ? 60.0 : 0.0) +
+                        (0 == (x / 64 + y / 48) % 5 ? -40.0 : 0.0);
+
+                    const int noise = static_cast<int>(NextRandom(random) % 5) - 2;
+
+                    frame[pixel * bytesPerPixel + channel] =
+                        static_cast<uint8_t>(std::max(0.0, std::min(255.0, shading + noise)));
+                }
+
+                if (4 == bytesPerPixel)
+                {
+                    frame[pixel * bytesPerPixel + 3] = 0xff;
+                }
+            }
+        }
+
+        return frame;
+    }
+
+#if defined(WITH_LIBJPEG)
+    size_t CompressJpeg(
+        const Sensor& sensor,
+        const uint8_t* pixels,
+        std::vector<uint8_t>& output)
+    {
+        jpeg_compress_struct compressor;
+        jpeg_error_mgr errorManager;
+
+        compressor.err = jpeg_std_error(&errorManager);
+        jpeg_create_compress(&compressor);
+
+        unsigned char* data = nullptr;
+        unsigned long size = 0;
+
+        jpeg_mem_dest(&compressor, &data, &size);
+
+        compressor.image_width = sensor.Width;
+        compressor.image_height = sensor.Height;
+        compressor.input_components = static_cast<int>(GetBytesPerPixel(sensor.Format));
+        compressor.in_color_space = (PixelFormat::Bgra8 == sensor.Format) ? JCS_EXT_BGRA : JCS_GRAYSCALE;
+
+        jpeg_set_defaults(&compressor);
+        jpeg_set_quality(&compressor, c_jpegQuality, TRUE);
+        jpeg_start_compress(&compressor, TRUE);
+
+        const size_t rowStride = static_cast<size_t>(sensor.Width) * compressor.input_components;
+
+        while (compressor.next_scanline < compressor.image_height)
+        {
+            JSAMPROW row = const_cast<JSAMPROW>(pixels + compressor.next_scanline * rowStride);
+
+            jpeg_write_scanlines(&compressor, &row, 1);
+        }
+
+        jpeg_finish_compress(&compressor);
+        jpeg_destroy_compress(&compressor);
+
+        output.assign(data, data + size);
+        free(data);
+
+        return output.size();
+    }
+
+    void DecompressJpeg(
+        const Sensor& sensor,
+        const uint8_t* payload,
+        const size_t payloadLength,
+        uint8_t* pixels)
+    {
+        jpeg_decompress_struct decompressor;
+        jpeg_error_mgr errorManager;
+
+        decompressor.err = jpeg_std_error(&errorManager);
+        jpeg_create_decompress(&decompressor);
+
+        jpeg_mem_src(&decompressor, payload, static_cast<unsigned long>(payloadLength));
+        jpeg_read_header(&decompressor, TRUE);
+
+        decompressor.out_color_space = (PixelFormat::Bgra8 == sensor.Format) ? JCS_EXT_BGRA : JCS_GRAYSCALE;
+
+        jpeg_start_decompress(&decompressor);
+
+        const size_t rowStride = static_cast<size_t>(sensor.Width) * GetBytesPerPixel(sensor.Format);
+
+        while (decompressor.output_scanline < decompressor.output_height)
+        {
+            JSAMPROW row = pixels + decompressor.output_scanline * rowStride;
+
+            jpeg_read_scanlines(&decompressor, &row, 1);
+        }
+
+        jpeg_finish_decompress(&decompressor);
+        jpeg_destroy_decompress(&decompressor);
+    }
+#endif
+
+    //
+    // Compresses a frame like SensorFrameCompressor. Returns the codec that
+    // was used; the payload is empty when the frame is sent raw.
+    //
+    SensorStream::Codec CompressFrame(
+        const Sensor& sensor,
+        const SensorStream::Codec requestedCodec,
+        const uint8_t* pixels,
+        Io::Lz4Compressor& lz4Compressor,
+        std::vector<uint8_t>& payload)
+    {
+        const size_t imageSize =
+            static_cast<size_t>(sensor.Width) * sensor.Height * GetBytesPerPixel(sensor.Format);
+
+        SensorStream::Codec codec = requestedCodec;
+
+        if (SensorStream::Codec::Jpeg == codec && PixelFormat::Gray16 == sensor.Format)
+        {
+            codec = SensorStream::Codec::Depth;
+        }
+
+        if (SensorStream::Codec::Depth == codec && PixelFormat::Gray16 != sensor.Format)
+        {
+            codec = SensorStream::Codec::Lz4;
+        }
+
+        size_t payloadLength = 0;
+
+        switch (codec)
+        {
+        case SensorStream::Codec::Lz4:
+            payload.resize(Io::Lz4CompressBound(imageSize));
+            payloadLength = lz4Compressor.Compress(pixels, imageSize, payload.data(), payload.size());
+            break;
+
+        case SensorStream::Codec::Depth:
+            payload.resize(Io::DepthCompressBound(sensor.Width, sensor.Height));
+            payloadLength = Io::DepthCompress(
+                reinterpret_cast<const uint16_t*>(pixels),
+                sensor.Width,
+                sensor.Height,
+                payload.data(),
+                payload.size());
+            break;
+
+#if defined(WITH_LIBJPEG)
+        case SensorStream::Codec::Jpeg:
+            payloadLength = CompressJpeg(sensor, pixels, payload);
+            break;
+#endif
+
+        default:
+            break;
+        }
+
+        if (0 == payloadLength || payloadLength >= imageSize)
+        {
+            payload.clear();
+
+            return SensorStream::Codec::Raw;
+        }
+
+        payload.resize(payloadLength);
+
+        return codec;
+    }
+
+    bool SendAll(
+        const int socket,
+        const uint8_t* data,
+        size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+
+            if (sent <= 0)
+            {
+                return false;
+            }
+
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+
+        return true;
+    }
+
+    bool ReceiveAll(
+        const int socket,
+        uint8_t* data,
+        size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t received = recv(socket, data, size, 0);
+
+            if (received <= 0)
+            {
+                return false;
+            }
+
+            data += received;
+            size -= static_cast<size_t>(received);
+        }
+
+        return true;
+    }
+
+    bool CreateConnection(
+        int* senderSocket,
+        int* receiverSocket)
+    {
+        const int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t addressLength = sizeof(address);
+
+        bool connected =
+            listener >= 0 &&
+            0 == bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) &&
+            0 == listen(listener, 1) &&
+            0 == getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength);
+
+        *receiverSocket = connected ? socket(AF_INET, SOCK_STREAM, 0) : -1;
+
+        connected = connected &&
+            0 == connect(*receiverSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        *senderSocket = connected ? accept(listener, nullptr, nullptr) : -1;
+
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+
+        return connected && *senderSocket >= 0;
+    }
+
+    struct RunResult
+    {
+        bool Passed = false;
+        SensorStream::Codec Codec = SensorStream::Codec::Raw;
+        uint64_t Frames = 0;
+        double FramesPerSecond = 0.0;
+        double CompressionRatio = 0.0;
+        double EncodeMilliseconds = 0.0;
+        double DecodeMilliseconds = 0.0;
+        double WorstPsnr = INFINITY;
+    };
+
+    double ComputePsnr(
+        const uint8_t* a,
+        const uint8_t* b,
+        const size_t size,
+        const size_t bytesPerPixel)
+    {
+        double squaredError = 0.0;
+        size_t samples = 0;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            //
+            // Alpha is not coded.
+            //
+            if (4 == bytesPerPixel && 3 == i % 4)
+            {
+                continue;
+            }
+
+            const double difference = static_cast<double>(a[i]) - b[i];
+
+            squaredError += difference * difference;
+            ++samples;
+        }
+
+        return (0.0 == squaredError) ?
+            INFINITY :
+            10.0 * log10(255.0 * 255.0 * samples / squaredError);
+    }
+
+    //
+    // Streams the frames of a sensor back to back for the given time, the
+    // sender pacing its writes at the rate of the link, and compressing the
+    // next frame while the previous one is on the wire.
+    //
+    RunResult StreamFrames(
+        const Sensor& sensor,
+        const std::vector<std::vector<uint8_t>>& frames,
+        const SensorStream::Codec requestedCodec,
+        const double linkMegabitsPerSecond,
+        const double seconds)
+    {
+        RunResult result;
+
+        int senderSocket = -1;
+        int receiverSocket = -1;
+
+        if (!CreateConnection(&senderSocket, &receiverSocket))
+        {
+            printf("  cannot connect over the loopback interface\n");
+            return result;
+        }
+
+        const uint32_t bytesPerPixel = GetBytesPerPixel(sensor.Format);
+        const size_t imageSize = static_cast<size_t>(sensor.Width) * sensor.Height * bytesPerPixel;
+
+        std::atomic<uint64_t> framesReceived(0);
+        std::atomic<uint64_t> payloadBytesSent(0);
+        std::atomic<int> codecUsed(static_cast<int>(SensorStream::Codec::Raw));
+
+        double encodeSeconds = 0.0;
+        double decodeSeconds = 0.0;
+
+        Clock::time_point firstFrameReceived;
+        Clock::time_point lastFrameReceived;
+
+        bool framesIntact = true;
+        bool transportFailed = false;
+
+        const Clock::time_point start = Clock::now();
+
+        std::thread receiver(
+            [&]()
+            {
+                std::vector<uint8_t> header(SensorStream::ProtocolHeaderLength + SensorStream::ProtocolMaximumExtendedHeaderLength);
+                std::vector<uint8_t> payload;
+                std::vector<uint8_t> pixels(imageSize);
+
+                for (;;)
+                {
+                    SensorStream::FrameHeader frameHeader;
+
+                    if (!ReceiveAll(receiverSocket, header.data(), SensorStream::ProtocolHeaderLength))
+                    {
+                        break;
+                    }
+
+                    const size_t extendedHeaderLength =
+                        SensorStream::ParseHeader(header.data(), &frameHeader) ?
+                        SensorStream::GetExtendedHeaderLength(frameHeader.VersionMinor) :
+                        0;
+
+                    if (0 == extendedHeaderLength ||
+                        !ReceiveAll(receiverSocket, header.data() + SensorStream::ProtocolHeaderLength, extendedHeaderLength) ||
+                        !SensorStream::ParseExtendedFields(header.data() + SensorStream::ProtocolHeaderLength, &frameHeader) ||
+                        0 != frameHeader.ExtensionsLength ||
+                        frameHeader.ImageWidth != sensor.Width ||
+                        frameHeader.ImageHeight != sensor.Height ||
+                        frameHeader.Timestamp >= frames.size())
+                    {
+                        transportFailed = true;
+                        break;
+                    }
+
+                    payload.resize(frameHeader.PayloadLength);
+
+                    if (!ReceiveAll(receiverSocket, payload.data(), payload.size()))
+                    {
+                        transportFailed = true;
+                        break;
+                    }
+
+                    const double decodeStart = GetThreadCpuSeconds();
+
+                    try
+                    {
+                        switch (frameHeader.PayloadCodec)
+                        {
+                        case SensorStream::Codec::Raw:
+                            memcpy(pixels.data(), payload.data(), imageSize);
+                            break;
+
+                        case SensorStream::Codec::Lz4:
+                            Io::Lz4Decompress(payload.data(), payload.size(), pixels.data(), imageSize);
+                            break;
+
+                        case SensorStream::Codec::Depth:
+                            Io::DepthDecompress(
+                                payload.data(),
+                                payload.size(),
+                                sensor.Width,
+                                sensor.Height,
+                                reinterpret_cast<uint16_t*>(pixels.data()));
+                            break;
+
+#if defined(WITH_LIBJPEG)
+                        case SensorStream::Codec::Jpeg:
+                            DecompressJpeg(sensor, payload.data(), payload.size(), pixels.data());
+                            break;
+#endif
+
+                        default:
+                            transportFailed = true;
+                            break;
+                        }
+                    }
+                    catch (const std::exception& exception)
+                    {
+                        printf("  frame %llu does not decompress: %s\n", static_cast<unsigned long long>(framesReceived.load()), exception.what());
+                        framesIntact = false;
+                    }
+
+                    decodeSeconds += GetThreadCpuSeconds() - decodeStart;
+
+                    if (transportFailed)
+                    {
+                        break;
+                    }
+
+                    const std::vector<uint8_t>& frame = frames[frameHeader.Timestamp];
+
+                    if (SensorStream::Codec::Jpeg == frameHeader.PayloadCodec)
+                    {
+                        result.WorstPsnr = std::min(
+                            result.WorstPsnr,
+                            ComputePsnr(frame.data(), pixels.data(), imageSize, bytesPerPixel));
+                    }
+                    else if (0 != memcmp(frame.data(), pixels.data(), imageSize))
+                    {
+                        framesIntact = false;
+                    }
+
+                    lastFrameReceived = Clock::now();
+
+                    if (0 == framesReceived)
+                    {
+                        firstFrameReceived = lastFrameReceived;
+                    }
+
+                    ++framesReceived;
+                }
+            });
+
+        Io::Lz4Compressor lz4Compressor;
+
+        std::vector<uint8_t> payload;
+        uint8_t header[SensorStream::ProtocolHeaderLength + SensorStream::ProtocolMaximumExtendedHeaderLength];
+
+        const double bytesPerSecond = linkMegabitsPerSecond * 1e6 / 8.0;
+
+        Clock::time_point linkFreeAt = start;
+
+        for (uint64_t frameIndex = 0; Clock::now() - start < std::chrono::duration<double>(seconds); ++frameIndex)
+        {
+            const std::vector<uint8_t>& frame = frames[frameIndex % frames.size()];
+
+            const double encodeStart = GetThreadCpuSeconds();
+
+            const SensorStream::Codec codec =
+                CompressFrame(sensor, requestedCodec, frame.data(), lz4Compressor, payload);
+
+            encodeSeconds += GetThreadCpuSeconds() - encodeStart;
+
+            SensorStream::FrameHeader frameHeader = {};
+
+            frameHeader.Cookie = SensorStream::ProtocolCookie;
+            frameHeader.VersionMajor = SensorStream::ProtocolVersionMajor;
+            frameHeader.VersionMinor = SensorStream::ProtocolVersionMinor;
+            frameHeader.FrameType = sensor.FrameType;
+            frameHeader.Timestamp = frameIndex % frames.size();
+            frameHeader.ImageWidth = sensor.Width;
+            frameHeader.ImageHeight = sensor.Height;
+            frameHeader.PixelStride = bytesPerPixel;
+            frameHeader.RowStride = sensor.Width * bytesPerPixel;
+            frameHeader.PayloadCodec = codec;
+            frameHeader.PayloadLength = static_cast<uint32_t>(payload.empty() ? imageSize : payload.size());
+
+            const size_t headerLength = SensorStream::WriteHeader(frameHeader, header);
+
+            //
+            // Wait for the previous frame to leave the emulated link.
+            //
+            std::this_thread::sleep_until(linkFreeAt);
+
+            const bool sent =
+                SendAll(senderSocket, header, headerLength) &&
+                SendAll(
+                    senderSocket,
+                    payload.empty() ? frame.data() : payload.data(),
+                    frameHeader.PayloadLength);
+
+            if (!sent)
+            {
+                transportFailed = true;
+                break;
+            }
+
+            linkFreeAt = std::max(linkFreeAt, Clock::now()) +
+                std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>((headerLength + frameHeader.PayloadLength) / bytesPerSecond));
+
+            payloadBytesSent += frameHeader.PayloadLength;
+            codecUsed = static_cast<int>(codec);
+        }
+
+        shutdown(senderSocket, SHUT_WR);
+
+        receiver.join();
+
+        close(senderSocket);
+        close(receiverSocket);
+
+        result.Frames = framesReceived;
+        result.Codec = static_cast<SensorStream::Codec>(codecUsed.load());
+
+        if (result.Frames > 0)
+        {
+            //
+            // The first frame finds the link idle; the rate is that of the
+            // frames that followed it.
+            //
+            result.FramesPerSecond = (result.Frames > 1) ?
+                (result.Frames - 1) / std::chrono::duration<double>(lastFrameReceived - firstFrameReceived).count() :
+                0.0;
+            result.CompressionRatio =
+                static_cast<double>(imageSize) * result.Frames / payloadBytesSent;
+            result.EncodeMilliseconds = 1e3 * encodeSeconds / result.Frames;
+            result.DecodeMilliseconds = 1e3 * decodeSeconds / result.Frames;
+        }
+
+        result.Passed = !transportFailed && framesIntact && result.Frames > 0;
+
+        return result;
+    }
+
+    //
+    // Round trips the delta codec between the image and previous images made
+    // from it, with 1- and 2-byte samples.
+    //
+    bool CheckDeltaCodec(
+        const uint64_t caseIndex,
+        const std::vector<uint16_t>& samples,
+        const uint32_t rowLength,
+        const uint32_t numberOfRows,
+        uint64_t& random)
+    {
+        const uint32_t tilesPerRow = (rowLength + Io::DeltaTileSize - 1) / Io::DeltaTileSize;
+        const uint32_t tilesPerColumn = (numberOfRows + Io::DeltaTileSize - 1) / Io::DeltaTileSize;
+        const size_t numberOfTiles = static_cast<size_t>(tilesPerRow) * tilesPerColumn;
+
+        // Some cases change no tile at all, some all of them.
+        const uint32_t changedTilesPercent =
+            (0 == caseIndex % 7) ? 0 : (1 == caseIndex % 7) ? 100 : NextRandom(random) % 100;
+
+        std::vector<uint16_t> previousSamples(samples);
+        bool isChanged = false;
+
+        for (uint32_t tileY = 0; tileY < tilesPerColumn; ++tileY)
+        {
+            for (uint32_t tileX = 0; tileX < tilesPerRow; ++tileX)
+            {
+                if (NextRandom(random) % 100 >= changedTilesPercent)
+                {
+                    continue;
+                }
+
+                const uint32_t firstX = tileX * Io::DeltaTileSize;
+                const uint32_t firstY = tileY * Io::DeltaTileSize;
+                const uint32_t tileWidth = std::min(Io::DeltaTileSize, rowLength - firstX);
+                const uint32_t tileHeight = std::min(Io::DeltaTileSize, numberOfRows - firstY);
+
+                //
+                // The changes are in the low byte, so that the 8-bit images
+                // differ in the same tiles.
+                //
+                const bool isWholeTile = (0 == NextRandom(random) % 2);
+                const uint32_t changedX = firstX + NextRandom(random) % tileWidth;
+                const uint32_t changedY = firstY + NextRandom(random) % tileHeight;
+
+                for (uint32_t y = firstY; y < firstY + tileHeight; ++y)
+                {
+                    for (uint32_t x = firstX; x < firstX + tileWidth; ++x)
+                    {
+                        if (isWholeTile || (x == changedX && y == changedY))
+                        {
+                            uint16_t& sample = previousSamples[static_cast<size_t>(y) * rowLength + x];
+
+                            sample = static_cast<uint16_t>(sample ^ (1 + NextRandom(random) % 0xff));
+                        }
+                    }
+                }
+
+                isChanged = true;
+            }
+        }
+
+        std::vector<uint8_t> compressed;
+
+        for (uint32_t bytesPerSample = 1; bytesPerSample <= 2; ++bytesPerSample)
+        {
+            std::vector<uint8_t> image;
+            std::vector<uint8_t> previousImage;
+
+            if (2 == bytesPerSample)
+            {
+                image.assign(
+                    reinterpret_cast<const uint8_t*>(samples.data()),
+                    reinterpret_cast<const uint8_t*>(samples.data() + samples.size()));
+                previousImage.assign(
+                    reinterpret_cast<const uint8_t*>(previousSamples.data()),
+                    reinterpret_cast<const uint8_t*>(previousSamples.data() + previousSamples.size()));
+            }
+            else
+            {
+                for (size_t j = 0; j < samples.size(); ++j)
+                {
+                    image.push_back(static_cast<uint8_t>(samples[j]));
+                    previousImage.push_back(static_cast<uint8_t>(previousSamples[j]));
+                }
+            }
+
+            compressed.resize(Io::DeltaCompressBound(bytesPerSample, rowLength, numberOfRows));
+
+            const size_t compressedSize = Io::DeltaCompress(
+                image.data(),
+                previousImage.data(),
+                bytesPerSample,
+                rowLength,
+                numberOfRows,
+                compressed.data(),
+                compressed.size());
+
+            // The decompressed image replaces the previous one.
+            Io::DeltaDecompress(
+                compressed.data(),
+                compressedSize,
+                bytesPerSample,
+                rowLength,
+                numberOfRows,
+                previousImage.data());
+
+            // Unchanged tiles cost a bit each.
+            const bool isSmallEnough =
+                isChanged || compressedSize == (numberOfTiles + 7) / 8;
+
+            if (image != previousImage || !isSmallEnough)
+            {
+                printf(
+                    "delta case %llu (%ux%u, %u-byte samples, %u%% of the tiles changed) does not round trip\n",
+                    static_cast<unsigned long long>(caseIndex),
+                    rowLength,
+                    numberOfRows,
+                    bytesPerSample,
+                    changedTilesPercent);
+
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //
+    // Round trips of the lossless codecs on random images of random sizes,
+    // from noise to constant images and the extremes of the sample range.
+    //
+    bool CheckLosslessCodecs(
+        const uint64_t numberOfCases)
+    {
+        uint64_t random = 42;
+
+        Io::Lz4Compressor lz4Compressor;
+        Io::FrameCompressor frameCompressor;
+
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> bitmapFile;
+
+        for (uint64_t i = 0; i < numberOfCases; ++i)
+        {
+            const uint32_t rowLength = 1 + NextRandom(random) % ((0 == i % 16) ? 1000 : 70);
+            const uint32_t numberOfRows = 1 + NextRandom(random) % 40;
+            const uint32_t style = NextRandom(random) % 5;
+
+            std::vector<uint16_t> samples(static_cast<size_t>(rowLength) * numberOfRows);
+
+            uint32_t level = NextRandom(random) & 0xffff;
+
+            for (uint16_t& sample : samples)
+            {
+                switch (style)
+                {
+                case 0:
+                    sample = static_cast<uint16_t>(NextRandom(random));
+                    break;
+                case 1:
+                    sample = static_cast<uint16_t>(level);
+                    break;
+                case 2:
+                    sample = (0 == NextRandom(random) % 2) ? 0 : 0xffff;
+                    break;
+                case 3:
+                    level += NextRandom(random) % 7;
+                    sample = static_cast<uint16_t>(level);
+                    break;
+                default:
+                    sample = (0 == NextRandom(random) % 8) ? 0 : static_cast<uint16_t>(1000 + NextRandom(random) % 16);
+                    break;
+                }
+            }
+
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(samples.data());
+            const size_t size = samples.size() * sizeof(uint16_t);
+
+            //
+            // LZ4, on the bytes of the image or a prefix of them.
+            //
+            const size_t lz4Size = (0 == i % 3) ? NextRandom(random) % (size + 1) : size;
+
+            compressed.resize(Io::Lz4CompressBound(lz4Size));
+
+            const size_t lz4CompressedSize =
+                lz4Compressor.Compress(bytes, lz4Size, compressed.data(), compressed.size());
+
+            //
+            // Empty inputs compress to a block too; decompress it into a
+            // valid pointer.
+            //
+            std::vector<uint8_t> lz4Decompressed(std::max<size_t>(lz4Size, 1));
+
+            Io::Lz4Decompress(compressed.data(), lz4CompressedSize, lz4Decompressed.data(), lz4Size);
+
+            if (0 != lz4Size && 0 != memcmp(bytes, lz4Decompressed.data(), lz4Size))
+            {
+                printf("LZ4 case %llu (%zu bytes, style %u) does not round trip\n", static_cast<unsigned long long>(i), lz4Size, style);
+                return false;
+            }
+
+            //
+            // Depth codec.
+            //
+            compressed.resize(Io::DepthCompressBound(rowLength, numberOfRows));
+
+            const size_t depthCompressedSize = Io::DepthCompress(
+                samples.data(), rowLength, numberOfRows, compressed.data(), compressed.size());
+
+            std::vector<uint16_t> depthDecompressed(samples.size());
+
+            Io::DepthDecompress(compressed.data(), depthCompressedSize, rowLength, numberOfRows, depthDecompressed.data());
+
+            if (samples != depthDecompressed)
+            {
+                printf("depth case %llu (%ux%u, style %u) does not round trip\n", static_cast<unsigned long long>(i), rowLength, numberOfRows, style);
+                return false;
+            }
+
+            //
+            // Delta codec, of 16-bit images and of 8-bit images of their low
+            // bytes, against a previous image that differs in some tiles:
+            // in all of their samples, in a single one, or in none. The sizes
+            // make for partial tiles on the right and bottom edges.
+            //
+            if (!CheckDeltaCodec(i, samples, rowLength, numberOfRows, random))
+            {
+                return false;
+            }
+
+            //
+            // Stored frames: a PGM file header followed by the pixels.
+            //
+            const std::string bitmapHeader =
+                "P5\n" + std::to_string(rowLength) + " " + std::to_string(numberOfRows) + "\n65535\n";
+
+            const Io::FrameCodec requestedCodec =
+                (0 == i % 2) ? Io::FrameCodec::Depth : Io::FrameCodec::Lz4;
+
+            const Io::FrameCodec codec = frameCompressor.Compress(
+                requestedCodec,
+                reinterpret_cast<const uint8_t*>(bitmapHeader.data()),
+                bitmapHeader.size(),
+                bytes,
+                size,
+                numberOfRows,
+                true /* is16BitPerPixel */);
+
+            if (Io::FrameCodec::Raw != codec)
+            {
+                Io::DecompressFrame(frameCompressor.GetData(), frameCompressor.GetSize(), bitmapFile);
+
+                const bool isSame =
+                    Io::IsCompressedFrame(frameCompressor.GetData(), frameCompressor.GetSize()) &&
+                    bitmapFile.size() == bitmapHeader.size() + size &&
+                    0 == memcmp(bitmapFile.data(), bitmapHeader.data(), bitmapHeader.size()) &&
+                    0 == memcmp(bitmapFile.data() + bitmapHeader.size(), bytes, size);
+
+                if (!isSame)
+                {
+                    printf("stored frame %llu (%ux%u, style %u) does not round trip\n", static_cast<unsigned long long>(i), rowLength, numberOfRows, style);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds = (argc > 1) ? atof(argv[1]) : 3.0;
+    const uint64_t numberOfCases = (argc > 2) ? static_cast<uint64_t>(atoll(argv[2])) : 20000;
+
+    bool passed = true;
+
+    try
+    {
+        passed = CheckLosslessCodecs(numberOfCases);
+    }
+    catch (const std::exception& exception)
+    {
+        printf("the codecs threw: %s\n", exception.what());
+        passed = false;
+    }
+
+    printf("%llu random images: %s\n", static_cast<unsigned long long>(numberOfCases), passed ? "round trip" : "FAILED");
+
+    uint64_t random = 7;
+
+    for (const Sensor& sensor : c_sensors)
+    {
+        std::vector<std::vector<uint8_t>> frames;
+
+        for (size_t i = 0; i < c_framesPerSensor; ++i)
+        {
+            frames.push_back(CreateFrame(sensor, i, random));
+        }
+
+        printf("\n%s\n", sensor.Name);
+
+        for (const SensorStream::Codec codec : sensor.Codecs)
+        {
+#if !defined(WITH_LIBJPEG)
+            if (SensorStream::Codec::Jpeg == codec)
+            {
+                printf("  jpeg: skipped, build with -DWITH_LIBJPEG -ljpeg\n");
+                continue;
+            }
+#endif
+
+            for (const double linkMegabitsPerSecond : c_linkMegabitsPerSecond)
+            {
+                const RunResult result =
+                    StreamFrames(sensor, frames, codec, linkMegabitsPerSecond, seconds);
+
+                printf(
+                    "  %-5s %3.0f Mbit/s: %6.1f fps, %5.2fx smaller, encode %5.2f ms, decode %5.2f ms",
+                    GetCodecName(codec),
+                    linkMegabitsPerSecond,
+                    result.FramesPerSecond,
+                    result.CompressionRatio,
+                    result.EncodeMilliseconds,
+                    result.DecodeMilliseconds);
+
+                if (codec != result.Codec)
+                {
+                    printf(", sent %s", GetCodecName(result.Codec));
+                }
+
+                if (std::isfinite(result.WorstPsnr))
+                {
+                    printf(", PSNR >= %.1f dB", result.WorstPsnr);
+                }
+
+                printf("%s\n", result.Passed ? "" : ", FAILED");
+
+                passed = passed && result.Passed;
+            }
+        }
+    }
+
+    printf("\n%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
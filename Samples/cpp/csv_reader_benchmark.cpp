@@ -0,0 +1,537 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks the CSV reader and number parsing of the Shared/Io library, which
+// BatchProcessing uses to read the manifests of a recording, and measures the
+// rows per second read from a synthetic pv.csv of the recorder's 50 column
+// frame schema, against the getline, strtok and atof path BatchProcessing
+// used before. Io::ParseFloat and Io::ParseDouble must give the same values
+// as strtof and strtod.
+//
+// Usage: csv_reader_benchmark [rows] [random numbers to check]
+//
+
+#include <Io/CsvReader.h>
+#include <Io/NumberParsing.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t c_numberOfMatrixValues = 48;
+    const size_t c_numberOfColumns = 2 + c_numberOfMatrixValues;
+
+    //
+    // The columns of a frame manifest, struct-of-arrays like BatchProcessing
+    // keeps them.
+    //
+    struct FrameColumns
+    {
+        std::vector<uint64_t> Timestamps;
+        std::vector<std::string> ImageFileNames;
+        std::vector<float> Matrices;
+
+        void Clear()
+        {
+            Timestamps.clear();
+            ImageFileNames.clear();
+            Matrices.clear();
+        }
+    };
+
+    uint32_t NextRandom(
+        uint64_t& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    //
+    // Writes the manifest as the recorder does: a header row followed by a row
+    // per frame, the floats printed with 9 significant digits.
+    //
+    std::string CreateManifest(
+        const size_t numberOfRows,
+        FrameColumns& expected)
+    {
+        std::string manifest = "Timestamp,ImageFileName";
+
+        const char* matrixNames[] =
+        {
+            "FrameToOrigin", "CameraViewTransform", "CameraProjectionTransform"
+        };
+
+        for (const char* matrixName : matrixNames)
+        {
+            for (int row = 1; row <= 4; ++row)
+            {
+                for (int column = 1; column <= 4; ++column)
+                {
+                    manifest += ",";
+                    manifest += matrixName;
+                    manifest += ".m" + std::to_string(row) + std::to_string(column);
+                }
+            }
+        }
+
+        manifest += "\n";
+
+        uint64_t random = 7;
+        char text[64];
+
+        for (size_t i = 0; i < numberOfRows; ++i)
+        {
+            const uint64_t timestamp = 131000000000000000ULL + i * 333333ULL;
+
+            snprintf(text, sizeof(text), "%" PRIu64, timestamp);
+
+            manifest += text;
+
+            snprintf(text, sizeof(text), "pv\\%020" PRIu64 ".raw", timestamp);
+
+            manifest += ",";
+            manifest += text;
+
+            expected.Timestamps.push_back(timestamp);
+            expected.ImageFileNames.push_back(text);
+
+            for (size_t j = 0; j < c_numberOfMatrixValues; ++j)
+            {
+                const float unit =
+                    static_cast<float>(NextRandom(random)) / 4294967296.0f;
+
+                const float value =
+                    (3 == j % 4) ? 0.0f :
+                    (15 == j % 16) ? 1.0f :
+                    (2.0f * unit - 1.0f) * ((j % 16 >= 12) ? 3.0f : 1.0f);
+
+                snprintf(text, sizeof(text), ",%.9g", value);
+
+                manifest += text;
+
+                expected.Matrices.push_back(strtof(text + 1, nullptr));
+            }
+
+            manifest += "\n";
+        }
+
+        return manifest;
+    }
+
+    bool ReadWithCsvReader(
+        const std::string& manifest,
+        FrameColumns& columns)
+    {
+        Io::CsvReader reader(manifest.data(), manifest.size());
+
+        bool headerSeen = false;
+
+        while (reader.ReadRecord())
+        {
+            if (c_numberOfColumns != reader.GetFieldCount())
+            {
+                return false;
+            }
+
+            if (!headerSeen)
+            {
+                headerSeen = true;
+
+                continue;
+            }
+
+            columns.Timestamps.push_back(reader.GetUInt64(0));
+            columns.ImageFileNames.push_back(reader.GetField(1).ToString());
+
+            const size_t matrixOffset = columns.Matrices.size();
+
+            columns.Matrices.resize(matrixOffset + c_numberOfMatrixValues);
+
+            reader.GetFloats(2, c_numberOfMatrixValues, columns.Matrices.data() + matrixOffset);
+        }
+
+        return true;
+    }
+
+    //
+    // BatchProcessing before it used Io::CsvReader: the file is copied into a
+    // string stream, each line into a tokenizer buffer, and each field into a
+    // string before it is converted.
+    //
+    bool ReadWithStreams(
+        const std::string& manifest,
+        FrameColumns& columns)
+    {
+        std::istringstream stream(std::string(manifest.begin(), manifest.end()));
+
+        std::string line;
+        std::vector<char> tokenizerBuffer;
+
+        bool headerSeen = false;
+
+        while (std::getline(stream, line))
+        {
+            tokenizerBuffer.assign(line.begin(), line.end());
+            tokenizerBuffer.push_back('\0');
+
+            std::vector<std::string> tokens;
+
+            char* context = nullptr;
+
+            for (char* token = strtok_r(tokenizerBuffer.data(), ",", &context);
+                 nullptr != token;
+                 token = strtok_r(nullptr, ",", &context))
+            {
+                tokens.push_back(token);
+            }
+
+            if (c_numberOfColumns != tokens.size())
+            {
+                return false;
+            }
+
+            if (!headerSeen)
+            {
+                headerSeen = true;
+
+                continue;
+            }
+
+            columns.Timestamps.push_back(strtoull(tokens[0].c_str(), nullptr, 10));
+            columns.ImageFileNames.push_back(tokens[1]);
+
+            for (size_t j = 0; j < c_numberOfMatrixValues; ++j)
+            {
+                columns.Matrices.push_back(static_cast<float>(atof(tokens[2 + j].c_str())));
+            }
+        }
+
+        return true;
+    }
+
+    bool IsSame(
+        const FrameColumns& expected,
+        const FrameColumns& actual)
+    {
+        return
+            expected.Timestamps == actual.Timestamps &&
+            expected.ImageFileNames == actual.ImageFileNames &&
+            expected.Matrices.size() == actual.Matrices.size() &&
+            0 == memcmp(expected.Matrices.data(), actual.Matrices.data(), expected.Matrices.size() * sizeof(float));
+    }
+
+    //
+    // Comments, empty lines, carriage returns, trailing whitespace, empty
+    // fields and a last line without a newline, in buffers of every length
+    // around the 16 byte blocks the delimiters are searched in.
+    //
+    bool CheckCsvReaderEdgeCases()
+    {
+        bool passed = true;
+
+        for (size_t padding = 0; padding < 40; ++padding)
+        {
+            std::string text =
+                "# comment, with a delimiter\r\n"
+                "\r\n" +
+                std::string(padding, 'a') + ",1,-2,3.5\r\n"
+                "\n"
+                "  \t\n"
+                "x,,y  \t\r\n"
+                "last,42";
+
+            Io::CsvReader reader(text.data(), text.size());
+
+            bool isSame =
+                reader.ReadRecord() &&
+                4 == reader.GetFieldCount() &&
+                reader.GetField(0).ToString() == std::string(padding, 'a') &&
+                1 == reader.GetUInt64(1) &&
+                -2 == reader.GetInt64(2) &&
+                3.5f == reader.GetFloat(3);
+
+            isSame = isSame &&
+                reader.ReadRecord() &&
+                3 == reader.GetFieldCount() &&
+                reader.GetField(0) == "x" &&
+                reader.GetField(1) == "" &&
+                reader.GetField(2) == "y";
+
+            isSame = isSame &&
+                reader.ReadRecord() &&
+                2 == reader.GetFieldCount() &&
+                reader.GetField(0) == "last" &&
+                42.0 == reader.GetDouble(1) &&
+                !reader.ReadRecord();
+
+            if (!isSame)
+            {
+                printf("CsvReader misreads the edge cases after %zu bytes of padding\n", padding);
+                passed = false;
+            }
+        }
+
+        //
+        // Fields that do not hold numbers of the requested type throw.
+        //
+        const char text[] = "abc,1.5,-1,18446744073709551616\n";
+
+        Io::CsvReader reader(text, sizeof(text) - 1);
+
+        reader.ReadRecord();
+
+        for (size_t index = 0; index < 4; ++index)
+        {
+            bool threw = false;
+
+            try
+            {
+                if (0 == index)
+                {
+                    reader.GetFloat(index);
+                }
+                else
+                {
+                    reader.GetUInt64(index);
+                }
+            }
+            catch (const std::exception&)
+            {
+                threw = true;
+            }
+
+            if (!threw)
+            {
+                printf("CsvReader accepts field %zu of '%.*s' as a number\n", index, static_cast<int>(sizeof(text) - 2), text);
+                passed = false;
+            }
+        }
+
+        return passed;
+    }
+
+    bool CheckParsedNumber(
+        const char* text)
+    {
+        const char* last = text + strlen(text);
+
+        float floatValue = 0.0f;
+        double doubleValue = 0.0;
+
+        const bool floatParsed = Io::ParseFloat(text, last, &floatValue);
+        const bool doubleParsed = Io::ParseDouble(text, last, &doubleValue);
+
+        const float expectedFloat = strtof(text, nullptr);
+        const double expectedDouble = strtod(text, nullptr);
+
+        const bool isSame =
+            floatParsed && doubleParsed &&
+            0 == memcmp(&floatValue, &expectedFloat, sizeof(float)) &&
+            0 == memcmp(&doubleValue, &expectedDouble, sizeof(double));
+
+        if (!isSame)
+        {
+            printf(
+                "'%s': ParseFloat %.9g, strtof %.9g, ParseDouble %.17g, strtod %.17g\n",
+                text,
+                floatValue,
+                expectedFloat,
+                doubleValue,
+                expectedDouble);
+        }
+
+        return isSame;
+    }
+
+    bool CheckNumberParsing(
+        const uint64_t numberOfRandomNumbers)
+    {
+        bool passed = true;
+
+        const char* specialNumbers[] =
+        {
+            "0", "-0", "1", "-1", "0.1", "0.3", "1e-7", "123456.7", "1e7", "1E+8",
+            "16777216", "16777217", "3.4028235e38", "1.17549435e-38", "1.4e-45",
+            "9007199254740993", "2.2250738585072014e-308", "4.9e-324", "1.7976931348623157e308",
+            "0.000000000000000000000000000000000000001", "123456789012345678901234567890",
+            ".5", "5.", "+2.5", "1e400", "-1e-400", "inf", "-inf", "nan",
+        };
+
+        for (const char* text : specialNumbers)
+        {
+            passed = CheckParsedNumber(text) && passed;
+        }
+
+        //
+        // Numbers that are not entirely consumed, or not numbers at all, fail.
+        //
+        const char* invalidNumbers[] =
+        {
+            "", "-", "+", ".", "e5", "1e", "1e+", "1.5x", " 1", "\t1", "1 ", "0x10", "-0X1p3", "--1",
+        };
+
+        for (const char* text : invalidNumbers)
+        {
+            float floatValue;
+            double doubleValue;
+
+            if (Io::ParseFloat(text, text + strlen(text), &floatValue) ||
+                Io::ParseDouble(text, text + strlen(text), &doubleValue))
+            {
+                printf("'%s' is parsed as a number\n", text);
+                passed = false;
+            }
+        }
+
+        uint64_t integer = 0;
+
+        bool integersPassed =
+            Io::ParseUInt64("18446744073709551615", "18446744073709551615" + 20, &integer) &&
+            UINT64_MAX == integer &&
+            !Io::ParseUInt64("18446744073709551616", "18446744073709551616" + 20, &integer);
+
+        int64_t signedInteger = 0;
+
+        integersPassed = integersPassed &&
+            Io::ParseInt64("-9223372036854775808", "-9223372036854775808" + 20, &signedInteger) &&
+            INT64_MIN == signedInteger &&
+            !Io::ParseInt64("9223372036854775808", "9223372036854775808" + 19, &signedInteger);
+
+        if (!integersPassed)
+        {
+            printf("the integer parsers mishandle the limits\n");
+            passed = false;
+        }
+
+        //
+        // Random floats and doubles printed with a random number of digits,
+        // which exercises the exact fast path as well as the fallback.
+        //
+        uint64_t random = 42;
+        uint64_t mismatches = 0;
+
+        for (uint64_t i = 0; i < numberOfRandomNumbers && mismatches < 10; ++i)
+        {
+            const uint64_t bits =
+                static_cast<uint64_t>(NextRandom(random)) << 32 | NextRandom(random);
+
+            double value;
+
+            if (0 == i % 2)
+            {
+                memcpy(&value, &bits, sizeof(value));
+            }
+            else
+            {
+                float floatValue;
+                const uint32_t floatBits = static_cast<uint32_t>(bits);
+                memcpy(&floatValue, &floatBits, sizeof(floatValue));
+                value = floatValue;
+            }
+
+            if (!std::isfinite(value))
+            {
+                continue;
+            }
+
+            const char* formats[] = { "%.*g", "%.*e", "%.*f" };
+
+            char text[512];
+
+            snprintf(
+                text,
+                sizeof(text),
+                formats[(bits >> 40) % 3],
+                static_cast<int>(1 + (bits >> 48) % 18),
+                value);
+
+            if (!CheckParsedNumber(text))
+            {
+                ++mismatches;
+            }
+        }
+
+        return passed && 0 == mismatches;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t numberOfRows =
+        (argc > 1) ? static_cast<size_t>(atoll(argv[1])) : 1000000;
+
+    const uint64_t numberOfRandomNumbers =
+        (argc > 2) ? static_cast<uint64_t>(atoll(argv[2])) : 1000000;
+
+    const bool parsingPassed =
+        CheckNumberParsing(numberOfRandomNumbers) && CheckCsvReaderEdgeCases();
+
+    printf(
+        "number parsing and edge cases: %s (%llu random numbers compared with strtof and strtod)\n",
+        parsingPassed ? "match the C runtime" : "FAILED",
+        static_cast<unsigned long long>(numberOfRandomNumbers));
+
+    FrameColumns expected;
+
+    const std::string manifest =
+        CreateManifest(numberOfRows, expected);
+
+    FrameColumns columns;
+
+    const Clock::time_point streamsStartTime = Clock::now();
+
+    const bool streamsPassed =
+        ReadWithStreams(manifest, columns) && IsSame(expected, columns);
+
+    const double streamsSeconds =
+        std::chrono::duration<double>(Clock::now() - streamsStartTime).count();
+
+    columns.Clear();
+
+    const Clock::time_point readerStartTime = Clock::now();
+
+    const bool readerPassed =
+        ReadWithCsvReader(manifest, columns) && IsSame(expected, columns);
+
+    const double readerSeconds =
+        std::chrono::duration<double>(Clock::now() - readerStartTime).count();
+
+    printf(
+        "pv.csv of %zu rows of 50 columns (%.1f MB):\n  getline, strtok and atof: %.0f rows/s%s\n  Io::CsvReader: %.0f rows/s (%.1fx, %.0f MB/s)%s\n",
+        numberOfRows,
+        manifest.size() / 1e6,
+        numberOfRows / streamsSeconds,
+        streamsPassed ? "" : ", values differ",
+        numberOfRows / readerSeconds,
+        streamsSeconds / readerSeconds,
+        manifest.size() / 1e6 / readerSeconds,
+        readerPassed ? "" : ", values differ");
+
+    const bool passed = parsingPassed && readerPassed;
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,441 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks the number formatting of the Shared/Io library, which the recorder's
+// CsvWriter uses, against the C++17 standard library: Io::FormatFloat must
+// produce the same text as std::to_chars, the integers the same as printf,
+// and Io::FormatDouble must parse back to the same double. Then measures the
+// rows per second written for the recorder's 50 column frame schema, against
+// the std::wofstream and std::endl path the recorder used before.
+//
+// Usage: csv_writer_benchmark [rows] [random floats to check]
+//
+
+#include <Io/NumberFormatting.h>
+
+#include <charconv>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t c_numberOfMatrixValues = 48;
+
+    // Room for the sensor folder and the file name of a frame.
+    const size_t c_maximumFileNameLength = 260;
+
+    struct FrameRecord
+    {
+        uint64_t Timestamp;
+        std::string ImageFileName;
+        float Matrices[c_numberOfMatrixValues];
+    };
+
+    uint32_t NextRandom(
+        uint64_t& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    bool CheckFloat(
+        const float value)
+    {
+        char expected[64];
+        char actual[Io::MaxFormattedFloatLength];
+
+        const std::to_chars_result result =
+            std::to_chars(expected, expected + sizeof(expected), value);
+
+        const size_t expectedLength =
+            static_cast<size_t>(result.ptr - expected);
+
+        const size_t actualLength =
+            Io::FormatFloat(value, actual);
+
+        if (expectedLength != actualLength || 0 != memcmp(expected, actual, actualLength))
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            printf(
+                "FormatFloat(0x%08x): '%.*s', std::to_chars: '%.*s'\n",
+                bits,
+                static_cast<int>(actualLength),
+                actual,
+                static_cast<int>(expectedLength),
+                expected);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CheckNumberFormatting(
+        const uint64_t numberOfRandomFloats)
+    {
+        bool passed = true;
+
+        //
+        // Floats: special values, powers of ten and of two, and random bit
+        // patterns. NaNs are formatted without their payload, like to_chars.
+        //
+        const float specialValues[] =
+        {
+            0.0f, -0.0f, 1.0f, -1.0f, 0.1f, 0.3f, 1e-7f, 123456.7f, 1e7f, 1e8f,
+            16777216.0f, 3.4028235e38f, 1.17549435e-38f, 1.4e-45f,
+            std::numeric_limits<float>::infinity(),
+            -std::numeric_limits<float>::infinity(),
+            std::numeric_limits<float>::quiet_NaN(),
+        };
+
+        for (const float value : specialValues)
+        {
+            passed = CheckFloat(value) && passed;
+        }
+
+        for (int32_t exponent = -45; exponent <= 38; ++exponent)
+        {
+            passed = CheckFloat(std::pow(10.0f, static_cast<float>(exponent))) && passed;
+            passed = CheckFloat(std::ldexp(1.0f, exponent * 3)) && passed;
+        }
+
+        uint64_t random = 42;
+        uint64_t mismatches = 0;
+
+        for (uint64_t i = 0; i < numberOfRandomFloats && mismatches < 10; ++i)
+        {
+            const uint32_t bits = NextRandom(random);
+
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+
+            if (std::isnan(value))
+            {
+                continue;
+            }
+
+            if (!CheckFloat(value))
+            {
+                ++mismatches;
+            }
+        }
+
+        passed = passed && 0 == mismatches;
+
+        //
+        // Integers, including the extremes and all lengths.
+        //
+        std::vector<uint64_t> integers =
+        {
+            0, 1, 9, 10, 99, 100, UINT64_MAX, static_cast<uint64_t>(INT64_MAX),
+            static_cast<uint64_t>(INT64_MIN),
+        };
+
+        for (uint64_t power = 1; power <= 10000000000000000000ULL / 10; power *= 10)
+        {
+            integers.push_back(power * 10 - 1);
+            integers.push_back(power * 10);
+        }
+
+        for (int i = 0; i < 100000; ++i)
+        {
+            integers.push_back(
+                (static_cast<uint64_t>(NextRandom(random)) << 32 | NextRandom(random)) >> (i % 64));
+        }
+
+        for (const uint64_t integer : integers)
+        {
+            char expected[32];
+            char actual[Io::MaxFormattedIntegerLength + 1];
+
+            int expectedLength = snprintf(expected, sizeof(expected), "%" PRIu64, integer);
+            size_t actualLength = Io::FormatUInt64(integer, actual);
+
+            bool isSame =
+                static_cast<size_t>(expectedLength) == actualLength &&
+                0 == memcmp(expected, actual, actualLength);
+
+            const int64_t signedInteger = static_cast<int64_t>(integer);
+
+            expectedLength = snprintf(expected, sizeof(expected), "%" PRId64, signedInteger);
+            actualLength = Io::FormatInt64(signedInteger, actual);
+
+            isSame = isSame &&
+                static_cast<size_t>(expectedLength) == actualLength &&
+                0 == memcmp(expected, actual, actualLength);
+
+            if (!isSame)
+            {
+                printf("FormatUInt64/FormatInt64(%" PRIu64 ") differ from printf\n", integer);
+                passed = false;
+            }
+        }
+
+        //
+        // Doubles parse back to the same value.
+        //
+        for (int i = 0; i < 100000; ++i)
+        {
+            const uint64_t bits =
+                static_cast<uint64_t>(NextRandom(random)) << 32 | NextRandom(random);
+
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+
+            if (!std::isfinite(value))
+            {
+                continue;
+            }
+
+            char text[Io::MaxFormattedDoubleLength + 1];
+
+            const size_t length = Io::FormatDouble(value, text);
+
+            text[length] = '\0';
+
+            if (strtod(text, nullptr) != value)
+            {
+                printf("FormatDouble(%.17g) does not round trip: '%s'\n", value, text);
+                passed = false;
+                break;
+            }
+        }
+
+        return passed;
+    }
+
+    std::vector<FrameRecord> CreateFrameRecords(
+        const size_t numberOfRecords)
+    {
+        std::vector<FrameRecord> records(numberOfRecords);
+
+        uint64_t random = 7;
+
+        for (size_t i = 0; i < numberOfRecords; ++i)
+        {
+            FrameRecord& record = records[i];
+
+            record.Timestamp = 131000000000000000ULL + i * 333333ULL;
+
+            char fileName[64];
+
+            snprintf(
+                fileName,
+                sizeof(fileName),
+                "vlc_ll\\%020llu.pgm",
+                static_cast<unsigned long long>(record.Timestamp));
+
+            record.ImageFileName = fileName;
+
+            //
+            // Rotations, translations in meters and projections, like the
+            // poses of a head moving around a room.
+            //
+            for (size_t j = 0; j < c_numberOfMatrixValues; ++j)
+            {
+                const float unit =
+                    static_cast<float>(NextRandom(random)) / 4294967296.0f;
+
+                record.Matrices[j] =
+                    (3 == j % 4) ? 0.0f :
+                    (15 == j % 16) ? 1.0f :
+                    (2.0f * unit - 1.0f) * ((j % 16 >= 12) ? 3.0f : 1.0f);
+            }
+        }
+
+        return records;
+    }
+
+    //
+    // The recorder's CsvWriter before it buffered its output.
+    //
+    void WriteWithStreams(
+        const std::vector<FrameRecord>& records,
+        const char* fileName)
+    {
+        std::wofstream file(fileName);
+
+        for (const FrameRecord& record : records)
+        {
+            file << record.Timestamp;
+            file << L"," << std::wstring(record.ImageFileName.begin(), record.ImageFileName.end());
+
+            for (const float value : record.Matrices)
+            {
+                file << L"," << value;
+            }
+
+            file << std::endl;
+        }
+    }
+
+    //
+    // The recorder's CsvWriter now: formats into a 64 KB buffer written to the
+    // file when it is full.
+    //
+    void WriteWithBuffer(
+        const std::vector<FrameRecord>& records,
+        const char* fileName)
+    {
+        FILE* file = fopen(fileName, "wb");
+
+        std::vector<char> buffer(64 * 1024);
+        size_t bufferedSize = 0;
+
+        const size_t maximumRowLength =
+            Io::MaxFormattedIntegerLength + 1 + c_maximumFileNameLength + c_numberOfMatrixValues * (1 + Io::MaxFormattedFloatLength) + 1;
+
+        for (const FrameRecord& record : records)
+        {
+            if (buffer.size() - bufferedSize < maximumRowLength)
+            {
+                fwrite(buffer.data(), 1, bufferedSize, file);
+                bufferedSize = 0;
+            }
+
+            char* output = buffer.data();
+
+            bufferedSize += Io::FormatUInt64(record.Timestamp, output + bufferedSize);
+
+            output[bufferedSize++] = ',';
+
+            memcpy(output + bufferedSize, record.ImageFileName.data(), record.ImageFileName.size());
+            bufferedSize += record.ImageFileName.size();
+
+            for (const float value : record.Matrices)
+            {
+                output[bufferedSize++] = ',';
+                bufferedSize += Io::FormatFloat(value, output + bufferedSize);
+            }
+
+            output[bufferedSize++] = '\n';
+        }
+
+        fwrite(buffer.data(), 1, bufferedSize, file);
+        fclose(file);
+    }
+
+    //
+    // Checks that the matrices of the written file parse back exactly.
+    //
+    bool CheckWrittenFile(
+        const std::vector<FrameRecord>& records,
+        const char* fileName)
+    {
+        FILE* file = fopen(fileName, "rb");
+
+        if (nullptr == file)
+        {
+            return false;
+        }
+
+        std::vector<char> line(4096);
+        size_t rowIndex = 0;
+        bool passed = true;
+
+        while (passed && nullptr != fgets(line.data(), static_cast<int>(line.size()), file))
+        {
+            passed = rowIndex < records.size();
+
+            if (!passed)
+            {
+                break;
+            }
+
+            const FrameRecord& record = records[rowIndex++];
+
+            char* position = line.data();
+
+            passed = strtoull(position, &position, 10) == record.Timestamp;
+            position = strchr(position + 1, ',');
+
+            for (size_t j = 0; passed && j < c_numberOfMatrixValues; ++j)
+            {
+                passed = nullptr != position && strtof(position + 1, &position) == record.Matrices[j];
+            }
+        }
+
+        fclose(file);
+
+        return passed && rowIndex == records.size();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t numberOfRows =
+        (argc > 1) ? static_cast<size_t>(atoll(argv[1])) : 100000;
+
+    const uint64_t numberOfRandomFloats =
+        (argc > 2) ? static_cast<uint64_t>(atoll(argv[2])) : 10000000;
+
+    const bool formattingPassed =
+        CheckNumberFormatting(numberOfRandomFloats);
+
+    printf(
+        "number formatting: %s (%llu random floats compared with std::to_chars)\n",
+        formattingPassed ? "matches the standard library" : "FAILED",
+        static_cast<unsigned long long>(numberOfRandomFloats));
+
+    const std::vector<FrameRecord> records =
+        CreateFrameRecords(numberOfRows);
+
+    const char* fileName = "csv_writer_benchmark.csv";
+
+    const Clock::time_point streamsStartTime = Clock::now();
+
+    WriteWithStreams(records, fileName);
+
+    const double streamsSeconds =
+        std::chrono::duration<double>(Clock::now() - streamsStartTime).count();
+
+    const Clock::time_point bufferStartTime = Clock::now();
+
+    WriteWithBuffer(records, fileName);
+
+    const double bufferSeconds =
+        std::chrono::duration<double>(Clock::now() - bufferStartTime).count();
+
+    const bool filePassed =
+        CheckWrittenFile(records, fileName);
+
+    remove(fileName);
+
+    printf(
+        "%zu rows of 50 columns:\n  wofstream and endl: %.0f rows/s\n  buffered Io formatting: %.0f rows/s (%.1fx)%s\n",
+        numberOfRows,
+        numberOfRows / streamsSeconds,
+        numberOfRows / bufferSeconds,
+        streamsSeconds / bufferSeconds,
+        filePassed ? "" : ", values do not parse back");
+
+    const bool passed = formattingPassed && filePassed;
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,598 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Streams synthetic frames over UDP on the loopback interface, through a relay
+// that loses, duplicates and reorders datagrams, and checks what the
+// DatagramReceiver makes of it: frames must arrive intact and in order, the
+// frames that lost a datagram must be dropped by their deadline, and the
+// others must make it through, as many as the loss rate allows.
+//
+// Usage: datagram_loopback_test [loss %] [reorder %] [duplicate %] [frames] [deadline in ms]
+//
+// Reordered datagrams are held back by the relay for up to 10 milliseconds.
+//
+
+#include "DatagramReceiver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // A short throw depth frame: 448x450, 16 bits per pixel, 280 datagrams.
+    const uint32_t c_imageWidth = 448;
+    const uint32_t c_imageHeight = 450;
+    const uint32_t c_pixelStride = 2;
+
+    const double c_framesPerSecond = 30.0;
+
+    const std::chrono::milliseconds c_maximumReorderDelay(10);
+
+    struct Impairments
+    {
+        double LossProbability;
+        double ReorderProbability;
+        double DuplicateProbability;
+    };
+
+    struct RelayStatistics
+    {
+        std::atomic<uint64_t> DatagramsRelayed;
+        std::atomic<uint64_t> DatagramsLost;
+        std::atomic<uint64_t> DatagramsReordered;
+        std::atomic<uint64_t> DatagramsDuplicated;
+    };
+
+    int BindLoopbackSocket(
+        uint16_t* port)
+    {
+        const int udpSocket =
+            socket(AF_INET, SOCK_DGRAM, 0);
+
+        sockaddr_in address = {};
+
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t addressLength = sizeof(address);
+
+        if (udpSocket < 0 ||
+            0 != bind(udpSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) ||
+            0 != getsockname(udpSocket, reinterpret_cast<sockaddr*>(&address), &addressLength))
+        {
+            perror("failed to bind a loopback socket");
+            exit(EXIT_FAILURE);
+        }
+
+        const int bufferSize = 8 * 1024 * 1024;
+
+        setsockopt(udpSocket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        setsockopt(udpSocket, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+
+        *port = ntohs(address.sin_port);
+
+        return udpSocket;
+    }
+
+    sockaddr_in GetLoopbackAddress(
+        uint16_t port)
+    {
+        sockaddr_in address = {};
+
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+
+        return address;
+    }
+
+    uint8_t GetPatternByte(
+        uint64_t frameIndex,
+        size_t offset)
+    {
+        return static_cast<uint8_t>(offset * 131 + frameIndex * 7);
+    }
+
+    //
+    // Waits for a subscription, then sends frameCount frames to the subscriber.
+    // The timestamp of each frame is its index; its payload starts with the
+    // index and the send time, followed by a pattern derived from the index.
+    //
+    void Send(
+        int senderSocket,
+        uint64_t frameCount,
+        std::atomic<bool>* stopping)
+    {
+        sockaddr_in subscriber = {};
+        socklen_t subscriberLength = 0;
+
+        while (!*stopping && 0 == subscriberLength)
+        {
+            pollfd descriptor = { senderSocket, POLLIN, 0 };
+
+            if (poll(&descriptor, 1, 100) <= 0)
+            {
+                continue;
+            }
+
+            uint8_t subscription[4];
+            sockaddr_in address = {};
+            socklen_t addressLength = sizeof(address);
+
+            const ssize_t bytesReceived =
+                recvfrom(senderSocket, subscription, sizeof(subscription), 0, reinterpret_cast<sockaddr*>(&address), &addressLength);
+
+            const uint32_t cookie =
+                subscription[0] |
+                (subscription[1] << 8) |
+                (subscription[2] << 16) |
+                (static_cast<uint32_t>(subscription[3]) << 24);
+
+            if (sizeof(subscription) == bytesReceived &&
+                Io::DatagramSubscribeCookie == cookie)
+            {
+                subscriber = address;
+                subscriberLength = addressLength;
+            }
+        }
+
+        SensorStream::FrameHeader header = {};
+
+        header.Cookie = SensorStream::ProtocolCookie;
+        header.VersionMajor = SensorStream::ProtocolVersionMajor;
+        header.VersionMinor = SensorStream::ProtocolVersionMinor;
+        header.FrameType = 2 /* ShortThrowToFDepth */;
+        header.ImageWidth = c_imageWidth;
+        header.ImageHeight = c_imageHeight;
+        header.PixelStride = c_pixelStride;
+        header.RowStride = c_imageWidth * c_pixelStride;
+        header.PayloadCodec = SensorStream::Codec::Raw;
+        header.PayloadLength = header.ImageHeight * header.RowStride;
+
+        std::vector<uint8_t> frame(
+            SensorStream::ProtocolHeaderLength + SensorStream::ProtocolMaximumExtendedHeaderLength + header.PayloadLength);
+
+        Io::DatagramFragmenter fragmenter;
+
+        const Clock::time_point startTime = Clock::now();
+
+        for (uint64_t frameIndex = 0; frameIndex < frameCount && !*stopping; ++frameIndex)
+        {
+            std::this_thread::sleep_until(
+                startTime + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(frameIndex / c_framesPerSecond)));
+
+            header.Timestamp = frameIndex;
+
+            const size_t headerLength =
+                SensorStream::WriteHeader(header, frame.data());
+
+            uint8_t* payload = frame.data() + headerLength;
+
+            for (size_t offset = 0; offset < header.PayloadLength; ++offset)
+            {
+                payload[offset] = GetPatternByte(frameIndex, offset);
+            }
+
+            const uint64_t sendTime =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now().time_since_epoch()).count();
+
+            memcpy(payload, &frameIndex, sizeof(frameIndex));
+            memcpy(payload + sizeof(frameIndex), &sendTime, sizeof(sendTime));
+
+            fragmenter.Fragment(
+                frame.data(),
+                headerLength + header.PayloadLength,
+                sendTime,
+                [&](const uint8_t* datagram, size_t size)
+                {
+                    sendto(senderSocket, datagram, size, 0, reinterpret_cast<const sockaddr*>(&subscriber), subscriberLength);
+                });
+        }
+    }
+
+    //
+    // Forwards the subscriptions of the receiver to the sender, and the frames
+    // of the sender to the receiver, impairing the latter.
+    //
+    void Relay(
+        int relaySocket,
+        uint16_t senderPort,
+        const Impairments& impairments,
+        RelayStatistics* statistics,
+        std::atomic<bool>* stopping)
+    {
+        struct HeldDatagram
+        {
+            Clock::time_point ReleaseTime;
+            std::vector<uint8_t> Data;
+        };
+
+        const sockaddr_in sender =
+            GetLoopbackAddress(senderPort);
+
+        sockaddr_in receiver = {};
+        bool hasReceiver = false;
+
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<double> probability(0.0, 1.0);
+        std::uniform_int_distribution<int> reorderDelayInMicroseconds(1, static_cast<int>(c_maximumReorderDelay.count() * 1000));
+
+        std::vector<HeldDatagram> heldDatagrams;
+        std::vector<uint8_t> datagram(64 * 1024);
+
+        const auto forward =
+            [&](const uint8_t* data, size_t size)
+            {
+                sendto(relaySocket, data, size, 0, reinterpret_cast<const sockaddr*>(&receiver), sizeof(receiver));
+
+                ++statistics->DatagramsRelayed;
+            };
+
+        while (!*stopping)
+        {
+            const Clock::time_point now = Clock::now();
+
+            //
+            // Release the held back datagrams that are due, in order.
+            //
+            std::sort(
+                heldDatagrams.begin(),
+                heldDatagrams.end(),
+                [](const HeldDatagram& a, const HeldDatagram& b) { return a.ReleaseTime < b.ReleaseTime; });
+
+            size_t released = 0;
+
+            while (released < heldDatagrams.size() && heldDatagrams[released].ReleaseTime <= now)
+            {
+                forward(heldDatagrams[released].Data.data(), heldDatagrams[released].Data.size());
+
+                ++released;
+            }
+
+            heldDatagrams.erase(
+                heldDatagrams.begin(),
+                heldDatagrams.begin() + released);
+
+            int timeoutInMilliseconds = 10;
+
+            if (!heldDatagrams.empty())
+            {
+                timeoutInMilliseconds = static_cast<int>(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(heldDatagrams.front().ReleaseTime - now).count()) + 1;
+            }
+
+            pollfd descriptor = { relaySocket, POLLIN, 0 };
+
+            if (poll(&descriptor, 1, timeoutInMilliseconds) <= 0)
+            {
+                continue;
+            }
+
+            for (;;)
+            {
+                sockaddr_in address = {};
+                socklen_t addressLength = sizeof(address);
+
+                const ssize_t bytesReceived =
+                    recvfrom(relaySocket, datagram.data(), datagram.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&address), &addressLength);
+
+                if (bytesReceived < 0)
+                {
+                    break;
+                }
+
+                const size_t size = static_cast<size_t>(bytesReceived);
+
+                if (address.sin_port != sender.sin_port)
+                {
+                    receiver = address;
+                    hasReceiver = true;
+
+                    sendto(relaySocket, datagram.data(), size, 0, reinterpret_cast<const sockaddr*>(&sender), sizeof(sender));
+
+                    continue;
+                }
+
+                if (!hasReceiver)
+                {
+                    continue;
+                }
+
+                if (probability(random) < impairments.LossProbability)
+                {
+                    ++statistics->DatagramsLost;
+
+                    continue;
+                }
+
+                const int copies =
+                    (probability(random) < impairments.DuplicateProbability) ? 2 : 1;
+
+                if (2 == copies)
+                {
+                    ++statistics->DatagramsDuplicated;
+                }
+
+                for (int copy = 0; copy < copies; ++copy)
+                {
+                    if (probability(random) < impairments.ReorderProbability)
+                    {
+                        ++statistics->DatagramsReordered;
+
+                        HeldDatagram heldDatagram;
+
+                        heldDatagram.ReleaseTime = Clock::now() + std::chrono::microseconds(reorderDelayInMicroseconds(random));
+                        heldDatagram.Data.assign(datagram.data(), datagram.data() + size);
+
+                        heldDatagrams.push_back(
+                            std::move(heldDatagram));
+                    }
+                    else
+                    {
+                        forward(datagram.data(), size);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    Impairments impairments;
+
+    impairments.LossProbability = ((argc > 1) ? atof(argv[1]) : 0.05) / 100.0;
+    impairments.ReorderProbability = ((argc > 2) ? atof(argv[2]) : 5.0) / 100.0;
+    impairments.DuplicateProbability = ((argc > 3) ? atof(argv[3]) : 1.0) / 100.0;
+
+    const uint64_t frameCount =
+        (argc > 4) ? strtoull(argv[4], nullptr, 10) : 150;
+
+    const std::chrono::milliseconds deadline(
+        (argc > 5) ? atoi(argv[5]) : 50);
+
+    uint16_t senderPort = 0;
+    uint16_t relayPort = 0;
+
+    const int senderSocket = BindLoopbackSocket(&senderPort);
+    const int relaySocket = BindLoopbackSocket(&relayPort);
+
+    RelayStatistics relayStatistics = {};
+    std::atomic<bool> stopping(false);
+
+    std::thread relayThread(
+        Relay,
+        relaySocket,
+        senderPort,
+        impairments,
+        &relayStatistics,
+        &stopping);
+
+    SensorStream::FrameBufferPool pool(
+        4 /* frameCount */,
+        c_imageWidth * c_imageHeight * c_pixelStride /* payloadCapacity */);
+
+    SensorStream::DatagramReceiver receiver(
+        pool,
+        deadline);
+
+    if (!receiver.Connect("127.0.0.1", relayPort))
+    {
+        fprintf(stderr, "failed to connect to the relay: %s\n", receiver.GetError().c_str());
+
+        return EXIT_FAILURE;
+    }
+
+    uint64_t framesIntact = 0;
+    uint64_t framesCorrupted = 0;
+    uint64_t framesOutOfOrder = 0;
+    double totalLatencyInSeconds = 0.0;
+    double maximumLatencyInSeconds = 0.0;
+
+    std::thread receiverThread(
+        [&]()
+        {
+            uint64_t nextTimestamp = 0;
+
+            for (;;)
+            {
+                SensorStream::FramePtr frame = receiver.ReceiveFrame();
+
+                if (nullptr == frame)
+                {
+                    return;
+                }
+
+                const uint64_t receiveTime =
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        Clock::now().time_since_epoch()).count();
+
+                const SensorStream::FrameHeader& header = frame->Header;
+
+                uint64_t frameIndex = 0;
+                uint64_t sendTime = 0;
+
+                memcpy(&frameIndex, frame->Payload, sizeof(frameIndex));
+                memcpy(&sendTime, frame->Payload + sizeof(frameIndex), sizeof(sendTime));
+
+                bool isIntact =
+                    frameIndex == header.Timestamp &&
+                    header.PayloadLength == c_imageWidth * c_imageHeight * c_pixelStride;
+
+                for (size_t offset = 2 * sizeof(uint64_t); isIntact && offset < header.PayloadLength; ++offset)
+                {
+                    isIntact = frame->Payload[offset] == GetPatternByte(frameIndex, offset);
+                }
+
+                if (!isIntact)
+                {
+                    ++framesCorrupted;
+
+                    continue;
+                }
+
+                ++framesIntact;
+
+                if (header.Timestamp < nextTimestamp)
+                {
+                    ++framesOutOfOrder;
+                }
+
+                nextTimestamp = header.Timestamp + 1;
+
+                const double latencyInSeconds =
+                    (receiveTime - sendTime) * 1e-6;
+
+                totalLatencyInSeconds += latencyInSeconds;
+                maximumLatencyInSeconds = std::max(maximumLatencyInSeconds, latencyInSeconds);
+            }
+        });
+
+    Send(
+        senderSocket,
+        frameCount,
+        &stopping);
+
+    //
+    // Let the last frames arrive, or reach their deadline.
+    //
+    std::this_thread::sleep_for(
+        c_maximumReorderDelay + 2 * deadline);
+
+    receiver.Close();
+    receiverThread.join();
+
+    stopping = true;
+    relayThread.join();
+
+    close(senderSocket);
+    close(relaySocket);
+
+    const SensorStream::DatagramReceiverStatistics statistics =
+        receiver.GetStatistics();
+
+    const Io::DatagramReassemblyStatistics& datagrams =
+        statistics.Datagrams;
+
+    printf(
+        "relay: %llu datagrams relayed, %llu lost, %llu reordered, %llu duplicated\n",
+        static_cast<unsigned long long>(relayStatistics.DatagramsRelayed),
+        static_cast<unsigned long long>(relayStatistics.DatagramsLost),
+        static_cast<unsigned long long>(relayStatistics.DatagramsReordered),
+        static_cast<unsigned long long>(relayStatistics.DatagramsDuplicated));
+
+    printf(
+        "receiver: %llu datagrams received, %llu lost, %llu reordered, %llu duplicated, %llu late, %llu malformed; jitter %.3f ms\n",
+        static_cast<unsigned long long>(datagrams.DatagramsReceived),
+        static_cast<unsigned long long>(datagrams.DatagramsLost),
+        static_cast<unsigned long long>(datagrams.DatagramsReordered),
+        static_cast<unsigned long long>(datagrams.DatagramsDuplicated),
+        static_cast<unsigned long long>(datagrams.DatagramsLate),
+        static_cast<unsigned long long>(datagrams.DatagramsMalformed),
+        1e3 * datagrams.JitterInSeconds);
+
+    printf(
+        "frames: %llu sent, %llu received (%llu intact, %llu corrupted, %llu out of order), %llu dropped by the reassembler, %llu by the receiver\n",
+        static_cast<unsigned long long>(frameCount),
+        static_cast<unsigned long long>(statistics.FramesReceived),
+        static_cast<unsigned long long>(framesIntact),
+        static_cast<unsigned long long>(framesCorrupted),
+        static_cast<unsigned long long>(framesOutOfOrder),
+        static_cast<unsigned long long>(datagrams.FramesDropped),
+        static_cast<unsigned long long>(statistics.FramesDropped + statistics.FramesTooLarge + statistics.FramesMalformed));
+
+    printf(
+        "latency: reassembly %.2f ms average, %.2f ms maximum; end to end %.2f ms average, %.2f ms maximum\n",
+        1e3 * datagrams.AverageLatencyInSeconds,
+        1e3 * datagrams.MaximumLatencyInSeconds,
+        (framesIntact > 0) ? 1e3 * totalLatencyInSeconds / framesIntact : 0.0,
+        1e3 * maximumLatencyInSeconds);
+
+    //
+    // A frame makes it through the relay if none of its datagrams is lost:
+    // the relay loses datagrams independently, before duplicating them. The
+    // intact frames must be within 4 standard deviations of the binomial
+    // count, give or take two frames the receiver drops while its pool is
+    // busy. All of them make it through a lossless relay.
+    //
+    const size_t frameLength =
+        SensorStream::ProtocolHeaderLength +
+        SensorStream::GetExtendedHeaderLength(SensorStream::ProtocolVersionMinor) +
+        c_imageWidth * c_imageHeight * c_pixelStride;
+
+    const size_t maximumFragmentSize =
+        Io::DatagramFragmenter().GetMaximumFragmentSize();
+
+    const double fragmentsPerFrame =
+        static_cast<double>((frameLength + maximumFragmentSize - 1) / maximumFragmentSize);
+
+    const double intactProbability =
+        pow(1.0 - impairments.LossProbability, fragmentsPerFrame);
+
+    const double expectedFramesIntact =
+        frameCount * intactProbability;
+
+    const double framesIntactTolerance =
+        (impairments.LossProbability > 0.0) ?
+            4.0 * sqrt(frameCount * intactProbability * (1.0 - intactProbability)) + 2.0 :
+            0.0;
+
+    printf(
+        "expected %.1f +/- %.1f intact frames, %.0f datagrams per frame\n",
+        expectedFramesIntact,
+        framesIntactTolerance,
+        fragmentsPerFrame);
+
+    //
+    // Frames are received or dropped, but never twice, however reordered
+    // and duplicated. No frame is delivered corrupted.
+    //
+    const uint64_t framesAccountedFor =
+        statistics.FramesReceived + datagrams.FramesDropped;
+
+    const bool isFramesIntactExpected =
+        fabs(static_cast<double>(framesIntact) - expectedFramesIntact) <= framesIntactTolerance;
+
+    const bool succeeded =
+        0 == framesCorrupted &&
+        0 == framesOutOfOrder &&
+        0 == datagrams.DatagramsMalformed &&
+        0 == statistics.FramesMalformed &&
+        framesAccountedFor <= frameCount &&
+        isFramesIntactExpected;
+
+    printf("%s\n", succeeded ? "passed" : "FAILED");
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
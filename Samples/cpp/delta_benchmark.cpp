@@ -0,0 +1,388 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Measures the bandwidth the Delta streaming codec saves on recorded frames.
+// The frames of each sensor of the tarballs are compressed in archive order
+// like SensorFrameCompressor does it:
+//
+// * Keyframes only: every frame is compressed on its own, 16-bit frames with
+//   the depth codec and other frames with LZ4, and sent raw if that doesn't
+//   shrink them.
+// * Delta: a keyframe, compressed the same way, every keyframe interval
+//   frames and whenever the image size changes; the frames in between are
+//   sent as the Io::DeltaCompress differences to the previous frame, unless
+//   those aren't smaller than the image. 8-bit and RGB frames are differenced
+//   byte by byte, 16-bit frames sample by sample.
+//
+// Both count the 4-byte delta header of each frame. Every frame is decoded
+// from the previous decoded frame, like a receiver does, and checked bit for
+// bit.
+//
+// Usage: delta_benchmark <keyframe interval> <tarball...>
+//
+
+#include "BitmapTarballReader.h"
+#include "SensorStreamProtocol.h"
+
+#include <Io/FrameCodec.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct SensorStatistics
+    {
+        uint64_t Frames = 0;
+        uint64_t RawBytes = 0;
+        uint64_t KeyframeOnlyBytes = 0;
+        uint64_t DeltaBytes = 0;
+
+        // Of the delta stream.
+        uint64_t Keyframes = 0;
+    };
+
+    //
+    // The delta stream of a sensor, and the receiver decoding it.
+    //
+    struct DeltaStream
+    {
+        SensorStatistics Statistics;
+
+        uint32_t FramesSinceKeyframe = 0;
+
+        // The previous frame, as sent and as decoded.
+        std::vector<uint16_t> ReferencePixels;
+        std::vector<uint16_t> DecodedPixels;
+        size_t ReferenceImageSize = 0;
+        uint32_t ReferenceRowLength = 0;
+    };
+
+    class Benchmark
+    {
+    public:
+        explicit Benchmark(
+            const uint32_t keyframeInterval)
+            : _keyframeInterval(keyframeInterval)
+            , _passed(true)
+        {
+        }
+
+        void AddFrame(
+            const SensorStream::RecordedBitmap& bitmap)
+        {
+            DeltaStream& stream = _streams[bitmap.SensorName];
+
+            const size_t imageSize = bitmap.PixelDataSize;
+
+            const bool is16BitPerPixel =
+                (2 == bitmap.BytesPerPixel);
+
+            const uint32_t bytesPerSample =
+                is16BitPerPixel ? 2 : 1;
+
+            const uint32_t rowLength =
+                bitmap.ImageWidth * bitmap.BytesPerPixel / bytesPerSample;
+
+            //
+            // The pixels of a tarball aren't aligned for 16-bit samples.
+            //
+            _pixels.resize(
+                (imageSize + 1) / sizeof(uint16_t));
+
+            memcpy(
+                _pixels.data(),
+                bitmap.Pixels,
+                imageSize);
+
+            const uint8_t* pixels =
+                reinterpret_cast<const uint8_t*>(_pixels.data());
+
+            const size_t keyframeSize =
+                CompressKeyframe(pixels, imageSize, bitmap.ImageWidth, bitmap.ImageHeight, is16BitPerPixel);
+
+            bool isKeyframe =
+                stream.FramesSinceKeyframe >= _keyframeInterval ||
+                stream.ReferenceImageSize != imageSize ||
+                stream.ReferenceRowLength != rowLength;
+
+            size_t deltaSize = 0;
+
+            if (!isKeyframe)
+            {
+                _delta.resize(
+                    Io::DeltaCompressBound(bytesPerSample, rowLength, bitmap.ImageHeight));
+
+                deltaSize = Io::DeltaCompress(
+                    pixels,
+                    reinterpret_cast<const uint8_t*>(stream.ReferencePixels.data()),
+                    bytesPerSample,
+                    rowLength,
+                    bitmap.ImageHeight,
+                    _delta.data(),
+                    _delta.size());
+
+                isKeyframe =
+                    deltaSize >= imageSize;
+            }
+
+            uint8_t* decodedPixels =
+                reinterpret_cast<uint8_t*>(stream.DecodedPixels.data());
+
+            if (isKeyframe)
+            {
+                stream.DecodedPixels.resize(
+                    _pixels.size());
+
+                decodedPixels =
+                    reinterpret_cast<uint8_t*>(stream.DecodedPixels.data());
+
+                DecompressKeyframe(
+                    keyframeSize,
+                    bitmap.ImageWidth,
+                    bitmap.ImageHeight,
+                    is16BitPerPixel,
+                    decodedPixels,
+                    imageSize);
+
+                stream.FramesSinceKeyframe = 1;
+                ++stream.Statistics.Keyframes;
+            }
+            else
+            {
+                Io::DeltaDecompress(
+                    _delta.data(),
+                    deltaSize,
+                    bytesPerSample,
+                    rowLength,
+                    bitmap.ImageHeight,
+                    decodedPixels);
+
+                ++stream.FramesSinceKeyframe;
+            }
+
+            if (0 != memcmp(decodedPixels, pixels, imageSize))
+            {
+                printf(
+                    "%s: frame %llu does not decode bit for bit from the %s\n",
+                    bitmap.SensorName.c_str(),
+                    static_cast<unsigned long long>(bitmap.Timestamp),
+                    isKeyframe ? "keyframe" : "delta");
+
+                _passed = false;
+            }
+
+            stream.ReferencePixels.swap(_pixels);
+            stream.ReferenceImageSize = imageSize;
+            stream.ReferenceRowLength = rowLength;
+
+            SensorStatistics& statistics = stream.Statistics;
+
+            ++statistics.Frames;
+            statistics.RawBytes += imageSize;
+            statistics.KeyframeOnlyBytes += SensorStream::ProtocolDeltaHeaderLength + keyframeSize;
+            statistics.DeltaBytes += SensorStream::ProtocolDeltaHeaderLength + (isKeyframe ? keyframeSize : deltaSize);
+        }
+
+        void PrintStatistics() const
+        {
+            for (const auto& stream : _streams)
+            {
+                const SensorStatistics& statistics = stream.second.Statistics;
+
+                printf(
+                    "  %-26s %6llu frames, raw %8.1f MB | keyframes only %8.1f MB (%5.2fx) | "
+                    "delta %8.1f MB (%5.2fx), %llu keyframes | %4.1f%% less than keyframes only\n",
+                    stream.first.c_str(),
+                    static_cast<unsigned long long>(statistics.Frames),
+                    statistics.RawBytes / 1e6,
+                    statistics.KeyframeOnlyBytes / 1e6,
+                    static_cast<double>(statistics.RawBytes) / statistics.KeyframeOnlyBytes,
+                    statistics.DeltaBytes / 1e6,
+                    static_cast<double>(statistics.RawBytes) / statistics.DeltaBytes,
+                    static_cast<unsigned long long>(statistics.Keyframes),
+                    100.0 * (1.0 - static_cast<double>(statistics.DeltaBytes) / statistics.KeyframeOnlyBytes));
+            }
+        }
+
+        bool HasPassed() const
+        {
+            return _passed;
+        }
+
+    private:
+        //
+        // Compresses the frame into _keyframe, returning its size, or zero if
+        // it is sent raw.
+        //
+        size_t CompressKeyframe(
+            const uint8_t* pixels,
+            const size_t imageSize,
+            const uint32_t imageWidth,
+            const uint32_t imageHeight,
+            const bool is16BitPerPixel)
+        {
+            size_t compressedSize = 0;
+
+            if (is16BitPerPixel)
+            {
+                _keyframe.resize(
+                    Io::DepthCompressBound(imageWidth, imageHeight));
+
+                compressedSize = Io::DepthCompress(
+                    reinterpret_cast<const uint16_t*>(pixels),
+                    imageWidth,
+                    imageHeight,
+                    _keyframe.data(),
+                    _keyframe.size());
+            }
+            else
+            {
+                _keyframe.resize(
+                    Io::Lz4CompressBound(imageSize));
+
+                compressedSize = _lz4Compressor.Compress(
+                    pixels,
+                    imageSize,
+                    _keyframe.data(),
+                    _keyframe.size());
+            }
+
+            if (compressedSize >= imageSize)
+            {
+                _keyframe.assign(
+                    pixels,
+                    pixels + imageSize);
+
+                compressedSize = imageSize;
+            }
+
+            return compressedSize;
+        }
+
+        void DecompressKeyframe(
+            const size_t keyframeSize,
+            const uint32_t imageWidth,
+            const uint32_t imageHeight,
+            const bool is16BitPerPixel,
+            uint8_t* pixels,
+            const size_t imageSize)
+        {
+            if (keyframeSize == imageSize)
+            {
+                memcpy(
+                    pixels,
+                    _keyframe.data(),
+                    imageSize);
+            }
+            else if (is16BitPerPixel)
+            {
+                Io::DepthDecompress(
+                    _keyframe.data(),
+                    keyframeSize,
+                    imageWidth,
+                    imageHeight,
+                    reinterpret_cast<uint16_t*>(pixels));
+            }
+            else
+            {
+                Io::Lz4Decompress(
+                    _keyframe.data(),
+                    keyframeSize,
+                    pixels,
+                    imageSize);
+            }
+        }
+
+        const uint32_t _keyframeInterval;
+
+        std::map<std::string, DeltaStream> _streams;
+
+        Io::Lz4Compressor _lz4Compressor;
+
+        std::vector<uint16_t> _pixels;
+        std::vector<uint8_t> _keyframe;
+        std::vector<uint8_t> _delta;
+
+        bool _passed;
+    };
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t keyframeInterval =
+        (argc > 1) ? atoi(argv[1]) : 0;
+
+    if (argc < 3 || keyframeInterval <= 0)
+    {
+        fprintf(stderr, "usage: %s <keyframe interval> <tarball...>\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    Benchmark benchmark(
+        static_cast<uint32_t>(keyframeInterval));
+
+    bool passed = true;
+
+    try
+    {
+        for (int i = 2; i < argc; ++i)
+        {
+            SensorStream::BitmapTarballReader reader;
+
+            if (!reader.Open(argv[i]))
+            {
+                printf("%s\n", reader.GetError().c_str());
+                passed = false;
+
+                continue;
+            }
+
+            SensorStream::RecordedBitmap bitmap;
+
+            while (reader.ReadBitmap(&bitmap))
+            {
+                benchmark.AddFrame(bitmap);
+            }
+
+            printf(
+                "%s: %llu other files skipped\n",
+                argv[i],
+                static_cast<unsigned long long>(reader.GetSkippedFileCount()));
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        printf("failed: %s\n", exception.what());
+        passed = false;
+    }
+
+    printf("Keyframe every %d frames:\n", keyframeInterval);
+
+    benchmark.PrintStatistics();
+
+    passed = benchmark.HasPassed() && passed;
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
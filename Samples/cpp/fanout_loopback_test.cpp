@@ -0,0 +1,323 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Streams synthetic frames from a LoopbackServer to several clients at the same
+// time, one of which processes its frames slowly, and checks that the slow
+// client only drops its own frames: the other clients, including one that joins
+// the stream late, must receive every frame from the first one they got, intact
+// and in order. A client beyond the maximum number of clients must be refused.
+//
+// Usage: fanout_loopback_test [fast clients] [frames] [slow client delay in ms]
+//
+
+#include "LoopbackServer.h"
+#include "SensorStreamReceiver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // A short throw depth frame: 448x450, 16 bits per pixel.
+    const uint32_t c_imageWidth = 448;
+    const uint32_t c_imageHeight = 450;
+    const uint32_t c_pixelStride = 2;
+
+    const double c_framesPerSecond = 60.0;
+
+    const uint32_t c_queueCapacity = 4;
+
+    struct ClientResult
+    {
+        const char* Name;
+        uint64_t FramesIntact;
+        uint64_t FramesCorrupted;
+        uint64_t FramesOutOfOrder;
+        uint64_t FramesSkipped;
+        uint64_t FirstTimestamp;
+        uint64_t LastTimestamp;
+    };
+
+    uint8_t GetPatternByte(
+        size_t offset)
+    {
+        return static_cast<uint8_t>(offset * 7 + offset / 4096);
+    }
+
+    //
+    // Receives frames until the server disconnects, checking them, and sleeping
+    // for the given delay after each of them.
+    //
+    void Receive(
+        uint16_t port,
+        std::chrono::milliseconds delay,
+        ClientResult* result)
+    {
+        SensorStream::FrameBufferPool pool(
+            4 /* frameCount */,
+            c_imageWidth * c_imageHeight * c_pixelStride /* payloadCapacity */);
+
+        SensorStream::SensorStreamReceiver receiver(
+            pool);
+
+        if (!receiver.Connect("127.0.0.1", port))
+        {
+            fprintf(stderr, "%s: failed to connect: %s\n", result->Name, receiver.GetError().c_str());
+            exit(EXIT_FAILURE);
+        }
+
+        bool hasFrame = false;
+
+        for (;;)
+        {
+            SensorStream::FramePtr frame = receiver.ReceiveFrame();
+
+            if (nullptr == frame)
+            {
+                return;
+            }
+
+            const SensorStream::FrameHeader& header = frame->Header;
+
+            uint64_t frameIndex = 0;
+
+            memcpy(&frameIndex, frame->Payload, sizeof(frameIndex));
+
+            bool isIntact =
+                frameIndex == header.Timestamp &&
+                header.PayloadLength == c_imageWidth * c_imageHeight * c_pixelStride;
+
+            for (size_t offset = sizeof(frameIndex); isIntact && offset < header.PayloadLength; ++offset)
+            {
+                isIntact = frame->Payload[offset] == GetPatternByte(offset);
+            }
+
+            if (!isIntact)
+            {
+                ++result->FramesCorrupted;
+
+                continue;
+            }
+
+            ++result->FramesIntact;
+
+            if (!hasFrame)
+            {
+                result->FirstTimestamp = header.Timestamp;
+                hasFrame = true;
+            }
+            else if (header.Timestamp <= result->LastTimestamp)
+            {
+                ++result->FramesOutOfOrder;
+            }
+            else
+            {
+                result->FramesSkipped += header.Timestamp - result->LastTimestamp - 1;
+            }
+
+            result->LastTimestamp = header.Timestamp;
+
+            frame.reset();
+
+            std::this_thread::sleep_for(
+                delay);
+        }
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const uint32_t fastClientCount =
+        (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 2;
+
+    const uint64_t frameCount =
+        (argc > 2) ? strtoull(argv[2], nullptr, 10) : 240;
+
+    const std::chrono::milliseconds slowClientDelay(
+        (argc > 3) ? atoi(argv[3]) : 100);
+
+    //
+    // The fast clients, the slow client and the late client.
+    //
+    SensorStream::LoopbackServerOptions options;
+
+    options.FrameType = 2 /* ShortThrowToFDepth */;
+    options.ImageWidth = c_imageWidth;
+    options.ImageHeight = c_imageHeight;
+    options.PixelStride = c_pixelStride;
+    options.FrameCount = frameCount;
+    options.FramesPerSecond = c_framesPerSecond;
+    options.MaximumClients = fastClientCount + 2;
+    options.Policy = Io::SendQueuePolicy::DropOldest;
+    options.QueueCapacity = c_queueCapacity;
+
+    SensorStream::LoopbackServer server(
+        options);
+
+    if (!server.Start())
+    {
+        fprintf(stderr, "failed to start the loopback server\n");
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::unique_ptr<ClientResult>> results;
+    std::vector<std::thread> clients;
+
+    const auto startClient =
+        [&](const char* name, std::chrono::milliseconds delay)
+        {
+            std::unique_ptr<ClientResult> result(
+                new ClientResult());
+
+            result->Name = name;
+
+            clients.emplace_back(
+                Receive,
+                server.GetPort(),
+                delay,
+                result.get());
+
+            results.push_back(
+                std::move(result));
+        };
+
+    for (uint32_t i = 0; i < fastClientCount; ++i)
+    {
+        startClient("fast", std::chrono::milliseconds(0));
+    }
+
+    startClient("slow", slowClientDelay);
+
+    //
+    // Join the stream a third of the way through, then try to connect once
+    // too many clients are.
+    //
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(frameCount / c_framesPerSecond / 3));
+
+    startClient("late", std::chrono::milliseconds(0));
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(100));
+
+    SensorStream::FrameBufferPool refusedPool(
+        1 /* frameCount */,
+        c_imageWidth * c_imageHeight * c_pixelStride /* payloadCapacity */);
+
+    SensorStream::SensorStreamReceiver refusedReceiver(
+        refusedPool);
+
+    const bool refused =
+        !refusedReceiver.Connect("127.0.0.1", server.GetPort()) ||
+        nullptr == refusedReceiver.ReceiveFrame();
+
+    //
+    // The server disconnects the clients once they have been sent the last
+    // frame.
+    //
+    for (std::thread& client : clients)
+    {
+        client.join();
+    }
+
+    const std::vector<Io::SendQueueStatistics> serverStatistics =
+        server.GetClientStatistics();
+
+    server.Stop();
+
+    printf(
+        "server: %llu frames at %.0f fps, queues of %u frames, dropping the oldest\n",
+        static_cast<unsigned long long>(server.GetFramesSent()),
+        c_framesPerSecond,
+        c_queueCapacity);
+
+    bool succeeded =
+        refused &&
+        server.GetFramesSent() == frameCount &&
+        serverStatistics.size() == results.size();
+
+    //
+    // The clients connected in the order they were started, but the fast ones
+    // and the slow one race each other; match them by the frames they received.
+    //
+    std::vector<bool> matched(serverStatistics.size(), false);
+
+    for (const std::unique_ptr<ClientResult>& result : results)
+    {
+        const bool isSlow =
+            0 == strcmp("slow", result->Name);
+
+        const Io::SendQueueStatistics* statistics = nullptr;
+
+        for (size_t i = 0; i < serverStatistics.size() && nullptr == statistics; ++i)
+        {
+            if (!matched[i] && serverStatistics[i].FramesSent == result->FramesIntact + result->FramesCorrupted)
+            {
+                matched[i] = true;
+                statistics = &serverStatistics[i];
+            }
+        }
+
+        printf(
+            "%s client: %llu frames intact (%llu to %llu), %llu skipped, %llu corrupted, %llu out of order",
+            result->Name,
+            static_cast<unsigned long long>(result->FramesIntact),
+            static_cast<unsigned long long>(result->FirstTimestamp),
+            static_cast<unsigned long long>(result->LastTimestamp),
+            static_cast<unsigned long long>(result->FramesSkipped),
+            static_cast<unsigned long long>(result->FramesCorrupted),
+            static_cast<unsigned long long>(result->FramesOutOfOrder));
+
+        if (nullptr != statistics)
+        {
+            printf(
+                "; server dropped %llu, queue latency %.2f ms average, %.2f ms maximum",
+                static_cast<unsigned long long>(statistics->FramesDropped),
+                (statistics->FramesSent > 0) ? 1e3 * statistics->TotalQueueLatencyInSeconds / statistics->FramesSent : 0.0,
+                1e3 * statistics->MaximumQueueLatencyInSeconds);
+        }
+
+        printf("\n");
+
+        //
+        // Every client gets intact frames in order; all but the slow one get
+        // every frame until the last one.
+        //
+        succeeded =
+            succeeded &&
+            nullptr != statistics &&
+            result->FramesIntact > 0 &&
+            0 == result->FramesCorrupted &&
+            0 == result->FramesOutOfOrder &&
+            (isSlow ?
+                statistics->FramesDropped > 0 :
+                0 == result->FramesSkipped && 0 == statistics->FramesDropped && frameCount - 1 == result->LastTimestamp);
+    }
+
+    printf("extra client: %s\n", refused ? "refused" : "NOT refused");
+
+    printf("%s\n", succeeded ? "passed" : "FAILED");
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,506 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Fuzzes the decoder of the frame header extensions of the Shared/Io library,
+// which receivers of version 0.2 sensor frame streams run on the extension
+// block of every frame they get from the network. Whatever the input, the
+// decoder must return without crashing, throwing or allocating more than the
+// block could describe, and whatever it accepts must survive being encoded
+// and decoded again unchanged.
+//
+// Built with g++, the program checks that encoded extensions decode to what
+// was encoded, then decodes mutations of valid blocks: flipped bits, damaged
+// lengths, truncations, insertions and records spliced from other blocks.
+// Built with clang and -DLIBFUZZER, it is a libFuzzer target instead:
+//
+//   clang++ -std=c++14 -g -O1 -fsanitize=fuzzer,address -DLIBFUZZER ...
+//
+// Usage: frame_header_extensions_fuzzer [mutations]
+//
+
+#include <Io/FrameHeaderExtensions.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+namespace
+{
+    bool IsSame(
+        const Io::FrameHeaderExtensions& a,
+        const Io::FrameHeaderExtensions& b)
+    {
+        //
+        // The structures are packed, so comparing their bytes also compares
+        // NaNs and negative zeros exactly.
+        //
+        bool isSame =
+            a.HasTransforms == b.HasTransforms &&
+            a.HasPixelFormat == b.HasPixelFormat &&
+            a.HasPinholeIntrinsics == b.HasPinholeIntrinsics &&
+            a.HasUnprojectionLutReference == b.HasUnprojectionLutReference &&
+            (nullptr == a.UnprojectionLut) == (nullptr == b.UnprojectionLut);
+
+        isSame = isSame &&
+            (!a.HasTransforms || 0 == memcmp(&a.Transforms, &b.Transforms, sizeof(a.Transforms))) &&
+            (!a.HasPixelFormat || a.PixelFormat == b.PixelFormat) &&
+            (!a.HasPinholeIntrinsics || 0 == memcmp(&a.Pinhole, &b.Pinhole, sizeof(a.Pinhole))) &&
+            (!a.HasUnprojectionLutReference ||
+                0 == memcmp(&a.UnprojectionLutReference, &b.UnprojectionLutReference, sizeof(a.UnprojectionLutReference)));
+
+        if (isSame && nullptr != a.UnprojectionLut)
+        {
+            const Io::UnprojectionLut& lutA = *a.UnprojectionLut;
+            const Io::UnprojectionLut& lutB = *b.UnprojectionLut;
+
+            const size_t planeSize =
+                static_cast<size_t>(lutA.GetImageWidth()) * lutA.GetImageHeight() * sizeof(float);
+
+            isSame =
+                lutA.GetImageWidth() == lutB.GetImageWidth() &&
+                lutA.GetImageHeight() == lutB.GetImageHeight() &&
+                (lutA.IsEmpty() ||
+                    (0 == memcmp(lutA.GetX(), lutB.GetX(), planeSize) &&
+                     0 == memcmp(lutA.GetY(), lutB.GetY(), planeSize)));
+        }
+
+        return isSame;
+    }
+
+    //
+    // The property checked on every input. Returns false if it does not hold.
+    //
+    bool DecodeAndCheck(
+        const uint8_t* data,
+        const size_t size)
+    {
+        Io::FrameHeaderExtensions extensions;
+
+        try
+        {
+            if (!Io::DecodeFrameHeaderExtensions(data, size, extensions))
+            {
+                return true;
+            }
+
+            //
+            // A decoded LUT is bounded by the block it came from.
+            //
+            if (nullptr != extensions.UnprojectionLut &&
+                2ull * extensions.UnprojectionLut->GetImageWidth() * extensions.UnprojectionLut->GetImageHeight() * sizeof(float) > size)
+            {
+                return false;
+            }
+
+            std::vector<uint8_t> encoded;
+
+            Io::EncodeFrameHeaderExtensions(extensions, encoded);
+
+            Io::FrameHeaderExtensions decoded;
+
+            return
+                Io::DecodeFrameHeaderExtensions(encoded.data(), encoded.size(), decoded) &&
+                IsSame(extensions, decoded);
+        }
+        catch (const std::exception& exception)
+        {
+            printf("the decoder threw: %s\n", exception.what());
+
+            return false;
+        }
+    }
+}
+
+#if defined(LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(
+    const uint8_t* data,
+    size_t size)
+{
+    if (!DecodeAndCheck(data, size))
+    {
+        abort();
+    }
+
+    return 0;
+}
+
+#else
+
+namespace
+{
+    uint32_t NextRandom(
+        uint64_t& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    float NextFloat(
+        uint64_t& random)
+    {
+        //
+        // Mostly ordinary values, sometimes arbitrary bit patterns.
+        //
+        if (0 == NextRandom(random) % 8)
+        {
+            const uint32_t bits = NextRandom(random);
+
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+
+            return value;
+        }
+
+        return (static_cast<float>(NextRandom(random)) / 4294967296.0f - 0.5f) * 4.0f;
+    }
+
+    Io::FrameHeaderExtensions CreateRandomExtensions(
+        uint64_t& random)
+    {
+        Io::FrameHeaderExtensions extensions;
+
+        extensions.HasTransforms = 0 != NextRandom(random) % 2;
+
+        for (size_t i = 0; extensions.HasTransforms && i < 16; ++i)
+        {
+            extensions.Transforms.FrameToOrigin[i] = NextFloat(random);
+            extensions.Transforms.CameraViewTransform[i] = NextFloat(random);
+            extensions.Transforms.CameraProjectionTransform[i] = NextFloat(random);
+        }
+
+        extensions.HasPixelFormat = 0 != NextRandom(random) % 2;
+        extensions.PixelFormat = extensions.HasPixelFormat ? NextRandom(random) % 100 : 0;
+
+        extensions.HasPinholeIntrinsics = 0 != NextRandom(random) % 2;
+
+        if (extensions.HasPinholeIntrinsics)
+        {
+            Io::PinholeIntrinsics& pinhole = extensions.Pinhole;
+
+            pinhole.FocalLength[0] = NextFloat(random);
+            pinhole.FocalLength[1] = NextFloat(random);
+            pinhole.PrincipalPoint[0] = NextFloat(random);
+            pinhole.PrincipalPoint[1] = NextFloat(random);
+
+            //
+            // The structure is packed, so its members are assigned rather than
+            // referenced.
+            //
+            for (size_t i = 0; i < sizeof(pinhole.RadialDistortion) / sizeof(float); ++i)
+            {
+                pinhole.RadialDistortion[i] = NextFloat(random);
+            }
+
+            for (size_t i = 0; i < sizeof(pinhole.TangentialDistortion) / sizeof(float); ++i)
+            {
+                pinhole.TangentialDistortion[i] = NextFloat(random);
+            }
+
+            pinhole.ImageWidth = 1 + NextRandom(random) % 2000;
+            pinhole.ImageHeight = 1 + NextRandom(random) % 2000;
+        }
+
+        switch (NextRandom(random) % 3)
+        {
+        case 0:
+            break;
+
+        case 1:
+            extensions.HasUnprojectionLutReference = true;
+            extensions.UnprojectionLutReference.Hash = static_cast<uint64_t>(NextRandom(random)) << 32 | NextRandom(random);
+            extensions.UnprojectionLutReference.ImageWidth = NextRandom(random) % 1000;
+            extensions.UnprojectionLutReference.ImageHeight = NextRandom(random) % 1000;
+            break;
+
+        case 2:
+        {
+            auto unprojectionLut = std::make_shared<Io::UnprojectionLut>();
+
+            const uint32_t imageWidth = NextRandom(random) % 24;
+            const uint32_t imageHeight = NextRandom(random) % 24;
+
+            unprojectionLut->Resize(imageWidth, imageHeight);
+
+            for (size_t i = 0; i < static_cast<size_t>(imageWidth) * imageHeight; ++i)
+            {
+                const float x = (0 == NextRandom(random) % 16) ? NAN : NextFloat(random);
+
+                unprojectionLut->SetPoint(i, x, NextFloat(random));
+            }
+
+            extensions.HasUnprojectionLutReference = true;
+            extensions.UnprojectionLutReference.Hash = Io::HashUnprojectionLut(*unprojectionLut);
+            extensions.UnprojectionLutReference.ImageWidth = imageWidth;
+            extensions.UnprojectionLutReference.ImageHeight = imageHeight;
+            extensions.UnprojectionLut = unprojectionLut;
+            break;
+        }
+        }
+
+        return extensions;
+    }
+
+    //
+    // Offsets of the length fields of the records of a valid block.
+    //
+    std::vector<size_t> FindLengthFields(
+        const std::vector<uint8_t>& block)
+    {
+        std::vector<size_t> offsets;
+
+        Io::FrameHeaderExtensionRecordHeader recordHeader;
+
+        for (size_t offset = 0; offset + sizeof(recordHeader) <= block.size(); offset += sizeof(recordHeader) + recordHeader.Length)
+        {
+            memcpy(&recordHeader, block.data() + offset, sizeof(recordHeader));
+
+            offsets.push_back(offset + offsetof(Io::FrameHeaderExtensionRecordHeader, Length));
+        }
+
+        return offsets;
+    }
+
+    void Mutate(
+        std::vector<uint8_t>& block,
+        const std::vector<uint8_t>& otherBlock,
+        uint64_t& random)
+    {
+        const uint32_t numberOfMutations = 1 + NextRandom(random) % 4;
+
+        for (uint32_t i = 0; i < numberOfMutations; ++i)
+        {
+            const size_t position = block.empty() ? 0 : NextRandom(random) % block.size();
+
+            switch (NextRandom(random) % 7)
+            {
+            case 0:
+                if (!block.empty())
+                {
+                    block[position] ^= static_cast<uint8_t>(1 << (NextRandom(random) % 8));
+                }
+                break;
+
+            case 1:
+                if (!block.empty())
+                {
+                    block[position] = static_cast<uint8_t>(NextRandom(random));
+                }
+                break;
+
+            case 2:
+                block.resize(position);
+                break;
+
+            case 3:
+                block.insert(block.begin() + position, 1 + NextRandom(random) % 16, static_cast<uint8_t>(NextRandom(random)));
+                break;
+
+            case 4:
+            {
+                //
+                // Lengths just off, far off, or at the limits.
+                //
+                const std::vector<size_t> lengthFields = FindLengthFields(block);
+
+                if (!lengthFields.empty())
+                {
+                    const size_t offset = lengthFields[NextRandom(random) % lengthFields.size()];
+
+                    uint32_t length;
+                    memcpy(&length, block.data() + offset, sizeof(length));
+
+                    const uint32_t lengths[] =
+                    {
+                        length - 1, length + 1, length - 4, length + 4, 0, 0xffffffffu, 0x80000000u, NextRandom(random)
+                    };
+
+                    length = lengths[NextRandom(random) % 8];
+
+                    memcpy(block.data() + offset, &length, sizeof(length));
+                }
+                break;
+            }
+
+            case 5:
+            {
+                //
+                // A record type, including unknown ones.
+                //
+                const std::vector<size_t> lengthFields = FindLengthFields(block);
+
+                if (!lengthFields.empty())
+                {
+                    const uint16_t type = static_cast<uint16_t>(NextRandom(random) % 8);
+
+                    memcpy(block.data() + lengthFields[NextRandom(random) % lengthFields.size()] - 4, &type, sizeof(type));
+                }
+                break;
+            }
+
+            case 6:
+                if (!otherBlock.empty())
+                {
+                    const size_t first = NextRandom(random) % otherBlock.size();
+                    const size_t last = first + NextRandom(random) % (otherBlock.size() - first + 1);
+
+                    block.insert(block.begin() + position, otherBlock.begin() + first, otherBlock.begin() + last);
+                }
+                break;
+            }
+        }
+    }
+
+    //
+    // LUT records whose image size overflows when multiplied out, and which a
+    // 32-bit multiplication would wrap to the size of the payload.
+    //
+    bool CheckOverflowingLutSizes()
+    {
+        const uint32_t sizes[][2] =
+        {
+            { 0xffffffffu, 0xffffffffu },
+            { 0x80000000u, 0x80000000u },
+            { 0x40000000u, 4 },
+            { 0x80000000u, 2 },
+            { 0x10000u, 0x10000u },
+            { 2, 0x80000001u },
+        };
+
+        for (const auto& size : sizes)
+        {
+            Io::UnprojectionLutHeader lutHeader = {};
+
+            lutHeader.ImageWidth = size[0];
+            lutHeader.ImageHeight = size[1];
+
+            for (const uint32_t pointsSize : { 0u, 8u, 16u, 64u })
+            {
+                Io::FrameHeaderExtensionRecordHeader recordHeader = {};
+
+                recordHeader.Type = static_cast<uint16_t>(Io::FrameHeaderExtensionType::UnprojectionLut);
+                recordHeader.Length = static_cast<uint32_t>(sizeof(lutHeader)) + pointsSize;
+
+                std::vector<uint8_t> block(sizeof(recordHeader) + recordHeader.Length);
+
+                memcpy(block.data(), &recordHeader, sizeof(recordHeader));
+                memcpy(block.data() + sizeof(recordHeader), &lutHeader, sizeof(lutHeader));
+
+                Io::FrameHeaderExtensions extensions;
+
+                try
+                {
+                    if (Io::DecodeFrameHeaderExtensions(block.data(), block.size(), extensions))
+                    {
+                        printf("a %ux%u LUT is accepted with %u bytes of points\n", size[0], size[1], pointsSize);
+                        return false;
+                    }
+                }
+                catch (const std::exception& exception)
+                {
+                    printf("a %ux%u LUT with %u bytes of points makes the decoder throw: %s\n", size[0], size[1], pointsSize, exception.what());
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint64_t numberOfMutations =
+        (argc > 1) ? static_cast<uint64_t>(atoll(argv[1])) : 1000000;
+
+    uint64_t random = 42;
+
+    bool passed = true;
+
+    //
+    // Encoded extensions decode to what was encoded.
+    //
+    std::vector<std::vector<uint8_t>> corpus;
+
+    for (int i = 0; i < 1000 && passed; ++i)
+    {
+        const Io::FrameHeaderExtensions extensions = CreateRandomExtensions(random);
+
+        std::vector<uint8_t> block;
+
+        Io::EncodeFrameHeaderExtensions(extensions, block);
+
+        Io::FrameHeaderExtensions decoded;
+
+        if (!Io::DecodeFrameHeaderExtensions(block.data(), block.size(), decoded) || !IsSame(extensions, decoded))
+        {
+            printf("extensions %d do not survive being encoded and decoded\n", i);
+            passed = false;
+        }
+
+        corpus.push_back(block);
+    }
+
+    printf("round trips: %s\n", passed ? "exact" : "FAILED");
+
+    const bool overflowsRejected = CheckOverflowingLutSizes();
+
+    printf("overflowing LUT sizes: %s\n", overflowsRejected ? "rejected" : "FAILED");
+
+    passed = passed && overflowsRejected;
+
+    uint64_t accepted = 0;
+    uint64_t failures = 0;
+
+    for (uint64_t i = 0; i < numberOfMutations && failures < 10; ++i)
+    {
+        std::vector<uint8_t> block = corpus[NextRandom(random) % corpus.size()];
+
+        Mutate(block, corpus[NextRandom(random) % corpus.size()], random);
+
+        Io::FrameHeaderExtensions extensions;
+
+        try
+        {
+            accepted += Io::DecodeFrameHeaderExtensions(block.data(), block.size(), extensions) ? 1 : 0;
+        }
+        catch (const std::exception&)
+        {
+        }
+
+        if (!DecodeAndCheck(block.data(), block.size()))
+        {
+            printf("mutation %llu of %zu bytes breaks the decoder\n", static_cast<unsigned long long>(i), block.size());
+            ++failures;
+        }
+    }
+
+    printf(
+        "%llu mutated blocks: %llu accepted, %s\n",
+        static_cast<unsigned long long>(numberOfMutations),
+        static_cast<unsigned long long>(accepted),
+        (0 == failures) ? "no failures" : "FAILED");
+
+    passed = passed && 0 == failures;
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
@@ -0,0 +1,345 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Compares the two ways the receiver has gotten the buffers it deserializes
+// frames into:
+//
+// * Before: a new buffer per frame.
+// * Now: an Io::FramePool, which hands out the buffers of the frames the
+//   application is done with.
+//
+// Frames of a photo video, a depth and a visible light stream arrive in turn,
+// and the application holds on to the last few frames of each stream, like
+// an application that processes them in the background does. Halfway through,
+// the photo video stream changes resolution, so that the pool picks up a new
+// size class while keeping the others.
+//
+// Reports the allocations per frame and the latency of getting a buffer and
+// filling it with a frame (median, p99, max), with no pool and with pools that
+// keep fewer and as many buffers per size class as there are frames held.
+// Checks the statistics of the pools, and that no buffer in use is handed out
+// again.
+//
+// Usage: frame_pool_benchmark [frames] [frames held per stream]
+//
+
+#include <Io/FramePool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount(0);
+
+    typedef std::vector<uint8_t> FrameBuffer;
+    typedef Io::FramePool<FrameBuffer> FrameBufferPool;
+
+    struct StreamConfiguration
+    {
+        const char* Name;
+        Io::FramePoolKey Key;
+
+        // The key the stream switches to halfway through.
+        Io::FramePoolKey SecondKey;
+
+        uint32_t BytesPerPixel;
+    };
+
+    // Windows::Graphics::Imaging::BitmapPixelFormat values.
+    const int32_t c_bgra8 = 87;
+    const int32_t c_gray16 = 57;
+    const int32_t c_gray8 = 62;
+
+    const StreamConfiguration c_streams[] =
+    {
+        { "pv", { 1280, 720, c_bgra8 }, { 1920, 1080, c_bgra8 }, 4 },
+        { "long_throw_depth", { 448, 450, c_gray16 }, { 448, 450, c_gray16 }, 2 },
+        { "vlc_lf", { 640, 480, c_gray8 }, { 640, 480, c_gray8 }, 1 },
+    };
+
+    const size_t c_numberOfStreams =
+        sizeof(c_streams) / sizeof(c_streams[0]);
+
+    size_t GetFrameSize(
+        const StreamConfiguration& stream,
+        const Io::FramePoolKey& key)
+    {
+        return static_cast<size_t>(key.Width) * key.Height * stream.BytesPerPixel;
+    }
+
+    double GetPercentile(
+        std::vector<double> values,
+        const double percentile)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+
+        std::sort(values.begin(), values.end());
+
+        return values[std::min(values.size() - 1, static_cast<size_t>(values.size() * percentile))];
+    }
+
+    //
+    // Receives frameCount frames, holding on to the last framesHeld frames of
+    // each stream. Without a pool (maximumBuffersPerKey of 0) each frame gets
+    // a new buffer.
+    //
+    bool Run(
+        const int32_t frameCount,
+        const size_t framesHeld,
+        const size_t maximumBuffersPerKey,
+        const std::vector<uint8_t>& payload)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        const bool usePool =
+            (maximumBuffersPerKey > 0);
+
+        FrameBufferPool pool(
+            [](const Io::FramePoolKey& key)
+            {
+                // Sized for the largest stream; the frames fill what they need.
+                return FrameBuffer(static_cast<size_t>(key.Width) * key.Height * 4);
+            },
+            maximumBuffersPerKey);
+
+        std::deque<std::shared_ptr<FrameBuffer>> heldFrames[c_numberOfStreams];
+
+        std::vector<double> latencies(
+            frameCount);
+
+        bool passed = true;
+
+        const uint64_t firstAllocationCount = g_allocationCount;
+
+        for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        {
+            const size_t streamIndex =
+                frameIndex % c_numberOfStreams;
+
+            const StreamConfiguration& stream =
+                c_streams[streamIndex];
+
+            const Io::FramePoolKey& key =
+                (frameIndex < frameCount / 2) ? stream.Key : stream.SecondKey;
+
+            const size_t frameSize =
+                GetFrameSize(stream, key);
+
+            std::deque<std::shared_ptr<FrameBuffer>>& held =
+                heldFrames[streamIndex];
+
+            if (held.size() == framesHeld)
+            {
+                held.pop_front();
+            }
+
+            const Clock::time_point startTime = Clock::now();
+
+            std::shared_ptr<FrameBuffer> buffer =
+                usePool
+                    ? pool.Acquire(key)
+                    : std::make_shared<FrameBuffer>(static_cast<size_t>(key.Width) * key.Height * 4);
+
+            memcpy(buffer->data(), payload.data(), frameSize);
+
+            latencies[frameIndex] =
+                std::chrono::duration<double, std::micro>(Clock::now() - startTime).count();
+
+            for (const std::deque<std::shared_ptr<FrameBuffer>>& otherHeld : heldFrames)
+            {
+                if (otherHeld.end() != std::find(otherHeld.begin(), otherHeld.end(), buffer))
+                {
+                    fprintf(stderr, "frame %d: a buffer in use was handed out again\n", frameIndex);
+                    passed = false;
+                }
+            }
+
+            held.push_back(
+                std::move(buffer));
+        }
+
+        const uint64_t allocations =
+            g_allocationCount - firstAllocationCount;
+
+        char name[64] = {};
+
+        if (usePool)
+        {
+            snprintf(name, sizeof(name), "pool of %zu per key", maximumBuffersPerKey);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "no pool");
+        }
+
+        printf(
+            "%-20s %6.2f allocations per frame, latency median %7.1f us, p99 %7.1f us, max %7.1f us\n",
+            name,
+            static_cast<double>(allocations) / frameCount,
+            GetPercentile(latencies, 0.5),
+            GetPercentile(latencies, 0.99),
+            GetPercentile(latencies, 1.0));
+
+        if (!usePool)
+        {
+            return passed;
+        }
+
+        const Io::FramePoolStatistics statistics =
+            pool.GetStatistics();
+
+        // One size class per stream, and the photo video one it switches to.
+        const size_t numberOfKeys =
+            c_numberOfStreams + 1;
+
+        // The frames held are released before the next one is received.
+        const size_t buffersPerKey =
+            std::min(framesHeld, maximumBuffersPerKey);
+
+        printf(
+            "%-20s %llu acquisitions, %llu buffers created, %zu pooled, high water mark %zu\n",
+            "",
+            static_cast<unsigned long long>(statistics.Acquisitions),
+            static_cast<unsigned long long>(statistics.Allocations),
+            statistics.BuffersPooled,
+            statistics.HighWaterMark);
+
+        if (statistics.Acquisitions != static_cast<uint64_t>(frameCount) ||
+            statistics.BuffersPooled != numberOfKeys * buffersPerKey)
+        {
+            fprintf(stderr, "unexpected number of acquisitions or pooled buffers\n");
+            passed = false;
+        }
+
+        if (maximumBuffersPerKey >= framesHeld)
+        {
+            //
+            // Once warmed up, a pool with room for the frames held creates no
+            // more buffers, and the buffers of the old photo video size class
+            // aren't reused for the new one.
+            //
+            if (statistics.Allocations != numberOfKeys * buffersPerKey)
+            {
+                fprintf(stderr, "the pool kept creating buffers once warmed up\n");
+                passed = false;
+            }
+
+            //
+            // The frames held by each stream. The size class the photo video
+            // stream left still counts the frames it held when last acquired
+            // from, since buffers in use are only counted on acquisition.
+            //
+            if (statistics.HighWaterMark != numberOfKeys * framesHeld)
+            {
+                fprintf(stderr, "unexpected high water mark\n");
+                passed = false;
+            }
+        }
+
+        return passed;
+    }
+}
+
+void* operator new(
+    size_t size)
+{
+    ++g_allocationCount;
+
+    void* pointer = malloc((0 == size) ? 1 : size);
+
+    if (nullptr == pointer)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void operator delete(
+    void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(
+    void* pointer,
+    size_t /* size */) noexcept
+{
+    free(pointer);
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t frameCount =
+        (argc > 1) ? atoi(argv[1]) : 3000;
+
+    const int32_t framesHeld =
+        (argc > 2) ? atoi(argv[2]) : 3;
+
+    if (frameCount < 2 * static_cast<int32_t>(c_numberOfStreams) * (framesHeld + 1) || framesHeld <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames] [frames held per stream]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint8_t> payload(
+        1920 * 1080 * 4);
+
+    for (size_t i = 0; i < payload.size(); ++i)
+    {
+        payload[i] = static_cast<uint8_t>(i * 7 + (i >> 11));
+    }
+
+    const size_t maximumBuffersPerKey[] =
+    {
+        0,
+        static_cast<size_t>(framesHeld + 1) / 2,
+        static_cast<size_t>(framesHeld),
+    };
+
+    bool passed = true;
+
+    for (size_t index = 0; index < sizeof(maximumBuffersPerKey) / sizeof(maximumBuffersPerKey[0]); ++index)
+    {
+        const size_t maximum =
+            maximumBuffersPerKey[index];
+
+        // A single frame held per stream needs a single buffer per key.
+        if (index > 0 && maximum == maximumBuffersPerKey[index - 1])
+        {
+            continue;
+        }
+
+        passed = Run(frameCount, framesHeld, maximum, payload) && passed;
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,549 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Stress tests the lock-free frame history of the Shared/Io library, which
+// HoloLensForCV's MultiFrameBuffer keeps per sensor: a producer pushes frames
+// as fast as it can while readers check that every snapshot they take is
+// consistent and that no frame is released while it can still be read. Then
+// measures the reads per second and read latency of several readers while
+// nine producers push frames at the rates of the HoloLens sensors, against the
+// single mutex and std::deque per sensor MultiFrameBuffer used before.
+//
+// Usage: frame_ring_benchmark [seconds per run] [readers]
+//
+
+#include <Io/FrameRing.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const uint32_t c_liveFrameMagic = 0x4652414d;
+    const uint32_t c_releasedFrameMagic = 0xdeadbeef;
+
+    std::atomic<int64_t> g_liveFrames(0);
+
+    struct TestFrame
+    {
+        explicit TestFrame(
+            const uint64_t ordinal)
+            : Ordinal(ordinal)
+            , Timestamp(static_cast<int64_t>(ordinal) * 10)
+            , Magic(c_liveFrameMagic)
+        {
+            ++g_liveFrames;
+        }
+
+        ~TestFrame()
+        {
+            Magic = c_releasedFrameMagic;
+            --g_liveFrames;
+        }
+
+        uint64_t Ordinal;
+        int64_t Timestamp;
+        volatile uint32_t Magic;
+    };
+
+    typedef std::shared_ptr<TestFrame> TestFramePointer;
+    typedef Io::FrameRing<TestFramePointer> TestFrameRing;
+
+    bool IsLive(
+        const TestFramePointer& frame)
+    {
+        return nullptr != frame && c_liveFrameMagic == frame->Magic;
+    }
+
+    //
+    // Checks what a reader sees while the producer laps the ring.
+    //
+    uint64_t ReadAndCheck(
+        const TestFrameRing& ring,
+        const std::atomic<bool>& stopRequested,
+        uint64_t* numberOfReads)
+    {
+        uint64_t errors = 0;
+        uint64_t latestOrdinal = 0;
+
+        std::vector<TestFrameRing::Entry> entries;
+        std::vector<int64_t> timestamps;
+
+        while (!stopRequested.load())
+        {
+            const TestFramePointer latest = ring.GetLatest();
+
+            if (nullptr != latest)
+            {
+                if (!IsLive(latest) || latest->Ordinal < latestOrdinal || latest->Timestamp != static_cast<int64_t>(latest->Ordinal) * 10)
+                {
+                    ++errors;
+                }
+
+                latestOrdinal = latest->Ordinal;
+            }
+
+            entries.clear();
+            ring.GetHistory(entries);
+
+            if (entries.size() > ring.GetCapacity())
+            {
+                ++errors;
+            }
+
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                const TestFrameRing::Entry& entry = entries[i];
+
+                if (!IsLive(entry.Frame) ||
+                    entry.Timestamp != entry.Frame->Timestamp ||
+                    (i > 0 && entry.Frame->Ordinal <= entries[i - 1].Frame->Ordinal) ||
+                    entry.Frame->Ordinal - entries[0].Frame->Ordinal >= ring.GetCapacity())
+                {
+                    ++errors;
+                }
+            }
+
+            timestamps.clear();
+            ring.GetTimestamps(timestamps);
+
+            if (timestamps.size() > ring.GetCapacity() || !std::is_sorted(timestamps.begin(), timestamps.end()))
+            {
+                ++errors;
+            }
+
+            *numberOfReads += 3;
+        }
+
+        return errors;
+    }
+
+    bool RunStressTest(
+        const uint32_t capacity,
+        const uint32_t numberOfReaders,
+        const double seconds)
+    {
+        uint64_t errors = 0;
+        uint64_t numberOfPushes = 0;
+        uint64_t numberOfReads = 0;
+
+        {
+            TestFrameRing ring(capacity);
+
+            std::atomic<bool> stopRequested(false);
+
+            std::vector<uint64_t> readerErrors(numberOfReaders);
+            std::vector<uint64_t> readerReads(numberOfReaders);
+            std::vector<std::thread> readers;
+
+            for (uint32_t i = 0; i < numberOfReaders; ++i)
+            {
+                readers.emplace_back(
+                    [&, i]()
+                {
+                    readerErrors[i] = ReadAndCheck(ring, stopRequested, &readerReads[i]);
+                });
+            }
+
+            const Clock::time_point endTime =
+                Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+            while (Clock::now() < endTime)
+            {
+                for (int i = 0; i < 64; ++i)
+                {
+                    TestFramePointer frame =
+                        std::make_shared<TestFrame>(numberOfPushes++);
+
+                    ring.Push(frame, frame->Timestamp);
+                }
+            }
+
+            stopRequested = true;
+
+            for (uint32_t i = 0; i < numberOfReaders; ++i)
+            {
+                readers[i].join();
+
+                errors += readerErrors[i];
+                numberOfReads += readerReads[i];
+            }
+
+            //
+            // Once the readers are gone, the history is the last frames pushed.
+            //
+            std::vector<TestFrameRing::Entry> entries;
+            ring.GetHistory(entries);
+
+            const uint64_t expectedSize = std::min<uint64_t>(capacity, numberOfPushes);
+
+            if (entries.size() != expectedSize ||
+                ring.GetWriteCount() != numberOfPushes ||
+                ring.GetLatest()->Ordinal != numberOfPushes - 1 ||
+                entries.front().Frame->Ordinal != numberOfPushes - expectedSize)
+            {
+                printf("  the history after the run is not the last %llu frames pushed\n", static_cast<unsigned long long>(expectedSize));
+                ++errors;
+            }
+        }
+
+        //
+        // Every frame is released with the ring.
+        //
+        if (0 != g_liveFrames.load())
+        {
+            printf("  %lld frames leaked\n", static_cast<long long>(g_liveFrames.load()));
+            ++errors;
+        }
+
+        printf(
+            "capacity %u, %u readers: %llu pushes, %llu reads, %s\n",
+            capacity,
+            numberOfReaders,
+            static_cast<unsigned long long>(numberOfPushes),
+            static_cast<unsigned long long>(numberOfReads),
+            (0 == errors) ? "consistent" : "INCONSISTENT");
+
+        return 0 == errors;
+    }
+
+    //
+    // The HoloLens sensors: the PV camera, four visible light cameras, and the
+    // depth and reflectivity streams of the short and long throw depth modes.
+    //
+    const double c_sensorRates[] = { 30, 30, 30, 30, 30, 45, 45, 5, 5 };
+    const size_t c_numberOfSensors = sizeof(c_sensorRates) / sizeof(c_sensorRates[0]);
+    const uint32_t c_historyDepth = 5;
+
+    //
+    // MultiFrameBuffer before it kept a ring per sensor.
+    //
+    class LockedFrameBuffer
+    {
+    public:
+        void Push(
+            const size_t sensor,
+            const TestFramePointer& frame)
+        {
+            std::lock_guard<std::mutex> lock(_framesMutex);
+
+            auto& buffer = _frames[sensor];
+
+            buffer.push_back(frame);
+
+            while (buffer.size() > c_historyDepth)
+            {
+                buffer.pop_front();
+            }
+        }
+
+        TestFramePointer GetLatest(
+            const size_t sensor)
+        {
+            std::lock_guard<std::mutex> lock(_framesMutex);
+
+            auto& buffer = _frames[sensor];
+
+            return buffer.empty() ? nullptr : buffer.back();
+        }
+
+        TestFramePointer GetFrameForTime(
+            const size_t sensor,
+            const int64_t timestamp)
+        {
+            std::lock_guard<std::mutex> lock(_framesMutex);
+
+            for (const TestFramePointer& frame : _frames[sensor])
+            {
+                if (std::abs(frame->Timestamp - timestamp) < 10)
+                {
+                    return frame;
+                }
+            }
+
+            return nullptr;
+        }
+
+    private:
+        std::mutex _framesMutex;
+        std::map<size_t, std::deque<TestFramePointer>> _frames;
+    };
+
+    class RingFrameBuffer
+    {
+    public:
+        RingFrameBuffer()
+        {
+            for (auto& ring : _rings)
+            {
+                ring.reset(new TestFrameRing(c_historyDepth));
+            }
+        }
+
+        void Push(
+            const size_t sensor,
+            const TestFramePointer& frame)
+        {
+            _rings[sensor]->Push(frame, frame->Timestamp);
+        }
+
+        TestFramePointer GetLatest(
+            const size_t sensor)
+        {
+            return _rings[sensor]->GetLatest();
+        }
+
+        TestFramePointer GetFrameForTime(
+            const size_t sensor,
+            const int64_t timestamp)
+        {
+            std::vector<TestFrameRing::Entry>& entries = Entries();
+
+            entries.clear();
+            _rings[sensor]->GetHistory(entries);
+
+            for (const TestFrameRing::Entry& entry : entries)
+            {
+                if (std::abs(entry.Timestamp - timestamp) < 10)
+                {
+                    return entry.Frame;
+                }
+            }
+
+            return nullptr;
+        }
+
+    private:
+        static std::vector<TestFrameRing::Entry>& Entries()
+        {
+            thread_local std::vector<TestFrameRing::Entry> entries;
+
+            return entries;
+        }
+
+        std::array<std::unique_ptr<TestFrameRing>, c_numberOfSensors> _rings;
+    };
+
+    struct LatencyStatistics
+    {
+        double Median;
+        double P99;
+        double Maximum;
+    };
+
+    LatencyStatistics ComputeLatencyStatistics(
+        const std::vector<std::vector<double>>& latenciesPerThread,
+        size_t* numberOfSamples)
+    {
+        std::vector<double> latencies;
+
+        for (const std::vector<double>& threadLatencies : latenciesPerThread)
+        {
+            latencies.insert(latencies.end(), threadLatencies.begin(), threadLatencies.end());
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        LatencyStatistics statistics = {};
+
+        if (!latencies.empty())
+        {
+            statistics.Median = latencies[latencies.size() / 2];
+            statistics.P99 = latencies[latencies.size() * 99 / 100];
+            statistics.Maximum = latencies.back();
+        }
+
+        *numberOfSamples = latencies.size();
+
+        return statistics;
+    }
+
+    struct ContentionResult
+    {
+        double ReadsPerSecond;
+        LatencyStatistics ReadLatency;
+        LatencyStatistics PushLatency;
+        size_t Pushes;
+    };
+
+    //
+    // Readers alternate between the latest frame of a sensor and the frame of
+    // another sensor closest to it in time, like the render thread and the
+    // computer vision samples do.
+    //
+    template <typename TFrameBuffer>
+    ContentionResult RunContention(
+        const uint32_t numberOfReaders,
+        const double seconds)
+    {
+        TFrameBuffer frameBuffer;
+
+        std::atomic<bool> stopRequested(false);
+
+        std::vector<std::vector<double>> pushLatencies(c_numberOfSensors);
+        std::vector<std::vector<double>> readLatencies(numberOfReaders);
+
+        std::vector<std::thread> threads;
+
+        for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+        {
+            threads.emplace_back(
+                [&, sensor]()
+            {
+                const Clock::duration period =
+                    std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / c_sensorRates[sensor]));
+
+                Clock::time_point nextFrameTime = Clock::now();
+
+                for (uint64_t ordinal = 0; !stopRequested.load(); ++ordinal)
+                {
+                    const TestFramePointer frame =
+                        std::make_shared<TestFrame>(ordinal);
+
+                    const Clock::time_point startTime = Clock::now();
+
+                    frameBuffer.Push(sensor, frame);
+
+                    pushLatencies[sensor].push_back(
+                        std::chrono::duration<double, std::nano>(Clock::now() - startTime).count());
+
+                    nextFrameTime += period;
+
+                    std::this_thread::sleep_until(nextFrameTime);
+                }
+            });
+        }
+
+        for (uint32_t reader = 0; reader < numberOfReaders; ++reader)
+        {
+            threads.emplace_back(
+                [&, reader]()
+            {
+                std::vector<double>& readerLatencies = readLatencies[reader];
+
+                readerLatencies.reserve(1 << 22);
+
+                for (size_t i = 0; !stopRequested.load(); ++i)
+                {
+                    const size_t sensor = (i + reader) % c_numberOfSensors;
+
+                    const Clock::time_point startTime = Clock::now();
+
+                    TestFramePointer frame = frameBuffer.GetLatest(sensor);
+
+                    if (nullptr != frame)
+                    {
+                        frame = frameBuffer.GetFrameForTime((sensor + 1) % c_numberOfSensors, frame->Timestamp);
+                    }
+
+                    const Clock::time_point endTime = Clock::now();
+
+                    if (readerLatencies.size() < readerLatencies.capacity())
+                    {
+                        readerLatencies.push_back(
+                            std::chrono::duration<double, std::nano>(endTime - startTime).count());
+                    }
+                }
+            });
+        }
+
+        const Clock::time_point startTime = Clock::now();
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+        stopRequested = true;
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        const double elapsedSeconds =
+            std::chrono::duration<double>(Clock::now() - startTime).count();
+
+        ContentionResult result = {};
+
+        size_t numberOfReads;
+
+        result.ReadLatency = ComputeLatencyStatistics(readLatencies, &numberOfReads);
+        result.PushLatency = ComputeLatencyStatistics(pushLatencies, &result.Pushes);
+        result.ReadsPerSecond = numberOfReads / elapsedSeconds;
+
+        return result;
+    }
+
+    void PrintContentionResult(
+        const char* name,
+        const ContentionResult& result)
+    {
+        printf(
+            "  %s\n"
+            "    reads: %.0f/s, latency median %.0f ns, p99 %.0f ns, max %.0f ns\n"
+            "    %zu pushes: latency median %.0f ns, p99 %.0f ns, max %.0f ns\n",
+            name,
+            result.ReadsPerSecond,
+            result.ReadLatency.Median,
+            result.ReadLatency.P99,
+            result.ReadLatency.Maximum,
+            result.Pushes,
+            result.PushLatency.Median,
+            result.PushLatency.P99,
+            result.PushLatency.Maximum);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds =
+        (argc > 1) ? atof(argv[1]) : 2.0;
+
+    const uint32_t numberOfReaders =
+        (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 4;
+
+    bool passed = true;
+
+    for (const uint32_t capacity : { 1u, 2u, 5u, 32u })
+    {
+        passed = RunStressTest(capacity, numberOfReaders, seconds / 2) && passed;
+    }
+
+    printf(
+        "%zu producers at sensor rates, %u readers, %.1f s:\n",
+        c_numberOfSensors,
+        numberOfReaders,
+        seconds);
+
+    PrintContentionResult(
+        "mutex and std::deque:",
+        RunContention<LockedFrameBuffer>(numberOfReaders, seconds));
+
+    PrintContentionResult(
+        "Io::FrameRing per sensor:",
+        RunContention<RingFrameBuffer>(numberOfReaders, seconds));
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
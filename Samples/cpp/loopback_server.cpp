@@ -0,0 +1,94 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Serves synthetic frames on the loopback interface, to test receivers
+// without a HoloLens. Clients that can not keep up drop the oldest frames of
+// their queue, without holding back the other clients.
+//
+// Usage: loopback_server [port] [width] [height] [pixel stride] [frames per second] [maximum clients]
+//
+
+#include "LoopbackServer.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#include <pthread.h>
+
+int main(
+    int argc,
+    char** argv)
+{
+    SensorStream::LoopbackServerOptions options;
+
+    options.Port = static_cast<uint16_t>((argc > 1) ? atoi(argv[1]) : 23940);
+    options.ImageWidth = (argc > 2) ? static_cast<uint32_t>(atoi(argv[2])) : 1280;
+    options.ImageHeight = (argc > 3) ? static_cast<uint32_t>(atoi(argv[3])) : 720;
+    options.PixelStride = (argc > 4) ? static_cast<uint32_t>(atoi(argv[4])) : 4;
+    options.FramesPerSecond = (argc > 5) ? atof(argv[5]) : 30.0;
+    options.MaximumClients = (argc > 6) ? static_cast<uint32_t>(atoi(argv[6])) : 4;
+    options.Policy = Io::SendQueuePolicy::DropOldest;
+
+    //
+    // Serve until interrupted; the server thread inherits the blocked signals.
+    //
+    sigset_t signals;
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    SensorStream::LoopbackServer server(
+        options);
+
+    if (!server.Start())
+    {
+        fprintf(stderr, "failed to listen on port %u\n", options.Port);
+
+        return EXIT_FAILURE;
+    }
+
+    printf(
+        "serving %ux%u frames (%u bytes per pixel) at %.1f fps to up to %u clients on 127.0.0.1:%u\n",
+        options.ImageWidth,
+        options.ImageHeight,
+        options.PixelStride,
+        options.FramesPerSecond,
+        options.MaximumClients,
+        server.GetPort());
+
+    int signal = 0;
+
+    sigwait(&signals, &signal);
+
+    server.Stop();
+
+    printf("%llu frames sent\n", static_cast<unsigned long long>(server.GetFramesSent()));
+
+    const std::vector<Io::SendQueueStatistics> clientStatistics =
+        server.GetClientStatistics();
+
+    for (size_t i = 0; i < clientStatistics.size(); ++i)
+    {
+        printf(
+            "client %zu: %llu frames sent, %llu dropped\n",
+            i,
+            static_cast<unsigned long long>(clientStatistics[i].FramesSent),
+            static_cast<unsigned long long>(clientStatistics[i].FramesDropped));
+    }
+
+    return EXIT_SUCCESS;
+}
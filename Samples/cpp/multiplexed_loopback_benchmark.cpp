@@ -0,0 +1,848 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Compares the two layouts of HoloLensForCV's sensor streaming over TCP
+// loopback: a connection per sensor, and a single connection the sensors share
+// chunk by chunk through the stream scheduler of the Shared/Io library, like
+// SensorFrameMultiplexedStreamingServer. Nine cameras queue frames of the
+// sizes and at the rates of the HoloLens sensors, the senders pace their
+// writes through a shared emulated link, and the receivers check that the
+// frames of every sensor arrive intact and in order. Reports the aggregate
+// throughput and the per-sensor latency from capture to reception.
+//
+// Usage: multiplexed_loopback_benchmark [seconds per run] [link MB/s, 0 for unthrottled]
+//
+
+#include <Io/FrameSendQueue.h>
+#include <Io/StreamScheduler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct Sensor
+    {
+        const char* Name;
+        uint32_t FrameSize;
+        double FramesPerSecond;
+    };
+
+    //
+    // The PV camera (BGRA), the four visible light cameras, and the depth and
+    // reflectivity images of the short and long throw depth modes.
+    //
+    const Sensor c_sensors[] =
+    {
+        { "PV", 1280 * 720 * 4, 15.0 },
+        { "VLC LL", 640 * 480, 30.0 },
+        { "VLC LF", 640 * 480, 30.0 },
+        { "VLC RF", 640 * 480, 30.0 },
+        { "VLC RR", 640 * 480, 30.0 },
+        { "ST depth", 448 * 450 * 2, 45.0 },
+        { "ST refl.", 448 * 450 * 2, 45.0 },
+        { "LT depth", 448 * 450 * 2, 5.0 },
+        { "LT refl.", 448 * 450 * 2, 5.0 },
+    };
+
+    const size_t c_numberOfSensors = sizeof(c_sensors) / sizeof(c_sensors[0]);
+
+    const size_t c_queueCapacity = 2;
+
+    // Like MultiplexedChunkMaximumLength and MultiplexedChunkFlagLast.
+    const uint32_t c_chunkMaximumLength = 64 * 1024;
+    const uint16_t c_chunkFlagLast = 0x0001;
+
+    //
+    // Precedes the payload of every frame.
+    //
+    struct FrameHeader
+    {
+        uint32_t Sensor;
+        uint32_t Ordinal;
+        int64_t CaptureTime;
+        uint32_t PayloadSize;
+        uint32_t Reserved;
+    };
+
+    struct ChunkHeader
+    {
+        uint16_t FrameType;
+        uint16_t Flags;
+        uint32_t Length;
+    };
+
+    //
+    // A serialized frame: its header followed by its payload.
+    //
+    typedef std::shared_ptr<std::vector<uint8_t>> Frame;
+
+    uint8_t GetPatternByte(
+        const uint32_t sensor,
+        const uint32_t ordinal,
+        const size_t offset)
+    {
+        return static_cast<uint8_t>(sensor * 31 + ordinal * 7 + offset);
+    }
+
+    int64_t GetTimeInNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    //
+    // A link of a fixed bandwidth shared by all connections: each write takes
+    // the link for as long as its bytes need to cross it, in the order the
+    // writes are made. Like a socket send buffer, the link accepts a backlog
+    // of writes before it blocks the writer.
+    //
+    class EmulatedLink
+    {
+    public:
+        explicit EmulatedLink(
+            const double bytesPerSecond)
+            : _bytesPerSecond(bytesPerSecond)
+            , _backlog((bytesPerSecond > 0.0) ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(256 * 1024 / bytesPerSecond)) : Clock::duration::zero())
+            , _freeTime(Clock::now())
+        {
+        }
+
+        void Transmit(
+            const size_t sizeInBytes)
+        {
+            if (_bytesPerSecond <= 0.0)
+            {
+                return;
+            }
+
+            Clock::time_point endTime;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                _freeTime = std::max(_freeTime, Clock::now()) +
+                    std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(sizeInBytes / _bytesPerSecond));
+
+                endTime = _freeTime;
+            }
+
+            std::this_thread::sleep_until(endTime - _backlog);
+        }
+
+    private:
+        const double _bytesPerSecond;
+        const Clock::duration _backlog;
+
+        std::mutex _mutex;
+        Clock::time_point _freeTime;
+    };
+
+    bool SendAll(
+        const int socket,
+        const uint8_t* data,
+        size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+
+            if (sent <= 0)
+            {
+                return false;
+            }
+
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+
+        return true;
+    }
+
+    bool ReceiveAll(
+        const int socket,
+        void* data,
+        size_t size)
+    {
+        uint8_t* bytes = static_cast<uint8_t*>(data);
+
+        while (size > 0)
+        {
+            const ssize_t received = recv(socket, bytes, size, 0);
+
+            if (received <= 0)
+            {
+                return false;
+            }
+
+            bytes += received;
+            size -= static_cast<size_t>(received);
+        }
+
+        return true;
+    }
+
+    bool CreateConnection(
+        int* senderSocket,
+        int* receiverSocket)
+    {
+        const int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t addressLength = sizeof(address);
+
+        bool connected =
+            listener >= 0 &&
+            0 == bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) &&
+            0 == listen(listener, 1) &&
+            0 == getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength);
+
+        *receiverSocket = connected ? socket(AF_INET, SOCK_STREAM, 0) : -1;
+
+        connected = connected &&
+            0 == connect(*receiverSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        *senderSocket = connected ? accept(listener, nullptr, nullptr) : -1;
+
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+
+        return connected && *senderSocket >= 0;
+    }
+
+    //
+    // What the receivers saw of a sensor.
+    //
+    struct SensorResult
+    {
+        uint64_t FramesReceived;
+        uint64_t BytesReceived;
+        bool Consistent;
+        int64_t LastOrdinal;
+        std::vector<double> Latencies;
+    };
+
+    //
+    // Checks a received frame and records its latency.
+    //
+    void ReceiveFrame(
+        const FrameHeader& header,
+        const uint8_t* payload,
+        const size_t payloadSize,
+        std::vector<SensorResult>& results)
+    {
+        if (header.Sensor >= c_numberOfSensors)
+        {
+            return;
+        }
+
+        SensorResult& result = results[header.Sensor];
+
+        result.Latencies.push_back((GetTimeInNanoseconds() - header.CaptureTime) * 1e-6);
+
+        bool intact =
+            header.PayloadSize == payloadSize &&
+            payloadSize == c_sensors[header.Sensor].FrameSize &&
+            static_cast<int64_t>(header.Ordinal) > result.LastOrdinal;
+
+        //
+        // The ends of the payload are enough to catch misplaced chunks.
+        //
+        for (size_t i = 0; intact && i < 64; ++i)
+        {
+            intact =
+                payload[i] == GetPatternByte(header.Sensor, header.Ordinal, i) &&
+                payload[payloadSize - 1 - i] == GetPatternByte(header.Sensor, header.Ordinal, payloadSize - 1 - i);
+        }
+
+        result.Consistent = result.Consistent && intact;
+        result.LastOrdinal = header.Ordinal;
+
+        ++result.FramesReceived;
+        result.BytesReceived += sizeof(FrameHeader) + payloadSize;
+    }
+
+    //
+    // The send queues of the sensors, filled by a camera thread per sensor.
+    //
+    class Cameras
+    {
+    public:
+        Cameras()
+            : _stopRequested(false)
+        {
+            for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+            {
+                _queues.emplace_back(
+                    new Io::FrameSendQueue<Frame>(c_queueCapacity, 1, Io::SendQueuePolicy::DropOldest));
+
+                //
+                // A few frames per sensor are enough, as they are only read
+                // once they have been dequeued.
+                //
+                std::vector<Frame> frames;
+
+                for (uint32_t i = 0; i < c_queueCapacity + 3; ++i)
+                {
+                    frames.push_back(std::make_shared<std::vector<uint8_t>>(sizeof(FrameHeader) + c_sensors[sensor].FrameSize));
+                }
+
+                _frames.push_back(frames);
+            }
+        }
+
+        void Start()
+        {
+            for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+            {
+                _threads.emplace_back(
+                    [this, sensor]()
+                {
+                    Capture(static_cast<uint32_t>(sensor));
+                });
+            }
+        }
+
+        void Stop()
+        {
+            _stopRequested = true;
+
+            for (std::thread& thread : _threads)
+            {
+                thread.join();
+            }
+
+            for (auto& queue : _queues)
+            {
+                queue->Close();
+            }
+        }
+
+        Io::FrameSendQueue<Frame>& GetQueue(
+            const size_t sensor)
+        {
+            return *_queues[sensor];
+        }
+
+    private:
+        void Capture(
+            const uint32_t sensor)
+        {
+            const Clock::duration period =
+                std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / c_sensors[sensor].FramesPerSecond));
+
+            Clock::time_point nextFrameTime = Clock::now();
+
+            for (uint32_t ordinal = 0; !_stopRequested.load(); ++ordinal)
+            {
+                //
+                // Frames are recycled once no queue or sender refers to them.
+                //
+                Frame frame;
+
+                for (const Frame& candidate : _frames[sensor])
+                {
+                    if (1 == candidate.use_count())
+                    {
+                        frame = candidate;
+                        break;
+                    }
+                }
+
+                if (nullptr == frame)
+                {
+                    frame = std::make_shared<std::vector<uint8_t>>(sizeof(FrameHeader) + c_sensors[sensor].FrameSize);
+                }
+
+                uint8_t* payload = frame->data() + sizeof(FrameHeader);
+
+                for (size_t i = 0; i < 64; ++i)
+                {
+                    payload[i] = GetPatternByte(sensor, ordinal, i);
+                    payload[c_sensors[sensor].FrameSize - 1 - i] = GetPatternByte(sensor, ordinal, c_sensors[sensor].FrameSize - 1 - i);
+                }
+
+                FrameHeader header = {};
+
+                header.Sensor = sensor;
+                header.Ordinal = ordinal;
+                header.CaptureTime = GetTimeInNanoseconds();
+                header.PayloadSize = c_sensors[sensor].FrameSize;
+
+                memcpy(frame->data(), &header, sizeof(header));
+
+                _queues[sensor]->Push(frame, frame->size(), true);
+
+                nextFrameTime += period;
+
+                std::this_thread::sleep_until(nextFrameTime);
+            }
+        }
+
+        std::atomic<bool> _stopRequested;
+        std::vector<std::unique_ptr<Io::FrameSendQueue<Frame>>> _queues;
+        std::vector<std::vector<Frame>> _frames;
+        std::vector<std::thread> _threads;
+    };
+
+    const Clock::duration c_idlePollPeriod = std::chrono::microseconds(200);
+
+    //
+    // A connection per sensor, each with its own sender and receiver.
+    //
+    bool RunSocketPerSensor(
+        Cameras& cameras,
+        EmulatedLink& link,
+        const double seconds,
+        std::vector<SensorResult>& results)
+    {
+        std::vector<int> senderSockets(c_numberOfSensors, -1);
+        std::vector<int> receiverSockets(c_numberOfSensors, -1);
+
+        for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+        {
+            if (!CreateConnection(&senderSockets[sensor], &receiverSockets[sensor]))
+            {
+                return false;
+            }
+        }
+
+        std::atomic<bool> stopRequested(false);
+        std::vector<std::thread> threads;
+
+        for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+        {
+            threads.emplace_back(
+                [&, sensor]()
+            {
+                Io::FrameSendQueue<Frame>& queue = cameras.GetQueue(sensor);
+
+                while (!stopRequested.load())
+                {
+                    Frame frame;
+                    size_t frameSize;
+
+                    if (!queue.TryBeginSend(&frame, &frameSize))
+                    {
+                        std::this_thread::sleep_for(c_idlePollPeriod);
+                        continue;
+                    }
+
+                    bool sent = true;
+
+                    for (size_t offset = 0; sent && offset < frameSize; offset += c_chunkMaximumLength)
+                    {
+                        const size_t length = std::min<size_t>(frameSize - offset, c_chunkMaximumLength);
+
+                        link.Transmit(length);
+
+                        sent = SendAll(senderSockets[sensor], frame->data() + offset, length);
+                    }
+
+                    queue.EndSend(frameSize, sent);
+                }
+
+                shutdown(senderSockets[sensor], SHUT_WR);
+            });
+
+            threads.emplace_back(
+                [&, sensor]()
+            {
+                std::vector<uint8_t> payload(c_sensors[sensor].FrameSize);
+
+                FrameHeader header;
+
+                while (ReceiveAll(receiverSockets[sensor], &header, sizeof(header)) &&
+                       header.PayloadSize == payload.size() &&
+                       ReceiveAll(receiverSockets[sensor], payload.data(), payload.size()))
+                {
+                    ReceiveFrame(header, payload.data(), payload.size(), results);
+                }
+            });
+        }
+
+        cameras.Start();
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+        cameras.Stop();
+        stopRequested = true;
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+        {
+            close(senderSockets[sensor]);
+            close(receiverSockets[sensor]);
+        }
+
+        return true;
+    }
+
+    //
+    // A single connection: the sender takes a chunk at a time from the sensor
+    // the scheduler picks, and the receiver reassembles the frames.
+    //
+    bool RunMultiplexed(
+        Cameras& cameras,
+        EmulatedLink& link,
+        const std::vector<uint32_t>& weights,
+        const double seconds,
+        std::vector<SensorResult>& results)
+    {
+        int senderSocket = -1;
+        int receiverSocket = -1;
+
+        if (!CreateConnection(&senderSocket, &receiverSocket))
+        {
+            return false;
+        }
+
+        std::atomic<bool> stopRequested(false);
+
+        std::thread sender(
+            [&]()
+        {
+            Io::StreamScheduler scheduler(c_numberOfSensors);
+
+            for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+            {
+                scheduler.SetWeight(sensor, weights[sensor]);
+            }
+
+            std::vector<Frame> frames(c_numberOfSensors);
+            std::vector<size_t> frameOffsets(c_numberOfSensors, 0);
+            std::vector<size_t> serviceOrder;
+
+            std::vector<uint8_t> chunk(sizeof(ChunkHeader) + c_chunkMaximumLength);
+
+            bool sent = true;
+
+            while (sent && !stopRequested.load())
+            {
+                scheduler.GetServiceOrder(serviceOrder);
+
+                size_t sensor = c_numberOfSensors;
+
+                for (const size_t candidate : serviceOrder)
+                {
+                    size_t frameSize;
+
+                    if (nullptr != frames[candidate] ||
+                        cameras.GetQueue(candidate).TryBeginSend(&frames[candidate], &frameSize))
+                    {
+                        sensor = candidate;
+                        break;
+                    }
+                }
+
+                if (c_numberOfSensors == sensor)
+                {
+                    std::this_thread::sleep_for(c_idlePollPeriod);
+                    continue;
+                }
+
+                const Frame& frame = frames[sensor];
+
+                ChunkHeader header;
+
+                header.FrameType = static_cast<uint16_t>(sensor);
+                header.Length = static_cast<uint32_t>(std::min<size_t>(frame->size() - frameOffsets[sensor], c_chunkMaximumLength));
+                header.Flags = (frameOffsets[sensor] + header.Length == frame->size()) ? c_chunkFlagLast : 0;
+
+                memcpy(chunk.data(), &header, sizeof(header));
+                memcpy(chunk.data() + sizeof(header), frame->data() + frameOffsets[sensor], header.Length);
+
+                link.Transmit(header.Length);
+
+                sent = SendAll(senderSocket, chunk.data(), sizeof(header) + header.Length);
+
+                scheduler.Charge(sensor, header.Length);
+
+                frameOffsets[sensor] += header.Length;
+
+                if (0 != (header.Flags & c_chunkFlagLast))
+                {
+                    cameras.GetQueue(sensor).EndSend(frame->size(), sent);
+
+                    frames[sensor] = nullptr;
+                    frameOffsets[sensor] = 0;
+                }
+            }
+
+            for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+            {
+                if (nullptr != frames[sensor])
+                {
+                    cameras.GetQueue(sensor).EndSend(frames[sensor]->size(), false);
+                }
+            }
+
+            shutdown(senderSocket, SHUT_WR);
+        });
+
+        std::thread receiver(
+            [&]()
+        {
+            std::vector<std::vector<uint8_t>> frames(c_numberOfSensors);
+
+            ChunkHeader header;
+
+            while (ReceiveAll(receiverSocket, &header, sizeof(header)) &&
+                   header.FrameType < c_numberOfSensors &&
+                   header.Length <= c_chunkMaximumLength)
+            {
+                std::vector<uint8_t>& frame = frames[header.FrameType];
+
+                const size_t offset = frame.size();
+
+                frame.resize(offset + header.Length);
+
+                if (!ReceiveAll(receiverSocket, frame.data() + offset, header.Length))
+                {
+                    break;
+                }
+
+                if (0 != (header.Flags & c_chunkFlagLast))
+                {
+                    FrameHeader frameHeader = {};
+
+                    if (frame.size() >= sizeof(frameHeader))
+                    {
+                        memcpy(&frameHeader, frame.data(), sizeof(frameHeader));
+                    }
+
+                    if (frameHeader.Sensor != header.FrameType)
+                    {
+                        results[header.FrameType].Consistent = false;
+                    }
+                    else
+                    {
+                        ReceiveFrame(frameHeader, frame.data() + sizeof(frameHeader), frame.size() - sizeof(frameHeader), results);
+                    }
+
+                    frame.clear();
+                }
+            }
+        });
+
+        cameras.Start();
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+
+        cameras.Stop();
+        stopRequested = true;
+
+        sender.join();
+        receiver.join();
+
+        close(senderSocket);
+        close(receiverSocket);
+
+        return true;
+    }
+
+    double GetPercentile(
+        std::vector<double> values,
+        const double percentile)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+
+        std::sort(values.begin(), values.end());
+
+        return values[std::min(values.size() - 1, static_cast<size_t>(values.size() * percentile))];
+    }
+
+    //
+    // Prints the throughput and latencies of a run. Returns false if a frame
+    // was lost, corrupted or reordered on the way.
+    //
+    bool PrintResults(
+        const char* name,
+        const std::vector<SensorResult>& results,
+        const double seconds)
+    {
+        uint64_t bytesReceived = 0;
+        bool consistent = true;
+
+        for (const SensorResult& result : results)
+        {
+            bytesReceived += result.BytesReceived;
+            consistent = consistent && result.Consistent;
+        }
+
+        printf("  %s: %.1f MB/s%s\n", name, bytesReceived / 1e6 / seconds, consistent ? "" : ", frames corrupted or reordered");
+
+        printf("    ");
+
+        for (size_t sensor = 0; sensor < c_numberOfSensors; ++sensor)
+        {
+            printf(
+                "%s %.0f/%.0f%s",
+                c_sensors[sensor].Name,
+                GetPercentile(results[sensor].Latencies, 0.5),
+                GetPercentile(results[sensor].Latencies, 0.99),
+                (4 == sensor) ? "\n    " : (sensor + 1 < c_numberOfSensors) ? ", " : " ms (p50/p99)\n");
+        }
+
+        return consistent;
+    }
+
+    std::vector<SensorResult> CreateResults()
+    {
+        SensorResult result = {};
+
+        result.Consistent = true;
+        result.LastOrdinal = -1;
+
+        return std::vector<SensorResult>(c_numberOfSensors, result);
+    }
+
+    //
+    // Streams that always have data get the connection in proportion to their
+    // weights, ties go to the lower index, and a stream that was idle does not
+    // make up for it once it has data again.
+    //
+    bool CheckScheduler()
+    {
+        Io::StreamScheduler scheduler(3);
+
+        scheduler.SetWeight(1, 3);
+
+        std::vector<size_t> serviceOrder;
+        std::vector<uint64_t> bytesSent(3, 0);
+
+        bool passed = 3 == scheduler.GetWeight(1);
+
+        scheduler.GetServiceOrder(serviceOrder);
+
+        passed = passed && serviceOrder == std::vector<size_t>({ 0, 1, 2 });
+
+        //
+        // Stream 2 is idle for the first half.
+        //
+        for (int i = 0; i < 40000; ++i)
+        {
+            scheduler.GetServiceOrder(serviceOrder);
+
+            const size_t stream = (i < 20000 && 2 == serviceOrder[0]) ? serviceOrder[1] : serviceOrder[0];
+
+            scheduler.Charge(stream, 1000);
+            bytesSent[stream] += 1000;
+
+            if (19999 == i)
+            {
+                passed = passed && 0 == bytesSent[2] && bytesSent[1] > 2.95 * bytesSent[0] && bytesSent[1] < 3.05 * bytesSent[0];
+
+                bytesSent.assign(3, 0);
+            }
+        }
+
+        return passed && bytesSent[1] > 2.95 * bytesSent[2] && bytesSent[2] > 0.98 * bytesSent[0] && bytesSent[2] < 1.02 * bytesSent[0];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds =
+        (argc > 1) ? atof(argv[1]) : 5.0;
+
+    const double linkMegabytesPerSecond =
+        (argc > 2) ? atof(argv[2]) : 100.0;
+
+    bool passed = CheckScheduler();
+
+    printf("stream scheduler: %s\n", passed ? "shares in proportion to the weights" : "FAILED");
+
+    double offeredBytesPerSecond = 0.0;
+
+    for (const Sensor& sensor : c_sensors)
+    {
+        offeredBytesPerSecond += sensor.FrameSize * sensor.FramesPerSecond;
+    }
+
+    if (linkMegabytesPerSecond > 0.0)
+    {
+        printf("%zu sensors offering %.1f MB/s over a %.0f MB/s link, %.1f s per layout:\n", c_numberOfSensors, offeredBytesPerSecond / 1e6, linkMegabytesPerSecond, seconds);
+    }
+    else
+    {
+        printf("%zu sensors offering %.1f MB/s, unthrottled, %.1f s per layout:\n", c_numberOfSensors, offeredBytesPerSecond / 1e6, seconds);
+    }
+
+    {
+        Cameras cameras;
+        EmulatedLink link(linkMegabytesPerSecond * 1e6);
+        std::vector<SensorResult> results = CreateResults();
+
+        passed =
+            RunSocketPerSensor(cameras, link, seconds, results) &&
+            PrintResults("a connection per sensor", results, seconds) &&
+            passed;
+    }
+
+    {
+        Cameras cameras;
+        EmulatedLink link(linkMegabytesPerSecond * 1e6);
+        std::vector<SensorResult> results = CreateResults();
+
+        passed =
+            RunMultiplexed(cameras, link, std::vector<uint32_t>(c_numberOfSensors, 1), seconds, results) &&
+            PrintResults("one multiplexed connection, equal weights", results, seconds) &&
+            passed;
+    }
+
+    {
+        Cameras cameras;
+        EmulatedLink link(linkMegabytesPerSecond * 1e6);
+        std::vector<SensorResult> results = CreateResults();
+
+        std::vector<uint32_t> weights(c_numberOfSensors, 1);
+        weights[0] = 4;
+
+        passed =
+            RunMultiplexed(cameras, link, weights, seconds, results) &&
+            PrintResults("one multiplexed connection, PV weighted 4", results, seconds) &&
+            passed;
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
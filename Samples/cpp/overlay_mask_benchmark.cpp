@@ -0,0 +1,228 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks rmcv::OverlayMask against the per-pixel loop it replaces in the
+// ComputeOnDevice and ComputeOnDesktop samples, on CV_8UC4 and CV_8UC1
+// images of many sizes, including views into larger images. Then measures
+// both on the edges cv::Canny finds in a synthetic image, at the resolutions
+// of the samples.
+//
+// Usage: overlay_mask_benchmark [frames]
+//
+
+#include <OpenCVHelpers/OverlayMask.h>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    const uint8_t c_threshold = 64;
+    const uint32_t c_colorBGRA = 0xFFFF00FF;
+
+    //
+    // The loop of the samples, extended to CV_8UC1 images.
+    //
+    void OverlayMaskPerPixel(
+        const cv::Mat& mask,
+        const uint8_t threshold,
+        const uint32_t colorBGRA,
+        cv::Mat& image)
+    {
+        cv::Mat color(1, 1, CV_8UC4, const_cast<uint32_t*>(&colorBGRA));
+        cv::Mat grayLevel;
+
+        cv::cvtColor(color, grayLevel, cv::COLOR_BGRA2GRAY);
+
+        for (int32_t y = 0; y < image.rows; ++y)
+        {
+            for (int32_t x = 0; x < image.cols; ++x)
+            {
+                if (mask.at<uint8_t>(y, x) > threshold)
+                {
+                    if (CV_8UC4 == image.type())
+                    {
+                        image.at<uint32_t>(y, x) = colorBGRA;
+                    }
+                    else
+                    {
+                        image.at<uint8_t>(y, x) = grayLevel.at<uint8_t>(0, 0);
+                    }
+                }
+            }
+        }
+    }
+
+    //
+    // Compares the kernel with the loop on random images and masks, and on
+    // views into them that don't start or end on a multiple of 16 pixels.
+    // cv::cvtColor rounds the gray level of a few colours differently, hence
+    // the tolerance of 1 on CV_8UC1 images.
+    //
+    bool Check(
+        cv::RNG& rng)
+    {
+        for (int32_t iteration = 0; iteration < 1000; ++iteration)
+        {
+            const int32_t width = rng.uniform(1, 100);
+            const int32_t height = rng.uniform(1, 20);
+            const int32_t type = (iteration % 2) ? CV_8UC4 : CV_8UC1;
+
+            const uint8_t threshold = static_cast<uint8_t>(rng.uniform(0, 256));
+            const uint32_t colorBGRA = static_cast<uint32_t>(rng.next());
+
+            cv::Mat image(height + 2, width + 5, type);
+            cv::Mat mask(height + 3, width + 7, CV_8UC1);
+
+            rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+            rng.fill(mask, cv::RNG::UNIFORM, 0, 256);
+
+            const cv::Rect imageView(rng.uniform(0, 6), rng.uniform(0, 3), width, height);
+            const cv::Rect maskView(rng.uniform(0, 8), rng.uniform(0, 4), width, height);
+
+            cv::Mat expectedImage = image.clone();
+
+            cv::Mat expectedView = expectedImage(imageView);
+
+            OverlayMaskPerPixel(mask(maskView), threshold, colorBGRA, expectedView);
+
+            cv::Mat actualView = image(imageView);
+
+            rmcv::OverlayMask(mask(maskView), threshold, colorBGRA, actualView);
+
+            cv::Mat difference;
+
+            cv::absdiff(image, expectedImage, difference);
+
+            double maximumDifference = 0.0;
+
+            cv::minMaxLoc(difference.reshape(1), nullptr, &maximumDifference);
+
+            if (maximumDifference > ((CV_8UC1 == type) ? 1.0 : 0.0))
+            {
+                fprintf(
+                    stderr,
+                    "%dx%d %s image differs by %.0f\n",
+                    width,
+                    height,
+                    (CV_8UC4 == type) ? "CV_8UC4" : "CV_8UC1",
+                    maximumDifference);
+
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    double GetMilliseconds(
+        const std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    //
+    // Times the kernel and the loop overlaying the edges of a synthetic image
+    // of the given size.
+    //
+    void Benchmark(
+        cv::RNG& rng,
+        const cv::Size& imageSize,
+        const int32_t frameCount)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        cv::Mat image(imageSize, CV_8UC4, cv::Scalar(32, 32, 32, 255));
+
+        for (int32_t index = 0; index < 60; ++index)
+        {
+            const cv::Point center(
+                rng.uniform(0, imageSize.width),
+                rng.uniform(0, imageSize.height));
+
+            cv::circle(
+                image,
+                center,
+                rng.uniform(10, imageSize.height / 4),
+                cv::Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256), 255),
+                cv::FILLED);
+        }
+
+        cv::Mat blurredImage, cannyImage;
+
+        cv::medianBlur(image, blurredImage, 3);
+        cv::Canny(blurredImage, cannyImage, 50.0, 200.0);
+
+        cv::Mat overlaidImage = blurredImage.clone();
+
+        double kernelTime = 0.0, perPixelTime = 0.0;
+
+        for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        {
+            const Clock::time_point startTime = Clock::now();
+
+            rmcv::OverlayMask(cannyImage, c_threshold, c_colorBGRA, overlaidImage);
+
+            const Clock::time_point kernelTimePoint = Clock::now();
+
+            OverlayMaskPerPixel(cannyImage, c_threshold, c_colorBGRA, overlaidImage);
+
+            const Clock::time_point endTime = Clock::now();
+
+            kernelTime += GetMilliseconds(kernelTimePoint - startTime);
+            perPixelTime += GetMilliseconds(endTime - kernelTimePoint);
+        }
+
+        printf(
+            "%dx%d, %.1f%% edges: OverlayMask %.3f ms, per pixel loop %.3f ms per frame (%.1fx)\n",
+            imageSize.width,
+            imageSize.height,
+            100.0 * cv::countNonZero(cannyImage) / imageSize.area(),
+            kernelTime / frameCount,
+            perPixelTime / frameCount,
+            perPixelTime / kernelTime);
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t frameCount =
+        (argc > 1) ? atoi(argv[1]) : 500;
+
+    if (frameCount <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    cv::RNG rng(0x4f564c59);
+
+    const bool passed =
+        Check(rng);
+
+    // The downscaled frames of ComputeOnDevice, and the frames ComputeOnDesktop receives.
+    Benchmark(rng, cv::Size(640, 360), frameCount);
+    Benchmark(rng, cv::Size(1280, 720), frameCount);
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
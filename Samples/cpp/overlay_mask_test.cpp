@@ -0,0 +1,270 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks the instruction sets of rmcv::OverlayMaskRows, the kernel of
+// rmcv::OverlayMask, against a per-pixel loop, on BGRA and gray images of many
+// sizes, including views into larger images. Then measures them on a sparse
+// mask, like the edges cv::Canny finds, at the resolution of the frames
+// ComputeOnDesktop receives. Builds without OpenCV.
+//
+// Usage: overlay_mask_test [frames]
+//
+
+#include <OpenCVHelpers/OverlayMaskRows.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const uint8_t c_threshold = 64;
+    const uint32_t c_colorBGRA = 0xFFFF00FF;
+
+    const rmcv::OverlayMaskIsa c_isas[] =
+    {
+        rmcv::OverlayMaskIsa::Scalar,
+        rmcv::OverlayMaskIsa::Sse2
+    };
+
+    const char* GetIsaName(
+        const rmcv::OverlayMaskIsa isa)
+    {
+        return (rmcv::OverlayMaskIsa::Sse2 == isa) ? "SSE2" : "scalar";
+    }
+
+    void OverlayMaskPerPixel(
+        const uint8_t* mask,
+        const size_t maskStride,
+        const uint8_t threshold,
+        const uint32_t colorBGRA,
+        const int32_t width,
+        const int32_t height,
+        const int32_t channels,
+        uint8_t* image,
+        const size_t imageStride)
+    {
+        const uint8_t grayLevel =
+            rmcv::GetOverlayGrayLevel(colorBGRA);
+
+        for (int32_t y = 0; y < height; ++y)
+        {
+            for (int32_t x = 0; x < width; ++x)
+            {
+                if (mask[y * maskStride + x] <= threshold)
+                {
+                    continue;
+                }
+
+                uint8_t* pixel =
+                    image + y * imageStride + x * channels;
+
+                if (4 == channels)
+                {
+                    pixel[0] = static_cast<uint8_t>(colorBGRA);
+                    pixel[1] = static_cast<uint8_t>(colorBGRA >> 8);
+                    pixel[2] = static_cast<uint8_t>(colorBGRA >> 16);
+                    pixel[3] = static_cast<uint8_t>(colorBGRA >> 24);
+                }
+                else
+                {
+                    *pixel = grayLevel;
+                }
+            }
+        }
+    }
+
+    //
+    // Compares each instruction set with the loop on random images and masks,
+    // through views that don't start or end on a multiple of 16 pixels. The
+    // whole images are compared, so that pixels written outside of the views
+    // are caught too.
+    //
+    bool Check(
+        std::mt19937& rng)
+    {
+        std::uniform_int_distribution<int32_t> byte(0, 255);
+
+        for (int32_t iteration = 0; iteration < 2000; ++iteration)
+        {
+            const int32_t width = 1 + rng() % 100;
+            const int32_t height = 1 + rng() % 20;
+            const int32_t channels = (iteration % 2) ? 4 : 1;
+
+            const uint8_t threshold = static_cast<uint8_t>(byte(rng));
+            const uint32_t colorBGRA = static_cast<uint32_t>(rng());
+
+            // BGRA pixels are read as uint32_t, hence the aligned strides.
+            const size_t imageStride = channels * (width + 5 + rng() % 3);
+            const size_t maskStride = width + 7 + rng() % 5;
+
+            std::vector<uint8_t> image((height + 2) * imageStride);
+            std::vector<uint8_t> mask((height + 3) * maskStride);
+
+            for (uint8_t& value : image)
+            {
+                value = static_cast<uint8_t>(byte(rng));
+            }
+
+            for (uint8_t& value : mask)
+            {
+                value = static_cast<uint8_t>(byte(rng));
+            }
+
+            const size_t imageOffset = (rng() % 3) * imageStride + channels * (rng() % 6);
+            const size_t maskOffset = (rng() % 4) * maskStride + rng() % 8;
+
+            std::vector<uint8_t> expectedImage = image;
+
+            OverlayMaskPerPixel(
+                mask.data() + maskOffset,
+                maskStride,
+                threshold,
+                colorBGRA,
+                width,
+                height,
+                channels,
+                expectedImage.data() + imageOffset,
+                imageStride);
+
+            for (const rmcv::OverlayMaskIsa isa : c_isas)
+            {
+                if (!rmcv::IsOverlayMaskIsaSupported(isa))
+                {
+                    continue;
+                }
+
+                std::vector<uint8_t> actualImage = image;
+
+                rmcv::OverlayMaskRows(
+                    isa,
+                    mask.data() + maskOffset,
+                    maskStride,
+                    threshold,
+                    colorBGRA,
+                    width,
+                    height,
+                    channels,
+                    actualImage.data() + imageOffset,
+                    imageStride);
+
+                if (actualImage != expectedImage)
+                {
+                    fprintf(
+                        stderr,
+                        "%s: %dx%d %s image differs\n",
+                        GetIsaName(isa),
+                        width,
+                        height,
+                        (4 == channels) ? "BGRA" : "gray");
+
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    double GetMilliseconds(
+        const std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    //
+    // Times each instruction set overlaying a mask with about 5% of its pixels
+    // set, in short runs like the edges of an image.
+    //
+    void Benchmark(
+        std::mt19937& rng,
+        const int32_t width,
+        const int32_t height,
+        const int32_t frameCount)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        std::vector<uint8_t> mask(width * height, 0);
+
+        for (size_t index = 0; index < mask.size(); index += 1 + rng() % 80)
+        {
+            for (size_t run = 0; run < 4 && index < mask.size(); ++run)
+            {
+                mask[index++] = 255;
+            }
+        }
+
+        std::vector<uint8_t> image(4 * width * height, 32);
+
+        for (const rmcv::OverlayMaskIsa isa : c_isas)
+        {
+            if (!rmcv::IsOverlayMaskIsaSupported(isa))
+            {
+                continue;
+            }
+
+            const Clock::time_point startTime = Clock::now();
+
+            for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+            {
+                rmcv::OverlayMaskRows(
+                    isa,
+                    mask.data(),
+                    width,
+                    c_threshold,
+                    c_colorBGRA,
+                    width,
+                    height,
+                    4,
+                    image.data(),
+                    4 * width);
+            }
+
+            printf(
+                "%dx%d BGRA, %s: %.3f ms per frame\n",
+                width,
+                height,
+                GetIsaName(isa),
+                GetMilliseconds(Clock::now() - startTime) / frameCount);
+        }
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t frameCount =
+        (argc > 1) ? atoi(argv[1]) : 500;
+
+    if (frameCount <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 rng(0x4f564c59);
+
+    const bool passed =
+        Check(rng);
+
+    Benchmark(rng, 1280, 720, frameCount);
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
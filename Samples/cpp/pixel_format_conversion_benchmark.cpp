@@ -0,0 +1,286 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks Io::PackBgraToRgb, with each instruction set the CPU supports, against
+// the scalar reference on all pixel counts up to a few vector widths, without
+// writing past the end of the output, then measures it on 1280x720 photo video
+// frames against the per-byte push_back loop the recorder used before.
+//
+// Usage: pixel_format_conversion_benchmark [frames]
+//
+
+#include <Io/PixelFormatConversion.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct IsaDescription
+    {
+        Io::PixelFormatConversionIsa Isa;
+        const char* Name;
+    };
+
+    // The kernels the CPU supports, from the slowest to the fastest.
+    std::vector<IsaDescription> GetSupportedIsas()
+    {
+        std::vector<IsaDescription> isas;
+
+        isas.push_back({ Io::PixelFormatConversionIsa::Scalar, "scalar" });
+
+        switch (Io::GetPixelFormatConversionIsa())
+        {
+        case Io::PixelFormatConversionIsa::Avx2:
+            isas.push_back({ Io::PixelFormatConversionIsa::Ssse3, "SSSE3" });
+            isas.push_back({ Io::PixelFormatConversionIsa::Avx2, "AVX2" });
+            break;
+
+        case Io::PixelFormatConversionIsa::Ssse3:
+            isas.push_back({ Io::PixelFormatConversionIsa::Ssse3, "SSSE3" });
+            break;
+
+        case Io::PixelFormatConversionIsa::Neon:
+            isas.push_back({ Io::PixelFormatConversionIsa::Neon, "NEON" });
+            break;
+
+        default:
+            break;
+        }
+
+        return isas;
+    }
+
+    void PackBgraToRgbReference(
+        const uint8_t* bgraPixels,
+        const size_t numberOfPixels,
+        uint8_t* rgbPixels)
+    {
+        for (size_t i = 0; i < numberOfPixels; ++i)
+        {
+            rgbPixels[3 * i + 0] = bgraPixels[4 * i + 2];
+            rgbPixels[3 * i + 1] = bgraPixels[4 * i + 1];
+            rgbPixels[3 * i + 2] = bgraPixels[4 * i + 0];
+        }
+    }
+
+    //
+    // The conversion of the recorder before Io::PackBgraToRgb.
+    //
+    void PackBgraToRgbPushBack(
+        const uint8_t* bgraPixels,
+        const uint32_t width,
+        const uint32_t height,
+        std::vector<uint8_t>& bitmapData)
+    {
+        bitmapData.clear();
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const uint8_t* pixel = bgraPixels + 4 * (static_cast<size_t>(y) * width + x);
+
+                bitmapData.push_back(pixel[2]);
+                bitmapData.push_back(pixel[1]);
+                bitmapData.push_back(pixel[0]);
+            }
+        }
+    }
+
+    std::vector<uint8_t> CreateBgraImage(
+        const size_t numberOfPixels)
+    {
+        std::vector<uint8_t> image(numberOfPixels * 4);
+
+        uint32_t random = 0x9E3779B9;
+
+        for (uint8_t& value : image)
+        {
+            random = random * 1664525 + 1013904223;
+            value = static_cast<uint8_t>(random >> 24);
+        }
+
+        return image;
+    }
+
+    bool CheckIsa(
+        const IsaDescription& isa)
+    {
+        const size_t c_guardSize = 64;
+        const uint8_t c_guardValue = 0xA5;
+
+        const std::vector<uint8_t> bgraImage = CreateBgraImage(200);
+
+        std::vector<uint8_t> expected(200 * 3);
+        std::vector<uint8_t> actual;
+
+        for (size_t numberOfPixels = 0; numberOfPixels <= 200; ++numberOfPixels)
+        {
+            //
+            // Aligned and unaligned input and output, followed by guard bytes.
+            //
+            for (const size_t offset : { 0, 3 })
+            {
+                const std::vector<uint8_t> input(
+                    bgraImage.begin() + offset * 4,
+                    bgraImage.end());
+
+                const size_t count =
+                    (numberOfPixels <= input.size() / 4) ? numberOfPixels : input.size() / 4;
+
+                PackBgraToRgbReference(input.data(), count, expected.data());
+
+                actual.assign(offset + count * 3 + c_guardSize, c_guardValue);
+
+                Io::PackBgraToRgb(
+                    isa.Isa,
+                    input.data(),
+                    count,
+                    actual.data() + offset);
+
+                if (0 != memcmp(actual.data() + offset, expected.data(), count * 3))
+                {
+                    printf("  %s: wrong pixels for %zu pixels\n", isa.Name, count);
+                    return false;
+                }
+
+                for (size_t i = 0; i < actual.size(); ++i)
+                {
+                    const bool isOutput = i >= offset && i < offset + count * 3;
+
+                    if (!isOutput && c_guardValue != actual[i])
+                    {
+                        printf("  %s: wrote outside of the output for %zu pixels\n", isa.Name, count);
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    double GetMilliseconds(
+        const Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t frameCount =
+        (argc > 1) ? atoi(argv[1]) : 200;
+
+    if (frameCount <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<IsaDescription> isas = GetSupportedIsas();
+
+    bool passed = true;
+
+    for (const IsaDescription& isa : isas)
+    {
+        const bool isaPassed = CheckIsa(isa);
+
+        printf("%s: %s\n", isa.Name, isaPassed ? "matches the reference" : "FAILED");
+
+        passed = passed && isaPassed;
+    }
+
+    const uint32_t width = 1280;
+    const uint32_t height = 720;
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+
+    const std::vector<uint8_t> bgraImage = CreateBgraImage(pixelCount);
+
+    std::vector<uint8_t> expected(pixelCount * 3);
+
+    PackBgraToRgbReference(bgraImage.data(), pixelCount, expected.data());
+
+    std::vector<uint8_t> bitmapData;
+
+    const Clock::time_point pushBackStartTime = Clock::now();
+
+    for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+    {
+        //
+        // The recorder started from an empty vector for every frame.
+        //
+        std::vector<uint8_t>().swap(bitmapData);
+
+        PackBgraToRgbPushBack(bgraImage.data(), width, height, bitmapData);
+    }
+
+    const double pushBackTime =
+        GetMilliseconds(Clock::now() - pushBackStartTime) / frameCount;
+
+    passed = passed && bitmapData == expected;
+
+    printf(
+        "%ux%u BGRA to RGB:\n  push_back per byte: %.3f ms per frame, %.0f Mpx/s\n",
+        width,
+        height,
+        pushBackTime,
+        pixelCount / pushBackTime / 1000.0);
+
+    std::vector<uint8_t> rgbImage(pixelCount * 3);
+
+    for (const IsaDescription& isa : isas)
+    {
+        std::fill(rgbImage.begin(), rgbImage.end(), 0);
+
+        const Clock::time_point startTime = Clock::now();
+
+        for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        {
+            Io::PackBgraToRgb(
+                isa.Isa,
+                bgraImage.data(),
+                pixelCount,
+                rgbImage.data());
+        }
+
+        const double time =
+            GetMilliseconds(Clock::now() - startTime) / frameCount;
+
+        const bool isSame = rgbImage == expected;
+
+        printf(
+            "  PackBgraToRgb, %s: %.3f ms per frame, %.0f Mpx/s (%.1fx)%s\n",
+            isa.Name,
+            time,
+            pixelCount / time / 1000.0,
+            pushBackTime / time,
+            isSame ? "" : ", pixels differ");
+
+        passed = passed && isSame;
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,403 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Measures the throughput, in points per second, of the depth to point cloud
+// conversion on synthetic long throw and short throw depth frames, with each
+// instruction set the CPU supports, and checks that they all give the points
+// of the scalar conversion.
+//
+// Usage: point_cloud_benchmark [seconds per configuration]
+//
+
+#include <Io/PointCloud.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    struct Configuration
+    {
+        const char* Name;
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+
+        // Pixels further than this from the center don't map to the unit plane,
+        // like the corners of the long throw camera; zero if they all do.
+        float ValidRadius;
+    };
+
+    //
+    // Pinhole camera with some barrel distortion.
+    //
+    Io::MapImagePointFunction CreateCamera(
+        const Configuration& configuration)
+    {
+        const float focalLength = 0.5f * configuration.ImageWidth;
+        const float centerU = 0.5f * configuration.ImageWidth;
+        const float centerV = 0.5f * configuration.ImageHeight;
+        const float validRadius = configuration.ValidRadius;
+
+        return [=](float u, float v, float* x, float* y)
+        {
+            const float du = u - centerU;
+            const float dv = v - centerV;
+
+            if (validRadius > 0.0f &&
+                du * du + dv * dv > validRadius * validRadius)
+            {
+                return false;
+            }
+
+            const float distortion =
+                1.0f + 0.1f * (du * du + dv * dv) / (focalLength * focalLength);
+
+            *x = du / focalLength * distortion;
+            *y = dv / focalLength * distortion;
+
+            return true;
+        };
+    }
+
+    Io::UnprojectionLut CreateLut(
+        const Configuration& configuration)
+    {
+        Io::UnprojectionLut lut;
+
+        lut.Sample(
+            configuration.ImageWidth,
+            configuration.ImageHeight,
+            CreateCamera(configuration));
+
+        return lut;
+    }
+
+    //
+    // The LUT loaded from the camera space projection the recorder stores, and
+    // the points it interpolates between the pixel centers, are those of the
+    // camera, within a ten thousandth of the unit plane.
+    //
+    bool CheckLut(
+        const Configuration& configuration,
+        const Io::UnprojectionLut& lut)
+    {
+        const Io::MapImagePointFunction camera =
+            CreateCamera(configuration);
+
+        std::vector<float> cameraSpaceProjection;
+
+        Io::SampleCameraSpaceProjection(
+            configuration.ImageWidth,
+            configuration.ImageHeight,
+            camera,
+            cameraSpaceProjection);
+
+        Io::UnprojectionLut recordedLut;
+
+        recordedLut.AssignCameraSpaceProjection(
+            configuration.ImageWidth,
+            configuration.ImageHeight,
+            cameraSpaceProjection.data());
+
+        const float tolerance = 1e-4f;
+
+        for (size_t i = 0; i < static_cast<size_t>(configuration.ImageWidth) * configuration.ImageHeight; ++i)
+        {
+            //
+            // The pixels on the edge of the valid circle have corners on both
+            // sides of it, and may only be valid in one of the LUTs.
+            //
+            if (std::isnan(recordedLut.GetX()[i]) || std::isnan(lut.GetX()[i]))
+            {
+                continue;
+            }
+
+            if (std::fabs(recordedLut.GetX()[i] - lut.GetX()[i]) > tolerance ||
+                std::fabs(recordedLut.GetY()[i] - lut.GetY()[i]) > tolerance)
+            {
+                printf("%s: pixel %zu of the recorded LUT is off\n", configuration.Name, i);
+
+                return false;
+            }
+        }
+
+        uint32_t state = 0x87654321;
+
+        for (int i = 0; i < 100000; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            const float u = 0.5f + (state & 0xffff) / 65536.0f * (configuration.ImageWidth - 1);
+            const float v = 0.5f + (state >> 16) / 65536.0f * (configuration.ImageHeight - 1);
+
+            float x, y, expectedX, expectedY;
+
+            if (!lut.MapImagePointToCameraUnitPlane(u, v, &x, &y))
+            {
+                continue;
+            }
+
+            if (!camera(u, v, &expectedX, &expectedY) ||
+                std::fabs(x - expectedX) > tolerance ||
+                std::fabs(y - expectedY) > tolerance)
+            {
+                printf("%s: (%f, %f) is mapped to (%f, %f)\n", configuration.Name, u, v, x, y);
+
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //
+    // Mostly depths between 0.2 and 3.5 meters, with some invalid pixels.
+    //
+    std::vector<uint16_t> CreateDepth(
+        const Configuration& configuration)
+    {
+        std::vector<uint16_t> depth(
+            static_cast<size_t>(configuration.ImageWidth) * configuration.ImageHeight);
+
+        uint32_t state = 0x12345678;
+
+        for (uint16_t& value : depth)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            const uint32_t percentile = state % 100;
+
+            if (percentile < 10)
+            {
+                value = 0;
+            }
+            else if (percentile < 12)
+            {
+                value = 4090;
+            }
+            else
+            {
+                value = static_cast<uint16_t>(200 + (state >> 8) % 3300);
+            }
+        }
+
+        return depth;
+    }
+
+    //
+    // A pose a quarter turn about the vertical axis away from the origin, and
+    // a camera slightly offset from the frame.
+    //
+    void CreateCameraToOrigin(
+        float cameraToOrigin[16])
+    {
+        const float frameToOrigin[16] =
+        {
+            0.0f, 0.0f, -1.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.5f, 1.6f, -2.0f, 1.0f
+        };
+
+        const float angle = 0.1f;
+
+        const float cameraViewTransform[16] =
+        {
+            std::cos(angle), std::sin(angle), 0.0f, 0.0f,
+            -std::sin(angle), std::cos(angle), 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.01f, -0.02f, 0.05f, 1.0f
+        };
+
+        Io::ComputeCameraToOrigin(
+            frameToOrigin,
+            cameraViewTransform,
+            cameraToOrigin);
+    }
+
+    //
+    // Same valid points, within a hundredth of a millimeter.
+    //
+    bool IsSamePointCloud(
+        const std::vector<float>& points,
+        const std::vector<float>& expectedPoints)
+    {
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            if (std::isnan(points[i]) != std::isnan(expectedPoints[i]))
+            {
+                return false;
+            }
+
+            if (!std::isnan(points[i]) && std::fabs(points[i] - expectedPoints[i]) > 1e-5f)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool Run(
+        const Configuration& configuration,
+        double seconds)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        const Io::UnprojectionLut lut =
+            CreateLut(configuration);
+
+        if (!CheckLut(configuration, lut))
+        {
+            return false;
+        }
+
+        const std::vector<uint16_t> depth =
+            CreateDepth(configuration);
+
+        const size_t depthRowStride =
+            configuration.ImageWidth * sizeof(uint16_t);
+
+        float cameraToOrigin[16];
+
+        CreateCameraToOrigin(
+            cameraToOrigin);
+
+        const Io::DepthUnprojectionOptions options;
+
+        const size_t pointCount =
+            depth.size();
+
+        std::vector<float> expectedPoints(
+            3 * pointCount);
+
+        const size_t expectedValidPointCount =
+            Io::UnprojectDepth(
+                Io::PointCloudIsa::Scalar,
+                lut,
+                depth.data(),
+                depthRowStride,
+                cameraToOrigin,
+                options,
+                expectedPoints.data());
+
+        bool passed = true;
+
+        const Io::PointCloudIsa isas[] =
+        {
+            Io::PointCloudIsa::Scalar,
+            Io::PointCloudIsa::Avx2,
+            Io::PointCloudIsa::Neon
+        };
+
+        for (Io::PointCloudIsa isa : isas)
+        {
+            if (!Io::IsPointCloudIsaSupported(isa))
+            {
+                continue;
+            }
+
+            std::vector<float> points(
+                3 * pointCount);
+
+            const size_t validPointCount =
+                Io::UnprojectDepth(
+                    isa,
+                    lut,
+                    depth.data(),
+                    depthRowStride,
+                    cameraToOrigin,
+                    options,
+                    points.data());
+
+            const bool isCorrect =
+                validPointCount == expectedValidPointCount &&
+                IsSamePointCloud(points, expectedPoints);
+
+            uint64_t frames = 0;
+
+            const Clock::time_point startTime =
+                Clock::now();
+
+            double elapsedTime = 0.0;
+
+            do
+            {
+                Io::UnprojectDepth(
+                    isa,
+                    lut,
+                    depth.data(),
+                    depthRowStride,
+                    cameraToOrigin,
+                    options,
+                    points.data());
+
+                ++frames;
+
+                elapsedTime =
+                    std::chrono::duration<double>(Clock::now() - startTime).count();
+            }
+            while (elapsedTime < seconds);
+
+            printf(
+                "%-24s %-7s %8.1f Mpoints/s %8.3f ms/frame  %zu/%zu valid points, %s\n",
+                configuration.Name,
+                Io::GetPointCloudIsaName(isa),
+                frames * pointCount / elapsedTime / 1e6,
+                elapsedTime * 1e3 / frames,
+                validPointCount,
+                pointCount,
+                isCorrect ? "matches scalar" : "DOES NOT MATCH SCALAR");
+
+            passed = passed && isCorrect;
+        }
+
+        return passed;
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const double seconds =
+        (argc > 1) ? atof(argv[1]) : 2.0;
+
+    const Configuration configurations[] =
+    {
+        { "Long throw 448x450", 448, 450, 240.0f },
+        { "Short throw 512x512", 512, 512, 0.0f },
+    };
+
+    bool passed = true;
+
+    for (const Configuration& configuration : configurations)
+    {
+        passed = Run(
+            configuration,
+            seconds) && passed;
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
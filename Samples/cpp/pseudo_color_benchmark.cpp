@@ -0,0 +1,311 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Measures the pseudo-colouring of depth frames through an Io::PseudoColorTable,
+// with each instruction set the CPU supports, against the per-pixel float
+// mapping the SensorStreamViewer sample used before: scale, normalize and clamp
+// each depth, then look its colour up in a 1024 entry ramp, one row at a time
+// through a std::function. Checks that all of them give the same colours.
+//
+// Usage: pseudo_color_benchmark [frames]
+//
+
+#include <Io/PseudoColor.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+namespace
+{
+    const uint32_t c_invalidColor = 0x7F0000FF;
+    const uint16_t c_maximumValidDepth = 4000;
+
+    struct SensorConfiguration
+    {
+        const char* Name;
+        uint32_t Width;
+        uint32_t Height;
+        float MinimumDepth;
+        float MaximumDepth;
+    };
+
+    // Colours from blue to red, through cyan and yellow.
+    uint32_t GetRampColor(
+        const float value)
+    {
+        const float red = std::min(std::max(2.0f * value - 0.5f, 0.0f), 1.0f);
+        const float green = std::min(std::max(1.5f - std::fabs(2.0f * value - 1.0f) * 1.5f, 0.0f), 1.0f);
+        const float blue = std::min(std::max(1.5f - 2.0f * value, 0.0f), 1.0f);
+
+        return 0xFF000000 |
+            (static_cast<uint32_t>(red * 255.0f) << 16) |
+            (static_cast<uint32_t>(green * 255.0f) << 8) |
+            static_cast<uint32_t>(blue * 255.0f);
+    }
+
+    //
+    // The ramp, sampled like the LookupTable of the SensorStreamViewer sample.
+    //
+    class Ramp
+    {
+    public:
+        Ramp()
+            : _colors(1024)
+        {
+            for (size_t index = 0; index < _colors.size(); ++index)
+            {
+                _colors[index] = GetRampColor(
+                    static_cast<float>(index) / static_cast<float>(_colors.size()));
+            }
+        }
+
+        uint32_t GetValue(
+            const float value) const
+        {
+            const int32_t index = static_cast<int32_t>(value * _colors.size());
+
+            return _colors[std::min(std::max(0, index), static_cast<int32_t>(_colors.size()) - 1)];
+        }
+
+    private:
+        std::vector<uint32_t> _colors;
+    };
+
+    void PseudoColorRowPerPixel(
+        const Ramp& ramp,
+        const int32_t width,
+        const uint8_t* inputRowBytes,
+        uint8_t* outputRowBytes,
+        const float depthScale,
+        const float minimumDepth,
+        const float maximumDepth)
+    {
+        const float rangeReciprocal = 1.0f / (maximumDepth - minimumDepth);
+
+        const uint16_t* inputRow = reinterpret_cast<const uint16_t*>(inputRowBytes);
+        uint32_t* outputRow = reinterpret_cast<uint32_t*>(outputRowBytes);
+
+        for (int32_t x = 0; x < width; ++x)
+        {
+            if (inputRow[x] == 0 || inputRow[x] > c_maximumValidDepth)
+            {
+                outputRow[x] = c_invalidColor;
+            }
+            else
+            {
+                const float depth = static_cast<float>(inputRow[x]) * depthScale;
+
+                outputRow[x] = ramp.GetValue((depth - minimumDepth) * rangeReciprocal);
+            }
+        }
+    }
+
+    //
+    // A slanted floor and walls, with a few holes of invalid and saturated
+    // depths, and some noise.
+    //
+    std::vector<uint16_t> CreateDepthImage(
+        const SensorConfiguration& sensor)
+    {
+        std::vector<uint16_t> image(
+            static_cast<size_t>(sensor.Width) * sensor.Height);
+
+        uint32_t random = 0x9E3779B9;
+
+        for (uint32_t y = 0; y < sensor.Height; ++y)
+        {
+            for (uint32_t x = 0; x < sensor.Width; ++x)
+            {
+                random = random * 1664525 + 1013904223;
+
+                const float u = static_cast<float>(x) / sensor.Width;
+                const float v = static_cast<float>(y) / sensor.Height;
+
+                const float depth =
+                    sensor.MinimumDepth * 0.8f +
+                    (sensor.MaximumDepth * 1.2f - sensor.MinimumDepth * 0.8f) * (0.5f * u + 0.5f * v * v);
+
+                uint16_t value =
+                    static_cast<uint16_t>(depth * 1000.0f + static_cast<float>(random >> 28));
+
+                if ((random >> 8) % 16 == 0)
+                {
+                    value = ((random >> 16) & 1) ? 0 : 0xFFF0;
+                }
+
+                image[static_cast<size_t>(y) * sensor.Width + x] = value;
+            }
+        }
+
+        return image;
+    }
+
+    double GetMilliseconds(
+        const std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    bool Benchmark(
+        const SensorConfiguration& sensor,
+        const int32_t frameCount)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        const Ramp ramp;
+
+        Io::PseudoColorRange range = {};
+
+        range.Scale = 1.0f / 1000.0f;
+        range.Minimum = sensor.MinimumDepth;
+        range.Maximum = sensor.MaximumDepth;
+        range.MinimumValid = 1;
+        range.MaximumValid = c_maximumValidDepth;
+        range.InvalidColor = c_invalidColor;
+
+        const Clock::time_point tableStartTime = Clock::now();
+
+        const Io::PseudoColorTable<uint16_t> table(
+            range,
+            [&ramp](float value) { return ramp.GetValue(value); });
+
+        const double tableTime =
+            GetMilliseconds(Clock::now() - tableStartTime);
+
+        const std::vector<uint16_t> depthImage = CreateDepthImage(sensor);
+        const size_t pixelCount = depthImage.size();
+
+        std::vector<uint32_t> expectedImage(pixelCount);
+        std::vector<uint32_t> bgraImage(pixelCount);
+
+        using namespace std::placeholders;
+
+        const std::function<void(int32_t, const uint8_t*, uint8_t*)> transformScanline =
+            std::bind(&PseudoColorRowPerPixel, std::cref(ramp), _1, _2, _3, range.Scale, sensor.MinimumDepth, sensor.MaximumDepth);
+
+        const size_t stride = sensor.Width * sizeof(uint16_t);
+        const size_t bgraStride = sensor.Width * sizeof(uint32_t);
+
+        const Clock::time_point perPixelStartTime = Clock::now();
+
+        for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        {
+            for (uint32_t y = 0; y < sensor.Height; ++y)
+            {
+                transformScanline(
+                    static_cast<int32_t>(sensor.Width),
+                    reinterpret_cast<const uint8_t*>(depthImage.data()) + y * stride,
+                    reinterpret_cast<uint8_t*>(expectedImage.data()) + y * bgraStride);
+            }
+        }
+
+        const double perPixelTime =
+            GetMilliseconds(Clock::now() - perPixelStartTime) / frameCount;
+
+        printf(
+            "%s (%ux%u), table built in %.2f ms:\n  per pixel: %.3f ms per frame, %.0f Mpx/s\n",
+            sensor.Name,
+            sensor.Width,
+            sensor.Height,
+            tableTime,
+            perPixelTime,
+            pixelCount / perPixelTime / 1000.0);
+
+        bool passed = true;
+
+        const Io::PseudoColorIsa isas[] = { Io::PseudoColorIsa::Scalar, Io::PseudoColorIsa::Avx2 };
+        const char* isaNames[] = { "scalar", "AVX2" };
+
+        for (size_t isaIndex = 0; isaIndex < 2; ++isaIndex)
+        {
+            const Io::PseudoColorIsa isa = isas[isaIndex];
+
+            if (Io::PseudoColorIsa::Scalar != isa && Io::GetPseudoColorIsa() != isa)
+            {
+                continue;
+            }
+
+            std::fill(bgraImage.begin(), bgraImage.end(), 0);
+
+            const Clock::time_point startTime = Clock::now();
+
+            for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+            {
+                for (uint32_t y = 0; y < sensor.Height; ++y)
+                {
+                    table.Apply(
+                        isa,
+                        depthImage.data() + static_cast<size_t>(y) * sensor.Width,
+                        sensor.Width,
+                        bgraImage.data() + static_cast<size_t>(y) * sensor.Width);
+                }
+            }
+
+            const double time =
+                GetMilliseconds(Clock::now() - startTime) / frameCount;
+
+            const bool isSame =
+                bgraImage == expectedImage;
+
+            printf(
+                "  table, %s: %.3f ms per frame, %.0f Mpx/s (%.1fx)%s\n",
+                isaNames[isaIndex],
+                time,
+                pixelCount / time / 1000.0,
+                perPixelTime / time,
+                isSame ? "" : ", colours differ");
+
+            passed = passed && isSame;
+        }
+
+        return passed;
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t frameCount =
+        (argc > 1) ? atoi(argv[1]) : 500;
+
+    if (frameCount <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const SensorConfiguration sensors[] =
+    {
+        { "AHAT depth", 512, 512, 0.2f, 1.0f },
+        { "long throw depth", 448, 450, 0.5f, 4.0f },
+    };
+
+    bool passed = true;
+
+    for (const SensorConfiguration& sensor : sensors)
+    {
+        passed = Benchmark(sensor, frameCount) && passed;
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,229 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Measures the throughput of SensorStreamReceiver over the loopback interface,
+// and checks that it doesn't allocate once streaming.
+//
+// Usage: receiver_benchmark [seconds per configuration]
+//
+
+#include "LoopbackServer.h"
+#include "SensorStreamReceiver.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount(0);
+
+    struct Configuration
+    {
+        const char* Name;
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+        uint32_t PixelStride;
+        uint8_t VersionMinor;
+        uint32_t ExtensionsLength;
+    };
+
+    void Run(
+        const Configuration& configuration,
+        double seconds)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        SensorStream::LoopbackServerOptions options;
+
+        options.ImageWidth = configuration.ImageWidth;
+        options.ImageHeight = configuration.ImageHeight;
+        options.PixelStride = configuration.PixelStride;
+        options.VersionMinor = configuration.VersionMinor;
+        options.ExtensionsLength = configuration.ExtensionsLength;
+
+        SensorStream::LoopbackServer server(
+            options);
+
+        if (!server.Start())
+        {
+            fprintf(stderr, "failed to start the loopback server\n");
+            exit(EXIT_FAILURE);
+        }
+
+        SensorStream::FrameBufferPool pool(
+            8 /* frameCount */,
+            static_cast<size_t>(configuration.ImageWidth) * configuration.ImageHeight * configuration.PixelStride);
+
+        SensorStream::FrameQueue queue(
+            6 /* capacity */);
+
+        SensorStream::SensorStreamReceiver receiver(
+            pool);
+
+        if (!receiver.Connect("127.0.0.1", server.GetPort()))
+        {
+            fprintf(stderr, "failed to connect: %s\n", receiver.GetError().c_str());
+            exit(EXIT_FAILURE);
+        }
+
+        std::thread receivingThread(
+            [&]()
+            {
+                receiver.Run(
+                    queue);
+            });
+
+        //
+        // Consume the frames on this thread, checking that each payload belongs
+        // to its header, and start counting once the pooled frames have been
+        // used at least once.
+        //
+        uint64_t framesConsumed = 0;
+        uint64_t corruptFrames = 0;
+        uint64_t firstAllocationCount = 0;
+        uint64_t firstBytesReceived = 0;
+        uint64_t firstFramesReceived = 0;
+
+        Clock::time_point startTime;
+        Clock::time_point endTime;
+
+        const uint64_t warmUpFrames = 2 * pool.GetFrameCount();
+
+        for (;;)
+        {
+            SensorStream::FramePtr frame = queue.TryPop();
+
+            if (nullptr == frame)
+            {
+                std::this_thread::yield();
+
+                continue;
+            }
+
+            uint64_t frameIndex = 0;
+
+            memcpy(&frameIndex, frame->Payload, sizeof(frameIndex));
+
+            if (frameIndex != frame->Header.Timestamp)
+            {
+                ++corruptFrames;
+            }
+
+            frame.reset();
+
+            ++framesConsumed;
+
+            if (warmUpFrames == framesConsumed)
+            {
+                startTime = Clock::now();
+                firstAllocationCount = g_allocationCount;
+                firstBytesReceived = receiver.GetStatistics().BytesReceived;
+                firstFramesReceived = receiver.GetStatistics().FramesReceived;
+            }
+            else if (framesConsumed > warmUpFrames &&
+                     std::chrono::duration<double>(Clock::now() - startTime).count() >= seconds)
+            {
+                endTime = Clock::now();
+                break;
+            }
+        }
+
+        const uint64_t allocations =
+            g_allocationCount - firstAllocationCount;
+
+        const SensorStream::ReceiverStatistics statistics =
+            receiver.GetStatistics();
+
+        receiver.Close();
+        server.Stop();
+        receivingThread.join();
+
+        const double elapsedTime =
+            std::chrono::duration<double>(endTime - startTime).count();
+
+        const double frameRate =
+            (statistics.FramesReceived - firstFramesReceived) / elapsedTime;
+
+        const double gigabitsPerSecond =
+            (statistics.BytesReceived - firstBytesReceived) * 8.0 / elapsedTime / 1e9;
+
+        printf(
+            "%-32s %9.1f frames/s %7.2f Gbit/s  %llu not queued, %llu corrupt, %llu allocations\n",
+            configuration.Name,
+            frameRate,
+            gigabitsPerSecond,
+            static_cast<unsigned long long>(statistics.FramesNotQueued),
+            static_cast<unsigned long long>(corruptFrames),
+            static_cast<unsigned long long>(allocations));
+    }
+}
+
+void* operator new(
+    size_t size)
+{
+    ++g_allocationCount;
+
+    void* pointer = malloc((0 == size) ? 1 : size);
+
+    if (nullptr == pointer)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void operator delete(
+    void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(
+    void* pointer,
+    size_t /* size */) noexcept
+{
+    free(pointer);
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const double seconds =
+        (argc > 1) ? atof(argv[1]) : 3.0;
+
+    const Configuration configurations[] =
+    {
+        { "PV 1280x720 BGRA8, v0.1", 1280, 720, 4, 0x01, 0 },
+        { "PV 1280x720 BGRA8, v0.2 + 512 B", 1280, 720, 4, 0x02, 512 },
+        { "VLC 640x480 Gray8, v0.1", 640, 480, 1, 0x01, 0 },
+        { "Long throw 448x450 Gray16, v0.3", 448, 450, 2, 0x03, 0 },
+        { "64x64 Gray8, v0.1", 64, 64, 1, 0x01, 0 },
+    };
+
+    for (const Configuration& configuration : configurations)
+    {
+        Run(
+            configuration,
+            seconds);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,397 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Replays the frames of the HoloLens sensors into per-sensor tarballs, the way
+// the recorder does: each sensor has an Io::WriteBehindQueue whose writer
+// thread adds the frames to a tarball through an Io::TarArchiveWriter, while
+// the sensor thread keeps producing frames at the sensor's rate. Reports the
+// throughput sustained to disk and the frames that had to be dropped. A speed
+// up above 1 replays the sensors faster than real time, to find the rate the
+// disk can sustain.
+//
+// Also checks that a write that fails drops the remaining frames of its queue
+// and is reported once the queue has stopped.
+//
+// Usage: recorder_replay_benchmark [seconds] [speed up] [output folder]
+//
+
+#include <Io/TarArchive.h>
+#include <Io/WriteBehindQueue.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct SensorConfiguration
+    {
+        const char* Name;
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t BytesPerPixel;
+        double FramesPerSecond;
+    };
+
+    // The sensors the recorder can enable, at their native rates.
+    const SensorConfiguration c_sensors[] =
+    {
+        { "pv", 1280, 720, 3, 30.0 },
+        { "vlc_ll", 640, 480, 1, 30.0 },
+        { "vlc_lf", 640, 480, 1, 30.0 },
+        { "vlc_rf", 640, 480, 1, 30.0 },
+        { "vlc_rr", 640, 480, 1, 30.0 },
+        { "short_throw_depth", 448, 450, 2, 30.0 },
+        { "short_throw_reflectivity", 448, 450, 2, 30.0 },
+        { "long_throw_depth", 448, 450, 2, 5.0 },
+        { "long_throw_reflectivity", 448, 450, 2, 5.0 },
+    };
+
+    struct Frame
+    {
+        uint64_t Timestamp;
+        const SensorConfiguration* Sensor;
+        std::shared_ptr<const std::vector<uint8_t>> Pixels;
+    };
+
+    struct SensorStatistics
+    {
+        uint64_t FramesProduced;
+        uint64_t FramesDropped;
+        uint64_t BytesWritten;
+    };
+
+    //
+    // Adds a frame to a tarball as a PGM/PPM file, with the header and the
+    // pixels as separate spans.
+    //
+    uint64_t WriteFrame(
+        Io::TarArchiveWriter& archive,
+        const Frame& frame)
+    {
+        char header[64] = {};
+
+        const int headerSize = snprintf(
+            header,
+            sizeof(header),
+            "%s\n%u %u\n%u\n",
+            (3 == frame.Sensor->BytesPerPixel) ? "P6" : "P5",
+            frame.Sensor->Width,
+            frame.Sensor->Height,
+            (2 == frame.Sensor->BytesPerPixel) ? 65535u : 255u);
+
+        char fileName[128] = {};
+
+        snprintf(
+            fileName,
+            sizeof(fileName),
+            "%s/%020llu.%s",
+            frame.Sensor->Name,
+            static_cast<unsigned long long>(frame.Timestamp),
+            (3 == frame.Sensor->BytesPerPixel) ? "ppm" : "pgm");
+
+        const Io::TarballFileSpan spans[] =
+        {
+            { reinterpret_cast<const uint8_t*>(header), static_cast<size_t>(headerSize) },
+            { frame.Pixels->data(), frame.Pixels->size() },
+        };
+
+        archive.AddFile(
+            fileName,
+            spans,
+            2,
+            0 /* modificationTime */);
+
+        return static_cast<uint64_t>(headerSize) + frame.Pixels->size();
+    }
+
+    //
+    // Produces the frames of a sensor at its rate for the given time, then
+    // stops its queue, which writes the pending frames.
+    //
+    SensorStatistics ReplaySensor(
+        const SensorConfiguration& sensor,
+        const std::string& tarballFileName,
+        const double seconds,
+        const double speedUp)
+    {
+        FILE* tarball = fopen(tarballFileName.c_str(), "wb");
+
+        if (nullptr == tarball)
+        {
+            throw std::runtime_error("cannot create " + tarballFileName);
+        }
+
+        Io::TarArchiveWriter archive(
+            [tarball](const uint8_t* data, size_t size)
+        {
+            if (size != fwrite(data, 1, size, tarball))
+            {
+                throw std::runtime_error("fwrite failed");
+            }
+        });
+
+        Io::WriteBehindQueue<Frame> queue;
+
+        queue.Start(
+            [&archive](Frame& frame, uint64_t* bytesWritten)
+        {
+            *bytesWritten += WriteFrame(archive, frame);
+            return true;
+        });
+
+        //
+        // The frames cycle through a few buffers, like those of a media frame
+        // reader, with different contents so that the data is not all zeros.
+        //
+        std::vector<std::shared_ptr<const std::vector<uint8_t>>> buffers;
+
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            std::vector<uint8_t> pixels(
+                static_cast<size_t>(sensor.Width) * sensor.Height * sensor.BytesPerPixel);
+
+            for (size_t j = 0; j < pixels.size(); ++j)
+            {
+                pixels[j] = static_cast<uint8_t>(j * 7 + i);
+            }
+
+            buffers.push_back(
+                std::make_shared<const std::vector<uint8_t>>(std::move(pixels)));
+        }
+
+        const Clock::duration framePeriod =
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / (sensor.FramesPerSecond * speedUp)));
+
+        const uint64_t frameCount =
+            static_cast<uint64_t>(seconds * sensor.FramesPerSecond * speedUp);
+
+        const Clock::time_point startTime = Clock::now();
+
+        for (uint64_t i = 0; i < frameCount; ++i)
+        {
+            std::this_thread::sleep_until(
+                startTime + framePeriod * static_cast<Clock::rep>(i));
+
+            Frame frame;
+
+            frame.Timestamp = 131000000000000000ULL + i * 333333ULL;
+            frame.Sensor = &sensor;
+            frame.Pixels = buffers[i % buffers.size()];
+
+            queue.Push(frame);
+        }
+
+        queue.Stop();
+        archive.Finish();
+
+        fclose(tarball);
+
+        if (queue.HasFailed())
+        {
+            throw std::runtime_error(queue.GetFailureMessage());
+        }
+
+        SensorStatistics statistics;
+
+        statistics.FramesProduced = frameCount;
+        statistics.FramesDropped = queue.GetDroppedItems();
+        statistics.BytesWritten = queue.GetBytesWritten();
+
+        return statistics;
+    }
+
+    //
+    // A write that throws marks the queue as failed: the frame and all of the
+    // frames after it are dropped, and the failure is reported after Stop.
+    //
+    bool CheckWriteFailure()
+    {
+        Io::WriteBehindQueue<int> queue;
+
+        queue.SetMaximumDepth(1000);
+
+        int framesWritten = 0;
+
+        queue.Start(
+            [&framesWritten](int& frame, uint64_t* bytesWritten)
+        {
+            if (5 == frame)
+            {
+                throw std::runtime_error("disk full");
+            }
+
+            // Frames that are dropped without compromising the output.
+            if (2 == frame)
+            {
+                return false;
+            }
+
+            ++framesWritten;
+            *bytesWritten += 100;
+
+            return true;
+        });
+
+        for (int i = 0; i < 20; ++i)
+        {
+            queue.Push(i);
+        }
+
+        queue.Stop();
+
+        const bool ignoredAfterStop = !queue.Push(20);
+
+        const bool succeeded =
+            queue.HasFailed() &&
+            "disk full" == queue.GetFailureMessage() &&
+            4 == framesWritten &&
+            400 == queue.GetBytesWritten() &&
+            16 == queue.GetDroppedItems() &&
+            ignoredAfterStop;
+
+        //
+        // A new run starts afresh.
+        //
+        queue.Start(
+            [](int&, uint64_t*)
+        {
+            return true;
+        });
+
+        queue.Push(0);
+        queue.Stop();
+
+        return succeeded && !queue.HasFailed();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const double seconds =
+        (argc > 1) ? atof(argv[1]) : 5.0;
+
+    const double speedUp =
+        (argc > 2) ? atof(argv[2]) : 1.0;
+
+    const std::string outputFolder =
+        (argc > 3) ? argv[3] : ".";
+
+    if (seconds <= 0.0 || speedUp <= 0.0)
+    {
+        printf("usage: recorder_replay_benchmark [seconds] [speed up] [output folder]\n");
+        return EXIT_FAILURE;
+    }
+
+    const size_t sensorCount =
+        sizeof(c_sensors) / sizeof(c_sensors[0]);
+
+    std::vector<SensorStatistics> statistics(sensorCount);
+    std::vector<std::string> failures(sensorCount);
+    std::vector<std::thread> sensorThreads;
+
+    const Clock::time_point startTime = Clock::now();
+
+    for (size_t i = 0; i < sensorCount; ++i)
+    {
+        sensorThreads.emplace_back(
+            [&, i]()
+        {
+            try
+            {
+                statistics[i] = ReplaySensor(
+                    c_sensors[i],
+                    outputFolder + "/" + c_sensors[i].Name + ".tar",
+                    seconds,
+                    speedUp);
+            }
+            catch (const std::exception& exception)
+            {
+                failures[i] = exception.what();
+            }
+        });
+    }
+
+    for (std::thread& sensorThread : sensorThreads)
+    {
+        sensorThread.join();
+    }
+
+    //
+    // Includes the time taken to write the frames still queued at the end.
+    //
+    const double elapsedSeconds =
+        std::chrono::duration<double>(Clock::now() - startTime).count();
+
+    bool succeeded = true;
+    uint64_t totalBytesWritten = 0;
+    uint64_t totalFramesProduced = 0;
+    uint64_t totalFramesDropped = 0;
+
+    for (size_t i = 0; i < sensorCount; ++i)
+    {
+        const std::string tarballFileName =
+            outputFolder + "/" + c_sensors[i].Name + ".tar";
+
+        remove(tarballFileName.c_str());
+
+        if (!failures[i].empty())
+        {
+            printf("%-26s failed: %s\n", c_sensors[i].Name, failures[i].c_str());
+            succeeded = false;
+            continue;
+        }
+
+        printf(
+            "%-26s %6llu frames, %5llu dropped, %8.2f MB/s\n",
+            c_sensors[i].Name,
+            static_cast<unsigned long long>(statistics[i].FramesProduced),
+            static_cast<unsigned long long>(statistics[i].FramesDropped),
+            statistics[i].BytesWritten / elapsedSeconds / 1e6);
+
+        totalBytesWritten += statistics[i].BytesWritten;
+        totalFramesProduced += statistics[i].FramesProduced;
+        totalFramesDropped += statistics[i].FramesDropped;
+    }
+
+    printf(
+        "total: %llu frames at %.1fx real time, %llu dropped (%.2f%%), %.2f MB/s sustained over %.2f s\n",
+        static_cast<unsigned long long>(totalFramesProduced),
+        speedUp,
+        static_cast<unsigned long long>(totalFramesDropped),
+        (totalFramesProduced > 0) ? 100.0 * totalFramesDropped / totalFramesProduced : 0.0,
+        totalBytesWritten / elapsedSeconds / 1e6,
+        elapsedSeconds);
+
+    const bool writeFailureHandled =
+        CheckWriteFailure();
+
+    printf(
+        "write failure: %s\n",
+        writeFailureHandled ? "reported" : "NOT REPORTED");
+
+    succeeded = succeeded && writeFailureHandled;
+
+    printf("%s\n", succeeded ? "passed" : "FAILED");
+
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,525 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks the send queue of the Shared/Io library, which HoloLensForCV's
+// streaming server pipelines its writes through: first the policies applied
+// when the queue is full, the limit on the writes in flight and the counters,
+// then a load test over a TCP loopback connection. A camera thread queues 1 MB
+// frames at 120 Hz, a transport thread writes them to the socket in order and
+// reports each write complete after a simulated round trip, like the
+// completion of a StoreAsync call on the device, and a receiver checks that
+// the frames it gets are intact and in order.
+//
+// Usage: send_queue_loopback_test [frames] [round trip in ms]
+//
+
+#include <Io/FrameSendQueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t c_frameSize = 1024 * 1024;
+    const double c_framesPerSecond = 120.0;
+    const uint32_t c_keyframeInterval = 30;
+    const size_t c_queueCapacity = 4;
+
+    // The payloads are reused, as encoding them is not what is measured.
+    const uint32_t c_numberOfPayloads = 64;
+
+    //
+    // A frame is sent as its ordinal followed by a payload filled with a
+    // pattern derived from the ordinal.
+    //
+    struct Frame
+    {
+        uint32_t Ordinal;
+        std::shared_ptr<const std::vector<uint8_t>> Payload;
+    };
+
+    bool CheckPolicies()
+    {
+        bool passed = true;
+
+        auto check = [&passed](const bool condition, const char* description)
+        {
+            if (!condition)
+            {
+                printf("  %s\n", description);
+                passed = false;
+            }
+        };
+
+        int frame = 0;
+        size_t size = 0;
+
+        {
+            Io::FrameSendQueue<int> queue(2, 1, Io::SendQueuePolicy::DropOldest);
+
+            check(queue.Push(1, 10, true) && queue.Push(2, 20, false) && queue.Push(3, 30, false), "DropOldest refuses a frame");
+            check(queue.TryBeginSend(&frame, &size) && 2 == frame && 20 == size, "DropOldest does not evict the oldest frame");
+            check(!queue.TryBeginSend(&frame, &size), "more writes than allowed are in flight");
+
+            queue.EndSend(size, true);
+
+            check(queue.TryBeginSend(&frame, &size) && 3 == frame, "DropOldest reorders the frames");
+
+            queue.EndSend(size, false);
+
+            const Io::SendQueueStatistics statistics = queue.GetStatistics();
+
+            check(
+                3 == statistics.FramesQueued && 2 == statistics.FramesStarted && 1 == statistics.FramesSent &&
+                2 == statistics.FramesDropped && 20 == statistics.BytesSent,
+                "DropOldest miscounts the frames");
+        }
+
+        {
+            Io::FrameSendQueue<int> queue(2, 2, Io::SendQueuePolicy::DropNewest);
+
+            check(queue.Push(1, 1, true) && queue.Push(2, 1, false) && !queue.Push(3, 1, false), "DropNewest accepts a frame into a full queue");
+            check(queue.TryBeginSend(&frame, &size) && 1 == frame && queue.TryBeginSend(&frame, &size) && 2 == frame, "DropNewest reorders the frames");
+            check(!queue.TryBeginSend(&frame, &size), "an empty queue starts a write");
+        }
+
+        {
+            //
+            // Once a dependent frame is dropped, all of them are until the next
+            // keyframe, which replaces the frames of a full queue.
+            //
+            Io::FrameSendQueue<int> queue(2, 1, Io::SendQueuePolicy::KeyframeOnly);
+
+            check(queue.Push(1, 1, true) && queue.Push(2, 1, false), "KeyframeOnly refuses a frame with room to spare");
+            check(!queue.Push(3, 1, false), "KeyframeOnly accepts a dependent frame into a full queue");
+            check(queue.TryBeginSend(&frame, &size) && 1 == frame, "KeyframeOnly reorders the frames");
+            check(!queue.Push(4, 1, false), "KeyframeOnly accepts a dependent frame after one was dropped");
+            check(queue.Push(5, 1, true), "KeyframeOnly refuses a keyframe");
+            check(!queue.Push(6, 1, false) && queue.Push(7, 1, true), "KeyframeOnly does not replace a full queue with a keyframe");
+
+            queue.EndSend(size, true);
+
+            check(queue.TryBeginSend(&frame, &size) && 7 == frame && !queue.TryBeginSend(&frame, &size), "KeyframeOnly keeps replaced frames");
+            check(5 == queue.GetStatistics().FramesDropped, "KeyframeOnly miscounts the dropped frames");
+        }
+
+        {
+            //
+            // A blocked sender resumes once a write starts, and is released
+            // when the queue is closed.
+            //
+            Io::FrameSendQueue<int> queue(1, 1, Io::SendQueuePolicy::Block);
+
+            std::atomic<int> framesPushed(0);
+            std::atomic<bool> lastPushResult(true);
+
+            check(queue.Push(1, 1, true), "Block refuses a frame into an empty queue");
+
+            std::thread sender(
+                [&]()
+            {
+                lastPushResult = queue.Push(2, 1, false);
+                ++framesPushed;
+                lastPushResult = queue.Push(3, 1, false) && lastPushResult;
+                ++framesPushed;
+            });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            check(0 == framesPushed.load(), "Block does not block the sender of a full queue");
+            check(queue.TryBeginSend(&frame, &size) && 1 == frame, "Block reorders the frames");
+
+            while (framesPushed.load() < 1)
+            {
+                std::this_thread::yield();
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            check(1 == framesPushed.load(), "Block does not block the sender of a full queue");
+
+            queue.Close();
+            sender.join();
+
+            check(!lastPushResult.load(), "Close does not release a blocked sender");
+            check(queue.IsClosed() && !queue.Push(4, 1, true) && !queue.TryBeginSend(&frame, &size), "a closed queue accepts frames");
+
+            queue.EndSend(size, true);
+
+            const Io::SendQueueStatistics statistics = queue.GetStatistics();
+
+            check(
+                2 == statistics.FramesQueued && 1 == statistics.FramesSent && 3 == statistics.FramesDropped,
+                "Close miscounts the frames");
+        }
+
+        return passed;
+    }
+
+    bool SendAll(
+        const int socket,
+        const uint8_t* data,
+        size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+
+            if (sent <= 0)
+            {
+                return false;
+            }
+
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+
+        return true;
+    }
+
+    bool ReceiveAll(
+        const int socket,
+        uint8_t* data,
+        size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t received = recv(socket, data, size, 0);
+
+            if (received <= 0)
+            {
+                return false;
+            }
+
+            data += received;
+            size -= static_cast<size_t>(received);
+        }
+
+        return true;
+    }
+
+    uint8_t GetPatternByte(
+        const uint32_t ordinal,
+        const size_t offset)
+    {
+        return static_cast<uint8_t>((ordinal % c_numberOfPayloads) * 7 + offset);
+    }
+
+    std::vector<std::shared_ptr<const std::vector<uint8_t>>> CreatePayloads()
+    {
+        std::vector<std::shared_ptr<const std::vector<uint8_t>>> payloads;
+
+        for (uint32_t ordinal = 0; ordinal < c_numberOfPayloads; ++ordinal)
+        {
+            std::shared_ptr<std::vector<uint8_t>> payload =
+                std::make_shared<std::vector<uint8_t>>(c_frameSize);
+
+            for (size_t i = 0; i < c_frameSize; ++i)
+            {
+                (*payload)[i] = GetPatternByte(ordinal, i);
+            }
+
+            payloads.push_back(payload);
+        }
+
+        return payloads;
+    }
+
+    bool IsIntact(
+        const std::vector<uint8_t>& payload,
+        const uint32_t ordinal)
+    {
+        for (size_t i = 0; i < c_frameSize; ++i)
+        {
+            if (payload[i] != GetPatternByte(ordinal, i))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool CreateConnection(
+        int* senderSocket,
+        int* receiverSocket)
+    {
+        const int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t addressLength = sizeof(address);
+
+        bool connected =
+            listener >= 0 &&
+            0 == bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) &&
+            0 == listen(listener, 1) &&
+            0 == getsockname(listener, reinterpret_cast<sockaddr*>(&address), &addressLength);
+
+        *receiverSocket = connected ? socket(AF_INET, SOCK_STREAM, 0) : -1;
+
+        connected = connected &&
+            0 == connect(*receiverSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        *senderSocket = connected ? accept(listener, nullptr, nullptr) : -1;
+
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+
+        return connected && *senderSocket >= 0;
+    }
+
+    struct LoadTestResult
+    {
+        Io::SendQueueStatistics Statistics;
+        uint64_t FramesReceived;
+        bool Passed;
+    };
+
+    LoadTestResult RunLoadTest(
+        const Io::SendQueuePolicy policy,
+        const size_t maximumWritesInFlight,
+        const uint32_t numberOfFrames,
+        const std::vector<std::shared_ptr<const std::vector<uint8_t>>>& payloads,
+        const Clock::duration roundTrip)
+    {
+        LoadTestResult result = {};
+
+        int senderSocket = -1;
+        int receiverSocket = -1;
+
+        if (!CreateConnection(&senderSocket, &receiverSocket))
+        {
+            printf("  cannot connect over the loopback interface\n");
+            return result;
+        }
+
+        Io::FrameSendQueue<Frame> queue(c_queueCapacity, maximumWritesInFlight, policy);
+
+        std::atomic<bool> cameraDone(false);
+        bool transportFailed = false;
+        bool framesInOrder = true;
+
+        //
+        // Writes the frames in queue order. A write completes a round trip
+        // after the frame was handed to the socket.
+        //
+        std::thread transport(
+            [&]()
+            {
+                std::deque<std::pair<Clock::time_point, size_t>> completions;
+
+                for (;;)
+                {
+                    const bool lastFrameQueued = cameraDone.load();
+
+                    Frame frame;
+                    size_t sizeInBytes = 0;
+
+                    while (queue.TryBeginSend(&frame, &sizeInBytes))
+                    {
+                        transportFailed =
+                            !SendAll(senderSocket, reinterpret_cast<const uint8_t*>(&frame.Ordinal), sizeof(frame.Ordinal)) ||
+                            !SendAll(senderSocket, frame.Payload->data(), frame.Payload->size()) ||
+                            transportFailed;
+
+                        completions.emplace_back(Clock::now() + roundTrip, sizeInBytes);
+                    }
+
+                    if (lastFrameQueued && completions.empty())
+                    {
+                        break;
+                    }
+
+                    while (!completions.empty() && completions.front().first <= Clock::now())
+                    {
+                        queue.EndSend(completions.front().second, !transportFailed);
+                        completions.pop_front();
+                    }
+
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+
+                shutdown(senderSocket, SHUT_WR);
+            });
+
+        std::thread receiver(
+            [&]()
+            {
+                std::vector<uint8_t> payload(c_frameSize);
+
+                int64_t lastOrdinal = -1;
+                uint32_t ordinal;
+
+                while (ReceiveAll(receiverSocket, reinterpret_cast<uint8_t*>(&ordinal), sizeof(ordinal)) &&
+                       ReceiveAll(receiverSocket, payload.data(), payload.size()))
+                {
+                    framesInOrder = framesInOrder &&
+                        static_cast<int64_t>(ordinal) > lastOrdinal &&
+                        IsIntact(payload, ordinal);
+
+                    lastOrdinal = ordinal;
+
+                    ++result.FramesReceived;
+                }
+            });
+
+        const Clock::duration period =
+            std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / c_framesPerSecond));
+
+        Clock::time_point nextFrameTime = Clock::now();
+
+        for (uint32_t i = 0; i < numberOfFrames; ++i)
+        {
+            Frame frame;
+
+            frame.Ordinal = i;
+            frame.Payload = payloads[i % c_numberOfPayloads];
+
+            queue.Push(frame, sizeof(frame.Ordinal) + c_frameSize, 0 == i % c_keyframeInterval);
+
+            nextFrameTime += period;
+
+            std::this_thread::sleep_until(nextFrameTime);
+        }
+
+        cameraDone = true;
+
+        transport.join();
+        receiver.join();
+
+        close(senderSocket);
+        close(receiverSocket);
+
+        result.Statistics = queue.GetStatistics();
+
+        result.Passed =
+            !transportFailed &&
+            framesInOrder &&
+            result.FramesReceived == result.Statistics.FramesSent &&
+            numberOfFrames == result.Statistics.FramesSent + result.Statistics.FramesDropped;
+
+        return result;
+    }
+
+    const char* GetPolicyName(
+        const Io::SendQueuePolicy policy)
+    {
+        switch (policy)
+        {
+        case Io::SendQueuePolicy::DropOldest:
+            return "DropOldest";
+
+        case Io::SendQueuePolicy::DropNewest:
+            return "DropNewest";
+
+        case Io::SendQueuePolicy::Block:
+            return "Block";
+
+        case Io::SendQueuePolicy::KeyframeOnly:
+            return "KeyframeOnly";
+        }
+
+        return "?";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t numberOfFrames =
+        (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 300;
+
+    const double roundTripInMilliseconds =
+        (argc > 2) ? atof(argv[2]) : 10.0;
+
+    bool passed = CheckPolicies();
+
+    printf("send queue policies: %s\n", passed ? "behave as documented" : "FAILED");
+
+    const std::vector<std::shared_ptr<const std::vector<uint8_t>>> payloads =
+        CreatePayloads();
+
+    const Clock::duration roundTrip =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(roundTripInMilliseconds));
+
+    printf(
+        "%u 1 MB frames at %.0f Hz over TCP loopback, %.1f ms round trip, queue of %zu:\n",
+        numberOfFrames,
+        c_framesPerSecond,
+        roundTripInMilliseconds,
+        c_queueCapacity);
+
+    struct Configuration
+    {
+        Io::SendQueuePolicy Policy;
+        size_t MaximumWritesInFlight;
+    };
+
+    const Configuration configurations[] =
+    {
+        { Io::SendQueuePolicy::DropOldest, 1 },
+        { Io::SendQueuePolicy::DropOldest, 2 },
+        { Io::SendQueuePolicy::DropOldest, 4 },
+        { Io::SendQueuePolicy::DropNewest, 1 },
+        { Io::SendQueuePolicy::KeyframeOnly, 1 },
+        { Io::SendQueuePolicy::Block, 1 },
+    };
+
+    for (const Configuration& configuration : configurations)
+    {
+        const LoadTestResult result = RunLoadTest(
+            configuration.Policy,
+            configuration.MaximumWritesInFlight,
+            numberOfFrames,
+            payloads,
+            roundTrip);
+
+        const Io::SendQueueStatistics& statistics = result.Statistics;
+
+        printf(
+            "  %-12s %zu in flight: %4llu sent, %4llu dropped, queue latency mean %5.1f ms max %5.1f ms, %6.1f MB/s%s\n",
+            GetPolicyName(configuration.Policy),
+            configuration.MaximumWritesInFlight,
+            static_cast<unsigned long long>(statistics.FramesSent),
+            static_cast<unsigned long long>(statistics.FramesDropped),
+            (statistics.FramesStarted > 0) ? 1000.0 * statistics.TotalQueueLatencyInSeconds / statistics.FramesStarted : 0.0,
+            1000.0 * statistics.MaximumQueueLatencyInSeconds,
+            statistics.BytesSent / 1e6 / statistics.ElapsedTimeInSeconds,
+            result.Passed ? "" : ", frames lost, corrupted or reordered");
+
+        passed = result.Passed && passed;
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
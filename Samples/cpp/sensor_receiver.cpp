@@ -0,0 +1,145 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Connects to a HoloLensForCV streaming server and prints the frames it sends.
+//
+// Usage: sensor_receiver [-u] <host> [port]
+//
+// With -u, subscribes to the stream of a datagram streaming server instead of
+// connecting over TCP.
+//
+
+#include "DatagramReceiver.h"
+#include "SensorStreamReceiver.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(
+    int argc,
+    char** argv)
+{
+    const bool useDatagrams =
+        argc > 1 && 0 == strcmp(argv[1], "-u");
+
+    if (useDatagrams)
+    {
+        --argc;
+        ++argv;
+    }
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s [-u] <host> [port]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const char* host = argv[1];
+
+    const uint16_t port =
+        static_cast<uint16_t>((argc > 2) ? atoi(argv[2]) : 23940 /* PhotoVideo */);
+
+    //
+    // Large enough for the 1280x720 BGRA frames of the photo-video camera,
+    // including uncompressed Delta keyframes.
+    //
+    SensorStream::FrameBufferPool pool(
+        4 /* frameCount */,
+        1280 * 720 * 4 + SensorStream::ProtocolDeltaHeaderLength /* payloadCapacity */);
+
+    const auto printFrame =
+        [](SensorStream::FramePtr frame)
+        {
+            const SensorStream::FrameHeader& header = frame->Header;
+
+            printf(
+                "frame type %u, timestamp %llu, %ux%u, pixel stride %u, codec %u, %u bytes\n",
+                header.FrameType,
+                static_cast<unsigned long long>(header.Timestamp),
+                header.ImageWidth,
+                header.ImageHeight,
+                header.PixelStride,
+                static_cast<unsigned>(header.PayloadCodec),
+                header.PayloadLength);
+        };
+
+    if (useDatagrams)
+    {
+        SensorStream::DatagramReceiver receiver(
+            pool);
+
+        if (!receiver.Connect(host, port))
+        {
+            fprintf(stderr, "failed to subscribe to %s:%u: %s\n", host, port, receiver.GetError().c_str());
+
+            return EXIT_FAILURE;
+        }
+
+        printf("subscribed to %s:%u\n", host, port);
+
+        for (;;)
+        {
+            SensorStream::FramePtr frame = receiver.ReceiveFrame();
+
+            if (nullptr == frame)
+            {
+                break;
+            }
+
+            printFrame(
+                std::move(frame));
+        }
+
+        const SensorStream::DatagramReceiverStatistics statistics =
+            receiver.GetStatistics();
+
+        printf(
+            "%s; %llu frames received, %llu dropped; %llu datagrams lost\n",
+            receiver.GetError().c_str(),
+            static_cast<unsigned long long>(statistics.FramesReceived),
+            static_cast<unsigned long long>(statistics.FramesDropped + statistics.Datagrams.FramesDropped),
+            static_cast<unsigned long long>(statistics.Datagrams.DatagramsLost));
+
+        return EXIT_SUCCESS;
+    }
+
+    SensorStream::SensorStreamReceiver receiver(
+        pool);
+
+    if (!receiver.Connect(host, port))
+    {
+        fprintf(stderr, "failed to connect to %s:%u: %s\n", host, port, receiver.GetError().c_str());
+
+        return EXIT_FAILURE;
+    }
+
+    printf("connected to %s:%u\n", host, port);
+
+    receiver.Run(
+        printFrame);
+
+    const SensorStream::ReceiverStatistics statistics =
+        receiver.GetStatistics();
+
+    printf(
+        "%s; %llu frames received, %llu dropped, %llu too large\n",
+        receiver.GetError().c_str(),
+        static_cast<unsigned long long>(statistics.FramesReceived),
+        static_cast<unsigned long long>(statistics.FramesDropped),
+        static_cast<unsigned long long>(statistics.FramesTooLarge));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,476 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Measures the storage codecs HoloLensForCV's recorder can store the frames of
+// each sensor with: raw, LZ4 and the depth codec. Frames go through an
+// Io::FrameCompressor like in SensorFrameRecorderSink, including its
+// fallbacks: the depth codec applies to 16-bit frames only, other frames are
+// compressed with LZ4, and frames that don't shrink are stored raw. Every
+// frame is decompressed and checked bit for bit.
+//
+// Reports, per SensorType, the compression ratio of the stored files and the
+// encode and decode throughput in MB/s of bitmap files, on synthetic frames
+// and, if given, on the frames of recorded tarballs (<sensor>.tar files, as
+// downloaded from the HoloLens).
+//
+// Usage: storage_codec_benchmark [synthetic frames per sensor] [tarball...]
+//
+
+#include "BitmapTarballReader.h"
+
+#include <Io/FrameCodec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+namespace
+{
+    struct SensorConfiguration
+    {
+        // The SensorType, and the name the recorder gives its tarball.
+        const char* SensorType;
+        const char* Name;
+        uint32_t Width;
+        uint32_t Height;
+
+        // 3 for PPM files, 2 for Gray16 PGM files.
+        uint32_t BytesPerPixel;
+    };
+
+    const SensorConfiguration c_sensors[] =
+    {
+        { "PhotoVideo", "pv", 1280, 720, 3 },
+        { "ShortThrowToFDepth", "short_throw_depth", 448, 450, 2 },
+        { "ShortThrowToFReflectivity", "short_throw_reflectivity", 448, 450, 2 },
+        { "LongThrowToFDepth", "long_throw_depth", 448, 450, 2 },
+        { "LongThrowToFReflectivity", "long_throw_reflectivity", 448, 450, 2 },
+        { "VisibleLightLeftLeft", "vlc_ll", 640, 480, 1 },
+        { "VisibleLightLeftFront", "vlc_lf", 640, 480, 1 },
+        { "VisibleLightRightFront", "vlc_rf", 640, 480, 1 },
+        { "VisibleLightRightRight", "vlc_rr", 640, 480, 1 },
+    };
+
+    const Io::FrameCodec c_codecs[] =
+    {
+        Io::FrameCodec::Lz4,
+        Io::FrameCodec::Depth,
+    };
+
+    const char* GetCodecName(
+        const Io::FrameCodec codec)
+    {
+        switch (codec)
+        {
+        case Io::FrameCodec::Raw:
+            return "raw";
+        case Io::FrameCodec::Lz4:
+            return "lz4";
+        case Io::FrameCodec::Depth:
+            return "depth";
+        }
+
+        return "?";
+    }
+
+    uint32_t NextRandom(
+        uint64_t& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    double GetCpuSeconds()
+    {
+        timespec time;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+        return time.tv_sec + time.tv_nsec * 1e-9;
+    }
+
+    struct CodecStatistics
+    {
+        uint64_t Frames = 0;
+        uint64_t BitmapBytes = 0;
+        uint64_t StoredBytes = 0;
+        uint64_t FramesStoredRaw = 0;
+        double EncodeSeconds = 0.0;
+        double DecodeSeconds = 0.0;
+    };
+
+    struct SensorStatistics
+    {
+        std::string SensorType;
+        CodecStatistics Codecs[sizeof(c_codecs) / sizeof(c_codecs[0])];
+    };
+
+    class Benchmark
+    {
+    public:
+        Benchmark()
+            : _passed(true)
+        {
+        }
+
+        //
+        // Stores a bitmap file with each codec, and checks that it reads
+        // back unchanged.
+        //
+        void AddFrame(
+            SensorStatistics& statistics,
+            const uint8_t* header,
+            const size_t headerSize,
+            const uint8_t* pixels,
+            const size_t pixelDataSize,
+            const uint32_t numberOfRows,
+            const bool is16BitPerPixel)
+        {
+            for (size_t i = 0; i < sizeof(c_codecs) / sizeof(c_codecs[0]); ++i)
+            {
+                CodecStatistics& codecStatistics = statistics.Codecs[i];
+
+                const double encodeStart = GetCpuSeconds();
+
+                const Io::FrameCodec storedCodec = _frameCompressor.Compress(
+                    c_codecs[i],
+                    header,
+                    headerSize,
+                    pixels,
+                    pixelDataSize,
+                    numberOfRows,
+                    is16BitPerPixel);
+
+                codecStatistics.EncodeSeconds += GetCpuSeconds() - encodeStart;
+
+                ++codecStatistics.Frames;
+                codecStatistics.BitmapBytes += headerSize + pixelDataSize;
+
+                if (Io::FrameCodec::Raw == storedCodec)
+                {
+                    ++codecStatistics.FramesStoredRaw;
+                    codecStatistics.StoredBytes += headerSize + pixelDataSize;
+
+                    continue;
+                }
+
+                codecStatistics.StoredBytes += _frameCompressor.GetSize();
+
+                const double decodeStart = GetCpuSeconds();
+
+                Io::DecompressFrame(
+                    _frameCompressor.GetData(),
+                    _frameCompressor.GetSize(),
+                    _bitmapFile);
+
+                codecStatistics.DecodeSeconds += GetCpuSeconds() - decodeStart;
+
+                if (_bitmapFile.size() != headerSize + pixelDataSize ||
+                    0 != memcmp(_bitmapFile.data(), header, headerSize) ||
+                    0 != memcmp(_bitmapFile.data() + headerSize, pixels, pixelDataSize))
+                {
+                    printf(
+                        "%s: a frame stored with %s does not read back unchanged\n",
+                        statistics.SensorType.c_str(),
+                        GetCodecName(c_codecs[i]));
+
+                    _passed = false;
+                }
+            }
+        }
+
+        bool HasPassed() const
+        {
+            return _passed;
+        }
+
+    private:
+        Io::FrameCompressor _frameCompressor;
+        std::vector<uint8_t> _bitmapFile;
+        bool _passed;
+    };
+
+    //
+    // Camera images: shading, an object moving from frame to frame and sensor
+    // noise. Depth images: a sloped wall and a box moving in front of it in
+    // millimeters, with noise growing with the distance and no returns (zero)
+    // past the edges of the wall. Reflectivity images: the active brightness
+    // of the same scene, falling off with the distance, with shot noise.
+    //
+    std::vector<uint8_t> CreateFrame(
+        const SensorConfiguration& sensor,
+        const size_t frameIndex,
+        uint64_t& random)
+    {
+        std::vector<uint8_t> frame(
+            static_cast<size_t>(sensor.Width) * sensor.Height * sensor.BytesPerPixel);
+
+        const bool isDepth = (nullptr != strstr(sensor.Name, "depth"));
+
+        const double t = 0.15 * static_cast<double>(frameIndex);
+
+        const uint32_t boxLeft = static_cast<uint32_t>(sensor.Width * (0.2 + 0.03 * frameIndex));
+        const uint32_t boxTop = sensor.Height / 3;
+
+        for (uint32_t y = 0; y < sensor.Height; ++y)
+        {
+            for (uint32_t x = 0; x < sensor.Width; ++x)
+            {
+                const bool inBox =
+                    x >= boxLeft && x < boxLeft + sensor.Width / 4 &&
+                    y >= boxTop && y < boxTop + sensor.Height / 3;
+
+                const size_t pixel = static_cast<size_t>(y) * sensor.Width + x;
+
+                if (2 == sensor.BytesPerPixel)
+                {
+                    const bool noReturn = x < sensor.Width / 16 || y > sensor.Height * 15 / 16;
+
+                    const double distance = inBox ? 1200.0 : 2600.0 + 1.5 * x - 0.8 * y;
+
+                    double value;
+
+                    if (isDepth)
+                    {
+                        const int noise = static_cast<int>(NextRandom(random) % 9) - 4;
+
+                        value = distance + noise * distance / 2000.0;
+                    }
+                    else
+                    {
+                        const double brightness = 4.0e8 / (distance * distance);
+                        const int noise = static_cast<int>(NextRandom(random) % 17) - 8;
+
+                        value = brightness + noise * sqrt(brightness) / 8.0;
+                    }
+
+                    const uint16_t sample = noReturn ?
+                        0 : static_cast<uint16_t>(std::max(0.0, std::min(65535.0, value)));
+
+                    memcpy(frame.data() + 2 * pixel, &sample, sizeof(sample));
+
+                    continue;
+                }
+
+                for (uint32_t channel = 0; channel < sensor.BytesPerPixel; ++channel)
+                {
+                    const double shading =
+                        110.0 +
+                        50.0 * sin(0.013 * x + t + channel) * cos(0.021 * y - 0.5 * t) +
+                        (inBox ? 60.0 : 0.0) +
+                        (0 == (x / 64 + y / 48) % 5 ? -40.0 : 0.0);
+
+                    const int noise = static_cast<int>(NextRandom(random) % 5) - 2;
+
+                    frame[pixel * sensor.BytesPerPixel + channel] =
+                        static_cast<uint8_t>(std::max(0.0, std::min(255.0, shading + noise)));
+                }
+            }
+        }
+
+        return frame;
+    }
+
+    void PrintStatistics(
+        const SensorStatistics& statistics)
+    {
+        // Each codec stores the same bitmap files.
+        const CodecStatistics& raw = statistics.Codecs[0];
+
+        printf(
+            "  %-26s %6llu frames, raw %7.1f MB",
+            statistics.SensorType.c_str(),
+            static_cast<unsigned long long>(raw.Frames),
+            raw.BitmapBytes / 1e6);
+
+        for (size_t i = 0; i < sizeof(c_codecs) / sizeof(c_codecs[0]); ++i)
+        {
+            const CodecStatistics& codecStatistics = statistics.Codecs[i];
+
+            printf(
+                " | %-5s %5.2fx, encode %6.0f MB/s, decode %6.0f MB/s",
+                GetCodecName(c_codecs[i]),
+                static_cast<double>(codecStatistics.BitmapBytes) / codecStatistics.StoredBytes,
+                codecStatistics.BitmapBytes / 1e6 / codecStatistics.EncodeSeconds,
+                (codecStatistics.DecodeSeconds > 0.0) ?
+                    codecStatistics.BitmapBytes / 1e6 / codecStatistics.DecodeSeconds :
+                    0.0);
+
+            if (0 != codecStatistics.FramesStoredRaw)
+            {
+                printf(
+                    " (%llu stored raw)",
+                    static_cast<unsigned long long>(codecStatistics.FramesStoredRaw));
+            }
+        }
+
+        printf("\n");
+    }
+
+    void RunSynthetic(
+        Benchmark& benchmark,
+        const int32_t frameCount)
+    {
+        uint64_t random = 7;
+
+        printf("Synthetic frames (the depth codec falls back to lz4 for 8-bit frames):\n");
+
+        for (const SensorConfiguration& sensor : c_sensors)
+        {
+            SensorStatistics statistics;
+            statistics.SensorType = sensor.SensorType;
+
+            char header[64] = {};
+
+            const int headerSize = snprintf(
+                header,
+                sizeof(header),
+                "%s\n%u %u\n%u\n",
+                (3 == sensor.BytesPerPixel) ? "P6" : "P5",
+                sensor.Width,
+                sensor.Height,
+                (2 == sensor.BytesPerPixel) ? 65535u : 255u);
+
+            for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+            {
+                const std::vector<uint8_t> pixels =
+                    CreateFrame(sensor, frameIndex, random);
+
+                benchmark.AddFrame(
+                    statistics,
+                    reinterpret_cast<const uint8_t*>(header),
+                    static_cast<size_t>(headerSize),
+                    pixels.data(),
+                    pixels.size(),
+                    sensor.Height,
+                    2 == sensor.BytesPerPixel);
+            }
+
+            PrintStatistics(statistics);
+        }
+    }
+
+    //
+    // The SensorType of the frames of a tarball, from the folder the recorder
+    // stores them in.
+    //
+    std::string GetSensorType(
+        const std::string& sensorName)
+    {
+        for (const SensorConfiguration& sensor : c_sensors)
+        {
+            if (sensorName == sensor.Name)
+            {
+                return sensor.SensorType;
+            }
+        }
+
+        return sensorName;
+    }
+
+    bool RunRecorded(
+        Benchmark& benchmark,
+        const char* tarballPath)
+    {
+        SensorStream::BitmapTarballReader reader;
+
+        if (!reader.Open(tarballPath))
+        {
+            printf("%s\n", reader.GetError().c_str());
+            return false;
+        }
+
+        std::map<std::string, SensorStatistics> statistics;
+
+        SensorStream::RecordedBitmap bitmap;
+
+        while (reader.ReadBitmap(&bitmap))
+        {
+            SensorStatistics& sensorStatistics = statistics[bitmap.SensorName];
+
+            sensorStatistics.SensorType = GetSensorType(bitmap.SensorName);
+
+            benchmark.AddFrame(
+                sensorStatistics,
+                bitmap.Header,
+                bitmap.HeaderSize,
+                bitmap.Pixels,
+                bitmap.PixelDataSize,
+                bitmap.ImageHeight,
+                2 == bitmap.BytesPerPixel);
+        }
+
+        printf(
+            "\n%s (%llu other files skipped):\n",
+            tarballPath,
+            static_cast<unsigned long long>(reader.GetSkippedFileCount()));
+
+        for (const auto& sensorStatistics : statistics)
+        {
+            PrintStatistics(sensorStatistics.second);
+        }
+
+        return true;
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t frameCount =
+        (argc > 1) ? atoi(argv[1]) : 10;
+
+    if (frameCount <= 0)
+    {
+        fprintf(stderr, "usage: %s [synthetic frames per sensor] [tarball...]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    Benchmark benchmark;
+
+    bool passed = true;
+
+    try
+    {
+        RunSynthetic(
+            benchmark,
+            frameCount);
+
+        for (int i = 2; i < argc; ++i)
+        {
+            passed = RunRecorded(benchmark, argv[i]) && passed;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        printf("failed: %s\n", exception.what());
+        passed = false;
+    }
+
+    passed = benchmark.HasPassed() && passed;
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,405 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Writes a tarball and its index the way the recorder does, through the
+// Io::TarArchiveWriter of the Shared/Io library, and reads them back through
+// Io::TarArchiveScanner and Io::TarIndex: frames looked up by name and by
+// timestamp must hold the bytes that were written. The tarball is left on
+// disk so that it can also be listed with tar.
+//
+// Usage: tar_round_trip_test [tarball, round_trip.tar by default] [frames]
+//
+
+#include <Io/TarArchive.h>
+#include <Io/TarIndex.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    bool g_succeeded = true;
+
+    void Check(
+        const bool condition,
+        const char* description)
+    {
+        if (!condition)
+        {
+            printf("check failed: %s\n", description);
+            g_succeeded = false;
+        }
+    }
+
+    struct WrittenFrame
+    {
+        std::string FileName;
+        uint64_t Timestamp;
+        std::vector<uint8_t> Data;
+        uint64_t DataOffset;
+        uint32_t PixelDataOffset;
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    // Frames of the sizes the recorder stores: small and large, odd widths so
+    // that the files need padding, and spans on both sides of the size the
+    // writer stages next to the headers.
+    WrittenFrame MakeFrame(
+        const size_t index)
+    {
+        static const uint32_t c_sizes[][2] =
+        {
+            { 1, 1 },
+            { 17, 3 },
+            { 160, 120 },
+            { 320, 288 },
+            { 641, 481 },
+            { 8, 2047 },
+        };
+
+        const uint32_t* size =
+            c_sizes[index % (sizeof(c_sizes) / sizeof(c_sizes[0]))];
+
+        WrittenFrame frame;
+
+        frame.Width = size[0];
+        frame.Height = size[1];
+
+        //
+        // Timestamps are not in order, as when two sensors share a tarball.
+        //
+        frame.Timestamp =
+            131000000000000000ULL + 333333ULL * (index ^ 1);
+
+        char fileName[64] = {};
+
+        snprintf(
+            fileName,
+            sizeof(fileName),
+            "%llu.pgm",
+            static_cast<unsigned long long>(frame.Timestamp));
+
+        frame.FileName = fileName;
+
+        //
+        // Some frames are stored in a folder of the archive.
+        //
+        if (0 == index % 4)
+        {
+            frame.FileName = "sensor/" + frame.FileName;
+        }
+
+        char header[64] = {};
+
+        const int headerSize = snprintf(
+            header,
+            sizeof(header),
+            "P5\n%u %u\n255\n",
+            frame.Width,
+            frame.Height);
+
+        frame.PixelDataOffset = static_cast<uint32_t>(headerSize);
+
+        frame.Data.assign(header, header + headerSize);
+
+        for (uint32_t i = 0; i < frame.Width * frame.Height; ++i)
+        {
+            frame.Data.push_back(static_cast<uint8_t>(i * 31 + index));
+        }
+
+        frame.DataOffset = 0;
+
+        return frame;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* tarballFileName =
+        (argc > 1) ? argv[1] : "round_trip.tar";
+
+    const size_t frameCount =
+        (argc > 2) ? static_cast<size_t>(atoi(argv[2])) : 100;
+
+    const std::string indexFileName =
+        std::string(tarballFileName) + ".idx";
+
+    std::vector<WrittenFrame> frames;
+
+    //
+    // Write the tarball and its index.
+    //
+    {
+        FILE* tarball = fopen(tarballFileName, "wb");
+        FILE* index = fopen(indexFileName.c_str(), "wb");
+
+        if (nullptr == tarball || nullptr == index)
+        {
+            printf("cannot create %s\n", tarballFileName);
+            return EXIT_FAILURE;
+        }
+
+        Io::TarArchiveWriter writer(
+            [tarball](const uint8_t* data, size_t size)
+        {
+            if (size != fwrite(data, 1, size, tarball))
+            {
+                throw std::runtime_error("fwrite failed");
+            }
+        });
+
+        Io::TarIndexHeader indexHeader = {};
+
+        indexHeader.Cookie = Io::TarIndexCookie;
+        indexHeader.VersionMajor = Io::TarIndexVersionMajor;
+        indexHeader.VersionMinor = Io::TarIndexVersionMinor;
+        indexHeader.RecordSize = sizeof(Io::TarIndexRecord);
+
+        fwrite(&indexHeader, sizeof(indexHeader), 1, index);
+
+        for (size_t i = 0; i < frameCount; ++i)
+        {
+            WrittenFrame frame = MakeFrame(i);
+
+            //
+            // The header and the pixels are separate spans, as in the recorder.
+            //
+            const Io::TarballFileSpan spans[] =
+            {
+                { frame.Data.data(), frame.PixelDataOffset },
+                { frame.Data.data() + frame.PixelDataOffset, frame.Data.size() - frame.PixelDataOffset },
+            };
+
+            frame.DataOffset = writer.AddFile(
+                frame.FileName,
+                spans,
+                2,
+                1500000000 /* modificationTime */);
+
+            Io::TarIndexRecord record = {};
+
+            record.Timestamp = frame.Timestamp;
+            record.DataOffset = frame.DataOffset;
+            record.DataSize = frame.Data.size();
+            record.PixelDataOffset = frame.PixelDataOffset;
+            record.PixelFormat = static_cast<uint32_t>(Io::TarIndexPixelFormat::Gray8);
+            record.ImageWidth = frame.Width;
+            record.ImageHeight = frame.Height;
+            record.RowStride = frame.Width;
+
+            fwrite(&record, sizeof(record), 1, index);
+
+            frames.push_back(std::move(frame));
+        }
+
+        writer.Finish();
+
+        Check(0 == writer.GetWrittenSize() % Io::TarBlockSize, "archive is a whole number of blocks");
+        Check(static_cast<long>(writer.GetWrittenSize()) == ftell(tarball), "written size");
+
+        fclose(tarball);
+        fclose(index);
+    }
+
+    //
+    // Read the whole archive and index back into memory.
+    //
+    std::vector<uint8_t> archive;
+    std::vector<uint8_t> indexFile;
+
+    for (int file = 0; file < 2; ++file)
+    {
+        FILE* input = fopen((0 == file) ? tarballFileName : indexFileName.c_str(), "rb");
+
+        if (nullptr == input)
+        {
+            printf("cannot open %s\n", tarballFileName);
+            return EXIT_FAILURE;
+        }
+
+        std::vector<uint8_t>& contents =
+            (0 == file) ? archive : indexFile;
+
+        uint8_t buffer[65536];
+        size_t numberOfBytesRead = 0;
+
+        while (0 != (numberOfBytesRead = fread(buffer, 1, sizeof(buffer), input)))
+        {
+            contents.insert(contents.end(), buffer, buffer + numberOfBytesRead);
+        }
+
+        fclose(input);
+    }
+
+    Io::TarArchiveScanner scanner(
+        archive.size(),
+        [&archive](uint64_t offset, void* buffer, size_t size)
+    {
+        if (offset > archive.size() || size > archive.size() - offset)
+        {
+            throw std::runtime_error("read past the end of the archive");
+        }
+
+        memcpy(buffer, archive.data() + offset, size);
+    });
+
+    //
+    // Walk the entries in archive order.
+    //
+    {
+        Io::TarEntry entry;
+        size_t entryCount = 0;
+
+        while (scanner.ReadNextEntry(&entry))
+        {
+            if (entryCount < frames.size())
+            {
+                const WrittenFrame& frame = frames[entryCount];
+
+                Check(frame.FileName == entry.FileName, "entry name in archive order");
+                Check(frame.DataOffset == entry.DataOffset, "entry data offset");
+                Check(frame.Data.size() == entry.DataSize, "entry data size");
+                Check('0' == entry.Type, "entry type");
+            }
+
+            ++entryCount;
+        }
+
+        Check(frames.size() == entryCount, "number of entries");
+    }
+
+    //
+    // Look the frames up by name, with either kind of slash, and read them.
+    //
+    {
+        std::vector<uint8_t> data;
+
+        for (const WrittenFrame& frame : frames)
+        {
+            std::string fileName = frame.FileName;
+
+            for (char& c : fileName)
+            {
+                c = ('/' == c) ? '\\' : c;
+            }
+
+            Io::TarEntry entry;
+
+            if (!scanner.FindEntry(fileName, &entry))
+            {
+                Check(false, "entry found by name");
+                continue;
+            }
+
+            //
+            // Read in pieces that straddle the blocks of the archive.
+            //
+            data.assign(frame.Data.size() + 1, 0);
+
+            uint64_t position = 0;
+
+            while (const size_t numberOfBytesRead =
+                scanner.ReadEntryData(entry, position, data.data() + position, 700))
+            {
+                position += numberOfBytesRead;
+            }
+
+            Check(frame.Data.size() == position, "entry read to its end");
+            Check(0 == memcmp(frame.Data.data(), data.data(), frame.Data.size()), "entry data");
+        }
+
+        Io::TarEntry entry;
+
+        Check(!scanner.FindEntry("missing.pgm", &entry), "missing entry not found");
+    }
+
+    //
+    // Look the frames up through the index, by ordinal and by timestamp.
+    //
+    {
+        Io::TarIndex index;
+
+        index.Load(
+            indexFile.data(),
+            indexFile.size());
+
+        Check(frames.size() == index.GetRecordCount(), "number of index records");
+
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            const WrittenFrame& frame = frames[i];
+
+            size_t ordinal = 0;
+
+            if (!index.FindRecord(frame.Timestamp, &ordinal))
+            {
+                Check(false, "record found by timestamp");
+                continue;
+            }
+
+            Check(i == ordinal, "ordinal of the record");
+
+            const Io::TarIndexRecord& record = index.GetRecord(ordinal);
+
+            Check(
+                0 == memcmp(
+                    archive.data() + record.DataOffset,
+                    frame.Data.data(),
+                    frame.Data.size()),
+                "data located through the index");
+
+            Check(
+                archive[record.DataOffset + record.PixelDataOffset] ==
+                frame.Data[frame.PixelDataOffset],
+                "pixels located through the index");
+
+            Check(i == index.FindNearestRecord(frame.Timestamp + 1), "nearest record after");
+            Check(i == index.FindNearestRecord(frame.Timestamp - 1), "nearest record before");
+        }
+
+        if (!frames.empty())
+        {
+            size_t ordinal = 0;
+
+            Check(!index.FindRecord(frames[0].Timestamp + 7, &ordinal), "missing timestamp not found");
+        }
+
+        //
+        // A record cut short by an interrupted recording is ignored.
+        //
+        Io::TarIndex truncatedIndex;
+
+        truncatedIndex.Load(
+            indexFile.data(),
+            indexFile.size() - 5);
+
+        Check(
+            frames.empty() || frames.size() - 1 == truncatedIndex.GetRecordCount(),
+            "truncated index");
+    }
+
+    printf(
+        "%llu frames, %llu bytes of archive\n",
+        static_cast<unsigned long long>(frames.size()),
+        static_cast<unsigned long long>(archive.size()));
+
+    printf("%s\n", g_succeeded ? "passed" : "FAILED");
+
+    return g_succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,427 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Compares the two ways the recorder has added frames to its tarballs:
+//
+// * Before: the PGM/PPM header and the pixels are copied into a new vector
+//   (PV frames are converted from BGRA to RGB a byte at a time on the way),
+//   then the tar header, the file and a newly allocated block of zero padding
+//   are written through a std::ofstream, in three calls.
+// * Now: the header and the pixels (PV frames converted with
+//   Io::PackBgraToRgb into a reused buffer) are handed as spans to an
+//   Io::TarArchiveWriter, which writes to a file descriptor.
+//
+// Reports the bytes per second written and the allocations per frame, for
+// 640x480 Gray8 visible light frames and 1280x720 BGRA photo video frames.
+// Checks that both ways write the same tarball.
+//
+// Usage: tar_write_benchmark [frames] [output folder]
+//
+
+#include <Io/PixelFormatConversion.h>
+#include <Io/TarArchive.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount(0);
+
+    struct FrameConfiguration
+    {
+        const char* Name;
+        uint32_t Width;
+        uint32_t Height;
+
+        // 4 for BGRA frames, stored as PPM files.
+        uint32_t BytesPerPixel;
+    };
+
+    std::string GetFileName(
+        const FrameConfiguration& configuration,
+        const uint64_t timestamp)
+    {
+        char fileName[128] = {};
+
+        snprintf(
+            fileName,
+            sizeof(fileName),
+            "%s/%020llu.%s",
+            configuration.Name,
+            static_cast<unsigned long long>(timestamp),
+            (4 == configuration.BytesPerPixel) ? "ppm" : "pgm");
+
+        return fileName;
+    }
+
+    //
+    // The path of the recorder before the span based AddFile.
+    //
+    void WriteFramesBefore(
+        const FrameConfiguration& configuration,
+        const std::vector<uint8_t>& pixels,
+        const int32_t frameCount,
+        const std::string& tarballFileName)
+    {
+        std::ofstream tarball(
+            tarballFileName,
+            std::ios::binary | std::ios::out | std::ios::trunc);
+
+        const bool isBgra =
+            (4 == configuration.BytesPerPixel);
+
+        for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        {
+            std::stringstream header;
+            header << (isBgra ? "P6" : "P5") << "\n"
+                << configuration.Width << " "
+                << configuration.Height << "\n"
+                << 255 << "\n";
+            const std::string headerString = header.str();
+
+            std::vector<uint8_t> bitmapData;
+
+            if (isBgra)
+            {
+                const uint32_t numPixels = configuration.Width * configuration.Height;
+
+                bitmapData.reserve(headerString.size() + numPixels * 3);
+
+                bitmapData.insert(
+                    bitmapData.end(),
+                    headerString.c_str(), headerString.c_str() + headerString.size());
+
+                for (uint32_t i = 0; i < numPixels; ++i)
+                {
+                    for (uint32_t j = 0; j < 3; ++j)
+                    {
+                        bitmapData.push_back(pixels[i * 4 + 2 - j]);
+                    }
+                }
+            }
+            else
+            {
+                bitmapData.reserve(headerString.size() + pixels.size());
+
+                bitmapData.insert(
+                    bitmapData.end(),
+                    headerString.c_str(), headerString.c_str() + headerString.size());
+
+                bitmapData.insert(
+                    bitmapData.end(),
+                    pixels.begin(), pixels.end());
+            }
+
+            uint8_t tarHeader[Io::TarBlockSize];
+
+            Io::FormatTarHeader(
+                GetFileName(configuration, frameIndex),
+                bitmapData.size(),
+                0 /* modificationTime */,
+                tarHeader);
+
+            tarball.write(
+                reinterpret_cast<const char*>(tarHeader), sizeof(tarHeader));
+            tarball.write(
+                reinterpret_cast<const char*>(bitmapData.data()), bitmapData.size());
+
+            const size_t lastBlockSize = bitmapData.size() % Io::TarBlockSize;
+
+            if (lastBlockSize != 0)
+            {
+                const size_t lastBlockPadding = Io::TarBlockSize - lastBlockSize;
+
+                tarball.write(
+                    std::vector<char>(lastBlockPadding, 0).data(), lastBlockPadding);
+            }
+        }
+
+        // The end of the archive, which TarArchiveWriter::Finish writes too.
+        const std::vector<char> endOfArchive(2 * Io::TarBlockSize, 0);
+
+        tarball.write(
+            endOfArchive.data(), endOfArchive.size());
+    }
+
+    //
+    // The path of the recorder now.
+    //
+    void WriteFramesNow(
+        const FrameConfiguration& configuration,
+        const std::vector<uint8_t>& pixels,
+        const int32_t frameCount,
+        const std::string& tarballFileName)
+    {
+        const int tarball = open(
+            tarballFileName.c_str(),
+            O_WRONLY | O_CREAT | O_TRUNC,
+            0644);
+
+        if (tarball < 0)
+        {
+            fprintf(stderr, "cannot create %s\n", tarballFileName.c_str());
+            exit(EXIT_FAILURE);
+        }
+
+        Io::TarArchiveWriter archive(
+            [tarball](const uint8_t* data, size_t size)
+            {
+                while (size > 0)
+                {
+                    const ssize_t written = write(tarball, data, size);
+
+                    if (written <= 0)
+                    {
+                        fprintf(stderr, "write failed\n");
+                        exit(EXIT_FAILURE);
+                    }
+
+                    data += written;
+                    size -= static_cast<size_t>(written);
+                }
+            });
+
+        const bool isBgra =
+            (4 == configuration.BytesPerPixel);
+
+        const size_t pixelCount =
+            static_cast<size_t>(configuration.Width) * configuration.Height;
+
+        // Kept by the recorder sink from frame to frame.
+        std::vector<uint8_t> rgbPixels(
+            isBgra ? 3 * pixelCount : 0);
+
+        for (int32_t frameIndex = 0; frameIndex < frameCount; ++frameIndex)
+        {
+            char header[64] = {};
+
+            const int headerSize = snprintf(
+                header,
+                sizeof(header),
+                "%s\n%u %u\n255\n",
+                isBgra ? "P6" : "P5",
+                configuration.Width,
+                configuration.Height);
+
+            Io::TarballFileSpan spans[2] =
+            {
+                { reinterpret_cast<const uint8_t*>(header), static_cast<size_t>(headerSize) },
+                { pixels.data(), pixels.size() },
+            };
+
+            if (isBgra)
+            {
+                Io::PackBgraToRgb(
+                    pixels.data(),
+                    pixelCount,
+                    rgbPixels.data());
+
+                spans[1].Data = rgbPixels.data();
+                spans[1].Size = rgbPixels.size();
+            }
+
+            char fileName[128] = {};
+
+            snprintf(
+                fileName,
+                sizeof(fileName),
+                "%s/%020llu.%s",
+                configuration.Name,
+                static_cast<unsigned long long>(frameIndex),
+                isBgra ? "ppm" : "pgm");
+
+            archive.AddFile(
+                fileName,
+                spans,
+                2,
+                0 /* modificationTime */);
+        }
+
+        archive.Finish();
+
+        close(tarball);
+    }
+
+    bool ReadFile(
+        const std::string& fileName,
+        std::vector<char>* contents)
+    {
+        std::ifstream file(
+            fileName,
+            std::ios::binary);
+
+        contents->assign(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>());
+
+        return file.good() || file.eof();
+    }
+
+    bool Run(
+        const FrameConfiguration& configuration,
+        const int32_t frameCount,
+        const std::string& outputFolder)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        std::vector<uint8_t> pixels(
+            static_cast<size_t>(configuration.Width) * configuration.Height * configuration.BytesPerPixel);
+
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = static_cast<uint8_t>(i * 7 + (i >> 11));
+        }
+
+        const std::string beforeFileName = outputFolder + "/" + configuration.Name + "_before.tar";
+        const std::string nowFileName = outputFolder + "/" + configuration.Name + "_now.tar";
+
+        typedef void (*WriteFrames)(
+            const FrameConfiguration&,
+            const std::vector<uint8_t>&,
+            int32_t,
+            const std::string&);
+
+        const struct
+        {
+            const char* Name;
+            WriteFrames Write;
+            const std::string& FileName;
+        } paths[] =
+        {
+            { "before", &WriteFramesBefore, beforeFileName },
+            { "now", &WriteFramesNow, nowFileName },
+        };
+
+        for (const auto& path : paths)
+        {
+            const uint64_t firstAllocationCount = g_allocationCount;
+
+            const Clock::time_point startTime = Clock::now();
+
+            path.Write(configuration, pixels, frameCount, path.FileName);
+
+            const double elapsedTime =
+                std::chrono::duration<double>(Clock::now() - startTime).count();
+
+            const uint64_t allocations =
+                g_allocationCount - firstAllocationCount;
+
+            std::vector<char> tarball;
+
+            if (!ReadFile(path.FileName, &tarball))
+            {
+                fprintf(stderr, "cannot read %s\n", path.FileName.c_str());
+                return false;
+            }
+
+            printf(
+                "%-24s %-6s %8.1f MB/s %8.1f frames/s %6.2f allocations per frame\n",
+                configuration.Name,
+                path.Name,
+                tarball.size() / elapsedTime / 1e6,
+                frameCount / elapsedTime,
+                static_cast<double>(allocations) / frameCount);
+        }
+
+        std::vector<char> before, now;
+
+        if (!ReadFile(beforeFileName, &before) ||
+            !ReadFile(nowFileName, &now) ||
+            before != now)
+        {
+            fprintf(stderr, "%s: the tarballs differ\n", configuration.Name);
+            return false;
+        }
+
+        remove(beforeFileName.c_str());
+        remove(nowFileName.c_str());
+
+        return true;
+    }
+}
+
+void* operator new(
+    size_t size)
+{
+    ++g_allocationCount;
+
+    void* pointer = malloc((0 == size) ? 1 : size);
+
+    if (nullptr == pointer)
+    {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+}
+
+void operator delete(
+    void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(
+    void* pointer,
+    size_t /* size */) noexcept
+{
+    free(pointer);
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    const int32_t frameCount =
+        (argc > 1) ? atoi(argv[1]) : 300;
+
+    const std::string outputFolder =
+        (argc > 2) ? argv[2] : ".";
+
+    if (frameCount <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames] [output folder]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const FrameConfiguration configurations[] =
+    {
+        { "vlc_lf", 640, 480, 1 },
+        { "pv", 1280, 720, 4 },
+    };
+
+    bool passed = true;
+
+    for (const FrameConfiguration& configuration : configurations)
+    {
+        passed = Run(configuration, frameCount, outputFolder) && passed;
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
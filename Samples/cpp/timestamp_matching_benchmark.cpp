@@ -0,0 +1,455 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Checks the timestamp matching of HoloLensForCV's MultiFrameBuffer against
+// brute force searches on synthetic jittered timestamp streams of the four
+// visible light cameras and the depth camera, with dropped frames. Then
+// measures the time per query against the all-pairs search MultiFrameBuffer
+// used before, for sensor histories of increasing length.
+//
+// Usage: timestamp_matching_benchmark [random cases to check]
+//
+
+#include "../../Shared/HoloLensForCV/TimestampMatching.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace HoloLensForCV;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // Timestamps are in 100ns units.
+    const int64_t c_ticksPerMillisecond = 10000;
+    const int64_t c_ticksPerSecond = 1000 * c_ticksPerMillisecond;
+
+    uint32_t NextRandom(
+        uint64_t& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        return static_cast<uint32_t>(state >> 32);
+    }
+
+    int64_t AbsoluteDifference(
+        const int64_t a,
+        const int64_t b)
+    {
+        return (a > b) ? (a - b) : (b - a);
+    }
+
+    //
+    // The timestamps of a sensor running at the given rate, each shifted by up
+    // to the given jitter, with a fraction of the frames dropped. A grid larger
+    // than one tick rounds the timestamps, which produces ties.
+    //
+    std::vector<int64_t> CreateStream(
+        const size_t numberOfFrames,
+        const double rate,
+        const int64_t offset,
+        const int64_t jitter,
+        const uint32_t dropPercentage,
+        const int64_t grid,
+        uint64_t& random)
+    {
+        std::vector<int64_t> timestamps;
+
+        const double period = c_ticksPerSecond / rate;
+
+        for (size_t i = 0; timestamps.size() < numberOfFrames; ++i)
+        {
+            if (NextRandom(random) % 100 < dropPercentage)
+            {
+                continue;
+            }
+
+            int64_t timestamp =
+                131000000000000000LL + offset + static_cast<int64_t>(i * period);
+
+            if (jitter > 0)
+            {
+                timestamp += static_cast<int64_t>(NextRandom(random) % (2 * jitter + 1)) - jitter;
+            }
+
+            timestamps.push_back(timestamp / grid * grid);
+        }
+
+        std::sort(timestamps.begin(), timestamps.end());
+
+        return timestamps;
+    }
+
+    TimestampStream ToStream(
+        const std::vector<int64_t>& timestamps)
+    {
+        TimestampStream stream;
+
+        stream.Timestamps = timestamps.data();
+        stream.Count = timestamps.size();
+
+        return stream;
+    }
+
+    //
+    // Brute force versions of the matching functions, with the same rules:
+    // the later timestamp wins ties, and a timestamp matches a reference if it
+    // is strictly less than the tolerance away.
+    //
+    bool FindNearestTimestampByScanning(
+        const TimestampStream& stream,
+        const int64_t timestamp,
+        size_t* index)
+    {
+        for (size_t i = 0; i < stream.Count; ++i)
+        {
+            if (0 == i || AbsoluteDifference(stream.Timestamps[i], timestamp) <= AbsoluteDifference(stream.Timestamps[*index], timestamp))
+            {
+                *index = i;
+            }
+        }
+
+        return stream.Count > 0;
+    }
+
+    bool IsValidTuple(
+        const TimestampStream* streams,
+        const size_t streamCount,
+        const size_t reference,
+        const int64_t tolerance,
+        size_t* indices)
+    {
+        indices[0] = reference;
+
+        for (size_t i = 1; i < streamCount; ++i)
+        {
+            if (!FindNearestTimestampByScanning(streams[i], streams[0].Timestamps[reference], &indices[i]) ||
+                AbsoluteDifference(streams[i].Timestamps[indices[i]], streams[0].Timestamps[reference]) >= tolerance)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool FindLatestTimestampTupleByScanning(
+        const TimestampStream* streams,
+        const size_t streamCount,
+        const int64_t tolerance,
+        size_t* indices)
+    {
+        for (size_t reference = streams[0].Count; reference-- > 0;)
+        {
+            if (IsValidTuple(streams, streamCount, reference, tolerance, indices))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    size_t FindTimestampTuplesSinceByScanning(
+        const TimestampStream* streams,
+        const size_t streamCount,
+        const int64_t since,
+        const int64_t tolerance,
+        std::vector<size_t>& indices)
+    {
+        std::vector<size_t> tuple(streamCount);
+
+        size_t tupleCount = 0;
+
+        for (size_t reference = 0; reference < streams[0].Count; ++reference)
+        {
+            if (streams[0].Timestamps[reference] > since &&
+                IsValidTuple(streams, streamCount, reference, tolerance, tuple.data()))
+            {
+                indices.insert(indices.end(), tuple.begin(), tuple.end());
+                ++tupleCount;
+            }
+        }
+
+        return tupleCount;
+    }
+
+    //
+    // MultiFrameBuffer::GetTimestampForSensorPair before it used
+    // FindLatestTimestampTuple: the most recent timestamp of the first sensor
+    // that any timestamp of the second sensor is within the tolerance of.
+    //
+    int64_t FindTimestampForSensorPairByAllPairs(
+        const std::vector<int64_t>& a,
+        const std::vector<int64_t>& b,
+        const int64_t tolerance)
+    {
+        int64_t best = 0;
+
+        for (const int64_t ta : a)
+        {
+            for (const int64_t tb : b)
+            {
+                if (AbsoluteDifference(ta, tb) < tolerance && ta > best)
+                {
+                    best = ta;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    //
+    // The four visible light cameras at 30 Hz and the short throw depth camera
+    // at 45 Hz, the latter being the reference.
+    //
+    std::vector<std::vector<int64_t>> CreateSensorStreams(
+        const size_t numberOfReferenceFrames,
+        const int64_t jitter,
+        const uint32_t dropPercentage,
+        const int64_t grid,
+        uint64_t& random)
+    {
+        std::vector<std::vector<int64_t>> timestamps;
+
+        timestamps.push_back(
+            CreateStream(numberOfReferenceFrames, 45.0, 0, jitter, dropPercentage, grid, random));
+
+        for (int camera = 0; camera < 4; ++camera)
+        {
+            timestamps.push_back(
+                CreateStream(numberOfReferenceFrames * 2 / 3, 30.0, camera * 2 * c_ticksPerMillisecond, jitter, dropPercentage, grid, random));
+        }
+
+        return timestamps;
+    }
+
+    bool CheckRandomCases(
+        const uint32_t numberOfCases)
+    {
+        uint64_t random = 42;
+
+        const size_t historyLengths[] = { 0, 1, 2, 5, 30, 300 };
+
+        for (uint32_t i = 0; i < numberOfCases; ++i)
+        {
+            const size_t historyLength = historyLengths[NextRandom(random) % 6];
+            const size_t streamCount = 1 + NextRandom(random) % 5;
+            const int64_t jitter = (NextRandom(random) % 8) * c_ticksPerMillisecond;
+            const uint32_t dropPercentage = NextRandom(random) % 50;
+            const int64_t grid = (0 == NextRandom(random) % 2) ? 1 : c_ticksPerMillisecond;
+            const int64_t tolerance = 1 + NextRandom(random) % (40 * c_ticksPerMillisecond);
+
+            std::vector<std::vector<int64_t>> timestamps =
+                CreateSensorStreams(historyLength, jitter, dropPercentage, grid, random);
+
+            //
+            // Empty streams other than the reference.
+            //
+            if (0 == NextRandom(random) % 20)
+            {
+                timestamps[1 + NextRandom(random) % 4].clear();
+            }
+
+            std::vector<TimestampStream> streams;
+
+            for (size_t j = 0; j < streamCount; ++j)
+            {
+                streams.push_back(ToStream(timestamps[j]));
+            }
+
+            //
+            // Nearest timestamps to times around and between the frames.
+            //
+            for (int j = 0; j < 8; ++j)
+            {
+                const int64_t timestamp =
+                    131000000000000000LL + static_cast<int64_t>(NextRandom(random) % (historyLength + 2)) * c_ticksPerSecond / 45 - c_ticksPerSecond / 45;
+
+                size_t expected = 0;
+                size_t actual = 0;
+
+                const bool expectedFound = FindNearestTimestampByScanning(streams[0], timestamp, &expected);
+                const bool actualFound = FindNearestTimestamp(streams[0], timestamp, &actual);
+
+                if (expectedFound != actualFound || (expectedFound && expected != actual))
+                {
+                    printf("case %u: FindNearestTimestamp found %zu instead of %zu\n", i, actual, expected);
+                    return false;
+                }
+            }
+
+            std::vector<size_t> expected(streamCount);
+            std::vector<size_t> actual(streamCount);
+
+            const bool expectedFound =
+                FindLatestTimestampTupleByScanning(streams.data(), streamCount, tolerance, expected.data());
+
+            const bool actualFound =
+                FindLatestTimestampTuple(streams.data(), streamCount, tolerance, actual.data());
+
+            if (expectedFound != actualFound || (expectedFound && expected != actual))
+            {
+                printf("case %u: FindLatestTimestampTuple differs from the brute force search\n", i);
+                return false;
+            }
+
+            const int64_t since = (0 == historyLength) ? 0 :
+                timestamps[0][NextRandom(random) % timestamps[0].size()] - static_cast<int64_t>(NextRandom(random) % 2);
+
+            std::vector<size_t> expectedTuples;
+            std::vector<size_t> actualTuples;
+
+            const size_t expectedCount =
+                FindTimestampTuplesSinceByScanning(streams.data(), streamCount, since, tolerance, expectedTuples);
+
+            const size_t actualCount =
+                FindTimestampTuplesSince(streams.data(), streamCount, since, tolerance, actualTuples);
+
+            if (expectedCount != actualCount || expectedTuples != actualTuples)
+            {
+                printf("case %u: FindTimestampTuplesSince found %zu tuples instead of %zu\n", i, actualCount, expectedCount);
+                return false;
+            }
+
+            //
+            // The pair search MultiFrameBuffer used before agrees on the
+            // reference timestamp.
+            //
+            if (streamCount >= 2)
+            {
+                const bool pairFound =
+                    FindLatestTimestampTuple(streams.data(), 2, tolerance, actual.data());
+
+                const int64_t pairTimestamp =
+                    pairFound ? timestamps[0][actual[0]] : 0;
+
+                if (pairTimestamp != FindTimestampForSensorPairByAllPairs(timestamps[0], timestamps[1], tolerance))
+                {
+                    printf("case %u: the sensor pair timestamp differs from the all-pairs search\n", i);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    template <typename TQuery>
+    double MeasureNanosecondsPerQuery(
+        TQuery query)
+    {
+        size_t numberOfQueries = 0;
+        size_t checksum = 0;
+
+        const Clock::time_point startTime = Clock::now();
+        double seconds = 0.0;
+
+        do
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                checksum += query();
+            }
+
+            numberOfQueries += 16;
+
+            seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+        }
+        while (seconds < 0.2);
+
+        //
+        // Keeps the queries from being optimized away.
+        //
+        if (1 == checksum)
+        {
+            printf(" ");
+        }
+
+        return seconds * 1e9 / numberOfQueries;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t numberOfCases =
+        (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 20000;
+
+    const bool passed = CheckRandomCases(numberOfCases);
+
+    printf(
+        "timestamp matching: %s (%u random cases compared with brute force searches)\n",
+        passed ? "matches" : "FAILED",
+        numberOfCases);
+
+    const int64_t tolerance = 16 * c_ticksPerMillisecond;
+
+    printf("4 VLC cameras and depth, 2 ms jitter, 5%% dropped frames, ns per query:\n");
+    printf("  %8s %12s %12s %14s %14s %14s %14s\n", "history", "pair before", "pair now", "5-tuple scan", "5-tuple now", "since scan", "since now");
+
+    for (const size_t historyLength : { 5, 30, 300, 3000 })
+    {
+        uint64_t random = 7;
+
+        const std::vector<std::vector<int64_t>> timestamps =
+            CreateSensorStreams(historyLength, 2 * c_ticksPerMillisecond, 5, 1, random);
+
+        std::vector<TimestampStream> streams;
+
+        for (const std::vector<int64_t>& sensorTimestamps : timestamps)
+        {
+            streams.push_back(ToStream(sensorTimestamps));
+        }
+
+        std::vector<size_t> indices(streams.size());
+        std::vector<size_t> tuples;
+
+        const double pairBefore = MeasureNanosecondsPerQuery(
+            [&]() { return static_cast<size_t>(FindTimestampForSensorPairByAllPairs(timestamps[0], timestamps[1], tolerance)); });
+
+        const double pairNow = MeasureNanosecondsPerQuery(
+            [&]() { return static_cast<size_t>(FindLatestTimestampTuple(streams.data(), 2, tolerance, indices.data())) + indices[0]; });
+
+        const double tupleScan = MeasureNanosecondsPerQuery(
+            [&]() { return static_cast<size_t>(FindLatestTimestampTupleByScanning(streams.data(), streams.size(), tolerance, indices.data())) + indices[0]; });
+
+        const double tupleNow = MeasureNanosecondsPerQuery(
+            [&]() { return static_cast<size_t>(FindLatestTimestampTuple(streams.data(), streams.size(), tolerance, indices.data())) + indices[0]; });
+
+        const double sinceScan = MeasureNanosecondsPerQuery(
+            [&]() { tuples.clear(); return FindTimestampTuplesSinceByScanning(streams.data(), streams.size(), 0, tolerance, tuples); });
+
+        const double sinceNow = MeasureNanosecondsPerQuery(
+            [&]() { tuples.clear(); return FindTimestampTuplesSince(streams.data(), streams.size(), 0, tolerance, tuples); });
+
+        printf(
+            "  %8zu %12.0f %12.0f %14.0f %14.0f %14.0f %14.0f\n",
+            historyLength,
+            pairBefore,
+            pairNow,
+            tupleScan,
+            tupleNow,
+            sinceScan,
+            sinceNow);
+    }
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
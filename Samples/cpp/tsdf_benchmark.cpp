@@ -0,0 +1,370 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Measures the throughput, in frames per second, of the TSDF fusion of
+// synthetic long throw depth frames of a room with a ball in it, seen from a
+// camera turning around. Checks that the extracted mesh lies on the room's
+// surfaces.
+//
+// Usage: tsdf_benchmark [frames] [threads] [mesh.ply]
+//
+
+#include "TsdfVolume.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const uint32_t c_imageWidth = 448;
+    const uint32_t c_imageHeight = 450;
+
+    // The room spans [-HalfSize, HalfSize] along each axis.
+    const float c_roomHalfSize[3] = { 2.0f, 1.5f, 3.0f };
+
+    const float c_ballCenter[3] = { 0.4f, -0.6f, -1.5f };
+    const float c_ballRadius = 0.45f;
+
+    //
+    // Signed distance to the room's walls and ball, positive in the free
+    // space.
+    //
+    float GetSceneDistance(
+        const float* point)
+    {
+        float distance = INFINITY;
+        float ballDistance = 0.0f;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            distance = std::min(distance, c_roomHalfSize[k] - std::fabs(point[k]));
+            ballDistance += (point[k] - c_ballCenter[k]) * (point[k] - c_ballCenter[k]);
+        }
+
+        return std::min(distance, std::sqrt(ballDistance) - c_ballRadius);
+    }
+
+    //
+    // Distance along a unit ray from inside of the room to the first surface
+    // it hits.
+    //
+    float CastRay(
+        const float* origin,
+        const float* direction)
+    {
+        float distance = INFINITY;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            if (direction[k] != 0.0f)
+            {
+                const float wall = (direction[k] > 0.0f) ? c_roomHalfSize[k] : -c_roomHalfSize[k];
+
+                distance = std::min(distance, (wall - origin[k]) / direction[k]);
+            }
+        }
+
+        float offset[3];
+        float b = 0.0f;
+        float c = -c_ballRadius * c_ballRadius;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            offset[k] = origin[k] - c_ballCenter[k];
+            b += offset[k] * direction[k];
+            c += offset[k] * offset[k];
+        }
+
+        const float discriminant = b * b - c;
+
+        if (discriminant >= 0.0f)
+        {
+            const float hit = -b - std::sqrt(discriminant);
+
+            if (hit > 0.0f)
+            {
+                distance = std::min(distance, hit);
+            }
+        }
+
+        return distance;
+    }
+
+    //
+    // Pinhole camera with some barrel distortion, and the corners of the
+    // long throw camera cut off.
+    //
+    Io::UnprojectionLut CreateLut()
+    {
+        const float focalLength = 0.4f * c_imageWidth;
+
+        std::vector<float> points;
+
+        for (uint32_t v = 0; v < c_imageHeight; ++v)
+        {
+            for (uint32_t u = 0; u < c_imageWidth; ++u)
+            {
+                const float du = u + 0.5f - 0.5f * c_imageWidth;
+                const float dv = v + 0.5f - 0.5f * c_imageHeight;
+
+                if (du * du + dv * dv > 240.0f * 240.0f)
+                {
+                    points.push_back(NAN);
+                    points.push_back(NAN);
+
+                    continue;
+                }
+
+                const float x = du / focalLength;
+                const float y = dv / focalLength;
+                const float distortion = 1.0f + 0.1f * (x * x + y * y);
+
+                points.push_back(x * distortion);
+                points.push_back(y * distortion);
+            }
+        }
+
+        Io::UnprojectionLut lut;
+
+        lut.Assign(
+            c_imageWidth,
+            c_imageHeight,
+            points.data());
+
+        return lut;
+    }
+
+    //
+    // The camera walks around a circle while turning half way around, looking
+    // slightly down.
+    //
+    void CreateCameraToOrigin(
+        uint32_t frame,
+        uint32_t frameCount,
+        float cameraToOrigin[16])
+    {
+        const float angle = 3.14159265f * frame / frameCount;
+        const float pitch = -0.2f;
+
+        const float forward[3] = { std::sin(angle) * std::cos(pitch), std::sin(pitch), -std::cos(angle) * std::cos(pitch) };
+        const float right[3] = { std::cos(angle), 0.0f, std::sin(angle) };
+
+        const float down[3] =
+        {
+            forward[1] * right[2] - forward[2] * right[1],
+            forward[2] * right[0] - forward[0] * right[2],
+            forward[0] * right[1] - forward[1] * right[0]
+        };
+
+        for (int k = 0; k < 3; ++k)
+        {
+            cameraToOrigin[k] = right[k];
+            cameraToOrigin[4 + k] = down[k];
+            cameraToOrigin[8 + k] = forward[k];
+        }
+
+        cameraToOrigin[3] = cameraToOrigin[7] = cameraToOrigin[11] = 0.0f;
+
+        cameraToOrigin[12] = 0.5f * std::sin(2.0f * angle);
+        cameraToOrigin[13] = 0.1f * std::sin(4.0f * angle);
+        cameraToOrigin[14] = 0.5f * std::cos(2.0f * angle);
+        cameraToOrigin[15] = 1.0f;
+    }
+
+    //
+    // Radial depths in millimeters, with a millimeter of noise.
+    //
+    std::vector<uint16_t> RenderDepth(
+        const Io::UnprojectionLut& lut,
+        const float cameraToOrigin[16],
+        uint32_t* noiseState)
+    {
+        std::vector<uint16_t> depth(
+            static_cast<size_t>(c_imageWidth) * c_imageHeight);
+
+        for (size_t i = 0; i < depth.size(); ++i)
+        {
+            const float x = lut.GetX()[i];
+
+            if (x != x)
+            {
+                continue;
+            }
+
+            const float cameraDirection[3] =
+            {
+                x * lut.GetInverseRayLength()[i],
+                lut.GetY()[i] * lut.GetInverseRayLength()[i],
+                lut.GetInverseRayLength()[i]
+            };
+
+            float direction[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                direction[k] =
+                    cameraDirection[0] * cameraToOrigin[k] +
+                    cameraDirection[1] * cameraToOrigin[4 + k] +
+                    cameraDirection[2] * cameraToOrigin[8 + k];
+            }
+
+            *noiseState ^= *noiseState << 13;
+            *noiseState ^= *noiseState >> 17;
+            *noiseState ^= *noiseState << 5;
+
+            const float millimeters =
+                1000.0f * CastRay(cameraToOrigin + 12, direction) + static_cast<float>(*noiseState % 3) - 1.0f;
+
+            depth[i] = (millimeters < 4090.0f) ? static_cast<uint16_t>(millimeters + 0.5f) : 0;
+        }
+
+        return depth;
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const uint32_t frameCount = (argc > 1) ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+    const size_t threadCount = (argc > 2) ? static_cast<size_t>(atoi(argv[2])) : 0;
+    const char* meshPath = (argc > 3) ? argv[3] : nullptr;
+
+    const Io::UnprojectionLut lut =
+        CreateLut();
+
+    std::vector<std::vector<uint16_t>> depthFrames;
+    std::vector<std::vector<float>> poses;
+    uint32_t noiseState = 0x12345678;
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        std::vector<float> cameraToOrigin(16);
+
+        CreateCameraToOrigin(
+            frame,
+            frameCount,
+            cameraToOrigin.data());
+
+        depthFrames.push_back(
+            RenderDepth(lut, cameraToOrigin.data(), &noiseState));
+
+        poses.push_back(
+            std::move(cameraToOrigin));
+    }
+
+    SensorStream::WorkerPool workerPool(
+        threadCount);
+
+    const SensorStream::TsdfOptions options;
+
+    SensorStream::TsdfVolume volume(
+        lut,
+        options,
+        workerPool);
+
+    const Clock::time_point startTime =
+        Clock::now();
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        volume.Integrate(
+            depthFrames[frame].data(),
+            c_imageWidth * sizeof(uint16_t),
+            poses[frame].data());
+    }
+
+    const Clock::time_point integrationTime =
+        Clock::now();
+
+    SensorStream::TriangleMesh mesh;
+
+    volume.ExtractMesh(
+        &mesh);
+
+    const Clock::time_point extractionTime =
+        Clock::now();
+
+    const double integrationSeconds =
+        std::chrono::duration<double>(integrationTime - startTime).count();
+
+    const double extractionSeconds =
+        std::chrono::duration<double>(extractionTime - integrationTime).count();
+
+    printf(
+        "%u frames of %ux%u, %zu threads: %.1f frames/s, %zu blocks (%.0f MB)\n",
+        frameCount,
+        c_imageWidth,
+        c_imageHeight,
+        workerPool.GetThreadCount(),
+        frameCount / integrationSeconds,
+        volume.GetBlockCount(),
+        volume.GetMemoryUsage() / 1e6);
+
+    //
+    // The vertices should be within a fraction of a voxel of the surfaces.
+    //
+    std::vector<float> errors;
+
+    for (size_t i = 0; i < mesh.Vertices.size(); i += 3)
+    {
+        errors.push_back(
+            std::fabs(GetSceneDistance(&mesh.Vertices[i])));
+    }
+
+    std::sort(
+        errors.begin(),
+        errors.end());
+
+    double totalError = 0.0;
+
+    for (float error : errors)
+    {
+        totalError += error;
+    }
+
+    const double averageError = errors.empty() ? INFINITY : totalError / errors.size();
+    const double error95 = errors.empty() ? INFINITY : errors[errors.size() * 95 / 100];
+
+    printf(
+        "mesh: %zu triangles in %.1f ms, vertices %.2f mm from the surfaces on average, 95%% within %.2f mm\n",
+        mesh.Triangles.size() / 3,
+        extractionSeconds * 1e3,
+        averageError * 1e3,
+        error95 * 1e3);
+
+    if (nullptr != meshPath)
+    {
+        std::string error;
+
+        if (!SensorStream::WritePlyFile(mesh, meshPath, &error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+        }
+    }
+
+    const bool passed =
+        averageError < 0.25f * options.VoxelSize && error95 < 0.5f * options.VoxelSize;
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
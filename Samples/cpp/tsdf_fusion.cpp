@@ -0,0 +1,208 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Fuses the depth frames of a recording made with HoloLensForCV's recorder
+// into a TSDF volume, and writes the mesh of its surfaces to a PLY file.
+// Reports the throughput of the fusion in frames per second.
+//
+// The recording folder holds the <sensor>.tar, <sensor>.csv and
+// <sensor>_camera_space_projection.bin files downloaded from the HoloLens.
+//
+// Usage: tsdf_fusion <recording folder> [sensor] [mesh.ply] [voxel size in m] [threads]
+//
+
+#include "Recording.h"
+#include "TsdfVolume.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(
+    int argc,
+    char** argv)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <recording folder> [sensor] [mesh.ply] [voxel size in m] [threads]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const std::string recordingFolder = argv[1];
+    const std::string sensorName = (argc > 2) ? argv[2] : "long_throw_depth";
+    const std::string meshPath = (argc > 3) ? argv[3] : sensorName + "_mesh.ply";
+    const size_t threadCount = (argc > 5) ? static_cast<size_t>(atoi(argv[5])) : 0;
+
+    SensorStream::TsdfOptions options;
+
+    if (argc > 4)
+    {
+        options.VoxelSize = static_cast<float>(atof(argv[4]));
+        options.TruncationDistance = 4.0f * options.VoxelSize;
+    }
+
+    SensorStream::RecordingReader reader;
+    SensorStream::RecordedFrame frame;
+
+    if (!reader.Open(recordingFolder, sensorName))
+    {
+        fprintf(stderr, "%s\n", reader.GetError().c_str());
+
+        return EXIT_FAILURE;
+    }
+
+    if (!reader.ReadFrame(&frame))
+    {
+        fprintf(stderr, "no frame to fuse: %s\n", reader.GetError().empty() ? "the recording is empty" : reader.GetError().c_str());
+
+        return EXIT_FAILURE;
+    }
+
+    if (2 != frame.BytesPerPixel)
+    {
+        fprintf(stderr, "%s doesn't hold Gray16 depth frames\n", sensorName.c_str());
+
+        return EXIT_FAILURE;
+    }
+
+    Io::UnprojectionLut lut;
+    std::string error;
+
+    if (!SensorStream::LoadCameraSpaceProjection(
+            recordingFolder,
+            sensorName,
+            frame.ImageWidth,
+            frame.ImageHeight,
+            &lut,
+            &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+
+        return EXIT_FAILURE;
+    }
+
+    SensorStream::WorkerPool workerPool(
+        threadCount);
+
+    SensorStream::TsdfVolume volume(
+        lut,
+        options,
+        workerPool);
+
+    // The pixels of the recorded frames may not be aligned.
+    std::vector<uint16_t> depth(
+        static_cast<size_t>(frame.ImageWidth) * frame.ImageHeight);
+
+    const size_t rowSize =
+        frame.ImageWidth * sizeof(uint16_t);
+
+    uint64_t fusedFrameCount = 0;
+    Clock::duration readingTime = Clock::duration::zero();
+    Clock::duration fusionTime = Clock::duration::zero();
+
+    Clock::time_point readTime =
+        Clock::now();
+
+    do
+    {
+        const Clock::time_point fusionStartTime =
+            Clock::now();
+
+        readingTime += fusionStartTime - readTime;
+
+        if (frame.ImageWidth != lut.GetImageWidth() || frame.ImageHeight != lut.GetImageHeight() || 2 != frame.BytesPerPixel)
+        {
+            fprintf(stderr, "skipping the %ux%u frame at %llu\n", frame.ImageWidth, frame.ImageHeight, (unsigned long long)frame.Timestamp);
+
+            readTime = Clock::now();
+
+            continue;
+        }
+
+        for (uint32_t y = 0; y < frame.ImageHeight; ++y)
+        {
+            memcpy(
+                depth.data() + static_cast<size_t>(y) * frame.ImageWidth,
+                frame.Pixels + y * frame.RowStride,
+                rowSize);
+        }
+
+        float cameraToOrigin[16];
+
+        Io::ComputeCameraToOrigin(
+            frame.FrameToOrigin,
+            frame.CameraViewTransform,
+            cameraToOrigin);
+
+        volume.Integrate(
+            depth.data(),
+            rowSize,
+            cameraToOrigin);
+
+        ++fusedFrameCount;
+
+        readTime = Clock::now();
+
+        fusionTime += readTime - fusionStartTime;
+    }
+    while (reader.ReadFrame(&frame));
+
+    if (!reader.GetError().empty())
+    {
+        fprintf(stderr, "%s\n", reader.GetError().c_str());
+    }
+
+    const double fusionSeconds =
+        std::chrono::duration<double>(fusionTime).count();
+
+    printf(
+        "%llu frames fused (%llu skipped), %zu threads: %.1f frames/s, %.1f frames/s read, %zu blocks (%.0f MB)\n",
+        (unsigned long long)fusedFrameCount,
+        (unsigned long long)reader.GetSkippedFrameCount(),
+        workerPool.GetThreadCount(),
+        fusedFrameCount / fusionSeconds,
+        fusedFrameCount / std::chrono::duration<double>(readingTime).count(),
+        volume.GetBlockCount(),
+        volume.GetMemoryUsage() / 1e6);
+
+    SensorStream::TriangleMesh mesh;
+
+    const Clock::time_point extractionStartTime =
+        Clock::now();
+
+    volume.ExtractMesh(
+        &mesh);
+
+    printf(
+        "mesh: %zu triangles in %.1f ms\n",
+        mesh.Triangles.size() / 3,
+        std::chrono::duration<double, std::milli>(Clock::now() - extractionStartTime).count());
+
+    if (!SensorStream::WritePlyFile(mesh, meshPath.c_str(), &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+
+        return EXIT_FAILURE;
+    }
+
+    printf("%s written\n", meshPath.c_str());
+
+    return EXIT_SUCCESS;
+}
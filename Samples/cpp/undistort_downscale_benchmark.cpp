@@ -0,0 +1,212 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Compares rmcv::UndistortDownscaleMap with the OpenCV functions it replaces
+// in the ComputeOnDevice sample: cv::remap with the maps of
+// cv::initUndistortRectifyMap, then cv::resize by 0.5 with cv::INTER_AREA,
+// each followed by the sample's cv::medianBlur. Measures the time per
+// 1280x720 BGRA frame, and checks that both give about the same image.
+//
+// Usage: undistort_downscale_benchmark [frames]
+//
+
+#include <OpenCVHelpers/UndistortDownscale.h>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    const int c_imageWidth = 1280;
+    const int c_imageHeight = 720;
+
+    //
+    // Intrinsics of the order of those of the HoloLens photo video camera.
+    //
+    cv::Matx33d GetCameraMatrix()
+    {
+        return cv::Matx33d(
+            1038.0, 0.0, 640.0,
+            0.0, 1038.0, 360.0,
+            0.0, 0.0, 1.0);
+    }
+
+    cv::Vec<double, 5> GetDistortionCoefficients()
+    {
+        return cv::Vec<double, 5>(0.12, -0.25, 0.0008, -0.0005, 0.1);
+    }
+
+    //
+    // Smooth gradients with a grid of sharp edges, so that misplaced samples
+    // show in the comparison.
+    //
+    cv::Mat CreateImage()
+    {
+        cv::Mat image(c_imageHeight, c_imageWidth, CV_8UC4);
+
+        for (int y = 0; y < c_imageHeight; ++y)
+        {
+            cv::Vec4b* row = image.ptr<cv::Vec4b>(y);
+
+            for (int x = 0; x < c_imageWidth; ++x)
+            {
+                const bool isGridLine = (x % 40) < 3 || (y % 40) < 3;
+
+                row[x] = cv::Vec4b(
+                    static_cast<uint8_t>(x * 255 / c_imageWidth),
+                    static_cast<uint8_t>(y * 255 / c_imageHeight),
+                    static_cast<uint8_t>(isGridLine ? 255 : 64),
+                    255);
+            }
+        }
+
+        return image;
+    }
+
+    double GetMilliseconds(
+        const std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+int main(
+    int argc,
+    char** argv)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const int frameCount =
+        (argc > 1) ? atoi(argv[1]) : 200;
+
+    if (frameCount <= 0)
+    {
+        fprintf(stderr, "usage: %s [frames]\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    const cv::Mat image = CreateImage();
+    const cv::Matx33d cameraMatrix = GetCameraMatrix();
+    const cv::Vec<double, 5> distortionCoefficients = GetDistortionCoefficients();
+
+    cv::Mat undistortMap1, undistortMap2;
+
+    cv::initUndistortRectifyMap(
+        cameraMatrix,
+        distortionCoefficients,
+        cv::Mat(),
+        cameraMatrix,
+        image.size(),
+        CV_32FC1,
+        undistortMap1,
+        undistortMap2);
+
+    rmcv::UndistortDownscaleMap undistortDownscaleMap;
+
+    undistortDownscaleMap.Create(
+        image.size(),
+        cameraMatrix,
+        distortionCoefficients);
+
+    cv::Mat undistortedImage, resizedImage, blurredImage;
+    cv::Mat fusedImage, fusedBlurredImage;
+
+    double remapTime = 0.0, resizeTime = 0.0, chainBlurTime = 0.0;
+    double fusedTime = 0.0, fusedBlurTime = 0.0;
+
+    // The first frame allocates the images, and is not measured.
+    for (int frameIndex = -1; frameIndex < frameCount; ++frameIndex)
+    {
+        const Clock::time_point startTime = Clock::now();
+
+        cv::remap(image, undistortedImage, undistortMap1, undistortMap2, cv::INTER_LINEAR);
+
+        const Clock::time_point remapTimePoint = Clock::now();
+
+        cv::resize(undistortedImage, resizedImage, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+
+        const Clock::time_point resizeTimePoint = Clock::now();
+
+        cv::medianBlur(resizedImage, blurredImage, 3);
+
+        const Clock::time_point chainTimePoint = Clock::now();
+
+        undistortDownscaleMap.Apply(image, fusedImage);
+
+        const Clock::time_point fusedTimePoint = Clock::now();
+
+        cv::medianBlur(fusedImage, fusedBlurredImage, 3);
+
+        const Clock::time_point endTime = Clock::now();
+
+        if (frameIndex >= 0)
+        {
+            remapTime += GetMilliseconds(remapTimePoint - startTime);
+            resizeTime += GetMilliseconds(resizeTimePoint - remapTimePoint);
+            chainBlurTime += GetMilliseconds(chainTimePoint - resizeTimePoint);
+            fusedTime += GetMilliseconds(fusedTimePoint - chainTimePoint);
+            fusedBlurTime += GetMilliseconds(endTime - fusedTimePoint);
+        }
+    }
+
+    printf(
+        "remap + resize + medianBlur: %.2f + %.2f + %.2f = %.2f ms per frame\n",
+        remapTime / frameCount,
+        resizeTime / frameCount,
+        chainBlurTime / frameCount,
+        (remapTime + resizeTime + chainBlurTime) / frameCount);
+
+    printf(
+        "UndistortDownscaleMap + medianBlur: %.2f + %.2f = %.2f ms per frame (%.2fx)\n",
+        fusedTime / frameCount,
+        fusedBlurTime / frameCount,
+        (fusedTime + fusedBlurTime) / frameCount,
+        (remapTime + resizeTime + chainBlurTime) / (fusedTime + fusedBlurTime));
+
+    //
+    // The fused filter approximates the chain; the values should be within a
+    // couple of levels of each other, but for few pixels on the grid's edges.
+    //
+    cv::Mat difference;
+
+    cv::absdiff(resizedImage, fusedImage, difference);
+
+    const cv::Scalar meanDifference = cv::mean(difference);
+
+    double maximumDifference = 0.0;
+
+    cv::minMaxLoc(difference.reshape(1), nullptr, &maximumDifference);
+
+    const double averageDifference =
+        (meanDifference[0] + meanDifference[1] + meanDifference[2]) / 3.0;
+
+    printf(
+        "difference to remap + resize: %.3f on average, %.0f at most\n",
+        averageDifference,
+        maximumDifference);
+
+    const bool passed =
+        fusedImage.size() == resizedImage.size() &&
+        averageDifference < 0.5;
+
+    printf("%s\n", passed ? "passed" : "FAILED");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -18,6 +18,7 @@ import argparse
 import sqlite3
 import shutil
 import json
+import struct
 import subprocess
 import urllib.request
 import numpy as np
@@ -342,6 +343,83 @@ def synchronize_sensor_frames(args, recording_path, output_path, camera_names):
     return sync_frames, sync_poses
 
 
+# Frames recorded with a storage codec are stored as <timestamp>.pgm.hlfc:
+# a 24 byte header ('HLFC' cookie, codec, size of the bitmap header, row
+# length, number of rows and size of the pixels), the original PGM header
+# and the compressed pixels. See Shared/Io/Include/Io/FrameCodec.h.
+COMPRESSED_FRAME_HEADER = struct.Struct("<4sHHIIQ")
+COMPRESSED_FRAME_COOKIE = b"HLFC"
+FRAME_CODEC_LZ4 = 1
+
+
+def lz4_decompress_block(data, output_size):
+    output = bytearray()
+    pos = 0
+    while True:
+        token = data[pos]
+        pos += 1
+        literal_length = token >> 4
+        if literal_length == 15:
+            while True:
+                b = data[pos]
+                pos += 1
+                literal_length += b
+                if b != 255:
+                    break
+        output += data[pos:pos + literal_length]
+        pos += literal_length
+        if pos >= len(data):
+            break
+        offset = data[pos] | (data[pos + 1] << 8)
+        pos += 2
+        match_length = token & 0x0f
+        if match_length == 15:
+            while True:
+                b = data[pos]
+                pos += 1
+                match_length += b
+                if b != 255:
+                    break
+        match_length += 4
+        start = len(output) - offset
+        assert offset > 0 and start >= 0
+        # Matches may overlap the bytes they produce.
+        while match_length > 0:
+            chunk = output[start:start + min(match_length, offset)]
+            output += chunk
+            start += len(chunk)
+            match_length -= len(chunk)
+    assert len(output) == output_size
+    return bytes(output)
+
+
+def decompress_frames(recording_path):
+    # COLMAP reads PGM files, so frames stored with the LZ4 storage codec are
+    # decompressed next to the compressed files. Frames stored with the depth
+    # codec are not needed for the reconstruction and are left as they are.
+    num_skipped = 0
+    for file_name in glob.glob(os.path.join(recording_path, "*", "*.hlfc")):
+        bitmap_file_name = os.path.splitext(file_name)[0]
+        if os.path.exists(bitmap_file_name):
+            continue
+        with open(file_name, "rb") as fid:
+            data = fid.read()
+        cookie, codec, bitmap_header_size, _, _, pixel_data_size = \
+            COMPRESSED_FRAME_HEADER.unpack_from(data)
+        assert cookie == COMPRESSED_FRAME_COOKIE
+        if codec != FRAME_CODEC_LZ4:
+            num_skipped += 1
+            continue
+        payload_offset = COMPRESSED_FRAME_HEADER.size + bitmap_header_size
+        with open(bitmap_file_name, "wb") as fid:
+            fid.write(data[COMPRESSED_FRAME_HEADER.size:payload_offset])
+            fid.write(lz4_decompress_block(
+                data[payload_offset:], pixel_data_size))
+    if num_skipped > 0:
+        print("=> Skipped", num_skipped,
+              "frames stored with the depth codec")
+
+
 def extract_recording(recording_path):
     print("Extracting recording data...")
     for file_name in glob.glob(os.path.join(recording_path, "*.tar")):
@@ -349,6 +427,7 @@ def extract_recording(recording_path):
         tar = tarfile.open(file_name)
         tar.extractall(path=recording_path)
         tar.close()
+    decompress_frames(recording_path)
 
 
 def reconstruct_recording(args, recording_path, dense=True):
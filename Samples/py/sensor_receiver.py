@@ -31,6 +31,17 @@ PROCESS = True
 # ImageHeight PixelStride RowStride
 SENSOR_STREAM_HEADER_FORMAT = "@IBBHqIIII"
 
+# Version 0.2 headers are followed by the length of an extension block carrying
+# the camera pose and intrinsics, and the block itself
+SENSOR_STREAM_EXTENSIONS_LENGTH_FORMAT = "<I"
+
+# Version 0.3 headers additionally carry the codec of the image and the length
+# of the (compressed) image that follows the extension block
+SENSOR_STREAM_COMPRESSION_FORMAT = "<IHI"
+
+CODEC_RAW = 0
+CODEC_JPEG = 3
+
 SENSOR_FRAME_STREAM_HEADER = namedtuple(
     'SensorFrameStreamHeader',
     'Cookie VersionMajor VersionMinor FrameType Timestamp ImageWidth ImageHeight PixelStride RowStride'
@@ -41,6 +52,18 @@ SENSOR_FRAME_STREAM_HEADER = namedtuple(
 PV_STREAM_PORT = 23940
 
 
+def recv_exactly(s, size):
+    """Receives exactly size bytes"""
+    data = b''
+    while len(data) < size:
+        chunk = s.recv(size - len(data))
+        if not chunk:
+            print('ERROR: Failed to receive data')
+            sys.exit()
+        data += chunk
+    return data
+
+
 def main(argv):
     """Receiver main"""
     parser = argparse.ArgumentParser()
@@ -78,8 +101,22 @@ def main(argv):
             # Parse the header
             header = SENSOR_FRAME_STREAM_HEADER(*data)
 
-            # read the image in chunks
+            # Skip the header extensions, if any
+            codec = CODEC_RAW
             image_size_bytes = header.ImageHeight * header.RowStride
+
+            if header.VersionMinor >= 3:
+                extensions_length, codec, image_size_bytes = struct.unpack(
+                    SENSOR_STREAM_COMPRESSION_FORMAT,
+                    recv_exactly(s, struct.calcsize(SENSOR_STREAM_COMPRESSION_FORMAT)))
+                recv_exactly(s, extensions_length)
+            elif header.VersionMinor >= 2:
+                extensions_length = struct.unpack(
+                    SENSOR_STREAM_EXTENSIONS_LENGTH_FORMAT,
+                    recv_exactly(s, struct.calcsize(SENSOR_STREAM_EXTENSIONS_LENGTH_FORMAT)))[0]
+                recv_exactly(s, extensions_length)
+
+            # read the image in chunks
             image_data = ''
 
             while len(image_data) < image_size_bytes:
@@ -90,8 +127,15 @@ def main(argv):
                     sys.exit()
                 image_data += image_data_chunk
 
-            image_array = np.frombuffer(image_data, dtype=np.uint8).reshape((header.ImageHeight,
-                                        header.ImageWidth, header.PixelStride))
+            if codec == CODEC_JPEG:
+                image_array = cv2.imdecode(np.frombuffer(image_data, dtype=np.uint8),
+                                           cv2.IMREAD_COLOR)
+            elif codec != CODEC_RAW:
+                print('INFO: Skipping frame compressed with codec ' + str(codec))
+                continue
+            else:
+                image_array = np.frombuffer(image_data, dtype=np.uint8).reshape((header.ImageHeight,
+                                            header.ImageWidth, header.PixelStride))
             if PROCESS:
                 # process image
                 gray = cv2.cvtColor(image_array,cv2.COLOR_BGR2GRAY)
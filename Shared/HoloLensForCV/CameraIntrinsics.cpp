@@ -23,10 +23,61 @@ namespace HoloLensForCV
         ImageHeight = imageHeight;
     }
 
+    CameraIntrinsics::CameraIntrinsics(
+        _In_ std::shared_ptr<const Io::UnprojectionLut> unprojectionLut)
+        : _unprojectionLut(unprojectionLut)
+    {
+        REQUIRES(nullptr != unprojectionLut);
+
+        ImageWidth = unprojectionLut->GetImageWidth();
+        ImageHeight = unprojectionLut->GetImageHeight();
+    }
+
+    std::shared_ptr<const Io::UnprojectionLut> CameraIntrinsics::CreateUnprojectionLut()
+    {
+        if (nullptr != _unprojectionLut)
+        {
+            return _unprojectionLut;
+        }
+
+        auto unprojectionLut =
+            std::make_shared<Io::UnprojectionLut>();
+
+        unprojectionLut->Sample(
+            ImageWidth,
+            ImageHeight,
+            [this](float u, float v, float* x, float* y)
+            {
+                float uv[2] = { u, v };
+                float xy[2];
+
+                if (FAILED(_sensorStreamingCameraIntrinsics->MapImagePointToCameraUnitPlane(uv, xy)))
+                {
+                    return false;
+                }
+
+                *x = xy[0];
+                *y = xy[1];
+
+                return true;
+            });
+
+        return unprojectionLut;
+    }
+
     bool CameraIntrinsics::MapImagePointToCameraUnitPlane(
         _In_ Windows::Foundation::Point UV,
         _Out_ Windows::Foundation::Point* XY)
     {
+        if (nullptr != _unprojectionLut)
+        {
+            return _unprojectionLut->MapImagePointToCameraUnitPlane(
+                UV.X,
+                UV.Y,
+                &XY->X,
+                &XY->Y);
+        }
+
         float uv[2] = { UV.X, UV.Y };
         float xy[2];
 
@@ -47,6 +98,13 @@ namespace HoloLensForCV
         _In_ Windows::Foundation::Point XY,
         _Out_ Windows::Foundation::Point* UV)
     {
+        if (nullptr == _sensorStreamingCameraIntrinsics)
+        {
+            UV->X = UV->Y = std::numeric_limits<float>::infinity();
+
+            return false;
+        }
+
         float xy[2] = { XY.X, XY.Y };
         float uv[2];
 
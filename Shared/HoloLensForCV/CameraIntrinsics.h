@@ -25,6 +25,18 @@ namespace HoloLensForCV
             _In_ unsigned int imageWidth,
             _In_ unsigned int imageHeight);
 
+        //
+        // Intrinsics received over the network, as an unprojection LUT. Only
+        // MapImagePointToCameraUnitPlane is supported.
+        //
+        CameraIntrinsics(
+            _In_ std::shared_ptr<const Io::UnprojectionLut> unprojectionLut);
+
+        //
+        // Samples the unit plane at the center of each pixel, for streaming.
+        //
+        std::shared_ptr<const Io::UnprojectionLut> CreateUnprojectionLut();
+
     public:
         /// <summary>
         /// Maps an image pixel to the unit Z=1 plane.
@@ -42,6 +54,8 @@ namespace HoloLensForCV
         ///
         /// Convention applied is that integer coordinate of the pixel corresponds to
         /// the location of its top-left corner.
+        ///
+        /// Not available for intrinsics received over the network.
         /// </summary>
         bool MapCameraSpaceToImagePoint(
             _In_ Windows::Foundation::Point XY,
@@ -53,5 +67,6 @@ namespace HoloLensForCV
 
     private:
         Microsoft::WRL::ComPtr<SensorStreaming::ICameraIntrinsics> _sensorStreamingCameraIntrinsics;
+        std::shared_ptr<const Io::UnprojectionLut> _unprojectionLut;
     };
 }
@@ -13,17 +13,39 @@
 
 namespace HoloLensForCV
 {
+    namespace
+    {
+        //
+        // Holds a few seconds worth of the camera frame rows of the recorder.
+        //
+        const size_t c_csvWriterBufferSize = 64 * 1024;
+    }
+
     _Use_decl_annotations_
     CsvWriter::CsvWriter(
         const std::wstring& outputFileName)
-        : _file(outputFileName)
+        : _file(INVALID_HANDLE_VALUE)
+        , _buffer(c_csvWriterBufferSize)
+        , _bufferedSize(0)
     {
-        ASSERT(_file);
+        _file = CreateFile2(
+            outputFileName.c_str(),
+            GENERIC_WRITE /* dwDesiredAccess */,
+            FILE_SHARE_READ /* dwShareMode */,
+            CREATE_ALWAYS /* dwCreationDisposition */,
+            nullptr /* pCreateExParams */);
+
+        ASSERT(INVALID_HANDLE_VALUE != _file);
     }
 
     CsvWriter::~CsvWriter()
     {
         EndLine();
+
+        Flush();
+
+        CloseHandle(
+            _file);
     }
 
     _Use_decl_annotations_
@@ -34,10 +56,9 @@ namespace HoloLensForCV
 
         for (const auto& column : columns)
         {
-            WriteComma(
+            WriteText(
+                column,
                 &writeComma);
-
-            _file << column;
         }
 
         EndLine();
@@ -51,7 +72,37 @@ namespace HoloLensForCV
         WriteComma(
             writeComma);
 
-        _file << text;
+        //
+        // Our columns are ASCII for the most part; copy those directly and only
+        // convert the text when it needs multi-byte UTF-8 sequences.
+        //
+        const size_t length = text.size();
+
+        if (length <= _buffer.size())
+        {
+            char* output = Reserve(length);
+
+            size_t i = 0;
+
+            for (; i < length && text[i] < 0x80; ++i)
+            {
+                output[i] = static_cast<char>(text[i]);
+            }
+
+            if (i == length)
+            {
+                _bufferedSize += length;
+                return;
+            }
+        }
+
+        const std::string utf8Text =
+            Utf16ToUtf8(
+                text);
+
+        Append(
+            utf8Text.data(),
+            utf8Text.size());
     }
 
     _Use_decl_annotations_
@@ -62,7 +113,9 @@ namespace HoloLensForCV
         WriteComma(
             writeComma);
 
-        _file << value;
+        _bufferedSize += Io::FormatInt64(
+            value,
+            Reserve(Io::MaxFormattedIntegerLength + 1));
     }
 
     _Use_decl_annotations_
@@ -73,7 +126,9 @@ namespace HoloLensForCV
         WriteComma(
             writeComma);
 
-        _file << value;
+        _bufferedSize += Io::FormatUInt64(
+            value,
+            Reserve(Io::MaxFormattedIntegerLength));
     }
 
     _Use_decl_annotations_
@@ -84,7 +139,9 @@ namespace HoloLensForCV
         WriteComma(
             writeComma);
 
-        _file << value;
+        _bufferedSize += Io::FormatFloat(
+            value,
+            Reserve(Io::MaxFormattedFloatLength));
     }
 
     _Use_decl_annotations_
@@ -95,7 +152,9 @@ namespace HoloLensForCV
         WriteComma(
             writeComma);
 
-        _file << value;
+        _bufferedSize += Io::FormatDouble(
+            value,
+            Reserve(Io::MaxFormattedDoubleLength));
     }
 
     _Use_decl_annotations_
@@ -156,7 +215,18 @@ namespace HoloLensForCV
 
     void CsvWriter::EndLine()
     {
-        _file << std::endl;
+        Append(
+            "\n",
+            1);
+    }
+
+    void CsvWriter::Flush()
+    {
+        WriteToFile(
+            _buffer.data(),
+            _bufferedSize);
+
+        _bufferedSize = 0;
     }
 
     _Use_decl_annotations_
@@ -165,11 +235,75 @@ namespace HoloLensForCV
     {
         if (*writeComma)
         {
-            _file << ',';
+            Append(
+                ",",
+                1);
         }
         else
         {
             *writeComma = true;
         }
     }
+
+    _Use_decl_annotations_
+    char* CsvWriter::Reserve(
+        const size_t size)
+    {
+        ASSERT(size <= _buffer.size());
+
+        if (_buffer.size() - _bufferedSize < size)
+        {
+            Flush();
+        }
+
+        return _buffer.data() + _bufferedSize;
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::Append(
+        const char* data,
+        const size_t size)
+    {
+        if (size > _buffer.size())
+        {
+            //
+            // Too large to be buffered; write it out directly.
+            //
+            Flush();
+
+            WriteToFile(
+                data,
+                size);
+
+            return;
+        }
+
+        memcpy(
+            Reserve(size),
+            data,
+            size);
+
+        _bufferedSize += size;
+    }
+
+    _Use_decl_annotations_
+    void CsvWriter::WriteToFile(
+        const char* data,
+        size_t size)
+    {
+        while (size > 0)
+        {
+            DWORD numberOfBytesWritten = 0;
+
+            ASSERT(!!WriteFile(
+                _file,
+                data,
+                static_cast<DWORD>(std::min<size_t>(size, MAXDWORD)),
+                &numberOfBytesWritten,
+                nullptr /* lpOverlapped */));
+
+            data += numberOfBytesWritten;
+            size -= numberOfBytesWritten;
+        }
+    }
 }
@@ -13,6 +13,12 @@
 
 namespace HoloLensForCV
 {
+    //
+    // Writes comma separated values to a UTF-8 encoded file. The values are
+    // formatted into a reusable buffer without going through the C++ streams
+    // and written to disk in large blocks; floats use the shortest text that
+    // parses back to the same value.
+    //
     class CsvWriter
     {
     public:
@@ -21,6 +27,9 @@ namespace HoloLensForCV
 
         ~CsvWriter();
 
+        CsvWriter(const CsvWriter&) = delete;
+        CsvWriter& operator=(const CsvWriter&) = delete;
+
         void WriteHeader(
             _In_ const std::vector<std::wstring>& columns);
 
@@ -61,11 +70,35 @@ namespace HoloLensForCV
 
         void EndLine();
 
+        //
+        // Writes the buffered text to the file.
+        //
+        void Flush();
+
     protected:
         void WriteComma(
             _Inout_ bool* shouldWrite);
 
+        //
+        // Returns a pointer to at least the given number of free bytes in the
+        // buffer, flushing it first if needed. Commit the bytes actually used
+        // by advancing _bufferedSize.
+        //
+        char* Reserve(
+            _In_ const size_t size);
+
+        void Append(
+            _In_reads_(size) const char* data,
+            _In_ const size_t size);
+
+        void WriteToFile(
+            _In_reads_(size) const char* data,
+            _In_ size_t size);
+
     protected:
-        std::wofstream _file;
+        HANDLE _file;
+
+        std::vector<char> _buffer;
+        size_t _bufferedSize;
     };
 }
@@ -13,13 +13,83 @@
 
 namespace HoloLensForCV
 {
-    static double TimeDeltaAMinusB(
-        Windows::Foundation::DateTime a,
-        Windows::Foundation::DateTime b)
+    namespace
     {
-        auto timeDiff100ns = a.UniversalTime - b.UniversalTime;
+        //
+        // Snapshot of a sensor's recent frames, sorted by timestamp.
+        //
+        struct SensorHistory
+        {
+            std::vector<SensorFrameRing::Entry> Entries;
+            std::vector<int64_t> Timestamps;
+
+            TimestampStream GetTimestampStream() const
+            {
+                TimestampStream stream;
+
+                stream.Timestamps = Timestamps.data();
+                stream.Count = Timestamps.size();
+
+                return stream;
+            }
+        };
+
+        void GetSortedHistory(
+            _In_ const SensorFrameRing& ring,
+            _Out_ SensorHistory& history)
+        {
+            ring.GetHistory(
+                history.Entries);
+
+
+            auto timestampLess =
+                [](const SensorFrameRing::Entry& a, const SensorFrameRing::Entry& b)
+            {
+                return a.Timestamp < b.Timestamp;
+            };
+
+            //
+            // Frames arrive in timestamp order, so this is normally a no-op.
+            //
+            if (!std::is_sorted(history.Entries.begin(), history.Entries.end(), timestampLess))
+            {
+                std::stable_sort(
+                    history.Entries.begin(),
+                    history.Entries.end(),
+                    timestampLess);
+            }
+
+            history.Timestamps.reserve(
+                history.Entries.size());
+
+            for (const auto& entry : history.Entries)
+            {
+                history.Timestamps.push_back(
+                    entry.Timestamp);
+            }
+        }
+
+        int64_t ToleranceInTicks(
+            _In_ const float toleranceInSeconds)
+        {
+            return static_cast<int64_t>(
+                static_cast<double>(toleranceInSeconds) * 1e7);
+        }
+    }
+
+    MultiFrameBuffer::MultiFrameBuffer()
+        : MultiFrameBuffer(5 /* historyDepth */)
+    {
+    }
 
-        return timeDiff100ns * 1e-7;
+    MultiFrameBuffer::MultiFrameBuffer(
+        _In_ uint32_t historyDepth)
+    {
+        for (auto& ring : _rings)
+        {
+            ring = std::make_unique<SensorFrameRing>(
+                historyDepth);
+        }
     }
 
     ISensorFrameSink^ MultiFrameBuffer::GetSensorFrameSink(
@@ -31,31 +101,15 @@ namespace HoloLensForCV
     void MultiFrameBuffer::Send(
         SensorFrame^ sensorFrame)
     {
-        std::lock_guard<std::mutex> lock(_framesMutex);
-        
-        auto& buffer = _frames[sensorFrame->FrameType];
-        
-        buffer.push_back(sensorFrame);
-        
-        while (buffer.size() > 5)
-        {
-            buffer.pop_front();
-        }
+        GetRing(sensorFrame->FrameType).Push(
+            sensorFrame,
+            sensorFrame->Timestamp.UniversalTime);
     }
 
     SensorFrame^ MultiFrameBuffer::GetLatestFrame(
         SensorType sensor)
     {
-        std::lock_guard<std::mutex> lock(_framesMutex);
-
-        auto& buffer = _frames[sensor];
-
-        if (buffer.empty())
-        {
-            return nullptr;
-        }
-
-        return buffer.back();
+        return GetRing(sensor).GetLatest();
     }
 
     SensorFrame^ MultiFrameBuffer::GetFrameForTime(
@@ -63,25 +117,21 @@ namespace HoloLensForCV
         Windows::Foundation::DateTime Timestamp,
         float toleranceInSeconds)
     {
-        std::lock_guard<std::mutex> lock(_framesMutex);
+        SensorHistory history;
 
-        auto& buffer = _frames[sensor];
+        GetSortedHistory(
+            GetRing(sensor),
+            history);
 
-        for (auto& f : buffer)
-        {
-            const double secondsDifference =
-                std::abs(
-                    TimeDeltaAMinusB(
-                        Timestamp,
-                        f->Timestamp));
+        size_t nearest;
 
-            if (secondsDifference < toleranceInSeconds)
-            {
-                return f;
-            }
+        if (!FindNearestTimestamp(history.GetTimestampStream(), Timestamp.UniversalTime, &nearest) ||
+            std::abs(history.Timestamps[nearest] - Timestamp.UniversalTime) >= ToleranceInTicks(toleranceInSeconds))
+        {
+            return nullptr;
         }
 
-        return nullptr;
+        return history.Entries[nearest].Frame;
     }
 
     Windows::Foundation::DateTime MultiFrameBuffer::GetTimestampForSensorPair(
@@ -89,40 +139,137 @@ namespace HoloLensForCV
         SensorType b,
         float toleranceInSeconds)
     {
-        std::vector<Windows::Foundation::DateTime> vta;
-        std::vector<Windows::Foundation::DateTime> vtb;
+        std::array<std::vector<int64_t>, 2> timestamps;
 
-        {
-            std::lock_guard<std::mutex> lock(_framesMutex);
+        GetRing(a).GetTimestamps(
+            timestamps[0]);
 
-            for (auto& f : _frames[a])
-            {
-                vta.push_back(f->Timestamp);
-            }
+        GetRing(b).GetTimestamps(
+            timestamps[1]);
 
-            for (auto& f : _frames[b])
-            {
-                vtb.push_back(f->Timestamp);
-            }
+        std::array<TimestampStream, 2> streams;
+
+        for (size_t i = 0; i < streams.size(); ++i)
+        {
+            std::sort(
+                timestamps[i].begin(),
+                timestamps[i].end());
+
+            streams[i].Timestamps = timestamps[i].data();
+            streams[i].Count = timestamps[i].size();
         }
 
+        std::array<size_t, 2> indices;
+
         Windows::Foundation::DateTime best;
         best.UniversalTime = 0;
 
-        for (auto ta : vta)
+        if (FindLatestTimestampTuple(streams.data(), streams.size(), ToleranceInTicks(toleranceInSeconds), indices.data()))
+        {
+            best.UniversalTime = timestamps[0][indices[0]];
+        }
+
+        return best;
+    }
+
+    SensorFrameTuple^ MultiFrameBuffer::GetLatestFrameTuple(
+        const Platform::Array<SensorType>^ sensors,
+        float toleranceInSeconds)
+    {
+        REQUIRES(nullptr != sensors && sensors->Length > 0);
+
+        std::vector<SensorHistory> histories(sensors->Length);
+        std::vector<TimestampStream> streams(sensors->Length);
+
+        for (uint32_t i = 0; i < sensors->Length; ++i)
+        {
+            GetSortedHistory(
+                GetRing(sensors[i]),
+                histories[i]);
+
+            streams[i] = histories[i].GetTimestampStream();
+        }
+
+        std::vector<size_t> indices(sensors->Length);
+
+        if (!FindLatestTimestampTuple(streams.data(), streams.size(), ToleranceInTicks(toleranceInSeconds), indices.data()))
+        {
+            return nullptr;
+        }
+
+        auto frames = ref new Platform::Collections::Vector<SensorFrame^>();
+
+        for (uint32_t i = 0; i < sensors->Length; ++i)
+        {
+            frames->Append(
+                histories[i].Entries[indices[i]].Frame);
+        }
+
+        return ref new SensorFrameTuple(
+            frames->GetAt(0)->Timestamp,
+            frames->GetView());
+    }
+
+    Windows::Foundation::Collections::IVectorView<SensorFrameTuple^>^ MultiFrameBuffer::GetFrameTuplesSince(
+        const Platform::Array<SensorType>^ sensors,
+        Windows::Foundation::DateTime since,
+        float toleranceInSeconds)
+    {
+        REQUIRES(nullptr != sensors && sensors->Length > 0);
+
+        std::vector<SensorHistory> histories(sensors->Length);
+        std::vector<TimestampStream> streams(sensors->Length);
+
+        for (uint32_t i = 0; i < sensors->Length; ++i)
+        {
+            GetSortedHistory(
+                GetRing(sensors[i]),
+                histories[i]);
+
+            streams[i] = histories[i].GetTimestampStream();
+        }
+
+        std::vector<size_t> indices;
+
+        const size_t tupleCount = FindTimestampTuplesSince(
+            streams.data(),
+            streams.size(),
+            since.UniversalTime,
+            ToleranceInTicks(toleranceInSeconds),
+            indices);
+
+        auto tuples = ref new Platform::Collections::Vector<SensorFrameTuple^>();
+
+        for (size_t t = 0; t < tupleCount; ++t)
         {
-            for (auto tb : vtb)
+            const size_t* tupleIndices = &indices[t * sensors->Length];
+
+            auto frames = ref new Platform::Collections::Vector<SensorFrame^>();
+
+            for (uint32_t i = 0; i < sensors->Length; ++i)
             {
-                if (std::abs(TimeDeltaAMinusB(ta, tb)) < toleranceInSeconds)
-                {
-                    if (TimeDeltaAMinusB(ta, best) > 0)
-                    {
-                        best = ta;
-                    }
-                }
+                frames->Append(
+                    histories[i].Entries[tupleIndices[i]].Frame);
             }
+
+            tuples->Append(
+                ref new SensorFrameTuple(
+                    frames->GetAt(0)->Timestamp,
+                    frames->GetView()));
         }
 
-        return best;
+        return tuples->GetView();
+    }
+
+    SensorFrameRing& MultiFrameBuffer::GetRing(
+        _In_ SensorType sensorType)
+    {
+        const int32_t sensorIndex = (int32_t)sensorType;
+
+        REQUIRES(
+            sensorIndex >= 0 &&
+            sensorIndex < (int32_t)SensorType::NumberOfSensorTypes);
+
+        return *_rings[sensorIndex];
     }
 }
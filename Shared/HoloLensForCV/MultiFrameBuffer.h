@@ -18,6 +18,14 @@ namespace HoloLensForCV
         , public ISensorFrameSinkGroup
     {
     public:
+        MultiFrameBuffer();
+
+        //
+        // Keeps the given number of most recent frames per sensor.
+        //
+        MultiFrameBuffer(
+            _In_ uint32_t historyDepth);
+
         virtual void Send(
             SensorFrame^ sensorFrame);
 
@@ -27,6 +35,10 @@ namespace HoloLensForCV
         SensorFrame^ GetLatestFrame(
             SensorType sensor);
 
+        //
+        // Returns the frame nearest to the given time, or null if there is no
+        // frame less than the tolerance away from it.
+        //
         SensorFrame^ GetFrameForTime(
             SensorType sensor,
             Windows::Foundation::DateTime Timestamp,
@@ -37,8 +49,34 @@ namespace HoloLensForCV
             SensorType b,
             float toleranceInSeconds);
 
+        //
+        // Returns the most recent frame of the first sensor for which every other
+        // sensor has a frame less than the tolerance away, together with those
+        // frames, or null if there is no such frame.
+        //
+        SensorFrameTuple^ GetLatestFrameTuple(
+            const Platform::Array<SensorType>^ sensors,
+            float toleranceInSeconds);
+
+        //
+        // Returns all the frame tuples that GetLatestFrameTuple could match for
+        // frames of the first sensor more recent than the given time, oldest first.
+        //
+        Windows::Foundation::Collections::IVectorView<SensorFrameTuple^>^ GetFrameTuplesSince(
+            const Platform::Array<SensorType>^ sensors,
+            Windows::Foundation::DateTime since,
+            float toleranceInSeconds);
+
+    private:
+        SensorFrameRing& GetRing(
+            _In_ SensorType sensorType);
+
     private:
-        std::map<SensorType, std::deque<SensorFrame^>> _frames;
-        std::mutex _framesMutex;
+        //
+        // One ring per sensor type. Each sensor's frames are sent from a single
+        // thread, so every ring has one producer, and readers never block the
+        // frame reader callbacks.
+        //
+        std::array<std::unique_ptr<SensorFrameRing>, (size_t)SensorType::NumberOfSensorTypes> _rings;
     };
 }
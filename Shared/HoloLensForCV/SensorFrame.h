@@ -34,5 +34,19 @@ namespace HoloLensForCV
         property Windows::Foundation::Numerics::float4x4 FrameToOrigin;
         property Windows::Foundation::Numerics::float4x4 CameraViewTransform;
         property Windows::Foundation::Numerics::float4x4 CameraProjectionTransform;
+
+    internal:
+        //
+        // Frames received into a pooled bitmap keep it from being reused until they
+        // are released.
+        //
+        void SetBitmapLease(
+            _In_ std::shared_ptr<Windows::Graphics::Imaging::SoftwareBitmap^> bitmapLease)
+        {
+            _bitmapLease = std::move(bitmapLease);
+        }
+
+    private:
+        std::shared_ptr<Windows::Graphics::Imaging::SoftwareBitmap^> _bitmapLease;
     };
 }
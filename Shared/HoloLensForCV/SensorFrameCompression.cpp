@@ -0,0 +1,576 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    namespace
+    {
+        Windows::Storage::Streams::IBuffer^ CopyToBuffer(
+            _In_reads_(size) const uint8_t* data,
+            _In_ uint32_t size)
+        {
+            Windows::Storage::Streams::Buffer^ buffer =
+                ref new Windows::Storage::Streams::Buffer(size);
+
+            memcpy(
+                Io::GetTypedPointerToIBuffer<uint8_t>(buffer),
+                data,
+                size);
+
+            buffer->Length = size;
+
+            return buffer;
+        }
+
+        void DecompressLossless(
+            _In_ SensorFrameStreamingCodec codec,
+            _In_reads_(payloadLength) const uint8_t* payload,
+            _In_ uint32_t payloadLength,
+            _In_ uint32_t imageHeight,
+            _In_ uint32_t rowStride,
+            _Out_writes_(imageHeight * rowStride) uint8_t* pixels)
+        {
+            switch (codec)
+            {
+            case SensorFrameStreamingCodec::Lz4:
+                Io::Lz4Decompress(
+                    payload,
+                    payloadLength,
+                    pixels,
+                    imageHeight * rowStride);
+                break;
+
+            case SensorFrameStreamingCodec::Depth:
+                REQUIRES(0 == rowStride % sizeof(uint16_t));
+
+                Io::DepthDecompress(
+                    payload,
+                    payloadLength,
+                    rowStride / sizeof(uint16_t),
+                    imageHeight,
+                    reinterpret_cast<uint16_t*>(pixels));
+                break;
+
+            default:
+                REQUIRES(false);
+            }
+        }
+    }
+
+    SensorFrameCompressor::SensorFrameCompressor(
+        _In_ SensorFrameStreamingCodec codec,
+        _In_ float jpegQuality,
+        _In_ uint32_t keyframeInterval)
+        : _codec(codec)
+        , _jpegQuality(jpegQuality)
+        , _keyframeInterval(keyframeInterval)
+        , _referenceImageSize(0)
+        , _referenceRowStride(0)
+        , _framesSinceKeyframe(0)
+        , _keyframeRequested(true)
+    {
+        REQUIRES(0.0f <= jpegQuality && jpegQuality <= 1.0f);
+        REQUIRES(keyframeInterval > 0);
+    }
+
+    Windows::Storage::Streams::IBuffer^ SensorFrameCompressor::Compress(
+        _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat,
+        _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+        _In_ uint32_t imageHeight,
+        _In_ uint32_t rowStride,
+        _Out_ SensorFrameStreamingCodec* codec,
+        _Out_ bool* isKeyframe)
+    {
+        *isKeyframe = true;
+
+        const bool is16BitPerPixel =
+            (Windows::Graphics::Imaging::BitmapPixelFormat::Gray16 == pixelFormat);
+
+        const bool isJpegCompatible =
+            (Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8 == pixelFormat) ||
+            (Windows::Graphics::Imaging::BitmapPixelFormat::Gray8 == pixelFormat);
+
+        SensorFrameStreamingCodec effectiveCodec = _codec;
+
+        //
+        // Fall back to the closest codec that applies to the pixels: JPEG would
+        // lose the range of the 16-bit images, which the depth codec keeps.
+        //
+        if (SensorFrameStreamingCodec::Jpeg == effectiveCodec && !isJpegCompatible)
+        {
+            effectiveCodec = SensorFrameStreamingCodec::Depth;
+        }
+
+        if (SensorFrameStreamingCodec::Depth == effectiveCodec &&
+            (!is16BitPerPixel ||
+             0 != rowStride % sizeof(uint16_t) ||
+             0 != reinterpret_cast<uintptr_t>(pixels) % alignof(uint16_t)))
+        {
+            effectiveCodec = SensorFrameStreamingCodec::Lz4;
+        }
+
+        if (SensorFrameStreamingCodec::Raw == effectiveCodec || 0 == imageHeight * rowStride)
+        {
+            *codec = SensorFrameStreamingCodec::Raw;
+
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (SensorFrameStreamingCodec::Delta == effectiveCodec)
+        {
+            *codec = SensorFrameStreamingCodec::Delta;
+
+            return CompressDelta(
+                pixelFormat,
+                pixels,
+                imageHeight,
+                rowStride,
+                isKeyframe);
+        }
+
+        Windows::Storage::Streams::IBuffer^ compressedPixels;
+
+        if (SensorFrameStreamingCodec::Jpeg == effectiveCodec)
+        {
+            compressedPixels =
+                CompressJpeg(pixelFormat, pixels, imageHeight, rowStride);
+        }
+        else
+        {
+            const size_t compressedSize =
+                CompressLossless(effectiveCodec, pixels, imageHeight, rowStride, 0 /* outputOffset */);
+
+            if (compressedSize < imageHeight * rowStride)
+            {
+                compressedPixels =
+                    CopyToBuffer(_compressedPixels.data(), static_cast<uint32_t>(compressedSize));
+            }
+        }
+
+        //
+        // Send incompressible frames as they are.
+        //
+        if (nullptr == compressedPixels || compressedPixels->Length >= imageHeight * rowStride)
+        {
+            *codec = SensorFrameStreamingCodec::Raw;
+
+            return nullptr;
+        }
+
+        *codec = effectiveCodec;
+
+        return compressedPixels;
+    }
+
+    void SensorFrameCompressor::RequestKeyframe()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _keyframeRequested = true;
+    }
+
+    size_t SensorFrameCompressor::CompressLossless(
+        _In_ SensorFrameStreamingCodec codec,
+        _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+        _In_ uint32_t imageHeight,
+        _In_ uint32_t rowStride,
+        _In_ size_t outputOffset)
+    {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+        dbg::TimerGuard timerGuard(
+            L"SensorFrameCompressor::CompressLossless",
+            8.0 /* minimum_time_elapsed_in_milliseconds */);
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+        const size_t pixelDataSize =
+            static_cast<size_t>(imageHeight) * rowStride;
+
+        const uint32_t rowLength =
+            rowStride / sizeof(uint16_t);
+
+        const size_t compressBound =
+            (SensorFrameStreamingCodec::Depth == codec) ?
+            Io::DepthCompressBound(rowLength, imageHeight) :
+            Io::Lz4CompressBound(pixelDataSize);
+
+        if (_compressedPixels.size() < outputOffset + compressBound)
+        {
+            _compressedPixels.resize(outputOffset + compressBound);
+        }
+
+        if (SensorFrameStreamingCodec::Depth == codec)
+        {
+            return Io::DepthCompress(
+                reinterpret_cast<const uint16_t*>(pixels),
+                rowLength,
+                imageHeight,
+                _compressedPixels.data() + outputOffset,
+                compressBound);
+        }
+
+        return _lz4Compressor.Compress(
+            pixels,
+            pixelDataSize,
+            _compressedPixels.data() + outputOffset,
+            compressBound);
+    }
+
+    Windows::Storage::Streams::IBuffer^ SensorFrameCompressor::CompressDelta(
+        _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat,
+        _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+        _In_ uint32_t imageHeight,
+        _In_ uint32_t rowStride,
+        _Out_ bool* isKeyframe)
+    {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+        dbg::TimerGuard timerGuard(
+            L"SensorFrameCompressor::CompressDelta",
+            8.0 /* minimum_time_elapsed_in_milliseconds */);
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+        const size_t imageSize =
+            static_cast<size_t>(imageHeight) * rowStride;
+
+        const size_t outputOffset =
+            sizeof(SensorFrameDeltaHeader);
+
+        //
+        // 16-bit images are differenced sample by sample, and their keyframes
+        // are compressed with the depth codec.
+        //
+        const bool is16BitPerPixel =
+            Windows::Graphics::Imaging::BitmapPixelFormat::Gray16 == pixelFormat &&
+            0 == rowStride % sizeof(uint16_t) &&
+            0 == reinterpret_cast<uintptr_t>(pixels) % alignof(uint16_t);
+
+        const uint32_t bytesPerSample =
+            is16BitPerPixel ? 2 : 1;
+
+        SensorFrameDeltaHeader deltaHeader = {};
+        size_t compressedSize = 0;
+
+        *isKeyframe =
+            _keyframeRequested ||
+            _framesSinceKeyframe >= _keyframeInterval ||
+            _referenceImageSize != imageSize ||
+            _referenceRowStride != rowStride;
+
+        if (!*isKeyframe)
+        {
+            const uint32_t rowLength =
+                rowStride / bytesPerSample;
+
+            const size_t compressBound =
+                Io::DeltaCompressBound(bytesPerSample, rowLength, imageHeight);
+
+            if (_compressedPixels.size() < outputOffset + compressBound)
+            {
+                _compressedPixels.resize(outputOffset + compressBound);
+            }
+
+            compressedSize = Io::DeltaCompress(
+                pixels,
+                reinterpret_cast<const uint8_t*>(_referencePixels.data()),
+                bytesPerSample,
+                rowLength,
+                imageHeight,
+                _compressedPixels.data() + outputOffset,
+                compressBound);
+
+            //
+            // Send a keyframe instead of a delta that isn't smaller than the
+            // image, e.g. when the camera moved.
+            //
+            *isKeyframe =
+                compressedSize >= imageSize;
+
+            deltaHeader.BytesPerSample =
+                static_cast<uint8_t>(bytesPerSample);
+        }
+
+        if (*isKeyframe)
+        {
+            SensorFrameStreamingCodec keyframeCodec =
+                is16BitPerPixel ? SensorFrameStreamingCodec::Depth : SensorFrameStreamingCodec::Lz4;
+
+            compressedSize = CompressLossless(
+                keyframeCodec,
+                pixels,
+                imageHeight,
+                rowStride,
+                outputOffset);
+
+            if (compressedSize >= imageSize)
+            {
+                keyframeCodec = SensorFrameStreamingCodec::Raw;
+
+                memcpy(
+                    _compressedPixels.data() + outputOffset,
+                    pixels,
+                    imageSize);
+
+                compressedSize = imageSize;
+            }
+
+            deltaHeader.Flags = SensorFrameDeltaFlagKeyframe;
+            deltaHeader.KeyframeCodec = static_cast<uint8_t>(keyframeCodec);
+            deltaHeader.BytesPerSample = 0;
+
+            _framesSinceKeyframe = 1;
+            _keyframeRequested = false;
+        }
+        else
+        {
+            ++_framesSinceKeyframe;
+        }
+
+        //
+        // The frame is the reference of the next one.
+        //
+        _referencePixels.resize(
+            (imageSize + 1) / sizeof(uint16_t));
+
+        memcpy(
+            _referencePixels.data(),
+            pixels,
+            imageSize);
+
+        _referenceImageSize = imageSize;
+        _referenceRowStride = rowStride;
+
+        memcpy(
+            _compressedPixels.data(),
+            &deltaHeader,
+            sizeof(deltaHeader));
+
+        return CopyToBuffer(
+            _compressedPixels.data(),
+            static_cast<uint32_t>(outputOffset + compressedSize));
+    }
+
+    Windows::Storage::Streams::IBuffer^ SensorFrameCompressor::CompressJpeg(
+        _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat,
+        _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+        _In_ uint32_t imageHeight,
+        _In_ uint32_t rowStride)
+    {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+        dbg::TimerGuard timerGuard(
+            L"SensorFrameCompressor::CompressJpeg",
+            20.0 /* minimum_time_elapsed_in_milliseconds */);
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+        const uint32_t bytesPerPixel =
+            (Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8 == pixelFormat) ? 4 : 1;
+
+        Windows::Storage::Streams::InMemoryRandomAccessStream^ stream =
+            ref new Windows::Storage::Streams::InMemoryRandomAccessStream();
+
+        Windows::Graphics::Imaging::BitmapPropertySet^ encodingOptions =
+            ref new Windows::Graphics::Imaging::BitmapPropertySet();
+
+        encodingOptions->Insert(
+            L"ImageQuality",
+            ref new Windows::Graphics::Imaging::BitmapTypedValue(
+                _jpegQuality,
+                Windows::Foundation::PropertyType::Single));
+
+        Windows::Graphics::Imaging::BitmapEncoder^ encoder =
+            Concurrency::create_task(
+                Windows::Graphics::Imaging::BitmapEncoder::CreateAsync(
+                    Windows::Graphics::Imaging::BitmapEncoder::JpegEncoderId,
+                    stream,
+                    encodingOptions)).get();
+
+        //
+        // The encoder reads the pixels straight from the locked bitmap buffer.
+        //
+        encoder->SetPixelData(
+            pixelFormat,
+            Windows::Graphics::Imaging::BitmapAlphaMode::Ignore,
+            rowStride / bytesPerPixel,
+            imageHeight,
+            96.0 /* dpiX */,
+            96.0 /* dpiY */,
+            Platform::ArrayReference<uint8_t>(
+                const_cast<uint8_t*>(pixels),
+                imageHeight * rowStride));
+
+        Concurrency::create_task(
+            encoder->FlushAsync()).get();
+
+        const uint32_t encodedSize =
+            static_cast<uint32_t>(stream->Size);
+
+        Windows::Storage::Streams::Buffer^ encodedPixels =
+            ref new Windows::Storage::Streams::Buffer(encodedSize);
+
+        return Concurrency::create_task(
+            stream->GetInputStreamAt(0)->ReadAsync(
+                encodedPixels,
+                encodedSize,
+                Windows::Storage::Streams::InputStreamOptions::None)).get();
+    }
+
+    void DecompressSensorFrame(
+        _In_ SensorFrameStreamHeader^ header,
+        _In_reads_(payloadLength) const uint8_t* payload,
+        _In_ uint32_t payloadLength,
+        _Out_writes_(header->ImageHeight * header->RowStride) uint8_t* pixels)
+    {
+        DecompressLossless(
+            header->Codec,
+            payload,
+            payloadLength,
+            header->ImageHeight,
+            header->RowStride,
+            pixels);
+    }
+
+    void SensorFrameDeltaDecoder::Decompress(
+        _In_ SensorFrameStreamHeader^ header,
+        _In_reads_(payloadLength) const uint8_t* payload,
+        _In_ uint32_t payloadLength,
+        _Out_writes_(header->ImageHeight * header->RowStride) uint8_t* pixels)
+    {
+        const size_t imageSize =
+            static_cast<size_t>(header->ImageHeight) * header->RowStride;
+
+        SensorFrameDeltaHeader deltaHeader = {};
+
+        if (payloadLength < sizeof(deltaHeader))
+        {
+            throw ref new Platform::FailureException();
+        }
+
+        memcpy(
+            &deltaHeader,
+            payload,
+            sizeof(deltaHeader));
+
+        payload += sizeof(deltaHeader);
+        payloadLength -= sizeof(deltaHeader);
+
+        const bool isKeyframe =
+            0 != (deltaHeader.Flags & SensorFrameDeltaFlagKeyframe);
+
+        //
+        // Deltas apply to the previous frame, which the receiver may not have,
+        // e.g. if it failed to decode it.
+        //
+        if (!isKeyframe &&
+            (_referenceRowStride != header->RowStride ||
+             _referenceImageHeight != header->ImageHeight ||
+             (1 != deltaHeader.BytesPerSample && 2 != deltaHeader.BytesPerSample) ||
+             0 != header->RowStride % deltaHeader.BytesPerSample))
+        {
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"SensorFrameDeltaDecoder::Decompress: no reference frame for a delta of %u rows of %u bytes",
+                header->ImageHeight,
+                header->RowStride);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        //
+        // The reference is only valid again once the frame has been decoded.
+        //
+        _referenceRowStride = 0;
+        _referenceImageHeight = 0;
+
+        if (isKeyframe)
+        {
+            _referencePixels.resize(
+                (imageSize + 1) / sizeof(uint16_t));
+
+            uint8_t* referencePixels =
+                reinterpret_cast<uint8_t*>(_referencePixels.data());
+
+            switch ((SensorFrameStreamingCodec)deltaHeader.KeyframeCodec)
+            {
+            case SensorFrameStreamingCodec::Raw:
+                if (payloadLength != imageSize)
+                {
+                    throw ref new Platform::FailureException();
+                }
+
+                memcpy(
+                    referencePixels,
+                    payload,
+                    imageSize);
+                break;
+
+            case SensorFrameStreamingCodec::Lz4:
+            case SensorFrameStreamingCodec::Depth:
+                DecompressLossless(
+                    (SensorFrameStreamingCodec)deltaHeader.KeyframeCodec,
+                    payload,
+                    payloadLength,
+                    header->ImageHeight,
+                    header->RowStride,
+                    referencePixels);
+                break;
+
+            default:
+                throw ref new Platform::FailureException();
+            }
+        }
+        else
+        {
+            Io::DeltaDecompress(
+                payload,
+                payloadLength,
+                deltaHeader.BytesPerSample,
+                header->RowStride / deltaHeader.BytesPerSample,
+                header->ImageHeight,
+                reinterpret_cast<uint8_t*>(_referencePixels.data()));
+        }
+
+        _referenceRowStride = header->RowStride;
+        _referenceImageHeight = header->ImageHeight;
+
+        memcpy(
+            pixels,
+            _referencePixels.data(),
+            imageSize);
+    }
+
+    Concurrency::task<Windows::Graphics::Imaging::SoftwareBitmap^> DecodeJpegSensorFrameAsync(
+        _In_ Windows::Storage::Streams::IBuffer^ payload,
+        _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat)
+    {
+        Windows::Storage::Streams::InMemoryRandomAccessStream^ stream =
+            ref new Windows::Storage::Streams::InMemoryRandomAccessStream();
+
+        return Concurrency::create_task(
+            stream->WriteAsync(payload)
+        ).then([stream](unsigned int /* bytesWritten */)
+        {
+            stream->Seek(0);
+
+            return Windows::Graphics::Imaging::BitmapDecoder::CreateAsync(
+                Windows::Graphics::Imaging::BitmapDecoder::JpegDecoderId,
+                stream);
+        }).then([pixelFormat](Windows::Graphics::Imaging::BitmapDecoder^ decoder)
+        {
+            return decoder->GetSoftwareBitmapAsync(
+                pixelFormat,
+                Windows::Graphics::Imaging::BitmapAlphaMode::Ignore);
+        });
+    }
+}
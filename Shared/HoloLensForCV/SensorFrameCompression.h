@@ -0,0 +1,168 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Compresses the frames of a sensor for streaming, reusing its buffers
+    // across frames. Thread safe.
+    //
+    class SensorFrameCompressor
+    {
+    public:
+        SensorFrameCompressor(
+            _In_ SensorFrameStreamingCodec codec,
+            _In_ float jpegQuality,
+            _In_ uint32_t keyframeInterval);
+
+        SensorFrameCompressor(const SensorFrameCompressor&) = delete;
+        SensorFrameCompressor& operator=(const SensorFrameCompressor&) = delete;
+
+        SensorFrameStreamingCodec GetCodec() const
+        {
+            return _codec;
+        }
+
+        //
+        // Compresses the tightly packed pixels of a frame, imageHeight rows of
+        // rowStride bytes in the given streaming pixel format. Returns the codec
+        // that was used and the compressed pixels, or nullptr when the frame
+        // should be sent as is.
+        //
+        // With the Delta codec, frames must be compressed in the order they are
+        // sent, and every frame but the keyframes depends on the previous one.
+        //
+        // JPEG compression waits for the system encoder; don't call from a
+        // single-threaded apartment.
+        //
+        Windows::Storage::Streams::IBuffer^ Compress(
+            _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat,
+            _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+            _In_ uint32_t imageHeight,
+            _In_ uint32_t rowStride,
+            _Out_ SensorFrameStreamingCodec* codec,
+            _Out_ bool* isKeyframe);
+
+        //
+        // Makes the next frame a keyframe, e.g. after a frame was dropped.
+        //
+        void RequestKeyframe();
+
+    private:
+        //
+        // Compresses the pixels into the compressed pixel buffer, after the given
+        // number of bytes. Returns the compressed size.
+        //
+        size_t CompressLossless(
+            _In_ SensorFrameStreamingCodec codec,
+            _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+            _In_ uint32_t imageHeight,
+            _In_ uint32_t rowStride,
+            _In_ size_t outputOffset);
+
+        Windows::Storage::Streams::IBuffer^ CompressDelta(
+            _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat,
+            _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+            _In_ uint32_t imageHeight,
+            _In_ uint32_t rowStride,
+            _Out_ bool* isKeyframe);
+
+        Windows::Storage::Streams::IBuffer^ CompressJpeg(
+            _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat,
+            _In_reads_(imageHeight * rowStride) const uint8_t* pixels,
+            _In_ uint32_t imageHeight,
+            _In_ uint32_t rowStride);
+
+    private:
+        const SensorFrameStreamingCodec _codec;
+        const float _jpegQuality;
+        const uint32_t _keyframeInterval;
+
+        std::mutex _mutex;
+        Io::Lz4Compressor _lz4Compressor;
+        std::vector<uint8_t> _compressedPixels;
+
+        // The previous frame, which the next delta is taken against.
+        std::vector<uint16_t> _referencePixels;
+        size_t _referenceImageSize;
+        uint32_t _referenceRowStride;
+        uint32_t _framesSinceKeyframe;
+        bool _keyframeRequested;
+    };
+
+    //
+    // Frames sent with the Delta codec start with this header. Keyframes are
+    // followed by their image, compressed with KeyframeCodec (Raw, Lz4 or
+    // Depth); other frames by the Io::DeltaCompress differences of their image
+    // to the previous frame of the sensor, in samples of BytesPerSample bytes.
+    //
+    const uint8_t SensorFrameDeltaFlagKeyframe = 0x01;
+
+#pragma pack (push, 1)
+    struct SensorFrameDeltaHeader
+    {
+        uint8_t Flags;
+        uint8_t KeyframeCodec;
+        uint8_t BytesPerSample;
+        uint8_t Reserved;
+    };
+#pragma pack (pop)
+
+    //
+    // Restores the frames of a sensor sent with the Delta codec, keeping the
+    // last one as the reference of the next. Not thread safe: frames must be
+    // decompressed in the order they were received.
+    //
+    class SensorFrameDeltaDecoder
+    {
+    public:
+        SensorFrameDeltaDecoder() = default;
+
+        SensorFrameDeltaDecoder(const SensorFrameDeltaDecoder&) = delete;
+        SensorFrameDeltaDecoder& operator=(const SensorFrameDeltaDecoder&) = delete;
+
+        //
+        // Decompresses into header->ImageHeight rows of header->RowStride bytes.
+        // Throws a FailureException if a frame doesn't follow a keyframe of the
+        // same size.
+        //
+        void Decompress(
+            _In_ SensorFrameStreamHeader^ header,
+            _In_reads_(payloadLength) const uint8_t* payload,
+            _In_ uint32_t payloadLength,
+            _Out_writes_(header->ImageHeight * header->RowStride) uint8_t* pixels);
+
+    private:
+        std::vector<uint16_t> _referencePixels;
+        uint32_t _referenceRowStride = 0;
+        uint32_t _referenceImageHeight = 0;
+    };
+
+    //
+    // Restores the pixels of a frame compressed with a lossless codec into
+    // header->ImageHeight rows of header->RowStride bytes.
+    //
+    void DecompressSensorFrame(
+        _In_ SensorFrameStreamHeader^ header,
+        _In_reads_(payloadLength) const uint8_t* payload,
+        _In_ uint32_t payloadLength,
+        _Out_writes_(header->ImageHeight * header->RowStride) uint8_t* pixels);
+
+    //
+    // Decodes a JPEG compressed frame to the given pixel format.
+    //
+    Concurrency::task<Windows::Graphics::Imaging::SoftwareBitmap^> DecodeJpegSensorFrameAsync(
+        _In_ Windows::Storage::Streams::IBuffer^ payload,
+        _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat);
+}
@@ -0,0 +1,492 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    namespace
+    {
+        const size_t MaximumPendingFrames = 8;
+        const size_t MaximumFrameLength = 64 * 1024 * 1024;
+
+        //
+        // Incomplete frames are checked against their deadline on every
+        // datagram, and on a timer for when no more datagrams come. The
+        // subscription is renewed well within the server's timeout.
+        //
+        const uint32_t TimerPeriodInMilliseconds = 10;
+        const uint32_t TimerTicksPerSubscription = 100;
+    }
+
+    SensorFrameDatagramReceiver::SensorFrameDatagramReceiver()
+        : _timerTicksSinceSubscription(0)
+        , _isReceiving(false)
+        , _framesDisplaced(0)
+        , _framesMalformed(0)
+    {
+        DeadlineInMilliseconds = 50;
+        QueueCapacity = 2;
+
+        _socket = ref new Windows::Networking::Sockets::DatagramSocket();
+
+        _socket->MessageReceived +=
+            ref new Windows::Foundation::TypedEventHandler<
+                Windows::Networking::Sockets::DatagramSocket^,
+                Windows::Networking::Sockets::DatagramSocketMessageReceivedEventArgs^>(
+                    this,
+                    &SensorFrameDatagramReceiver::OnMessageReceived);
+    }
+
+    SensorFrameDatagramReceiver::~SensorFrameDatagramReceiver()
+    {
+        if (nullptr != _timer)
+        {
+            _timer->Cancel();
+            _timer = nullptr;
+        }
+
+        delete _socket;
+        _socket = nullptr;
+    }
+
+    Windows::Foundation::IAsyncAction^ SensorFrameDatagramReceiver::ConnectAsync(
+        _In_ Windows::Networking::HostName^ hostName,
+        _In_ Platform::String^ serviceName)
+    {
+        REQUIRES(DeadlineInMilliseconds > 0 && QueueCapacity > 0);
+
+        {
+            std::lock_guard<std::mutex> lock(_reassemblerMutex);
+
+            _reassembler =
+                std::make_unique<Io::DatagramReassembler>(
+                    std::chrono::milliseconds(DeadlineInMilliseconds),
+                    MaximumPendingFrames,
+                    MaximumFrameLength);
+        }
+
+        return concurrency::create_async(
+            [this, hostName, serviceName]()
+        {
+            return concurrency::create_task(
+                _socket->ConnectAsync(
+                    hostName,
+                    serviceName)
+            ).then([this]()
+            {
+                Subscribe();
+
+                Windows::Foundation::TimeSpan period;
+
+                // In 100-nanosecond units.
+                period.Duration = TimerPeriodInMilliseconds * 10000;
+
+                _timer =
+                    Windows::System::Threading::ThreadPoolTimer::CreatePeriodicTimer(
+                        ref new Windows::System::Threading::TimerElapsedHandler(
+                            this,
+                            &SensorFrameDatagramReceiver::OnTimer),
+                        period);
+            });
+        });
+    }
+
+    Windows::Foundation::IAsyncOperation<SensorFrame^>^ SensorFrameDatagramReceiver::ReceiveAsync()
+    {
+        return concurrency::create_async(
+            [this]()
+        {
+            return ReceiveFrameAsync();
+        });
+    }
+
+    SensorFrameDatagramStatistics SensorFrameDatagramReceiver::GetStatistics()
+    {
+        Io::DatagramReassemblyStatistics reassemblyStatistics = {};
+
+        {
+            std::lock_guard<std::mutex> lock(_reassemblerMutex);
+
+            if (nullptr != _reassembler)
+            {
+                reassemblyStatistics =
+                    _reassembler->GetStatistics();
+            }
+        }
+
+        SensorFrameDatagramStatistics statistics = {};
+
+        statistics.DatagramsReceived = reassemblyStatistics.DatagramsReceived;
+        statistics.DatagramsLost = reassemblyStatistics.DatagramsLost;
+        statistics.DatagramsReordered = reassemblyStatistics.DatagramsReordered;
+        statistics.DatagramsDuplicated = reassemblyStatistics.DatagramsDuplicated;
+        statistics.DatagramsLate = reassemblyStatistics.DatagramsLate;
+        statistics.FramesReceived = reassemblyStatistics.FramesDelivered;
+        statistics.FramesDropped = reassemblyStatistics.FramesDropped;
+        statistics.FramesMalformed = _framesMalformed;
+        statistics.AverageLatencyInMilliseconds = 1e3 * reassemblyStatistics.AverageLatencyInSeconds;
+        statistics.MaximumLatencyInMilliseconds = 1e3 * reassemblyStatistics.MaximumLatencyInSeconds;
+        statistics.JitterInMilliseconds = 1e3 * reassemblyStatistics.JitterInSeconds;
+
+        {
+            std::lock_guard<std::mutex> lock(_framesMutex);
+
+            statistics.FramesDropped += _framesDisplaced;
+        }
+
+        return statistics;
+    }
+
+    void SensorFrameDatagramReceiver::OnMessageReceived(
+        Windows::Networking::Sockets::DatagramSocket^ socket,
+        Windows::Networking::Sockets::DatagramSocketMessageReceivedEventArgs^ args)
+    {
+        Windows::Storage::Streams::DataReader^ reader;
+
+        try
+        {
+            reader = args->GetDataReader();
+        }
+        catch (Platform::Exception^ exception)
+        {
+            //
+            // E.g. the server isn't running (yet): the subscription will be
+            // renewed.
+            //
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+            dbg::trace(
+                L"SensorFrameDatagramReceiver::OnMessageReceived: %s",
+                exception->Message->Data());
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+            return;
+        }
+
+        const uint32_t datagramSize =
+            reader->UnconsumedBufferLength;
+
+        std::lock_guard<std::mutex> lock(_reassemblerMutex);
+
+        if (nullptr == _reassembler)
+        {
+            return;
+        }
+
+        _datagram.resize(
+            datagramSize);
+
+        if (datagramSize > 0)
+        {
+            reader->ReadBytes(
+                Platform::ArrayReference<uint8_t>(
+                    _datagram.data(),
+                    datagramSize));
+        }
+
+        const Io::DatagramReassembler::Clock::time_point now =
+            Io::DatagramReassembler::Clock::now();
+
+        _reassembler->AddDatagram(
+            _datagram.data(),
+            _datagram.size(),
+            now);
+
+        TakeFrames(
+            now);
+    }
+
+    void SensorFrameDatagramReceiver::OnTimer(
+        Windows::System::Threading::ThreadPoolTimer^ timer)
+    {
+        bool subscribe = false;
+
+        {
+            std::lock_guard<std::mutex> lock(_reassemblerMutex);
+
+            TakeFrames(
+                Io::DatagramReassembler::Clock::now());
+
+            if (++_timerTicksSinceSubscription >= TimerTicksPerSubscription)
+            {
+                _timerTicksSinceSubscription = 0;
+
+                subscribe = true;
+            }
+        }
+
+        if (subscribe)
+        {
+            Subscribe();
+        }
+    }
+
+    void SensorFrameDatagramReceiver::Subscribe()
+    {
+        Windows::Storage::Streams::Buffer^ subscription =
+            ref new Windows::Storage::Streams::Buffer(
+                sizeof(Io::DatagramSubscribeCookie));
+
+        memcpy(
+            Io::GetTypedPointerToIBuffer<uint8_t>(subscription),
+            &Io::DatagramSubscribeCookie,
+            sizeof(Io::DatagramSubscribeCookie));
+
+        subscription->Length =
+            sizeof(Io::DatagramSubscribeCookie);
+
+        Concurrency::create_task(_socket->OutputStream->WriteAsync(subscription)).then(
+            [](Concurrency::task<unsigned int> writeTask)
+        {
+            try
+            {
+                // Try getting an exception.
+                writeTask.get();
+            }
+            catch (Platform::Exception^ exception)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameDatagramReceiver::Subscribe: WriteAsync call failed with error: %s",
+                    exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+            }
+        });
+    }
+
+    void SensorFrameDatagramReceiver::TakeFrames(
+        _In_ const Io::DatagramReassembler::Clock::time_point now)
+    {
+        while (_reassembler->TryGetFrame(now, &_frame))
+        {
+            Windows::Storage::Streams::Buffer^ frame =
+                ref new Windows::Storage::Streams::Buffer(
+                    static_cast<uint32_t>(_frame.size()));
+
+            if (!_frame.empty())
+            {
+                memcpy(
+                    Io::GetTypedPointerToIBuffer<uint8_t>(frame),
+                    _frame.data(),
+                    _frame.size());
+            }
+
+            frame->Length =
+                static_cast<uint32_t>(_frame.size());
+
+            Concurrency::task_completion_event<void> frameAvailable;
+            bool isReceiving = false;
+
+            {
+                std::lock_guard<std::mutex> lock(_framesMutex);
+
+                _frames.push_back(
+                    frame);
+
+                while (_frames.size() > QueueCapacity)
+                {
+                    _frames.pop_front();
+
+                    ++_framesDisplaced;
+                }
+
+                isReceiving = _isReceiving;
+
+                if (isReceiving)
+                {
+                    frameAvailable = _frameAvailable;
+                    _isReceiving = false;
+                }
+            }
+
+            if (isReceiving)
+            {
+                frameAvailable.set();
+            }
+        }
+    }
+
+    Concurrency::task<SensorFrame^> SensorFrameDatagramReceiver::ReceiveFrameAsync()
+    {
+        Windows::Storage::Streams::IBuffer^ frame;
+        Concurrency::task_completion_event<void> frameAvailable;
+
+        {
+            std::lock_guard<std::mutex> lock(_framesMutex);
+
+            if (!_frames.empty())
+            {
+                frame = _frames.front();
+
+                _frames.pop_front();
+            }
+            else
+            {
+                _frameAvailable = Concurrency::task_completion_event<void>();
+                _isReceiving = true;
+
+                frameAvailable = _frameAvailable;
+            }
+        }
+
+        if (nullptr == frame)
+        {
+            return concurrency::create_task(
+                frameAvailable
+            ).then([this]()
+            {
+                return ReceiveFrameAsync();
+            });
+        }
+
+        //
+        // A frame that doesn't deserialize only costs that frame.
+        //
+        return concurrency::create_task(
+            [this, frame]()
+        {
+            return DeserializeFrameAsync(
+                frame);
+        }).then([this](concurrency::task<SensorFrame^> sensorFrameTask)
+        {
+            try
+            {
+                return concurrency::task_from_result(
+                    sensorFrameTask.get());
+            }
+            catch (Platform::FailureException^)
+            {
+                ++_framesMalformed;
+            }
+
+            return ReceiveFrameAsync();
+        });
+    }
+
+    Concurrency::task<SensorFrame^> SensorFrameDatagramReceiver::DeserializeFrameAsync(
+        _In_ Windows::Storage::Streams::IBuffer^ frame)
+    {
+        Windows::Storage::Streams::DataReader^ reader =
+            Windows::Storage::Streams::DataReader::FromBuffer(
+                frame);
+
+        reader->ByteOrder =
+            Windows::Storage::Streams::ByteOrder::LittleEndian;
+
+        if (reader->UnconsumedBufferLength < SensorFrameStreamHeader::ProtocolHeaderLength)
+        {
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"SensorFrameDatagramReceiver::ReceiveAsync: frame of %u bytes is too short for a SensorFrameStreamHeader",
+                frame->Length);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        SensorFrameStreamHeader^ header;
+
+        SensorFrameStreamHeader::Read(
+            reader,
+            &header);
+
+        if (SensorFrameStreamHeader::ProtocolCookie != header->Cookie ||
+            SensorFrameStreamHeader::ProtocolVersionMajor != header->VersionMajor ||
+            SensorFrameStreamHeader::ProtocolVersionMinorWithoutExtensions > header->VersionMinor ||
+            SensorFrameStreamHeader::ProtocolVersionMinor < header->VersionMinor ||
+            reader->UnconsumedBufferLength < SensorFrameStreamHeader::GetProtocolExtendedHeaderLength(header->VersionMinor))
+        {
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"SensorFrameDatagramReceiver::ReceiveAsync: malformed header (ProtocolCookie/ProtocolVersionMajor/ProtocolVersionMinor of 0x%08x/0x%02x/0x%02x)",
+                header->Cookie,
+                header->VersionMajor,
+                header->VersionMinor);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        SensorFrameStreamHeader::ReadExtendedFields(
+            reader,
+            header);
+
+        if (header->ExtensionsLength > Io::FrameHeaderExtensionsMaximumLength ||
+            !IsPayloadLengthValid(header) ||
+            reader->UnconsumedBufferLength != static_cast<uint64_t>(header->ExtensionsLength) + header->PayloadLength)
+        {
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"SensorFrameDatagramReceiver::ReceiveAsync: malformed extended header (%u bytes of extensions, %u bytes of payload in a frame of %u bytes)",
+                header->ExtensionsLength,
+                header->PayloadLength,
+                frame->Length);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        std::shared_ptr<Io::FrameHeaderExtensions> extensions;
+
+        if (header->HasExtensions)
+        {
+            std::vector<uint8_t> extensionBlock(
+                header->ExtensionsLength);
+
+            if (!extensionBlock.empty())
+            {
+                reader->ReadBytes(
+                    Platform::ArrayReference<uint8_t>(
+                        extensionBlock.data(),
+                        header->ExtensionsLength));
+            }
+
+            extensions = std::make_shared<Io::FrameHeaderExtensions>();
+
+            if (!Io::DecodeFrameHeaderExtensions(
+                    extensionBlock.data(),
+                    extensionBlock.size(),
+                    *extensions))
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameDatagramReceiver::ReceiveAsync: malformed header extensions");
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+        }
+
+        Windows::Storage::Streams::IBuffer^ payload =
+            reader->ReadBuffer(
+                header->PayloadLength);
+
+        //
+        // Frames are independent of each other: the server doesn't use the
+        // Delta codec over datagrams.
+        //
+        return DeserializeSensorFrameAsync(
+            header,
+            payload,
+            extensions.get()
+        ).then([this, extensions](SensorFrame^ sensorFrame)
+        {
+            if (nullptr != extensions)
+            {
+                _extensionsDecoder.Apply(
+                    *extensions,
+                    sensorFrame);
+            }
+
+            return sensorFrame;
+        });
+    }
+}
@@ -0,0 +1,123 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Counters of a datagram receiver (see Io::DatagramReassemblyStatistics).
+    //
+    public value struct SensorFrameDatagramStatistics
+    {
+        uint64_t DatagramsReceived;
+        uint64_t DatagramsLost;
+        uint64_t DatagramsReordered;
+        uint64_t DatagramsDuplicated;
+        uint64_t DatagramsLate;
+
+        uint64_t FramesReceived;
+
+        // Incomplete by their deadline, or not picked up by ReceiveAsync before
+        // later frames displaced them.
+        uint64_t FramesDropped;
+
+        // Frames that were complete, but could not be deserialized.
+        uint64_t FramesMalformed;
+
+        // From the first datagram of a frame to its reassembly.
+        double AverageLatencyInMilliseconds;
+        double MaximumLatencyInMilliseconds;
+
+        double JitterInMilliseconds;
+    };
+
+    //
+    // Receives the frames of a SensorFrameDatagramStreamingServer. Frames are
+    // reassembled from their datagrams as they arrive; a frame that misses a
+    // datagram is dropped once its deadline has passed, and ReceiveAsync moves
+    // on to the next one.
+    //
+    public ref class SensorFrameDatagramReceiver sealed
+    {
+    public:
+        SensorFrameDatagramReceiver();
+
+        //
+        // Subscribes to the stream of the server, and keeps the subscription
+        // alive until the receiver is destroyed.
+        //
+        Windows::Foundation::IAsyncAction^ ConnectAsync(
+            _In_ Windows::Networking::HostName^ hostName,
+            _In_ Platform::String^ serviceName);
+
+        Windows::Foundation::IAsyncOperation<SensorFrame^>^ ReceiveAsync();
+
+        //
+        // How long to wait for the missing datagrams of a frame, from the arrival
+        // of its first datagram. Defaults to 50 milliseconds; must be set before
+        // connecting.
+        //
+        property uint32_t DeadlineInMilliseconds;
+
+        //
+        // Number of reassembled frames kept for ReceiveAsync; older frames are
+        // dropped when the application falls behind. Defaults to 2.
+        //
+        property uint32_t QueueCapacity;
+
+        SensorFrameDatagramStatistics GetStatistics();
+
+    private:
+        ~SensorFrameDatagramReceiver();
+
+        void OnMessageReceived(
+            Windows::Networking::Sockets::DatagramSocket^ socket,
+            Windows::Networking::Sockets::DatagramSocketMessageReceivedEventArgs^ args);
+
+        void OnTimer(
+            Windows::System::Threading::ThreadPoolTimer^ timer);
+
+        void Subscribe();
+
+        //
+        // Moves the frames the reassembler is done with to the receive queue.
+        // Must be called with the reassembler mutex held.
+        //
+        void TakeFrames(
+            _In_ const Io::DatagramReassembler::Clock::time_point now);
+
+        Concurrency::task<SensorFrame^> ReceiveFrameAsync();
+
+        Concurrency::task<SensorFrame^> DeserializeFrameAsync(
+            _In_ Windows::Storage::Streams::IBuffer^ frame);
+
+    private:
+        Windows::Networking::Sockets::DatagramSocket^ _socket;
+        Windows::System::Threading::ThreadPoolTimer^ _timer;
+
+        std::mutex _reassemblerMutex;
+        std::unique_ptr<Io::DatagramReassembler> _reassembler;
+        std::vector<uint8_t> _datagram;
+        std::vector<uint8_t> _frame;
+        uint32_t _timerTicksSinceSubscription;
+
+        // Reassembled frames, and the ReceiveAsync call waiting for one.
+        std::mutex _framesMutex;
+        std::deque<Windows::Storage::Streams::IBuffer^> _frames;
+        bool _isReceiving;
+        Concurrency::task_completion_event<void> _frameAvailable;
+        uint64_t _framesDisplaced;
+        std::atomic<uint64_t> _framesMalformed;
+
+        SensorFrameExtensionsDecoder _extensionsDecoder;
+    };
+}
@@ -0,0 +1,328 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    SensorFrameDatagramStreamingServer::SensorFrameDatagramStreamingServer(
+        _In_ Platform::String^ serviceName)
+    {
+        MaximumDatagramSize = (uint32_t)Io::DatagramDefaultMaximumSize;
+        MaximumDatagramsInFlight = 1024;
+        ExtensionsEnabled = false;
+        Codec = SensorFrameStreamingCodec::Raw;
+        JpegQuality = 0.9f;
+
+        _socket = ref new Windows::Networking::Sockets::DatagramSocket();
+
+        _socket->MessageReceived +=
+            ref new Windows::Foundation::TypedEventHandler<
+                Windows::Networking::Sockets::DatagramSocket^,
+                Windows::Networking::Sockets::DatagramSocketMessageReceivedEventArgs^>(
+                    this,
+                    &SensorFrameDatagramStreamingServer::OnMessageReceived);
+
+        // Don't limit traffic to an address or an adapter.
+        Concurrency::create_task(_socket->BindServiceNameAsync(serviceName)).then(
+            [this](Concurrency::task<void> previousTask)
+        {
+            try
+            {
+                // Try getting an exception.
+                previousTask.get();
+            }
+            catch (Platform::Exception^ exception)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameDatagramStreamingServer::SensorFrameDatagramStreamingServer: %s",
+                    exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+            }
+        });
+    }
+
+    SensorFrameDatagramStreamingServer::~SensorFrameDatagramStreamingServer()
+    {
+        delete _socket;
+        _socket = nullptr;
+    }
+
+    void SensorFrameDatagramStreamingServer::OnMessageReceived(
+        Windows::Networking::Sockets::DatagramSocket^ socket,
+        Windows::Networking::Sockets::DatagramSocketMessageReceivedEventArgs^ args)
+    {
+        Windows::Storage::Streams::DataReader^ reader =
+            args->GetDataReader();
+
+        reader->ByteOrder =
+            Windows::Storage::Streams::ByteOrder::LittleEndian;
+
+        if (reader->UnconsumedBufferLength < sizeof(uint32_t) ||
+            Io::DatagramSubscribeCookie != reader->ReadUInt32())
+        {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+            dbg::trace(
+                L"SensorFrameDatagramStreamingServer::OnMessageReceived: ignoring a datagram that is not a subscription");
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+            return;
+        }
+
+        Platform::String^ remoteEndpoint =
+            args->RemoteAddress->CanonicalName + L":" + args->RemotePort;
+
+        const int64_t now =
+            std::chrono::steady_clock::now().time_since_epoch().count();
+
+        {
+            std::lock_guard<std::mutex> lock(_subscriptionMutex);
+
+            if (nullptr != _subscription &&
+                _subscription->RemoteEndpoint == remoteEndpoint)
+            {
+                _subscription->LastSubscriptionTime = now;
+
+                return;
+            }
+        }
+
+        REQUIRES(MaximumDatagramSize > sizeof(Io::DatagramHeader) && MaximumDatagramsInFlight > 0);
+
+        auto subscription =
+            std::make_shared<Subscription>(
+                MaximumDatagramSize);
+
+        subscription->RemoteEndpoint = remoteEndpoint;
+        subscription->ExtensionsEnabled = ExtensionsEnabled;
+        subscription->MaximumDatagramsInFlight = MaximumDatagramsInFlight;
+
+        //
+        // Delta compressed frames can't be decoded once a frame they depend on
+        // is lost.
+        //
+        const SensorFrameStreamingCodec codec =
+            SensorFrameStreamingCodec::Delta == Codec
+                ? SensorFrameStreamingCodec::Depth
+                : Codec;
+
+        if (SensorFrameStreamingCodec::Raw != codec)
+        {
+            subscription->Compressor =
+                std::make_unique<SensorFrameCompressor>(
+                    codec,
+                    JpegQuality,
+                    1 /* keyframeInterval */);
+        }
+
+        Concurrency::create_task(socket->GetOutputStreamAsync(args->RemoteAddress, args->RemotePort)).then(
+            [this, subscription](Concurrency::task<Windows::Storage::Streams::IOutputStream^> outputStreamTask)
+        {
+            try
+            {
+                subscription->OutputStream =
+                    outputStreamTask.get();
+            }
+            catch (Platform::Exception^ exception)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameDatagramStreamingServer::OnMessageReceived: GetOutputStreamAsync call failed with error: %s",
+                    exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(_subscriptionMutex);
+
+            _subscription = subscription;
+        });
+    }
+
+    SensorFrameStreamingStatistics SensorFrameDatagramStreamingServer::GetStatistics()
+    {
+        std::shared_ptr<Subscription> subscription;
+
+        {
+            std::lock_guard<std::mutex> lock(_subscriptionMutex);
+
+            subscription = _subscription;
+        }
+
+        SensorFrameStreamingStatistics statistics = {};
+
+        if (nullptr == subscription)
+        {
+            return statistics;
+        }
+
+        statistics.FramesSent = subscription->FramesSent;
+        statistics.FramesDropped = subscription->FramesDropped;
+        statistics.BytesSent = subscription->BytesSent;
+
+        const double elapsedTimeInSeconds =
+            std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - subscription->StartTime).count();
+
+        if (elapsedTimeInSeconds > 0.0)
+        {
+            statistics.BytesPerSecond =
+                statistics.BytesSent / elapsedTimeInSeconds;
+        }
+
+        return statistics;
+    }
+
+    void SensorFrameDatagramStreamingServer::Send(
+        SensorFrame^ sensorFrame)
+    {
+        std::shared_ptr<Subscription> subscription;
+
+        {
+            std::lock_guard<std::mutex> lock(_subscriptionMutex);
+
+            subscription = _subscription;
+        }
+
+        const std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+
+        if (nullptr == subscription ||
+            now.time_since_epoch() - std::chrono::steady_clock::duration(subscription->LastSubscriptionTime) >
+                std::chrono::seconds(SubscriptionTimeoutInSeconds))
+        {
+#if DBG_ENABLE_VERBOSE_LOGGING
+            dbg::trace(
+                L"SensorFrameDatagramStreamingServer::Send: image dropped -- no subscriber!");
+#endif /* DBG_ENABLE_VERBOSE_LOGGING */
+
+            return;
+        }
+
+        //
+        // Rather than queueing datagrams behind the ones the network stack has
+        // yet to send, drop the frame.
+        //
+        if (subscription->DatagramsInFlight >= subscription->MaximumDatagramsInFlight)
+        {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+            dbg::trace(
+                L"SensorFrameDatagramStreamingServer::Send: image dropped -- too many datagrams in flight!");
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+            ++subscription->FramesDropped;
+
+            return;
+        }
+
+        std::lock_guard<std::mutex> sendLock(subscription->SendMutex);
+
+        Windows::Storage::Streams::IBuffer^ frame;
+
+        if (subscription->ExtensionsEnabled)
+        {
+            std::vector<uint8_t> extensionBlock;
+
+            const bool includeUnprojectionLut =
+                0 == subscription->FramesSinceUnprojectionLut;
+
+            if (_extensionsEncoder.Encode(
+                    sensorFrame,
+                    includeUnprojectionLut,
+                    extensionBlock) ||
+                !includeUnprojectionLut)
+            {
+                subscription->FramesSinceUnprojectionLut =
+                    (subscription->FramesSinceUnprojectionLut + 1) % UnprojectionLutInterval;
+            }
+
+            frame =
+                SerializeSensorFrame(
+                    sensorFrame,
+                    &extensionBlock,
+                    subscription->Compressor.get());
+        }
+        else
+        {
+            frame =
+                SerializeSensorFrame(
+                    sensorFrame,
+                    nullptr /* extensionBlock */,
+                    subscription->Compressor.get());
+        }
+
+        const uint64_t sendTimeInMicroseconds =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                now.time_since_epoch()).count();
+
+        subscription->Fragmenter.Fragment(
+            Io::GetTypedPointerToIBuffer<uint8_t>(frame),
+            frame->Length,
+            sendTimeInMicroseconds,
+            [this, &subscription](const uint8_t* datagram, size_t size)
+        {
+            SendDatagram(
+                subscription,
+                datagram,
+                size);
+        });
+
+        ++subscription->FramesSent;
+    }
+
+    void SensorFrameDatagramStreamingServer::SendDatagram(
+        _In_ const std::shared_ptr<Subscription>& subscription,
+        _In_reads_(size) const uint8_t* datagram,
+        _In_ const size_t size)
+    {
+        Windows::Storage::Streams::Buffer^ buffer =
+            ref new Windows::Storage::Streams::Buffer(
+                static_cast<uint32_t>(size));
+
+        memcpy(
+            Io::GetTypedPointerToIBuffer<uint8_t>(buffer),
+            datagram,
+            size);
+
+        buffer->Length =
+            static_cast<uint32_t>(size);
+
+        ++subscription->DatagramsInFlight;
+
+        //
+        // Each write sends a datagram. Writes are started in sequence, which is
+        // all a datagram stream can promise anyway.
+        //
+        Concurrency::create_task(subscription->OutputStream->WriteAsync(buffer)).then(
+            [subscription, size](Concurrency::task<unsigned int> writeTask)
+        {
+            --subscription->DatagramsInFlight;
+
+            try
+            {
+                // Try getting an exception.
+                writeTask.get();
+
+                subscription->BytesSent += size;
+            }
+            catch (Platform::Exception^ exception)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameDatagramStreamingServer::SendDatagram: WriteAsync call failed with error: %s",
+                    exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+            }
+        });
+    }
+}
@@ -0,0 +1,138 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Streams the frames of a sensor over UDP, for clients that would rather lose
+    // a frame than wait for it to be retransmitted. Serialized frames are split
+    // into datagrams (see Io/DatagramFraming.h) that are sent as soon as the
+    // frame is captured; there is no send queue to wait in.
+    //
+    // Clients subscribe by sending DatagramSubscribeCookie datagrams to the
+    // service, at least every SubscriptionTimeoutInSeconds; the frames go to the
+    // client that last subscribed. Use a SensorFrameDatagramReceiver on the
+    // client side. The SensorFrameStreamingServer remains the default transport.
+    //
+    public ref class SensorFrameDatagramStreamingServer sealed
+        : public ISensorFrameSink
+    {
+    public:
+        SensorFrameDatagramStreamingServer(
+            _In_ Platform::String^ serviceName);
+
+        virtual void Send(
+            SensorFrame^ sensorFrame);
+
+        static property uint32_t SubscriptionTimeoutInSeconds
+        {
+            uint32_t get() { return 5; }
+        }
+
+        //
+        // Size of the datagrams, headers included, and number of datagrams
+        // being sent at the same time past which frames are dropped. Takes
+        // effect with the next subscription.
+        //
+        property uint32_t MaximumDatagramSize;
+        property uint32_t MaximumDatagramsInFlight;
+
+        //
+        // Sends version 0.2 headers, with the pose and intrinsics of the frames.
+        // As the frame carrying an unprojection LUT may be lost, the LUT is sent
+        // again every UnprojectionLutInterval frames. Takes effect with the next
+        // subscription.
+        //
+        property bool ExtensionsEnabled;
+
+        static property uint32_t UnprojectionLutInterval
+        {
+            uint32_t get() { return 30; }
+        }
+
+        //
+        // Compression of the frames (version 0.3 headers), and the quality of the
+        // JPEG codec between 0 and 1. Each frame must be decodable on its own:
+        // the Delta codec falls back to the Depth codec. Takes effect with the
+        // next subscription.
+        //
+        property SensorFrameStreamingCodec Codec;
+        property float JpegQuality;
+
+        //
+        // Frames are only queued by the network stack, so the queue latencies
+        // are zero; frames dropped for lack of a subscriber are not counted.
+        //
+        SensorFrameStreamingStatistics GetStatistics();
+
+    private:
+        ~SensorFrameDatagramStreamingServer();
+
+        struct Subscription
+        {
+            Platform::String^ RemoteEndpoint;
+            Windows::Storage::Streams::IOutputStream^ OutputStream;
+
+            // Of the last subscribe datagram, in steady clock ticks.
+            std::atomic<int64_t> LastSubscriptionTime;
+
+            // Keeps the datagrams of a frame together and in sequence.
+            std::mutex SendMutex;
+            Io::DatagramFragmenter Fragmenter;
+            std::unique_ptr<SensorFrameCompressor> Compressor;
+            bool ExtensionsEnabled;
+            uint32_t FramesSinceUnprojectionLut;
+
+            std::atomic<uint32_t> DatagramsInFlight;
+            uint32_t MaximumDatagramsInFlight;
+
+            std::atomic<uint64_t> FramesSent;
+            std::atomic<uint64_t> FramesDropped;
+            std::atomic<uint64_t> BytesSent;
+            std::chrono::steady_clock::time_point StartTime;
+
+            Subscription(
+                _In_ const size_t maximumDatagramSize)
+                : Fragmenter(maximumDatagramSize)
+                , ExtensionsEnabled(false)
+                , FramesSinceUnprojectionLut(0)
+                , DatagramsInFlight(0)
+                , MaximumDatagramsInFlight(0)
+                , FramesSent(0)
+                , FramesDropped(0)
+                , BytesSent(0)
+                , StartTime(std::chrono::steady_clock::now())
+            {
+                LastSubscriptionTime =
+                    StartTime.time_since_epoch().count();
+            }
+        };
+
+        void OnMessageReceived(
+            Windows::Networking::Sockets::DatagramSocket^ socket,
+            Windows::Networking::Sockets::DatagramSocketMessageReceivedEventArgs^ args);
+
+        void SendDatagram(
+            _In_ const std::shared_ptr<Subscription>& subscription,
+            _In_reads_(size) const uint8_t* datagram,
+            _In_ const size_t size);
+
+    private:
+        Windows::Networking::Sockets::DatagramSocket^ _socket;
+
+        std::mutex _subscriptionMutex;
+        std::shared_ptr<Subscription> _subscription;
+
+        SensorFrameExtensionsEncoder _extensionsEncoder;
+    };
+}
@@ -0,0 +1,220 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    namespace
+    {
+        void ToRowMajor(
+            _In_ const Windows::Foundation::Numerics::float4x4& matrix,
+            _Out_writes_(16) float* rowMajor)
+        {
+            static_assert(
+                sizeof(matrix) == 16 * sizeof(float),
+                "float4x4 is expected to be 16 tightly packed floats");
+
+            memcpy(rowMajor, &matrix, sizeof(matrix));
+        }
+
+        Windows::Foundation::Numerics::float4x4 FromRowMajor(
+            _In_reads_(16) const float* rowMajor)
+        {
+            Windows::Foundation::Numerics::float4x4 matrix;
+
+            memcpy(&matrix, rowMajor, sizeof(matrix));
+
+            return matrix;
+        }
+    }
+
+    bool SensorFrameExtensionsEncoder::Encode(
+        _In_ SensorFrame^ sensorFrame,
+        _In_ bool includeUnprojectionLut,
+        _Out_ std::vector<uint8_t>& extensionBlock)
+    {
+        Io::FrameHeaderExtensions extensions;
+
+        extensions.HasTransforms = true;
+
+        ToRowMajor(
+            sensorFrame->FrameToOrigin,
+            extensions.Transforms.FrameToOrigin);
+
+        ToRowMajor(
+            sensorFrame->CameraViewTransform,
+            extensions.Transforms.CameraViewTransform);
+
+        ToRowMajor(
+            sensorFrame->CameraProjectionTransform,
+            extensions.Transforms.CameraProjectionTransform);
+
+        extensions.HasPixelFormat = true;
+        extensions.PixelFormat = (uint32_t)GetStreamingPixelFormat(sensorFrame);
+
+        Windows::Media::Devices::Core::CameraIntrinsics^ coreCameraIntrinsics =
+            sensorFrame->CoreCameraIntrinsics;
+
+        if (nullptr != coreCameraIntrinsics)
+        {
+            extensions.HasPinholeIntrinsics = true;
+
+            extensions.Pinhole.FocalLength[0] = coreCameraIntrinsics->FocalLength.x;
+            extensions.Pinhole.FocalLength[1] = coreCameraIntrinsics->FocalLength.y;
+            extensions.Pinhole.PrincipalPoint[0] = coreCameraIntrinsics->PrincipalPoint.x;
+            extensions.Pinhole.PrincipalPoint[1] = coreCameraIntrinsics->PrincipalPoint.y;
+            extensions.Pinhole.RadialDistortion[0] = coreCameraIntrinsics->RadialDistortion.x;
+            extensions.Pinhole.RadialDistortion[1] = coreCameraIntrinsics->RadialDistortion.y;
+            extensions.Pinhole.RadialDistortion[2] = coreCameraIntrinsics->RadialDistortion.z;
+            extensions.Pinhole.TangentialDistortion[0] = coreCameraIntrinsics->TangentialDistortion.x;
+            extensions.Pinhole.TangentialDistortion[1] = coreCameraIntrinsics->TangentialDistortion.y;
+            extensions.Pinhole.ImageWidth = coreCameraIntrinsics->ImageWidth;
+            extensions.Pinhole.ImageHeight = coreCameraIntrinsics->ImageHeight;
+        }
+
+        bool includesUnprojectionLut = false;
+
+        if (nullptr != sensorFrame->SensorStreamingCameraIntrinsics)
+        {
+            const CachedUnprojectionLut unprojectionLut =
+                GetUnprojectionLut(
+                    sensorFrame);
+
+            extensions.HasUnprojectionLutReference = true;
+            extensions.UnprojectionLutReference.Hash = unprojectionLut.Hash;
+            extensions.UnprojectionLutReference.ImageWidth = unprojectionLut.Lut->GetImageWidth();
+            extensions.UnprojectionLutReference.ImageHeight = unprojectionLut.Lut->GetImageHeight();
+
+            if (includeUnprojectionLut)
+            {
+                extensions.UnprojectionLut = unprojectionLut.Lut;
+
+                includesUnprojectionLut = true;
+            }
+        }
+
+        Io::EncodeFrameHeaderExtensions(
+            extensions,
+            extensionBlock);
+
+        return includesUnprojectionLut;
+    }
+
+    SensorFrameExtensionsEncoder::CachedUnprojectionLut SensorFrameExtensionsEncoder::GetUnprojectionLut(
+        _In_ SensorFrame^ sensorFrame)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorFrame->FrameType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_unprojectionLuts.size());
+
+        std::lock_guard<std::mutex> lock(_unprojectionLutsMutex);
+
+        CachedUnprojectionLut& unprojectionLut =
+            _unprojectionLuts[sensorTypeAsIndex];
+
+        //
+        // The intrinsics of a sensor do not change; only compute its LUT once.
+        //
+        if (nullptr == unprojectionLut.Lut)
+        {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+            dbg::TimerGuard timerGuard(
+                L"SensorFrameExtensionsEncoder::GetUnprojectionLut: LUT creation",
+                4.0 /* minimum_time_elapsed_in_milliseconds */);
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+            unprojectionLut.Lut =
+                sensorFrame->SensorStreamingCameraIntrinsics->CreateUnprojectionLut();
+
+            unprojectionLut.Hash =
+                Io::HashUnprojectionLut(
+                    *unprojectionLut.Lut);
+        }
+
+        return unprojectionLut;
+    }
+
+    void SensorFrameExtensionsDecoder::Apply(
+        _In_ const Io::FrameHeaderExtensions& extensions,
+        _Inout_ SensorFrame^ sensorFrame)
+    {
+        if (extensions.HasTransforms)
+        {
+            sensorFrame->FrameToOrigin =
+                FromRowMajor(extensions.Transforms.FrameToOrigin);
+
+            sensorFrame->CameraViewTransform =
+                FromRowMajor(extensions.Transforms.CameraViewTransform);
+
+            sensorFrame->CameraProjectionTransform =
+                FromRowMajor(extensions.Transforms.CameraProjectionTransform);
+        }
+
+        if (extensions.HasPinholeIntrinsics)
+        {
+            const Io::PinholeIntrinsics& pinhole =
+                extensions.Pinhole;
+
+            sensorFrame->CoreCameraIntrinsics =
+                ref new Windows::Media::Devices::Core::CameraIntrinsics(
+                    Windows::Foundation::Numerics::float2(
+                        pinhole.FocalLength[0],
+                        pinhole.FocalLength[1]),
+                    Windows::Foundation::Numerics::float2(
+                        pinhole.PrincipalPoint[0],
+                        pinhole.PrincipalPoint[1]),
+                    Windows::Foundation::Numerics::float3(
+                        pinhole.RadialDistortion[0],
+                        pinhole.RadialDistortion[1],
+                        pinhole.RadialDistortion[2]),
+                    Windows::Foundation::Numerics::float2(
+                        pinhole.TangentialDistortion[0],
+                        pinhole.TangentialDistortion[1]),
+                    pinhole.ImageWidth,
+                    pinhole.ImageHeight);
+        }
+
+        if (extensions.HasUnprojectionLutReference)
+        {
+            const uint64_t hash =
+                extensions.UnprojectionLutReference.Hash;
+
+            if (nullptr != extensions.UnprojectionLut)
+            {
+                _sensorStreamingCameraIntrinsics[hash] =
+                    ref new CameraIntrinsics(
+                        extensions.UnprojectionLut);
+            }
+
+            const auto cameraIntrinsics =
+                _sensorStreamingCameraIntrinsics.find(hash);
+
+            if (cameraIntrinsics != _sensorStreamingCameraIntrinsics.end())
+            {
+                sensorFrame->SensorStreamingCameraIntrinsics =
+                    cameraIntrinsics->second;
+            }
+            else
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameExtensionsDecoder::Apply: unknown unprojection LUT 0x%016llx",
+                    hash);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+            }
+        }
+    }
+}
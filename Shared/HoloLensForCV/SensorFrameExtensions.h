@@ -0,0 +1,65 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Builds the header extensions of streamed frames (see
+    // Io/FrameHeaderExtensions.h). The unprojection LUTs of the sensors are
+    // computed once, on their first frame, and shared by all connections.
+    //
+    class SensorFrameExtensionsEncoder
+    {
+    public:
+        //
+        // Encodes the pose, pixel format and intrinsics of a frame. A frame with
+        // an unprojection LUT only carries it when includeUnprojectionLut is set,
+        // and refers to it by its hash otherwise. Returns whether the LUT was
+        // included.
+        //
+        bool Encode(
+            _In_ SensorFrame^ sensorFrame,
+            _In_ bool includeUnprojectionLut,
+            _Out_ std::vector<uint8_t>& extensionBlock);
+
+    private:
+        struct CachedUnprojectionLut
+        {
+            std::shared_ptr<const Io::UnprojectionLut> Lut;
+            uint64_t Hash;
+        };
+
+        CachedUnprojectionLut GetUnprojectionLut(
+            _In_ SensorFrame^ sensorFrame);
+
+    private:
+        std::mutex _unprojectionLutsMutex;
+        std::array<CachedUnprojectionLut, (size_t)SensorType::NumberOfSensorTypes> _unprojectionLuts;
+    };
+
+    //
+    // Applies received header extensions to the frames of a connection, keeping
+    // track of the unprojection LUTs sent with earlier frames.
+    //
+    class SensorFrameExtensionsDecoder
+    {
+    public:
+        void Apply(
+            _In_ const Io::FrameHeaderExtensions& extensions,
+            _Inout_ SensorFrame^ sensorFrame);
+
+    private:
+        std::map<uint64_t, CameraIntrinsics^> _sensorStreamingCameraIntrinsics;
+    };
+}
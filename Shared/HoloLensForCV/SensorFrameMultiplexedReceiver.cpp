@@ -0,0 +1,322 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    SensorFrameMultiplexedReceiver::SensorFrameMultiplexedReceiver(
+        _In_ Windows::Networking::Sockets::StreamSocket^ streamSocket)
+        : _streamSocket(streamSocket)
+    {
+        _reader = ref new Windows::Storage::Streams::DataReader(
+            _streamSocket->InputStream);
+
+        _reader->ByteOrder =
+            Windows::Storage::Streams::ByteOrder::LittleEndian;
+    }
+
+    Windows::Foundation::IAsyncOperation<SensorFrame^>^ SensorFrameMultiplexedReceiver::ReceiveAsync()
+    {
+        return concurrency::create_async(
+            [this]()
+        {
+            return ReceiveChunksAsync();
+        });
+    }
+
+    Concurrency::task<SensorFrame^> SensorFrameMultiplexedReceiver::ReceiveChunksAsync()
+    {
+        return concurrency::create_task(
+            _reader->LoadAsync(
+                MultiplexedChunkHeaderLength)
+        ).then([this](concurrency::task<unsigned int> chunkHeaderBytesLoadedTaskResult)
+        {
+            const size_t chunkHeaderBytesLoaded = chunkHeaderBytesLoadedTaskResult.get();
+
+            if (MultiplexedChunkHeaderLength != chunkHeaderBytesLoaded)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameMultiplexedReceiver::ReceiveAsync: expected chunk header of %i bytes, got %i bytes",
+                    MultiplexedChunkHeaderLength,
+                    chunkHeaderBytesLoaded);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            const SensorType frameType = (SensorType)_reader->ReadUInt16();
+            const uint16_t flags = _reader->ReadUInt16();
+            const uint32_t chunkLength = _reader->ReadUInt32();
+
+            if ((int32_t)frameType < 0 ||
+                (int32_t)frameType >= (int32_t)SensorType::NumberOfSensorTypes ||
+                chunkLength > MultiplexedChunkMaximumLength)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameMultiplexedReceiver::ReceiveAsync: malformed chunk header (sensor type %i, %u bytes)",
+                    frameType,
+                    chunkLength);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            return ReceiveChunkAsync(
+                frameType,
+                0 != (flags & MultiplexedChunkFlagLast),
+                chunkLength);
+        });
+    }
+
+    Concurrency::task<SensorFrame^> SensorFrameMultiplexedReceiver::ReceiveChunkAsync(
+        _In_ SensorType frameType,
+        _In_ bool isLastChunk,
+        _In_ uint32_t chunkLength)
+    {
+        return concurrency::create_task(
+            _reader->LoadAsync(
+                chunkLength)
+        ).then([this, frameType, isLastChunk, chunkLength](concurrency::task<unsigned int> chunkBytesLoadedTaskResult)
+        {
+            const size_t chunkBytesLoaded = chunkBytesLoadedTaskResult.get();
+
+            if (chunkLength != chunkBytesLoaded)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameMultiplexedReceiver::ReceiveAsync: expected chunk of %i bytes, got %i bytes",
+                    chunkLength,
+                    chunkBytesLoaded);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            PartialFrame& partialFrame =
+                _partialFrames[(int32_t)frameType];
+
+            uint32_t bytesToRead = chunkLength;
+
+            //
+            // The first chunk of a frame starts with its header, which tells us
+            // how large the extensions and the image are.
+            //
+            if (nullptr == partialFrame.Header)
+            {
+                if (chunkLength < SensorFrameStreamHeader::ProtocolHeaderLength)
+                {
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"SensorFrameMultiplexedReceiver::ReceiveAsync: first chunk of %u bytes is too short for a SensorFrameStreamHeader",
+                        chunkLength);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    throw ref new Platform::FailureException();
+                }
+
+                SensorFrameStreamHeader^ header =
+                    ReadSensorFrameStreamHeader();
+
+                bytesToRead -= SensorFrameStreamHeader::ProtocolHeaderLength;
+
+                const uint32_t extendedHeaderLength =
+                    SensorFrameStreamHeader::GetProtocolExtendedHeaderLength(
+                        header->VersionMinor);
+
+                if (bytesToRead < extendedHeaderLength)
+                {
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"SensorFrameMultiplexedReceiver::ReceiveAsync: first chunk of %u bytes is too short for the extended header",
+                        chunkLength);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    throw ref new Platform::FailureException();
+                }
+
+                SensorFrameStreamHeader::ReadExtendedFields(
+                    _reader,
+                    header);
+
+                bytesToRead -= extendedHeaderLength;
+
+                if (header->ExtensionsLength > Io::FrameHeaderExtensionsMaximumLength ||
+                    !IsPayloadLengthValid(header))
+                {
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"SensorFrameMultiplexedReceiver::ReceiveAsync: malformed extended header (%u bytes of extensions, %u bytes of payload)",
+                        header->ExtensionsLength,
+                        header->PayloadLength);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    throw ref new Platform::FailureException();
+                }
+
+                partialFrame.Header = header;
+
+                partialFrame.ExtensionBlock.resize(
+                    header->ExtensionsLength);
+
+                partialFrame.ExtensionBlockOffset = 0;
+
+                partialFrame.Image = ref new Windows::Storage::Streams::Buffer(
+                    header->PayloadLength);
+            }
+
+            //
+            // Fill in the extension block before the image.
+            //
+            const size_t extensionBytesToRead =
+                std::min<size_t>(
+                    bytesToRead,
+                    partialFrame.ExtensionBlock.size() - partialFrame.ExtensionBlockOffset);
+
+            if (extensionBytesToRead > 0)
+            {
+                _reader->ReadBytes(
+                    Platform::ArrayReference<uint8_t>(
+                        partialFrame.ExtensionBlock.data() + partialFrame.ExtensionBlockOffset,
+                        static_cast<uint32_t>(extensionBytesToRead)));
+
+                partialFrame.ExtensionBlockOffset += extensionBytesToRead;
+
+                bytesToRead -= static_cast<uint32_t>(extensionBytesToRead);
+            }
+
+            Windows::Storage::Streams::Buffer^ image =
+                partialFrame.Image;
+
+            if (image->Length + bytesToRead > image->Capacity)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameMultiplexedReceiver::ReceiveAsync: frame data exceeds the image size of %u bytes",
+                    image->Capacity);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            //
+            // Read the chunk straight into the image buffer.
+            //
+            if (bytesToRead > 0)
+            {
+                _reader->ReadBytes(
+                    Platform::ArrayReference<uint8_t>(
+                        Io::GetTypedPointerToIBuffer<uint8_t>(image) + image->Length,
+                        bytesToRead));
+
+                image->Length += bytesToRead;
+            }
+
+            if (!isLastChunk)
+            {
+                return ReceiveChunksAsync();
+            }
+
+            if (image->Length != image->Capacity ||
+                partialFrame.ExtensionBlockOffset != partialFrame.ExtensionBlock.size())
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameMultiplexedReceiver::ReceiveAsync: expected image frame data of %u bytes, got %u bytes",
+                    image->Capacity,
+                    image->Length);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            std::shared_ptr<Io::FrameHeaderExtensions> extensions;
+
+            if (partialFrame.Header->HasExtensions)
+            {
+                extensions = std::make_shared<Io::FrameHeaderExtensions>();
+
+                if (!Io::DecodeFrameHeaderExtensions(
+                        partialFrame.ExtensionBlock.data(),
+                        partialFrame.ExtensionBlock.size(),
+                        *extensions))
+                {
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"SensorFrameMultiplexedReceiver::ReceiveAsync: malformed header extensions");
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    throw ref new Platform::FailureException();
+                }
+            }
+
+            SensorFrameStreamHeader^ header =
+                partialFrame.Header;
+
+            partialFrame.Header = nullptr;
+            partialFrame.ExtensionBlock.clear();
+            partialFrame.ExtensionBlockOffset = 0;
+            partialFrame.Image = nullptr;
+
+            return DeserializeSensorFrameAsync(
+                header,
+                image,
+                extensions.get(),
+                nullptr /* bitmapPool */,
+                &_deltaDecoders[(int32_t)header->FrameType]
+            ).then([this, extensions](SensorFrame^ sensorFrame)
+            {
+                if (nullptr != extensions)
+                {
+                    _extensionsDecoder.Apply(
+                        *extensions,
+                        sensorFrame);
+                }
+
+                return sensorFrame;
+            });
+        });
+    }
+
+    SensorFrameStreamHeader^ SensorFrameMultiplexedReceiver::ReadSensorFrameStreamHeader()
+    {
+        SensorFrameStreamHeader^ header;
+
+        SensorFrameStreamHeader::Read(
+            _reader,
+            &header);
+
+        if (SensorFrameStreamHeader::ProtocolCookie != header->Cookie ||
+            SensorFrameStreamHeader::ProtocolVersionMajor != header->VersionMajor ||
+            SensorFrameStreamHeader::ProtocolVersionMinorWithoutExtensions > header->VersionMinor ||
+            SensorFrameStreamHeader::ProtocolVersionMinor < header->VersionMinor)
+        {
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"SensorFrameMultiplexedReceiver::ReceiveAsync: expected ProtocolCookie/ProtocolVersionMajor/ProtocolVersionMinor of 0x%08x/0x%02x/0x%02x-0x%02x, got 0x%08x/0x%02x/0x%02x",
+                SensorFrameStreamHeader::ProtocolCookie,
+                SensorFrameStreamHeader::ProtocolVersionMajor,
+                SensorFrameStreamHeader::ProtocolVersionMinorWithoutExtensions,
+                SensorFrameStreamHeader::ProtocolVersionMinor,
+                header->Cookie,
+                header->VersionMajor,
+                header->VersionMinor);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        return header;
+    }
+}
@@ -0,0 +1,69 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Client side of a SensorFrameMultiplexedStreamingServer connection: reassembles
+    // the interleaved chunks and returns the frames of all the streamed sensors, in
+    // the order they were completed. Use the FrameType of the frames to tell them
+    // apart.
+    //
+    public ref class SensorFrameMultiplexedReceiver sealed
+    {
+    public:
+        SensorFrameMultiplexedReceiver(
+            _In_ Windows::Networking::Sockets::StreamSocket^ streamSocket);
+
+        Windows::Foundation::IAsyncOperation<SensorFrame^>^ ReceiveAsync();
+
+    private:
+        //
+        // Receives chunks until one of them completes a frame.
+        //
+        Concurrency::task<SensorFrame^> ReceiveChunksAsync();
+
+        Concurrency::task<SensorFrame^> ReceiveChunkAsync(
+            _In_ SensorType frameType,
+            _In_ bool isLastChunk,
+            _In_ uint32_t chunkLength);
+
+        SensorFrameStreamHeader^ ReadSensorFrameStreamHeader();
+
+    private:
+        //
+        // A frame whose chunks are still being received.
+        //
+        struct PartialFrame
+        {
+            SensorFrameStreamHeader^ Header;
+
+            // The extension block precedes the image, and may span chunks.
+            std::vector<uint8_t> ExtensionBlock;
+            size_t ExtensionBlockOffset = 0;
+
+            Windows::Storage::Streams::Buffer^ Image;
+        };
+
+        Windows::Networking::Sockets::StreamSocket^ _streamSocket;
+        Windows::Storage::Streams::DataReader^ _reader;
+
+        std::array<PartialFrame, (size_t)SensorType::NumberOfSensorTypes> _partialFrames;
+
+        // Per sensor, the reference frame of the Delta codec.
+        std::array<SensorFrameDeltaDecoder, (size_t)SensorType::NumberOfSensorTypes> _deltaDecoders;
+
+        SensorFrameExtensionsDecoder _extensionsDecoder;
+    };
+}
@@ -0,0 +1,493 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    SensorFrameMultiplexedStreamingServer::SensorFrameMultiplexedStreamingServer(
+        _In_ Platform::String^ serviceName)
+    {
+        Policy = SensorFrameStreamingPolicy::DropOldest;
+        QueueCapacity = 4;
+        MaximumWritesInFlight = 3;
+        ExtensionsEnabled = false;
+        JpegQuality = 0.9f;
+        KeyframeInterval = 30;
+
+        _weights.fill(
+            1 /* weight */);
+
+        _codecs.fill(
+            SensorFrameStreamingCodec::Raw);
+
+        _listener = ref new Windows::Networking::Sockets::StreamSocketListener();
+
+        _listener->ConnectionReceived +=
+            ref new Windows::Foundation::TypedEventHandler<
+                Windows::Networking::Sockets::StreamSocketListener^,
+                Windows::Networking::Sockets::StreamSocketListenerConnectionReceivedEventArgs^>(
+                    this,
+                    &SensorFrameMultiplexedStreamingServer::OnConnection);
+
+        _listener->Control->KeepAlive = true;
+
+        //
+        // Frames are written as soon as they are scheduled; don't hold small
+        // frames back waiting for more data.
+        //
+        _listener->Control->NoDelay = true;
+
+        // Don't limit traffic to an address or an adapter.
+        Concurrency::create_task(_listener->BindServiceNameAsync(serviceName)).then(
+            [this](Concurrency::task<void> previousTask)
+        {
+            try
+            {
+                // Try getting an exception.
+                previousTask.get();
+            }
+            catch (Platform::Exception^ exception)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameMultiplexedStreamingServer::SensorFrameMultiplexedStreamingServer: %s",
+                    exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+            }
+        });
+    }
+
+    SensorFrameMultiplexedStreamingServer::~SensorFrameMultiplexedStreamingServer()
+    {
+        delete _listener;
+        _listener = nullptr;
+    }
+
+    void SensorFrameMultiplexedStreamingServer::OnConnection(
+        Windows::Networking::Sockets::StreamSocketListener^ listener,
+        Windows::Networking::Sockets::StreamSocketListenerConnectionReceivedEventArgs^ object)
+    {
+        REQUIRES(QueueCapacity > 0 && MaximumWritesInFlight > 0);
+
+        auto connection =
+            std::make_shared<Connection>();
+
+        connection->Socket = object->Socket;
+        connection->MaximumWritesInFlight = MaximumWritesInFlight;
+        connection->ExtensionsEnabled = ExtensionsEnabled;
+
+        connection->ServiceOrder.reserve(
+            _weights.size());
+
+        for (uint32_t i = 0; i < MaximumWritesInFlight; ++i)
+        {
+            connection->FreeChunkBuffers.push_back(
+                ref new Windows::Storage::Streams::Buffer(
+                    MultiplexedChunkHeaderLength + MultiplexedChunkMaximumLength));
+        }
+
+        std::lock_guard<std::mutex> lock(_connectionMutex);
+
+        for (size_t i = 0; i < _weights.size(); ++i)
+        {
+            connection->SendQueues[i] =
+                std::make_unique<SendQueue>(
+                    QueueCapacity,
+                    MaximumWritesInFlight,
+                    ToSendQueuePolicy(Policy, _codecs[i]));
+
+            connection->Scheduler.SetWeight(
+                i,
+                _weights[i]);
+
+            if (SensorFrameStreamingCodec::Raw != _codecs[i])
+            {
+                connection->Compressors[i] =
+                    std::make_unique<SensorFrameCompressor>(
+                        _codecs[i],
+                        JpegQuality,
+                        KeyframeInterval);
+            }
+        }
+
+        if (nullptr != _connection)
+        {
+            CloseConnection(
+                *_connection);
+        }
+
+        _connection = connection;
+    }
+
+    void SensorFrameMultiplexedStreamingServer::SetWeight(
+        _In_ SensorType sensorType,
+        _In_ uint32_t weight)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_weights.size());
+
+        REQUIRES(weight > 0);
+
+        std::lock_guard<std::mutex> lock(_connectionMutex);
+
+        _weights[sensorTypeAsIndex] = weight;
+
+        if (nullptr != _connection)
+        {
+            std::lock_guard<std::recursive_mutex> writeLock(_connection->WriteMutex);
+
+            _connection->Scheduler.SetWeight(
+                sensorTypeAsIndex,
+                weight);
+        }
+    }
+
+    void SensorFrameMultiplexedStreamingServer::SetCodec(
+        _In_ SensorType sensorType,
+        _In_ SensorFrameStreamingCodec codec)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_codecs.size());
+
+        std::lock_guard<std::mutex> lock(_connectionMutex);
+
+        _codecs[sensorTypeAsIndex] = codec;
+    }
+
+    SensorFrameStreamingStatistics SensorFrameMultiplexedStreamingServer::GetStatistics(
+        _In_ SensorType sensorType)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_weights.size());
+
+        std::shared_ptr<Connection> connection;
+
+        {
+            std::lock_guard<std::mutex> lock(_connectionMutex);
+
+            connection = _connection;
+        }
+
+        if (nullptr == connection)
+        {
+            SensorFrameStreamingStatistics statistics = {};
+
+            return statistics;
+        }
+
+        return ToSensorFrameStreamingStatistics(
+            connection->SendQueues[sensorTypeAsIndex]->GetStatistics());
+    }
+
+    void SensorFrameMultiplexedStreamingServer::Send(
+        SensorFrame^ sensorFrame)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorFrame->FrameType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_weights.size());
+
+        std::shared_ptr<Connection> connection;
+
+        {
+            std::lock_guard<std::mutex> lock(_connectionMutex);
+
+            connection = _connection;
+        }
+
+        if (nullptr == connection || connection->SendQueues[sensorTypeAsIndex]->IsClosed())
+        {
+#if DBG_ENABLE_VERBOSE_LOGGING
+            dbg::trace(
+                L"SensorFrameMultiplexedStreamingServer::Send: image dropped -- no connection!");
+#endif /* DBG_ENABLE_VERBOSE_LOGGING */
+
+            return;
+        }
+
+        SensorFrameCompressor* compressor =
+            connection->Compressors[sensorTypeAsIndex].get();
+
+        //
+        // A delta must be queued before the frame compressed after it.
+        //
+        std::unique_lock<std::mutex> compressionOrderLock(
+            connection->CompressionOrderMutexes[sensorTypeAsIndex],
+            std::defer_lock);
+
+        if (nullptr != compressor && SensorFrameStreamingCodec::Delta == compressor->GetCodec())
+        {
+            compressionOrderLock.lock();
+        }
+
+        SerializedSensorFrame frame;
+        bool isKeyframe = true;
+
+        if (connection->ExtensionsEnabled)
+        {
+            std::vector<uint8_t> extensionBlock;
+
+            frame.CarriesUnprojectionLut =
+                _extensionsEncoder.Encode(
+                    sensorFrame,
+                    !connection->UnprojectionLutSent[sensorTypeAsIndex] /* includeUnprojectionLut */,
+                    extensionBlock);
+
+            frame.Buffer =
+                SerializeSensorFrame(
+                    sensorFrame,
+                    &extensionBlock,
+                    compressor,
+                    &isKeyframe);
+        }
+        else
+        {
+            frame.Buffer =
+                SerializeSensorFrame(
+                    sensorFrame,
+                    nullptr /* extensionBlock */,
+                    compressor,
+                    &isKeyframe);
+        }
+
+        if (!connection->SendQueues[sensorTypeAsIndex]->Push(frame, frame.Buffer->Length, isKeyframe))
+        {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+            dbg::trace(
+                L"SensorFrameMultiplexedStreamingServer::Send: image dropped -- the send queue is full!");
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+            if (nullptr != compressor)
+            {
+                compressor->RequestKeyframe();
+            }
+        }
+
+        if (compressionOrderLock.owns_lock())
+        {
+            compressionOrderLock.unlock();
+        }
+
+        StartWrites(
+            connection);
+    }
+
+    void SensorFrameMultiplexedStreamingServer::StartWrites(
+        _In_ const std::shared_ptr<Connection>& connection)
+    {
+        //
+        // Writes to a stream socket may overlap and complete in the order they
+        // were started, which must be the order the chunks were scheduled in.
+        //
+        std::lock_guard<std::recursive_mutex> lock(connection->WriteMutex);
+
+        while (connection->WritesInFlight < connection->MaximumWritesInFlight)
+        {
+            size_t sensorTypeAsIndex = 0;
+            Windows::Storage::Streams::IBuffer^ chunk;
+            bool isLastChunk = false;
+
+            if (!TryGetNextChunk(*connection, &sensorTypeAsIndex, &chunk, &isLastChunk))
+            {
+                break;
+            }
+
+            SendQueue* sendQueue =
+                connection->SendQueues[sensorTypeAsIndex].get();
+
+            const size_t frameSize =
+                isLastChunk ? connection->FrameOffsets[sensorTypeAsIndex] : 0;
+
+            if (isLastChunk)
+            {
+                connection->Frames[sensorTypeAsIndex] = nullptr;
+                connection->FrameOffsets[sensorTypeAsIndex] = 0;
+            }
+
+            ++connection->WritesInFlight;
+
+            Concurrency::create_task(connection->Socket->OutputStream->WriteAsync(chunk)).then(
+                [this, connection, sendQueue, chunk, isLastChunk, frameSize](Concurrency::task<unsigned int> writeTask)
+            {
+                bool succeeded = false;
+
+                try
+                {
+                    // Try getting an exception.
+                    writeTask.get();
+
+                    succeeded = true;
+                }
+                catch (Platform::Exception^ exception)
+                {
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"SensorFrameMultiplexedStreamingServer::StartWrites: WriteAsync call failed with error: %s",
+                        exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+                }
+
+                //
+                // The frame is sent once its last chunk is. Should an earlier chunk
+                // fail, the connection is closed and the frame is never ended.
+                //
+                if (isLastChunk)
+                {
+                    sendQueue->EndSend(
+                        frameSize,
+                        succeeded);
+                }
+
+                {
+                    std::lock_guard<std::recursive_mutex> writeLock(connection->WriteMutex);
+
+                    --connection->WritesInFlight;
+
+                    connection->FreeChunkBuffers.push_back(
+                        chunk);
+                }
+
+                if (!succeeded)
+                {
+                    // The connection is gone; wait for the client to reconnect.
+                    CloseConnection(
+                        *connection);
+
+                    return;
+                }
+
+                StartWrites(
+                    connection);
+            });
+        }
+    }
+
+    bool SensorFrameMultiplexedStreamingServer::TryGetNextChunk(
+        _Inout_ Connection& connection,
+        _Out_ size_t* sensorTypeAsIndex,
+        _Out_ Windows::Storage::Streams::IBuffer^* chunk,
+        _Out_ bool* isLastChunk)
+    {
+        //
+        // A buffer is free for every write that may start (see StartWrites).
+        //
+        ASSERT(!connection.FreeChunkBuffers.empty());
+
+        connection.Scheduler.GetServiceOrder(
+            connection.ServiceOrder);
+
+        for (const size_t index : connection.ServiceOrder)
+        {
+            if (nullptr == connection.Frames[index])
+            {
+                SerializedSensorFrame serializedFrame;
+                size_t frameSize = 0;
+
+                if (!connection.SendQueues[index]->TryBeginSend(&serializedFrame, &frameSize))
+                {
+                    continue;
+                }
+
+                //
+                // The chunks of the sensor's later frames are scheduled after
+                // the ones of this frame, so they can refer to its LUT.
+                //
+                if (serializedFrame.CarriesUnprojectionLut)
+                {
+                    connection.UnprojectionLutSent[index] = true;
+                }
+
+                connection.Frames[index] = serializedFrame.Buffer;
+                connection.FrameOffsets[index] = 0;
+            }
+
+            Windows::Storage::Streams::IBuffer^ frame =
+                connection.Frames[index];
+
+            const uint32_t frameOffset =
+                connection.FrameOffsets[index];
+
+            const uint32_t chunkLength =
+                std::min<uint32_t>(
+                    frame->Length - frameOffset,
+                    MultiplexedChunkMaximumLength);
+
+            *sensorTypeAsIndex = index;
+            *isLastChunk = (frameOffset + chunkLength == frame->Length);
+
+            //
+            // The chunk header and the slice of the frame are written into a
+            // free chunk buffer of the connection. IBuffer has no view of part
+            // of another buffer, so the slice is copied, once.
+            //
+            Windows::Storage::Streams::IBuffer^ chunkBuffer =
+                connection.FreeChunkBuffers.back();
+
+            connection.FreeChunkBuffers.pop_back();
+
+            uint8_t* chunkData =
+                Io::GetTypedPointerToIBuffer<uint8_t>(chunkBuffer);
+
+            const uint16_t chunkSensorType = static_cast<uint16_t>(index);
+            const uint16_t chunkFlags = *isLastChunk ? MultiplexedChunkFlagLast : 0;
+
+            // Little endian, like the rest of the stream.
+            memcpy(chunkData, &chunkSensorType, sizeof(chunkSensorType));
+            memcpy(chunkData + 2, &chunkFlags, sizeof(chunkFlags));
+            memcpy(chunkData + 4, &chunkLength, sizeof(chunkLength));
+
+            memcpy(
+                chunkData + MultiplexedChunkHeaderLength,
+                Io::GetTypedPointerToIBuffer<uint8_t>(frame) + frameOffset,
+                chunkLength);
+
+            chunkBuffer->Length =
+                MultiplexedChunkHeaderLength + chunkLength;
+
+            *chunk = chunkBuffer;
+
+            connection.FrameOffsets[index] += chunkLength;
+
+            connection.Scheduler.Charge(
+                index,
+                chunkLength);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void SensorFrameMultiplexedStreamingServer::CloseConnection(
+        _In_ Connection& connection)
+    {
+        for (auto& sendQueue : connection.SendQueues)
+        {
+            sendQueue->Close();
+        }
+    }
+}
@@ -0,0 +1,166 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Streams the frames of all the sensors over a single connection. Frames are
+    // self-describing (see SensorFrameStreamHeader), so a SensorFrameReceiver
+    // reading from the connection gets the frames of all the sensors and can tell
+    // them apart by their FrameType.
+    //
+    // Each sensor has its own send queue, configured like the one of the
+    // SensorFrameStreamingServer. Frames are sent in chunks, and the connection
+    // is shared between the sensors chunk by chunk in proportion to their
+    // weights, so that a sensor with large or frequent frames can not starve the
+    // others. Use a SensorFrameMultiplexedReceiver on the client side.
+    //
+    public ref class SensorFrameMultiplexedStreamingServer sealed
+        : public ISensorFrameSink
+    {
+    public:
+        SensorFrameMultiplexedStreamingServer(
+            _In_ Platform::String^ serviceName);
+
+        virtual void Send(
+            SensorFrame^ sensorFrame);
+
+        //
+        // Send queue configuration, per sensor. Takes effect with the next
+        // connection. MaximumWritesInFlight applies to the whole connection.
+        //
+        property SensorFrameStreamingPolicy Policy;
+        property uint32_t QueueCapacity;
+        property uint32_t MaximumWritesInFlight;
+
+        //
+        // Sends version 0.2 headers, with the pose and intrinsics of the frames.
+        // Takes effect with the next connection.
+        //
+        property bool ExtensionsEnabled;
+
+        //
+        // Quality of the JPEG codec, between 0 and 1, and number of frames from a
+        // keyframe to the next with the Delta codec. Takes effect with the next
+        // connection.
+        //
+        property float JpegQuality;
+        property uint32_t KeyframeInterval;
+
+        //
+        // Share of the connection a sensor gets while other sensors have frames
+        // queued as well, relative to the other sensors. Defaults to 1.
+        //
+        void SetWeight(
+            _In_ SensorType sensorType,
+            _In_ uint32_t weight);
+
+        //
+        // Compression of a sensor's frames (version 0.3 headers). Defaults to
+        // Raw; takes effect with the next connection. The send queue of a sensor
+        // using the Delta codec behaves like a KeyframeOnly one, unless its
+        // policy is Block.
+        //
+        void SetCodec(
+            _In_ SensorType sensorType,
+            _In_ SensorFrameStreamingCodec codec);
+
+        SensorFrameStreamingStatistics GetStatistics(
+            _In_ SensorType sensorType);
+
+    private:
+        ~SensorFrameMultiplexedStreamingServer();
+
+        typedef Io::FrameSendQueue<SerializedSensorFrame> SendQueue;
+
+        struct Connection
+        {
+            Windows::Networking::Sockets::StreamSocket^ Socket;
+
+            std::array<std::unique_ptr<SendQueue>, (size_t)SensorType::NumberOfSensorTypes> SendQueues;
+
+            // Per sensor, nullptr for uncompressed frames.
+            std::array<std::unique_ptr<SensorFrameCompressor>, (size_t)SensorType::NumberOfSensorTypes> Compressors;
+
+            // Per sensor, keeps delta compressed frames queued in the order they
+            // were compressed.
+            std::array<std::mutex, (size_t)SensorType::NumberOfSensorTypes> CompressionOrderMutexes;
+
+            // Per sensor, the frame being sent and how much of it has been sent.
+            std::array<Windows::Storage::Streams::IBuffer^, (size_t)SensorType::NumberOfSensorTypes> Frames;
+            std::array<uint32_t, (size_t)SensorType::NumberOfSensorTypes> FrameOffsets;
+
+            // Guards the scheduler, the write count and the chunk buffers, and
+            // keeps the writes in the order they were scheduled in.
+            std::recursive_mutex WriteMutex;
+            Io::StreamScheduler Scheduler;
+            uint32_t WritesInFlight;
+            uint32_t MaximumWritesInFlight;
+
+            // Scratch space of the scheduler, kept across chunks.
+            std::vector<size_t> ServiceOrder;
+
+            // One buffer per write in flight, allocated with the connection; a
+            // buffer returns to the list once its write completes.
+            std::vector<Windows::Storage::Streams::IBuffer^> FreeChunkBuffers;
+
+            // Per sensor, whether a frame carrying the unprojection LUT has been
+            // scheduled on this connection.
+            bool ExtensionsEnabled;
+            std::array<std::atomic<bool>, (size_t)SensorType::NumberOfSensorTypes> UnprojectionLutSent;
+
+            Connection()
+                : Scheduler((size_t)SensorType::NumberOfSensorTypes)
+                , WritesInFlight(0)
+                , MaximumWritesInFlight(0)
+                , ExtensionsEnabled(false)
+            {
+                FrameOffsets.fill(
+                    0);
+
+                for (auto& unprojectionLutSent : UnprojectionLutSent)
+                {
+                    unprojectionLutSent = false;
+                }
+            }
+        };
+
+        void OnConnection(
+            Windows::Networking::Sockets::StreamSocketListener^ listener,
+            Windows::Networking::Sockets::StreamSocketListenerConnectionReceivedEventArgs^ object);
+
+        void StartWrites(
+            _In_ const std::shared_ptr<Connection>& connection);
+
+        bool TryGetNextChunk(
+            _Inout_ Connection& connection,
+            _Out_ size_t* sensorTypeAsIndex,
+            _Out_ Windows::Storage::Streams::IBuffer^* chunk,
+            _Out_ bool* isLastChunk);
+
+        void CloseConnection(
+            _In_ Connection& connection);
+
+    private:
+        Windows::Networking::Sockets::StreamSocketListener^ _listener;
+
+        std::mutex _connectionMutex;
+        std::shared_ptr<Connection> _connection;
+
+        std::array<uint32_t, (size_t)SensorType::NumberOfSensorTypes> _weights;
+        std::array<SensorFrameStreamingCodec, (size_t)SensorType::NumberOfSensorTypes> _codecs;
+
+        SensorFrameExtensionsEncoder _extensionsEncoder;
+    };
+}
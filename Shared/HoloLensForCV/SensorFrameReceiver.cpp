@@ -25,6 +25,26 @@ namespace HoloLensForCV
 
         _reader->ByteOrder =
             Windows::Storage::Streams::ByteOrder::LittleEndian;
+
+        FramePoolCapacity = 0;
+    }
+
+    SensorFramePoolStatistics SensorFrameReceiver::GetFramePoolStatistics()
+    {
+        SensorFramePoolStatistics statistics = {};
+
+        if (nullptr != _bitmapPool)
+        {
+            const Io::FramePoolStatistics bitmapPoolStatistics =
+                _bitmapPool->GetStatistics();
+
+            statistics.Acquisitions = bitmapPoolStatistics.Acquisitions;
+            statistics.Allocations = bitmapPoolStatistics.Allocations;
+            statistics.BitmapsInUse = static_cast<uint32_t>(bitmapPoolStatistics.BuffersInUse);
+            statistics.HighWaterMark = static_cast<uint32_t>(bitmapPoolStatistics.HighWaterMark);
+        }
+
+        return statistics;
     }
 
     Concurrency::task<SensorFrameStreamHeader^> SensorFrameReceiver::ReceiveSensorFrameStreamHeaderAsync()
@@ -59,15 +79,20 @@ namespace HoloLensForCV
                 _reader,
                 &header);
 
+            //
+            // Servers send version 0.1 headers unless extensions are enabled.
+            //
             if (SensorFrameStreamHeader::ProtocolCookie != header->Cookie ||
                 SensorFrameStreamHeader::ProtocolVersionMajor != header->VersionMajor ||
-                SensorFrameStreamHeader::ProtocolVersionMinor != header->VersionMinor)
+                SensorFrameStreamHeader::ProtocolVersionMinorWithoutExtensions > header->VersionMinor ||
+                SensorFrameStreamHeader::ProtocolVersionMinor < header->VersionMinor)
             {
 #if DBG_ENABLE_ERROR_LOGGING
                 dbg::trace(
-                    L"SensorFrameReceiver::ReceiveAsync: expected ProtocolCookie/ProtocolVersionMajor/ProtocolVersionMinor of 0x%08x/0x%02x/0x%02x, got 0x%08x/0x%02x/0x%02x",
+                    L"SensorFrameReceiver::ReceiveAsync: expected ProtocolCookie/ProtocolVersionMajor/ProtocolVersionMinor of 0x%08x/0x%02x/0x%02x-0x%02x, got 0x%08x/0x%02x/0x%02x",
                     SensorFrameStreamHeader::ProtocolCookie,
                     SensorFrameStreamHeader::ProtocolVersionMajor,
+                    SensorFrameStreamHeader::ProtocolVersionMinorWithoutExtensions,
                     SensorFrameStreamHeader::ProtocolVersionMinor,
                     header->Cookie,
                     header->VersionMajor,
@@ -90,97 +115,190 @@ namespace HoloLensForCV
         });
     }
 
-    Concurrency::task<SensorFrame^> SensorFrameReceiver::ReceiveSensorFrameAsync(
+    Concurrency::task<std::shared_ptr<Io::FrameHeaderExtensions>> SensorFrameReceiver::ReceiveExtensionsAsync(
         SensorFrameStreamHeader^ header)
     {
+        if (!header->HasExtensions)
+        {
+            return concurrency::task_from_result(
+                std::shared_ptr<Io::FrameHeaderExtensions>());
+        }
+
+        const uint32_t extendedHeaderLength =
+            SensorFrameStreamHeader::GetProtocolExtendedHeaderLength(
+                header->VersionMinor);
+
         return concurrency::create_task(
             _reader->LoadAsync(
-                header->ImageHeight * header->RowStride)).
-            then([this, header](concurrency::task<unsigned int> frameBytesLoadedTaskResult)
+                extendedHeaderLength)
+        ).then([this, header, extendedHeaderLength](concurrency::task<unsigned int> extendedHeaderBytesLoadedTaskResult)
         {
-            //
-            // Make sure that we have received exactly the number of bytes we have
-            // asked for. Doing so will also implicitly check for the possible exceptions
-            // that could have been thrown in the async call chain.
-            //
-            const size_t frameBytesLoaded = frameBytesLoadedTaskResult.get();
+            const size_t extendedHeaderBytesLoaded = extendedHeaderBytesLoadedTaskResult.get();
 
-            if (header->ImageHeight * header->RowStride != frameBytesLoaded)
+            if (extendedHeaderLength != extendedHeaderBytesLoaded)
             {
 #if DBG_ENABLE_ERROR_LOGGING
                 dbg::trace(
-                    L"SensorFrameReceiver::ReceiveAsync: expected image frame data of %i bytes, got %i bytes",
-                    header->ImageHeight * header->RowStride,
-                    frameBytesLoaded);
+                    L"SensorFrameReceiver::ReceiveAsync: expected extended header of %u bytes, got %i bytes",
+                    extendedHeaderLength,
+                    extendedHeaderBytesLoaded);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            SensorFrameStreamHeader::ReadExtendedFields(
+                _reader,
+                header);
+
+            if (header->ExtensionsLength > Io::FrameHeaderExtensionsMaximumLength ||
+                !IsPayloadLengthValid(header))
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameReceiver::ReceiveAsync: malformed extended header (%u bytes of extensions, %u bytes of payload)",
+                    header->ExtensionsLength,
+                    header->PayloadLength);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            return concurrency::create_task(
+                _reader->LoadAsync(
+                    header->ExtensionsLength));
+        }).then([this, header](concurrency::task<unsigned int> extensionBytesLoadedTaskResult)
+        {
+            const size_t extensionBytesLoaded = extensionBytesLoadedTaskResult.get();
+
+            if (header->ExtensionsLength != extensionBytesLoaded)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameReceiver::ReceiveAsync: expected extensions of %u bytes, got %i bytes",
+                    header->ExtensionsLength,
+                    extensionBytesLoaded);
 #endif /* DBG_ENABLE_ERROR_LOGGING */
 
                 throw ref new Platform::FailureException();
             }
 
-            Windows::Storage::Streams::IBuffer^ frameAsBuffer =
-                _reader->ReadBuffer(
-                    static_cast<uint32_t>(frameBytesLoaded));
+            std::vector<uint8_t> extensionBlock(
+                header->ExtensionsLength);
+
+            if (!extensionBlock.empty())
+            {
+                _reader->ReadBytes(
+                    Platform::ArrayReference<uint8_t>(
+                        extensionBlock.data(),
+                        header->ExtensionsLength));
+            }
 
-            Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat;
-            uint32_t packedImageWidthMultiplier = 1;
+            auto extensions =
+                std::make_shared<Io::FrameHeaderExtensions>();
 
-            switch (header->FrameType)
+            if (!Io::DecodeFrameHeaderExtensions(
+                    extensionBlock.data(),
+                    extensionBlock.size(),
+                    *extensions))
             {
-            case SensorType::PhotoVideo:
-                pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8;
-                break;
-
-            case SensorType::ShortThrowToFDepth:
-            case SensorType::LongThrowToFDepth:
-                pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray16;
-                break;
-
-            case SensorType::ShortThrowToFReflectivity:
-            case SensorType::LongThrowToFReflectivity:
-                pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray8;
-                break;
-
-            case SensorType::VisibleLightLeftLeft:
-            case SensorType::VisibleLightLeftFront:
-            case SensorType::VisibleLightRightFront:
-            case SensorType::VisibleLightRightRight:
-                pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray8;
-                packedImageWidthMultiplier = 4;
-                break;
-
-            default:
 #if DBG_ENABLE_ERROR_LOGGING
                 dbg::trace(
-                    L"SensorFrameReceiver::ReceiveAsync: unrecognized sensor type %i",
-                    header->FrameType);
+                    L"SensorFrameReceiver::ReceiveAsync: malformed header extensions");
 #endif /* DBG_ENABLE_ERROR_LOGGING */
 
                 throw ref new Platform::FailureException();
             }
 
-            Windows::Graphics::Imaging::SoftwareBitmap^ frameAsSoftwareBitmap =
-                Windows::Graphics::Imaging::SoftwareBitmap::CreateCopyFromBuffer(
-                    frameAsBuffer,
-                    pixelFormat,
-                    header->ImageWidth * packedImageWidthMultiplier,
-                    header->ImageHeight,
-                    Windows::Graphics::Imaging::BitmapAlphaMode::Ignore);
+            return extensions;
+        });
+    }
 
+    Concurrency::task<SensorFrame^> SensorFrameReceiver::ReceiveSensorFrameAsync(
+        SensorFrameStreamHeader^ header,
+        std::shared_ptr<Io::FrameHeaderExtensions> extensions)
+    {
+        return concurrency::create_task(
+            _reader->LoadAsync(
+                header->PayloadLength)).
+            then([this, header, extensions](concurrency::task<unsigned int> frameBytesLoadedTaskResult)
+        {
             //
-            // Timestamps on the wire are encoded as universal time
+            // Make sure that we have received exactly the number of bytes we have
+            // asked for. Doing so will also implicitly check for the possible exceptions
+            // that could have been thrown in the async call chain.
             //
-            Windows::Foundation::DateTime frameTimestamp;
+            const size_t frameBytesLoaded = frameBytesLoadedTaskResult.get();
+
+            if (header->PayloadLength != frameBytesLoaded)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"SensorFrameReceiver::ReceiveAsync: expected image frame data of %u bytes, got %i bytes",
+                    header->PayloadLength,
+                    frameBytesLoaded);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            Windows::Storage::Streams::IBuffer^ frameAsBuffer;
+
+            if (FramePoolCapacity > 0)
+            {
+                if (nullptr == _bitmapPool)
+                {
+                    _bitmapPool = std::make_unique<SoftwareBitmapPool>(
+                        CreatePooledSoftwareBitmap,
+                        FramePoolCapacity);
+                }
 
-            frameTimestamp.UniversalTime =
-                header->Timestamp;
+                //
+                // Frames are received one at a time, and deserializing them is
+                // done with the payload by the time the next one is received.
+                //
+                if (nullptr == _payloadBuffer || _payloadBuffer->Capacity < header->PayloadLength)
+                {
+                    _payloadBuffer =
+                        ref new Windows::Storage::Streams::Buffer(
+                            header->PayloadLength);
+                }
 
-            SensorFrame^ sensorFrame =
-                ref new SensorFrame(
-                    header->FrameType,
-                    frameTimestamp,
-                    frameAsSoftwareBitmap);
+                if (header->PayloadLength > 0)
+                {
+                    _reader->ReadBytes(
+                        Platform::ArrayReference<uint8_t>(
+                            Io::GetTypedPointerToIBuffer<uint8_t>(_payloadBuffer),
+                            header->PayloadLength));
+                }
 
-            //TODO: add support for sending and receiving camera intrinsics and extrinsics
+                _payloadBuffer->Length =
+                    header->PayloadLength;
+
+                frameAsBuffer =
+                    _payloadBuffer;
+            }
+            else
+            {
+                frameAsBuffer =
+                    _reader->ReadBuffer(
+                        static_cast<uint32_t>(frameBytesLoaded));
+            }
+
+            return DeserializeSensorFrameAsync(
+                header,
+                frameAsBuffer,
+                extensions.get(),
+                _bitmapPool.get(),
+                &_deltaDecoder);
+        }).then([this, extensions](SensorFrame^ sensorFrame)
+        {
+            if (nullptr != extensions)
+            {
+                _extensionsDecoder.Apply(
+                    *extensions,
+                    sensorFrame);
+            }
 
             return sensorFrame;
         });
@@ -192,10 +310,19 @@ namespace HoloLensForCV
             [this]()
         {
             return ReceiveSensorFrameStreamHeaderAsync().then(
-                [this](concurrency::task<SensorFrameStreamHeader^> header)
+                [this](concurrency::task<SensorFrameStreamHeader^> headerTask)
             {
-                return ReceiveSensorFrameAsync(
-                    header.get());
+                SensorFrameStreamHeader^ header =
+                    headerTask.get();
+
+                return ReceiveExtensionsAsync(
+                    header).then(
+                        [this, header](concurrency::task<std::shared_ptr<Io::FrameHeaderExtensions>> extensions)
+                {
+                    return ReceiveSensorFrameAsync(
+                        header,
+                        extensions.get());
+                });
             });
         });
     }
@@ -13,6 +13,22 @@
 
 namespace HoloLensForCV
 {
+    //
+    // Counters of a receiver's frame pool.
+    //
+    public value struct SensorFramePoolStatistics
+    {
+        uint64_t Acquisitions;
+
+        // Bitmaps created because none of the right size was free.
+        uint64_t Allocations;
+
+        // Bitmaps held by received frames, and the most that were held at the
+        // same time.
+        uint32_t BitmapsInUse;
+        uint32_t HighWaterMark;
+    };
+
     //
     // On the device side, the sensor frame streamer will open a stream socket for each
     // of the sensors.
@@ -20,6 +36,9 @@ namespace HoloLensForCV
     // On the client side, connect to that socket and use this class to await on the
     // ReceiveAsync call to obtain sensor frames.
     //
+    // When the streamer multiplexes all the sensors over a single connection, use the
+    // SensorFrameMultiplexedReceiver instead.
+    //
     public ref class SensorFrameReceiver sealed
     {
     public:
@@ -28,14 +47,42 @@ namespace HoloLensForCV
 
         Windows::Foundation::IAsyncOperation<SensorFrame^>^ ReceiveAsync();
 
+        //
+        // Number of bitmaps of each image size kept for reuse. Zero, the default,
+        // gives each frame a bitmap of its own. Otherwise, frames give their bitmap
+        // back to the receiver when released: copy the SoftwareBitmap of frames
+        // that may be released before their bitmap. Must be set before the first
+        // frame is received.
+        //
+        property uint32_t FramePoolCapacity;
+
+        SensorFramePoolStatistics GetFramePoolStatistics();
+
     private:
         Concurrency::task<SensorFrameStreamHeader^> ReceiveSensorFrameStreamHeaderAsync();
 
-        Concurrency::task<SensorFrame^> ReceiveSensorFrameAsync(
+        //
+        // Returns nullptr for headers without extensions.
+        //
+        Concurrency::task<std::shared_ptr<Io::FrameHeaderExtensions>> ReceiveExtensionsAsync(
             SensorFrameStreamHeader^ header);
 
+        Concurrency::task<SensorFrame^> ReceiveSensorFrameAsync(
+            SensorFrameStreamHeader^ header,
+            std::shared_ptr<Io::FrameHeaderExtensions> extensions);
+
     private:
         Windows::Networking::Sockets::StreamSocket^ _streamSocket;
         Windows::Storage::Streams::DataReader^ _reader;
+
+        SensorFrameExtensionsDecoder _extensionsDecoder;
+
+        // Created with the first frame if FramePoolCapacity is set, along with a
+        // payload buffer that is reused across frames.
+        std::unique_ptr<SoftwareBitmapPool> _bitmapPool;
+        Windows::Storage::Streams::Buffer^ _payloadBuffer;
+
+        // The reference frame of the Delta codec.
+        SensorFrameDeltaDecoder _deltaDecoder;
     };
 }
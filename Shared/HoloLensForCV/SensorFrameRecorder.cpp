@@ -14,12 +14,27 @@
 namespace HoloLensForCV
 {
     SensorFrameRecorder::SensorFrameRecorder()
+        : _poseLogEnabled(false)
     {
+        _storageCodecs.fill(
+            SensorFrameStorageCodec::Raw);
     }
 
     SensorFrameRecorder::~SensorFrameRecorder()
     {
-        Stop();
+        //
+        // Destructors must not throw: failures are only reported by Stop.
+        //
+        try
+        {
+            Stop();
+        }
+        catch (Platform::Exception^)
+        {
+        }
+        catch (const std::exception&)
+        {
+        }
     }
 
     void SensorFrameRecorder::EnableAll()
@@ -58,10 +73,71 @@ namespace HoloLensForCV
                     GetSensorName(
                         sensorType)));
 
+        sensorFrameSink->StorageCodec =
+            _storageCodecs[sensorTypeAsIndex];
+
+        sensorFrameSink->PoseLogEnabled =
+            _poseLogEnabled;
+
         _sensorFrameSinks[sensorTypeAsIndex] =
             sensorFrameSink;
     }
 
+    void SensorFrameRecorder::SetStorageCodec(
+        _In_ SensorType sensorType,
+        _In_ SensorFrameStorageCodec storageCodec)
+    {
+        std::lock_guard<std::mutex> recorderLockGuard(
+            _recorderMutex);
+
+        REQUIRES(nullptr == _archiveSourceFolder);
+
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_storageCodecs.size());
+
+        _storageCodecs[sensorTypeAsIndex] =
+            storageCodec;
+
+        if (nullptr != _sensorFrameSinks[sensorTypeAsIndex])
+        {
+            _sensorFrameSinks[sensorTypeAsIndex]->StorageCodec =
+                storageCodec;
+        }
+    }
+
+    bool SensorFrameRecorder::PoseLogEnabled::get()
+    {
+        std::lock_guard<std::mutex> recorderLockGuard(
+            _recorderMutex);
+
+        return _poseLogEnabled;
+    }
+
+    void SensorFrameRecorder::PoseLogEnabled::set(
+        bool value)
+    {
+        std::lock_guard<std::mutex> recorderLockGuard(
+            _recorderMutex);
+
+        REQUIRES(nullptr == _archiveSourceFolder);
+
+        _poseLogEnabled =
+            value;
+
+        for (SensorFrameRecorderSink^ sensorFrameSink : _sensorFrameSinks)
+        {
+            if (nullptr != sensorFrameSink)
+            {
+                sensorFrameSink->PoseLogEnabled =
+                    value;
+            }
+        }
+    }
+
     Windows::Foundation::IAsyncAction^ SensorFrameRecorder::StartAsync()
     {
         return concurrency::create_async(
@@ -103,6 +179,13 @@ namespace HoloLensForCV
         //
         std::vector<std::wstring> sourceFiles;
 
+        //
+        // A sink whose frames could not all be written still closes its
+        // files. Stop the others and complete the recording before reporting
+        // the first failure.
+        //
+        Platform::Exception^ sinkFailure = nullptr;
+
 		for (SensorFrameRecorderSink^ sensorFrameSink : _sensorFrameSinks)
 		{
 			if (nullptr == sensorFrameSink)
@@ -110,8 +193,17 @@ namespace HoloLensForCV
 				continue;
 			}
 
-			sensorFrameSink->Stop();
-
+			try
+			{
+				sensorFrameSink->Stop();
+			}
+			catch (Platform::Exception^ exception)
+			{
+				if (nullptr == sinkFailure)
+				{
+					sinkFailure = exception;
+				}
+			}
 		}
 
 		for (SensorFrameRecorderSink^ sensorFrameSink : _sensorFrameSinks)
@@ -134,6 +226,11 @@ namespace HoloLensForCV
         //
         ReportCameraCalibrationInformation(sourceFiles);
 
+        //
+        // Add the codecs used to store the sensor frames.
+        //
+        ReportStorageCodecInformation(sourceFiles);
+
         //
         // Create a TAR file containing all the recording files reported so far.
         //
@@ -166,6 +263,11 @@ namespace HoloLensForCV
         }
 
         _archiveSourceFolder = nullptr;
+
+        if (nullptr != sinkFailure)
+        {
+            throw sinkFailure;
+        }
     }
 
     void SensorFrameRecorder::ReportRecorderVersioningInformation(
@@ -237,18 +339,30 @@ namespace HoloLensForCV
 
             sourceFiles.push_back(fileName);
 
-            std::vector<Windows::Foundation::Point> pointList;
-            pointList.resize(cameraIntrinsics->ImageWidth * cameraIntrinsics->ImageHeight);
-            size_t index = 0;
-            for (unsigned int x = 0; x < cameraIntrinsics->ImageWidth; ++x)
-            {
-                for (unsigned int y = 0; y < cameraIntrinsics->ImageHeight; ++y)
+            //
+            // Stored in the layout Io::UnprojectionLut::AssignCameraSpaceProjection
+            // loads the LUT of the sensor from.
+            //
+            std::vector<float> cameraSpaceProjection;
+
+            Io::SampleCameraSpaceProjection(
+                cameraIntrinsics->ImageWidth,
+                cameraIntrinsics->ImageHeight,
+                [cameraIntrinsics](float u, float v, float* x, float* y)
                 {
-                    Windows::Foundation::Point uv = { float(x), float(y) }, xy;
-                    cameraIntrinsics->MapImagePointToCameraUnitPlane(uv, &xy);
-                    pointList[index++] = xy;
-                }
-            }
+                    Windows::Foundation::Point uv = { u, v }, xy;
+
+                    if (!cameraIntrinsics->MapImagePointToCameraUnitPlane(uv, &xy))
+                    {
+                        return false;
+                    }
+
+                    *x = xy.X;
+                    *y = xy.Y;
+
+                    return true;
+                },
+                cameraSpaceProjection);
 
             //TODO: Better conversion to char*
             std::wstring ws(fileName);
@@ -258,9 +372,9 @@ namespace HoloLensForCV
             FILE* file = nullptr;
             ASSERT(0 == fopen_s(&file, outputFilePath.c_str(), "wb"));
 
-            size_t expectedSize = pointList.size() * sizeof(Windows::Foundation::Point);
+            size_t expectedSize = cameraSpaceProjection.size() * sizeof(float);
             ASSERT(expectedSize == fwrite(
-                reinterpret_cast<uint8_t*>(&pointList[0]),
+                reinterpret_cast<uint8_t*>(cameraSpaceProjection.data()),
                 sizeof(uint8_t),
                 expectedSize,
                 file));
@@ -270,6 +384,66 @@ namespace HoloLensForCV
         }
     }
 
+    void SensorFrameRecorder::ReportStorageCodecInformation(
+        _Inout_ std::vector<std::wstring>& sourceFiles)
+    {
+        wchar_t fileName[MAX_PATH] = {};
+
+        swprintf_s(
+            fileName,
+            L"%s\\storage_codec_information.csv",
+            _archiveSourceFolder->Path->Data());
+
+        sourceFiles.push_back(
+            L"storage_codec_information.csv");
+
+        CsvWriter csvWriter(
+            fileName);
+
+        {
+            std::vector<std::wstring> columns;
+
+            columns.push_back(L"SensorName");
+            columns.push_back(L"StorageCodec");
+
+            csvWriter.WriteHeader(
+                columns);
+        }
+
+        for (SensorFrameRecorderSink^ sensorFrameSink : _sensorFrameSinks)
+        {
+            if (nullptr == sensorFrameSink)
+            {
+                continue;
+            }
+
+            const wchar_t* storageCodecName = L"raw";
+
+            switch (sensorFrameSink->StorageCodec)
+            {
+            case SensorFrameStorageCodec::Lz4:
+                storageCodecName = L"lz4";
+                break;
+
+            case SensorFrameStorageCodec::Depth:
+                storageCodecName = L"depth";
+                break;
+            }
+
+            bool writeComma = false;
+
+            csvWriter.WriteText(
+                sensorFrameSink->GetSensorName()->Data(),
+                &writeComma);
+
+            csvWriter.WriteText(
+                storageCodecName,
+                &writeComma);
+
+            csvWriter.EndLine();
+        }
+    }
+
     ISensorFrameSink^ SensorFrameRecorder::GetSensorFrameSink(
         _In_ SensorType sensorType)
     {
@@ -33,7 +33,7 @@ namespace HoloLensForCV
 
         static property uint8_t RecordingVersionMinor
         {
-            uint8_t get() { return 0x01; }
+            uint8_t get() { return 0x02; }
         }
 
         void EnableAll();
@@ -41,6 +41,26 @@ namespace HoloLensForCV
         void Enable(
             _In_ SensorType sensorType);
 
+        //
+        // Selects the lossless codec used to store the frames of the given sensor.
+        // Frames are stored uncompressed unless specified otherwise. Must be
+        // called before StartAsync.
+        //
+        void SetStorageCodec(
+            _In_ SensorType sensorType,
+            _In_ SensorFrameStorageCodec storageCodec);
+
+        //
+        // Records the frame transforms to a binary pose log per sensor instead of
+        // formatting them as text while recording. The per-sensor CSV files are
+        // still produced when the recording stops. Must be set before StartAsync.
+        //
+        property bool PoseLogEnabled
+        {
+            bool get();
+            void set(bool value);
+        }
+
         Windows::Foundation::IAsyncAction^ StartAsync();
 
         void Stop();
@@ -60,11 +80,16 @@ namespace HoloLensForCV
         void ReportCameraCalibrationInformation(
             _Inout_ std::vector<std::wstring>& sourceFiles);
 
+        void ReportStorageCodecInformation(
+            _Inout_ std::vector<std::wstring>& sourceFiles);
+
     private:
         std::mutex _recorderMutex;
 
         Windows::Storage::StorageFolder^ _archiveSourceFolder;
 
         std::array<SensorFrameRecorderSink^, (size_t)SensorType::NumberOfSensorTypes> _sensorFrameSinks;
+        std::array<SensorFrameStorageCodec, (size_t)SensorType::NumberOfSensorTypes> _storageCodecs;
+        bool _poseLogEnabled;
     };
 }
@@ -17,12 +17,26 @@ namespace HoloLensForCV
 		_In_ SensorType sensorType,
 		_In_ Platform::String^ sensorName)
 		: _sensorType(sensorType), _sensorName(sensorName)
+		, _storageCodec(SensorFrameStorageCodec::Raw)
+		, _poseLogEnabled(false)
 	{
 	}
 
 	SensorFrameRecorderSink::~SensorFrameRecorderSink()
 	{
-		Stop();
+		//
+		// Destructors must not throw: failures are only reported by Stop.
+		//
+		try
+		{
+			Stop();
+		}
+		catch (Platform::Exception^)
+		{
+		}
+		catch (const std::exception&)
+		{
+		}
 	}
 
 	void SensorFrameRecorderSink::Start(
@@ -45,10 +59,131 @@ namespace HoloLensForCV
 				_sensorName->Data());
 			_bitmapTarball.reset(new Io::Tarball(fileName));
 		}
+
+		// Create the index of the bitmaps in the tarball.
+
+		{
+			wchar_t fileName[MAX_PATH] = {};
+			swprintf_s(
+				fileName,
+				L"%s\\%s.tar.idx",
+				_archiveSourceFolder->Path->Data(),
+				_sensorName->Data());
+			_bitmapIndex.reset(new Io::TarIndexWriter(fileName));
+		}
 		
 
-		// Create the csv file for the frame information.
+		// Create the binary pose log or the csv file for the frame information.
 
+		if (_poseLogEnabled)
+		{
+			wchar_t fileName[MAX_PATH] = {};
+			swprintf_s(
+				fileName,
+				L"%s\\%s.poselog",
+				_archiveSourceFolder->Path->Data(),
+				_sensorName->Data());
+			_poseLog.reset(new Io::PoseLogWriter(fileName));
+			_poseLogCodecs.clear();
+		}
+		else
+		{
+			CreateCsvWriter();
+		}
+
+		// Start the writer thread that will drain the pending frames queue.
+		_writeQueue.Start(
+			[this](SensorFrame^& sensorFrame, uint64_t* bytesWritten)
+		{
+			try
+			{
+				*bytesWritten += WriteFrame(sensorFrame);
+				return true;
+			}
+			catch (Platform::Exception^ exception)
+			{
+				//
+				// The media frame reader may have recycled the bitmap while the
+				// frame was waiting in the queue. Failures to write the files
+				// are std::exceptions, which mark the queue as failed.
+				//
+#if DBG_ENABLE_ERROR_LOGGING
+				dbg::trace(
+					L"SensorFrameRecorderSink::WriteFrame: failed to write a %s frame: %s",
+					_sensorName->Data(),
+					exception->Message->Data());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+				return false;
+			}
+		});
+	}
+
+	void SensorFrameRecorderSink::Stop()
+	{
+		// Let the writer thread drain the queue before closing the files.
+		_writeQueue.Stop();
+
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+
+		if (nullptr == _archiveSourceFolder)
+		{
+			return;
+		}
+
+		if (_writeQueue.HasFailed())
+		{
+			//
+			// The files are incomplete. Release them without reporting further
+			// errors, and report the one that interrupted the recording.
+			//
+			const std::wstring failureMessage =
+				Utf8ToUtf16(_writeQueue.GetFailureMessage());
+
+#if DBG_ENABLE_ERROR_LOGGING
+			dbg::trace(
+				L"SensorFrameRecorderSink::Stop: the %s recording failed: %s",
+				_sensorName->Data(),
+				failureMessage.c_str());
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+			_bitmapTarball.reset();
+			_bitmapIndex.reset();
+			_csvWriter.reset();
+			_poseLog.reset();
+			_poseLogCodecs.clear();
+
+			_archiveSourceFolder = nullptr;
+
+			throw ref new Platform::FailureException(
+				ref new Platform::String(failureMessage.c_str()));
+		}
+
+		// Close the tarball explicitly, so that a failure to complete it
+		// reaches the caller instead of being ignored by its destructor.
+		if (nullptr != _bitmapTarball)
+		{
+			_bitmapTarball->Close();
+		}
+
+		_bitmapTarball.reset();
+		_bitmapIndex.reset();
+		_csvWriter.reset();
+
+		if (nullptr != _poseLog)
+		{
+			_poseLog->Close();
+			_poseLog.reset();
+
+			// Keep the csv manifest for the tools that consume it.
+			ExportPoseLogToCsv();
+		}
+
+		_archiveSourceFolder = nullptr;
+	}
+
+	void SensorFrameRecorderSink::CreateCsvWriter()
+	{
 		{
 			wchar_t fileName[MAX_PATH] = {};
 			swprintf_s(
@@ -86,12 +221,111 @@ namespace HoloLensForCV
 		}
 	}
 
-	void SensorFrameRecorderSink::Stop()
+	void SensorFrameRecorderSink::ExportPoseLogToCsv()
 	{
-		std::lock_guard<std::mutex> guard(_sinkMutex);
-		_bitmapTarball.reset();
+		wchar_t fileName[MAX_PATH] = {};
+
+		swprintf_s(
+			fileName,
+			L"%s\\%s.poselog",
+			_archiveSourceFolder->Path->Data(),
+			_sensorName->Data());
+
+		Io::PoseLogReader poseLog(fileName);
+
+		// Every record of the pose log was preceded by the codec of its bitmap.
+		ASSERT(poseLog.GetRecordCount() <= _poseLogCodecs.size());
+
+		CreateCsvWriter();
+
+		static_assert(
+			sizeof(Windows::Foundation::Numerics::float4x4) == sizeof(Io::PoseLogRecord::FrameToOrigin),
+			"The pose log matrices must have the layout of float4x4.");
+
+		for (size_t i = 0; i < poseLog.GetRecordCount(); ++i)
+		{
+			const Io::PoseLogRecord& record = poseLog.GetRecord(i);
+
+			wchar_t bitmapPath[MAX_PATH];
+			ComposeBitmapPath(record.Timestamp, _poseLogCodecs[i], bitmapPath);
+
+			Windows::Foundation::Numerics::float4x4 frameToOrigin;
+			Windows::Foundation::Numerics::float4x4 cameraViewTransform;
+			Windows::Foundation::Numerics::float4x4 cameraProjectionTransform;
+
+			memcpy(&frameToOrigin, record.FrameToOrigin, sizeof(frameToOrigin));
+			memcpy(&cameraViewTransform, record.CameraViewTransform, sizeof(cameraViewTransform));
+			memcpy(&cameraProjectionTransform, record.CameraProjectionTransform, sizeof(cameraProjectionTransform));
+
+			WriteCsvRecord(
+				record.Timestamp,
+				bitmapPath,
+				frameToOrigin,
+				cameraViewTransform,
+				cameraProjectionTransform);
+		}
+
 		_csvWriter.reset();
-		_archiveSourceFolder = nullptr;
+
+		_poseLogCodecs.clear();
+		_poseLogCodecs.shrink_to_fit();
+	}
+
+	bool SensorFrameRecorderSink::PoseLogEnabled::get()
+	{
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+		return _poseLogEnabled;
+	}
+
+	void SensorFrameRecorderSink::PoseLogEnabled::set(
+		bool value)
+	{
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+
+		REQUIRES(nullptr == _archiveSourceFolder);
+		_poseLogEnabled = value;
+	}
+
+	SensorFrameStorageCodec SensorFrameRecorderSink::StorageCodec::get()
+	{
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+		return _storageCodec;
+	}
+
+	void SensorFrameRecorderSink::StorageCodec::set(
+		SensorFrameStorageCodec value)
+	{
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+
+		// The codec cannot change in the middle of a recording.
+		REQUIRES(nullptr == _archiveSourceFolder);
+		_storageCodec = value;
+	}
+
+	uint32_t SensorFrameRecorderSink::MaxQueueDepth::get()
+	{
+		return static_cast<uint32_t>(_writeQueue.GetMaximumDepth());
+	}
+
+	void SensorFrameRecorderSink::MaxQueueDepth::set(
+		uint32_t value)
+	{
+		_writeQueue.SetMaximumDepth(value);
+	}
+
+	uint32_t SensorFrameRecorderSink::QueueDepth::get()
+	{
+		return static_cast<uint32_t>(_writeQueue.GetDepth());
+	}
+
+	uint64_t SensorFrameRecorderSink::DroppedFrames::get()
+	{
+		return _writeQueue.GetDroppedItems();
+	}
+
+	uint64_t SensorFrameRecorderSink::BytesWritten::get()
+	{
+		return _writeQueue.GetBytesWritten();
 	}
 
 	Platform::String^ SensorFrameRecorderSink::GetSensorName()
@@ -107,6 +341,8 @@ namespace HoloLensForCV
 	void SensorFrameRecorderSink::ReportArchiveSourceFiles(
 		_Inout_ std::vector<std::wstring>& sourceFiles)
 	{
+		std::lock_guard<std::mutex> guard(_sinkMutex);
+
 		wchar_t csvFileName[MAX_PATH] = {};
 
 		swprintf_s(
@@ -115,34 +351,55 @@ namespace HoloLensForCV
 			_sensorName->Data());
 
 		sourceFiles.push_back(csvFileName);
+
+		if (_poseLogEnabled)
+		{
+			wchar_t poseLogFileName[MAX_PATH] = {};
+
+			swprintf_s(
+				poseLogFileName,
+				L"%s.poselog",
+				_sensorName->Data());
+
+			sourceFiles.push_back(poseLogFileName);
+		}
 	}
 
 	void SensorFrameRecorderSink::Send(
 		SensorFrame^ sensorFrame)
 	{
-		dbg::TimerGuard timerGuard(
-			L"SensorFrameRecorderSink::Send: synchrounous I/O",
-			20.0 /* minimum_time_elapsed_in_milliseconds */);
+		{
+			std::lock_guard<std::mutex> lockGuard(_sinkMutex);
 
-		std::lock_guard<std::mutex> lockGuard(_sinkMutex);
+			if (nullptr == _archiveSourceFolder)
+			{
+				return;
+			}
 
-		if (nullptr == _archiveSourceFolder)
-		{
-			return;
-		}
+			// Store a reference to the camera intrinsics.
+			if (nullptr == _cameraIntrinsics)
+			{
+				_cameraIntrinsics = sensorFrame->SensorStreamingCameraIntrinsics;
+			}
 
-		// Store a reference to the camera intrinsics.
-		if (nullptr == _cameraIntrinsics)
-		{
-			_cameraIntrinsics = sensorFrame->SensorStreamingCameraIntrinsics;
-		}
+			// Avoid duplicate sensor frame recordings.
+			if (_prevFrameTimestamp.Equals(sensorFrame->Timestamp)) {
+				return;
+			}
 
-		// Avoid duplicate sensor frame recordings.
-		if (_prevFrameTimestamp.Equals(sensorFrame->Timestamp)) {
-			return;
+			_prevFrameTimestamp = sensorFrame->Timestamp;
 		}
 
-		_prevFrameTimestamp = sensorFrame->Timestamp;
+		// The oldest pending frame is dropped if the queue is full.
+		_writeQueue.Push(sensorFrame);
+	}
+
+	uint64_t SensorFrameRecorderSink::WriteFrame(
+		_In_ SensorFrame^ sensorFrame)
+	{
+		dbg::TimerGuard timerGuard(
+			L"SensorFrameRecorderSink::WriteFrame: synchronous I/O",
+			20.0 /* minimum_time_elapsed_in_milliseconds */);
 
 		//
 		// Write the sensor frame as a bitmap to the archive.
@@ -161,12 +418,14 @@ namespace HoloLensForCV
 
 		int maxBitmapValue = 0;
 		int actualBitmapWidth = softwareBitmap->PixelWidth;
+		Io::TarIndexPixelFormat storedPixelFormat = Io::TarIndexPixelFormat::Gray8;
 
 		switch (softwareBitmap->BitmapPixelFormat)
 		{
 
 		case Windows::Graphics::Imaging::BitmapPixelFormat::Gray16:
 			maxBitmapValue = 65535;
+			storedPixelFormat = Io::TarIndexPixelFormat::Gray16;
 			break;
 
 		case Windows::Graphics::Imaging::BitmapPixelFormat::Gray8:
@@ -185,6 +444,7 @@ namespace HoloLensForCV
             else if (_sensorType == SensorType::PhotoVideo)
             {
                 maxBitmapValue = 255;
+                storedPixelFormat = Io::TarIndexPixelFormat::Rgb8;
             }
 			else
 			{
@@ -206,33 +466,32 @@ namespace HoloLensForCV
 
         // Determine which bitmap format to use.
         std::string bitmapFormat;
-        std::wstring bitmapFileExtension;
         if (_sensorType == SensorType::PhotoVideo)
         {
             bitmapFormat = "P6";
-            bitmapFileExtension = L"ppm";
         }
         else 
         {
             bitmapFormat = "P5";
-            bitmapFileExtension = L"pgm";
         }
 
         // Compose the output file name.
         wchar_t bitmapPath[MAX_PATH];
-        swprintf_s(
-            bitmapPath, L"%s\\%020llu.%s",
-            _sensorName->Data(),
+        ComposeBitmapPath(
             sensorFrame->Timestamp.UniversalTime,
-            bitmapFileExtension.c_str());
+            Io::FrameCodec::Raw,
+            bitmapPath);
 
 		// Compose PGM header string.
-		std::stringstream header;
-		header << bitmapFormat << "\n"
-			<< actualBitmapWidth << " "
-			<< softwareBitmap->PixelHeight << "\n"
-			<< maxBitmapValue << "\n";
-		const std::string headerString = header.str();
+		char headerString[64] = {};
+		const int headerStringLength = sprintf_s(
+			headerString,
+			"%s\n%i %i\n%i\n",
+			bitmapFormat.c_str(),
+			actualBitmapWidth,
+			softwareBitmap->PixelHeight,
+			maxBitmapValue);
+		ASSERT(headerStringLength > 0);
 
 		// Get bitmap buffer object of the frame.
 		Windows::Graphics::Imaging::BitmapBuffer^ bitmapBuffer =
@@ -246,69 +505,180 @@ namespace HoloLensForCV
 				bitmapBuffer->CreateReference(),
 				pixelBufferDataLength);
 
-        // Convert the software bitmap to raw bytes.
-        std::vector<uint8_t> bitmapData;
+		// The bitmap file is the header followed by the pixels, which are
+		// handed to the tarball without being copied into a single buffer.
+		Io::TarballFileSpan bitmapSpans[2] = {};
+
+		bitmapSpans[0].Data = reinterpret_cast<const uint8_t*>(headerString);
+		bitmapSpans[0].Size = static_cast<size_t>(headerStringLength);
+
         if (_sensorType == SensorType::PhotoVideo)
         {
             const uint32_t numPixels = softwareBitmap->PixelWidth * softwareBitmap->PixelHeight;
 
-            // Allocate data for PGM bitmap file.
-            bitmapData.reserve(headerString.size() + numPixels * 3);
+            // Drop the alpha channel and swap to RGB order for the PPM file.
+            _bitmapConversionBuffer.resize(numPixels * 3);
 
-            // Add PGM header data.
-            bitmapData.insert(
-                bitmapData.end(),
-                headerString.c_str(), headerString.c_str() + headerString.size());
+            uint8_t* rgbData = _bitmapConversionBuffer.data();
 
-            for (uint32_t i = 0; i < numPixels; ++i)
-            {
-                for (uint32_t j = 0; j < 3; ++j)
-                {
-                    bitmapData.push_back(pixelBufferData[i * 4 + 2 - j]);
-                }
-            }
+            Io::PackBgraToRgb(
+                pixelBufferData,
+                numPixels,
+                rgbData);
+
+            bitmapSpans[1].Data = rgbData;
+            bitmapSpans[1].Size = _bitmapConversionBuffer.size();
         }
         else
         {
-            // Allocate data for PGM bitmap file.
-            bitmapData.reserve(headerString.size() + pixelBufferDataLength);
-
-            // Add PGM header data.
-            bitmapData.insert(
-                bitmapData.end(),
-                headerString.c_str(), headerString.c_str() + headerString.size());
-
-            // Add raw pixel data.
-            bitmapData.insert(
-                bitmapData.end(),
-                pixelBufferData, pixelBufferData + pixelBufferDataLength);
+            bitmapSpans[1].Data = pixelBufferData;
+            bitmapSpans[1].Size = pixelBufferDataLength;
         }
 
+		const size_t pixelDataSize = bitmapSpans[1].Size;
+
+		// Compress the bitmap if requested. Frames that do not compress are
+		// stored as is.
+		Io::FrameCodec storedCodec = Io::FrameCodec::Raw;
+
+		if (SensorFrameStorageCodec::Raw != _storageCodec)
+		{
+			storedCodec = _frameCompressor.Compress(
+				(SensorFrameStorageCodec::Depth == _storageCodec) ?
+					Io::FrameCodec::Depth : Io::FrameCodec::Lz4,
+				bitmapSpans[0].Data,
+				bitmapSpans[0].Size,
+				bitmapSpans[1].Data,
+				bitmapSpans[1].Size,
+				softwareBitmap->PixelHeight,
+				Io::TarIndexPixelFormat::Gray16 == storedPixelFormat);
+		}
+
+		size_t numberOfBitmapSpans = 2;
+
+		if (Io::FrameCodec::Raw != storedCodec)
+		{
+			bitmapSpans[0].Data = _frameCompressor.GetData();
+			bitmapSpans[0].Size = _frameCompressor.GetSize();
+			numberOfBitmapSpans = 1;
+
+			ComposeBitmapPath(
+				sensorFrame->Timestamp.UniversalTime,
+				storedCodec,
+				bitmapPath);
+		}
+
 		// Add the bitmap to the tarball.
-		_bitmapTarball->AddFile(bitmapPath, bitmapData.data(), bitmapData.size());
+		const uint64_t bitmapDataOffset =
+			_bitmapTarball->AddFile(bitmapPath, bitmapSpans, numberOfBitmapSpans);
+
+		size_t bitmapDataSize = 0;
+
+		for (size_t i = 0; i < numberOfBitmapSpans; ++i)
+		{
+			bitmapDataSize += bitmapSpans[i].Size;
+		}
+
+		// Index the bitmap so that it can be read back without unpacking.
+		{
+			Io::TarIndexRecord indexRecord = {};
+
+			indexRecord.Timestamp = sensorFrame->Timestamp.UniversalTime;
+			indexRecord.DataOffset = bitmapDataOffset;
+			indexRecord.DataSize = bitmapDataSize;
+			indexRecord.PixelDataOffset = (Io::FrameCodec::Raw == storedCodec) ?
+				static_cast<uint32_t>(headerStringLength) : 0;
+			indexRecord.PixelFormat = static_cast<uint32_t>(storedPixelFormat);
+			indexRecord.ImageWidth = actualBitmapWidth;
+			indexRecord.ImageHeight = softwareBitmap->PixelHeight;
+			indexRecord.RowStride = static_cast<uint32_t>(
+				pixelDataSize / softwareBitmap->PixelHeight);
+			indexRecord.Codec = static_cast<uint32_t>(storedCodec);
+
+			_bitmapIndex->AddRecord(indexRecord);
+		}
 
 		//
-		// Record the sensor frame meta data to the csv file.
+		// Record the sensor frame meta data to the pose log or the csv file.
 		//
 
-		bool writeComma = false;
+		if (nullptr != _poseLog)
+		{
+			static_assert(
+				sizeof(Windows::Foundation::Numerics::float4x4) == sizeof(Io::PoseLogRecord::FrameToOrigin),
+				"The pose log matrices must have the layout of float4x4.");
 
-		_csvWriter->WriteUInt64(
-			sensorFrame->Timestamp.UniversalTime, &writeComma);
+			Io::PoseLogRecord poseLogRecord;
 
+			poseLogRecord.Timestamp = sensorFrame->Timestamp.UniversalTime;
+
+			const Windows::Foundation::Numerics::float4x4 frameToOrigin =
+				sensorFrame->FrameToOrigin;
+			const Windows::Foundation::Numerics::float4x4 cameraViewTransform =
+				sensorFrame->CameraViewTransform;
+			const Windows::Foundation::Numerics::float4x4 cameraProjectionTransform =
+				sensorFrame->CameraProjectionTransform;
+
+			memcpy(poseLogRecord.FrameToOrigin, &frameToOrigin, sizeof(frameToOrigin));
+			memcpy(poseLogRecord.CameraViewTransform, &cameraViewTransform, sizeof(cameraViewTransform));
+			memcpy(poseLogRecord.CameraProjectionTransform, &cameraProjectionTransform, sizeof(cameraProjectionTransform));
+
+			// The file names of the CSV export depend on the codec.
+			_poseLogCodecs.push_back(storedCodec);
+
+			_poseLog->AddRecord(poseLogRecord);
+		}
+		else
 		{
-			_csvWriter->WriteText(
-				bitmapPath, &writeComma);
+			WriteCsvRecord(
+				sensorFrame->Timestamp.UniversalTime,
+				bitmapPath,
+				sensorFrame->FrameToOrigin,
+				sensorFrame->CameraViewTransform,
+				sensorFrame->CameraProjectionTransform);
 		}
 
+		return bitmapDataSize;
+	}
+
+	void SensorFrameRecorderSink::ComposeBitmapPath(
+		_In_ uint64_t timestamp,
+		_In_ Io::FrameCodec codec,
+		_Out_writes_(MAX_PATH) wchar_t* bitmapPath)
+	{
+		swprintf_s(
+			bitmapPath,
+			MAX_PATH,
+			L"%s\\%020llu.%s%s",
+			_sensorName->Data(),
+			timestamp,
+			(_sensorType == SensorType::PhotoVideo) ? L"ppm" : L"pgm",
+			Io::GetFrameCodecFileExtension(codec));
+	}
+
+	void SensorFrameRecorderSink::WriteCsvRecord(
+		_In_ uint64_t timestamp,
+		_In_ const wchar_t* bitmapPath,
+		_In_ const Windows::Foundation::Numerics::float4x4& frameToOrigin,
+		_In_ const Windows::Foundation::Numerics::float4x4& cameraViewTransform,
+		_In_ const Windows::Foundation::Numerics::float4x4& cameraProjectionTransform)
+	{
+		bool writeComma = false;
+
+		_csvWriter->WriteUInt64(
+			timestamp, &writeComma);
+
+		_csvWriter->WriteText(
+			bitmapPath, &writeComma);
+
 		_csvWriter->WriteFloat4x4(
-			sensorFrame->FrameToOrigin, &writeComma);
+			frameToOrigin, &writeComma);
 
 		_csvWriter->WriteFloat4x4(
-			sensorFrame->CameraViewTransform, &writeComma);
+			cameraViewTransform, &writeComma);
 
 		_csvWriter->WriteFloat4x4(
-			sensorFrame->CameraProjectionTransform, &writeComma);
+			cameraProjectionTransform, &writeComma);
 
 		_csvWriter->EndLine();
 	}
@@ -20,6 +20,16 @@ namespace HoloLensForCV
 	// metadata that will be used to create the per-sensor recording manifest CSV
 	// file.
 	//
+	// Send only queues a reference to the sensor frame in an Io::WriteBehindQueue;
+	// the bitmap encoding and the tarball and CSV writes happen on its writer
+	// thread, so that a disk stall does not block the frame arrival thread. When
+	// the queue is full, the oldest pending frame is dropped. If a write fails,
+	// the remaining frames are dropped and Stop reports the failure.
+	//
+	// When the pose log is enabled, the frame transforms are appended to a binary
+	// Io::PoseLogWriter file instead of being formatted as text, and the CSV file
+	// is exported from the pose log once the recording stops.
+	//
 	public ref class SensorFrameRecorderSink sealed
 		: public ISensorFrameSink
 	{
@@ -30,10 +40,65 @@ namespace HoloLensForCV
 
 		void Start(_In_ Windows::Storage::StorageFolder^ archiveSourceFolder);
 
+		// Throws a Platform::FailureException once the files are closed if
+		// frames could not be written during the recording.
 		void Stop();
 
 		virtual void Send(_In_ SensorFrame^ sensorFrame);
 
+		//
+		// Lossless codec used to store the frames. Must be set before Start.
+		//
+		property SensorFrameStorageCodec StorageCodec
+		{
+			SensorFrameStorageCodec get();
+			void set(SensorFrameStorageCodec value);
+		}
+
+		//
+		// Write the frame transforms to a binary pose log (<sensor>.poselog)
+		// during the recording. Must be set before Start.
+		//
+		property bool PoseLogEnabled
+		{
+			bool get();
+			void set(bool value);
+		}
+
+		//
+		// Maximum number of frames waiting to be written to disk.
+		//
+		property uint32_t MaxQueueDepth
+		{
+			uint32_t get();
+			void set(uint32_t value);
+		}
+
+		//
+		// Number of frames currently waiting to be written to disk.
+		//
+		property uint32_t QueueDepth
+		{
+			uint32_t get();
+		}
+
+		//
+		// Number of frames that were not recorded, either because the queue was
+		// full or because the frame was closed before the writer got to it.
+		//
+		property uint64_t DroppedFrames
+		{
+			uint64_t get();
+		}
+
+		//
+		// Number of bitmap bytes added to the tarball since the sink was created.
+		//
+		property uint64_t BytesWritten
+		{
+			uint64_t get();
+		}
+
 	internal:
 		Platform::String^ GetSensorName();
 
@@ -45,16 +110,52 @@ namespace HoloLensForCV
 	private:
 		~SensorFrameRecorderSink();
 
+		// Returns the number of bitmap bytes added to the tarball.
+		uint64_t WriteFrame(
+			_In_ SensorFrame^ sensorFrame);
+
+		void ComposeBitmapPath(
+			_In_ uint64_t timestamp,
+			_In_ Io::FrameCodec codec,
+			_Out_writes_(MAX_PATH) wchar_t* bitmapPath);
+
+		void CreateCsvWriter();
+
+		void WriteCsvRecord(
+			_In_ uint64_t timestamp,
+			_In_ const wchar_t* bitmapPath,
+			_In_ const Windows::Foundation::Numerics::float4x4& frameToOrigin,
+			_In_ const Windows::Foundation::Numerics::float4x4& cameraViewTransform,
+			_In_ const Windows::Foundation::Numerics::float4x4& cameraProjectionTransform);
+
+		void ExportPoseLogToCsv();
+
 		Platform::String^ _sensorName;
 
 		SensorType _sensorType;
 
+		SensorFrameStorageCodec _storageCodec;
+		bool _poseLogEnabled;
+
 		std::mutex _sinkMutex;
 
+		Io::WriteBehindQueue<SensorFrame^> _writeQueue;
+
 		Windows::Storage::StorageFolder^ _archiveSourceFolder;
 
 		std::unique_ptr<Io::Tarball> _bitmapTarball;
+		std::unique_ptr<Io::TarIndexWriter> _bitmapIndex;
 		std::unique_ptr<CsvWriter> _csvWriter;
+		std::unique_ptr<Io::PoseLogWriter> _poseLog;
+
+		// Codec of the bitmap of each pose log record, in the same order, so
+		// that the CSV export does not have to read the tarball back.
+		std::vector<Io::FrameCodec> _poseLogCodecs;
+
+		// Scratch space for pixel format conversions and compression, owned
+		// by the writer thread.
+		std::vector<uint8_t> _bitmapConversionBuffer;
+		Io::FrameCompressor _frameCompressor;
 
 		CameraIntrinsics^ _cameraIntrinsics;
 
@@ -0,0 +1,23 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Fixed-capacity history of the most recent frames of a single sensor, read
+    // without locks by the render and computer vision threads while the media
+    // frame reader of the sensor pushes new frames. See Io::FrameRing.
+    //
+    typedef Io::FrameRing<SensorFrame^> SensorFrameRing;
+}
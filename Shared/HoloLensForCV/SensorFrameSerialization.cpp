@@ -0,0 +1,602 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+namespace HoloLensForCV
+{
+    namespace
+    {
+        uint32_t GetBytesPerPixel(
+            _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat)
+        {
+            switch (pixelFormat)
+            {
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8:
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Rgba8:
+                return 4;
+
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Rgba16:
+                return 8;
+
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Gray16:
+                return 2;
+
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Gray8:
+                return 1;
+
+            default:
+                // Planar formats can't be described by a row stride alone.
+                return 0;
+            }
+        }
+
+        //
+        // Pixel format and width of a received image.
+        //
+        void GetReceivedImageFormat(
+            _In_ SensorFrameStreamHeader^ header,
+            _In_opt_ const Io::FrameHeaderExtensions* extensions,
+            _Out_ Windows::Graphics::Imaging::BitmapPixelFormat* pixelFormat,
+            _Out_ uint32_t* imageWidth)
+        {
+            *imageWidth = header->ImageWidth;
+
+            if (nullptr != extensions && extensions->HasPixelFormat)
+            {
+                *pixelFormat =
+                    (Windows::Graphics::Imaging::BitmapPixelFormat)extensions->PixelFormat;
+
+                const uint32_t bytesPerPixel =
+                    GetBytesPerPixel(
+                        *pixelFormat);
+
+                if (0 == bytesPerPixel || 0 != header->RowStride % bytesPerPixel)
+                {
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"DeserializeSensorFrameAsync: unsupported pixel format %u for a row stride of %u bytes",
+                        extensions->PixelFormat,
+                        header->RowStride);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    throw ref new Platform::FailureException();
+                }
+
+                //
+                // Images are tightly packed, and the pixel format may differ from the
+                // one the pixels were sent in (e.g. for the visible light cameras).
+                //
+                *imageWidth =
+                    header->RowStride / bytesPerPixel;
+            }
+            else
+            {
+                switch (header->FrameType)
+                {
+                case SensorType::PhotoVideo:
+                    *pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8;
+                    break;
+
+                case SensorType::ShortThrowToFDepth:
+                case SensorType::LongThrowToFDepth:
+                    *pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray16;
+                    break;
+
+                case SensorType::ShortThrowToFReflectivity:
+                case SensorType::LongThrowToFReflectivity:
+                    *pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray8;
+                    break;
+
+                case SensorType::VisibleLightLeftLeft:
+                case SensorType::VisibleLightLeftFront:
+                case SensorType::VisibleLightRightFront:
+                case SensorType::VisibleLightRightRight:
+                    *pixelFormat = Windows::Graphics::Imaging::BitmapPixelFormat::Gray8;
+                    *imageWidth = header->ImageWidth * 4;
+                    break;
+
+                default:
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"DeserializeSensorFrameAsync: unrecognized sensor type %i",
+                        header->FrameType);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    throw ref new Platform::FailureException();
+                }
+            }
+        }
+
+        SensorFrame^ CreateSensorFrame(
+            _In_ SensorFrameStreamHeader^ header,
+            _In_ Windows::Graphics::Imaging::SoftwareBitmap^ imageAsSoftwareBitmap)
+        {
+            //
+            // Timestamps on the wire are encoded as universal time
+            //
+            Windows::Foundation::DateTime frameTimestamp;
+
+            frameTimestamp.UniversalTime =
+                header->Timestamp;
+
+            return ref new SensorFrame(
+                header->FrameType,
+                frameTimestamp,
+                imageAsSoftwareBitmap);
+        }
+
+        //
+        // Restores a losslessly compressed image.
+        //
+        void DecompressImage(
+            _In_ SensorFrameStreamHeader^ header,
+            _In_ Windows::Storage::Streams::IBuffer^ payload,
+            _In_opt_ SensorFrameDeltaDecoder* deltaDecoder,
+            _Out_writes_(header->ImageHeight * header->RowStride) uint8_t* pixels)
+        {
+            if (SensorFrameStreamingCodec::Delta != header->Codec)
+            {
+                DecompressSensorFrame(
+                    header,
+                    Io::GetTypedPointerToIBuffer<uint8_t>(payload),
+                    payload->Length,
+                    pixels);
+
+                return;
+            }
+
+            if (nullptr == deltaDecoder)
+            {
+#if DBG_ENABLE_ERROR_LOGGING
+                dbg::trace(
+                    L"DeserializeSensorFrameAsync: no delta decoder for a frame of sensor %i",
+                    header->FrameType);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                throw ref new Platform::FailureException();
+            }
+
+            deltaDecoder->Decompress(
+                header,
+                Io::GetTypedPointerToIBuffer<uint8_t>(payload),
+                payload->Length,
+                pixels);
+        }
+
+        //
+        // Writes the image straight into a bitmap of the pool. Returns nullptr if
+        // the bitmap isn't laid out like the received image.
+        //
+        SensorFrame^ CreatePooledSensorFrame(
+            _In_ SensorFrameStreamHeader^ header,
+            _In_ Windows::Storage::Streams::IBuffer^ payload,
+            _In_ Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat,
+            _In_ uint32_t imageWidth,
+            _Inout_ SoftwareBitmapPool& bitmapPool,
+            _In_opt_ SensorFrameDeltaDecoder* deltaDecoder)
+        {
+            Io::FramePoolKey key;
+
+            key.Width = imageWidth;
+            key.Height = header->ImageHeight;
+            key.Format = (int32_t)pixelFormat;
+
+            std::shared_ptr<Windows::Graphics::Imaging::SoftwareBitmap^> bitmapLease =
+                bitmapPool.Acquire(
+                    key);
+
+            Windows::Graphics::Imaging::BitmapBuffer^ bitmapBuffer =
+                (*bitmapLease)->LockBuffer(
+                    Windows::Graphics::Imaging::BitmapBufferAccessMode::Write);
+
+            Windows::Foundation::IMemoryBufferReference^ bitmapBufferReference =
+                bitmapBuffer->CreateReference();
+
+            uint32_t bitmapBufferDataSize = 0;
+
+            uint8_t* bitmapBufferData =
+                Io::GetTypedPointerToMemoryBuffer<uint8_t>(
+                    bitmapBufferReference,
+                    bitmapBufferDataSize);
+
+            const bool isTightlyPacked =
+                (int32_t)header->RowStride == bitmapBuffer->GetPlaneDescription(0).Stride &&
+                header->ImageHeight * header->RowStride == bitmapBufferDataSize;
+
+            if (isTightlyPacked)
+            {
+                if (SensorFrameStreamingCodec::Raw == header->Codec)
+                {
+                    memcpy(
+                        bitmapBufferData,
+                        Io::GetTypedPointerToIBuffer<uint8_t>(payload),
+                        bitmapBufferDataSize);
+                }
+                else
+                {
+                    DecompressImage(
+                        header,
+                        payload,
+                        deltaDecoder,
+                        bitmapBufferData);
+                }
+            }
+
+            //
+            // Unlock the bitmap, so that it can be read, and locked again when the
+            // pool hands it out for another frame.
+            //
+            delete bitmapBufferReference;
+            delete bitmapBuffer;
+
+            if (!isTightlyPacked)
+            {
+                return nullptr;
+            }
+
+            SensorFrame^ sensorFrame =
+                CreateSensorFrame(
+                    header,
+                    *bitmapLease);
+
+            sensorFrame->SetBitmapLease(
+                std::move(bitmapLease));
+
+            return sensorFrame;
+        }
+    }
+
+    Windows::Graphics::Imaging::SoftwareBitmap^ CreatePooledSoftwareBitmap(
+        _In_ const Io::FramePoolKey& key)
+    {
+        return ref new Windows::Graphics::Imaging::SoftwareBitmap(
+            (Windows::Graphics::Imaging::BitmapPixelFormat)key.Format,
+            key.Width,
+            key.Height,
+            Windows::Graphics::Imaging::BitmapAlphaMode::Ignore);
+    }
+
+    Windows::Graphics::Imaging::BitmapPixelFormat GetStreamingPixelFormat(
+        _In_ SensorFrame^ sensorFrame)
+    {
+        switch (sensorFrame->FrameType)
+        {
+        case SensorType::VisibleLightLeftLeft:
+        case SensorType::VisibleLightLeftFront:
+        case SensorType::VisibleLightRightFront:
+        case SensorType::VisibleLightRightRight:
+            return Windows::Graphics::Imaging::BitmapPixelFormat::Gray8;
+
+        default:
+            return sensorFrame->SoftwareBitmap->BitmapPixelFormat;
+        }
+    }
+
+    Windows::Storage::Streams::IBuffer^ SerializeSensorFrame(
+        _In_ SensorFrame^ sensorFrame,
+        _In_opt_ const std::vector<uint8_t>* extensionBlock,
+        _In_opt_ SensorFrameCompressor* compressor,
+        _Out_opt_ bool* isKeyframe)
+    {
+        Windows::Graphics::Imaging::SoftwareBitmap^ bitmap;
+        Windows::Graphics::Imaging::BitmapBuffer^ bitmapBuffer;
+        Windows::Foundation::IMemoryBufferReference^ bitmapBufferReference;
+
+        int32_t imageWidth = 0;
+        int32_t imageHeight = 0;
+        int32_t pixelStride = 1;
+        int32_t rowStride = 0;
+
+        int32_t imageBufferSize = 0;
+
+        Windows::Storage::Streams::DataWriter^ writer =
+            ref new Windows::Storage::Streams::DataWriter();
+
+        writer->ByteOrder =
+            Windows::Storage::Streams::ByteOrder::LittleEndian;
+
+        {
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+            dbg::TimerGuard timerGuard(
+                L"SerializeSensorFrame: buffer preparation",
+                4.0 /* minimum_time_elapsed_in_milliseconds */);
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+            bitmap =
+                sensorFrame->SoftwareBitmap;
+
+            imageWidth = bitmap->PixelWidth;
+            imageHeight = bitmap->PixelHeight;
+
+            bitmapBuffer =
+                bitmap->LockBuffer(
+                    Windows::Graphics::Imaging::BitmapBufferAccessMode::Read);
+
+            bitmapBufferReference =
+                bitmapBuffer->CreateReference();
+
+            uint32_t bitmapBufferDataSize = 0;
+
+            uint8_t* bitmapBufferData =
+                Io::GetTypedPointerToMemoryBuffer<uint8_t>(
+                    bitmapBufferReference,
+                    bitmapBufferDataSize);
+
+            switch (bitmap->BitmapPixelFormat)
+            {
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8:
+                pixelStride = 4;
+                break;
+
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Gray16:
+                pixelStride = 2;
+                break;
+
+            case Windows::Graphics::Imaging::BitmapPixelFormat::Gray8:
+                pixelStride = 1;
+                break;
+
+            default:
+#if DBG_ENABLE_INFORMATIONAL_LOGGING
+                dbg::trace(
+                    L"SerializeSensorFrame: unrecognized bitmap pixel format, assuming 1 byte per pixel");
+#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+
+                break;
+            }
+
+            rowStride =
+                imageWidth * pixelStride;
+
+            imageBufferSize =
+                imageHeight * rowStride;
+
+            ASSERT(
+                imageBufferSize == (int32_t)bitmapBufferDataSize);
+
+            SensorFrameStreamingCodec codec =
+                SensorFrameStreamingCodec::Raw;
+
+            Windows::Storage::Streams::IBuffer^ compressedImage;
+
+            bool isCompressedKeyframe = true;
+
+            if (nullptr != compressor)
+            {
+                compressedImage =
+                    compressor->Compress(
+                        GetStreamingPixelFormat(sensorFrame),
+                        bitmapBufferData,
+                        imageHeight,
+                        rowStride,
+                        &codec,
+                        &isCompressedKeyframe);
+            }
+
+            if (nullptr != isKeyframe)
+            {
+                *isKeyframe = isCompressedKeyframe;
+            }
+
+            SensorFrameStreamHeader^ header =
+                ref new SensorFrameStreamHeader();
+
+            header->FrameType = sensorFrame->FrameType;
+            header->Timestamp = sensorFrame->Timestamp.UniversalTime;
+            header->ImageWidth = imageWidth;
+            header->ImageHeight = imageHeight;
+            header->PixelStride = pixelStride;
+            header->RowStride = rowStride;
+
+            if (nullptr != extensionBlock)
+            {
+                ASSERT(extensionBlock->size() <= Io::FrameHeaderExtensionsMaximumLength);
+
+                header->ExtensionsLength = static_cast<uint32_t>(extensionBlock->size());
+            }
+
+            header->Codec = codec;
+            header->PayloadLength =
+                (nullptr != compressedImage) ? compressedImage->Length : imageBufferSize;
+
+            //
+            // Use the lowest protocol version that describes the frame.
+            //
+            if (SensorFrameStreamingCodec::Raw != codec)
+            {
+                header->VersionMinor = SensorFrameStreamHeader::ProtocolVersionMinor;
+            }
+            else if (nullptr != extensionBlock)
+            {
+                header->VersionMinor = SensorFrameStreamHeader::ProtocolVersionMinorWithoutCompression;
+            }
+            else
+            {
+                header->VersionMinor = SensorFrameStreamHeader::ProtocolVersionMinorWithoutExtensions;
+            }
+
+            SensorFrameStreamHeader::Write(
+                header,
+                writer);
+
+            if (nullptr != extensionBlock && !extensionBlock->empty())
+            {
+                writer->WriteBytes(
+                    Platform::ArrayReference<uint8_t>(
+                        const_cast<uint8_t*>(extensionBlock->data()),
+                        static_cast<uint32_t>(extensionBlock->size())));
+            }
+
+            if (nullptr != compressedImage)
+            {
+                writer->WriteBuffer(
+                    compressedImage);
+            }
+            else
+            {
+                //
+                // Copy the pixels straight from the locked bitmap buffer.
+                //
+                writer->WriteBytes(
+                    Platform::ArrayReference<uint8_t>(
+                        bitmapBufferData,
+                        imageBufferSize));
+            }
+        }
+
+        return writer->DetachBuffer();
+    }
+
+    bool IsPayloadLengthValid(
+        _In_ SensorFrameStreamHeader^ header)
+    {
+        const uint64_t imageSize =
+            static_cast<uint64_t>(header->ImageHeight) * header->RowStride;
+
+        if (imageSize > UINT32_MAX)
+        {
+            return false;
+        }
+
+        if (SensorFrameStreamingCodec::Raw == header->Codec)
+        {
+            return header->PayloadLength == imageSize;
+        }
+
+        if (SensorFrameStreamingCodec::Delta == header->Codec)
+        {
+            return
+                sizeof(SensorFrameDeltaHeader) <= header->PayloadLength &&
+                header->PayloadLength <= imageSize + sizeof(SensorFrameDeltaHeader);
+        }
+
+        return 0 < header->PayloadLength && header->PayloadLength < imageSize;
+    }
+
+    Concurrency::task<SensorFrame^> DeserializeSensorFrameAsync(
+        _In_ SensorFrameStreamHeader^ header,
+        _In_ Windows::Storage::Streams::IBuffer^ payload,
+        _In_opt_ const Io::FrameHeaderExtensions* extensions,
+        _In_opt_ SoftwareBitmapPool* bitmapPool,
+        _In_opt_ SensorFrameDeltaDecoder* deltaDecoder)
+    {
+        Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat;
+        uint32_t imageWidth = 0;
+
+        GetReceivedImageFormat(
+            header,
+            extensions,
+            &pixelFormat,
+            &imageWidth);
+
+        Windows::Storage::Streams::IBuffer^ image;
+
+        if (nullptr != bitmapPool &&
+            (SensorFrameStreamingCodec::Raw == header->Codec ||
+             SensorFrameStreamingCodec::Lz4 == header->Codec ||
+             SensorFrameStreamingCodec::Depth == header->Codec ||
+             SensorFrameStreamingCodec::Delta == header->Codec))
+        {
+            SensorFrame^ sensorFrame =
+                CreatePooledSensorFrame(
+                    header,
+                    payload,
+                    pixelFormat,
+                    imageWidth,
+                    *bitmapPool,
+                    deltaDecoder);
+
+            if (nullptr != sensorFrame)
+            {
+                return Concurrency::task_from_result(
+                    sensorFrame);
+            }
+        }
+
+        switch (header->Codec)
+        {
+        case SensorFrameStreamingCodec::Raw:
+            image = payload;
+            break;
+
+        case SensorFrameStreamingCodec::Lz4:
+        case SensorFrameStreamingCodec::Depth:
+        case SensorFrameStreamingCodec::Delta:
+        {
+            Windows::Storage::Streams::Buffer^ decompressedImage =
+                ref new Windows::Storage::Streams::Buffer(
+                    header->ImageHeight * header->RowStride);
+
+            DecompressImage(
+                header,
+                payload,
+                deltaDecoder,
+                Io::GetTypedPointerToIBuffer<uint8_t>(decompressedImage));
+
+            decompressedImage->Length =
+                decompressedImage->Capacity;
+
+            image = decompressedImage;
+            break;
+        }
+
+        case SensorFrameStreamingCodec::Jpeg:
+            return DecodeJpegSensorFrameAsync(
+                payload,
+                pixelFormat
+            ).then([header, imageWidth](Windows::Graphics::Imaging::SoftwareBitmap^ imageAsSoftwareBitmap)
+            {
+                if (imageWidth != (uint32_t)imageAsSoftwareBitmap->PixelWidth ||
+                    header->ImageHeight != (uint32_t)imageAsSoftwareBitmap->PixelHeight)
+                {
+#if DBG_ENABLE_ERROR_LOGGING
+                    dbg::trace(
+                        L"DeserializeSensorFrameAsync: expected a %ux%u JPEG image, got %ix%i",
+                        imageWidth,
+                        header->ImageHeight,
+                        imageAsSoftwareBitmap->PixelWidth,
+                        imageAsSoftwareBitmap->PixelHeight);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+                    throw ref new Platform::FailureException();
+                }
+
+                return CreateSensorFrame(
+                    header,
+                    imageAsSoftwareBitmap);
+            });
+
+        default:
+#if DBG_ENABLE_ERROR_LOGGING
+            dbg::trace(
+                L"DeserializeSensorFrameAsync: unrecognized codec %i",
+                header->Codec);
+#endif /* DBG_ENABLE_ERROR_LOGGING */
+
+            throw ref new Platform::FailureException();
+        }
+
+        Windows::Graphics::Imaging::SoftwareBitmap^ imageAsSoftwareBitmap =
+            Windows::Graphics::Imaging::SoftwareBitmap::CreateCopyFromBuffer(
+                image,
+                pixelFormat,
+                imageWidth,
+                header->ImageHeight,
+                Windows::Graphics::Imaging::BitmapAlphaMode::Ignore);
+
+        return Concurrency::task_from_result(
+            CreateSensorFrame(
+                header,
+                imageAsSoftwareBitmap));
+    }
+}
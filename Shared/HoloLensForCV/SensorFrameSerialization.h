@@ -0,0 +1,107 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Serializes a sensor frame for streaming: a SensorFrameStreamHeader followed
+    // by the image, tightly packed. Each frame is self-describing, so frames of
+    // different sensors can share a connection.
+    //
+    // The header is followed by the extension block, if one is given, and by
+    // the image, compressed if a compressor is given and the frame compresses.
+    // The header has the lowest version that can describe the frame.
+    //
+    // Frames that don't depend on previous frames are keyframes; only frames
+    // compressed with the Delta codec can be something else.
+    //
+    Windows::Storage::Streams::IBuffer^ SerializeSensorFrame(
+        _In_ SensorFrame^ sensorFrame,
+        _In_opt_ const std::vector<uint8_t>* extensionBlock = nullptr,
+        _In_opt_ SensorFrameCompressor* compressor = nullptr,
+        _Out_opt_ bool* isKeyframe = nullptr);
+
+    //
+    // Bitmaps recycled across received frames, by size and pixel format.
+    //
+    typedef Io::FramePool<Windows::Graphics::Imaging::SoftwareBitmap^> SoftwareBitmapPool;
+
+    //
+    // Creates a sensor frame from a received header and the payload following
+    // it, decompressing the image if need be. The pixel format is taken from the
+    // extensions, if they have one, and derived from the sensor type otherwise.
+    //
+    // Given a pool, raw and losslessly compressed images are received into a
+    // bitmap of the pool, which the frame holds on to until it is released.
+    //
+    // Frames compressed with the Delta codec need the delta decoder of their
+    // sensor, and must be deserialized in the order they were received.
+    //
+    Concurrency::task<SensorFrame^> DeserializeSensorFrameAsync(
+        _In_ SensorFrameStreamHeader^ header,
+        _In_ Windows::Storage::Streams::IBuffer^ payload,
+        _In_opt_ const Io::FrameHeaderExtensions* extensions = nullptr,
+        _In_opt_ SoftwareBitmapPool* bitmapPool = nullptr,
+        _In_opt_ SensorFrameDeltaDecoder* deltaDecoder = nullptr);
+
+    //
+    // Creates an empty bitmap for a SoftwareBitmapPool; the pool key format is a
+    // BitmapPixelFormat.
+    //
+    Windows::Graphics::Imaging::SoftwareBitmap^ CreatePooledSoftwareBitmap(
+        _In_ const Io::FramePoolKey& key);
+
+    //
+    // Checks the payload length of a received header against the size of its
+    // image: compressed images must be smaller than uncompressed ones, but for
+    // the keyframes of the Delta codec, which may be sent uncompressed.
+    //
+    bool IsPayloadLengthValid(
+        _In_ SensorFrameStreamHeader^ header);
+
+    //
+    // Pixel format of a frame's image on the wire. The visible light camera
+    // images are grayscale, but packed as 32bpp ARGB images: they are streamed as
+    // the Gray8 images they are.
+    //
+    Windows::Graphics::Imaging::BitmapPixelFormat GetStreamingPixelFormat(
+        _In_ SensorFrame^ sensorFrame);
+
+    //
+    // A serialized frame waiting in a send queue.
+    //
+    struct SerializedSensorFrame
+    {
+        Windows::Storage::Streams::IBuffer^ Buffer;
+
+        // Set when the frame carries its unprojection LUT. Later frames on the
+        // same connection only refer to the LUT once this one has been sent.
+        bool CarriesUnprojectionLut = false;
+    };
+
+    //
+    // On a multiplexed connection, serialized frames are split into chunks so that
+    // the frames of different sensors can be interleaved. Each chunk is preceded
+    // by a chunk header; the chunks of a sensor's frame are sent in order, and the
+    // last one is flagged. All fields are little endian:
+    //
+    //   uint16_t FrameType   -- the SensorType of the frame
+    //   uint16_t Flags       -- MultiplexedChunkFlagLast on the last chunk
+    //   uint32_t Length      -- number of bytes following the chunk header
+    //
+    const uint32_t MultiplexedChunkHeaderLength = 8;
+    const uint32_t MultiplexedChunkMaximumLength = 64 * 1024;
+
+    const uint16_t MultiplexedChunkFlagLast = 0x0001;
+}
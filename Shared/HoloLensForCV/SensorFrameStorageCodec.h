@@ -0,0 +1,31 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Lossless codecs the recorder can use to store sensor frames.
+    //
+    public enum class SensorFrameStorageCodec : int32_t
+    {
+        // Uncompressed PGM/PPM files.
+        Raw = 0,
+
+        // LZ4 compressed pixels (stored as <timestamp>.pgm.hlfc).
+        Lz4 = 1,
+
+        // Predictive coding of 16-bit depth and reflectivity images (stored as
+        // <timestamp>.pgm.hlfc). Other pixel formats fall back to LZ4.
+        Depth = 2
+    };
+}
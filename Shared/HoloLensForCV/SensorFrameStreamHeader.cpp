@@ -24,6 +24,30 @@ namespace HoloLensForCV
         ImageHeight = 0;
         PixelStride = 0;
         RowStride = 0;
+        ExtensionsLength = 0;
+        Codec = SensorFrameStreamingCodec::Raw;
+        PayloadLength = 0;
+    }
+
+    /* static */ uint32_t SensorFrameStreamHeader::GetProtocolExtendedHeaderLength(
+        _In_ uint8_t versionMinor)
+    {
+        uint32_t extendedHeaderLength = 0;
+
+        if (versionMinor >= ProtocolVersionMinorWithoutCompression)
+        {
+            extendedHeaderLength +=
+                sizeof(uint32_t) /* ExtensionsLength */;
+        }
+
+        if (versionMinor >= ProtocolVersionMinor)
+        {
+            extendedHeaderLength +=
+                sizeof(uint16_t) /* Codec */ +
+                sizeof(uint32_t) /* PayloadLength */;
+        }
+
+        return extendedHeaderLength;
     }
 
     /* static */ void SensorFrameStreamHeader::Read(
@@ -43,9 +67,28 @@ namespace HoloLensForCV
         header->PixelStride = dataReader->ReadUInt32();
         header->RowStride = dataReader->ReadUInt32();
 
+        header->PayloadLength =
+            header->ImageHeight * header->RowStride;
+
         *headerReference = header;
     }
 
+    /* static */ void SensorFrameStreamHeader::ReadExtendedFields(
+        _Inout_ Windows::Storage::Streams::DataReader^ dataReader,
+        _Inout_ SensorFrameStreamHeader^ header)
+    {
+        if (header->VersionMinor >= ProtocolVersionMinorWithoutCompression)
+        {
+            header->ExtensionsLength = dataReader->ReadUInt32();
+        }
+
+        if (header->VersionMinor >= ProtocolVersionMinor)
+        {
+            header->Codec = (SensorFrameStreamingCodec)dataReader->ReadUInt16();
+            header->PayloadLength = dataReader->ReadUInt32();
+        }
+    }
+
     /* static */ void SensorFrameStreamHeader::Write(
         _In_ SensorFrameStreamHeader^ header,
         _Inout_ Windows::Storage::Streams::DataWriter^ dataWriter)
@@ -59,5 +102,16 @@ namespace HoloLensForCV
         dataWriter->WriteUInt32(header->ImageHeight);
         dataWriter->WriteUInt32(header->PixelStride);
         dataWriter->WriteUInt32(header->RowStride);
+
+        if (header->VersionMinor >= ProtocolVersionMinorWithoutCompression)
+        {
+            dataWriter->WriteUInt32(header->ExtensionsLength);
+        }
+
+        if (header->VersionMinor >= ProtocolVersionMinor)
+        {
+            dataWriter->WriteUInt16((uint16_t)header->Codec);
+            dataWriter->WriteUInt32(header->PayloadLength);
+        }
     }
 }
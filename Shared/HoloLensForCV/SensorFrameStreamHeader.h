@@ -16,6 +16,21 @@ namespace HoloLensForCV
     //
     // Network header for sensor frame streaming.
     //
+    // Version 0.1 headers are directly followed by the image.
+    //
+    // Version 0.2 headers are followed by a uint32_t ExtensionsLength, and then
+    // by an extension block of that many bytes carrying the camera pose and
+    // intrinsics of the frame (see Io/FrameHeaderExtensions.h).
+    //
+    // Version 0.3 headers add a uint16_t Codec and a uint32_t PayloadLength after
+    // the ExtensionsLength: the image is sent compressed, as PayloadLength bytes.
+    // With the Delta codec, the image is preceded by a SensorFrameDeltaHeader
+    // (see SensorFrameCompression.h).
+    //
+    // Streaming servers send the lowest version that can describe the frame, so
+    // that older receivers keep working unless extensions or compression are
+    // enabled.
+    //
     public ref class SensorFrameStreamHeader sealed
     {
     public:
@@ -45,10 +60,27 @@ namespace HoloLensForCV
         }
 
         static property uint8_t ProtocolVersionMinor
+        {
+            uint8_t get() { return 0x03; }
+        }
+
+        static property uint8_t ProtocolVersionMinorWithoutExtensions
         {
             uint8_t get() { return 0x01; }
         }
 
+        static property uint8_t ProtocolVersionMinorWithoutCompression
+        {
+            uint8_t get() { return 0x02; }
+        }
+
+        //
+        // Length of the fields following the first ProtocolHeaderLength bytes of a
+        // header of the given version.
+        //
+        static uint32_t GetProtocolExtendedHeaderLength(
+            _In_ uint8_t versionMinor);
+
         property uint32_t Cookie;
         property uint8_t VersionMajor;
         property uint8_t VersionMinor;
@@ -59,10 +91,40 @@ namespace HoloLensForCV
         property uint32_t PixelStride;
         property uint32_t RowStride;
 
+        //
+        // Sent with version 0.2 headers and up.
+        //
+        property uint32_t ExtensionsLength;
+
+        property bool HasExtensions
+        {
+            bool get() { return VersionMinor >= ProtocolVersionMinorWithoutCompression; }
+        }
+
+        //
+        // Sent with version 0.3 headers. For earlier versions, the image is sent
+        // uncompressed and its length follows from the image size.
+        //
+        property SensorFrameStreamingCodec Codec;
+        property uint32_t PayloadLength;
+
+        //
+        // Reads the first ProtocolHeaderLength bytes of the header. The
+        // GetProtocolExtendedHeaderLength(VersionMinor) bytes that follow are
+        // read by ReadExtendedFields.
+        //
         static void Read(
             _Inout_ Windows::Storage::Streams::DataReader^ dataReader,
             _Out_ SensorFrameStreamHeader^* header);
 
+        static void ReadExtendedFields(
+            _Inout_ Windows::Storage::Streams::DataReader^ dataReader,
+            _Inout_ SensorFrameStreamHeader^ header);
+
+        //
+        // Writes the header, including the fields of its version. The extension
+        // block and the payload are up to the caller.
+        //
         static void Write(
             _In_ SensorFrameStreamHeader^ header,
             _Inout_ Windows::Storage::Streams::DataWriter^ dataWriter);
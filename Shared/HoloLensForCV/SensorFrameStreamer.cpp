@@ -13,8 +13,72 @@
 
 namespace HoloLensForCV
 {
+    namespace
+    {
+        //
+        // Port of a sensor's stream, or nullptr for sensors that can't be
+        // streamed.
+        //
+        Platform::String^ GetStreamingServiceName(
+            _In_ SensorType sensorType)
+        {
+            switch (sensorType)
+            {
+            case SensorType::PhotoVideo:
+                return L"23940";
+
+#if ENABLE_HOLOLENS_RESEARCH_MODE_SENSORS
+            case SensorType::ShortThrowToFDepth:
+                return L"23941";
+
+            case SensorType::ShortThrowToFReflectivity:
+                return L"23942";
+
+            case SensorType::LongThrowToFDepth:
+                return L"23947";
+
+            case SensorType::LongThrowToFReflectivity:
+                return L"23948";
+
+            case SensorType::VisibleLightLeftLeft:
+                return L"23943";
+
+            case SensorType::VisibleLightLeftFront:
+                return L"23944";
+
+            case SensorType::VisibleLightRightFront:
+                return L"23945";
+
+            case SensorType::VisibleLightRightRight:
+                return L"23946";
+#endif /* ENABLE_HOLOLENS_RESEARCH_MODE_SENSORS */
+
+            default:
+                return nullptr;
+            }
+        }
+    }
+
     SensorFrameStreamer::SensorFrameStreamer()
     {
+        Policy = SensorFrameStreamingPolicy::DropOldest;
+        QueueCapacity = 4;
+        MaximumWritesInFlight = 3;
+        MaximumClients = 4;
+        ExtensionsEnabled = false;
+        JpegQuality = 0.9f;
+        KeyframeInterval = 30;
+        MultiplexingEnabled = false;
+        DatagramTransportEnabled = false;
+
+        _multiplexedSensors.fill(
+            false);
+
+        _weights.fill(
+            1 /* weight */);
+
+        _codecs.fill(
+            SensorFrameStreamingCodec::Raw);
     }
 
     void SensorFrameStreamer::EnableAll()
@@ -36,55 +100,161 @@ namespace HoloLensForCV
     void SensorFrameStreamer::Enable(
         _In_ SensorType sensorType)
     {
-        switch (sensorType)
+        if (MultiplexingEnabled)
         {
-        case SensorType::PhotoVideo:
-            _sensorFrameStreamingServers[(int32_t)SensorType::PhotoVideo] =
-                ref new SensorFrameStreamingServer(L"23940");
-            break;
+            EnableMultiplexed(
+                sensorType);
 
-#if ENABLE_HOLOLENS_RESEARCH_MODE_SENSORS
-        case SensorType::ShortThrowToFDepth:
-            _sensorFrameStreamingServers[(int32_t)SensorType::ShortThrowToFDepth] =
-                ref new SensorFrameStreamingServer(L"23941");
-            break;
-
-        case SensorType::ShortThrowToFReflectivity:
-            _sensorFrameStreamingServers[(int32_t)SensorType::ShortThrowToFReflectivity] =
-                ref new SensorFrameStreamingServer(L"23942");
-            break;
-
-        case SensorType::LongThrowToFDepth:
-            _sensorFrameStreamingServers[(int32_t)SensorType::LongThrowToFDepth] =
-                ref new SensorFrameStreamingServer(L"23947");
-            break;
-
-        case SensorType::LongThrowToFReflectivity:
-            _sensorFrameStreamingServers[(int32_t)SensorType::LongThrowToFReflectivity] =
-                ref new SensorFrameStreamingServer(L"23948");
-            break;
-
-        case SensorType::VisibleLightLeftLeft:
-            _sensorFrameStreamingServers[(int32_t)SensorType::VisibleLightLeftLeft] =
-                ref new SensorFrameStreamingServer(L"23943");
-            break;
-
-        case SensorType::VisibleLightLeftFront:
-            _sensorFrameStreamingServers[(int32_t)SensorType::VisibleLightLeftFront] =
-                ref new SensorFrameStreamingServer(L"23944");
-            break;
-
-        case SensorType::VisibleLightRightFront:
-            _sensorFrameStreamingServers[(int32_t)SensorType::VisibleLightRightFront] =
-                ref new SensorFrameStreamingServer(L"23945");
-            break;
-
-        case SensorType::VisibleLightRightRight:
-            _sensorFrameStreamingServers[(int32_t)SensorType::VisibleLightRightRight] =
-                ref new SensorFrameStreamingServer(L"23946");
-            break;
-#endif /* ENABLE_HOLOLENS_RESEARCH_MODE_SENSORS */
+            return;
+        }
+
+        Platform::String^ serviceName =
+            GetStreamingServiceName(
+                sensorType);
+
+        if (nullptr == serviceName)
+        {
+            return;
+        }
+
+        if (DatagramTransportEnabled)
+        {
+            EnableDatagram(
+                sensorType,
+                serviceName);
+
+            return;
+        }
+
+        SensorFrameStreamingServer^ sensorFrameStreamingServer =
+            ref new SensorFrameStreamingServer(serviceName);
+
+        sensorFrameStreamingServer->Policy = Policy;
+        sensorFrameStreamingServer->QueueCapacity = QueueCapacity;
+        sensorFrameStreamingServer->MaximumWritesInFlight = MaximumWritesInFlight;
+        sensorFrameStreamingServer->MaximumClients = MaximumClients;
+        sensorFrameStreamingServer->ExtensionsEnabled = ExtensionsEnabled;
+        sensorFrameStreamingServer->Codec = _codecs[(int32_t)sensorType];
+        sensorFrameStreamingServer->JpegQuality = JpegQuality;
+        sensorFrameStreamingServer->KeyframeInterval = KeyframeInterval;
+
+        _sensorFrameStreamingServers[(int32_t)sensorType] =
+            sensorFrameStreamingServer;
+    }
+
+    void SensorFrameStreamer::EnableMultiplexed(
+        _In_ SensorType sensorType)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_multiplexedSensors.size());
+
+        if (nullptr == _multiplexedStreamingServer)
+        {
+            _multiplexedStreamingServer =
+                ref new SensorFrameMultiplexedStreamingServer(L"23949");
+
+            _multiplexedStreamingServer->Policy = Policy;
+            _multiplexedStreamingServer->QueueCapacity = QueueCapacity;
+            _multiplexedStreamingServer->MaximumWritesInFlight = MaximumWritesInFlight;
+            _multiplexedStreamingServer->ExtensionsEnabled = ExtensionsEnabled;
+            _multiplexedStreamingServer->JpegQuality = JpegQuality;
+            _multiplexedStreamingServer->KeyframeInterval = KeyframeInterval;
+        }
+
+        _multiplexedStreamingServer->SetWeight(
+            sensorType,
+            _weights[sensorTypeAsIndex]);
+
+        _multiplexedStreamingServer->SetCodec(
+            sensorType,
+            _codecs[sensorTypeAsIndex]);
+
+        _multiplexedSensors[sensorTypeAsIndex] = true;
+    }
+
+    void SensorFrameStreamer::EnableDatagram(
+        _In_ SensorType sensorType,
+        _In_ Platform::String^ serviceName)
+    {
+        SensorFrameDatagramStreamingServer^ datagramStreamingServer =
+            ref new SensorFrameDatagramStreamingServer(serviceName);
+
+        datagramStreamingServer->ExtensionsEnabled = ExtensionsEnabled;
+        datagramStreamingServer->Codec = _codecs[(int32_t)sensorType];
+        datagramStreamingServer->JpegQuality = JpegQuality;
+
+        _datagramStreamingServers[(int32_t)sensorType] =
+            datagramStreamingServer;
+    }
+
+    void SensorFrameStreamer::SetWeight(
+        _In_ SensorType sensorType,
+        _In_ uint32_t weight)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_weights.size());
+
+        REQUIRES(weight > 0);
+
+        _weights[sensorTypeAsIndex] =
+            weight;
+    }
+
+    void SensorFrameStreamer::SetCodec(
+        _In_ SensorType sensorType,
+        _In_ SensorFrameStreamingCodec codec)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_codecs.size());
+
+        _codecs[sensorTypeAsIndex] =
+            codec;
+    }
+
+    SensorFrameStreamingStatistics SensorFrameStreamer::GetStatistics(
+        _In_ SensorType sensorType)
+    {
+        const int32_t sensorTypeAsIndex =
+            (int32_t)sensorType;
+
+        REQUIRES(
+            0 <= sensorTypeAsIndex &&
+            sensorTypeAsIndex < (int32_t)_sensorFrameStreamingServers.size());
+
+        if (_multiplexedSensors[sensorTypeAsIndex])
+        {
+            return _multiplexedStreamingServer->GetStatistics(
+                sensorType);
+        }
+
+        if (nullptr != _datagramStreamingServers[sensorTypeAsIndex])
+        {
+            return _datagramStreamingServers[sensorTypeAsIndex]->GetStatistics();
         }
+
+        SensorFrameStreamingServer^ sensorFrameStreamingServer =
+            _sensorFrameStreamingServers[sensorTypeAsIndex];
+
+        if (nullptr == sensorFrameStreamingServer)
+        {
+            SensorFrameStreamingStatistics statistics = {};
+
+            return statistics;
+        }
+
+        return sensorFrameStreamingServer->GetStatistics();
     }
 
     ISensorFrameSink^ SensorFrameStreamer::GetSensorFrameSink(
@@ -97,6 +267,16 @@ namespace HoloLensForCV
             0 <= sensorTypeAsIndex &&
             sensorTypeAsIndex < (int32_t)_sensorFrameStreamingServers.size());
 
+        if (_multiplexedSensors[sensorTypeAsIndex])
+        {
+            return _multiplexedStreamingServer;
+        }
+
+        if (nullptr != _datagramStreamingServers[sensorTypeAsIndex])
+        {
+            return _datagramStreamingServers[sensorTypeAsIndex];
+        }
+
         return _sensorFrameStreamingServers[
             sensorTypeAsIndex];
     }
@@ -17,6 +17,12 @@ namespace HoloLensForCV
     // Collects sensor frames for all the enabled sensors. Opens a stream socket for each
     // of the sensors and streams the sensor images to connected clients.
     //
+    // With multiplexing enabled, the frames of all the sensors are instead streamed over
+    // a single connection on port 23949.
+    //
+    // With the datagram transport enabled, each sensor is streamed over UDP on the port
+    // it would have used for TCP.
+    //
     public ref class SensorFrameStreamer sealed
         : public ISensorFrameSinkGroup
     {
@@ -28,10 +34,86 @@ namespace HoloLensForCV
         void Enable(
             _In_ SensorType sensorType);
 
+        //
+        // Send queue configuration of the streaming servers; must be set before
+        // the sensors are enabled. See SensorFrameStreamingServer.
+        //
+        property SensorFrameStreamingPolicy Policy;
+        property uint32_t QueueCapacity;
+        property uint32_t MaximumWritesInFlight;
+
+        //
+        // Number of clients each sensor's streaming server streams to at the same
+        // time; must be set before the sensors are enabled. Ignored when
+        // multiplexing or with the datagram transport.
+        //
+        property uint32_t MaximumClients;
+
+        //
+        // Streams the pose and intrinsics of the frames along with them (version
+        // 0.2 headers); must be set before the sensors are enabled.
+        //
+        property bool ExtensionsEnabled;
+
+        //
+        // Quality of the JPEG codec, between 0 and 1, and number of frames from a
+        // keyframe to the next with the Delta codec; must be set before the
+        // sensors are enabled.
+        //
+        property float JpegQuality;
+        property uint32_t KeyframeInterval;
+
+        //
+        // Streams all the enabled sensors over one connection; must be set before the
+        // sensors are enabled. See SensorFrameMultiplexedStreamingServer.
+        //
+        property bool MultiplexingEnabled;
+
+        //
+        // Streams the enabled sensors over UDP rather than TCP, dropping the
+        // frames that lose a datagram; must be set before the sensors are
+        // enabled, and is ignored when multiplexing. Off by default. See
+        // SensorFrameDatagramStreamingServer.
+        //
+        property bool DatagramTransportEnabled;
+
+        //
+        // Share of the multiplexed connection given to a sensor, relative to the other
+        // sensors. Must be set before the sensor is enabled.
+        //
+        void SetWeight(
+            _In_ SensorType sensorType,
+            _In_ uint32_t weight);
+
+        //
+        // Compression of a sensor's frames (version 0.3 headers). Must be set before
+        // the sensor is enabled.
+        //
+        void SetCodec(
+            _In_ SensorType sensorType,
+            _In_ SensorFrameStreamingCodec codec);
+
+        SensorFrameStreamingStatistics GetStatistics(
+            _In_ SensorType sensorType);
+
         virtual ISensorFrameSink^ GetSensorFrameSink(
             _In_ SensorType sensorType);
 
+    private:
+        void EnableMultiplexed(
+            _In_ SensorType sensorType);
+
+        void EnableDatagram(
+            _In_ SensorType sensorType,
+            _In_ Platform::String^ serviceName);
+
     private:
         std::array<SensorFrameStreamingServer^, (size_t)SensorType::NumberOfSensorTypes> _sensorFrameStreamingServers;
+        std::array<SensorFrameDatagramStreamingServer^, (size_t)SensorType::NumberOfSensorTypes> _datagramStreamingServers;
+
+        SensorFrameMultiplexedStreamingServer^ _multiplexedStreamingServer;
+        std::array<bool, (size_t)SensorType::NumberOfSensorTypes> _multiplexedSensors;
+        std::array<uint32_t, (size_t)SensorType::NumberOfSensorTypes> _weights;
+        std::array<SensorFrameStreamingCodec, (size_t)SensorType::NumberOfSensorTypes> _codecs;
     };
 }
@@ -0,0 +1,46 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Codecs the streaming servers can compress frames with. Frames that a codec
+    // does not apply to, or that would not get smaller, are sent with the next
+    // best codec, down to Raw; the stream header says which one was used.
+    //
+    public enum class SensorFrameStreamingCodec : int32_t
+    {
+        // Uncompressed pixels.
+        Raw = 0,
+
+        // LZ4 compressed pixels (lossless).
+        Lz4 = 1,
+
+        // Predictive coding of 16-bit depth and reflectivity images (lossless).
+        // Other pixel formats fall back to LZ4.
+        Depth = 2,
+
+        // JPEG (lossy), at the server's JpegQuality. Applies to the photo video
+        // and visible light cameras; 16-bit images fall back to the depth codec.
+        Jpeg = 3,
+
+        // Temporal coding of the 8 and 16-bit images of static sensors, such as
+        // the visible light cameras and the depth cameras (lossless). A keyframe
+        // every KeyframeInterval frames is coded like Depth; the frames between
+        // keyframes are coded as their difference to the previous frame, tiles
+        // that did not change costing a bit. 16-bit images are differenced sample
+        // by sample, others byte by byte.
+        Delta = 4
+    };
+}
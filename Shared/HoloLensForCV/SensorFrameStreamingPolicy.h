@@ -0,0 +1,67 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // What a streaming server does with new frames while its send queue is full.
+    //
+    public enum class SensorFrameStreamingPolicy : int32_t
+    {
+        // Drop the oldest queued frame; keeps the latency low.
+        DropOldest = 0,
+
+        // Drop the new frame.
+        DropNewest = 1,
+
+        // Block the frame reader until there is room; nothing is dropped, but
+        // the sensor is throttled to the speed of the connection.
+        Block = 2,
+
+        // Only keep streaming keyframes while the connection is behind.
+        KeyframeOnly = 3
+    };
+
+    //
+    // Counters of a streaming server's current connection.
+    //
+    public value struct SensorFrameStreamingStatistics
+    {
+        uint64_t FramesSent;
+        uint64_t FramesDropped;
+        uint64_t BytesSent;
+
+        // Time frames spent queued before being written to the socket.
+        double AverageQueueLatencyInMilliseconds;
+        double MaximumQueueLatencyInMilliseconds;
+
+        // Average throughput since the client connected.
+        double BytesPerSecond;
+    };
+
+    //
+    // Converts the counters of a streaming server send queue.
+    //
+    SensorFrameStreamingStatistics ToSensorFrameStreamingStatistics(
+        _In_ const Io::SendQueueStatistics& sendQueueStatistics);
+
+    //
+    // Send queue policy of a stream: frames compressed with the Delta codec
+    // depend on the previous ones, so dropping any frame but a keyframe drops
+    // the frames that follow until the next keyframe.
+    //
+    Io::SendQueuePolicy ToSendQueuePolicy(
+        _In_ SensorFrameStreamingPolicy policy,
+        _In_ SensorFrameStreamingCodec codec);
+}
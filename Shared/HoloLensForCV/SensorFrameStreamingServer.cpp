@@ -13,10 +13,60 @@
 
 namespace HoloLensForCV
 {
+    SensorFrameStreamingStatistics ToSensorFrameStreamingStatistics(
+        _In_ const Io::SendQueueStatistics& sendQueueStatistics)
+    {
+        SensorFrameStreamingStatistics statistics = {};
+
+        statistics.FramesSent = sendQueueStatistics.FramesSent;
+        statistics.FramesDropped = sendQueueStatistics.FramesDropped;
+        statistics.BytesSent = sendQueueStatistics.BytesSent;
+
+        if (sendQueueStatistics.FramesStarted > 0)
+        {
+            statistics.AverageQueueLatencyInMilliseconds =
+                1e3 * sendQueueStatistics.TotalQueueLatencyInSeconds / sendQueueStatistics.FramesStarted;
+        }
+
+        statistics.MaximumQueueLatencyInMilliseconds =
+            1e3 * sendQueueStatistics.MaximumQueueLatencyInSeconds;
+
+        if (sendQueueStatistics.ElapsedTimeInSeconds > 0.0)
+        {
+            statistics.BytesPerSecond =
+                sendQueueStatistics.BytesSent / sendQueueStatistics.ElapsedTimeInSeconds;
+        }
+
+        return statistics;
+    }
+
+    Io::SendQueuePolicy ToSendQueuePolicy(
+        _In_ SensorFrameStreamingPolicy policy,
+        _In_ SensorFrameStreamingCodec codec)
+    {
+        if (SensorFrameStreamingCodec::Delta == codec &&
+            SensorFrameStreamingPolicy::Block != policy)
+        {
+            return Io::SendQueuePolicy::KeyframeOnly;
+        }
+
+        return (Io::SendQueuePolicy)policy;
+    }
+
     SensorFrameStreamingServer::SensorFrameStreamingServer(
         _In_ Platform::String^ serviceName)
-        : _writeInProgress(false)
+        : _codec(SensorFrameStreamingCodec::Raw)
+        , _extensionsEnabled(false)
     {
+        Policy = SensorFrameStreamingPolicy::DropOldest;
+        QueueCapacity = 4;
+        MaximumWritesInFlight = 3;
+        MaximumClients = 4;
+        ExtensionsEnabled = false;
+        Codec = SensorFrameStreamingCodec::Raw;
+        JpegQuality = 0.9f;
+        KeyframeInterval = 30;
+
         _listener = ref new Windows::Networking::Sockets::StreamSocketListener();
 
         _listener->ConnectionReceived +=
@@ -56,208 +106,323 @@ namespace HoloLensForCV
         // In this case this is the last reference to the listener so both will yield the same result.
         delete _listener;
         _listener = nullptr;
+
+        if (nullptr != _fanOut)
+        {
+            _fanOut->Close();
+        }
     }
 
     void SensorFrameStreamingServer::OnConnection(
         Windows::Networking::Sockets::StreamSocketListener^ listener,
         Windows::Networking::Sockets::StreamSocketListenerConnectionReceivedEventArgs^ object)
     {
-        _socket = object->Socket;
+        REQUIRES(QueueCapacity > 0 && MaximumWritesInFlight > 0 && MaximumClients > 0);
 
-        _writeInProgress = false;
+        auto connection =
+            std::make_shared<Connection>();
 
-        _writer = ref new Windows::Storage::Streams::DataWriter(
-            _socket->OutputStream);
+        connection->Socket = object->Socket;
+        connection->UnprojectionLutSent = false;
 
-        _writer->UnicodeEncoding =
-            Windows::Storage::Streams::UnicodeEncoding::Utf8;
+        std::lock_guard<std::mutex> lock(_connectionMutex);
 
-        _writer->ByteOrder =
-            Windows::Storage::Streams::ByteOrder::LittleEndian;
-    }
+        if (nullptr == _fanOut)
+        {
+            _fanOut =
+                std::make_shared<FanOut>(
+                    MaximumClients);
+        }
 
-    void SensorFrameStreamingServer::Send(
-        SensorFrame^ sensorFrame)
-    {
-        if (nullptr == _socket)
+        //
+        // The first client picks the encoding of the stream; the clients that
+        // join it later get the same frames.
+        //
+        if (_fanOut->GetClients().empty())
         {
-#if DBG_ENABLE_VERBOSE_LOGGING
-            dbg::trace(
-                L"SensorFrameStreamingServer::Consume: image dropped -- no connection!");
-#endif /* DBG_ENABLE_VERBOSE_LOGGING */
+            _codec = Codec;
+            _extensionsEnabled = ExtensionsEnabled;
+            _compressor.reset();
 
-            return;
+            if (SensorFrameStreamingCodec::Raw != _codec)
+            {
+                _compressor =
+                    std::make_shared<SensorFrameCompressor>(
+                        _codec,
+                        JpegQuality,
+                        KeyframeInterval);
+            }
         }
 
-        if (_writeInProgress)
+        if (nullptr == _fanOut->AddClient(
+                connection,
+                QueueCapacity,
+                MaximumWritesInFlight,
+                ToSendQueuePolicy(Policy, _codec)))
         {
 #if DBG_ENABLE_INFORMATIONAL_LOGGING
             dbg::trace(
-                L"SensorFrameStreamingServer::Send: image dropped -- previous send operation is in progress!");
+                L"SensorFrameStreamingServer::OnConnection: connection refused -- already streaming to %u clients!",
+                MaximumClients);
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
+            delete connection->Socket;
+
             return;
         }
 
-        Windows::Graphics::Imaging::SoftwareBitmap^ bitmap;
-        Windows::Graphics::Imaging::BitmapBuffer^ bitmapBuffer;
-        Windows::Foundation::IMemoryBufferReference^ bitmapBufferReference;
+        //
+        // The new client waits for a keyframe to start its stream.
+        //
+        if (nullptr != _compressor)
+        {
+            _compressor->RequestKeyframe();
+        }
+    }
 
-        int32_t imageWidth = 0;
-        int32_t imageHeight = 0;
-        int32_t pixelStride = 1;
-        int32_t rowStride = 0;
+    SensorFrameStreamingStatistics SensorFrameStreamingServer::GetStatistics()
+    {
+        Platform::Array<SensorFrameStreamingStatistics>^ clientStatistics =
+            GetClientStatistics();
 
-        Platform::Array<uint8_t>^ imageBufferAsPlatformArray;
-        int32_t imageBufferSize = 0;
+        SensorFrameStreamingStatistics statistics = {};
 
-        {
-#if DBG_ENABLE_INFORMATIONAL_LOGGING
-            dbg::TimerGuard timerGuard(
-                L"SensorFrameStreamingServer::Send: buffer preparation",
-                4.0 /* minimum_time_elapsed_in_milliseconds */);
-#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+        //
+        // The average queue latency is weighted by the number of frames each
+        // client has sent.
+        //
+        double totalQueueLatencyInMilliseconds = 0.0;
 
-            bitmap =
-                sensorFrame->SoftwareBitmap;
+        for (unsigned int i = 0; i < clientStatistics->Length; ++i)
+        {
+            const SensorFrameStreamingStatistics& client =
+                clientStatistics[i];
 
-            imageWidth = bitmap->PixelWidth;
-            imageHeight = bitmap->PixelHeight;
+            statistics.FramesSent += client.FramesSent;
+            statistics.FramesDropped += client.FramesDropped;
+            statistics.BytesSent += client.BytesSent;
+            statistics.BytesPerSecond += client.BytesPerSecond;
 
-            bitmapBuffer =
-                bitmap->LockBuffer(
-                    Windows::Graphics::Imaging::BitmapBufferAccessMode::Read);
+            totalQueueLatencyInMilliseconds +=
+                client.AverageQueueLatencyInMilliseconds * client.FramesSent;
 
-            bitmapBufferReference =
-                bitmapBuffer->CreateReference();
+            statistics.MaximumQueueLatencyInMilliseconds =
+                std::max<double>(
+                    statistics.MaximumQueueLatencyInMilliseconds,
+                    client.MaximumQueueLatencyInMilliseconds);
+        }
 
-            uint32_t bitmapBufferDataSize = 0;
+        if (statistics.FramesSent > 0)
+        {
+            statistics.AverageQueueLatencyInMilliseconds =
+                totalQueueLatencyInMilliseconds / statistics.FramesSent;
+        }
 
-            uint8_t* bitmapBufferData =
-                Io::GetTypedPointerToMemoryBuffer<uint8_t>(
-                    bitmapBufferReference,
-                    bitmapBufferDataSize);
+        return statistics;
+    }
 
-            switch (bitmap->BitmapPixelFormat)
-            {
-            case Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8:
-                pixelStride = 4;
-                break;
+    Platform::Array<SensorFrameStreamingStatistics>^ SensorFrameStreamingServer::GetClientStatistics()
+    {
+        std::shared_ptr<FanOut> fanOut;
 
-            case Windows::Graphics::Imaging::BitmapPixelFormat::Gray16:
-                pixelStride = 2;
-                break;
+        {
+            std::lock_guard<std::mutex> lock(_connectionMutex);
 
-            case Windows::Graphics::Imaging::BitmapPixelFormat::Gray8:
-                pixelStride = 1;
-                break;
+            fanOut = _fanOut;
+        }
 
-            default:
-#if DBG_ENABLE_INFORMATIONAL_LOGGING
-                dbg::trace(
-                    L"SensorFrameStreamingServer::Send: unrecognized bitmap pixel format, assuming 1 byte per pixel");
-#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+        if (nullptr == fanOut)
+        {
+            return ref new Platform::Array<SensorFrameStreamingStatistics>(0);
+        }
 
-                break;
-            }
+        const std::vector<Io::SendQueueStatistics> sendQueueStatistics =
+            fanOut->GetStatistics();
 
-            rowStride =
-                imageWidth * pixelStride;
+        Platform::Array<SensorFrameStreamingStatistics>^ statistics =
+            ref new Platform::Array<SensorFrameStreamingStatistics>(
+                static_cast<unsigned int>(sendQueueStatistics.size()));
 
-            imageBufferSize =
-                imageHeight * rowStride;
+        for (size_t i = 0; i < sendQueueStatistics.size(); ++i)
+        {
+            statistics[static_cast<unsigned int>(i)] =
+                ToSensorFrameStreamingStatistics(
+                    sendQueueStatistics[i]);
+        }
 
-            ASSERT(
-                imageBufferSize == (int32_t)bitmapBufferDataSize);
+        return statistics;
+    }
 
-            imageBufferAsPlatformArray =
-                ref new Platform::Array<uint8_t>(
-                    bitmapBufferData,
-                    imageBufferSize);
-        }
+    void SensorFrameStreamingServer::Send(
+        SensorFrame^ sensorFrame)
+    {
+        std::shared_ptr<FanOut> fanOut;
+        bool extensionsEnabled = false;
+        std::shared_ptr<SensorFrameCompressor> compressor;
 
-        SensorFrameStreamHeader^ header =
-            ref new SensorFrameStreamHeader();
+        {
+            std::lock_guard<std::mutex> lock(_connectionMutex);
 
-        header->FrameType = sensorFrame->FrameType;
-        header->Timestamp = sensorFrame->Timestamp.UniversalTime;
-        header->ImageWidth = imageWidth;
-        header->ImageHeight = imageHeight;
-        header->PixelStride = pixelStride;
-        header->RowStride = rowStride;
+            fanOut = _fanOut;
+            extensionsEnabled = _extensionsEnabled;
+            compressor = _compressor;
+        }
 
-        SendImage(
-            header,
-            imageBufferAsPlatformArray);
-    }
+        const std::vector<FanOut::Client> clients =
+            (nullptr != fanOut) ? fanOut->GetClients() : std::vector<FanOut::Client>();
 
-    void SensorFrameStreamingServer::SendImage(
-        SensorFrameStreamHeader^ header,
-        const Platform::Array<uint8_t>^ data)
-    {
-        if (nullptr == _socket)
+        if (clients.empty())
         {
 #if DBG_ENABLE_VERBOSE_LOGGING
             dbg::trace(
-                L"SensorFrameStreamingServer::SendImage: image dropped -- no connection!");
+                L"SensorFrameStreamingServer::Send: image dropped -- no connection!");
 #endif /* DBG_ENABLE_VERBOSE_LOGGING */
 
             return;
         }
 
-        if (_writeInProgress)
-        {
-#if DBG_ENABLE_INFORMATIONAL_LOGGING
-            dbg::trace(
-                L"SensorFrameStreamingServer::SendImage: image dropped -- previous StoreAsync task is still in progress!");
-#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+        //
+        // A delta must be queued before the frame compressed after it.
+        //
+        std::unique_lock<std::mutex> compressionOrderLock(
+            _compressionOrderMutex,
+            std::defer_lock);
 
-            return;
+        if (nullptr != compressor && SensorFrameStreamingCodec::Delta == compressor->GetCodec())
+        {
+            compressionOrderLock.lock();
         }
 
-        _writeInProgress = true;
+        //
+        // The frame is encoded once for all the clients. It carries the
+        // unprojection LUT for as long as a client hasn't been sent it yet.
+        //
+        SerializedSensorFrame frame;
+        bool isKeyframe = true;
 
+        if (extensionsEnabled)
+        {
+            const bool includeUnprojectionLut =
+                std::any_of(
+                    clients.begin(),
+                    clients.end(),
+                    [](const FanOut::Client& client) { return !client.Connection->UnprojectionLutSent; });
+
+            std::vector<uint8_t> extensionBlock;
+
+            frame.CarriesUnprojectionLut =
+                _extensionsEncoder.Encode(
+                    sensorFrame,
+                    includeUnprojectionLut,
+                    extensionBlock);
+
+            frame.Buffer =
+                SerializeSensorFrame(
+                    sensorFrame,
+                    &extensionBlock,
+                    compressor.get(),
+                    &isKeyframe);
+        }
+        else
+        {
+            frame.Buffer =
+                SerializeSensorFrame(
+                    sensorFrame,
+                    nullptr /* extensionBlock */,
+                    compressor.get(),
+                    &isKeyframe);
+        }
+
+        if (fanOut->Push(frame, frame.Buffer->Length, isKeyframe))
         {
 #if DBG_ENABLE_INFORMATIONAL_LOGGING
-            dbg::TimerGuard timerGuard(
-                L"SensorFrameStreamingServer::SendImage: writer operations",
-                4.0 /* minimum_time_elapsed_in_milliseconds */);
+            dbg::trace(
+                L"SensorFrameStreamingServer::Send: image dropped for a client -- its send queue is full or it awaits a keyframe!");
 #endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
 
-            SensorFrameStreamHeader::Write(
-                header,
-                _writer);
+            //
+            // The frames that follow depend on the dropped one until the next
+            // keyframe; don't wait for it.
+            //
+            if (nullptr != compressor)
+            {
+                compressor->RequestKeyframe();
+            }
+        }
 
-            _writer->WriteBytes(
-                data);
+        if (compressionOrderLock.owns_lock())
+        {
+            compressionOrderLock.unlock();
         }
 
-#if DBG_ENABLE_INFORMATIONAL_LOGGING
-        dbg::TimerGuard timerGuard(
-            L"SensorFrameStreamingServer::SendImage: StoreAsync task creation",
-            10.0 /* minimum_time_elapsed_in_milliseconds */);
-#endif /* DBG_ENABLE_INFORMATIONAL_LOGGING */
+        for (const FanOut::Client& client : clients)
+        {
+            StartWrites(
+                client);
+        }
+    }
+
+    void SensorFrameStreamingServer::StartWrites(
+        _In_ const FanOut::Client& client)
+    {
+        //
+        // Writes to a stream socket may overlap and complete in the order they
+        // were started, which must be the order of the queue.
+        //
+        std::lock_guard<std::recursive_mutex> lock(
+            client.Connection->WriteOrderMutex);
 
-        Concurrency::create_task(_writer->StoreAsync()).then(
-            [&](Concurrency::task<unsigned int> writeTask)
+        SerializedSensorFrame frame;
+        size_t bufferSize = 0;
+
+        while (client.Queue->TryBeginSend(&frame, &bufferSize))
         {
-            try
+            //
+            // Once the write of a frame carrying the unprojection LUT has been
+            // started, the frames that follow can refer to the LUT: they are
+            // written after it, or the connection fails before they are.
+            //
+            if (frame.CarriesUnprojectionLut)
             {
-                // Try getting an exception.
-                writeTask.get();
-
-                _writeInProgress = false;
+                client.Connection->UnprojectionLutSent = true;
             }
-            catch (Platform::Exception^ exception)
+
+            Concurrency::create_task(client.Connection->Socket->OutputStream->WriteAsync(frame.Buffer)).then(
+                [this, client, bufferSize](Concurrency::task<unsigned int> writeTask)
             {
+                bool succeeded = false;
+
+                try
+                {
+                    // Try getting an exception.
+                    writeTask.get();
+
+                    succeeded = true;
+                }
+                catch (Platform::Exception^ exception)
+                {
 #if DBG_ENABLE_ERROR_LOGGING
-                dbg::trace(
-                    L"SensorFrameStreamingServer::SendImage: StoreAsync call failed with error: %s",
-                    exception->Message->Data());
+                    dbg::trace(
+                        L"SensorFrameStreamingServer::StartWrites: WriteAsync call failed with error: %s",
+                        exception->Message->Data());
 #endif /* DBG_ENABLE_ERROR_LOGGING */
+                }
 
-                _socket = nullptr;
-            }
-        });
+                client.Queue->EndSend(
+                    bufferSize,
+                    succeeded);
+
+                if (!succeeded)
+                {
+                    // The client is gone; forget it.
+                    client.Queue->Close();
+
+                    return;
+                }
+
+                StartWrites(
+                    client);
+            });
+        }
     }
 }
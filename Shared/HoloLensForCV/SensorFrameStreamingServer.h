@@ -13,6 +13,14 @@
 
 namespace HoloLensForCV
 {
+    //
+    // Streams the frames of a sensor to the clients connected to the given service.
+    // Each frame is encoded once and queued for every client, whose frames are
+    // written asynchronously, with several writes in flight to make up for the
+    // round trip time of the connection. What happens when a client can not keep
+    // up is decided by the streaming policy of its queue: the other clients are
+    // not held back, unless the policy is Block.
+    //
     public ref class SensorFrameStreamingServer sealed
         : public ISensorFrameSink
     {
@@ -23,6 +31,53 @@ namespace HoloLensForCV
         virtual void Send(
             SensorFrame^ sensorFrame);
 
+        //
+        // Send queue configuration of a client. Takes effect with the next
+        // connection.
+        //
+        property SensorFrameStreamingPolicy Policy;
+        property uint32_t QueueCapacity;
+        property uint32_t MaximumWritesInFlight;
+
+        //
+        // Number of clients streamed to at the same time; further connections are
+        // closed. Must be set before the first client connects.
+        //
+        property uint32_t MaximumClients;
+
+        //
+        // Sends version 0.2 headers, with the pose and intrinsics of the frames.
+        // Off by default for receivers that only understand version 0.1 headers.
+        // Takes effect when a client connects while no other client is.
+        //
+        property bool ExtensionsEnabled;
+
+        //
+        // Compression of the frames (version 0.3 headers), the quality of the
+        // JPEG codec between 0 and 1, and the number of frames from a keyframe to
+        // the next with the Delta codec. Takes effect when a client connects while
+        // no other client is.
+        //
+        // With the Delta codec, frames that depend on a dropped frame are dropped
+        // until the next keyframe, which is sent as soon as possible: the
+        // DropOldest and DropNewest policies behave like KeyframeOnly. Frames are
+        // compressed once for all the clients, so a keyframe requested for one of
+        // them is sent to all of them, as is the keyframe a new client starts with.
+        //
+        property SensorFrameStreamingCodec Codec;
+        property float JpegQuality;
+        property uint32_t KeyframeInterval;
+
+        //
+        // Totals of the connected clients.
+        //
+        SensorFrameStreamingStatistics GetStatistics();
+
+        //
+        // Statistics of each connected client, in the order they connected.
+        //
+        Platform::Array<SensorFrameStreamingStatistics>^ GetClientStatistics();
+
     private:
         ~SensorFrameStreamingServer();
 
@@ -30,14 +85,38 @@ namespace HoloLensForCV
             Windows::Networking::Sockets::StreamSocketListener^ listener,
             Windows::Networking::Sockets::StreamSocketListenerConnectionReceivedEventArgs^ object);
 
-        void SendImage(
-            SensorFrameStreamHeader^ header,
-            const Platform::Array<uint8_t>^ data);
+        struct Connection
+        {
+            Windows::Networking::Sockets::StreamSocket^ Socket;
+
+            // Set once the write of a frame carrying the unprojection LUT has
+            // been started.
+            std::atomic<bool> UnprojectionLutSent;
+
+            // Writes are started in queue order, even when several threads pick
+            // up frames from the queue.
+            std::recursive_mutex WriteOrderMutex;
+        };
+
+        typedef Io::FrameFanOut<SerializedSensorFrame, Connection> FanOut;
+
+        void StartWrites(
+            _In_ const FanOut::Client& client);
 
     private:
         Windows::Networking::Sockets::StreamSocketListener^ _listener;
-        Windows::Networking::Sockets::StreamSocket^ _socket;
-        Windows::Storage::Streams::DataWriter^ _writer;
-        bool _writeInProgress;
+
+        // The clients, created when the first one connects, and the encoding of
+        // the stream, chosen when a client connects while no other client is.
+        std::mutex _connectionMutex;
+        std::shared_ptr<FanOut> _fanOut;
+        SensorFrameStreamingCodec _codec;
+        bool _extensionsEnabled;
+        std::shared_ptr<SensorFrameCompressor> _compressor;
+
+        SensorFrameExtensionsEncoder _extensionsEncoder;
+
+        // Delta compressed frames are queued in the order they were compressed.
+        std::mutex _compressionOrderMutex;
     };
 }
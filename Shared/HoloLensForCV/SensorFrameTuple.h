@@ -0,0 +1,38 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace HoloLensForCV
+{
+    //
+    // Frames of several sensors captured at (approximately) the same time.
+    //
+    public ref class SensorFrameTuple sealed
+    {
+    public:
+        SensorFrameTuple(
+            _In_ Windows::Foundation::DateTime timestamp,
+            _In_ Windows::Foundation::Collections::IVectorView<SensorFrame^>^ frames);
+
+        //
+        // Timestamp of the frame of the first sensor, which the frames of the
+        // other sensors were matched against.
+        //
+        property Windows::Foundation::DateTime Timestamp;
+
+        //
+        // One frame per sensor, in the order the sensors were requested in.
+        //
+        property Windows::Foundation::Collections::IVectorView<SensorFrame^>^ Frames;
+    };
+}
@@ -0,0 +1,212 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see TimestampStream.
+//
+#include "TimestampMatching.h"
+
+#include <algorithm>
+
+namespace HoloLensForCV
+{
+    namespace
+    {
+        int64_t AbsoluteDifference(
+            _In_ const int64_t a,
+            _In_ const int64_t b)
+        {
+            return (a > b) ? (a - b) : (b - a);
+        }
+
+        //
+        // Advances the cursor for as long as the next timestamp is at least as
+        // close to the given time. Given non-decreasing times, repeated calls
+        // visit every timestamp of the stream at most once.
+        //
+        size_t AdvanceToNearestTimestamp(
+            _In_ const TimestampStream& stream,
+            _In_ const int64_t timestamp,
+            _In_ size_t cursor)
+        {
+            while (cursor + 1 < stream.Count &&
+                AbsoluteDifference(stream.Timestamps[cursor + 1], timestamp) <=
+                AbsoluteDifference(stream.Timestamps[cursor], timestamp))
+            {
+                ++cursor;
+            }
+
+            return cursor;
+        }
+    }
+
+    bool FindNearestTimestamp(
+        _In_ const TimestampStream& stream,
+        _In_ const int64_t timestamp,
+        _Out_ size_t* index)
+    {
+        if (0 == stream.Count)
+        {
+            return false;
+        }
+
+        const int64_t* end = stream.Timestamps + stream.Count;
+
+        const int64_t* next = std::lower_bound(
+            stream.Timestamps,
+            end,
+            timestamp);
+
+        if (next == end)
+        {
+            *index = stream.Count - 1;
+        }
+        else if (next == stream.Timestamps ||
+            AbsoluteDifference(*next, timestamp) <= AbsoluteDifference(*(next - 1), timestamp))
+        {
+            *index = next - stream.Timestamps;
+        }
+        else
+        {
+            *index = (next - stream.Timestamps) - 1;
+        }
+
+        return true;
+    }
+
+    bool FindLatestTimestampTuple(
+        _In_reads_(streamCount) const TimestampStream* streams,
+        _In_ const size_t streamCount,
+        _In_ const int64_t tolerance,
+        _Out_writes_(streamCount) size_t* indices)
+    {
+        REQUIRES(streamCount > 0);
+
+        for (size_t reference = streams[0].Count; reference-- > 0;)
+        {
+            const int64_t referenceTimestamp =
+                streams[0].Timestamps[reference];
+
+            bool valid = true;
+
+            indices[0] = reference;
+
+            for (size_t i = 1; valid && i < streamCount; ++i)
+            {
+                valid =
+                    FindNearestTimestamp(streams[i], referenceTimestamp, &indices[i]) &&
+                    AbsoluteDifference(streams[i].Timestamps[indices[i]], referenceTimestamp) < tolerance;
+            }
+
+            if (valid)
+            {
+                return true;
+            }
+
+            //
+            // Older references cannot be matched once a stream has no timestamp
+            // left that is early enough.
+            //
+            for (size_t i = 1; i < streamCount; ++i)
+            {
+                if (0 == streams[i].Count ||
+                    streams[i].Timestamps[0] >= referenceTimestamp + tolerance)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    size_t FindTimestampTuplesSince(
+        _In_reads_(streamCount) const TimestampStream* streams,
+        _In_ const size_t streamCount,
+        _In_ const int64_t since,
+        _In_ const int64_t tolerance,
+        _Inout_ std::vector<size_t>& indices)
+    {
+        REQUIRES(streamCount > 0);
+
+        for (size_t i = 1; i < streamCount; ++i)
+        {
+            if (0 == streams[i].Count)
+            {
+                return 0;
+            }
+        }
+
+        const int64_t* referenceEnd =
+            streams[0].Timestamps + streams[0].Count;
+
+        size_t reference = std::upper_bound(
+            streams[0].Timestamps,
+            referenceEnd,
+            since) - streams[0].Timestamps;
+
+        if (reference == streams[0].Count)
+        {
+            return 0;
+        }
+
+        //
+        // The references are visited in ascending order, so the nearest
+        // timestamp of each of the other streams only ever moves forward.
+        //
+        std::vector<size_t> cursors(streamCount, 0);
+
+        for (size_t i = 1; i < streamCount; ++i)
+        {
+            FindNearestTimestamp(
+                streams[i],
+                streams[0].Timestamps[reference],
+                &cursors[i]);
+        }
+
+        size_t tupleCount = 0;
+
+        for (; reference < streams[0].Count; ++reference)
+        {
+            const int64_t referenceTimestamp =
+                streams[0].Timestamps[reference];
+
+            bool valid = true;
+
+            for (size_t i = 1; i < streamCount; ++i)
+            {
+                cursors[i] = AdvanceToNearestTimestamp(
+                    streams[i],
+                    referenceTimestamp,
+                    cursors[i]);
+
+                valid = valid &&
+                    AbsoluteDifference(streams[i].Timestamps[cursors[i]], referenceTimestamp) < tolerance;
+            }
+
+            if (valid)
+            {
+                indices.push_back(
+                    reference);
+
+                indices.insert(
+                    indices.end(),
+                    cursors.begin() + 1,
+                    cursors.end());
+
+                ++tupleCount;
+            }
+        }
+
+        return tupleCount;
+    }
+}
@@ -0,0 +1,67 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace HoloLensForCV
+{
+    //
+    // A sensor's frame timestamps in 100ns units, sorted in ascending order.
+    //
+    struct TimestampStream
+    {
+        const int64_t* Timestamps;
+        size_t Count;
+    };
+
+    //
+    // Finds the timestamp closest to the given time in O(log n), preferring the
+    // later one on ties. Returns false if the stream is empty.
+    //
+    bool FindNearestTimestamp(
+        _In_ const TimestampStream& stream,
+        _In_ const int64_t timestamp,
+        _Out_ size_t* index);
+
+    //
+    // Matches frames across sensors. A tuple is anchored on a timestamp of the
+    // first stream, the reference, and picks the timestamp nearest to it from
+    // each of the other streams; it is valid if all of them are less than the
+    // tolerance away from the reference.
+    //
+    // Finds the valid tuple with the most recent reference and stores one index
+    // per stream. Returns false if there is no valid tuple.
+    //
+    bool FindLatestTimestampTuple(
+        _In_reads_(streamCount) const TimestampStream* streams,
+        _In_ const size_t streamCount,
+        _In_ const int64_t tolerance,
+        _Out_writes_(streamCount) size_t* indices);
+
+    //
+    // Appends the valid tuples whose reference is more recent than the given
+    // time, oldest first, as streamCount indices per tuple. Runs in time linear
+    // in the total length of the streams. Returns the number of tuples found.
+    //
+    size_t FindTimestampTuplesSince(
+        _In_reads_(streamCount) const TimestampStream* streams,
+        _In_ const size_t streamCount,
+        _In_ const int64_t since,
+        _In_ const int64_t tolerance,
+        _Inout_ std::vector<size_t>& indices);
+}
@@ -12,15 +12,21 @@
 #pragma once
 
 #include <map>
+#include <vector>
+#include <algorithm>
 #include <array>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include <ctime>
 #include <deque>
 #include <chrono>
 #include <fstream>
 #include <sstream>
 #include <cstddef>
+#include <cmath>
 #include <stdexcept>
 #include <shared_mutex>
 #include <unordered_set>
@@ -51,15 +57,25 @@
 #include "SpatialPerception.h"
 
 #include "SensorType.h"
+#include "SensorFrameStorageCodec.h"
 #include "SensorFrame.h"
 
 #include "ISensorFrameSink.h"
 #include "ISensorFrameSinkGroup.h"
 
+#include "SensorFrameStreamingCodec.h"
 #include "SensorFrameStreamHeader.h"
+#include "SensorFrameStreamingPolicy.h"
+#include "SensorFrameCompression.h"
+#include "SensorFrameSerialization.h"
+#include "SensorFrameExtensions.h"
 #include "SensorFrameStreamingServer.h"
+#include "SensorFrameMultiplexedStreamingServer.h"
+#include "SensorFrameDatagramStreamingServer.h"
 #include "SensorFrameStreamer.h"
 #include "SensorFrameReceiver.h"
+#include "SensorFrameMultiplexedReceiver.h"
+#include "SensorFrameDatagramReceiver.h"
 
 #include "SensorFrameRecorderSink.h"
 #include "SensorFrameRecorder.h"
@@ -68,4 +84,7 @@
 #include "MediaFrameSourceGroupType.h"
 #include "MediaFrameSourceGroup.h"
 
+#include "SensorFrameRing.h"
+#include "TimestampMatching.h"
+#include "SensorFrameTuple.h"
 #include "MultiFrameBuffer.h"
@@ -0,0 +1,303 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see CsvReader.
+//
+#include <Io/CsvReader.h>
+#include <Io/NumberParsing.h>
+
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define IO_CSV_READER_SSE2 1
+#include <emmintrin.h>
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define IO_CSV_READER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Io
+{
+    namespace
+    {
+        const size_t c_blockSize = 16;
+
+#if IO_CSV_READER_NEON
+        //
+        // NEON has no byte mask extraction; narrowing the compare result gives
+        // four mask bits per byte instead.
+        //
+        const uint32_t c_maskBitsPerByte = 4;
+#else
+        const uint32_t c_maskBitsPerByte = 1;
+#endif
+
+        const uint64_t c_byteMask = (1ull << c_maskBitsPerByte) - 1;
+
+        //
+        // Returns a mask with c_maskBitsPerByte bits set for every comma and line
+        // feed in the given 16 bytes.
+        //
+        uint64_t GetDelimiterMask(
+            _In_reads_(c_blockSize) const char* block)
+        {
+#if IO_CSV_READER_SSE2
+            const __m128i bytes =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+
+            const __m128i delimiters = _mm_or_si128(
+                _mm_cmpeq_epi8(bytes, _mm_set1_epi8(',')),
+                _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+
+            return static_cast<uint32_t>(_mm_movemask_epi8(delimiters));
+#elif IO_CSV_READER_NEON
+            const uint8x16_t bytes =
+                vld1q_u8(reinterpret_cast<const uint8_t*>(block));
+
+            const uint8x16_t delimiters = vorrq_u8(
+                vceqq_u8(bytes, vdupq_n_u8(',')),
+                vceqq_u8(bytes, vdupq_n_u8('\n')));
+
+            const uint8x8_t nibbles =
+                vshrn_n_u16(vreinterpretq_u16_u8(delimiters), 4);
+
+            return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+#else
+            uint64_t mask = 0;
+
+            for (size_t i = 0; i < c_blockSize; ++i)
+            {
+                if (',' == block[i] || '\n' == block[i])
+                {
+                    mask |= c_byteMask << (i * c_maskBitsPerByte);
+                }
+            }
+
+            return mask;
+#endif
+        }
+
+        uint32_t CountTrailingZeros(
+            _In_ const uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+
+            if (_BitScanForward(&index, static_cast<uint32_t>(value)))
+            {
+                return index;
+            }
+
+            _BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+
+            return 32 + index;
+#else
+            return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+        }
+
+        bool IsTrailingWhitespace(
+            _In_ const char c)
+        {
+            return ' ' == c || '\t' == c || '\r' == c || '\n' == c;
+        }
+    }
+
+    _Use_decl_annotations_
+    bool CsvField::operator==(
+        const char* text) const
+    {
+        const size_t length = strlen(text);
+
+        return length == Size && 0 == memcmp(Data, text, length);
+    }
+
+    CsvReader::CsvReader(
+        _In_reads_(size) const void* data,
+        _In_ const size_t size)
+        : _position(reinterpret_cast<const char*>(data))
+        , _end(reinterpret_cast<const char*>(data) + size)
+    {
+        _fields.reserve(64);
+    }
+
+    bool CsvReader::ReadRecord()
+    {
+        while (_position < _end)
+        {
+            const char* lineStart = _position;
+            const char* fieldStart = lineStart;
+            const char* lineEnd = nullptr;
+
+            _fields.clear();
+
+            const char* block = lineStart;
+
+            //
+            // Record the fields delimited by the commas of this line, 16 bytes at
+            // a time. The tail of the buffer is scanned byte by byte.
+            //
+            while (nullptr == lineEnd && block < _end)
+            {
+                uint64_t mask;
+
+                if (static_cast<size_t>(_end - block) >= c_blockSize)
+                {
+                    mask = GetDelimiterMask(block);
+                }
+                else
+                {
+                    mask = 0;
+
+                    for (size_t i = 0; block + i < _end; ++i)
+                    {
+                        if (',' == block[i] || '\n' == block[i])
+                        {
+                            mask |= c_byteMask << (i * c_maskBitsPerByte);
+                        }
+                    }
+                }
+
+                while (0 != mask)
+                {
+                    const uint32_t index =
+                        CountTrailingZeros(mask) / c_maskBitsPerByte;
+
+                    mask &= ~(c_byteMask << (index * c_maskBitsPerByte));
+
+                    const char* delimiter = block + index;
+
+                    _fields.push_back(
+                        { fieldStart, static_cast<size_t>(delimiter - fieldStart) });
+
+                    fieldStart = delimiter + 1;
+
+                    if ('\n' == *delimiter)
+                    {
+                        lineEnd = delimiter;
+                        break;
+                    }
+                }
+
+                block += c_blockSize;
+            }
+
+            if (nullptr == lineEnd)
+            {
+                // The last line is not terminated.
+                lineEnd = _end;
+
+                _fields.push_back(
+                    { fieldStart, static_cast<size_t>(_end - fieldStart) });
+
+                _position = _end;
+            }
+            else
+            {
+                _position = lineEnd + 1;
+            }
+
+            CsvField& lastField = _fields.back();
+
+            while (lastField.Size > 0 && IsTrailingWhitespace(lastField.Data[lastField.Size - 1]))
+            {
+                --lastField.Size;
+            }
+
+            //
+            // Skip comments and empty lines.
+            //
+            if ('#' == *lineStart || (1 == _fields.size() && 0 == lastField.Size))
+            {
+                continue;
+            }
+
+            return true;
+        }
+
+        _fields.clear();
+
+        return false;
+    }
+
+    const CsvField& CsvReader::GetField(
+        _In_ const size_t index) const
+    {
+        REQUIRES(index < _fields.size());
+
+        return _fields[index];
+    }
+
+    uint64_t CsvReader::GetUInt64(
+        _In_ const size_t index) const
+    {
+        const CsvField& field = GetField(index);
+
+        uint64_t value;
+        ASSERT(ParseUInt64(field.Data, field.Data + field.Size, &value));
+
+        return value;
+    }
+
+    int64_t CsvReader::GetInt64(
+        _In_ const size_t index) const
+    {
+        const CsvField& field = GetField(index);
+
+        int64_t value;
+        ASSERT(ParseInt64(field.Data, field.Data + field.Size, &value));
+
+        return value;
+    }
+
+    float CsvReader::GetFloat(
+        _In_ const size_t index) const
+    {
+        const CsvField& field = GetField(index);
+
+        float value;
+        ASSERT(ParseFloat(field.Data, field.Data + field.Size, &value));
+
+        return value;
+    }
+
+    double CsvReader::GetDouble(
+        _In_ const size_t index) const
+    {
+        const CsvField& field = GetField(index);
+
+        double value;
+        ASSERT(ParseDouble(field.Data, field.Data + field.Size, &value));
+
+        return value;
+    }
+
+    void CsvReader::GetFloats(
+        _In_ const size_t firstIndex,
+        _In_ const size_t count,
+        _Out_writes_(count) float* values) const
+    {
+        REQUIRES(firstIndex + count <= _fields.size());
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const CsvField& field = _fields[firstIndex + i];
+
+            ASSERT(ParseFloat(field.Data, field.Data + field.Size, &values[i]));
+        }
+    }
+}
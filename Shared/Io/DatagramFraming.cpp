@@ -0,0 +1,457 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see DatagramReassembler.
+//
+#include <Io/DatagramFraming.h>
+
+#include <cstdlib>
+
+namespace Io
+{
+    DatagramFragmenter::DatagramFragmenter(
+        _In_ const size_t maximumDatagramSize)
+        : _maximumFragmentSize(0)
+        , _nextSequenceNumber(0)
+        , _nextFrameId(0)
+    {
+        REQUIRES(maximumDatagramSize > sizeof(DatagramHeader));
+
+        _maximumFragmentSize =
+            maximumDatagramSize - sizeof(DatagramHeader);
+
+        _datagram.resize(
+            maximumDatagramSize);
+    }
+
+    uint32_t DatagramFragmenter::BeginFrame(
+        _In_ const size_t frameLength) const
+    {
+        REQUIRES(frameLength <= UINT32_MAX);
+
+        //
+        // Empty frames still take a datagram, so that the receiver sees them.
+        //
+        const size_t fragmentCount =
+            std::max<size_t>(
+                1,
+                (frameLength + _maximumFragmentSize - 1) / _maximumFragmentSize);
+
+        REQUIRES(fragmentCount <= UINT16_MAX);
+
+        return static_cast<uint32_t>(fragmentCount);
+    }
+
+    DatagramReassembler::DatagramReassembler(
+        _In_ const Clock::duration deadline,
+        _In_ const size_t maximumPendingFrames,
+        _In_ const size_t maximumFrameLength)
+        : _deadline(deadline)
+        , _maximumPendingFrames(maximumPendingFrames)
+        , _maximumFrameLength(maximumFrameLength)
+        , _isStarted(false)
+        , _nextFrameId(0)
+        , _firstSequenceNumber(0)
+        , _highestSequenceNumber(0)
+        , _sequenceNumbersReceived(0)
+        , _hasTransitTime(false)
+        , _previousTransitTimeInMicroseconds(0)
+        , _jitterInMicroseconds(0.0)
+        , _totalLatencyInSeconds(0.0)
+        , _statistics()
+    {
+        REQUIRES(maximumPendingFrames > 0);
+        REQUIRES(maximumFrameLength <= UINT32_MAX);
+    }
+
+    void DatagramReassembler::AddDatagram(
+        _In_reads_(size) const uint8_t* datagram,
+        _In_ const size_t size,
+        _In_ const Clock::time_point arrivalTime)
+    {
+        ++_statistics.DatagramsReceived;
+
+        if (size < sizeof(DatagramHeader))
+        {
+            ++_statistics.DatagramsMalformed;
+
+            return;
+        }
+
+        DatagramHeader header;
+
+        memcpy(
+            &header,
+            datagram,
+            sizeof(header));
+
+        const size_t fragmentSize =
+            size - sizeof(header);
+
+        if (DatagramCookie != header.Cookie ||
+            0 == header.FragmentCount ||
+            header.FragmentIndex >= header.FragmentCount ||
+            header.FrameLength > _maximumFrameLength ||
+            header.FragmentOffset > header.FrameLength ||
+            fragmentSize > header.FrameLength - header.FragmentOffset)
+        {
+            ++_statistics.DatagramsMalformed;
+
+            return;
+        }
+
+        if (!_isStarted)
+        {
+            _nextFrameId = header.FrameId;
+            _isStarted = true;
+        }
+
+        PendingFrame* frame = nullptr;
+
+        if (static_cast<int32_t>(header.FrameId - _nextFrameId) >= 0)
+        {
+            frame = FindOrAddFrame(
+                header,
+                arrivalTime);
+
+            if (nullptr == frame &&
+                static_cast<int32_t>(header.FrameId - _nextFrameId) >= 0)
+            {
+                ++_statistics.DatagramsMalformed;
+
+                return;
+            }
+
+            if (nullptr != frame &&
+                frame->FragmentsReceived[header.FragmentIndex])
+            {
+                ++_statistics.DatagramsDuplicated;
+
+                return;
+            }
+        }
+
+        UpdateSequenceStatistics(
+            header.SequenceNumber);
+
+        UpdateJitter(
+            header.SendTime,
+            arrivalTime);
+
+        //
+        // The frame was delivered or dropped already.
+        //
+        if (nullptr == frame)
+        {
+            ++_statistics.DatagramsLate;
+
+            return;
+        }
+
+        if (fragmentSize > 0)
+        {
+            memcpy(
+                frame->Data.data() + header.FragmentOffset,
+                datagram + sizeof(header),
+                fragmentSize);
+        }
+
+        frame->FragmentsReceived[header.FragmentIndex] = true;
+        ++frame->NumberOfFragmentsReceived;
+        frame->BytesReceived += fragmentSize;
+    }
+
+    bool DatagramReassembler::TryGetFrame(
+        _In_ const Clock::time_point now,
+        _Inout_ std::vector<uint8_t>* frame)
+    {
+        REQUIRES(nullptr != frame);
+
+        while (!_pendingFrames.empty())
+        {
+            PendingFrameMap::iterator oldestFrame =
+                _pendingFrames.begin();
+
+            if (oldestFrame->first == _nextFrameId &&
+                IsComplete(oldestFrame->second))
+            {
+                const double latencyInSeconds =
+                    std::chrono::duration<double>(
+                        now - oldestFrame->second.FirstArrivalTime).count();
+
+                ++_statistics.FramesDelivered;
+
+                _totalLatencyInSeconds += latencyInSeconds;
+
+                _statistics.MaximumLatencyInSeconds =
+                    std::max(
+                        _statistics.MaximumLatencyInSeconds,
+                        latencyInSeconds);
+
+                frame->swap(
+                    oldestFrame->second.Data);
+
+                if (_spareBuffers.size() < _maximumPendingFrames)
+                {
+                    _spareBuffers.emplace_back(
+                        std::move(oldestFrame->second.Data));
+                }
+
+                _pendingFrames.erase(
+                    oldestFrame);
+
+                ++_nextFrameId;
+
+                return true;
+            }
+
+            if (now - oldestFrame->second.FirstArrivalTime < _deadline)
+            {
+                return false;
+            }
+
+            //
+            // Past its deadline: give up on the frames that never showed up
+            // before it, and on the frame itself if it is still incomplete.
+            //
+            if (oldestFrame->first != _nextFrameId)
+            {
+                SkipTo(
+                    oldestFrame->first);
+            }
+            else
+            {
+                DropOldestFrame();
+            }
+        }
+
+        return false;
+    }
+
+    bool DatagramReassembler::GetNextDeadline(
+        _Out_ Clock::time_point* deadline) const
+    {
+        REQUIRES(nullptr != deadline);
+
+        if (_pendingFrames.empty())
+        {
+            return false;
+        }
+
+        *deadline =
+            _pendingFrames.begin()->second.FirstArrivalTime + _deadline;
+
+        return true;
+    }
+
+    DatagramReassemblyStatistics DatagramReassembler::GetStatistics() const
+    {
+        DatagramReassemblyStatistics statistics =
+            _statistics;
+
+        if (_sequenceNumbersReceived > 0)
+        {
+            const uint64_t sequenceNumbersExpected =
+                static_cast<uint64_t>(
+                    _highestSequenceNumber - _firstSequenceNumber + 1);
+
+            statistics.DatagramsLost =
+                sequenceNumbersExpected > _sequenceNumbersReceived
+                    ? sequenceNumbersExpected - _sequenceNumbersReceived
+                    : 0;
+        }
+
+        if (statistics.FramesDelivered > 0)
+        {
+            statistics.AverageLatencyInSeconds =
+                _totalLatencyInSeconds / statistics.FramesDelivered;
+        }
+
+        statistics.JitterInSeconds =
+            _jitterInMicroseconds * 1e-6;
+
+        return statistics;
+    }
+
+    void DatagramReassembler::UpdateSequenceStatistics(
+        _In_ const uint32_t sequenceNumber)
+    {
+        if (0 == _sequenceNumbersReceived)
+        {
+            _firstSequenceNumber = sequenceNumber;
+            _highestSequenceNumber = sequenceNumber;
+        }
+        else
+        {
+            //
+            // Sequence numbers are compared modulo 2^32, and extended to 64
+            // bits from the closest one received so far.
+            //
+            const int32_t distance =
+                static_cast<int32_t>(
+                    sequenceNumber - static_cast<uint32_t>(_highestSequenceNumber));
+
+            if (distance > 0)
+            {
+                _highestSequenceNumber += distance;
+            }
+            else
+            {
+                ++_statistics.DatagramsReordered;
+
+                _firstSequenceNumber =
+                    std::min(
+                        _firstSequenceNumber,
+                        _highestSequenceNumber + distance);
+            }
+        }
+
+        ++_sequenceNumbersReceived;
+    }
+
+    void DatagramReassembler::UpdateJitter(
+        _In_ const uint64_t sendTimeInMicroseconds,
+        _In_ const Clock::time_point arrivalTime)
+    {
+        //
+        // The clocks of the sender and of the receiver need not agree: only
+        // the changes of the transit time matter.
+        //
+        const int64_t arrivalTimeInMicroseconds =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                arrivalTime.time_since_epoch()).count();
+
+        const int64_t transitTimeInMicroseconds =
+            arrivalTimeInMicroseconds - static_cast<int64_t>(sendTimeInMicroseconds);
+
+        if (_hasTransitTime)
+        {
+            const double transitTimeChangeInMicroseconds =
+                static_cast<double>(std::abs(
+                    transitTimeInMicroseconds - _previousTransitTimeInMicroseconds));
+
+            _jitterInMicroseconds +=
+                (transitTimeChangeInMicroseconds - _jitterInMicroseconds) / 16.0;
+        }
+
+        _previousTransitTimeInMicroseconds = transitTimeInMicroseconds;
+        _hasTransitTime = true;
+    }
+
+    DatagramReassembler::PendingFrame* DatagramReassembler::FindOrAddFrame(
+        _In_ const DatagramHeader& header,
+        _In_ const Clock::time_point arrivalTime)
+    {
+        PendingFrameMap::iterator pendingFrame =
+            _pendingFrames.find(
+                header.FrameId);
+
+        if (_pendingFrames.end() != pendingFrame)
+        {
+            PendingFrame& frame =
+                pendingFrame->second;
+
+            if (frame.Data.size() != header.FrameLength ||
+                frame.FragmentCount != header.FragmentCount)
+            {
+                return nullptr;
+            }
+
+            return &frame;
+        }
+
+        if (_pendingFrames.size() >= _maximumPendingFrames)
+        {
+            //
+            // Later frames take precedence: a frame older than all the pending
+            // ones is given up on right away.
+            //
+            if (FrameIdLess()(header.FrameId, _pendingFrames.begin()->first))
+            {
+                SkipTo(
+                    header.FrameId + 1);
+
+                return nullptr;
+            }
+
+            while (_pendingFrames.size() >= _maximumPendingFrames)
+            {
+                DropOldestFrame();
+            }
+        }
+
+        PendingFrame& frame =
+            _pendingFrames[header.FrameId];
+
+        if (!_spareBuffers.empty())
+        {
+            frame.Data.swap(
+                _spareBuffers.back());
+
+            _spareBuffers.pop_back();
+        }
+
+        frame.Data.resize(
+            header.FrameLength);
+
+        frame.FragmentsReceived.assign(
+            header.FragmentCount,
+            false);
+
+        frame.FragmentCount = header.FragmentCount;
+        frame.NumberOfFragmentsReceived = 0;
+        frame.BytesReceived = 0;
+        frame.FirstArrivalTime = arrivalTime;
+
+        return &frame;
+    }
+
+    bool DatagramReassembler::IsComplete(
+        _In_ const PendingFrame& frame) const
+    {
+        return
+            frame.NumberOfFragmentsReceived == frame.FragmentCount &&
+            frame.BytesReceived == frame.Data.size();
+    }
+
+    void DatagramReassembler::SkipTo(
+        _In_ const uint32_t frameId)
+    {
+        ASSERT(static_cast<int32_t>(frameId - _nextFrameId) >= 0);
+
+        _statistics.FramesDropped +=
+            frameId - _nextFrameId;
+
+        _nextFrameId = frameId;
+    }
+
+    void DatagramReassembler::DropOldestFrame()
+    {
+        ASSERT(!_pendingFrames.empty());
+
+        PendingFrameMap::iterator oldestFrame =
+            _pendingFrames.begin();
+
+        SkipTo(
+            oldestFrame->first + 1);
+
+        if (_spareBuffers.size() < _maximumPendingFrames)
+        {
+            _spareBuffers.emplace_back(
+                std::move(oldestFrame->second.Data));
+        }
+
+        _pendingFrames.erase(
+            oldestFrame);
+    }
+}
@@ -0,0 +1,1137 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+//
+// Built without the precompiled header; see FrameCompressor.
+//
+#include <Io/FrameCodec.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Io
+{
+    namespace
+    {
+        //
+        // LZ4 block format parameters.
+        //
+        const size_t c_lz4MinMatch = 4;
+        const size_t c_lz4LastLiterals = 5;
+        const size_t c_lz4MatchFindLimit = 12;
+        const size_t c_lz4MaxDistance = 65535;
+        const uint32_t c_lz4HashLog = 12;
+
+        //
+        // Rice coding parameters of the depth codec. Residuals whose unary
+        // part would exceed c_riceEscapeLength are stored verbatim.
+        //
+        const uint32_t c_riceEscapeLength = 24;
+        const uint32_t c_riceEscapeBits = 17;
+        const uint32_t c_riceResetCount = 64;
+
+        uint32_t ReadUInt32(
+            _In_ const uint8_t* p)
+        {
+            uint32_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t Lz4Hash(
+            _In_ const uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - c_lz4HashLog);
+        }
+
+        uint8_t* Lz4WriteLength(
+            _In_ size_t length,
+            _Out_ uint8_t* output)
+        {
+            while (length >= 255)
+            {
+                *output++ = 255;
+                length -= 255;
+            }
+
+            *output++ = static_cast<uint8_t>(length);
+
+            return output;
+        }
+
+        uint32_t CountTrailingZeros(
+            _In_ const uint64_t value)
+        {
+#if defined(_MSC_VER)
+            unsigned long index = 0;
+
+            if (_BitScanForward(&index, static_cast<uint32_t>(value)))
+            {
+                return index;
+            }
+
+            _BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+
+            return index + 32;
+#else
+            return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+        }
+
+        //
+        // Writes bits starting with the least significant bit of each byte.
+        //
+        class BitWriter
+        {
+        public:
+            BitWriter(
+                _Out_writes_(capacity) uint8_t* output,
+                _In_ const size_t capacity)
+                : _output(output)
+                , _capacity(capacity)
+                , _size(0)
+                , _bits(0)
+                , _numberOfBits(0)
+            {
+            }
+
+            // Writes up to 32 bits.
+            void Write(
+                _In_ const uint32_t value,
+                _In_ const uint32_t numberOfBits)
+            {
+                _bits |= static_cast<uint64_t>(value) << _numberOfBits;
+                _numberOfBits += numberOfBits;
+
+                if (_numberOfBits >= 32)
+                {
+                    ASSERT(_size + 4 <= _capacity);
+
+                    const uint32_t word = static_cast<uint32_t>(_bits);
+                    memcpy(_output + _size, &word, sizeof(word));
+
+                    _size += 4;
+                    _bits >>= 32;
+                    _numberOfBits -= 32;
+                }
+            }
+
+            size_t Finish()
+            {
+                while (_numberOfBits > 0)
+                {
+                    ASSERT(_size < _capacity);
+
+                    _output[_size++] = static_cast<uint8_t>(_bits);
+                    _bits >>= 8;
+                    _numberOfBits = _numberOfBits > 8 ? _numberOfBits - 8 : 0;
+                }
+
+                return _size;
+            }
+
+        private:
+            uint8_t* _output;
+            size_t _capacity;
+            size_t _size;
+
+            uint64_t _bits;
+            uint32_t _numberOfBits;
+        };
+
+        class BitReader
+        {
+        public:
+            BitReader(
+                _In_reads_(size) const uint8_t* input,
+                _In_ const size_t size)
+                : _input(input)
+                , _size(size)
+                , _position(0)
+                , _bits(0)
+                , _numberOfBits(0)
+            {
+                Refill();
+            }
+
+            // Returns the next 32 bits without consuming them.
+            uint32_t Peek()
+            {
+                if (_numberOfBits < 32)
+                {
+                    Refill();
+                }
+
+                return static_cast<uint32_t>(_bits);
+            }
+
+            void Skip(
+                _In_ const uint32_t numberOfBits)
+            {
+                ASSERT(numberOfBits <= _numberOfBits);
+
+                _bits >>= numberOfBits;
+                _numberOfBits -= numberOfBits;
+            }
+
+            // Reads up to 32 bits.
+            uint32_t Read(
+                _In_ const uint32_t numberOfBits)
+            {
+                if (0 == numberOfBits)
+                {
+                    return 0;
+                }
+
+                const uint32_t value =
+                    Peek() & (0xffffffffu >> (32 - numberOfBits));
+
+                Skip(numberOfBits);
+
+                return value;
+            }
+
+        private:
+            void Refill()
+            {
+                //
+                // Past the end of the input the stream reads as zeros; the
+                // number of valid bits is tracked so that Skip fails there.
+                //
+                while (_numberOfBits <= 56 && _position < _size)
+                {
+                    _bits |= static_cast<uint64_t>(_input[_position++]) << _numberOfBits;
+                    _numberOfBits += 8;
+                }
+            }
+
+            const uint8_t* _input;
+            size_t _size;
+            size_t _position;
+
+            uint64_t _bits;
+            uint32_t _numberOfBits;
+        };
+
+        //
+        // Median edge detector predictor from LOCO-I / JPEG-LS.
+        //
+        int32_t PredictDepth(
+            _In_ const int32_t left,
+            _In_ const int32_t up,
+            _In_ const int32_t upLeft)
+        {
+            const int32_t minimum = std::min<int32_t>(left, up);
+            const int32_t maximum = std::max<int32_t>(left, up);
+
+            if (upLeft >= maximum)
+            {
+                return minimum;
+            }
+            else if (upLeft <= minimum)
+            {
+                return maximum;
+            }
+
+            return left + up - upLeft;
+        }
+
+        int32_t PredictDepthAt(
+            _In_ const uint16_t* row,
+            _In_opt_ const uint16_t* previousRow,
+            _In_ const uint32_t x)
+        {
+            if (nullptr == previousRow)
+            {
+                return (0 == x) ? 0 : row[x - 1];
+            }
+            else if (0 == x)
+            {
+                return previousRow[0];
+            }
+
+            return PredictDepth(
+                row[x - 1],
+                previousRow[x],
+                previousRow[x - 1]);
+        }
+
+        //
+        // Adaptive selection of the Rice parameter from the running mean of the
+        // mapped residuals.
+        //
+        class RiceParameter
+        {
+        public:
+            RiceParameter()
+                : _sum(16)
+                , _count(1)
+            {
+            }
+
+            uint32_t Get() const
+            {
+                uint32_t k = 0;
+
+                while ((_count << k) < _sum && k < 16)
+                {
+                    ++k;
+                }
+
+                return k;
+            }
+
+            void Update(
+                _In_ const uint32_t mappedResidual)
+            {
+                _sum += mappedResidual;
+                ++_count;
+
+                if (_count == c_riceResetCount)
+                {
+                    _sum >>= 1;
+                    _count >>= 1;
+                }
+            }
+
+        private:
+            uint32_t _sum;
+            uint32_t _count;
+        };
+
+        //
+        // Tiles of the delta codec, visited row of tiles by row of tiles. The
+        // tiles on the right and bottom edges may be smaller.
+        //
+        template <typename TVisitor>
+        void ForEachDeltaTile(
+            _In_ const uint32_t rowLength,
+            _In_ const uint32_t numberOfRows,
+            _In_ TVisitor visitor)
+        {
+            for (uint32_t tileY = 0; tileY < numberOfRows; tileY += DeltaTileSize)
+            {
+                const uint32_t tileHeight =
+                    std::min(DeltaTileSize, numberOfRows - tileY);
+
+                for (uint32_t tileX = 0; tileX < rowLength; tileX += DeltaTileSize)
+                {
+                    const uint32_t tileWidth =
+                        std::min(DeltaTileSize, rowLength - tileX);
+
+                    visitor(
+                        static_cast<size_t>(tileY) * rowLength + tileX,
+                        tileWidth,
+                        tileHeight);
+                }
+            }
+        }
+
+        template <typename TSample>
+        size_t DeltaCompressSamples(
+            _In_ const TSample* pixels,
+            _In_ const TSample* previousPixels,
+            _In_ const uint32_t rowLength,
+            _In_ const uint32_t numberOfRows,
+            _Out_writes_(outputCapacity) uint8_t* output,
+            _In_ const size_t outputCapacity)
+        {
+            //
+            // Differences are taken modulo the sample range, so that they fit
+            // in a sample, and sign extended from its top bit.
+            //
+            const uint32_t sampleBits = 8 * sizeof(TSample);
+            const uint32_t sampleMask = (1u << sampleBits) - 1;
+            const uint32_t signBit = 1u << (sampleBits - 1);
+
+            BitWriter writer(
+                output,
+                outputCapacity);
+
+            RiceParameter riceParameter;
+
+            ForEachDeltaTile(
+                rowLength,
+                numberOfRows,
+                [&](size_t tileOffset, uint32_t tileWidth, uint32_t tileHeight)
+            {
+                bool isChanged = false;
+
+                for (uint32_t y = 0; y < tileHeight && !isChanged; ++y)
+                {
+                    const size_t rowOffset = tileOffset + static_cast<size_t>(y) * rowLength;
+
+                    isChanged = 0 != memcmp(
+                        pixels + rowOffset,
+                        previousPixels + rowOffset,
+                        tileWidth * sizeof(TSample));
+                }
+
+                writer.Write(isChanged ? 1 : 0, 1);
+
+                if (!isChanged)
+                {
+                    return;
+                }
+
+                for (uint32_t y = 0; y < tileHeight; ++y)
+                {
+                    const size_t rowOffset = tileOffset + static_cast<size_t>(y) * rowLength;
+
+                    const TSample* row = pixels + rowOffset;
+                    const TSample* previousRow = previousPixels + rowOffset;
+
+                    for (uint32_t x = 0; x < tileWidth; ++x)
+                    {
+                        const uint32_t difference =
+                            (static_cast<uint32_t>(row[x]) - previousRow[x]) & sampleMask;
+
+                        const int32_t residual =
+                            static_cast<int32_t>(difference ^ signBit) - static_cast<int32_t>(signBit);
+
+                        const uint32_t mappedResidual =
+                            (static_cast<uint32_t>(residual) << 1) ^ static_cast<uint32_t>(residual >> 31);
+
+                        const uint32_t k = riceParameter.Get();
+                        const uint32_t quotient = mappedResidual >> k;
+
+                        if (quotient < c_riceEscapeLength)
+                        {
+                            writer.Write(1u << quotient, quotient + 1);
+                            writer.Write(mappedResidual & ((1u << k) - 1), k);
+                        }
+                        else
+                        {
+                            writer.Write(1u << c_riceEscapeLength, c_riceEscapeLength + 1);
+                            writer.Write(mappedResidual, sampleBits);
+                        }
+
+                        riceParameter.Update(mappedResidual);
+                    }
+                }
+            });
+
+            return writer.Finish();
+        }
+
+        template <typename TSample>
+        void DeltaDecompressSamples(
+            _In_reads_(inputSize) const uint8_t* input,
+            _In_ const size_t inputSize,
+            _In_ const uint32_t rowLength,
+            _In_ const uint32_t numberOfRows,
+            _Inout_ TSample* pixels)
+        {
+            const uint32_t sampleBits = 8 * sizeof(TSample);
+            const uint32_t sampleMask = (1u << sampleBits) - 1;
+
+            BitReader reader(
+                input,
+                inputSize);
+
+            RiceParameter riceParameter;
+
+            ForEachDeltaTile(
+                rowLength,
+                numberOfRows,
+                [&](size_t tileOffset, uint32_t tileWidth, uint32_t tileHeight)
+            {
+                if (0 == reader.Read(1))
+                {
+                    return;
+                }
+
+                for (uint32_t y = 0; y < tileHeight; ++y)
+                {
+                    TSample* row = pixels + tileOffset + static_cast<size_t>(y) * rowLength;
+
+                    for (uint32_t x = 0; x < tileWidth; ++x)
+                    {
+                        const uint32_t k = riceParameter.Get();
+                        const uint32_t peekedBits = reader.Peek();
+
+                        ASSERT(0 != (peekedBits & ((1u << (c_riceEscapeLength + 1)) - 1)));
+
+                        const uint32_t quotient = CountTrailingZeros(peekedBits);
+
+                        reader.Skip(quotient + 1);
+
+                        uint32_t mappedResidual = 0;
+
+                        if (quotient < c_riceEscapeLength)
+                        {
+                            mappedResidual = (quotient << k) | reader.Read(k);
+                        }
+                        else
+                        {
+                            mappedResidual = reader.Read(sampleBits);
+                        }
+
+                        const int32_t residual =
+                            static_cast<int32_t>(mappedResidual >> 1) ^ -static_cast<int32_t>(mappedResidual & 1);
+
+                        row[x] = static_cast<TSample>(
+                            (static_cast<uint32_t>(row[x]) + static_cast<uint32_t>(residual)) & sampleMask);
+
+                        riceParameter.Update(mappedResidual);
+                    }
+                }
+            });
+        }
+    }
+
+    const wchar_t* GetFrameCodecFileExtension(
+        _In_ const FrameCodec codec)
+    {
+        switch (codec)
+        {
+        case FrameCodec::Raw:
+            return L"";
+
+        //
+        // The codec is recorded in the CompressedFrameHeader, so all of the
+        // compressed frames share the extension of their container format.
+        //
+        case FrameCodec::Lz4:
+        case FrameCodec::Depth:
+            return L".hlfc";
+
+        default:
+            ASSERT(false);
+            return L"";
+        }
+    }
+
+    size_t Lz4CompressBound(
+        _In_ const size_t inputSize)
+    {
+        return inputSize + inputSize / 255 + 16;
+    }
+
+    Lz4Compressor::Lz4Compressor()
+        : _hashTable(size_t(1) << c_lz4HashLog)
+    {
+    }
+
+    size_t Lz4Compressor::Compress(
+        _In_reads_(inputSize) const uint8_t* input,
+        _In_ const size_t inputSize,
+        _Out_writes_(outputCapacity) uint8_t* output,
+        _In_ const size_t outputCapacity)
+    {
+        REQUIRES(outputCapacity >= Lz4CompressBound(inputSize));
+        REQUIRES(inputSize < 0x7e000000);
+
+        const uint8_t* anchor = input;
+        uint8_t* op = output;
+
+        if (inputSize >= c_lz4MatchFindLimit + 1)
+        {
+            std::fill(_hashTable.begin(), _hashTable.end(), 0);
+
+            const uint8_t* const matchLimit = input + inputSize - c_lz4LastLiterals;
+            const uint8_t* const matchFindLimit = input + inputSize - c_lz4MatchFindLimit;
+
+            const uint8_t* ip = input + 1;
+
+            while (ip < matchFindLimit)
+            {
+                //
+                // Find a match, skipping faster through incompressible data.
+                //
+                const uint8_t* match = nullptr;
+                uint32_t searchCount = 1 << 6;
+
+                while (ip < matchFindLimit)
+                {
+                    const uint32_t hash = Lz4Hash(ReadUInt32(ip));
+
+                    match = input + _hashTable[hash];
+                    _hashTable[hash] = static_cast<uint32_t>(ip - input);
+
+                    if (match < ip &&
+                        static_cast<size_t>(ip - match) <= c_lz4MaxDistance &&
+                        ReadUInt32(match) == ReadUInt32(ip))
+                    {
+                        break;
+                    }
+
+                    match = nullptr;
+                    ip += searchCount++ >> 6;
+                }
+
+                if (nullptr == match)
+                {
+                    break;
+                }
+
+                //
+                // Extend the match backwards over pending literals.
+                //
+                while (ip > anchor && match > input && ip[-1] == match[-1])
+                {
+                    --ip;
+                    --match;
+                }
+
+                //
+                // Extend the match forwards.
+                //
+                size_t matchLength = c_lz4MinMatch;
+
+                while (ip + matchLength < matchLimit && ip[matchLength] == match[matchLength])
+                {
+                    ++matchLength;
+                }
+
+                //
+                // Emit the sequence.
+                //
+                const size_t literalLength = static_cast<size_t>(ip - anchor);
+                uint8_t* token = op++;
+
+                *token = static_cast<uint8_t>(
+                    (std::min<size_t>(literalLength, 15) << 4) |
+                    std::min<size_t>(matchLength - c_lz4MinMatch, 15));
+
+                if (literalLength >= 15)
+                {
+                    op = Lz4WriteLength(literalLength - 15, op);
+                }
+
+                memcpy(op, anchor, literalLength);
+                op += literalLength;
+
+                const uint16_t offset = static_cast<uint16_t>(ip - match);
+                memcpy(op, &offset, sizeof(offset));
+                op += sizeof(offset);
+
+                if (matchLength - c_lz4MinMatch >= 15)
+                {
+                    op = Lz4WriteLength(matchLength - c_lz4MinMatch - 15, op);
+                }
+
+                ip += matchLength;
+                anchor = ip;
+
+                if (ip < matchFindLimit)
+                {
+                    _hashTable[Lz4Hash(ReadUInt32(ip - 2))] =
+                        static_cast<uint32_t>(ip - 2 - input);
+                }
+            }
+        }
+
+        //
+        // The block ends with a sequence made of literals only.
+        //
+        const size_t lastLiteralLength =
+            static_cast<size_t>(input + inputSize - anchor);
+
+        *op++ = static_cast<uint8_t>(std::min<size_t>(lastLiteralLength, 15) << 4);
+
+        if (lastLiteralLength >= 15)
+        {
+            op = Lz4WriteLength(lastLiteralLength - 15, op);
+        }
+
+        memcpy(op, anchor, lastLiteralLength);
+        op += lastLiteralLength;
+
+        ENSURES(static_cast<size_t>(op - output) <= outputCapacity);
+
+        return static_cast<size_t>(op - output);
+    }
+
+    void Lz4Decompress(
+        _In_reads_(inputSize) const uint8_t* input,
+        _In_ const size_t inputSize,
+        _Out_writes_(outputSize) uint8_t* output,
+        _In_ const size_t outputSize)
+    {
+        const uint8_t* ip = input;
+        const uint8_t* const inputEnd = input + inputSize;
+
+        uint8_t* op = output;
+        uint8_t* const outputEnd = output + outputSize;
+
+        while (true)
+        {
+            ASSERT(ip < inputEnd);
+
+            const uint8_t token = *ip++;
+
+            //
+            // Literals.
+            //
+            size_t literalLength = token >> 4;
+
+            if (15 == literalLength)
+            {
+                uint8_t b = 0;
+
+                do
+                {
+                    ASSERT(ip < inputEnd);
+                    b = *ip++;
+                    literalLength += b;
+                } while (255 == b);
+            }
+
+            ASSERT(literalLength <= static_cast<size_t>(inputEnd - ip));
+            ASSERT(literalLength <= static_cast<size_t>(outputEnd - op));
+
+            memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            if (ip == inputEnd)
+            {
+                break;
+            }
+
+            //
+            // Match.
+            //
+            ASSERT(2 <= inputEnd - ip);
+
+            const size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+
+            ASSERT(0 != offset && offset <= static_cast<size_t>(op - output));
+
+            size_t matchLength = token & 0x0f;
+
+            if (15 == matchLength)
+            {
+                uint8_t b = 0;
+
+                do
+                {
+                    ASSERT(ip < inputEnd);
+                    b = *ip++;
+                    matchLength += b;
+                } while (255 == b);
+            }
+
+            matchLength += c_lz4MinMatch;
+
+            ASSERT(matchLength <= static_cast<size_t>(outputEnd - op));
+
+            const uint8_t* match = op - offset;
+
+            if (offset >= matchLength)
+            {
+                memcpy(op, match, matchLength);
+                op += matchLength;
+            }
+            else
+            {
+                // Overlapping copy repeats the last offset bytes.
+                for (size_t i = 0; i < matchLength; ++i)
+                {
+                    *op++ = *match++;
+                }
+            }
+        }
+
+        ENSURES(op == outputEnd);
+    }
+
+    size_t DepthCompressBound(
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows)
+    {
+        const size_t maxBitsPerPixel =
+            c_riceEscapeLength + 1 + c_riceEscapeBits;
+
+        return (static_cast<size_t>(rowLength) * numberOfRows * maxBitsPerPixel + 7) / 8 + 8;
+    }
+
+    size_t DepthCompress(
+        _In_ const uint16_t* pixels,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Out_writes_(outputCapacity) uint8_t* output,
+        _In_ const size_t outputCapacity)
+    {
+        BitWriter writer(
+            output,
+            outputCapacity);
+
+        RiceParameter riceParameter;
+
+        const uint16_t* previousRow = nullptr;
+
+        for (uint32_t y = 0; y < numberOfRows; ++y)
+        {
+            const uint16_t* row = pixels + static_cast<size_t>(y) * rowLength;
+
+            for (uint32_t x = 0; x < rowLength; ++x)
+            {
+                const int32_t residual =
+                    static_cast<int32_t>(row[x]) - PredictDepthAt(row, previousRow, x);
+
+                // Zigzag mapping of the residual to an unsigned value.
+                const uint32_t mappedResidual =
+                    (static_cast<uint32_t>(residual) << 1) ^ static_cast<uint32_t>(residual >> 31);
+
+                const uint32_t k = riceParameter.Get();
+                const uint32_t quotient = mappedResidual >> k;
+
+                if (quotient < c_riceEscapeLength)
+                {
+                    // Unary quotient: zeros terminated by a one.
+                    writer.Write(1u << quotient, quotient + 1);
+                    writer.Write(mappedResidual & ((1u << k) - 1), k);
+                }
+                else
+                {
+                    writer.Write(1u << c_riceEscapeLength, c_riceEscapeLength + 1);
+                    writer.Write(mappedResidual, c_riceEscapeBits);
+                }
+
+                riceParameter.Update(mappedResidual);
+            }
+
+            previousRow = row;
+        }
+
+        return writer.Finish();
+    }
+
+    void DepthDecompress(
+        _In_reads_(inputSize) const uint8_t* input,
+        _In_ const size_t inputSize,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Out_ uint16_t* pixels)
+    {
+        BitReader reader(
+            input,
+            inputSize);
+
+        RiceParameter riceParameter;
+
+        const uint16_t* previousRow = nullptr;
+
+        for (uint32_t y = 0; y < numberOfRows; ++y)
+        {
+            uint16_t* row = pixels + static_cast<size_t>(y) * rowLength;
+
+            for (uint32_t x = 0; x < rowLength; ++x)
+            {
+                const uint32_t k = riceParameter.Get();
+
+                //
+                // The unary part is at most c_riceEscapeLength zeros, so it
+                // always fits in the peeked bits.
+                //
+                const uint32_t peekedBits = reader.Peek();
+
+                ASSERT(0 != (peekedBits & ((1u << (c_riceEscapeLength + 1)) - 1)));
+
+                const uint32_t quotient = CountTrailingZeros(peekedBits);
+
+                reader.Skip(quotient + 1);
+
+                uint32_t mappedResidual = 0;
+
+                if (quotient < c_riceEscapeLength)
+                {
+                    mappedResidual = (quotient << k) | reader.Read(k);
+                }
+                else
+                {
+                    mappedResidual = reader.Read(c_riceEscapeBits);
+                }
+
+                const int32_t residual =
+                    static_cast<int32_t>(mappedResidual >> 1) ^ -static_cast<int32_t>(mappedResidual & 1);
+
+                const int32_t value =
+                    PredictDepthAt(row, previousRow, x) + residual;
+
+                ASSERT(0 <= value && value <= 0xffff);
+
+                row[x] = static_cast<uint16_t>(value);
+
+                riceParameter.Update(mappedResidual);
+            }
+
+            previousRow = row;
+        }
+    }
+
+    size_t DeltaCompressBound(
+        _In_ const uint32_t bytesPerSample,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows)
+    {
+        const size_t numberOfTiles =
+            static_cast<size_t>((rowLength + DeltaTileSize - 1) / DeltaTileSize) *
+            ((numberOfRows + DeltaTileSize - 1) / DeltaTileSize);
+
+        const size_t maxBitsPerSample =
+            c_riceEscapeLength + 1 + 8 * bytesPerSample;
+
+        return (numberOfTiles + static_cast<size_t>(rowLength) * numberOfRows * maxBitsPerSample + 7) / 8 + 8;
+    }
+
+    size_t DeltaCompress(
+        _In_ const uint8_t* pixels,
+        _In_ const uint8_t* previousPixels,
+        _In_ const uint32_t bytesPerSample,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Out_writes_(outputCapacity) uint8_t* output,
+        _In_ const size_t outputCapacity)
+    {
+        REQUIRES(1 == bytesPerSample || 2 == bytesPerSample);
+
+        if (1 == bytesPerSample)
+        {
+            return DeltaCompressSamples(
+                pixels,
+                previousPixels,
+                rowLength,
+                numberOfRows,
+                output,
+                outputCapacity);
+        }
+
+        REQUIRES(0 == reinterpret_cast<uintptr_t>(pixels) % alignof(uint16_t));
+        REQUIRES(0 == reinterpret_cast<uintptr_t>(previousPixels) % alignof(uint16_t));
+
+        return DeltaCompressSamples(
+            reinterpret_cast<const uint16_t*>(pixels),
+            reinterpret_cast<const uint16_t*>(previousPixels),
+            rowLength,
+            numberOfRows,
+            output,
+            outputCapacity);
+    }
+
+    void DeltaDecompress(
+        _In_reads_(inputSize) const uint8_t* input,
+        _In_ const size_t inputSize,
+        _In_ const uint32_t bytesPerSample,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Inout_ uint8_t* pixels)
+    {
+        REQUIRES(1 == bytesPerSample || 2 == bytesPerSample);
+
+        if (1 == bytesPerSample)
+        {
+            DeltaDecompressSamples(
+                input,
+                inputSize,
+                rowLength,
+                numberOfRows,
+                pixels);
+
+            return;
+        }
+
+        REQUIRES(0 == reinterpret_cast<uintptr_t>(pixels) % alignof(uint16_t));
+
+        DeltaDecompressSamples(
+            input,
+            inputSize,
+            rowLength,
+            numberOfRows,
+            reinterpret_cast<uint16_t*>(pixels));
+    }
+
+    FrameCodec FrameCompressor::Compress(
+        _In_ const FrameCodec requestedCodec,
+        _In_reads_(bitmapHeaderSize) const uint8_t* bitmapHeader,
+        _In_ const size_t bitmapHeaderSize,
+        _In_reads_(pixelDataSize) const uint8_t* pixelData,
+        _In_ const size_t pixelDataSize,
+        _In_ const uint32_t numberOfRows,
+        _In_ const bool is16BitPerPixel)
+    {
+        REQUIRES(FrameCodec::Raw != requestedCodec);
+        REQUIRES(bitmapHeaderSize <= UINT16_MAX);
+        REQUIRES(numberOfRows > 0);
+
+        FrameCodec codec = requestedCodec;
+
+        //
+        // The depth codec needs whole rows of 16-bit samples.
+        //
+        if (FrameCodec::Depth == codec &&
+            (!is16BitPerPixel || 0 != pixelDataSize % (static_cast<size_t>(numberOfRows) * 2)))
+        {
+            codec = FrameCodec::Lz4;
+        }
+
+        const uint32_t rowLength =
+            static_cast<uint32_t>(pixelDataSize / numberOfRows / (FrameCodec::Depth == codec ? 2 : 1));
+
+        const size_t compressBound =
+            (FrameCodec::Depth == codec) ?
+            DepthCompressBound(rowLength, numberOfRows) :
+            Lz4CompressBound(pixelDataSize);
+
+        const size_t payloadOffset =
+            sizeof(CompressedFrameHeader) + bitmapHeaderSize;
+
+        if (_compressedFrame.size() < payloadOffset + compressBound)
+        {
+            _compressedFrame.resize(payloadOffset + compressBound);
+        }
+
+        CompressedFrameHeader header = {};
+
+        header.Cookie = CompressedFrameCookie;
+        header.Codec = static_cast<uint16_t>(codec);
+        header.BitmapHeaderSize = static_cast<uint16_t>(bitmapHeaderSize);
+        header.RowLength = rowLength;
+        header.NumberOfRows = numberOfRows;
+        header.PixelDataSize = pixelDataSize;
+
+        memcpy(_compressedFrame.data(), &header, sizeof(header));
+        memcpy(_compressedFrame.data() + sizeof(header), bitmapHeader, bitmapHeaderSize);
+
+        uint8_t* payload = _compressedFrame.data() + payloadOffset;
+        size_t payloadSize = 0;
+
+        if (FrameCodec::Depth == codec)
+        {
+            //
+            // Copy the pixels when they are not 2-byte aligned.
+            //
+            const uint16_t* depthPixels =
+                reinterpret_cast<const uint16_t*>(pixelData);
+
+            std::vector<uint16_t> alignedPixels;
+
+            if (0 != reinterpret_cast<uintptr_t>(pixelData) % alignof(uint16_t))
+            {
+                alignedPixels.resize(pixelDataSize / 2);
+                memcpy(alignedPixels.data(), pixelData, pixelDataSize);
+                depthPixels = alignedPixels.data();
+            }
+
+            payloadSize = DepthCompress(
+                depthPixels,
+                rowLength,
+                numberOfRows,
+                payload,
+                compressBound);
+        }
+        else
+        {
+            payloadSize = _lz4Compressor.Compress(
+                pixelData,
+                pixelDataSize,
+                payload,
+                compressBound);
+        }
+
+        //
+        // Keep incompressible frames as they are.
+        //
+        if (payloadSize >= pixelDataSize)
+        {
+            _compressedFrameSize = 0;
+
+            return FrameCodec::Raw;
+        }
+
+        _compressedFrameSize = payloadOffset + payloadSize;
+
+        return codec;
+    }
+
+    bool IsCompressedFrame(
+        _In_reads_(size) const uint8_t* data,
+        _In_ const size_t size)
+    {
+        return
+            size >= sizeof(CompressedFrameHeader) &&
+            CompressedFrameCookie == ReadUInt32(data);
+    }
+
+    void DecompressFrame(
+        _In_reads_(size) const uint8_t* data,
+        _In_ const size_t size,
+        _Out_ std::vector<uint8_t>& bitmapFile)
+    {
+        REQUIRES(IsCompressedFrame(data, size));
+
+        CompressedFrameHeader header;
+        memcpy(&header, data, sizeof(header));
+
+        const size_t payloadOffset =
+            sizeof(CompressedFrameHeader) + header.BitmapHeaderSize;
+
+        REQUIRES(payloadOffset <= size);
+        REQUIRES(header.PixelDataSize <= SIZE_MAX - header.BitmapHeaderSize);
+
+        bitmapFile.resize(
+            header.BitmapHeaderSize + static_cast<size_t>(header.PixelDataSize));
+
+        memcpy(
+            bitmapFile.data(),
+            data + sizeof(CompressedFrameHeader),
+            header.BitmapHeaderSize);
+
+        uint8_t* pixelData =
+            bitmapFile.data() + header.BitmapHeaderSize;
+
+        switch (static_cast<FrameCodec>(header.Codec))
+        {
+        case FrameCodec::Lz4:
+            Lz4Decompress(
+                data + payloadOffset,
+                size - payloadOffset,
+                pixelData,
+                static_cast<size_t>(header.PixelDataSize));
+            break;
+
+        case FrameCodec::Depth:
+        {
+            REQUIRES(
+                static_cast<uint64_t>(header.RowLength) * header.NumberOfRows * 2 ==
+                header.PixelDataSize);
+
+            std::vector<uint16_t> depthPixels(
+                static_cast<size_t>(header.PixelDataSize) / 2);
+
+            DepthDecompress(
+                data + payloadOffset,
+                size - payloadOffset,
+                header.RowLength,
+                header.NumberOfRows,
+                depthPixels.data());
+
+            memcpy(
+                pixelData,
+                depthPixels.data(),
+                static_cast<size_t>(header.PixelDataSize));
+
+            break;
+        }
+
+        default:
+            REQUIRES(false);
+            break;
+        }
+    }
+}
@@ -0,0 +1,306 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see FrameHeaderExtensionType.
+//
+#include <Io/FrameHeaderExtensions.h>
+
+#include <cstring>
+
+namespace Io
+{
+    namespace
+    {
+        void AppendBytes(
+            _In_reads_(size) const void* data,
+            _In_ const size_t size,
+            _Inout_ std::vector<uint8_t>& extensionBlock)
+        {
+            const uint8_t* bytes =
+                static_cast<const uint8_t*>(data);
+
+            extensionBlock.insert(
+                extensionBlock.end(),
+                bytes,
+                bytes + size);
+        }
+
+        void AppendRecord(
+            _In_ const FrameHeaderExtensionType type,
+            _In_reads_(size) const void* payload,
+            _In_ const size_t size,
+            _Inout_ std::vector<uint8_t>& extensionBlock)
+        {
+            FrameHeaderExtensionRecordHeader recordHeader = {};
+
+            recordHeader.Type = static_cast<uint16_t>(type);
+            recordHeader.Length = static_cast<uint32_t>(size);
+
+            AppendBytes(&recordHeader, sizeof(recordHeader), extensionBlock);
+            AppendBytes(payload, size, extensionBlock);
+        }
+
+        //
+        // Reads a fixed size payload. Records may grow in later versions of the
+        // protocol by appending fields, so longer payloads are accepted.
+        //
+        template <typename T>
+        bool ReadPayload(
+            _In_reads_(size) const uint8_t* payload,
+            _In_ const size_t size,
+            _Out_ T* value)
+        {
+            if (size < sizeof(T))
+            {
+                return false;
+            }
+
+            memcpy(value, payload, sizeof(T));
+
+            return true;
+        }
+
+        bool DecodeUnprojectionLut(
+            _In_reads_(size) const uint8_t* payload,
+            _In_ const size_t size,
+            _Inout_ FrameHeaderExtensions& extensions)
+        {
+            UnprojectionLutHeader lutHeader;
+
+            if (!ReadPayload(payload, size, &lutHeader))
+            {
+                return false;
+            }
+
+            //
+            // The size of the LUT comes from the network. The pixel count is
+            // computed in 64 bits, where it cannot overflow, and checked against
+            // the payload before anything is derived from it.
+            //
+            const size_t pointsSize =
+                size - sizeof(lutHeader);
+
+            const uint64_t pixelCount =
+                static_cast<uint64_t>(lutHeader.ImageWidth) * lutHeader.ImageHeight;
+
+            if (0 != pointsSize % (2 * sizeof(float)) ||
+                pixelCount != pointsSize / (2 * sizeof(float)))
+            {
+                return false;
+            }
+
+            //
+            // The points of the payload are not aligned; copy them out before
+            // splitting them into the planes of the LUT.
+            //
+            std::vector<float> points(
+                2 * static_cast<size_t>(pixelCount));
+
+            if (!points.empty())
+            {
+                memcpy(
+                    points.data(),
+                    payload + sizeof(lutHeader),
+                    pointsSize);
+            }
+
+            auto unprojectionLut =
+                std::make_shared<UnprojectionLut>();
+
+            unprojectionLut->Assign(
+                lutHeader.ImageWidth,
+                lutHeader.ImageHeight,
+                points.data());
+
+            //
+            // The hash is what later frames refer to the LUT by, so make sure it
+            // matches the points we got. The LUT stores the points that do not
+            // map to the unit plane as NaN, as the sender's LUT did.
+            //
+            if (HashUnprojectionLut(*unprojectionLut) != lutHeader.Hash)
+            {
+                return false;
+            }
+
+            extensions.HasUnprojectionLutReference = true;
+            extensions.UnprojectionLutReference = lutHeader;
+            extensions.UnprojectionLut = std::move(unprojectionLut);
+
+            return true;
+        }
+    }
+
+    void EncodeFrameHeaderExtensions(
+        _In_ const FrameHeaderExtensions& extensions,
+        _Out_ std::vector<uint8_t>& extensionBlock)
+    {
+        extensionBlock.clear();
+
+        if (extensions.HasTransforms)
+        {
+            AppendRecord(
+                FrameHeaderExtensionType::Transforms,
+                &extensions.Transforms,
+                sizeof(extensions.Transforms),
+                extensionBlock);
+        }
+
+        if (extensions.HasPixelFormat)
+        {
+            AppendRecord(
+                FrameHeaderExtensionType::PixelFormat,
+                &extensions.PixelFormat,
+                sizeof(extensions.PixelFormat),
+                extensionBlock);
+        }
+
+        if (extensions.HasPinholeIntrinsics)
+        {
+            AppendRecord(
+                FrameHeaderExtensionType::PinholeIntrinsics,
+                &extensions.Pinhole,
+                sizeof(extensions.Pinhole),
+                extensionBlock);
+        }
+
+        if (nullptr != extensions.UnprojectionLut)
+        {
+            const UnprojectionLut& unprojectionLut =
+                *extensions.UnprojectionLut;
+
+            UnprojectionLutHeader lutHeader = {};
+
+            lutHeader.Hash = HashUnprojectionLut(unprojectionLut);
+            lutHeader.ImageWidth = unprojectionLut.GetImageWidth();
+            lutHeader.ImageHeight = unprojectionLut.GetImageHeight();
+
+            const size_t pointCount =
+                static_cast<size_t>(lutHeader.ImageWidth) * lutHeader.ImageHeight;
+
+            const size_t pointsSize =
+                2 * pointCount * sizeof(float);
+
+            FrameHeaderExtensionRecordHeader recordHeader = {};
+
+            recordHeader.Type = static_cast<uint16_t>(FrameHeaderExtensionType::UnprojectionLut);
+            recordHeader.Length = static_cast<uint32_t>(sizeof(lutHeader) + pointsSize);
+
+            AppendBytes(&recordHeader, sizeof(recordHeader), extensionBlock);
+            AppendBytes(&lutHeader, sizeof(lutHeader), extensionBlock);
+
+            //
+            // Points are streamed as (x, y) pairs, row by row.
+            //
+            extensionBlock.reserve(
+                extensionBlock.size() + pointsSize);
+
+            for (size_t i = 0; i < pointCount; ++i)
+            {
+                AppendBytes(unprojectionLut.GetX() + i, sizeof(float), extensionBlock);
+                AppendBytes(unprojectionLut.GetY() + i, sizeof(float), extensionBlock);
+            }
+        }
+        else if (extensions.HasUnprojectionLutReference)
+        {
+            AppendRecord(
+                FrameHeaderExtensionType::UnprojectionLutReference,
+                &extensions.UnprojectionLutReference,
+                sizeof(extensions.UnprojectionLutReference),
+                extensionBlock);
+        }
+
+        REQUIRES(extensionBlock.size() <= FrameHeaderExtensionsMaximumLength);
+    }
+
+    bool DecodeFrameHeaderExtensions(
+        _In_reads_(size) const uint8_t* extensionBlock,
+        _In_ const size_t size,
+        _Out_ FrameHeaderExtensions& extensions)
+    {
+        extensions = FrameHeaderExtensions();
+
+        if (size > FrameHeaderExtensionsMaximumLength)
+        {
+            return false;
+        }
+
+        size_t offset = 0;
+
+        while (offset < size)
+        {
+            FrameHeaderExtensionRecordHeader recordHeader;
+
+            if (size - offset < sizeof(recordHeader))
+            {
+                return false;
+            }
+
+            memcpy(&recordHeader, extensionBlock + offset, sizeof(recordHeader));
+
+            offset += sizeof(recordHeader);
+
+            if (size - offset < recordHeader.Length)
+            {
+                return false;
+            }
+
+            const uint8_t* payload =
+                extensionBlock + offset;
+
+            const size_t payloadSize =
+                recordHeader.Length;
+
+            offset += payloadSize;
+
+            bool succeeded = true;
+
+            switch (static_cast<FrameHeaderExtensionType>(recordHeader.Type))
+            {
+            case FrameHeaderExtensionType::Transforms:
+                succeeded = ReadPayload(payload, payloadSize, &extensions.Transforms);
+                extensions.HasTransforms = succeeded;
+                break;
+
+            case FrameHeaderExtensionType::PixelFormat:
+                succeeded = ReadPayload(payload, payloadSize, &extensions.PixelFormat);
+                extensions.HasPixelFormat = succeeded;
+                break;
+
+            case FrameHeaderExtensionType::PinholeIntrinsics:
+                succeeded = ReadPayload(payload, payloadSize, &extensions.Pinhole);
+                extensions.HasPinholeIntrinsics = succeeded;
+                break;
+
+            case FrameHeaderExtensionType::UnprojectionLutReference:
+                succeeded = ReadPayload(payload, payloadSize, &extensions.UnprojectionLutReference);
+                extensions.HasUnprojectionLutReference = succeeded;
+                extensions.UnprojectionLut = nullptr;
+                break;
+
+            case FrameHeaderExtensionType::UnprojectionLut:
+                succeeded = DecodeUnprojectionLut(payload, payloadSize, extensions);
+                break;
+
+            default:
+                break;
+            }
+
+            if (!succeeded)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
@@ -15,7 +15,27 @@
 #include <Io/TimeConverter.h>
 #include <Io/Timer.h>
 #include <Io/StorageHandleAccess.h>
+#include <Io/TarArchive.h>
+#include <Io/TarIndex.h>
 #include <Io/Tar.h>
+#include <Io/FrameCodec.h>
+#include <Io/MemoryMappedFile.h>
+#include <Io/PoseLog.h>
+#include <Io/WriteBehindQueue.h>
+#include <Io/FrameRing.h>
+#include <Io/FrameSendQueue.h>
+#include <Io/FrameFanOut.h>
+#include <Io/FramePool.h>
+#include <Io/StreamScheduler.h>
+#include <Io/DatagramFraming.h>
+#include <Io/UnprojectionLut.h>
+#include <Io/PointCloud.h>
+#include <Io/FrameHeaderExtensions.h>
 #include <Io/BufferHelpers.h>
+#include <Io/PixelFormatConversion.h>
+#include <Io/PseudoColor.h>
 #include <Io/StringHelpers.h>
+#include <Io/NumberFormatting.h>
+#include <Io/NumberParsing.h>
+#include <Io/CsvReader.h>
 #include <Io/IoHelpers.h>
\ No newline at end of file
@@ -0,0 +1,102 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Io
+{
+    //
+    // A field of a CSV record. Points into the buffer given to the CsvReader.
+    //
+    struct CsvField
+    {
+        const char* Data;
+        size_t Size;
+
+        bool operator==(
+            _In_z_ const char* text) const;
+
+        std::string ToString() const
+        {
+            return std::string(Data, Size);
+        }
+    };
+
+    //
+    // Zero-copy reader for the CSV files written by the recorder. Works on an
+    // in-memory buffer, typically a MemoryMappedFile, which must outlive the
+    // reader. Record boundaries and delimiters are located 16 bytes at a time
+    // with SIMD compares, and fields are parsed in place.
+    //
+    // Empty lines and lines starting with '#' are skipped, trailing whitespace
+    // is ignored. Quoted fields are not supported, as CsvWriter does not
+    // produce them.
+    //
+    class CsvReader
+    {
+    public:
+        CsvReader(
+            _In_reads_(size) const void* data,
+            _In_ const size_t size);
+
+        //
+        // Advances to the next record. Returns false at the end of the buffer.
+        //
+        bool ReadRecord();
+
+        size_t GetFieldCount() const
+        {
+            return _fields.size();
+        }
+
+        const CsvField& GetField(
+            _In_ const size_t index) const;
+
+        //
+        // Typed accessors for the fields of the current record. Throw if the
+        // field does not hold a number of the requested type.
+        //
+        uint64_t GetUInt64(
+            _In_ const size_t index) const;
+
+        int64_t GetInt64(
+            _In_ const size_t index) const;
+
+        float GetFloat(
+            _In_ const size_t index) const;
+
+        double GetDouble(
+            _In_ const size_t index) const;
+
+        //
+        // Parses a run of consecutive float fields into caller provided storage,
+        // e.g. a column of a struct-of-arrays or the elements of a matrix.
+        //
+        void GetFloats(
+            _In_ const size_t firstIndex,
+            _In_ const size_t count,
+            _Out_writes_(count) float* values) const;
+
+    private:
+        const char* _position;
+        const char* _end;
+
+        std::vector<CsvField> _fields;
+    };
+}
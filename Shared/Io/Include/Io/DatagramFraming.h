@@ -0,0 +1,296 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Datagram transport of serialized frames. A frame is split into fragments
+    // that each fit a datagram, after a DatagramHeader. Datagrams may be lost,
+    // duplicated or reordered on the way; the receiver puts the frames back
+    // together and gives up on those that don't complete in time.
+    //
+    // Clients subscribe to a stream by sending DatagramSubscribeCookie to the
+    // server, and keep doing so while they want the stream.
+    //
+    const uint32_t DatagramCookie = 0x47444c48; // 'HLDG'
+    const uint32_t DatagramSubscribeCookie = 0x53444c48; // 'HLDS'
+
+    // Fits an Ethernet MTU of 1500 bytes, after the IPv4 and UDP headers.
+    const size_t DatagramDefaultMaximumSize = 1472;
+
+#pragma pack (push, 1)
+    struct DatagramHeader
+    {
+        uint32_t Cookie;
+        uint32_t SequenceNumber;    // Counts the datagrams of the stream.
+        uint32_t FrameId;           // Counts the frames of the stream.
+        uint32_t FrameLength;
+        uint32_t FragmentOffset;
+        uint16_t FragmentIndex;
+        uint16_t FragmentCount;
+        uint64_t SendTime;          // Sender's clock, in microseconds.
+    };
+#pragma pack (pop)
+
+    //
+    // Splits the frames of a stream into datagrams.
+    //
+    class DatagramFragmenter
+    {
+    public:
+        explicit DatagramFragmenter(
+            _In_ const size_t maximumDatagramSize = DatagramDefaultMaximumSize);
+
+        size_t GetMaximumFragmentSize() const
+        {
+            return _maximumFragmentSize;
+        }
+
+        //
+        // Builds the datagrams of a frame, handing each of them to
+        // send(const uint8_t* datagram, size_t size). The datagram is only
+        // valid during the call. Returns the number of datagrams.
+        //
+        template <typename TSend>
+        uint32_t Fragment(
+            _In_reads_(frameLength) const uint8_t* frame,
+            _In_ const size_t frameLength,
+            _In_ const uint64_t sendTimeInMicroseconds,
+            _In_ TSend send)
+        {
+            const uint32_t fragmentCount =
+                BeginFrame(frameLength);
+
+            DatagramHeader header = {};
+
+            header.Cookie = DatagramCookie;
+            header.FrameId = _nextFrameId++;
+            header.FrameLength = static_cast<uint32_t>(frameLength);
+            header.FragmentCount = static_cast<uint16_t>(fragmentCount);
+            header.SendTime = sendTimeInMicroseconds;
+
+            for (uint32_t fragmentIndex = 0; fragmentIndex < fragmentCount; ++fragmentIndex)
+            {
+                const size_t fragmentOffset =
+                    fragmentIndex * _maximumFragmentSize;
+
+                const size_t fragmentSize =
+                    std::min(_maximumFragmentSize, frameLength - fragmentOffset);
+
+                header.SequenceNumber = _nextSequenceNumber++;
+                header.FragmentOffset = static_cast<uint32_t>(fragmentOffset);
+                header.FragmentIndex = static_cast<uint16_t>(fragmentIndex);
+
+                memcpy(
+                    _datagram.data(),
+                    &header,
+                    sizeof(header));
+
+                if (fragmentSize > 0)
+                {
+                    memcpy(
+                        _datagram.data() + sizeof(header),
+                        frame + fragmentOffset,
+                        fragmentSize);
+                }
+
+                send(
+                    static_cast<const uint8_t*>(_datagram.data()),
+                    sizeof(header) + fragmentSize);
+            }
+
+            return fragmentCount;
+        }
+
+    private:
+        // Returns the number of fragments of a frame.
+        uint32_t BeginFrame(
+            _In_ const size_t frameLength) const;
+
+    private:
+        size_t _maximumFragmentSize;
+        std::vector<uint8_t> _datagram;
+
+        uint32_t _nextSequenceNumber;
+        uint32_t _nextFrameId;
+    };
+
+    struct DatagramReassemblyStatistics
+    {
+        uint64_t DatagramsReceived;
+
+        // Missing from the sequence numbers received so far.
+        uint64_t DatagramsLost;
+
+        // Received after a datagram sent later.
+        uint64_t DatagramsReordered;
+
+        uint64_t DatagramsDuplicated;
+
+        // Received after their frame was delivered or dropped.
+        uint64_t DatagramsLate;
+
+        uint64_t DatagramsMalformed;
+
+        uint64_t FramesDelivered;
+
+        // Incomplete at their deadline, evicted to make room for later frames,
+        // or never received at all.
+        uint64_t FramesDropped;
+
+        // From the first datagram of a frame to its delivery.
+        double AverageLatencyInSeconds;
+        double MaximumLatencyInSeconds;
+
+        // Interarrival jitter of the datagrams, as defined by RTP (RFC 3550).
+        double JitterInSeconds;
+    };
+
+    //
+    // Puts the frames of a datagram stream back together, delivering them in
+    // order. An incomplete frame holds back the frames after it until it
+    // completes or until its deadline, measured from the arrival of its first
+    // datagram, has passed; it is then dropped. A frame of which no datagram
+    // arrived is given up on at the deadline of the next frame.
+    //
+    // Not thread safe.
+    //
+    class DatagramReassembler
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        //
+        // At most maximumPendingFrames frames are reassembled at the same time:
+        // the oldest one is dropped to make room for a new one. Datagrams of
+        // frames longer than maximumFrameLength are rejected.
+        //
+        DatagramReassembler(
+            _In_ const Clock::duration deadline,
+            _In_ const size_t maximumPendingFrames,
+            _In_ const size_t maximumFrameLength);
+
+        DatagramReassembler(const DatagramReassembler&) = delete;
+        DatagramReassembler& operator=(const DatagramReassembler&) = delete;
+
+        void AddDatagram(
+            _In_reads_(size) const uint8_t* datagram,
+            _In_ const size_t size,
+            _In_ const Clock::time_point arrivalTime);
+
+        //
+        // Takes the next frame if it is complete, first dropping the frames
+        // before it whose deadline has passed. The frame is swapped into the
+        // given buffer, whose previous storage is reused for later frames.
+        //
+        bool TryGetFrame(
+            _In_ const Clock::time_point now,
+            _Inout_ std::vector<uint8_t>* frame);
+
+        //
+        // When the oldest pending frame will be past its deadline, if there is
+        // one; receivers wait for datagrams until then at most.
+        //
+        bool GetNextDeadline(
+            _Out_ Clock::time_point* deadline) const;
+
+        DatagramReassemblyStatistics GetStatistics() const;
+
+    private:
+        struct PendingFrame
+        {
+            std::vector<uint8_t> Data;
+            std::vector<bool> FragmentsReceived;
+            uint32_t FragmentCount;
+            uint32_t NumberOfFragmentsReceived;
+            size_t BytesReceived;
+            Clock::time_point FirstArrivalTime;
+        };
+
+        //
+        // Orders frame identifiers across their wraparound, which holds as long
+        // as the pending frames are less than 2^31 frames apart.
+        //
+        struct FrameIdLess
+        {
+            bool operator()(
+                _In_ const uint32_t a,
+                _In_ const uint32_t b) const
+            {
+                return static_cast<int32_t>(a - b) < 0;
+            }
+        };
+
+        typedef std::map<uint32_t, PendingFrame, FrameIdLess> PendingFrameMap;
+
+        void UpdateSequenceStatistics(
+            _In_ const uint32_t sequenceNumber);
+
+        void UpdateJitter(
+            _In_ const uint64_t sendTimeInMicroseconds,
+            _In_ const Clock::time_point arrivalTime);
+
+        //
+        // Returns nullptr if the datagram doesn't match the other datagrams of
+        // its frame, or if the frame is given up on to make room for it.
+        //
+        PendingFrame* FindOrAddFrame(
+            _In_ const DatagramHeader& header,
+            _In_ const Clock::time_point arrivalTime);
+
+        bool IsComplete(
+            _In_ const PendingFrame& frame) const;
+
+        // Gives up on the frames before the given one.
+        void SkipTo(
+            _In_ const uint32_t frameId);
+
+        void DropOldestFrame();
+
+    private:
+        const Clock::duration _deadline;
+        const size_t _maximumPendingFrames;
+        const size_t _maximumFrameLength;
+
+        PendingFrameMap _pendingFrames;
+        std::vector<std::vector<uint8_t>> _spareBuffers;
+
+        // The frame to deliver next; frames before it were delivered or dropped.
+        bool _isStarted;
+        uint32_t _nextFrameId;
+
+        // Sequence numbers extended to 64 bits, so that they don't wrap around.
+        int64_t _firstSequenceNumber;
+        int64_t _highestSequenceNumber;
+        uint64_t _sequenceNumbersReceived;
+
+        bool _hasTransitTime;
+        int64_t _previousTransitTimeInMicroseconds;
+        double _jitterInMicroseconds;
+
+        double _totalLatencyInSeconds;
+
+        DatagramReassemblyStatistics _statistics;
+    };
+}
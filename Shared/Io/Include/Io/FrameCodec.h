@@ -0,0 +1,203 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Lossless codecs used to store sensor frames.
+    //
+    enum class FrameCodec : uint16_t
+    {
+        // The bitmap file is stored as is.
+        Raw = 0,
+
+        // The pixels are compressed using the LZ4 block format.
+        Lz4 = 1,
+
+        // 16-bit pixels are predicted from their neighbors (LOCO-I median
+        // predictor) and the residuals are adaptive Rice coded.
+        Depth = 2
+    };
+
+    //
+    // A compressed frame starts with this header, followed by the original
+    // bitmap file header (e.g. "P5\n448 450\n65535\n") and the compressed pixels.
+    // Decompressing yields the original bitmap file bit for bit.
+    //
+    const uint32_t CompressedFrameCookie = 0x43464c48; // 'HLFC'
+
+#pragma pack (push, 1)
+    struct CompressedFrameHeader
+    {
+        uint32_t Cookie;
+        uint16_t Codec;
+        uint16_t BitmapHeaderSize;
+        uint32_t RowLength;         // Samples per row, for the depth codec.
+        uint32_t NumberOfRows;
+        uint64_t PixelDataSize;     // Uncompressed size of the pixels.
+    };
+#pragma pack (pop)
+
+    //
+    // Returns the suffix appended to the name of a bitmap file stored with the
+    // given codec: ".hlfc" for compressed frames, which are not LZ4 frames
+    // and cannot be read by the lz4 tool.
+    //
+    const wchar_t* GetFrameCodecFileExtension(
+        _In_ const FrameCodec codec);
+
+    //
+    // LZ4 block format compression. The block does not store its uncompressed
+    // size; callers must keep track of it.
+    //
+    size_t Lz4CompressBound(
+        _In_ const size_t inputSize);
+
+    class Lz4Compressor
+    {
+    public:
+        Lz4Compressor();
+
+        // Returns the size of the compressed block.
+        size_t Compress(
+            _In_reads_(inputSize) const uint8_t* input,
+            _In_ const size_t inputSize,
+            _Out_writes_(outputCapacity) uint8_t* output,
+            _In_ const size_t outputCapacity);
+
+    private:
+        std::vector<uint32_t> _hashTable;
+    };
+
+    void Lz4Decompress(
+        _In_reads_(inputSize) const uint8_t* input,
+        _In_ const size_t inputSize,
+        _Out_writes_(outputSize) uint8_t* output,
+        _In_ const size_t outputSize);
+
+    //
+    // Predictive coding of 16-bit single channel images.
+    //
+    size_t DepthCompressBound(
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows);
+
+    // Returns the size of the compressed pixels.
+    size_t DepthCompress(
+        _In_ const uint16_t* pixels,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Out_writes_(outputCapacity) uint8_t* output,
+        _In_ const size_t outputCapacity);
+
+    void DepthDecompress(
+        _In_reads_(inputSize) const uint8_t* input,
+        _In_ const size_t inputSize,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Out_ uint16_t* pixels);
+
+    //
+    // Temporal coding of 8 or 16-bit single channel images against the previous
+    // image of the same size. The image is split into tiles of DeltaTileSize x
+    // DeltaTileSize samples; one bit per tile says whether it changed, and the
+    // differences of the changed tiles (modulo the sample range) are adaptive
+    // Rice coded. Unchanged tiles cost a single bit. 16-bit samples must be
+    // 2-byte aligned.
+    //
+    const uint32_t DeltaTileSize = 16;
+
+    size_t DeltaCompressBound(
+        _In_ const uint32_t bytesPerSample,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows);
+
+    // Returns the size of the compressed differences.
+    size_t DeltaCompress(
+        _In_ const uint8_t* pixels,
+        _In_ const uint8_t* previousPixels,
+        _In_ const uint32_t bytesPerSample,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Out_writes_(outputCapacity) uint8_t* output,
+        _In_ const size_t outputCapacity);
+
+    // Turns the previous image into the current one, in place.
+    void DeltaDecompress(
+        _In_reads_(inputSize) const uint8_t* input,
+        _In_ const size_t inputSize,
+        _In_ const uint32_t bytesPerSample,
+        _In_ const uint32_t rowLength,
+        _In_ const uint32_t numberOfRows,
+        _Inout_ uint8_t* pixels);
+
+    //
+    // Compresses bitmap files for storage, reusing its buffers across frames.
+    //
+    class FrameCompressor
+    {
+    public:
+        //
+        // Compresses a bitmap file made of a header and numberOfRows rows of
+        // pixels. The depth codec only applies to 16-bit pixels; other frames
+        // fall back to LZ4. Returns the codec that was used, or Raw when the
+        // frame did not compress and should be stored as is. The compressed
+        // file remains valid until the next call.
+        //
+        FrameCodec Compress(
+            _In_ const FrameCodec requestedCodec,
+            _In_reads_(bitmapHeaderSize) const uint8_t* bitmapHeader,
+            _In_ const size_t bitmapHeaderSize,
+            _In_reads_(pixelDataSize) const uint8_t* pixelData,
+            _In_ const size_t pixelDataSize,
+            _In_ const uint32_t numberOfRows,
+            _In_ const bool is16BitPerPixel);
+
+        const uint8_t* GetData() const
+        {
+            return _compressedFrame.data();
+        }
+
+        size_t GetSize() const
+        {
+            return _compressedFrameSize;
+        }
+
+    private:
+        Lz4Compressor _lz4Compressor;
+
+        std::vector<uint8_t> _compressedFrame;
+        size_t _compressedFrameSize = 0;
+    };
+
+    //
+    // Checks whether a stored file starts with a CompressedFrameHeader.
+    //
+    bool IsCompressedFrame(
+        _In_reads_(size) const uint8_t* data,
+        _In_ const size_t size);
+
+    //
+    // Restores the original bitmap file from a compressed frame.
+    //
+    void DecompressFrame(
+        _In_reads_(size) const uint8_t* data,
+        _In_ const size_t size,
+        _Out_ std::vector<uint8_t>& bitmapFile);
+}
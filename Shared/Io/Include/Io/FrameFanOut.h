@@ -0,0 +1,251 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/FrameSendQueue.h>
+#include <Io/Portability.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Hands the frames of a stream, encoded once, to several clients. Each client
+    // has its own send queue, with its own capacity and policy, so that a client
+    // that can not keep up only drops its own frames; only the Block policy makes
+    // the sender wait for it.
+    //
+    // Clients start their stream with a keyframe. A client is forgotten once its
+    // send queue has been closed, typically when a write to it failed.
+    //
+    template <typename TFrame, typename TConnection>
+    class FrameFanOut
+    {
+    public:
+        typedef FrameSendQueue<TFrame> SendQueue;
+
+        struct Client
+        {
+            std::shared_ptr<TConnection> Connection;
+            std::shared_ptr<SendQueue> Queue;
+        };
+
+        explicit FrameFanOut(
+            _In_ const size_t maximumClients)
+            : _maximumClients(maximumClients)
+        {
+            REQUIRES(maximumClients > 0);
+
+            _clients.reserve(
+                maximumClients);
+
+            _pushQueues.reserve(
+                maximumClients);
+        }
+
+        FrameFanOut(const FrameFanOut&) = delete;
+        FrameFanOut& operator=(const FrameFanOut&) = delete;
+
+        //
+        // Returns the send queue of the new client, or nullptr, leaving the
+        // connection alone, if there are already as many clients as allowed.
+        //
+        std::shared_ptr<SendQueue> AddClient(
+            _In_ const std::shared_ptr<TConnection>& connection,
+            _In_ const size_t queueCapacity,
+            _In_ const size_t maximumWritesInFlight,
+            _In_ const SendQueuePolicy policy)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            RemoveClosedClients();
+
+            if (_clients.size() == _maximumClients)
+            {
+                return nullptr;
+            }
+
+            ClientState client;
+
+            client.Connection = connection;
+            client.Queue =
+                std::make_shared<SendQueue>(
+                    queueCapacity,
+                    maximumWritesInFlight,
+                    policy);
+
+            client.AwaitingKeyframe = true;
+
+            _clients.push_back(
+                client);
+
+            return client.Queue;
+        }
+
+        size_t GetClientCount()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            RemoveClosedClients();
+
+            return _clients.size();
+        }
+
+        //
+        // The clients that are still connected, in the order they connected.
+        //
+        std::vector<Client> GetClients()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            RemoveClosedClients();
+
+            std::vector<Client> clients;
+
+            clients.reserve(
+                _clients.size());
+
+            for (const ClientState& client : _clients)
+            {
+                Client connectedClient;
+
+                connectedClient.Connection = client.Connection;
+                connectedClient.Queue = client.Queue;
+
+                clients.push_back(
+                    std::move(connectedClient));
+            }
+
+            return clients;
+        }
+
+        //
+        // Queues a frame for every client. Returns true if a client dropped it,
+        // or is waiting for a keyframe: the frames that depend on it are of no
+        // use to that client until the next keyframe. Frames are pushed one at
+        // a time, without allocating.
+        //
+        bool Push(
+            _In_ const TFrame& frame,
+            _In_ const size_t sizeInBytes,
+            _In_ const bool isKeyframe)
+        {
+            std::lock_guard<std::mutex> pushLock(_pushMutex);
+
+            bool keyframeWanted = false;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                RemoveClosedClients();
+
+                for (ClientState& client : _clients)
+                {
+                    if (client.AwaitingKeyframe && !isKeyframe)
+                    {
+                        keyframeWanted = true;
+
+                        continue;
+                    }
+
+                    client.AwaitingKeyframe = false;
+
+                    _pushQueues.push_back(
+                        client.Queue);
+                }
+            }
+
+            //
+            // Outside of the lock: with the Block policy, pushing waits for the
+            // client to make room.
+            //
+            for (const std::shared_ptr<SendQueue>& queue : _pushQueues)
+            {
+                if (!queue->Push(frame, sizeInBytes, isKeyframe))
+                {
+                    keyframeWanted = true;
+                }
+            }
+
+            _pushQueues.clear();
+
+            return keyframeWanted;
+        }
+
+        //
+        // Statistics of the clients that are still connected, in the order they
+        // connected.
+        //
+        std::vector<SendQueueStatistics> GetStatistics()
+        {
+            std::vector<SendQueueStatistics> statistics;
+
+            for (const Client& client : GetClients())
+            {
+                statistics.push_back(
+                    client.Queue->GetStatistics());
+            }
+
+            return statistics;
+        }
+
+        //
+        // Closes the send queues of all the clients, and forgets them.
+        //
+        void Close()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            for (const ClientState& client : _clients)
+            {
+                client.Queue->Close();
+            }
+
+            _clients.clear();
+        }
+
+    private:
+        struct ClientState
+        {
+            std::shared_ptr<TConnection> Connection;
+            std::shared_ptr<SendQueue> Queue;
+
+            // The client's stream hasn't started yet.
+            bool AwaitingKeyframe;
+        };
+
+        void RemoveClosedClients()
+        {
+            _clients.erase(
+                std::remove_if(
+                    _clients.begin(),
+                    _clients.end(),
+                    [](const ClientState& client) { return client.Queue->IsClosed(); }),
+                _clients.end());
+        }
+
+    private:
+        const size_t _maximumClients;
+
+        std::mutex _mutex;
+        std::vector<ClientState> _clients;
+
+        // The queues a frame is pushed to, outside of _mutex.
+        std::mutex _pushMutex;
+        std::vector<std::shared_ptr<SendQueue>> _pushQueues;
+    };
+}
@@ -0,0 +1,143 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+#include <Io/UnprojectionLut.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Per-frame metadata streamed after a version 0.2 sensor frame stream header:
+    // the camera pose, the pixel format and the camera intrinsics.
+    //
+    // The extension block is a sequence of records, each made of a
+    // FrameHeaderExtensionRecordHeader followed by Length bytes of payload.
+    // Receivers skip the records they do not know about, so that new records can
+    // be added without breaking them. All fields are little endian and the
+    // matrices are stored row major (m11, m12, ..., m44), matching
+    // Windows::Foundation::Numerics::float4x4.
+    //
+    // This code only depends on the C++ standard library so that it can be built
+    // into receivers running on other platforms.
+    //
+    enum class FrameHeaderExtensionType : uint16_t
+    {
+        // FrameTransforms.
+        Transforms = 1,
+
+        // A uint32_t holding a Windows::Graphics::Imaging::BitmapPixelFormat value.
+        PixelFormat = 2,
+
+        // PinholeIntrinsics.
+        PinholeIntrinsics = 3,
+
+        // UnprojectionLutHeader of an unprojection LUT sent with an earlier frame.
+        UnprojectionLutReference = 4,
+
+        // UnprojectionLutHeader followed by the LUT's points.
+        UnprojectionLut = 5
+    };
+
+    //
+    // The extension block is bounded so that receivers can reject a corrupted
+    // length before allocating for it.
+    //
+    const uint32_t FrameHeaderExtensionsMaximumLength = 32 * 1024 * 1024;
+
+#pragma pack (push, 1)
+    struct FrameHeaderExtensionRecordHeader
+    {
+        uint16_t Type;
+        uint16_t Reserved;
+        uint32_t Length;
+    };
+
+    struct FrameTransforms
+    {
+        float FrameToOrigin[16];
+        float CameraViewTransform[16];
+        float CameraProjectionTransform[16];
+    };
+
+    //
+    // Brown-Conrady lens model, as used by
+    // Windows::Media::Devices::Core::CameraIntrinsics.
+    //
+    struct PinholeIntrinsics
+    {
+        float FocalLength[2];
+        float PrincipalPoint[2];
+        float RadialDistortion[3];
+        float TangentialDistortion[2];
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+    };
+
+    struct UnprojectionLutHeader
+    {
+        uint64_t Hash;
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+    };
+#pragma pack (pop)
+
+    //
+    // The decoded extensions of a frame. Members are only meaningful when the
+    // matching Has... flag is set.
+    //
+    struct FrameHeaderExtensions
+    {
+        bool HasTransforms = false;
+        FrameTransforms Transforms = {};
+
+        bool HasPixelFormat = false;
+        uint32_t PixelFormat = 0;
+
+        bool HasPinholeIntrinsics = false;
+        PinholeIntrinsics Pinhole = {};
+
+        //
+        // Set when the frame refers to an unprojection LUT, whether the LUT was
+        // sent with this frame or an earlier one. UnprojectionLut is only set in
+        // the former case.
+        //
+        bool HasUnprojectionLutReference = false;
+        UnprojectionLutHeader UnprojectionLutReference = {};
+
+        std::shared_ptr<const Io::UnprojectionLut> UnprojectionLut;
+    };
+
+    //
+    // Replaces the contents of extensionBlock with the encoded extensions. When
+    // extensions.UnprojectionLut is set, the LUT itself is encoded; otherwise a
+    // reference to it is, if HasUnprojectionLutReference is set.
+    //
+    void EncodeFrameHeaderExtensions(
+        _In_ const FrameHeaderExtensions& extensions,
+        _Out_ std::vector<uint8_t>& extensionBlock);
+
+    //
+    // Decodes an extension block received from the network. Returns false if the
+    // block is malformed; records of unknown types are skipped.
+    //
+    bool DecodeFrameHeaderExtensions(
+        _In_reads_(size) const uint8_t* extensionBlock,
+        _In_ const size_t size,
+        _Out_ FrameHeaderExtensions& extensions);
+}
@@ -0,0 +1,196 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Size class of the buffers of a frame pool: the image size, and a format
+    // whose meaning is up to the allocator of the pool (e.g. a BitmapPixelFormat
+    // or an OpenCV type).
+    //
+    struct FramePoolKey
+    {
+        uint32_t Width;
+        uint32_t Height;
+        int32_t Format;
+
+        bool operator<(
+            _In_ const FramePoolKey& other) const
+        {
+            return
+                std::tie(Width, Height, Format) <
+                std::tie(other.Width, other.Height, other.Format);
+        }
+    };
+
+    struct FramePoolStatistics
+    {
+        uint64_t Acquisitions;
+
+        // Buffers created because none of the right size class was free.
+        uint64_t Allocations;
+
+        // Buffers in use, and the most that were in use at the same time, as
+        // observed when buffers are acquired.
+        size_t BuffersInUse;
+        size_t HighWaterMark;
+
+        size_t BuffersPooled;
+    };
+
+    //
+    // Recycles frame buffers (pixel buffers, bitmaps, images...) by size class,
+    // so that a steady stream of frames stops allocating once the pool has warmed
+    // up. Acquired buffers are shared pointers: a buffer goes back to the pool
+    // when its last reference is dropped, on any thread, and the pool hands it
+    // out again from then on.
+    //
+    // Up to maximumBuffersPerKey buffers of each size class are kept; buffers
+    // acquired beyond that are freed once dropped. Thread safe.
+    //
+    template <typename TBuffer>
+    class FramePool
+    {
+    public:
+        typedef std::function<TBuffer(const FramePoolKey&)> Allocator;
+
+        FramePool(
+            _In_ Allocator allocator,
+            _In_ const size_t maximumBuffersPerKey)
+            : _allocator(std::move(allocator))
+            , _maximumBuffersPerKey(maximumBuffersPerKey)
+            , _acquisitions(0)
+            , _allocations(0)
+            , _buffersInUse(0)
+            , _highWaterMark(0)
+            , _buffersPooled(0)
+        {
+        }
+
+        FramePool(const FramePool&) = delete;
+        FramePool& operator=(const FramePool&) = delete;
+
+        std::shared_ptr<TBuffer> Acquire(
+            _In_ const FramePoolKey& key)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            ++_acquisitions;
+
+            SizeClass& sizeClass = _sizeClasses[key];
+
+            //
+            // Only the pool hands out references to its buffers, and it does so
+            // under the lock: a buffer referenced by the pool alone stays free
+            // until it is handed out here. The fence orders this thread's use of
+            // the buffer after the last owner's release of it.
+            //
+            std::shared_ptr<TBuffer> buffer;
+            size_t buffersInUse = 0;
+
+            for (const std::shared_ptr<TBuffer>& pooledBuffer : sizeClass.Buffers)
+            {
+                if (1 != pooledBuffer.use_count())
+                {
+                    ++buffersInUse;
+                }
+                else if (nullptr == buffer)
+                {
+                    std::atomic_thread_fence(
+                        std::memory_order_acquire);
+
+                    buffer = pooledBuffer;
+                }
+            }
+
+            if (nullptr == buffer)
+            {
+                ++_allocations;
+
+                buffer = std::make_shared<TBuffer>(
+                    _allocator(key));
+
+                if (sizeClass.Buffers.size() < _maximumBuffersPerKey)
+                {
+                    sizeClass.Buffers.push_back(
+                        buffer);
+
+                    ++_buffersPooled;
+                }
+            }
+
+            //
+            // Buffers acquired beyond the pooled ones aren't tracked once handed
+            // out; they only count as in use while being acquired.
+            //
+            _buffersInUse -= sizeClass.BuffersInUse;
+            sizeClass.BuffersInUse = buffersInUse + 1;
+            _buffersInUse += sizeClass.BuffersInUse;
+
+            if (_buffersInUse > _highWaterMark)
+            {
+                _highWaterMark = _buffersInUse;
+            }
+
+            return buffer;
+        }
+
+        FramePoolStatistics GetStatistics()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            FramePoolStatistics statistics;
+
+            statistics.Acquisitions = _acquisitions;
+            statistics.Allocations = _allocations;
+            statistics.BuffersInUse = _buffersInUse;
+            statistics.HighWaterMark = _highWaterMark;
+            statistics.BuffersPooled = _buffersPooled;
+
+            return statistics;
+        }
+
+    private:
+        struct SizeClass
+        {
+            std::vector<std::shared_ptr<TBuffer>> Buffers;
+            size_t BuffersInUse = 0;
+        };
+
+        const Allocator _allocator;
+        const size_t _maximumBuffersPerKey;
+
+        std::mutex _mutex;
+        std::map<FramePoolKey, SizeClass> _sizeClasses;
+
+        uint64_t _acquisitions;
+        uint64_t _allocations;
+        size_t _buffersInUse;
+        size_t _highWaterMark;
+        size_t _buffersPooled;
+    };
+}
@@ -0,0 +1,377 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Fixed-capacity history of the most recent frames of a single sensor.
+    // Independent of the frame type: TFrame is a reference counted handle,
+    // e.g. HoloLensForCV::SensorFrame^ or a std::shared_ptr, that compares
+    // equal to nullptr when empty.
+    //
+    // There must be a single producer per ring (the media frame reader of the
+    // sensor); any number of threads may read concurrently. Readers never take
+    // a lock and never wait for the producer: each slot is published with a
+    // sequence number that lets readers detect a slot being overwritten under
+    // them, and the producer holds on to the frames it evicts until every reader
+    // that was active at the time has left, so that a reader can always safely
+    // copy the handle of a frame it found in a slot.
+    //
+    template <typename TFrame>
+    class FrameRing
+    {
+    public:
+        //
+        // A frame together with its timestamp, as seen by a reader.
+        //
+        struct Entry
+        {
+            int64_t Timestamp;
+            TFrame Frame;
+        };
+
+        explicit FrameRing(
+            _In_ const uint32_t capacity)
+            : _capacity(capacity)
+            , _slots(new Slot[capacity])
+            , _writeCount(0)
+            , _epoch(0)
+            , _slotFrames(capacity)
+        {
+            REQUIRES(capacity > 0);
+
+            _activeReaders[0] = 0;
+            _activeReaders[1] = 0;
+
+            for (uint32_t i = 0; i < _capacity; ++i)
+            {
+                _slots[i].Sequence = 0;
+                _slots[i].Timestamp = 0;
+                _slots[i].Frame = nullptr;
+            }
+        }
+
+        FrameRing(const FrameRing&) = delete;
+        FrameRing& operator=(const FrameRing&) = delete;
+
+        uint32_t GetCapacity() const
+        {
+            return _capacity;
+        }
+
+        //
+        // Number of frames pushed so far. Never decreases.
+        //
+        uint64_t GetWriteCount() const
+        {
+            return _writeCount.load();
+        }
+
+        //
+        // Adds a frame, evicting the oldest one once the ring is full. Must only
+        // be called from the producer thread.
+        //
+        void Push(
+            _In_ const TFrame& frame,
+            _In_ const int64_t timestamp)
+        {
+            REQUIRES(nullptr != frame);
+
+            const uint64_t ordinal = _writeCount.load(std::memory_order_relaxed);
+            const uint32_t slotIndex = static_cast<uint32_t>(ordinal % _capacity);
+
+            Slot& slot = _slots[slotIndex];
+
+            std::unique_ptr<TFrame> holder =
+                AcquireHolder(frame);
+
+            //
+            // Invalidate the slot, then publish the new frame in it.
+            //
+            slot.Sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            slot.Timestamp.store(timestamp, std::memory_order_relaxed);
+            slot.Frame.store(holder.get(), std::memory_order_relaxed);
+
+            slot.Sequence.store(ordinal + 1, std::memory_order_release);
+
+            _writeCount.store(ordinal + 1);
+
+            if (nullptr != _slotFrames[slotIndex])
+            {
+                RetireHolder(
+                    std::move(_slotFrames[slotIndex]));
+            }
+
+            _slotFrames[slotIndex] = std::move(holder);
+        }
+
+        //
+        // Returns the most recent frame, or an empty handle if there is none.
+        //
+        TFrame GetLatest() const
+        {
+            ReadGuard guard(*this);
+
+            for (;;)
+            {
+                const uint64_t writeCount = _writeCount.load();
+
+                if (0 == writeCount)
+                {
+                    return TFrame();
+                }
+
+                int64_t timestamp;
+                TFrame frame;
+
+                if (TryReadSlot(writeCount - 1, &timestamp, &frame))
+                {
+                    return frame;
+                }
+
+                //
+                // The producer lapped us while we were reading the slot; try
+                // again with the frame it has just published.
+                //
+            }
+        }
+
+        //
+        // Appends the frames currently held by the ring, oldest first. Frames
+        // overwritten while the snapshot is being taken are left out.
+        //
+        void GetHistory(
+            _Inout_ std::vector<Entry>& entries) const
+        {
+            ReadGuard guard(*this);
+
+            const uint64_t writeCount = _writeCount.load();
+            const uint64_t first = (writeCount > _capacity) ? writeCount - _capacity : 0;
+
+            for (uint64_t ordinal = first; ordinal < writeCount; ++ordinal)
+            {
+                Entry entry;
+
+                if (TryReadSlot(ordinal, &entry.Timestamp, &entry.Frame))
+                {
+                    entries.push_back(
+                        entry);
+                }
+            }
+        }
+
+        //
+        // Like GetHistory, but only reads the timestamps and does not take any
+        // frame references.
+        //
+        void GetTimestamps(
+            _Inout_ std::vector<int64_t>& timestamps) const
+        {
+            const uint64_t writeCount = _writeCount.load();
+            const uint64_t first = (writeCount > _capacity) ? writeCount - _capacity : 0;
+
+            for (uint64_t ordinal = first; ordinal < writeCount; ++ordinal)
+            {
+                int64_t timestamp;
+
+                if (TryReadSlot(ordinal, &timestamp, nullptr))
+                {
+                    timestamps.push_back(
+                        timestamp);
+                }
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            // Write ordinal of the frame in the slot plus one, or zero while the
+            // slot is being written.
+            std::atomic<uint64_t> Sequence;
+
+            std::atomic<int64_t> Timestamp;
+
+            // The handle of the frame, owned by the producer.
+            std::atomic<const TFrame*> Frame;
+        };
+
+        //
+        // Keeps the producer from releasing evicted frames for the lifetime of
+        // the guard.
+        //
+        class ReadGuard
+        {
+        public:
+            explicit ReadGuard(
+                _In_ const FrameRing& ring)
+                : _ring(ring)
+            {
+                //
+                // Register in the current epoch. Should the producer close the
+                // epoch in the meantime, back out and register in the new one.
+                //
+                for (;;)
+                {
+                    const uint64_t epoch = _ring._epoch.load();
+
+                    _epochParity = static_cast<uint32_t>(epoch & 1);
+
+                    _ring._activeReaders[_epochParity].fetch_add(1);
+
+                    if (_ring._epoch.load() == epoch)
+                    {
+                        break;
+                    }
+
+                    _ring._activeReaders[_epochParity].fetch_sub(1);
+                }
+            }
+
+            ~ReadGuard()
+            {
+                _ring._activeReaders[_epochParity].fetch_sub(1);
+            }
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+
+        private:
+            const FrameRing& _ring;
+            uint32_t _epochParity;
+        };
+
+        //
+        // The handles published in the slots are kept in holders that are
+        // recycled once released, so that pushing a frame does not allocate
+        // once the ring has warmed up.
+        //
+        std::unique_ptr<TFrame> AcquireHolder(
+            _In_ const TFrame& frame)
+        {
+            if (_freeHolders.empty())
+            {
+                return std::unique_ptr<TFrame>(
+                    new TFrame(frame));
+            }
+
+            std::unique_ptr<TFrame> holder =
+                std::move(_freeHolders.back());
+
+            _freeHolders.pop_back();
+
+            *holder = frame;
+
+            return holder;
+        }
+
+        void RetireHolder(
+            _In_ std::unique_ptr<TFrame> holder)
+        {
+            const uint64_t epoch = _epoch.load(std::memory_order_relaxed);
+
+            _retiredHolders[epoch & 1].push_back(
+                std::move(holder));
+
+            //
+            // Readers of the previous epoch may still hold a pointer to a frame
+            // retired during that epoch. Once they have all left, release those
+            // frames and open a new epoch; readers arriving from now on only see
+            // frames that are currently in the ring.
+            //
+            const uint32_t previousParity = static_cast<uint32_t>((epoch + 1) & 1);
+
+            if (0 == _activeReaders[previousParity].load())
+            {
+                for (std::unique_ptr<TFrame>& retiredHolder : _retiredHolders[previousParity])
+                {
+                    *retiredHolder = TFrame();
+
+                    _freeHolders.push_back(
+                        std::move(retiredHolder));
+                }
+
+                _retiredHolders[previousParity].clear();
+
+                _epoch.store(epoch + 1);
+            }
+        }
+
+        bool TryReadSlot(
+            _In_ const uint64_t ordinal,
+            _Out_ int64_t* timestamp,
+            _Out_opt_ TFrame* frame) const
+        {
+            const Slot& slot = _slots[ordinal % _capacity];
+
+            if (slot.Sequence.load(std::memory_order_acquire) != ordinal + 1)
+            {
+                return false;
+            }
+
+            *timestamp = slot.Timestamp.load(std::memory_order_relaxed);
+
+            const TFrame* holder = slot.Frame.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.Sequence.load(std::memory_order_relaxed) != ordinal + 1)
+            {
+                return false;
+            }
+
+            if (nullptr != frame)
+            {
+                //
+                // Safe under the ReadGuard: the holder is either still in the
+                // ring or retired, and retired holders are neither released nor
+                // reused while a reader that could have seen them is active.
+                // Copying the handle takes a reference of our own.
+                //
+                *frame = *holder;
+            }
+
+            return true;
+        }
+
+        const uint32_t _capacity;
+
+        std::unique_ptr<Slot[]> _slots;
+
+        std::atomic<uint64_t> _writeCount;
+
+        //
+        // Readers register in the current epoch. Frames evicted during an epoch
+        // are released once the epoch has been closed and its readers have left;
+        // readers that register later can no longer find those frames.
+        //
+        std::atomic<uint64_t> _epoch;
+        mutable std::array<std::atomic<uint32_t>, 2> _activeReaders;
+
+        // Producer only: the holders of the frames in the slots, those evicted
+        // during the current and the previous epoch, and the released ones.
+        std::vector<std::unique_ptr<TFrame>> _slotFrames;
+        std::array<std::vector<std::unique_ptr<TFrame>>, 2> _retiredHolders;
+        std::vector<std::unique_ptr<TFrame>> _freeHolders;
+    };
+}
@@ -0,0 +1,338 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Io
+{
+    //
+    // What to do with a frame sent while the send queue is full.
+    //
+    enum class SendQueuePolicy
+    {
+        // Evict the oldest queued frame to make room for the new one.
+        DropOldest,
+
+        // Drop the new frame.
+        DropNewest,
+
+        // Block the sender until there is room.
+        Block,
+
+        // Drop the new frame if it depends on previous frames, and the frames
+        // after it until the next keyframe. Keyframes are always queued: one
+        // sent while the queue is full replaces everything still queued.
+        KeyframeOnly
+    };
+
+    struct SendQueueStatistics
+    {
+        uint64_t FramesQueued;
+        uint64_t FramesStarted;
+        uint64_t FramesSent;
+        uint64_t FramesDropped;
+        uint64_t BytesSent;
+
+        // Time the started frames spent in the queue before their write began.
+        double TotalQueueLatencyInSeconds;
+        double MaximumQueueLatencyInSeconds;
+
+        // Time since the queue was created.
+        double ElapsedTimeInSeconds;
+    };
+
+    //
+    // Bounded queue of frames waiting to be written to a connection, allowing a
+    // fixed number of writes to be outstanding at the same time. Independent of
+    // the transport: the transport starts writes with TryBeginSend and reports
+    // their completion with EndSend, which may happen on any thread. Doesn't
+    // allocate once created.
+    //
+    template <typename TFrame>
+    class FrameSendQueue
+    {
+    public:
+        FrameSendQueue(
+            _In_ const size_t capacity,
+            _In_ const size_t maximumWritesInFlight,
+            _In_ const SendQueuePolicy policy)
+            : _capacity(capacity)
+            , _maximumWritesInFlight(maximumWritesInFlight)
+            , _policy(policy)
+            , _slots(capacity)
+            , _head(0)
+            , _count(0)
+            , _writesInFlight(0)
+            , _awaitingKeyframe(false)
+            , _closed(false)
+            , _creationTime(Clock::now())
+        {
+            REQUIRES(capacity > 0 && maximumWritesInFlight > 0);
+
+            _statistics = {};
+        }
+
+        FrameSendQueue(const FrameSendQueue&) = delete;
+        FrameSendQueue& operator=(const FrameSendQueue&) = delete;
+
+        //
+        // Queues a frame, applying the policy if the queue is full. Returns false
+        // if the frame was dropped.
+        //
+        bool Push(
+            _In_ const TFrame& frame,
+            _In_ const size_t sizeInBytes,
+            _In_ const bool isKeyframe)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            if (_closed)
+            {
+                ++_statistics.FramesDropped;
+
+                return false;
+            }
+
+            switch (_policy)
+            {
+            case SendQueuePolicy::DropOldest:
+                if (_count == _capacity)
+                {
+                    PopFront();
+
+                    ++_statistics.FramesDropped;
+                }
+                break;
+
+            case SendQueuePolicy::DropNewest:
+                if (_count == _capacity)
+                {
+                    ++_statistics.FramesDropped;
+
+                    return false;
+                }
+                break;
+
+            case SendQueuePolicy::Block:
+                _spaceAvailable.wait(
+                    lock,
+                    [this]() { return _closed || _count < _capacity; });
+
+                if (_closed)
+                {
+                    ++_statistics.FramesDropped;
+
+                    return false;
+                }
+                break;
+
+            case SendQueuePolicy::KeyframeOnly:
+                if (isKeyframe)
+                {
+                    if (_count == _capacity)
+                    {
+                        _statistics.FramesDropped += _count;
+
+                        Clear();
+                    }
+
+                    _awaitingKeyframe = false;
+                }
+                else if (_awaitingKeyframe || _count == _capacity)
+                {
+                    _awaitingKeyframe = true;
+
+                    ++_statistics.FramesDropped;
+
+                    return false;
+                }
+                break;
+            }
+
+            PendingFrame& pendingFrame = _slots[(_head + _count) % _capacity];
+
+            pendingFrame.Frame = frame;
+            pendingFrame.SizeInBytes = sizeInBytes;
+            pendingFrame.QueuedTime = Clock::now();
+
+            ++_count;
+
+            ++_statistics.FramesQueued;
+
+            return true;
+        }
+
+        //
+        // Takes the oldest queued frame if fewer than the maximum number of
+        // writes are outstanding. Every successful call must be followed by a
+        // call to EndSend once the write has completed.
+        //
+        bool TryBeginSend(
+            _Out_ TFrame* frame,
+            _Out_ size_t* sizeInBytes)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_closed || 0 == _count || _writesInFlight == _maximumWritesInFlight)
+            {
+                return false;
+            }
+
+            PendingFrame& pendingFrame = _slots[_head];
+
+            const double queueLatency =
+                std::chrono::duration<double>(Clock::now() - pendingFrame.QueuedTime).count();
+
+            ++_statistics.FramesStarted;
+
+            _statistics.TotalQueueLatencyInSeconds += queueLatency;
+
+            if (queueLatency > _statistics.MaximumQueueLatencyInSeconds)
+            {
+                _statistics.MaximumQueueLatencyInSeconds = queueLatency;
+            }
+
+            *frame = std::move(pendingFrame.Frame);
+            *sizeInBytes = pendingFrame.SizeInBytes;
+
+            PopFront();
+
+            ++_writesInFlight;
+
+            _spaceAvailable.notify_one();
+
+            return true;
+        }
+
+        void EndSend(
+            _In_ const size_t sizeInBytes,
+            _In_ const bool succeeded)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            ASSERT(_writesInFlight > 0);
+
+            --_writesInFlight;
+
+            if (succeeded)
+            {
+                ++_statistics.FramesSent;
+                _statistics.BytesSent += sizeInBytes;
+            }
+            else
+            {
+                ++_statistics.FramesDropped;
+            }
+        }
+
+        //
+        // Drops the queued frames and refuses new ones; releases blocked senders.
+        // Outstanding writes still have to be ended.
+        //
+        void Close()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if (_closed)
+            {
+                return;
+            }
+
+            _closed = true;
+
+            _statistics.FramesDropped += _count;
+
+            Clear();
+
+            _spaceAvailable.notify_all();
+        }
+
+        bool IsClosed() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            return _closed;
+        }
+
+        SendQueueStatistics GetStatistics() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            SendQueueStatistics statistics = _statistics;
+
+            statistics.ElapsedTimeInSeconds =
+                std::chrono::duration<double>(Clock::now() - _creationTime).count();
+
+            return statistics;
+        }
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct PendingFrame
+        {
+            TFrame Frame;
+            size_t SizeInBytes;
+            Clock::time_point QueuedTime;
+        };
+
+        //
+        // Releases the oldest queued frame, so that the queue holds no reference
+        // to a frame it no longer queues.
+        //
+        void PopFront()
+        {
+            _slots[_head].Frame = TFrame();
+
+            _head = (_head + 1) % _capacity;
+
+            --_count;
+        }
+
+        void Clear()
+        {
+            while (_count > 0)
+            {
+                PopFront();
+            }
+        }
+
+        const size_t _capacity;
+        const size_t _maximumWritesInFlight;
+        const SendQueuePolicy _policy;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _spaceAvailable;
+
+        // Ring of the queued frames, oldest first.
+        std::vector<PendingFrame> _slots;
+        size_t _head;
+        size_t _count;
+
+        size_t _writesInFlight;
+        bool _awaitingKeyframe;
+        bool _closed;
+
+        const Clock::time_point _creationTime;
+        SendQueueStatistics _statistics;
+    };
+}
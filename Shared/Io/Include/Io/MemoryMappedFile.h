@@ -0,0 +1,57 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Read-only view of a whole file mapped into the address space of the process,
+    // e.g. a CSV file or a pose log. Files larger than the address space are
+    // refused; use Io::TarReader to read the entries of a tarball.
+    //
+    class MemoryMappedFile
+    {
+    public:
+        MemoryMappedFile(
+            _In_ const std::wstring& fileName);
+
+        MemoryMappedFile(
+            _In_ Windows::Storage::StorageFolder^ folder,
+            _In_ const std::wstring& fileName);
+
+        ~MemoryMappedFile();
+
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        const uint8_t* GetData() const
+        {
+            return _data;
+        }
+
+        size_t GetSize() const
+        {
+            return _size;
+        }
+
+    private:
+        void Map(
+            _In_ HANDLE file);
+
+        void Unmap();
+
+        HANDLE _mapping;
+
+        const uint8_t* _data;
+        size_t _size;
+    };
+}
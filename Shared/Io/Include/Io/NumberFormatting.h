@@ -0,0 +1,55 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Io
+{
+    //
+    // Locale-independent formatting of numbers into caller provided character
+    // buffers. The functions do not null-terminate the output and return the
+    // number of characters written.
+    //
+    const size_t MaxFormattedIntegerLength = 20;
+    const size_t MaxFormattedFloatLength = 16;
+    const size_t MaxFormattedDoubleLength = 24;
+
+    size_t FormatUInt64(
+        _In_ const uint64_t value,
+        _Out_writes_(MaxFormattedIntegerLength) char* output);
+
+    size_t FormatInt64(
+        _In_ const int64_t value,
+        _Out_writes_(MaxFormattedIntegerLength + 1) char* output);
+
+    //
+    // Writes the shortest decimal representation that parses back to exactly the
+    // same float (the Ryu algorithm), in fixed or scientific notation, whichever
+    // is shorter. Produces the same text as std::to_chars(first, last, value).
+    //
+    size_t FormatFloat(
+        _In_ const float value,
+        _Out_writes_(MaxFormattedFloatLength) char* output);
+
+    //
+    // Writes the value with 17 significant digits, which is enough for it to
+    // parse back to exactly the same double.
+    //
+    size_t FormatDouble(
+        _In_ const double value,
+        _Out_writes_(MaxFormattedDoubleLength) char* output);
+}
@@ -0,0 +1,51 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Io
+{
+    //
+    // Locale-independent parsing of numbers from character ranges that are not
+    // null-terminated, e.g. fields of a memory mapped CSV file. The whole range
+    // must be consumed for the parse to succeed.
+    //
+    bool ParseUInt64(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ uint64_t* value);
+
+    bool ParseInt64(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ int64_t* value);
+
+    //
+    // The floating point parsers round correctly. Decimal numbers with up to 15
+    // significant digits and small exponents, which covers the text written by
+    // CsvWriter, take an exact fast path; everything else falls back to strtod.
+    //
+    bool ParseFloat(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ float* value);
+
+    bool ParseDouble(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ double* value);
+}
@@ -0,0 +1,59 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Io
+{
+    //
+    // Instruction set used by the pixel format conversion kernels.
+    //
+    enum class PixelFormatConversionIsa
+    {
+        Scalar,
+        Ssse3,
+        Avx2,
+        Neon
+    };
+
+    //
+    // Returns the best kernel supported by the processor we are running on.
+    // Detected once, on first use.
+    //
+    PixelFormatConversionIsa GetPixelFormatConversionIsa();
+
+    //
+    // Drops the alpha channel of 8-bit BGRA pixels and swaps the color
+    // channels to RGB order, as stored in binary PPM files. The output buffer
+    // must hold 3 * numberOfPixels bytes and must not overlap the input.
+    //
+    void PackBgraToRgb(
+        _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+        _In_ const size_t numberOfPixels,
+        _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels);
+
+    //
+    // Same as above, but using the given kernel. Intended for validating and
+    // benchmarking the kernels against each other; the instruction set must be
+    // supported by the processor.
+    //
+    void PackBgraToRgb(
+        _In_ const PixelFormatConversionIsa isa,
+        _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+        _In_ const size_t numberOfPixels,
+        _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels);
+}
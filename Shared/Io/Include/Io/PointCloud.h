@@ -0,0 +1,113 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/UnprojectionLut.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Io
+{
+    //
+    // Instruction sets of the depth to point cloud conversion. GetPointCloudIsa
+    // picks the best one the CPU supports; the others are there for
+    // benchmarking.
+    //
+    enum class PointCloudIsa
+    {
+        Scalar,
+        Avx2,
+        Neon
+    };
+
+    PointCloudIsa GetPointCloudIsa();
+
+    bool IsPointCloudIsaSupported(
+        _In_ const PointCloudIsa isa);
+
+    const char* GetPointCloudIsaName(
+        _In_ const PointCloudIsa isa);
+
+    //
+    // Inverts a rigid transform: a rotation followed by a translation.
+    //
+    void InvertRigidTransform(
+        _In_reads_(16) const float* transform,
+        _Out_writes_(16) float* inverse);
+
+    //
+    // Composes the camera to origin transform of a frame from its FrameToOrigin
+    // and CameraViewTransform (see Io::FrameTransforms): the inverse of the
+    // camera view transform, which is rigid, followed by the frame to origin
+    // transform. Matrices are stored row major and transform row vectors,
+    // like Windows::Foundation::Numerics::float4x4.
+    //
+    void ComputeCameraToOrigin(
+        _In_reads_(16) const float* frameToOrigin,
+        _In_reads_(16) const float* cameraViewTransform,
+        _Out_writes_(16) float* cameraToOrigin);
+
+    struct DepthUnprojectionOptions
+    {
+        // Meters per unit of depth; the depth sensors measure millimeters.
+        float DepthScale = 0.001f;
+
+        //
+        // Depths outside of this range are invalid. The defaults reject zero and
+        // the values from 4090, which the depth sensors use for invalid pixels.
+        //
+        uint16_t MinimumDepth = 1;
+        uint16_t MaximumDepth = 4089;
+
+        //
+        // The depth sensors measure the distance to the camera along the ray of
+        // each pixel; when false, depths are distances along the camera's Z axis
+        // instead.
+        //
+        bool DepthIsRadial = true;
+    };
+
+    //
+    // Turns a Gray16 depth image into a point cloud, transformed by
+    // cameraToOrigin (see ComputeCameraToOrigin). The image is as large as the
+    // LUT; depthRowStride is in bytes.
+    //
+    // The points are written as (x, y, z) triplets, one for each pixel, row by
+    // row: 3 * ImageWidth * ImageHeight floats. The points of invalid pixels,
+    // whether their depth is out of range or they don't map to the unit plane,
+    // are NaN. Returns the number of valid points.
+    //
+    // Builds without the precompiled header of the library, like
+    // Io::UnprojectionLut.
+    //
+    size_t UnprojectDepth(
+        _In_ const UnprojectionLut& lut,
+        _In_ const uint16_t* depth,
+        _In_ const size_t depthRowStride,
+        _In_reads_(16) const float* cameraToOrigin,
+        _In_ const DepthUnprojectionOptions& options,
+        _Out_writes_(3 * lut.GetImageWidth() * lut.GetImageHeight()) float* points);
+
+    //
+    // Same, with the given instruction set, which must be supported.
+    //
+    size_t UnprojectDepth(
+        _In_ const PointCloudIsa isa,
+        _In_ const UnprojectionLut& lut,
+        _In_ const uint16_t* depth,
+        _In_ const size_t depthRowStride,
+        _In_reads_(16) const float* cameraToOrigin,
+        _In_ const DepthUnprojectionOptions& options,
+        _Out_writes_(3 * lut.GetImageWidth() * lut.GetImageHeight()) float* points);
+}
@@ -0,0 +1,62 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+//
+// Lets the parts of the library that only depend on the C++ standard library
+// build without the precompiled header, e.g. next to the samples of Samples/cpp
+// on Linux. The SAL annotations compile to nothing outside of Visual C++, and
+// the code contracts throw std::logic_error like those of the Debugging
+// library, which are used instead when it was included first.
+//
+
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <sal.h>
+#else
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_reads_(size)
+#define _Inout_
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Use_decl_annotations_
+#endif
+
+#if defined(_MSC_VER)
+#define IO_CONTRACT_WHILE_FALSE while (0, 0)
+#else
+#define IO_CONTRACT_WHILE_FALSE while (false)
+#endif
+
+#define IO_CONTRACT_CHECK(kind, expr) \
+    do { \
+        if (!(expr)) { \
+            throw std::logic_error(kind "(" #expr ") check failed"); \
+        } \
+    } IO_CONTRACT_WHILE_FALSE
+
+#ifndef ASSERT
+#define ASSERT(expr) IO_CONTRACT_CHECK("ASSERT", expr)
+#endif
+
+#ifndef REQUIRES
+#define REQUIRES(expr) IO_CONTRACT_CHECK("REQUIRES", expr)
+#endif
+
+#ifndef ENSURES
+#define ENSURES(expr) IO_CONTRACT_CHECK("ENSURES", expr)
+#endif
@@ -0,0 +1,120 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+namespace Io
+{
+    //
+    // Binary log of the per-frame camera poses. Written next to the per-sensor
+    // tarball as an alternative to formatting the transforms as CSV text on the
+    // recording thread; the values are stored bit-exact.
+    //
+    // The file starts with a PoseLogHeader followed by one fixed-size
+    // PoseLogRecord per frame, in the order the frames were recorded. All fields
+    // are little endian and the matrices are stored row major (m11, m12, ...,
+    // m44), matching Windows::Foundation::Numerics::float4x4.
+    //
+    const uint32_t PoseLogCookie = 0x474f4c50; // 'PLOG'
+
+    const uint16_t PoseLogVersionMajor = 0x00;
+    const uint16_t PoseLogVersionMinor = 0x01;
+
+#pragma pack (push, 1)
+    struct PoseLogHeader
+    {
+        uint32_t Cookie;
+        uint16_t VersionMajor;
+        uint16_t VersionMinor;
+        uint32_t RecordSize;
+        uint32_t Reserved;
+    };
+
+    struct PoseLogRecord
+    {
+        uint64_t Timestamp;
+        float FrameToOrigin[16];
+        float CameraViewTransform[16];
+        float CameraProjectionTransform[16];
+    };
+#pragma pack (pop)
+
+    //
+    // Appends records to a pose log file.
+    //
+    class PoseLogWriter
+    {
+    public:
+        PoseLogWriter(
+            _In_ const std::wstring& poseLogFileName);
+
+        ~PoseLogWriter();
+
+        PoseLogWriter(const PoseLogWriter&) = delete;
+        PoseLogWriter& operator=(const PoseLogWriter&) = delete;
+
+        void Close();
+
+        void AddRecord(
+            _In_ const PoseLogRecord& record);
+
+    private:
+        void Write(
+            _In_reads_(size) const void* data,
+            _In_ const size_t size);
+
+        HANDLE _poseLogFile;
+    };
+
+    //
+    // Memory mapped, zero-copy access to the records of a pose log.
+    //
+    class PoseLogReader
+    {
+    public:
+        PoseLogReader(
+            _In_ const std::wstring& poseLogFileName);
+
+        PoseLogReader(
+            _In_ Windows::Storage::StorageFolder^ folder,
+            _In_ const std::wstring& poseLogFileName);
+
+        size_t GetRecordCount() const
+        {
+            return _numberOfRecords;
+        }
+
+        //
+        // Returns the record at the given position in the log. The reference
+        // remains valid for the lifetime of the reader.
+        //
+        const PoseLogRecord& GetRecord(
+            _In_ const size_t ordinal) const;
+
+        //
+        // Looks up the record with exactly the given timestamp. Returns null if
+        // there is none.
+        //
+        const PoseLogRecord* FindRecord(
+            _In_ const uint64_t timestamp) const;
+
+    private:
+        void ReadHeader();
+
+        MemoryMappedFile _poseLog;
+
+        const PoseLogRecord* _records;
+        size_t _numberOfRecords;
+
+        bool _isSortedByTime;
+    };
+}
@@ -0,0 +1,165 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Maps the raw values of a sensor to the values given to a colour map.
+    //
+    struct PseudoColorRange
+    {
+        // Of the raw values, e.g. 0.001 for depths in millimeters to meters.
+        float Scale;
+
+        // Scaled values mapped to the start and to the end of the colour map.
+        float Minimum;
+        float Maximum;
+
+        //
+        // Raw values outside of [MinimumValid, MaximumValid], e.g. depths that
+        // couldn't be measured, are painted with the invalid colour.
+        //
+        uint32_t MinimumValid;
+        uint32_t MaximumValid;
+
+        // BGRA, packed like the pixels read as uint32_t: 0xAARRGGBB.
+        uint32_t InvalidColor;
+    };
+
+    //
+    // Pseudo-colours Gray8 or Gray16 sensor images, through a table holding the
+    // BGRA colour of every raw value. The table is built once per sensor
+    // configuration; colouring a pixel is then a single lookup, done eight
+    // pixels at a time with AVX2 gathers where the processor supports them.
+    //
+    // The table stops after MaximumValid, with the invalid colour: greater values
+    // are clamped to that last entry. A depth table for values up to 4000 mm thus
+    // holds 16 KB rather than 256 KB, and fits the L1 cache.
+    //
+    // Builds without the precompiled header of the library, so that it can be
+    // used and benchmarked on other platforms too.
+    //
+    //
+    // Instruction sets of the pseudo-colouring kernels.
+    //
+    enum class PseudoColorIsa
+    {
+        Scalar,
+        Avx2
+    };
+
+    //
+    // Returns the best kernel supported by the processor we are running on.
+    // Detected once, on first use.
+    //
+    PseudoColorIsa GetPseudoColorIsa();
+
+    template <typename TValue>
+    class PseudoColorTable
+    {
+    public:
+        //
+        // colorMap(float value) returns the BGRA colour of a value scaled to
+        // [0, 1] by the range; values out of the range are passed as they are.
+        //
+        template <typename TColorMap>
+        PseudoColorTable(
+            const PseudoColorRange& range,
+            TColorMap colorMap)
+        {
+            assert(range.Maximum > range.Minimum);
+            assert(range.MinimumValid <= range.MaximumValid);
+
+            // In parentheses, for the max macro of windows.h.
+            const uint32_t largestValue =
+                (std::numeric_limits<TValue>::max)();
+
+            const uint32_t maximumValid =
+                (range.MaximumValid < largestValue) ? range.MaximumValid : largestValue;
+
+            _lastIndex =
+                (maximumValid < largestValue) ? maximumValid + 1 : largestValue;
+
+            _colors.resize(
+                static_cast<size_t>(_lastIndex) + 1);
+
+            const float rangeReciprocal =
+                1.0f / (range.Maximum - range.Minimum);
+
+            for (uint32_t value = 0; value <= _lastIndex; ++value)
+            {
+                if (value < range.MinimumValid || value > maximumValid)
+                {
+                    _colors[value] = range.InvalidColor;
+                }
+                else
+                {
+                    const float scaledValue =
+                        static_cast<float>(value) * range.Scale;
+
+                    _colors[value] =
+                        colorMap((scaledValue - range.Minimum) * rangeReciprocal);
+                }
+            }
+        }
+
+        uint32_t GetColor(
+            const TValue value) const
+        {
+            const uint32_t index = value;
+
+            return _colors[(index < _lastIndex) ? index : _lastIndex];
+        }
+
+        //
+        // Colours a row of pixels. The BGRA pixels must not overlap the values.
+        //
+        void Apply(
+            const TValue* values,
+            const size_t numberOfPixels,
+            uint32_t* bgraPixels) const;
+
+        //
+        // Same as above, but using the given kernel. Intended for validating and
+        // benchmarking the kernels against each other; the instruction set must
+        // be supported by the processor.
+        //
+        void Apply(
+            const PseudoColorIsa isa,
+            const TValue* values,
+            const size_t numberOfPixels,
+            uint32_t* bgraPixels) const;
+
+        //
+        // Colours an image; the strides are in bytes.
+        //
+        void Apply(
+            const uint8_t* image,
+            const size_t stride,
+            const uint32_t width,
+            const uint32_t height,
+            uint8_t* bgraImage,
+            const size_t bgraStride) const;
+
+    private:
+        std::vector<uint32_t> _colors;
+        uint32_t _lastIndex;
+    };
+}
@@ -0,0 +1,80 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Shares a connection between several streams in proportion to their
+    // weights (start-time fair queueing). Streams are charged for the bytes they
+    // send; a stream that was idle does not get to make up for the time it did
+    // not use the connection.
+    //
+    // Not thread safe.
+    //
+    class StreamScheduler
+    {
+    public:
+        explicit StreamScheduler(
+            _In_ const size_t streamCount);
+
+        size_t GetStreamCount() const
+        {
+            return _streams.size();
+        }
+
+        //
+        // Weights are relative; all streams start with a weight of 1.
+        //
+        void SetWeight(
+            _In_ const size_t stream,
+            _In_ const uint32_t weight);
+
+        uint32_t GetWeight(
+            _In_ const size_t stream) const;
+
+        //
+        // Lists the streams in the order they should be served in. The caller
+        // sends from the first stream that has data and charges it.
+        //
+        void GetServiceOrder(
+            _Inout_ std::vector<size_t>& streams) const;
+
+        void Charge(
+            _In_ const size_t stream,
+            _In_ const size_t sizeInBytes);
+
+    private:
+        double GetStartTag(
+            _In_ const size_t stream) const;
+
+        struct Stream
+        {
+            uint32_t Weight;
+
+            // Virtual time at which the stream's previous transmission ended.
+            double FinishTag;
+        };
+
+        std::vector<Stream> _streams;
+
+        // Start tag of the most recently scheduled transmission.
+        double _virtualTime;
+    };
+}
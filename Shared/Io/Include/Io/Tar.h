@@ -11,7 +11,10 @@
 
 #pragma once
 
-#include <fstream>
+#include <Io/TarArchive.h>
+#include <Io/TarIndex.h>
+
+#include <memory>
 
 namespace Io
 {
@@ -29,17 +32,227 @@ namespace Io
 		Tarball(_In_ const std::wstring& tarballFileName);
 		~Tarball();
 
-		// Close the tarball.
+		Tarball(const Tarball&) = delete;
+		Tarball& operator=(const Tarball&) = delete;
+
+		// Terminate and close the tarball. Throws if the end of the archive
+		// could not be written; the destructor closes an unclosed tarball on
+		// a best-effort basis and ignores errors.
 		void Close();
 
-		// Add a file to the tarball.
-		void AddFile(
+		// Add a file to the tarball. Returns the offset of the file
+		// data from the beginning of the tarball.
+		uint64_t AddFile(
 			_In_ const std::wstring& fileName,
 			_In_ const uint8_t* fileData,
 			_In_ const size_t fileSize);
 
+		// Add a file to the tarball whose contents are the concatenation
+		// of the given spans, e.g. a bitmap header followed by the pixels.
+		// Small spans are coalesced with the tar header, large spans are
+		// handed to the OS directly without being copied.
+		uint64_t AddFile(
+			_In_ const std::wstring& fileName,
+			_In_reads_(numberOfFileSpans) const TarballFileSpan* fileSpans,
+			_In_ const size_t numberOfFileSpans);
+
 	private:
-		// The file handler to the tarball.
-		std::ofstream _tarballFile;
+		void WriteToFile(
+			_In_reads_(size) const uint8_t* data,
+			_In_ size_t size);
+
+		// The file handle of the tarball.
+		HANDLE _tarballFile;
+
+		// Lays out the headers, data and padding of the files.
+		TarArchiveWriter _archive;
 	};
+
+    //
+    // Appends records to a tarball index file. See Io::TarIndex.
+    //
+    class TarIndexWriter
+    {
+    public:
+        TarIndexWriter(
+            _In_ const std::wstring& indexFileName);
+
+        ~TarIndexWriter();
+
+        TarIndexWriter(const TarIndexWriter&) = delete;
+        TarIndexWriter& operator=(const TarIndexWriter&) = delete;
+
+        void Close();
+
+        void AddRecord(
+            _In_ const TarIndexRecord& record);
+
+    private:
+        void Write(
+            _In_reads_(size) const void* data,
+            _In_ const size_t size);
+
+        HANDLE _indexFile;
+    };
+
+    //
+    // Read-only view of the data of a single tarball entry. Only the pages
+    // spanned by the entry are mapped, so entries of archives larger than the
+    // address space of the process can still be viewed.
+    //
+    class TarEntryView
+    {
+    public:
+        TarEntryView();
+        TarEntryView(TarEntryView&& other);
+        ~TarEntryView();
+
+        TarEntryView& operator=(TarEntryView&& other);
+
+        TarEntryView(const TarEntryView&) = delete;
+        TarEntryView& operator=(const TarEntryView&) = delete;
+
+        const uint8_t* GetData() const
+        {
+            return _data;
+        }
+
+        size_t GetSize() const
+        {
+            return _size;
+        }
+
+    private:
+        friend class TarReader;
+
+        void Reset();
+
+        void* _mappedView;
+        const uint8_t* _data;
+        size_t _size;
+    };
+
+    //
+    // Reads the entries of a tarball without extracting it; see
+    // Io::TarArchiveScanner for the formats it understands.
+    //
+    // The frames of the tarballs written by the recorder can also be looked up
+    // by ordinal or timestamp once the index written next to the tarball has
+    // been loaded, without walking the headers of the archive.
+    //
+    class TarReader
+    {
+    public:
+        TarReader(
+            _In_ const std::wstring& tarballFileName);
+
+        TarReader(
+            _In_ Windows::Storage::StorageFolder^ folder,
+            _In_ const std::wstring& tarballFileName);
+
+        ~TarReader();
+
+        TarReader(const TarReader&) = delete;
+        TarReader& operator=(const TarReader&) = delete;
+
+        uint64_t GetSize() const
+        {
+            return _archive->GetSize();
+        }
+
+        // Reads the next entry in archive order. Returns false after the last
+        // entry of the archive.
+        bool ReadNextEntry(
+            _Out_ TarEntry* entry);
+
+        // Restarts ReadNextEntry from the first entry of the archive.
+        void Rewind();
+
+        // Looks up an entry by name. The first call scans the headers of the
+        // whole archive; later calls are hash table lookups. Forward and back
+        // slashes are treated as equivalent.
+        bool FindEntry(
+            _In_ const std::string& fileName,
+            _Out_ TarEntry* entry);
+
+        // Maps the data of the entry into memory.
+        TarEntryView MapEntry(
+            _In_ const TarEntry& entry);
+
+        // Copies up to bufferSize bytes of the entry data starting at offset.
+        // Returns the number of bytes copied.
+        size_t ReadEntryData(
+            _In_ const TarEntry& entry,
+            _In_ const uint64_t offset,
+            _Out_writes_(bufferSize) uint8_t* buffer,
+            _In_ const size_t bufferSize);
+
+        // Loads the index of the frames of the tarball, written next to it by
+        // Io::TarIndexWriter (<tarball>.idx).
+        void LoadIndex(
+            _In_ const std::wstring& indexFileName);
+
+        void LoadIndex(
+            _In_ Windows::Storage::StorageFolder^ folder,
+            _In_ const std::wstring& indexFileName);
+
+        // The loaded index; empty if none was loaded.
+        const TarIndex& GetIndex() const
+        {
+            return _index;
+        }
+
+        // Describes the file of a frame of the index, to be read with
+        // MapEntry or ReadEntryData. The file name is not stored in the index
+        // and is left empty.
+        TarEntry GetFrameEntry(
+            _In_ const size_t ordinal) const;
+
+        // Looks up the file of the frame with exactly the given timestamp.
+        bool FindFrameEntry(
+            _In_ const uint64_t timestamp,
+            _Out_ TarEntry* entry) const;
+
+    private:
+        void Open(
+            _In_ HANDLE file);
+
+        void ReadAt(
+            _In_ const uint64_t offset,
+            _Out_writes_(size) void* buffer,
+            _In_ const size_t size);
+
+        HANDLE _file;
+        HANDLE _mapping;
+
+        uint32_t _allocationGranularity;
+
+        std::unique_ptr<TarArchiveScanner> _archive;
+
+        TarIndex _index;
+    };
+
+    //
+    // Streams the data of a tarball entry in chunks of a fixed size.
+    //
+    class TarEntryChunkIterator
+    {
+    public:
+        TarEntryChunkIterator(
+            _In_ TarReader& reader,
+            _In_ const TarEntry& entry,
+            _In_ const size_t chunkSize = 1024 * 1024);
+
+        // Returns false once all of the entry data has been read. The chunk
+        // remains valid until the next call.
+        bool ReadNextChunk(
+            _Out_ const uint8_t** chunkData,
+            _Out_ size_t* chunkSize);
+
+    private:
+        TarReader& _reader;
+        TarEntry _entry;
+        uint64_t _position;
+        std::vector<uint8_t> _chunk;
+    };
 }
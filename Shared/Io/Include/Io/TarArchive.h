@@ -0,0 +1,189 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Size of the headers of a tarball, to which the data of its files is padded.
+    //
+    const size_t TarBlockSize = 512;
+
+    //
+    // Formats the ustar header of a regular file.
+    //
+    void FormatTarHeader(
+        _In_ const std::string& fileName,
+        _In_ const uint64_t fileSize,
+        _In_ const uint64_t modificationTime,
+        _Out_writes_(TarBlockSize) uint8_t* header);
+
+    //
+    // A contiguous piece of the data of a file added to a tarball.
+    //
+    struct TarballFileSpan
+    {
+        const uint8_t* Data;
+        size_t Size;
+    };
+
+    //
+    // Describes a file stored in a tarball.
+    //
+    struct TarEntry
+    {
+        // UTF-8 file name as stored in the archive, after applying GNU and
+        // pax long name records.
+        std::string FileName;
+
+        // Type flag of the entry, e.g. '0' for regular files.
+        char Type;
+
+        uint64_t HeaderOffset;
+        uint64_t DataOffset;
+        uint64_t DataSize;
+    };
+
+    //
+    // Lays out the files streamed into a tarball: their headers, data and
+    // padding. Independent of the file system: the bytes of the archive are
+    // handed in order to a write function. Io::Tarball writes them to a file.
+    //
+    class TarArchiveWriter
+    {
+    public:
+        typedef std::function<void(const uint8_t* data, size_t size)> WriteFunction;
+
+        explicit TarArchiveWriter(
+            _In_ const WriteFunction& write);
+
+        TarArchiveWriter(const TarArchiveWriter&) = delete;
+        TarArchiveWriter& operator=(const TarArchiveWriter&) = delete;
+
+        //
+        // Adds a file whose contents are the concatenation of the given spans,
+        // e.g. a bitmap header followed by the pixels. Small spans are coalesced
+        // with the tar header, large spans are handed to the write function as
+        // they are. Returns the offset of the file data in the archive.
+        //
+        uint64_t AddFile(
+            _In_ const std::string& fileName,
+            _In_reads_(numberOfFileSpans) const TarballFileSpan* fileSpans,
+            _In_ const size_t numberOfFileSpans,
+            _In_ const uint64_t modificationTime);
+
+        //
+        // Writes the end of the archive. No file can be added afterwards.
+        //
+        void Finish();
+
+        //
+        // Number of bytes handed to the write function so far.
+        //
+        uint64_t GetWrittenSize() const
+        {
+            return _writtenSize;
+        }
+
+    private:
+        void Stage(
+            _In_reads_(size) const uint8_t* data,
+            _In_ const size_t size);
+
+        void FlushStagingBuffer();
+
+        void Write(
+            _In_reads_(size) const uint8_t* data,
+            _In_ const size_t size);
+
+        WriteFunction _write;
+
+        // Holds the padding of the previous file, the tar header and the
+        // small leading spans of the current file until the next write.
+        std::vector<uint8_t> _stagingBuffer;
+        size_t _stagingBufferSize;
+
+        uint64_t _writtenSize;
+        bool _finished;
+    };
+
+    //
+    // Walks the entries of a tarball without extracting it. Understands the
+    // ustar headers written by TarArchiveWriter as well as GNU long names ('L'),
+    // pax extended headers ('x') and base-256 encoded sizes. Independent of the
+    // file system: the archive is read through a function that copies the
+    // bytes at a given offset. Io::TarReader reads them from a file.
+    //
+    class TarArchiveScanner
+    {
+    public:
+        typedef std::function<void(uint64_t offset, void* buffer, size_t size)> ReadFunction;
+
+        TarArchiveScanner(
+            _In_ const uint64_t archiveSize,
+            _In_ const ReadFunction& read);
+
+        TarArchiveScanner(const TarArchiveScanner&) = delete;
+        TarArchiveScanner& operator=(const TarArchiveScanner&) = delete;
+
+        uint64_t GetSize() const
+        {
+            return _archiveSize;
+        }
+
+        // Reads the next entry in archive order. Returns false after the last
+        // entry of the archive.
+        bool ReadNextEntry(
+            _Out_ TarEntry* entry);
+
+        // Restarts ReadNextEntry from the first entry of the archive.
+        void Rewind();
+
+        // Looks up an entry by name. The first call scans the headers of the
+        // whole archive; later calls are hash table lookups. Forward and back
+        // slashes are treated as equivalent.
+        bool FindEntry(
+            _In_ const std::string& fileName,
+            _Out_ TarEntry* entry);
+
+        // Copies up to bufferSize bytes of the entry data starting at offset.
+        // Returns the number of bytes copied.
+        size_t ReadEntryData(
+            _In_ const TarEntry& entry,
+            _In_ const uint64_t offset,
+            _Out_writes_(bufferSize) uint8_t* buffer,
+            _In_ const size_t bufferSize);
+
+    private:
+        std::string ReadString(
+            _In_ const uint64_t offset,
+            _In_ const uint64_t size);
+
+        const uint64_t _archiveSize;
+        ReadFunction _read;
+
+        uint64_t _nextHeaderOffset;
+
+        bool _allEntriesIndexed;
+        std::unordered_map<std::string, TarEntry> _entriesByName;
+    };
+}
@@ -0,0 +1,129 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Binary index of the frames stored in a tarball written by Io::Tarball. The
+    // index lives next to the tarball (<tarball>.idx), is appended to as frames
+    // are added, and lets readers seek to any frame without scanning the archive.
+    //
+    // The file starts with a TarIndexHeader followed by one TarIndexRecord per
+    // frame, in the order the frames were added to the tarball. All fields are
+    // little endian.
+    //
+    const uint32_t TarIndexCookie = 0x58444954; // 'TIDX'
+
+    const uint16_t TarIndexVersionMajor = 0x00;
+    const uint16_t TarIndexVersionMinor = 0x02;
+
+    //
+    // Layout of the pixels of a stored frame.
+    //
+    enum class TarIndexPixelFormat : uint32_t
+    {
+        Unknown = 0,
+        Gray8 = 1,
+        Gray16 = 2, // Little endian.
+        Rgb8 = 3
+    };
+
+#pragma pack (push, 1)
+    struct TarIndexHeader
+    {
+        uint32_t Cookie;
+        uint16_t VersionMajor;
+        uint16_t VersionMinor;
+        uint32_t RecordSize;
+        uint32_t Reserved;
+    };
+
+    struct TarIndexRecord
+    {
+        uint64_t Timestamp;
+        uint64_t DataOffset;        // Offset of the file data in the tarball.
+        uint64_t DataSize;          // Size of the file data in the tarball.
+        uint32_t PixelDataOffset;   // Offset of the pixels relative to DataOffset.
+        uint32_t PixelFormat;       // TarIndexPixelFormat.
+        uint32_t ImageWidth;
+        uint32_t ImageHeight;
+        uint32_t RowStride;
+        uint32_t Codec;             // FrameCodec; zero in version 0.1 indices.
+    };
+#pragma pack (pop)
+
+    //
+    // The records of a tarball index, e.g. read by Io::TarReader::LoadIndex.
+    // Looking up a frame by ordinal is O(1) and by timestamp is a binary search.
+    //
+    class TarIndex
+    {
+    public:
+        TarIndex();
+
+        //
+        // Replaces the records with those of the given index file contents. A
+        // partially written trailing record, e.g. of an interrupted recording,
+        // is ignored.
+        //
+        void Load(
+            _In_reads_(size) const uint8_t* data,
+            _In_ const size_t size);
+
+        size_t GetRecordCount() const
+        {
+            return _records.size();
+        }
+
+        //
+        // Returns the record of the frame at the given position in the tarball.
+        //
+        const TarIndexRecord& GetRecord(
+            _In_ const size_t ordinal) const;
+
+        //
+        // Looks up the frame with exactly the given timestamp.
+        //
+        bool FindRecord(
+            _In_ const uint64_t timestamp,
+            _Out_ size_t* ordinal) const;
+
+        //
+        // Returns the ordinal of the frame closest in time to the given timestamp.
+        //
+        size_t FindNearestRecord(
+            _In_ const uint64_t timestamp) const;
+
+    private:
+        const TarIndexRecord& GetRecordByTime(
+            _In_ const size_t position) const;
+
+        size_t GetOrdinalByTime(
+            _In_ const size_t position) const;
+
+        size_t LowerBound(
+            _In_ const uint64_t timestamp) const;
+
+        std::vector<TarIndexRecord> _records;
+
+        // Ordinals sorted by timestamp; left empty when the frames were
+        // recorded in timestamp order, which is the common case.
+        std::vector<uint32_t> _ordinalsByTime;
+    };
+}
@@ -0,0 +1,171 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Io
+{
+    //
+    // Maps an image point (u, v) to the unit plane of a camera, e.g. through
+    // its intrinsics. Returns false if the point does not map to the plane.
+    //
+    typedef std::function<bool(float u, float v, float* x, float* y)> MapImagePointFunction;
+
+    //
+    // Maps the center (u + 0.5, v + 0.5) of each pixel of a camera to the Z=1
+    // plane of the camera. Pixels that do not map to the unit plane are NaN.
+    //
+    // The points are stored as separate x and y planes, row by row, so that
+    // they can be read a vector at a time (see Io::UnprojectDepth). For each
+    // pixel, the inverse length 1 / |(x, y, 1)| of its ray is kept too, with
+    // which the radial distances measured by the depth sensors are turned into
+    // points.
+    //
+    // Cameras without a parametric model (e.g. the research mode sensors) are
+    // described by such a LUT. It does not change from frame to frame, so it is
+    // streamed once per connection and referred to by its hash afterwards (see
+    // Io/FrameHeaderExtensions.h).
+    //
+    // Builds without the precompiled header of the library, so that it can be
+    // used and benchmarked on other platforms too.
+    //
+    class UnprojectionLut
+    {
+    public:
+        UnprojectionLut();
+
+        //
+        // Sizes the LUT for an image, after which each of its points must be
+        // set with SetPoint.
+        //
+        void Resize(
+            _In_ const uint32_t imageWidth,
+            _In_ const uint32_t imageHeight);
+
+        //
+        // Sets the point of the pixel at the given row major index. Points that
+        // are not finite are stored as NaN.
+        //
+        void SetPoint(
+            _In_ const size_t index,
+            _In_ float x,
+            _In_ float y);
+
+        //
+        // From points stored as (x, y) pairs, row by row, like the LUTs streamed
+        // in the header extensions.
+        //
+        void Assign(
+            _In_ const uint32_t imageWidth,
+            _In_ const uint32_t imageHeight,
+            _In_reads_(2 * imageWidth * imageHeight) const float* points);
+
+        //
+        // Samples the unit plane at the center of each pixel of an image.
+        //
+        void Sample(
+            _In_ const uint32_t imageWidth,
+            _In_ const uint32_t imageHeight,
+            _In_ const MapImagePointFunction& mapImagePoint);
+
+        //
+        // From the contents of a <sensor>_camera_space_projection.bin file of a
+        // recording (see SampleCameraSpaceProjection). The centers of the
+        // pixels are interpolated between their corners.
+        //
+        void AssignCameraSpaceProjection(
+            _In_ const uint32_t imageWidth,
+            _In_ const uint32_t imageHeight,
+            _In_reads_(2 * imageWidth * imageHeight) const float* cameraSpaceProjection);
+
+        //
+        // Maps a point of the image to the unit plane, interpolating bilinearly
+        // between the four nearest pixel centers and clamping to the border of
+        // the image. The integer coordinates of a pixel are its top-left corner.
+        // Returns false if the point does not map to the unit plane.
+        //
+        bool MapImagePointToCameraUnitPlane(
+            _In_ const float u,
+            _In_ const float v,
+            _Out_ float* x,
+            _Out_ float* y) const;
+
+        bool IsEmpty() const
+        {
+            return _x.empty();
+        }
+
+        uint32_t GetImageWidth() const
+        {
+            return _imageWidth;
+        }
+
+        uint32_t GetImageHeight() const
+        {
+            return _imageHeight;
+        }
+
+        // ImageWidth * ImageHeight values each, row by row.
+        const float* GetX() const
+        {
+            return _x.data();
+        }
+
+        const float* GetY() const
+        {
+            return _y.data();
+        }
+
+        const float* GetInverseRayLength() const
+        {
+            return _inverseRayLength.data();
+        }
+
+    private:
+        uint32_t _imageWidth;
+        uint32_t _imageHeight;
+
+        std::vector<float> _x;
+        std::vector<float> _y;
+        std::vector<float> _inverseRayLength;
+    };
+
+    //
+    // Samples the camera space projection that the recorder stores as
+    // <sensor>_camera_space_projection.bin. The file has no header: its points
+    // are stored as (x, y) pairs, column by column, for the top-left corner
+    // (u, v) of each pixel. Points that do not map to the unit plane are
+    // stored as infinity.
+    //
+    // Recordings of the long throw depth camera are 448x450, of the short throw
+    // depth camera 512x512 and of the visible light cameras 640x480.
+    //
+    void SampleCameraSpaceProjection(
+        _In_ const uint32_t imageWidth,
+        _In_ const uint32_t imageHeight,
+        _In_ const MapImagePointFunction& mapImagePoint,
+        _Out_ std::vector<float>& cameraSpaceProjection);
+
+    //
+    // 64-bit FNV-1a hash of the LUT's size and of its points, as streamed:
+    // (x, y) pairs, row by row.
+    //
+    uint64_t HashUnprojectionLut(
+        _In_ const UnprojectionLut& unprojectionLut);
+}
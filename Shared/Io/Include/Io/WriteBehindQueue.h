@@ -0,0 +1,270 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#pragma once
+
+#include <Io/Portability.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Io
+{
+    //
+    // Bounded queue of items written to disk by a dedicated writer thread, so
+    // that a disk stall does not block the thread producing the items. When the
+    // queue is full, the oldest pending item is dropped. Independent of what is
+    // written: the writer thread hands each item to a write function.
+    //
+    // A write function that throws a std::exception, e.g. because the disk is
+    // full, leaves the output in an unknown state: the item is dropped, the
+    // queue is marked failed, and all later items are dropped without being
+    // written. The failure is reported by HasFailed and GetFailureMessage.
+    //
+    template <typename TItem>
+    class WriteBehindQueue
+    {
+    public:
+        //
+        // Writes an item and adds the number of bytes written to bytesWritten.
+        // Returns false if the item was dropped without compromising the
+        // output, e.g. because its buffer was recycled while it was queued.
+        //
+        typedef std::function<bool(TItem& item, uint64_t* bytesWritten)> WriteFunction;
+
+        WriteBehindQueue()
+            : _maximumDepth(16)
+            , _running(false)
+            , _stopRequested(false)
+            , _failed(false)
+            , _droppedItems(0)
+            , _bytesWritten(0)
+        {
+        }
+
+        ~WriteBehindQueue()
+        {
+            Stop();
+        }
+
+        WriteBehindQueue(const WriteBehindQueue&) = delete;
+        WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+        //
+        // Starts the writer thread. Clears the failure of a previous run.
+        //
+        void Start(
+            _In_ const WriteFunction& write)
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+
+            REQUIRES(!_running);
+
+            _write = write;
+            _running = true;
+            _stopRequested = false;
+            _failed = false;
+            _failureMessage.clear();
+
+            _writerThread = std::thread(
+                [this]()
+            {
+                WriterThreadProc();
+            });
+        }
+
+        //
+        // Waits for the writer thread to write the pending items, then stops
+        // it. Items pushed afterwards are ignored until the next Start.
+        //
+        void Stop()
+        {
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                _stopRequested = true;
+            }
+
+            _pendingItemsChanged.notify_all();
+
+            if (_writerThread.joinable())
+            {
+                _writerThread.join();
+            }
+
+            std::lock_guard<std::mutex> guard(_mutex);
+
+            _running = false;
+            _write = nullptr;
+        }
+
+        //
+        // Queues an item, dropping the oldest pending item if the queue is
+        // full. Returns false if the item was ignored because the queue is not
+        // running.
+        //
+        bool Push(
+            _In_ const TItem& item)
+        {
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+
+                if (!_running || _stopRequested)
+                {
+                    return false;
+                }
+
+                while (_pendingItems.size() >= _maximumDepth)
+                {
+                    _pendingItems.pop_front();
+                    ++_droppedItems;
+                }
+
+                _pendingItems.push_back(item);
+            }
+
+            _pendingItemsChanged.notify_one();
+
+            return true;
+        }
+
+        size_t GetMaximumDepth() const
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            return _maximumDepth;
+        }
+
+        void SetMaximumDepth(
+            _In_ const size_t maximumDepth)
+        {
+            REQUIRES(maximumDepth > 0);
+
+            std::lock_guard<std::mutex> guard(_mutex);
+            _maximumDepth = maximumDepth;
+        }
+
+        // Number of items waiting to be written.
+        size_t GetDepth() const
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            return _pendingItems.size();
+        }
+
+        // Number of items that were not written, since the queue was created.
+        uint64_t GetDroppedItems() const
+        {
+            return _droppedItems.load();
+        }
+
+        // Number of bytes written, since the queue was created.
+        uint64_t GetBytesWritten() const
+        {
+            return _bytesWritten.load();
+        }
+
+        bool HasFailed() const
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            return _failed;
+        }
+
+        std::string GetFailureMessage() const
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            return _failureMessage;
+        }
+
+    private:
+        void WriterThreadProc()
+        {
+            while (true)
+            {
+                TItem item;
+                bool failed = false;
+
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+
+                    _pendingItemsChanged.wait(
+                        lock,
+                        [this]()
+                    {
+                        return _stopRequested || !_pendingItems.empty();
+                    });
+
+                    if (_pendingItems.empty())
+                    {
+                        // Stop was requested and the queue has been drained.
+                        break;
+                    }
+
+                    item = _pendingItems.front();
+                    _pendingItems.pop_front();
+
+                    failed = _failed;
+                }
+
+                if (failed)
+                {
+                    ++_droppedItems;
+                    continue;
+                }
+
+                uint64_t bytesWritten = 0;
+                bool written = false;
+
+                try
+                {
+                    written = _write(item, &bytesWritten);
+                }
+                catch (const std::exception& exception)
+                {
+                    std::lock_guard<std::mutex> guard(_mutex);
+
+                    _failed = true;
+                    _failureMessage = exception.what();
+                }
+
+                _bytesWritten += bytesWritten;
+
+                if (!written)
+                {
+                    ++_droppedItems;
+                }
+            }
+        }
+
+        mutable std::mutex _mutex;
+        std::condition_variable _pendingItemsChanged;
+
+        std::deque<TItem> _pendingItems;
+        size_t _maximumDepth;
+
+        WriteFunction _write;
+        std::thread _writerThread;
+
+        bool _running;
+        bool _stopRequested;
+
+        bool _failed;
+        std::string _failureMessage;
+
+        std::atomic<uint64_t> _droppedItems;
+        std::atomic<uint64_t> _bytesWritten;
+    };
+}
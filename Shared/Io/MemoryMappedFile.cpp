@@ -0,0 +1,150 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+namespace Io
+{
+    MemoryMappedFile::MemoryMappedFile(
+        _In_ const std::wstring& fileName)
+        : _mapping(nullptr)
+        , _data(nullptr)
+        , _size(0)
+    {
+        HANDLE file = CreateFile2(
+            fileName.c_str(),
+            GENERIC_READ /* dwDesiredAccess */,
+            FILE_SHARE_READ /* dwShareMode */,
+            OPEN_EXISTING /* dwCreationDisposition */,
+            nullptr /* pCreateExParams */);
+
+        ASSERT(INVALID_HANDLE_VALUE != file);
+
+        Map(file);
+    }
+
+    MemoryMappedFile::MemoryMappedFile(
+        _In_ Windows::Storage::StorageFolder^ folder,
+        _In_ const std::wstring& fileName)
+        : _mapping(nullptr)
+        , _data(nullptr)
+        , _size(0)
+    {
+        Microsoft::WRL::ComPtr<IStorageFolderHandleAccess> folderHandleAccess =
+            GetStorageFolderHandleAccess(
+                folder);
+
+        HANDLE file = nullptr;
+
+        ASSERT_SUCCEEDED(folderHandleAccess->Create(
+            fileName.c_str() /* fileName */,
+            HCO_OPEN_EXISTING /* creationOptions */,
+            HAO_READ /* accessOptions */,
+            HSO_SHARE_READ /* sharingOptions */,
+            HO_RANDOM_ACCESS /* options */,
+            nullptr /* oplockBreakingHandler */,
+            &file));
+
+        Map(file);
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+        Unmap();
+    }
+
+    void MemoryMappedFile::Map(
+        _In_ HANDLE file)
+    {
+        //
+        // The mapping keeps the file open, so the file handle is closed once
+        // the file is mapped, or if it could not be mapped.
+        //
+        try
+        {
+            LARGE_INTEGER fileSize = {};
+
+            ASSERT(!!GetFileSizeEx(
+                file,
+                &fileSize));
+
+            //
+            // The whole file is mapped into a single view, which has to fit in
+            // the address space of the process. Tarballs, which easily outgrow
+            // that of a 32-bit process, are mapped one entry at a time by
+            // Io::TarReader instead.
+            //
+            REQUIRES(static_cast<uint64_t>(fileSize.QuadPart) <= SIZE_MAX);
+
+            _size = static_cast<size_t>(fileSize.QuadPart);
+
+            //
+            // Empty files cannot be mapped. They are represented by a null view.
+            //
+            if (0 != _size)
+            {
+                _mapping = CreateFileMappingFromApp(
+                    file,
+                    nullptr /* SecurityAttributes */,
+                    PAGE_READONLY /* PageProtection */,
+                    0 /* MaximumSize */,
+                    nullptr /* Name */);
+
+                ASSERT(nullptr != _mapping);
+
+                _data = reinterpret_cast<const uint8_t*>(
+                    MapViewOfFileFromApp(
+                        _mapping,
+                        FILE_MAP_READ /* DesiredAccess */,
+                        0 /* FileOffset */,
+                        0 /* NumberOfBytesToMap */));
+
+                ASSERT(nullptr != _data);
+            }
+        }
+        catch (...)
+        {
+            //
+            // The destructor does not run when the constructor throws.
+            //
+            Unmap();
+
+            CloseHandle(
+                file);
+
+            throw;
+        }
+
+        ASSERT(!!CloseHandle(
+            file));
+    }
+
+    void MemoryMappedFile::Unmap()
+    {
+        if (nullptr != _data)
+        {
+            UnmapViewOfFile(
+                _data);
+
+            _data = nullptr;
+        }
+
+        if (nullptr != _mapping)
+        {
+            CloseHandle(
+                _mapping);
+
+            _mapping = nullptr;
+        }
+
+        _size = 0;
+    }
+}
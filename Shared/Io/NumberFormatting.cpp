@@ -0,0 +1,600 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see FormatFloat.
+//
+#include <Io/NumberFormatting.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace Io
+{
+    namespace
+    {
+        const char c_digitPairs[201] =
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+
+        //
+        // Ryu parameters and tables for 32-bit floats, see Ulf Adams, "Ryu: Fast
+        // Float-to-String Conversion", PLDI 2018. FloatPow5InvSplit[i] is
+        // 2^(bitlength(5^i) - 1 + 59) / 5^i rounded up, FloatPow5Split[i] holds
+        // the top 61 bits of 5^i.
+        //
+        const int32_t c_floatMantissaBits = 23;
+        const int32_t c_floatExponentBits = 8;
+        const int32_t c_floatBias = 127;
+
+        const int32_t c_floatPow5InvBitCount = 59;
+        const int32_t c_floatPow5BitCount = 61;
+
+        const uint64_t c_floatPow5InvSplit[31] =
+        {
+            0x0800000000000001ull, 0x0666666666666667ull, 0x051eb851eb851eb9ull,
+            0x04189374bc6a7efaull, 0x068db8bac710cb2aull, 0x053e2d6238da3c22ull,
+            0x0431bde82d7b634eull, 0x06b5fca6af2bd216ull, 0x055e63b88c230e78ull,
+            0x044b82fa09b5a52dull, 0x06df37f675ef6eaeull, 0x057f5ff85e592558ull,
+            0x0465e6604b7a8447ull, 0x0709709a125da071ull, 0x05a126e1a84ae6c1ull,
+            0x0480ebe7b9d58567ull, 0x0734aca5f6226f0bull, 0x05c3bd5191b525a3ull,
+            0x049c97747490eae9ull, 0x0760f253edb4ab0eull, 0x05e72843249088d8ull,
+            0x04b8ed0283a6d3e0ull, 0x078e480405d7b966ull, 0x060b6cd004ac9452ull,
+            0x04d5f0a66a23a9dbull, 0x07bcb43d769f762bull, 0x063090312bb2c4efull,
+            0x04f3a68dbc8f03f3ull, 0x07ec3daf94180651ull, 0x065697bfa9acd1daull,
+            0x051212ffbaf0a7e2ull,
+        };
+
+        const uint64_t c_floatPow5Split[48] =
+        {
+            0x1000000000000000ull, 0x1400000000000000ull, 0x1900000000000000ull,
+            0x1f40000000000000ull, 0x1388000000000000ull, 0x186a000000000000ull,
+            0x1e84800000000000ull, 0x1312d00000000000ull, 0x17d7840000000000ull,
+            0x1dcd650000000000ull, 0x12a05f2000000000ull, 0x174876e800000000ull,
+            0x1d1a94a200000000ull, 0x12309ce540000000ull, 0x16bcc41e90000000ull,
+            0x1c6bf52634000000ull, 0x11c37937e0800000ull, 0x16345785d8a00000ull,
+            0x1bc16d674ec80000ull, 0x1158e460913d0000ull, 0x15af1d78b58c4000ull,
+            0x1b1ae4d6e2ef5000ull, 0x10f0cf064dd59200ull, 0x152d02c7e14af680ull,
+            0x1a784379d99db420ull, 0x108b2a2c28029094ull, 0x14adf4b7320334b9ull,
+            0x19d971e4fe8401e7ull, 0x1027e72f1f128130ull, 0x1431e0fae6d7217cull,
+            0x193e5939a08ce9dbull, 0x1f8def8808b02452ull, 0x13b8b5b5056e16b3ull,
+            0x18a6e32246c99c60ull, 0x1ed09bead87c0378ull, 0x13426172c74d822bull,
+            0x1812f9cf7920e2b6ull, 0x1e17b84357691b64ull, 0x12ced32a16a1b11eull,
+            0x178287f49c4a1d66ull, 0x1d6329f1c35ca4bfull, 0x125dfa371a19e6f7ull,
+            0x16f578c4e0a060b5ull, 0x1cb2d6f618c878e3ull, 0x11efc659cf7d4b8dull,
+            0x166bb7f0435c9e71ull, 0x1c06a5ec5433c60dull, 0x118427b3b4a05bc8ull,
+        };
+
+        //
+        // Returns the number of decimal digits of a value below 10^10.
+        //
+        uint32_t DecimalLength(
+            _In_ const uint32_t value)
+        {
+            uint32_t length = 1;
+
+            for (uint32_t bound = 10; length < 10 && value >= bound; bound *= 10)
+            {
+                ++length;
+            }
+
+            return length;
+        }
+
+        //
+        // Writes the digits of the value right-aligned so that the last digit
+        // ends at output[length - 1].
+        //
+        void WriteDigits(
+            _In_ uint64_t value,
+            _In_ const size_t length,
+            _Out_writes_(length) char* output)
+        {
+            char* position = output + length;
+
+            while (value >= 100)
+            {
+                const size_t pair = static_cast<size_t>(value % 100) * 2;
+                value /= 100;
+
+                *--position = c_digitPairs[pair + 1];
+                *--position = c_digitPairs[pair];
+            }
+
+            if (value >= 10)
+            {
+                const size_t pair = static_cast<size_t>(value) * 2;
+
+                *--position = c_digitPairs[pair + 1];
+                *--position = c_digitPairs[pair];
+            }
+            else
+            {
+                *--position = static_cast<char>('0' + value);
+            }
+        }
+
+        // ceil(log2(5^e)) for e > 0, 1 for e == 0.
+        int32_t Pow5Bits(
+            _In_ const int32_t e)
+        {
+            return static_cast<int32_t>(((static_cast<uint32_t>(e) * 1217359) >> 19) + 1);
+        }
+
+        // floor(log10(2^e))
+        uint32_t Log10Pow2(
+            _In_ const int32_t e)
+        {
+            return (static_cast<uint32_t>(e) * 78913) >> 18;
+        }
+
+        // floor(log10(5^e))
+        uint32_t Log10Pow5(
+            _In_ const int32_t e)
+        {
+            return (static_cast<uint32_t>(e) * 732923) >> 20;
+        }
+
+        uint32_t Pow5Factor(
+            _In_ uint32_t value)
+        {
+            uint32_t count = 0;
+
+            for (;;)
+            {
+                const uint32_t quotient = value / 5;
+
+                if (value != quotient * 5)
+                {
+                    break;
+                }
+
+                value = quotient;
+                ++count;
+            }
+
+            return count;
+        }
+
+        bool IsMultipleOfPowerOf5(
+            _In_ const uint32_t value,
+            _In_ const uint32_t p)
+        {
+            return Pow5Factor(value) >= p;
+        }
+
+        bool IsMultipleOfPowerOf2(
+            _In_ const uint32_t value,
+            _In_ const uint32_t p)
+        {
+            return 0 == (value & ((1u << p) - 1));
+        }
+
+        uint32_t MulShift(
+            _In_ const uint32_t m,
+            _In_ const uint64_t factor,
+            _In_ const int32_t shift)
+        {
+            const uint64_t factorLow = static_cast<uint32_t>(factor);
+            const uint64_t factorHigh = factor >> 32;
+
+            const uint64_t bits0 = m * factorLow;
+            const uint64_t bits1 = m * factorHigh;
+
+            const uint64_t sum = (bits0 >> 32) + bits1;
+
+            return static_cast<uint32_t>(sum >> (shift - 32));
+        }
+
+        //
+        // Computes the shortest decimal significand and exponent of a finite,
+        // positive float given by its biased exponent and mantissa bits.
+        //
+        void FloatToDecimal(
+            _In_ const uint32_t ieeeMantissa,
+            _In_ const uint32_t ieeeExponent,
+            _Out_ uint32_t* significand,
+            _Out_ int32_t* exponent)
+        {
+            int32_t e2;
+            uint32_t m2;
+
+            if (0 == ieeeExponent)
+            {
+                e2 = 1 - c_floatBias - c_floatMantissaBits - 2;
+                m2 = ieeeMantissa;
+            }
+            else
+            {
+                e2 = static_cast<int32_t>(ieeeExponent) - c_floatBias - c_floatMantissaBits - 2;
+                m2 = (1u << c_floatMantissaBits) | ieeeMantissa;
+            }
+
+            const bool acceptBounds = (0 == (m2 & 1));
+
+            //
+            // The value and the midpoints to its neighbours, scaled by 4.
+            //
+            const uint32_t mv = 4 * m2;
+            const uint32_t mp = 4 * m2 + 2;
+            const uint32_t mmShift = (0 != ieeeMantissa || ieeeExponent <= 1) ? 1 : 0;
+            const uint32_t mm = 4 * m2 - 1 - mmShift;
+
+            uint32_t vr, vp, vm;
+            int32_t e10;
+            bool vmIsTrailingZeros = false;
+            bool vrIsTrailingZeros = false;
+            uint32_t lastRemovedDigit = 0;
+
+            if (e2 >= 0)
+            {
+                const uint32_t q = Log10Pow2(e2);
+                const int32_t k = c_floatPow5InvBitCount + Pow5Bits(q) - 1;
+                const int32_t i = -e2 + static_cast<int32_t>(q) + k;
+
+                e10 = static_cast<int32_t>(q);
+
+                vr = MulShift(mv, c_floatPow5InvSplit[q], i);
+                vp = MulShift(mp, c_floatPow5InvSplit[q], i);
+                vm = MulShift(mm, c_floatPow5InvSplit[q], i);
+
+                if (0 != q && (vp - 1) / 10 <= vm / 10)
+                {
+                    //
+                    // We need to know one removed digit even if we are not
+                    // going to loop below.
+                    //
+                    const int32_t l = c_floatPow5InvBitCount + Pow5Bits(q - 1) - 1;
+
+                    lastRemovedDigit =
+                        MulShift(mv, c_floatPow5InvSplit[q - 1], -e2 + static_cast<int32_t>(q) - 1 + l) % 10;
+                }
+
+                if (q <= 9)
+                {
+                    //
+                    // Only one of mp, mv and mm can be a multiple of 5, if any.
+                    //
+                    if (0 == mv % 5)
+                    {
+                        vrIsTrailingZeros = IsMultipleOfPowerOf5(mv, q);
+                    }
+                    else if (acceptBounds)
+                    {
+                        vmIsTrailingZeros = IsMultipleOfPowerOf5(mm, q);
+                    }
+                    else
+                    {
+                        vp -= IsMultipleOfPowerOf5(mp, q) ? 1 : 0;
+                    }
+                }
+            }
+            else
+            {
+                const uint32_t q = Log10Pow5(-e2);
+                const int32_t i = -e2 - static_cast<int32_t>(q);
+                const int32_t k = Pow5Bits(i) - c_floatPow5BitCount;
+                const int32_t j = static_cast<int32_t>(q) - k;
+
+                e10 = static_cast<int32_t>(q) + e2;
+
+                vr = MulShift(mv, c_floatPow5Split[i], j);
+                vp = MulShift(mp, c_floatPow5Split[i], j);
+                vm = MulShift(mm, c_floatPow5Split[i], j);
+
+                if (0 != q && (vp - 1) / 10 <= vm / 10)
+                {
+                    const int32_t l = static_cast<int32_t>(q) - 1 - (Pow5Bits(i + 1) - c_floatPow5BitCount);
+
+                    lastRemovedDigit =
+                        MulShift(mv, c_floatPow5Split[i + 1], l) % 10;
+                }
+
+                if (q <= 1)
+                {
+                    //
+                    // mv = 4 * m2 has at least two trailing zero bits.
+                    //
+                    vrIsTrailingZeros = true;
+
+                    if (acceptBounds)
+                    {
+                        vmIsTrailingZeros = (1 == mmShift);
+                    }
+                    else
+                    {
+                        --vp;
+                    }
+                }
+                else if (q < 31)
+                {
+                    vrIsTrailingZeros = IsMultipleOfPowerOf2(mv, q - 1);
+                }
+            }
+
+            //
+            // Remove digits while the interval still contains a shorter number.
+            //
+            int32_t removed = 0;
+            uint32_t output;
+
+            if (vmIsTrailingZeros || vrIsTrailingZeros)
+            {
+                while (vp / 10 > vm / 10)
+                {
+                    vmIsTrailingZeros &= (0 == vm % 10);
+                    vrIsTrailingZeros &= (0 == lastRemovedDigit);
+
+                    lastRemovedDigit = vr % 10;
+
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    ++removed;
+                }
+
+                if (vmIsTrailingZeros)
+                {
+                    while (0 == vm % 10)
+                    {
+                        vrIsTrailingZeros &= (0 == lastRemovedDigit);
+
+                        lastRemovedDigit = vr % 10;
+
+                        vr /= 10;
+                        vp /= 10;
+                        vm /= 10;
+                        ++removed;
+                    }
+                }
+
+                if (vrIsTrailingZeros && 5 == lastRemovedDigit && 0 == vr % 2)
+                {
+                    // Round even if the exact number is .....50..0.
+                    lastRemovedDigit = 4;
+                }
+
+                output = vr +
+                    (((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5) ? 1 : 0);
+            }
+            else
+            {
+                while (vp / 10 > vm / 10)
+                {
+                    lastRemovedDigit = vr % 10;
+
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                    ++removed;
+                }
+
+                output = vr + ((vr == vm || lastRemovedDigit >= 5) ? 1 : 0);
+            }
+
+            *significand = output;
+            *exponent = e10 + removed;
+        }
+
+        //
+        // Lays out significand * 10^exponent, the shortest representation of
+        // the given positive value, in fixed or scientific notation, whichever
+        // is shorter, preferring fixed notation on ties.
+        //
+        size_t WriteDecimal(
+            _In_ const float value,
+            _In_ const uint32_t significand,
+            _In_ const int32_t exponent,
+            _Out_writes_(MaxFormattedFloatLength) char* output)
+        {
+            const int32_t length =
+                static_cast<int32_t>(DecimalLength(significand));
+
+            const int32_t scientificExponent = length - 1 + exponent;
+            const int32_t absoluteScientificExponent =
+                scientificExponent < 0 ? -scientificExponent : scientificExponent;
+
+            const int32_t scientificLength =
+                length + (length > 1 ? 1 : 0) + 2 + (absoluteScientificExponent >= 100 ? 3 : 2);
+
+            int32_t fixedLength;
+
+            if (exponent >= 0)
+            {
+                fixedLength = length + exponent;
+            }
+            else if (length + exponent > 0)
+            {
+                fixedLength = length + 1;
+            }
+            else
+            {
+                fixedLength = 2 - (length + exponent) + length;
+            }
+
+            if (fixedLength <= scientificLength)
+            {
+                if (exponent > 0)
+                {
+                    //
+                    // The value is an integer; print it exactly rather than
+                    // padding the shortest digits with zeros.
+                    //
+                    return FormatUInt64(
+                        static_cast<uint64_t>(value),
+                        output);
+                }
+                else if (0 == exponent)
+                {
+                    WriteDigits(significand, length, output);
+                }
+                else if (length + exponent > 0)
+                {
+                    const int32_t integerLength = length + exponent;
+
+                    WriteDigits(significand, length + 1, output);
+                    memmove(output, output + 1, integerLength);
+                    output[integerLength] = '.';
+                }
+                else
+                {
+                    const int32_t leadingZeros = -(length + exponent);
+
+                    output[0] = '0';
+                    output[1] = '.';
+                    memset(output + 2, '0', leadingZeros);
+                    WriteDigits(significand, length, output + 2 + leadingZeros);
+                }
+
+                return static_cast<size_t>(fixedLength);
+            }
+
+            WriteDigits(significand, length + (length > 1 ? 1 : 0), output);
+
+            if (length > 1)
+            {
+                output[0] = output[1];
+                output[1] = '.';
+            }
+
+            size_t position = static_cast<size_t>(length + (length > 1 ? 1 : 0));
+
+            output[position++] = 'e';
+            output[position++] = scientificExponent < 0 ? '-' : '+';
+
+            // The exponent has at least two digits.
+            if (absoluteScientificExponent < 10)
+            {
+                output[position++] = '0';
+            }
+
+            const size_t exponentLength =
+                DecimalLength(absoluteScientificExponent);
+
+            WriteDigits(absoluteScientificExponent, exponentLength, output + position);
+
+            return position + exponentLength;
+        }
+    }
+
+    size_t FormatUInt64(
+        _In_ const uint64_t value,
+        _Out_writes_(MaxFormattedIntegerLength) char* output)
+    {
+        size_t length = 1;
+
+        for (uint64_t remaining = value; remaining >= 10; remaining /= 10)
+        {
+            ++length;
+        }
+
+        WriteDigits(value, length, output);
+
+        return length;
+    }
+
+    size_t FormatInt64(
+        _In_ const int64_t value,
+        _Out_writes_(MaxFormattedIntegerLength + 1) char* output)
+    {
+        if (value >= 0)
+        {
+            return FormatUInt64(
+                static_cast<uint64_t>(value),
+                output);
+        }
+
+        output[0] = '-';
+
+        return 1 + FormatUInt64(
+            0 - static_cast<uint64_t>(value),
+            output + 1);
+    }
+
+    size_t FormatFloat(
+        _In_ const float value,
+        _Out_writes_(MaxFormattedFloatLength) char* output)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        const bool sign = 0 != (bits >> 31);
+        const uint32_t ieeeMantissa = bits & ((1u << c_floatMantissaBits) - 1);
+        const uint32_t ieeeExponent = (bits >> c_floatMantissaBits) & ((1u << c_floatExponentBits) - 1);
+
+        size_t position = 0;
+
+        if (sign)
+        {
+            output[position++] = '-';
+        }
+
+        if (ieeeExponent == ((1u << c_floatExponentBits) - 1))
+        {
+            const char* text =
+                (0 != ieeeMantissa) ? "nan" : "inf";
+
+            memcpy(output + position, text, 3);
+
+            return position + 3;
+        }
+
+        if (0 == ieeeExponent && 0 == ieeeMantissa)
+        {
+            output[position] = '0';
+
+            return position + 1;
+        }
+
+        uint32_t significand;
+        int32_t exponent;
+
+        FloatToDecimal(
+            ieeeMantissa,
+            ieeeExponent,
+            &significand,
+            &exponent);
+
+        return position + WriteDecimal(
+            sign ? -value : value,
+            significand,
+            exponent,
+            output + position);
+    }
+
+    size_t FormatDouble(
+        _In_ const double value,
+        _Out_writes_(MaxFormattedDoubleLength) char* output)
+    {
+        char buffer[32];
+
+        const int length = snprintf(
+            buffer,
+            sizeof(buffer),
+            "%.17g",
+            value);
+
+        ASSERT(length > 0 && length <= static_cast<int>(MaxFormattedDoubleLength));
+
+        memcpy(output, buffer, length);
+
+        return static_cast<size_t>(length);
+    }
+}
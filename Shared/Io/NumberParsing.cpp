@@ -0,0 +1,344 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see ParseFloat.
+//
+#include <Io/NumberParsing.h>
+
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace Io
+{
+    namespace
+    {
+        //
+        // Powers of ten that are exactly representable as doubles.
+        //
+        const double c_exactPowersOfTen[23] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        const uint64_t c_maxExactDoubleInteger = 1ull << 53;
+
+        //
+        // Splits a decimal number into its sign, integral significand and power
+        // of ten. Returns false if the text is not a plain decimal number (e.g.
+        // "inf") or if the significand does not fit into 64 bits.
+        //
+        bool ParseDecimal(
+            _In_reads_(last - first) const char* first,
+            _In_ const char* last,
+            _Out_ bool* negative,
+            _Out_ uint64_t* significand,
+            _Out_ int32_t* exponent)
+        {
+            const char* position = first;
+
+            *negative = false;
+
+            if (position != last && ('-' == *position || '+' == *position))
+            {
+                *negative = ('-' == *position);
+                ++position;
+            }
+
+            uint64_t digits = 0;
+            int32_t numberOfDigits = 0;
+            int32_t decimalExponent = 0;
+            bool seenDigit = false;
+
+            for (; position != last && *position >= '0' && *position <= '9'; ++position)
+            {
+                digits = digits * 10 + static_cast<uint32_t>(*position - '0');
+                numberOfDigits += (0 != digits) ? 1 : 0;
+                seenDigit = true;
+            }
+
+            if (position != last && '.' == *position)
+            {
+                ++position;
+
+                for (; position != last && *position >= '0' && *position <= '9'; ++position)
+                {
+                    digits = digits * 10 + static_cast<uint32_t>(*position - '0');
+                    numberOfDigits += (0 != digits) ? 1 : 0;
+                    --decimalExponent;
+                    seenDigit = true;
+                }
+            }
+
+            //
+            // Nineteen significant digits always fit into 64 bits.
+            //
+            if (!seenDigit || numberOfDigits > 19)
+            {
+                return false;
+            }
+
+            if (position != last && ('e' == *position || 'E' == *position))
+            {
+                ++position;
+
+                bool negativeExponent = false;
+
+                if (position != last && ('-' == *position || '+' == *position))
+                {
+                    negativeExponent = ('-' == *position);
+                    ++position;
+                }
+
+                if (position == last)
+                {
+                    return false;
+                }
+
+                int32_t explicitExponent = 0;
+
+                for (; position != last && *position >= '0' && *position <= '9'; ++position)
+                {
+                    if (explicitExponent > 100000)
+                    {
+                        return false;
+                    }
+
+                    explicitExponent = explicitExponent * 10 + (*position - '0');
+                }
+
+                decimalExponent += negativeExponent ? -explicitExponent : explicitExponent;
+            }
+
+            if (position != last)
+            {
+                return false;
+            }
+
+            *significand = digits;
+            *exponent = decimalExponent;
+
+            return true;
+        }
+
+        //
+        // Exact when the significand and the power of ten are both exactly
+        // representable, as the single multiplication or division then rounds
+        // correctly.
+        //
+        bool TryComputeExactDouble(
+            _In_ const uint64_t significand,
+            _In_ const int32_t exponent,
+            _Out_ double* value)
+        {
+            if (significand > c_maxExactDoubleInteger || exponent < -22 || exponent > 22)
+            {
+                return false;
+            }
+
+            *value = static_cast<double>(significand);
+
+            if (exponent < 0)
+            {
+                *value /= c_exactPowersOfTen[-exponent];
+            }
+            else
+            {
+                *value *= c_exactPowersOfTen[exponent];
+            }
+
+            return true;
+        }
+
+        template <typename T, typename ConvertFn>
+        bool ParseWithCRuntime(
+            _In_reads_(last - first) const char* first,
+            _In_ const char* last,
+            _In_ ConvertFn convert,
+            _Out_ T* value)
+        {
+            //
+            // strtod also skips leading whitespace and reads hexadecimal
+            // numbers, neither of which CsvWriter produces.
+            //
+            for (const char* position = first; position != last; ++position)
+            {
+                if (' ' == *position || '\t' == *position || 'x' == *position || 'X' == *position)
+                {
+                    return false;
+                }
+            }
+
+            //
+            // strtod needs a null-terminated string.
+            //
+            const std::string text(
+                first,
+                last);
+
+            char* end = nullptr;
+
+            *value = convert(
+                text.c_str(),
+                &end);
+
+            return !text.empty() && end == text.c_str() + text.size();
+        }
+    }
+
+    bool ParseUInt64(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ uint64_t* value)
+    {
+        *value = 0;
+
+        if (first == last)
+        {
+            return false;
+        }
+
+        uint64_t result = 0;
+
+        for (const char* position = first; position != last; ++position)
+        {
+            if (*position < '0' || *position > '9')
+            {
+                return false;
+            }
+
+            const uint32_t digit = static_cast<uint32_t>(*position - '0');
+
+            if (result > (UINT64_MAX - digit) / 10)
+            {
+                return false;
+            }
+
+            result = result * 10 + digit;
+        }
+
+        *value = result;
+
+        return true;
+    }
+
+    bool ParseInt64(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ int64_t* value)
+    {
+        *value = 0;
+
+        const bool negative =
+            (first != last && '-' == *first);
+
+        uint64_t magnitude = 0;
+
+        if (!ParseUInt64(negative ? first + 1 : first, last, &magnitude))
+        {
+            return false;
+        }
+
+        if (negative)
+        {
+            if (magnitude > static_cast<uint64_t>(INT64_MAX) + 1)
+            {
+                return false;
+            }
+
+            *value = static_cast<int64_t>(0 - magnitude);
+        }
+        else
+        {
+            if (magnitude > static_cast<uint64_t>(INT64_MAX))
+            {
+                return false;
+            }
+
+            *value = static_cast<int64_t>(magnitude);
+        }
+
+        return true;
+    }
+
+    bool ParseFloat(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ float* value)
+    {
+        bool negative;
+        uint64_t significand;
+        int32_t exponent;
+        double exactValue;
+
+        if (ParseDecimal(first, last, &negative, &significand, &exponent) &&
+            TryComputeExactDouble(significand, exponent, &exactValue))
+        {
+            uint64_t bits;
+            memcpy(&bits, &exactValue, sizeof(bits));
+
+            //
+            // Rounding the correctly rounded double to float gives the correctly
+            // rounded float unless the double landed exactly halfway between
+            // two floats, or the result is subnormal.
+            //
+            const uint64_t c_floatRoundingBits = (1ull << 29) - 1;
+            const uint64_t c_floatHalfway = 1ull << 28;
+
+            if ((bits & c_floatRoundingBits) != c_floatHalfway &&
+                (0.0 == exactValue || exactValue >= FLT_MIN))
+            {
+                *value = static_cast<float>(negative ? -exactValue : exactValue);
+                return true;
+            }
+        }
+
+        return ParseWithCRuntime(
+            first,
+            last,
+            [](const char* text, char** end)
+        {
+            return strtof(text, end);
+        },
+            value);
+    }
+
+    bool ParseDouble(
+        _In_reads_(last - first) const char* first,
+        _In_ const char* last,
+        _Out_ double* value)
+    {
+        bool negative;
+        uint64_t significand;
+        int32_t exponent;
+        double exactValue;
+
+        if (ParseDecimal(first, last, &negative, &significand, &exponent) &&
+            TryComputeExactDouble(significand, exponent, &exactValue))
+        {
+            *value = negative ? -exactValue : exactValue;
+            return true;
+        }
+
+        return ParseWithCRuntime(
+            first,
+            last,
+            [](const char* text, char** end)
+        {
+            return strtod(text, end);
+        },
+            value);
+    }
+}
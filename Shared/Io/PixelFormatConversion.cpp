@@ -0,0 +1,351 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see PackBgraToRgb.
+//
+#include <Io/PixelFormatConversion.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define IO_PIXEL_FORMAT_CONVERSION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define IO_PIXEL_FORMAT_CONVERSION_TARGET_SSSE3
+#define IO_PIXEL_FORMAT_CONVERSION_TARGET_AVX2
+#else
+#define IO_PIXEL_FORMAT_CONVERSION_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define IO_PIXEL_FORMAT_CONVERSION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define IO_PIXEL_FORMAT_CONVERSION_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace Io
+{
+    namespace
+    {
+        void PackBgraToRgbScalar(
+            _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+            _In_ const size_t numberOfPixels,
+            _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels)
+        {
+            for (size_t i = 0; i < numberOfPixels; ++i)
+            {
+                rgbPixels[0] = bgraPixels[2];
+                rgbPixels[1] = bgraPixels[1];
+                rgbPixels[2] = bgraPixels[0];
+
+                bgraPixels += 4;
+                rgbPixels += 3;
+            }
+        }
+
+#if IO_PIXEL_FORMAT_CONVERSION_X86
+        //
+        // Moves the RGB bytes of four BGRA pixels into the low 12 bytes of the
+        // register; the upper four bytes are cleared.
+        //
+        IO_PIXEL_FORMAT_CONVERSION_TARGET_SSSE3
+        __m128i ShuffleBgraToRgb(
+            _In_ const __m128i bgra)
+        {
+            const __m128i shuffle = _mm_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+            return _mm_shuffle_epi8(
+                bgra,
+                shuffle);
+        }
+
+        IO_PIXEL_FORMAT_CONVERSION_TARGET_SSSE3
+        void PackBgraToRgbSsse3(
+            _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+            _In_ const size_t numberOfPixels,
+            _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels)
+        {
+            size_t i = 0;
+
+            //
+            // Sixteen pixels per iteration: four 12-byte groups are merged
+            // into three full 16-byte stores.
+            //
+            for (; i + 16 <= numberOfPixels; i += 16)
+            {
+                const __m128i* source =
+                    reinterpret_cast<const __m128i*>(bgraPixels + i * 4);
+
+                const __m128i a = ShuffleBgraToRgb(_mm_loadu_si128(source + 0));
+                const __m128i b = ShuffleBgraToRgb(_mm_loadu_si128(source + 1));
+                const __m128i c = ShuffleBgraToRgb(_mm_loadu_si128(source + 2));
+                const __m128i d = ShuffleBgraToRgb(_mm_loadu_si128(source + 3));
+
+                __m128i* destination =
+                    reinterpret_cast<__m128i*>(rgbPixels + i * 3);
+
+                _mm_storeu_si128(
+                    destination + 0,
+                    _mm_or_si128(a, _mm_slli_si128(b, 12)));
+
+                _mm_storeu_si128(
+                    destination + 1,
+                    _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+
+                _mm_storeu_si128(
+                    destination + 2,
+                    _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+            }
+
+            PackBgraToRgbScalar(
+                bgraPixels + i * 4,
+                numberOfPixels - i,
+                rgbPixels + i * 3);
+        }
+
+        IO_PIXEL_FORMAT_CONVERSION_TARGET_AVX2
+        void PackBgraToRgbAvx2(
+            _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+            _In_ const size_t numberOfPixels,
+            _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels)
+        {
+            //
+            // The byte shuffle works within each 128-bit lane, leaving 12 RGB
+            // bytes at the bottom of both lanes; the permute then packs the
+            // two groups into the low 24 bytes of the register.
+            //
+            const __m256i shuffle = _mm256_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+            const __m256i permutation = _mm256_setr_epi32(
+                0, 1, 2, 4, 5, 6, 3, 7);
+
+            size_t i = 0;
+
+            for (; i + 32 <= numberOfPixels; i += 32)
+            {
+                const __m256i* source =
+                    reinterpret_cast<const __m256i*>(bgraPixels + i * 4);
+
+                __m256i rgb[4];
+
+                for (size_t j = 0; j < 4; ++j)
+                {
+                    rgb[j] = _mm256_permutevar8x32_epi32(
+                        _mm256_shuffle_epi8(_mm256_loadu_si256(source + j), shuffle),
+                        permutation);
+                }
+
+                //
+                // Merge the four 24-byte groups into three full 32-byte stores.
+                //
+                __m256i* destination =
+                    reinterpret_cast<__m256i*>(rgbPixels + i * 3);
+
+                _mm256_storeu_si256(
+                    destination + 0,
+                    _mm256_blend_epi32(
+                        rgb[0],
+                        _mm256_permutevar8x32_epi32(rgb[1], _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 0, 1)),
+                        0xc0));
+
+                _mm256_storeu_si256(
+                    destination + 1,
+                    _mm256_blend_epi32(
+                        _mm256_permutevar8x32_epi32(rgb[1], _mm256_setr_epi32(2, 3, 4, 5, 0, 0, 0, 0)),
+                        _mm256_permutevar8x32_epi32(rgb[2], _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3)),
+                        0xf0));
+
+                _mm256_storeu_si256(
+                    destination + 2,
+                    _mm256_blend_epi32(
+                        _mm256_permutevar8x32_epi32(rgb[2], _mm256_setr_epi32(4, 5, 0, 0, 0, 0, 0, 0)),
+                        _mm256_permutevar8x32_epi32(rgb[3], _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5)),
+                        0xfc));
+            }
+
+            _mm256_zeroupper();
+
+            PackBgraToRgbSsse3(
+                bgraPixels + i * 4,
+                numberOfPixels - i,
+                rgbPixels + i * 3);
+        }
+
+        bool IsAvx2Supported()
+        {
+#if defined(_MSC_VER)
+            int cpuInfo[4] = {};
+
+            __cpuid(cpuInfo, 0);
+
+            if (cpuInfo[0] < 7)
+            {
+                return false;
+            }
+
+            __cpuid(cpuInfo, 1);
+
+            //
+            // AVX and OSXSAVE, and the OS must preserve the YMM registers.
+            //
+            const int avxAndOsxsave = (1 << 28) | (1 << 27);
+
+            if (avxAndOsxsave != (cpuInfo[2] & avxAndOsxsave) ||
+                0x6 != (_xgetbv(0) & 0x6))
+            {
+                return false;
+            }
+
+            __cpuidex(cpuInfo, 7, 0);
+
+            return 0 != (cpuInfo[1] & (1 << 5));
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        bool IsSsse3Supported()
+        {
+#if defined(_MSC_VER)
+            int cpuInfo[4] = {};
+
+            __cpuid(cpuInfo, 1);
+
+            return 0 != (cpuInfo[2] & (1 << 9));
+#else
+            return __builtin_cpu_supports("ssse3");
+#endif
+        }
+#endif /* IO_PIXEL_FORMAT_CONVERSION_X86 */
+
+#if IO_PIXEL_FORMAT_CONVERSION_NEON
+        void PackBgraToRgbNeon(
+            _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+            _In_ const size_t numberOfPixels,
+            _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels)
+        {
+            size_t i = 0;
+
+            //
+            // De-interleaving loads and interleaving stores do the channel
+            // swizzle for us.
+            //
+            for (; i + 16 <= numberOfPixels; i += 16)
+            {
+                const uint8x16x4_t bgra =
+                    vld4q_u8(bgraPixels + i * 4);
+
+                uint8x16x3_t rgb;
+
+                rgb.val[0] = bgra.val[2];
+                rgb.val[1] = bgra.val[1];
+                rgb.val[2] = bgra.val[0];
+
+                vst3q_u8(
+                    rgbPixels + i * 3,
+                    rgb);
+            }
+
+            PackBgraToRgbScalar(
+                bgraPixels + i * 4,
+                numberOfPixels - i,
+                rgbPixels + i * 3);
+        }
+#endif /* IO_PIXEL_FORMAT_CONVERSION_NEON */
+
+        PixelFormatConversionIsa DetectPixelFormatConversionIsa()
+        {
+#if IO_PIXEL_FORMAT_CONVERSION_X86
+            if (IsAvx2Supported())
+            {
+                return PixelFormatConversionIsa::Avx2;
+            }
+
+            if (IsSsse3Supported())
+            {
+                return PixelFormatConversionIsa::Ssse3;
+            }
+#elif IO_PIXEL_FORMAT_CONVERSION_NEON
+            return PixelFormatConversionIsa::Neon;
+#endif
+
+            return PixelFormatConversionIsa::Scalar;
+        }
+    }
+
+    PixelFormatConversionIsa GetPixelFormatConversionIsa()
+    {
+        static const PixelFormatConversionIsa isa =
+            DetectPixelFormatConversionIsa();
+
+        return isa;
+    }
+
+    void PackBgraToRgb(
+        _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+        _In_ const size_t numberOfPixels,
+        _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels)
+    {
+        PackBgraToRgb(
+            GetPixelFormatConversionIsa(),
+            bgraPixels,
+            numberOfPixels,
+            rgbPixels);
+    }
+
+    void PackBgraToRgb(
+        _In_ const PixelFormatConversionIsa isa,
+        _In_reads_(numberOfPixels * 4) const uint8_t* bgraPixels,
+        _In_ const size_t numberOfPixels,
+        _Out_writes_(numberOfPixels * 3) uint8_t* rgbPixels)
+    {
+        switch (isa)
+        {
+#if IO_PIXEL_FORMAT_CONVERSION_X86
+        case PixelFormatConversionIsa::Avx2:
+            PackBgraToRgbAvx2(
+                bgraPixels,
+                numberOfPixels,
+                rgbPixels);
+            break;
+
+        case PixelFormatConversionIsa::Ssse3:
+            PackBgraToRgbSsse3(
+                bgraPixels,
+                numberOfPixels,
+                rgbPixels);
+            break;
+#endif /* IO_PIXEL_FORMAT_CONVERSION_X86 */
+
+#if IO_PIXEL_FORMAT_CONVERSION_NEON
+        case PixelFormatConversionIsa::Neon:
+            PackBgraToRgbNeon(
+                bgraPixels,
+                numberOfPixels,
+                rgbPixels);
+            break;
+#endif /* IO_PIXEL_FORMAT_CONVERSION_NEON */
+
+        case PixelFormatConversionIsa::Scalar:
+            PackBgraToRgbScalar(
+                bgraPixels,
+                numberOfPixels,
+                rgbPixels);
+            break;
+
+        default:
+            ASSERT(false);
+        }
+    }
+}
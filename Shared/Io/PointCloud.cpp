@@ -0,0 +1,543 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Built without the precompiled header; see UnprojectDepth.
+//
+#include <Io/PointCloud.h>
+
+#include <limits>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define IO_POINT_CLOUD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define IO_POINT_CLOUD_TARGET_AVX2
+#else
+#define IO_POINT_CLOUD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define IO_POINT_CLOUD_NEON 1
+#if defined(_MSC_VER)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace Io
+{
+    namespace
+    {
+        //
+        // The camera to origin transform, with the depth scale and range, as
+        // used by the row kernels. A pixel's point is s * (x, y, 1), where s is
+        // its depth times the depth scale (times the inverse length of its ray
+        // for radial depths), so that each of its coordinates in the origin
+        // frame is s * (x * Row0[i] + y * Row1[i] + Row2[i]) + Row3[i].
+        //
+        struct Coefficients
+        {
+            float DepthScale;
+            float MinimumDepth;
+            float MaximumDepth;
+
+            float Row0[3];
+            float Row1[3];
+            float Row2[3];
+            float Row3[3];
+        };
+
+        //
+        // Converts count pixels of a row. inverseRayLength is nullptr for depths
+        // along the Z axis. Returns the number of valid points.
+        //
+        typedef size_t (*UnprojectRowFunction)(
+            const uint16_t* depth,
+            const float* x,
+            const float* y,
+            const float* inverseRayLength,
+            size_t count,
+            const Coefficients& coefficients,
+            float* points);
+
+        size_t UnprojectRowScalar(
+            const uint16_t* depth,
+            const float* x,
+            const float* y,
+            const float* inverseRayLength,
+            size_t count,
+            const Coefficients& c,
+            float* points)
+        {
+            const float nan =
+                std::numeric_limits<float>::quiet_NaN();
+
+            size_t validPointCount = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const float d =
+                    static_cast<float>(depth[i]);
+
+                float* point =
+                    points + 3 * i;
+
+                // Also rejects the NaN pixels of the LUT.
+                if (!(d >= c.MinimumDepth && d <= c.MaximumDepth && x[i] == x[i]))
+                {
+                    point[0] = point[1] = point[2] = nan;
+
+                    continue;
+                }
+
+                float s = d * c.DepthScale;
+
+                if (nullptr != inverseRayLength)
+                {
+                    s *= inverseRayLength[i];
+                }
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    point[k] = s * (x[i] * c.Row0[k] + y[i] * c.Row1[k] + c.Row2[k]) + c.Row3[k];
+                }
+
+                ++validPointCount;
+            }
+
+            return validPointCount;
+        }
+
+#if IO_POINT_CLOUD_X86
+        bool DetectAvx2()
+        {
+#if defined(_MSC_VER)
+            int cpuInfo[4] = {};
+
+            __cpuid(cpuInfo, 0);
+
+            if (cpuInfo[0] < 7)
+            {
+                return false;
+            }
+
+            __cpuid(cpuInfo, 1);
+
+            //
+            // FMA, AVX and OSXSAVE, and the OS must preserve the YMM registers.
+            //
+            const int fmaAvxAndOsxsave = (1 << 28) | (1 << 27) | (1 << 12);
+
+            if (fmaAvxAndOsxsave != (cpuInfo[2] & fmaAvxAndOsxsave) ||
+                0x6 != (_xgetbv(0) & 0x6))
+            {
+                return false;
+            }
+
+            __cpuidex(cpuInfo, 7, 0);
+
+            return 0 != (cpuInfo[1] & (1 << 5));
+#else
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+        }
+
+        bool IsAvx2Supported()
+        {
+            static const bool isAvx2Supported =
+                DetectAvx2();
+
+            return isAvx2Supported;
+        }
+
+        //
+        // 8 pixels at a time. The three coordinate vectors are interleaved into
+        // three vectors of (x, y, z) triplets with in-lane shuffles, then across
+        // the lanes.
+        //
+        IO_POINT_CLOUD_TARGET_AVX2
+        size_t UnprojectRowAvx2(
+            const uint16_t* depth,
+            const float* x,
+            const float* y,
+            const float* inverseRayLength,
+            size_t count,
+            const Coefficients& c,
+            float* points)
+        {
+            const __m256 nan = _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN());
+            const __m256 depthScale = _mm256_set1_ps(c.DepthScale);
+            const __m256 minimumDepth = _mm256_set1_ps(c.MinimumDepth);
+            const __m256 maximumDepth = _mm256_set1_ps(c.MaximumDepth);
+
+            __m256 row0[3], row1[3], row2[3], row3[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                row0[k] = _mm256_set1_ps(c.Row0[k]);
+                row1[k] = _mm256_set1_ps(c.Row1[k]);
+                row2[k] = _mm256_set1_ps(c.Row2[k]);
+                row3[k] = _mm256_set1_ps(c.Row3[k]);
+            }
+
+            size_t validPointCount = 0;
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m256 d =
+                    _mm256_cvtepi32_ps(
+                        _mm256_cvtepu16_epi32(
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + i))));
+
+                const __m256 xi = _mm256_loadu_ps(x + i);
+                const __m256 yi = _mm256_loadu_ps(y + i);
+
+                const __m256 valid =
+                    _mm256_and_ps(
+                        _mm256_and_ps(
+                            _mm256_cmp_ps(d, minimumDepth, _CMP_GE_OQ),
+                            _mm256_cmp_ps(d, maximumDepth, _CMP_LE_OQ)),
+                        _mm256_cmp_ps(xi, xi, _CMP_ORD_Q));
+
+                __m256 s = _mm256_mul_ps(d, depthScale);
+
+                if (nullptr != inverseRayLength)
+                {
+                    s = _mm256_mul_ps(s, _mm256_loadu_ps(inverseRayLength + i));
+                }
+
+                __m256 coordinates[3];
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    const __m256 ray =
+                        _mm256_fmadd_ps(xi, row0[k], _mm256_fmadd_ps(yi, row1[k], row2[k]));
+
+                    coordinates[k] =
+                        _mm256_blendv_ps(nan, _mm256_fmadd_ps(s, ray, row3[k]), valid);
+                }
+
+                // x0 x2 y0 y2 | x4 x6 y4 y6, y1 y3 z1 z3 | ..., z0 z2 x1 x3 | ...
+                const __m256 xy = _mm256_shuffle_ps(coordinates[0], coordinates[1], _MM_SHUFFLE(2, 0, 2, 0));
+                const __m256 yz = _mm256_shuffle_ps(coordinates[1], coordinates[2], _MM_SHUFFLE(3, 1, 3, 1));
+                const __m256 zx = _mm256_shuffle_ps(coordinates[2], coordinates[0], _MM_SHUFFLE(3, 1, 2, 0));
+
+                // x0 y0 z0 x1 | x4 y4 z4 x5, y1 z1 x2 y2 | ..., z2 x3 y3 z3 | ...
+                const __m256 points03 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+                const __m256 points14 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+                const __m256 points25 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+
+                float* point = points + 3 * i;
+
+                _mm256_storeu_ps(point, _mm256_permute2f128_ps(points03, points14, 0x20));
+                _mm256_storeu_ps(point + 8, _mm256_permute2f128_ps(points25, points03, 0x30));
+                _mm256_storeu_ps(point + 16, _mm256_permute2f128_ps(points14, points25, 0x31));
+
+                for (int mask = _mm256_movemask_ps(valid); 0 != mask; mask &= mask - 1)
+                {
+                    ++validPointCount;
+                }
+            }
+
+            return validPointCount + UnprojectRowScalar(
+                depth + i,
+                x + i,
+                y + i,
+                nullptr != inverseRayLength ? inverseRayLength + i : nullptr,
+                count - i,
+                c,
+                points + 3 * i);
+        }
+#endif /* IO_POINT_CLOUD_X86 */
+
+#if IO_POINT_CLOUD_NEON
+        //
+        // 4 pixels at a time, interleaved by the structure store.
+        //
+        size_t UnprojectRowNeon(
+            const uint16_t* depth,
+            const float* x,
+            const float* y,
+            const float* inverseRayLength,
+            size_t count,
+            const Coefficients& c,
+            float* points)
+        {
+            const float32x4_t nan = vdupq_n_f32(std::numeric_limits<float>::quiet_NaN());
+            const float32x4_t minimumDepth = vdupq_n_f32(c.MinimumDepth);
+            const float32x4_t maximumDepth = vdupq_n_f32(c.MaximumDepth);
+
+            float32x4_t row0[3], row1[3], row2[3], row3[3];
+
+            for (int k = 0; k < 3; ++k)
+            {
+                row0[k] = vdupq_n_f32(c.Row0[k]);
+                row1[k] = vdupq_n_f32(c.Row1[k]);
+                row2[k] = vdupq_n_f32(c.Row2[k]);
+                row3[k] = vdupq_n_f32(c.Row3[k]);
+            }
+
+            size_t validPointCount = 0;
+            size_t i = 0;
+
+            for (; i + 4 <= count; i += 4)
+            {
+                const float32x4_t d =
+                    vcvtq_f32_u32(
+                        vmovl_u16(
+                            vld1_u16(depth + i)));
+
+                const float32x4_t xi = vld1q_f32(x + i);
+                const float32x4_t yi = vld1q_f32(y + i);
+
+                const uint32x4_t valid =
+                    vandq_u32(
+                        vandq_u32(
+                            vcgeq_f32(d, minimumDepth),
+                            vcleq_f32(d, maximumDepth)),
+                        vceqq_f32(xi, xi));
+
+                float32x4_t s = vmulq_n_f32(d, c.DepthScale);
+
+                if (nullptr != inverseRayLength)
+                {
+                    s = vmulq_f32(s, vld1q_f32(inverseRayLength + i));
+                }
+
+                float32x4x3_t coordinates;
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    const float32x4_t ray =
+                        vfmaq_f32(vfmaq_f32(row2[k], yi, row1[k]), xi, row0[k]);
+
+                    coordinates.val[k] =
+                        vbslq_f32(valid, vfmaq_f32(row3[k], s, ray), nan);
+                }
+
+                vst3q_f32(points + 3 * i, coordinates);
+
+                validPointCount += vaddvq_u32(vshrq_n_u32(valid, 31));
+            }
+
+            return validPointCount + UnprojectRowScalar(
+                depth + i,
+                x + i,
+                y + i,
+                nullptr != inverseRayLength ? inverseRayLength + i : nullptr,
+                count - i,
+                c,
+                points + 3 * i);
+        }
+#endif /* IO_POINT_CLOUD_NEON */
+    }
+
+    PointCloudIsa GetPointCloudIsa()
+    {
+#if IO_POINT_CLOUD_X86
+        if (IsAvx2Supported())
+        {
+            return PointCloudIsa::Avx2;
+        }
+#elif IO_POINT_CLOUD_NEON
+        return PointCloudIsa::Neon;
+#endif
+
+        return PointCloudIsa::Scalar;
+    }
+
+    bool IsPointCloudIsaSupported(
+        _In_ const PointCloudIsa isa)
+    {
+        switch (isa)
+        {
+        case PointCloudIsa::Scalar:
+            return true;
+
+#if IO_POINT_CLOUD_X86
+        case PointCloudIsa::Avx2:
+            return IsAvx2Supported();
+#endif
+
+#if IO_POINT_CLOUD_NEON
+        case PointCloudIsa::Neon:
+            return true;
+#endif
+
+        default:
+            return false;
+        }
+    }
+
+    const char* GetPointCloudIsaName(
+        _In_ const PointCloudIsa isa)
+    {
+        switch (isa)
+        {
+        case PointCloudIsa::Scalar:
+            return "scalar";
+
+        case PointCloudIsa::Avx2:
+            return "AVX2";
+
+        case PointCloudIsa::Neon:
+            return "NEON";
+
+        default:
+            return "unknown";
+        }
+    }
+
+    void InvertRigidTransform(
+        _In_reads_(16) const float* transform,
+        _Out_writes_(16) float* inverse)
+    {
+        //
+        // The transform maps a row vector p to p * R + t; its inverse maps it
+        // to (p - t) * R^T.
+        //
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                inverse[4 * row + column] = transform[4 * column + row];
+            }
+
+            inverse[4 * row + 3] = 0.0f;
+        }
+
+        for (int column = 0; column < 3; ++column)
+        {
+            float translation = 0.0f;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                translation -= transform[12 + k] * transform[4 * column + k];
+            }
+
+            inverse[12 + column] = translation;
+        }
+
+        inverse[15] = 1.0f;
+    }
+
+    void ComputeCameraToOrigin(
+        _In_reads_(16) const float* frameToOrigin,
+        _In_reads_(16) const float* cameraViewTransform,
+        _Out_writes_(16) float* cameraToOrigin)
+    {
+        float viewToCamera[16];
+
+        InvertRigidTransform(
+            cameraViewTransform,
+            viewToCamera);
+
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                float value = 0.0f;
+
+                for (int k = 0; k < 4; ++k)
+                {
+                    value += viewToCamera[4 * row + k] * frameToOrigin[4 * k + column];
+                }
+
+                cameraToOrigin[4 * row + column] = value;
+            }
+        }
+    }
+
+    size_t UnprojectDepth(
+        _In_ const UnprojectionLut& lut,
+        _In_ const uint16_t* depth,
+        _In_ const size_t depthRowStride,
+        _In_reads_(16) const float* cameraToOrigin,
+        _In_ const DepthUnprojectionOptions& options,
+        _Out_writes_(3 * lut.GetImageWidth() * lut.GetImageHeight()) float* points)
+    {
+        return UnprojectDepth(
+            GetPointCloudIsa(),
+            lut,
+            depth,
+            depthRowStride,
+            cameraToOrigin,
+            options,
+            points);
+    }
+
+    size_t UnprojectDepth(
+        _In_ const PointCloudIsa isa,
+        _In_ const UnprojectionLut& lut,
+        _In_ const uint16_t* depth,
+        _In_ const size_t depthRowStride,
+        _In_reads_(16) const float* cameraToOrigin,
+        _In_ const DepthUnprojectionOptions& options,
+        _Out_writes_(3 * lut.GetImageWidth() * lut.GetImageHeight()) float* points)
+    {
+        REQUIRES(IsPointCloudIsaSupported(isa));
+
+        UnprojectRowFunction unprojectRow =
+            UnprojectRowScalar;
+
+#if IO_POINT_CLOUD_X86
+        if (PointCloudIsa::Avx2 == isa)
+        {
+            unprojectRow = UnprojectRowAvx2;
+        }
+#elif IO_POINT_CLOUD_NEON
+        if (PointCloudIsa::Neon == isa)
+        {
+            unprojectRow = UnprojectRowNeon;
+        }
+#endif
+
+        Coefficients coefficients;
+
+        coefficients.DepthScale = options.DepthScale;
+        coefficients.MinimumDepth = options.MinimumDepth;
+        coefficients.MaximumDepth = options.MaximumDepth;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            coefficients.Row0[k] = cameraToOrigin[k];
+            coefficients.Row1[k] = cameraToOrigin[4 + k];
+            coefficients.Row2[k] = cameraToOrigin[8 + k];
+            coefficients.Row3[k] = cameraToOrigin[12 + k];
+        }
+
+        const size_t imageWidth = lut.GetImageWidth();
+        const uint8_t* depthRow = reinterpret_cast<const uint8_t*>(depth);
+        size_t validPointCount = 0;
+
+        for (size_t v = 0; v < lut.GetImageHeight(); ++v)
+        {
+            const size_t index =
+                v * imageWidth;
+
+            validPointCount += unprojectRow(
+                reinterpret_cast<const uint16_t*>(depthRow + v * depthRowStride),
+                lut.GetX() + index,
+                lut.GetY() + index,
+                options.DepthIsRadial ? lut.GetInverseRayLength() + index : nullptr,
+                imageWidth,
+                coefficients,
+                points + 3 * index);
+        }
+
+        return validPointCount;
+    }
+}
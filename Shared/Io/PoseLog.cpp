@@ -0,0 +1,189 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+#include "pch.h"
+
+namespace Io
+{
+    PoseLogWriter::PoseLogWriter(
+        _In_ const std::wstring& poseLogFileName)
+        : _poseLogFile(INVALID_HANDLE_VALUE)
+    {
+        static_assert(
+            16 == sizeof(PoseLogHeader),
+            "Size of the PoseLogHeader structure must be equal to 16 bytes.");
+
+        static_assert(
+            200 == sizeof(PoseLogRecord),
+            "Size of the PoseLogRecord structure must be equal to 200 bytes.");
+
+        _poseLogFile = CreateFile2(
+            poseLogFileName.c_str(),
+            GENERIC_WRITE /* dwDesiredAccess */,
+            FILE_SHARE_READ /* dwShareMode */,
+            CREATE_ALWAYS /* dwCreationDisposition */,
+            nullptr /* pCreateExParams */);
+
+        ASSERT(INVALID_HANDLE_VALUE != _poseLogFile);
+
+        PoseLogHeader header = {};
+
+        header.Cookie = PoseLogCookie;
+        header.VersionMajor = PoseLogVersionMajor;
+        header.VersionMinor = PoseLogVersionMinor;
+        header.RecordSize = sizeof(PoseLogRecord);
+
+        Write(&header, sizeof(header));
+    }
+
+    PoseLogWriter::~PoseLogWriter()
+    {
+        //
+        // Destructors must not throw: errors are only reported by Close.
+        //
+        if (INVALID_HANDLE_VALUE != _poseLogFile)
+        {
+            CloseHandle(_poseLogFile);
+        }
+    }
+
+    void PoseLogWriter::Close()
+    {
+        if (INVALID_HANDLE_VALUE != _poseLogFile)
+        {
+            const HANDLE poseLogFile = _poseLogFile;
+            _poseLogFile = INVALID_HANDLE_VALUE;
+
+            ASSERT(!!CloseHandle(poseLogFile));
+        }
+    }
+
+    void PoseLogWriter::AddRecord(
+        _In_ const PoseLogRecord& record)
+    {
+        Write(&record, sizeof(record));
+    }
+
+    void PoseLogWriter::Write(
+        _In_reads_(size) const void* data,
+        _In_ const size_t size)
+    {
+        ASSERT(INVALID_HANDLE_VALUE != _poseLogFile);
+
+        DWORD numberOfBytesWritten = 0;
+
+        ASSERT(!!WriteFile(
+            _poseLogFile,
+            data,
+            static_cast<DWORD>(size),
+            &numberOfBytesWritten,
+            nullptr /* lpOverlapped */));
+
+        ASSERT(size == numberOfBytesWritten);
+    }
+
+    PoseLogReader::PoseLogReader(
+        _In_ const std::wstring& poseLogFileName)
+        : _poseLog(poseLogFileName)
+        , _records(nullptr)
+        , _numberOfRecords(0)
+        , _isSortedByTime(true)
+    {
+        ReadHeader();
+    }
+
+    PoseLogReader::PoseLogReader(
+        _In_ Windows::Storage::StorageFolder^ folder,
+        _In_ const std::wstring& poseLogFileName)
+        : _poseLog(folder, poseLogFileName)
+        , _records(nullptr)
+        , _numberOfRecords(0)
+        , _isSortedByTime(true)
+    {
+        ReadHeader();
+    }
+
+    void PoseLogReader::ReadHeader()
+    {
+        REQUIRES(_poseLog.GetSize() >= sizeof(PoseLogHeader));
+
+        const PoseLogHeader* header =
+            reinterpret_cast<const PoseLogHeader*>(
+                _poseLog.GetData());
+
+        REQUIRES(PoseLogCookie == header->Cookie);
+        REQUIRES(PoseLogVersionMajor == header->VersionMajor);
+        REQUIRES(sizeof(PoseLogRecord) == header->RecordSize);
+
+        _records =
+            reinterpret_cast<const PoseLogRecord*>(
+                _poseLog.GetData() + sizeof(PoseLogHeader));
+
+        //
+        // Ignore a partially written trailing record.
+        //
+        _numberOfRecords =
+            (_poseLog.GetSize() - sizeof(PoseLogHeader)) / sizeof(PoseLogRecord);
+
+        for (size_t i = 1; i < _numberOfRecords && _isSortedByTime; ++i)
+        {
+            _isSortedByTime =
+                _records[i - 1].Timestamp <= _records[i].Timestamp;
+        }
+    }
+
+    const PoseLogRecord& PoseLogReader::GetRecord(
+        _In_ const size_t ordinal) const
+    {
+        REQUIRES(ordinal < _numberOfRecords);
+
+        return _records[ordinal];
+    }
+
+    const PoseLogRecord* PoseLogReader::FindRecord(
+        _In_ const uint64_t timestamp) const
+    {
+        const PoseLogRecord* last =
+            _records + _numberOfRecords;
+
+        const PoseLogRecord* record = nullptr;
+
+        if (_isSortedByTime)
+        {
+            record = std::lower_bound(
+                _records,
+                last,
+                timestamp,
+                [](const PoseLogRecord& r, uint64_t t)
+            {
+                return r.Timestamp < t;
+            });
+        }
+        else
+        {
+            record = std::find_if(
+                _records,
+                last,
+                [timestamp](const PoseLogRecord& r)
+            {
+                return r.Timestamp == timestamp;
+            });
+        }
+
+        if (record == last || record->Timestamp != timestamp)
+        {
+            return nullptr;
+        }
+
+        return record;
+    }
+}
@@ -0,0 +1,242 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Built without the precompiled header; see PseudoColorTable.
+//
+#include <Io/PseudoColor.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define IO_PSEUDO_COLOR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define IO_PSEUDO_COLOR_TARGET_AVX2
+#else
+#define IO_PSEUDO_COLOR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace Io
+{
+    namespace
+    {
+        template <typename TValue>
+        void ApplyScalar(
+            const uint32_t* colors,
+            const uint32_t lastIndex,
+            const TValue* values,
+            const size_t numberOfPixels,
+            uint32_t* bgraPixels)
+        {
+            for (size_t i = 0; i < numberOfPixels; ++i)
+            {
+                const uint32_t value = values[i];
+
+                bgraPixels[i] = colors[(value < lastIndex) ? value : lastIndex];
+            }
+        }
+
+#if IO_PSEUDO_COLOR_X86
+        IO_PSEUDO_COLOR_TARGET_AVX2
+        __m256i LoadIndicesAvx2(
+            const uint8_t* values)
+        {
+            return _mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values)));
+        }
+
+        IO_PSEUDO_COLOR_TARGET_AVX2
+        __m256i LoadIndicesAvx2(
+            const uint16_t* values)
+        {
+            return _mm256_cvtepu16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(values)));
+        }
+
+        //
+        // Sixteen pixels per iteration, in two independent gathers of eight
+        // colours each.
+        //
+        template <typename TValue>
+        IO_PSEUDO_COLOR_TARGET_AVX2
+        void ApplyAvx2(
+            const uint32_t* colors,
+            const uint32_t lastIndex,
+            const TValue* values,
+            const size_t numberOfPixels,
+            uint32_t* bgraPixels)
+        {
+            const __m256i last =
+                _mm256_set1_epi32(static_cast<int>(lastIndex));
+
+            const int* table =
+                reinterpret_cast<const int*>(colors);
+
+            size_t i = 0;
+
+            for (; i + 16 <= numberOfPixels; i += 16)
+            {
+                const __m256i low =
+                    _mm256_min_epu32(LoadIndicesAvx2(values + i), last);
+
+                const __m256i high =
+                    _mm256_min_epu32(LoadIndicesAvx2(values + i + 8), last);
+
+                __m256i* destination =
+                    reinterpret_cast<__m256i*>(bgraPixels + i);
+
+                _mm256_storeu_si256(
+                    destination,
+                    _mm256_i32gather_epi32(table, low, 4));
+
+                _mm256_storeu_si256(
+                    destination + 1,
+                    _mm256_i32gather_epi32(table, high, 4));
+            }
+
+            ApplyScalar(
+                colors,
+                lastIndex,
+                values + i,
+                numberOfPixels - i,
+                bgraPixels + i);
+        }
+
+        bool IsAvx2Supported()
+        {
+#if defined(_MSC_VER)
+            int cpuInfo[4] = {};
+
+            __cpuid(cpuInfo, 0);
+
+            if (cpuInfo[0] < 7)
+            {
+                return false;
+            }
+
+            __cpuid(cpuInfo, 1);
+
+            //
+            // AVX and OSXSAVE, and the OS must preserve the YMM registers.
+            //
+            const int avxAndOsxsave = (1 << 28) | (1 << 27);
+
+            if (avxAndOsxsave != (cpuInfo[2] & avxAndOsxsave) ||
+                0x6 != (_xgetbv(0) & 0x6))
+            {
+                return false;
+            }
+
+            __cpuidex(cpuInfo, 7, 0);
+
+            return 0 != (cpuInfo[1] & (1 << 5));
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif /* IO_PSEUDO_COLOR_X86 */
+
+        PseudoColorIsa DetectPseudoColorIsa()
+        {
+#if IO_PSEUDO_COLOR_X86
+            if (IsAvx2Supported())
+            {
+                return PseudoColorIsa::Avx2;
+            }
+#endif
+
+            return PseudoColorIsa::Scalar;
+        }
+    }
+
+    PseudoColorIsa GetPseudoColorIsa()
+    {
+        static const PseudoColorIsa isa =
+            DetectPseudoColorIsa();
+
+        return isa;
+    }
+
+    template <typename TValue>
+    void PseudoColorTable<TValue>::Apply(
+        const TValue* values,
+        const size_t numberOfPixels,
+        uint32_t* bgraPixels) const
+    {
+        Apply(
+            GetPseudoColorIsa(),
+            values,
+            numberOfPixels,
+            bgraPixels);
+    }
+
+    template <typename TValue>
+    void PseudoColorTable<TValue>::Apply(
+        const PseudoColorIsa isa,
+        const TValue* values,
+        const size_t numberOfPixels,
+        uint32_t* bgraPixels) const
+    {
+        switch (isa)
+        {
+#if IO_PSEUDO_COLOR_X86
+        case PseudoColorIsa::Avx2:
+            ApplyAvx2(
+                _colors.data(),
+                _lastIndex,
+                values,
+                numberOfPixels,
+                bgraPixels);
+            break;
+#endif /* IO_PSEUDO_COLOR_X86 */
+
+        case PseudoColorIsa::Scalar:
+            ApplyScalar(
+                _colors.data(),
+                _lastIndex,
+                values,
+                numberOfPixels,
+                bgraPixels);
+            break;
+
+        default:
+            assert(false);
+        }
+    }
+
+    template <typename TValue>
+    void PseudoColorTable<TValue>::Apply(
+        const uint8_t* image,
+        const size_t stride,
+        const uint32_t width,
+        const uint32_t height,
+        uint8_t* bgraImage,
+        const size_t bgraStride) const
+    {
+        const PseudoColorIsa isa =
+            GetPseudoColorIsa();
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            Apply(
+                isa,
+                reinterpret_cast<const TValue*>(image + y * stride),
+                width,
+                reinterpret_cast<uint32_t*>(bgraImage + y * bgraStride));
+        }
+    }
+
+    template class PseudoColorTable<uint8_t>;
+    template class PseudoColorTable<uint16_t>;
+}
@@ -0,0 +1,100 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see StreamScheduler.
+//
+#include <Io/StreamScheduler.h>
+
+#include <algorithm>
+
+namespace Io
+{
+    StreamScheduler::StreamScheduler(
+        _In_ const size_t streamCount)
+        : _virtualTime(0.0)
+    {
+        REQUIRES(streamCount > 0);
+
+        Stream stream;
+
+        stream.Weight = 1;
+        stream.FinishTag = 0.0;
+
+        _streams.resize(
+            streamCount,
+            stream);
+    }
+
+    void StreamScheduler::SetWeight(
+        _In_ const size_t stream,
+        _In_ const uint32_t weight)
+    {
+        REQUIRES(stream < _streams.size() && weight > 0);
+
+        _streams[stream].Weight = weight;
+    }
+
+    uint32_t StreamScheduler::GetWeight(
+        _In_ const size_t stream) const
+    {
+        REQUIRES(stream < _streams.size());
+
+        return _streams[stream].Weight;
+    }
+
+    void StreamScheduler::GetServiceOrder(
+        _Inout_ std::vector<size_t>& streams) const
+    {
+        streams.resize(
+            _streams.size());
+
+        for (size_t i = 0; i < streams.size(); ++i)
+        {
+            streams[i] = i;
+        }
+
+        //
+        // Ties go to the stream with the lower index.
+        //
+        std::stable_sort(
+            streams.begin(),
+            streams.end(),
+            [this](const size_t a, const size_t b)
+        {
+            return GetStartTag(a) < GetStartTag(b);
+        });
+    }
+
+    void StreamScheduler::Charge(
+        _In_ const size_t stream,
+        _In_ const size_t sizeInBytes)
+    {
+        REQUIRES(stream < _streams.size());
+
+        const double startTag =
+            GetStartTag(stream);
+
+        _virtualTime = startTag;
+
+        _streams[stream].FinishTag =
+            startTag + static_cast<double>(sizeInBytes) / _streams[stream].Weight;
+    }
+
+    double StreamScheduler::GetStartTag(
+        _In_ const size_t stream) const
+    {
+        return std::max<double>(
+            _streams[stream].FinishTag,
+            _virtualTime);
+    }
+}
@@ -13,143 +13,6 @@
 
 namespace Io
 {
-    //
-    // TAR (Tape Archive) header.
-    //
-    // See https://en.wikipedia.org/wiki/Tar_(computing) for details.
-    //
-#pragma pack (push, 1)
-    struct TarHeader
-    {
-        TarHeader()
-            : FileName()
-            , FileMode()
-            , OwnerId()
-            , GroupId()
-            , FileSize()
-            , LastModificationTime()
-            , Checksum()
-            , Type('0' /* Normal file */)
-            , LinkedFileName()
-            , UStarIndicator()
-            , UStarVersion()
-            , OwnerUserName()
-            , OwnerGroupName()
-            , DeviceMajorNumber()
-            , DeviceMinorNumber()
-            , FileNamePrefix()
-            , Padding()
-        {
-            //
-            // S_IFREG: regular file.
-            //
-            FileMode[0] = '0'; FileMode[1] = '1'; FileMode[2] = '0'; FileMode[3] = '0';
-
-            //
-            // S_IRWXU+S_IRWXG+S_IRWXO: User/Group/Other can Read/Write/Execute.
-            //
-            FileMode[4] = '7'; FileMode[5] = '7'; FileMode[6] = '7'; FileMode[7] = '\0';
-
-            //
-            // Ignore group and owner ids.
-            //
-            for (int32_t i = 0; i < 7; ++i)
-            {
-                OwnerId[i] = '0';
-                GroupId[i] = '0';
-            }
-
-            //
-            // Note that the Checksum field needs to be set to space characters before
-            // we calculate the final checksum of the header.
-            //
-            for (int32_t i = 0; i < 7; ++i)
-            {
-                Checksum[i] = ' ';
-            }
-
-            ChecksumSpace = ' ';
-
-            //
-            // UStar magic number and version.
-            //
-            UStarIndicator[0] = 'u'; UStarIndicator[1] = 's'; UStarIndicator[2] = 't';
-            UStarIndicator[3] = 'a'; UStarIndicator[4] = 'r'; UStarIndicator[5] = '\0';
-
-            UStarVersion[0] = '0'; UStarVersion[1] = '0';
-        }
-
-        char FileName[100];                 // 0
-        char FileMode[8];                   // 100
-        char OwnerId[8];                    // 108
-        char GroupId[8];                    // 116
-        char FileSize[12];                  // 124
-        char LastModificationTime[12];      // 136
-        char Checksum[7];                   // 148
-        char ChecksumSpace;                 // 155
-        char Type;                          // 156
-        char LinkedFileName[100];           // 157
-        char UStarIndicator[6];             // 257
-        char UStarVersion[2];               // 263
-        char OwnerUserName[32];             // 265
-        char OwnerGroupName[32];            // 297
-        char DeviceMajorNumber[8];          // 329
-        char DeviceMinorNumber[8];          // 337
-        char FileNamePrefix[155];           // 345
-        char Padding[12];                   // 500
-                                            // 512
-    };
-#pragma pack (pop)
-
-    template <size_t N>
-    void CopyStringToTarHeader(
-        _In_ const std::string& input,
-        _Out_ char output[N])
-    {
-        ASSERT(input.size() < N);
-
-        for (size_t i = 0; i < input.size(); ++i)
-        {
-            output[i] = input[i];
-        }
-
-        for (size_t i = input.size(); i < N; ++i)
-        {
-            output[i] = '\0';
-        }
-    }
-
-    template <size_t N>
-    void CopyUInt64ToTarHeaderAsOctets(
-        _In_ const uint64_t input,
-        _Out_ char output[N])
-    {
-        size_t numberOfOctets = 0;
-
-        if (input > 0)
-        {
-            char buffer[32] = {};
-
-            numberOfOctets = sprintf_s(
-                buffer,
-                "%0*llo",
-                static_cast<int>(N - 1),
-                input);
-
-            ASSERT(numberOfOctets <= N - 1);
-
-            for (size_t i = 0; i < numberOfOctets; ++i)
-            {
-                output[i] = buffer[i];
-            }
-        }
-
-        for (size_t i = numberOfOctets; i < N; ++i)
-        {
-            output[i] = '\0';
-        }
-    }
-
     void CreateTarball(
         _In_ Windows::Storage::StorageFolder^ sourceFolder,
         _In_ const std::vector<std::wstring>& sourceFileNames,
@@ -225,40 +88,18 @@ namespace Io
 
             ASSERT(sourceFileBuffer.size() == numberOfBytesRead);
 
-            TarHeader header;
-
-            static_assert(
-                512 == sizeof(TarHeader),
-                "Size of the TarHeader structure must be equal to 512 bytes.");
+            uint8_t header[TarBlockSize];
 
-            CopyStringToTarHeader<100>(
+            FormatTarHeader(
                 Utf16ToUtf8(sourceFileName),
-                header.FileName);
-
-            CopyUInt64ToTarHeaderAsOctets<12>(
-                static_cast<size_t>(fileSize.QuadPart),
-                header.FileSize);
-
-            CopyUInt64ToTarHeaderAsOctets<12>(
+                static_cast<uint64_t>(fileSize.QuadPart),
                 std::chrono::duration_cast<std::chrono::seconds>(
                     UniversalToUnixTime(lastWriteTime)).count(),
-                header.LastModificationTime);
-
-            uint64_t checksum = 0;
-
-            for (size_t i = 0; i < sizeof(header); ++i)
-            {
-                checksum +=
-                    reinterpret_cast<uint8_t*>(&header)[i];
-            }
-
-            CopyUInt64ToTarHeaderAsOctets<7>(
-                checksum,
-                header.Checksum);
+                header);
 
             ASSERT(!!WriteFile(
                 output,
-                &header,
+                header,
                 sizeof(header),
                 &numberOfBytesWritten,
                 nullptr /* lpOverlapped */));
@@ -317,73 +158,548 @@ namespace Io
             output));
     }
 
-	Tarball::Tarball(_In_ const std::wstring& tarballFileName) {
-		_tarballFile.open(tarballFileName, std::ios::binary);
-		ASSERT(_tarballFile.is_open());
+	Tarball::Tarball(_In_ const std::wstring& tarballFileName)
+		: _tarballFile(INVALID_HANDLE_VALUE)
+		, _archive([this](const uint8_t* data, size_t size) { WriteToFile(data, size); })
+	{
+		_tarballFile = CreateFile2(
+			tarballFileName.c_str(),
+			GENERIC_WRITE /* dwDesiredAccess */,
+			0 /* dwShareMode */,
+			CREATE_ALWAYS /* dwCreationDisposition */,
+			nullptr /* pCreateExParams */);
+
+		ASSERT(INVALID_HANDLE_VALUE != _tarballFile);
 	}
 
 	Tarball::~Tarball() {
-		Close();
+		if (INVALID_HANDLE_VALUE == _tarballFile) {
+			return;
+		}
+
+		// Best effort only: destructors must not throw, so a tarball that was
+		// not closed explicitly may be left without its end of archive blocks.
+		try {
+			Close();
+		}
+		catch (const std::exception&) {
+		}
+
+		if (INVALID_HANDLE_VALUE != _tarballFile) {
+			CloseHandle(_tarballFile);
+			_tarballFile = INVALID_HANDLE_VALUE;
+		}
 	}
 
 	void Tarball::Close() {
-		if (_tarballFile.is_open()) {
-			// The tarball always ends with two 512 byte blocks of zeros.
-			std::vector<char> alignmentData(512, 0);
-			_tarballFile.write(alignmentData.data(), alignmentData.size());
-			_tarballFile.write(alignmentData.data(), alignmentData.size());
-			_tarballFile.close();
+		if (INVALID_HANDLE_VALUE != _tarballFile) {
+			_archive.Finish();
+
+			const HANDLE tarballFile = _tarballFile;
+			_tarballFile = INVALID_HANDLE_VALUE;
+
+			ASSERT(!!CloseHandle(tarballFile));
 		}
 	}
 
-	void Tarball::AddFile(
+	uint64_t Tarball::AddFile(
 		_In_ const std::wstring& fileName,
 		_In_ const uint8_t* fileData,
 		_In_ const size_t fileSize) {
 
-		ASSERT(_tarballFile.is_open());
+		const TarballFileSpan fileSpan = { fileData, fileSize };
 
-		static_assert(
-			sizeof(TarHeader) == 512,
-			"Size of the TarHeader structure must be equal to 512 bytes.");
+		return AddFile(fileName, &fileSpan, 1);
+	}
 
-		// Construct the file header.
+	uint64_t Tarball::AddFile(
+		_In_ const std::wstring& fileName,
+		_In_reads_(numberOfFileSpans) const TarballFileSpan* fileSpans,
+		_In_ const size_t numberOfFileSpans) {
 
-		TarHeader header;
+		ASSERT(INVALID_HANDLE_VALUE != _tarballFile);
 
-		CopyStringToTarHeader<100>(Utf16ToUtf8(fileName), header.FileName);
-		CopyUInt64ToTarHeaderAsOctets<12>(fileSize, header.FileSize);
-		CopyUInt64ToTarHeaderAsOctets<12>(
+		return _archive.AddFile(
+			Utf16ToUtf8(fileName),
+			fileSpans,
+			numberOfFileSpans,
 			std::chrono::duration_cast<std::chrono::seconds>(
-				std::chrono::system_clock::now().time_since_epoch()).count(),
-			header.LastModificationTime);
+				std::chrono::system_clock::now().time_since_epoch()).count());
+	}
 
-		uint64_t headerChecksum = 0;
-		for (size_t i = 0; i < sizeof(header); ++i)
-		{
-			headerChecksum += reinterpret_cast<uint8_t*>(&header)[i];
-		}
+	void Tarball::WriteToFile(
+		_In_reads_(size) const uint8_t* data,
+		_In_ size_t size) {
 
-		CopyUInt64ToTarHeaderAsOctets<7>(headerChecksum, header.Checksum);
+		while (size > 0)
+		{
+			const DWORD numberOfBytesToWrite =
+				static_cast<DWORD>(std::min<size_t>(size, MAXDWORD));
 
-		// Write the header and the data to the tarball.
+			DWORD numberOfBytesWritten = 0;
 
-		_tarballFile.write(
-			reinterpret_cast<const char*>(&header), sizeof(header));
-		_tarballFile.write(
-			reinterpret_cast<const char*>(fileData), fileSize);
-		
-		// Make sure the file is aligned to 512 byes, otherwise
-		// pad the file with zeros.
+			ASSERT(!!WriteFile(
+				_tarballFile,
+				data,
+				numberOfBytesToWrite,
+				&numberOfBytesWritten,
+				nullptr /* lpOverlapped */));
 
-		const size_t lastBlockSize = fileSize % 512;
-		if (lastBlockSize != 0)
-		{
-			const size_t lastBlockPadding = 512 - lastBlockSize;
-			ASSERT(lastBlockPadding < 512);
+			ASSERT(numberOfBytesToWrite == numberOfBytesWritten);
 
-			_tarballFile.write(
-				std::vector<char>(lastBlockPadding, 0).data(), lastBlockPadding);
+			data += numberOfBytesWritten;
+			size -= numberOfBytesWritten;
 		}
 	}
+
+    TarIndexWriter::TarIndexWriter(
+        _In_ const std::wstring& indexFileName)
+        : _indexFile(INVALID_HANDLE_VALUE)
+    {
+        static_assert(
+            16 == sizeof(TarIndexHeader),
+            "Size of the TarIndexHeader structure must be equal to 16 bytes.");
+
+        static_assert(
+            48 == sizeof(TarIndexRecord),
+            "Size of the TarIndexRecord structure must be equal to 48 bytes.");
+
+        _indexFile = CreateFile2(
+            indexFileName.c_str(),
+            GENERIC_WRITE /* dwDesiredAccess */,
+            FILE_SHARE_READ /* dwShareMode */,
+            CREATE_ALWAYS /* dwCreationDisposition */,
+            nullptr /* pCreateExParams */);
+
+        ASSERT(INVALID_HANDLE_VALUE != _indexFile);
+
+        TarIndexHeader header = {};
+
+        header.Cookie = TarIndexCookie;
+        header.VersionMajor = TarIndexVersionMajor;
+        header.VersionMinor = TarIndexVersionMinor;
+        header.RecordSize = sizeof(TarIndexRecord);
+
+        Write(&header, sizeof(header));
+    }
+
+    TarIndexWriter::~TarIndexWriter()
+    {
+        //
+        // Destructors must not throw: errors are only reported by Close.
+        //
+        if (INVALID_HANDLE_VALUE != _indexFile)
+        {
+            CloseHandle(_indexFile);
+        }
+    }
+
+    void TarIndexWriter::Close()
+    {
+        if (INVALID_HANDLE_VALUE != _indexFile)
+        {
+            const HANDLE indexFile = _indexFile;
+            _indexFile = INVALID_HANDLE_VALUE;
+
+            ASSERT(!!CloseHandle(indexFile));
+        }
+    }
+
+    void TarIndexWriter::AddRecord(
+        _In_ const TarIndexRecord& record)
+    {
+        //
+        // Records are written one at a time so that the index never gets
+        // ahead of the tarball if the recording is interrupted.
+        //
+        Write(&record, sizeof(record));
+    }
+
+    void TarIndexWriter::Write(
+        _In_reads_(size) const void* data,
+        _In_ const size_t size)
+    {
+        ASSERT(INVALID_HANDLE_VALUE != _indexFile);
+
+        DWORD numberOfBytesWritten = 0;
+
+        ASSERT(!!WriteFile(
+            _indexFile,
+            data,
+            static_cast<DWORD>(size),
+            &numberOfBytesWritten,
+            nullptr /* lpOverlapped */));
+
+        ASSERT(size == numberOfBytesWritten);
+    }
+
+    TarEntryView::TarEntryView()
+        : _mappedView(nullptr)
+        , _data(nullptr)
+        , _size(0)
+    {
+    }
+
+    TarEntryView::TarEntryView(TarEntryView&& other)
+        : _mappedView(other._mappedView)
+        , _data(other._data)
+        , _size(other._size)
+    {
+        other._mappedView = nullptr;
+        other._data = nullptr;
+        other._size = 0;
+    }
+
+    TarEntryView::~TarEntryView()
+    {
+        Reset();
+    }
+
+    TarEntryView& TarEntryView::operator=(TarEntryView&& other)
+    {
+        if (this != &other)
+        {
+            Reset();
+
+            _mappedView = other._mappedView;
+            _data = other._data;
+            _size = other._size;
+
+            other._mappedView = nullptr;
+            other._data = nullptr;
+            other._size = 0;
+        }
+
+        return *this;
+    }
+
+    void TarEntryView::Reset()
+    {
+        if (nullptr != _mappedView)
+        {
+            UnmapViewOfFile(
+                _mappedView);
+        }
+
+        _mappedView = nullptr;
+        _data = nullptr;
+        _size = 0;
+    }
+
+    TarReader::TarReader(
+        _In_ const std::wstring& tarballFileName)
+        : _file(INVALID_HANDLE_VALUE)
+        , _mapping(nullptr)
+        , _allocationGranularity(0)
+    {
+        HANDLE file = CreateFile2(
+            tarballFileName.c_str(),
+            GENERIC_READ /* dwDesiredAccess */,
+            FILE_SHARE_READ /* dwShareMode */,
+            OPEN_EXISTING /* dwCreationDisposition */,
+            nullptr /* pCreateExParams */);
+
+        ASSERT(INVALID_HANDLE_VALUE != file);
+
+        Open(file);
+    }
+
+    TarReader::TarReader(
+        _In_ Windows::Storage::StorageFolder^ folder,
+        _In_ const std::wstring& tarballFileName)
+        : _file(INVALID_HANDLE_VALUE)
+        , _mapping(nullptr)
+        , _allocationGranularity(0)
+    {
+        Microsoft::WRL::ComPtr<IStorageFolderHandleAccess> folderHandleAccess =
+            GetStorageFolderHandleAccess(
+                folder);
+
+        HANDLE file = nullptr;
+
+        ASSERT_SUCCEEDED(folderHandleAccess->Create(
+            tarballFileName.c_str() /* fileName */,
+            HCO_OPEN_EXISTING /* creationOptions */,
+            HAO_READ /* accessOptions */,
+            HSO_SHARE_READ /* sharingOptions */,
+            HO_RANDOM_ACCESS /* options */,
+            nullptr /* oplockBreakingHandler */,
+            &file));
+
+        Open(file);
+    }
+
+    TarReader::~TarReader()
+    {
+        if (nullptr != _mapping)
+        {
+            CloseHandle(
+                _mapping);
+        }
+
+        if (INVALID_HANDLE_VALUE != _file)
+        {
+            CloseHandle(
+                _file);
+        }
+    }
+
+    void TarReader::Open(
+        _In_ HANDLE file)
+    {
+        LARGE_INTEGER fileSize = {};
+
+        const bool hasFileSize = !!GetFileSizeEx(
+            file,
+            &fileSize);
+
+        if (!hasFileSize)
+        {
+            //
+            // The destructor does not run when the constructor throws.
+            //
+            CloseHandle(
+                file);
+        }
+
+        ASSERT(hasFileSize);
+
+        _file = file;
+
+        SYSTEM_INFO systemInfo = {};
+
+        GetSystemInfo(
+            &systemInfo);
+
+        _allocationGranularity = systemInfo.dwAllocationGranularity;
+
+        _archive.reset(
+            new TarArchiveScanner(
+                static_cast<uint64_t>(fileSize.QuadPart),
+                [this](uint64_t offset, void* buffer, size_t size)
+        {
+            ReadAt(offset, buffer, size);
+        }));
+    }
+
+    bool TarReader::ReadNextEntry(
+        _Out_ TarEntry* entry)
+    {
+        return _archive->ReadNextEntry(
+            entry);
+    }
+
+    void TarReader::Rewind()
+    {
+        _archive->Rewind();
+    }
+
+    bool TarReader::FindEntry(
+        _In_ const std::string& fileName,
+        _Out_ TarEntry* entry)
+    {
+        return _archive->FindEntry(
+            fileName,
+            entry);
+    }
+
+    TarEntryView TarReader::MapEntry(
+        _In_ const TarEntry& entry)
+    {
+        REQUIRES(entry.DataOffset <= GetSize());
+        REQUIRES(entry.DataSize <= GetSize() - entry.DataOffset);
+
+        //
+        // The view also spans the start of the entry's first allocation unit.
+        //
+        REQUIRES(entry.DataSize <= SIZE_MAX - _allocationGranularity);
+
+        TarEntryView view;
+
+        if (0 == entry.DataSize)
+        {
+            return view;
+        }
+
+        if (nullptr == _mapping)
+        {
+            _mapping = CreateFileMappingFromApp(
+                _file,
+                nullptr /* SecurityAttributes */,
+                PAGE_READONLY /* PageProtection */,
+                0 /* MaximumSize */,
+                nullptr /* Name */);
+
+            ASSERT(nullptr != _mapping);
+        }
+
+        //
+        // Views must start at a multiple of the allocation granularity.
+        //
+        const uint64_t viewOffset =
+            entry.DataOffset - entry.DataOffset % _allocationGranularity;
+
+        const size_t viewPrefix =
+            static_cast<size_t>(entry.DataOffset - viewOffset);
+
+        view._mappedView = MapViewOfFileFromApp(
+            _mapping,
+            FILE_MAP_READ /* DesiredAccess */,
+            viewOffset /* FileOffset */,
+            viewPrefix + static_cast<size_t>(entry.DataSize) /* NumberOfBytesToMap */);
+
+        ASSERT(nullptr != view._mappedView);
+
+        view._data = reinterpret_cast<const uint8_t*>(view._mappedView) + viewPrefix;
+        view._size = static_cast<size_t>(entry.DataSize);
+
+        return view;
+    }
+
+    size_t TarReader::ReadEntryData(
+        _In_ const TarEntry& entry,
+        _In_ const uint64_t offset,
+        _Out_writes_(bufferSize) uint8_t* buffer,
+        _In_ const size_t bufferSize)
+    {
+        return _archive->ReadEntryData(
+            entry,
+            offset,
+            buffer,
+            bufferSize);
+    }
+
+    void TarReader::LoadIndex(
+        _In_ const std::wstring& indexFileName)
+    {
+        MemoryMappedFile indexFile(
+            indexFileName);
+
+        _index.Load(
+            indexFile.GetData(),
+            indexFile.GetSize());
+    }
+
+    void TarReader::LoadIndex(
+        _In_ Windows::Storage::StorageFolder^ folder,
+        _In_ const std::wstring& indexFileName)
+    {
+        MemoryMappedFile indexFile(
+            folder,
+            indexFileName);
+
+        _index.Load(
+            indexFile.GetData(),
+            indexFile.GetSize());
+    }
+
+    TarEntry TarReader::GetFrameEntry(
+        _In_ const size_t ordinal) const
+    {
+        const TarIndexRecord& record =
+            _index.GetRecord(ordinal);
+
+        //
+        // The index must describe this tarball: each file is preceded by its
+        // header and lies within the archive.
+        //
+        REQUIRES(record.DataOffset >= TarBlockSize && record.DataOffset <= GetSize());
+        REQUIRES(record.DataSize <= GetSize() - record.DataOffset);
+        REQUIRES(record.PixelDataOffset <= record.DataSize);
+
+        TarEntry entry;
+
+        entry.Type = '0';
+        entry.HeaderOffset = record.DataOffset - TarBlockSize;
+        entry.DataOffset = record.DataOffset;
+        entry.DataSize = record.DataSize;
+
+        return entry;
+    }
+
+    bool TarReader::FindFrameEntry(
+        _In_ const uint64_t timestamp,
+        _Out_ TarEntry* entry) const
+    {
+        size_t ordinal = 0;
+
+        if (!_index.FindRecord(timestamp, &ordinal))
+        {
+            return false;
+        }
+
+        *entry = GetFrameEntry(
+            ordinal);
+
+        return true;
+    }
+
+    void TarReader::ReadAt(
+        _In_ const uint64_t offset,
+        _Out_writes_(size) void* buffer,
+        _In_ const size_t size)
+    {
+        uint8_t* destination =
+            reinterpret_cast<uint8_t*>(buffer);
+
+        size_t numberOfBytesRemaining = size;
+        uint64_t position = offset;
+
+        while (numberOfBytesRemaining > 0)
+        {
+            OVERLAPPED overlapped = {};
+
+            overlapped.Offset = static_cast<DWORD>(position);
+            overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+            const DWORD numberOfBytesToRead =
+                static_cast<DWORD>(std::min<size_t>(numberOfBytesRemaining, MAXDWORD));
+
+            DWORD numberOfBytesRead = 0;
+
+            ASSERT(!!ReadFile(
+                _file,
+                destination,
+                numberOfBytesToRead,
+                &numberOfBytesRead,
+                &overlapped));
+
+            ASSERT(numberOfBytesToRead == numberOfBytesRead);
+
+            destination += numberOfBytesRead;
+            numberOfBytesRemaining -= numberOfBytesRead;
+            position += numberOfBytesRead;
+        }
+    }
+
+    TarEntryChunkIterator::TarEntryChunkIterator(
+        _In_ TarReader& reader,
+        _In_ const TarEntry& entry,
+        _In_ const size_t chunkSize)
+        : _reader(reader)
+        , _entry(entry)
+        , _position(0)
+        , _chunk(chunkSize)
+    {
+        REQUIRES(chunkSize > 0);
+    }
+
+    bool TarEntryChunkIterator::ReadNextChunk(
+        _Out_ const uint8_t** chunkData,
+        _Out_ size_t* chunkSize)
+    {
+        const size_t numberOfBytesRead =
+            _reader.ReadEntryData(
+                _entry,
+                _position,
+                _chunk.data(),
+                _chunk.size());
+
+        _position += numberOfBytesRead;
+
+        *chunkData = _chunk.data();
+        *chunkSize = numberOfBytesRead;
+
+        return 0 != numberOfBytesRead;
+    }
 }
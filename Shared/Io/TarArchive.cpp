@@ -0,0 +1,698 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Built without the precompiled header; see TarArchiveWriter.
+//
+#include <Io/TarArchive.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace Io
+{
+    namespace
+    {
+        //
+        // TAR (Tape Archive) header.
+        //
+        // See https://en.wikipedia.org/wiki/Tar_(computing) for details.
+        //
+#pragma pack (push, 1)
+        struct TarHeader
+        {
+            TarHeader()
+                : FileName()
+                , FileMode()
+                , OwnerId()
+                , GroupId()
+                , FileSize()
+                , LastModificationTime()
+                , Checksum()
+                , Type('0' /* Normal file */)
+                , LinkedFileName()
+                , UStarIndicator()
+                , UStarVersion()
+                , OwnerUserName()
+                , OwnerGroupName()
+                , DeviceMajorNumber()
+                , DeviceMinorNumber()
+                , FileNamePrefix()
+                , Padding()
+            {
+                //
+                // S_IFREG: regular file.
+                //
+                FileMode[0] = '0'; FileMode[1] = '1'; FileMode[2] = '0'; FileMode[3] = '0';
+
+                //
+                // S_IRWXU+S_IRWXG+S_IRWXO: User/Group/Other can Read/Write/Execute.
+                //
+                FileMode[4] = '7'; FileMode[5] = '7'; FileMode[6] = '7'; FileMode[7] = '\0';
+
+                //
+                // Ignore group and owner ids.
+                //
+                for (int32_t i = 0; i < 7; ++i)
+                {
+                    OwnerId[i] = '0';
+                    GroupId[i] = '0';
+                }
+
+                //
+                // Note that the Checksum field needs to be set to space characters before
+                // we calculate the final checksum of the header.
+                //
+                for (int32_t i = 0; i < 7; ++i)
+                {
+                    Checksum[i] = ' ';
+                }
+
+                ChecksumSpace = ' ';
+
+                //
+                // UStar magic number and version.
+                //
+                UStarIndicator[0] = 'u'; UStarIndicator[1] = 's'; UStarIndicator[2] = 't';
+                UStarIndicator[3] = 'a'; UStarIndicator[4] = 'r'; UStarIndicator[5] = '\0';
+
+                UStarVersion[0] = '0'; UStarVersion[1] = '0';
+            }
+
+            char FileName[100];                 // 0
+            char FileMode[8];                   // 100
+            char OwnerId[8];                    // 108
+            char GroupId[8];                    // 116
+            char FileSize[12];                  // 124
+            char LastModificationTime[12];      // 136
+            char Checksum[7];                   // 148
+            char ChecksumSpace;                 // 155
+            char Type;                          // 156
+            char LinkedFileName[100];           // 157
+            char UStarIndicator[6];             // 257
+            char UStarVersion[2];               // 263
+            char OwnerUserName[32];             // 265
+            char OwnerGroupName[32];            // 297
+            char DeviceMajorNumber[8];          // 329
+            char DeviceMinorNumber[8];          // 337
+            char FileNamePrefix[155];           // 345
+            char Padding[12];                   // 500
+                                                // 512
+        };
+#pragma pack (pop)
+
+        static_assert(
+            TarBlockSize == sizeof(TarHeader),
+            "Size of the TarHeader structure must be equal to 512 bytes.");
+
+        // Spans up to this size are copied next to the tar header so that
+        // they reach the OS in the same write.
+        const size_t c_maxStagedSpanSize = 16 * 1024;
+
+        // Zeros used to pad the files and to terminate the archive.
+        const uint8_t c_zeroBlock[TarBlockSize] = {};
+
+        template <size_t N>
+        void CopyStringToTarHeader(
+            _In_ const std::string& input,
+            _Out_ char output[N])
+        {
+            ASSERT(input.size() < N);
+
+            for (size_t i = 0; i < input.size(); ++i)
+            {
+                output[i] = input[i];
+            }
+
+            for (size_t i = input.size(); i < N; ++i)
+            {
+                output[i] = '\0';
+            }
+        }
+
+        template <size_t N>
+        void CopyUInt64ToTarHeaderAsOctets(
+            _In_ const uint64_t input,
+            _Out_ char output[N])
+        {
+            size_t numberOfOctets = 0;
+
+            if (input > 0)
+            {
+                char buffer[32] = {};
+
+                const int result = snprintf(
+                    buffer,
+                    sizeof(buffer),
+                    "%0*llo",
+                    static_cast<int>(N - 1),
+                    static_cast<unsigned long long>(input));
+
+                ASSERT(result > 0);
+
+                numberOfOctets = static_cast<size_t>(result);
+
+                ASSERT(numberOfOctets <= N - 1);
+
+                for (size_t i = 0; i < numberOfOctets; ++i)
+                {
+                    output[i] = buffer[i];
+                }
+            }
+
+            for (size_t i = numberOfOctets; i < N; ++i)
+            {
+                output[i] = '\0';
+            }
+        }
+
+        //
+        // Parses a numeric field of a tar header. Fields are octal numbers
+        // unless the high bit of the first byte is set, in which case the
+        // remaining bits hold a big endian binary number (GNU base-256).
+        //
+        uint64_t ParseTarNumber(
+            _In_reads_(fieldSize) const char* field,
+            _In_ const size_t fieldSize)
+        {
+            const uint8_t* bytes =
+                reinterpret_cast<const uint8_t*>(field);
+
+            uint64_t value = 0;
+
+            if (0 != (bytes[0] & 0x80))
+            {
+                // Negative base-256 numbers are not valid sizes.
+                ASSERT(0 == (bytes[0] & 0x40));
+
+                value = bytes[0] & 0x3f;
+
+                for (size_t i = 1; i < fieldSize; ++i)
+                {
+                    ASSERT(value <= (UINT64_MAX >> 8));
+                    value = (value << 8) | bytes[i];
+                }
+
+                return value;
+            }
+
+            size_t i = 0;
+
+            while (i < fieldSize && (' ' == field[i] || '\0' == field[i]))
+            {
+                ++i;
+            }
+
+            for (; i < fieldSize && field[i] >= '0' && field[i] <= '7'; ++i)
+            {
+                value = (value << 3) | static_cast<uint64_t>(field[i] - '0');
+            }
+
+            return value;
+        }
+
+        uint64_t RoundUpToTarBlockSize(
+            _In_ const uint64_t size)
+        {
+            return (size + TarBlockSize - 1) / TarBlockSize * TarBlockSize;
+        }
+
+        std::string NormalizeTarEntryName(
+            _In_ const std::string& fileName)
+        {
+            std::string normalizedFileName(fileName);
+
+            std::replace(
+                normalizedFileName.begin(),
+                normalizedFileName.end(),
+                '\\',
+                '/');
+
+            return normalizedFileName;
+        }
+
+        //
+        // Extracts the 'path' and 'size' keywords from the records of a pax
+        // extended header. Each record has the form "<length> <key>=<value>\n".
+        //
+        void ParsePaxRecords(
+            _In_ const std::string& records,
+            _Inout_ std::string& path,
+            _Inout_ bool& hasPath,
+            _Inout_ uint64_t& size,
+            _Inout_ bool& hasSize)
+        {
+            size_t position = 0;
+
+            while (position < records.size())
+            {
+                const size_t lengthEnd =
+                    records.find(' ', position);
+
+                if (std::string::npos == lengthEnd)
+                {
+                    break;
+                }
+
+                const size_t recordLength = static_cast<size_t>(
+                    std::strtoull(records.c_str() + position, nullptr, 10));
+
+                ASSERT(recordLength > lengthEnd - position);
+                ASSERT(position + recordLength <= records.size());
+
+                const std::string record =
+                    records.substr(lengthEnd + 1, position + recordLength - lengthEnd - 2);
+
+                const size_t separator =
+                    record.find('=');
+
+                if (std::string::npos != separator)
+                {
+                    const std::string key = record.substr(0, separator);
+                    const std::string value = record.substr(separator + 1);
+
+                    if ("path" == key)
+                    {
+                        path = value;
+                        hasPath = true;
+                    }
+                    else if ("size" == key)
+                    {
+                        size = std::strtoull(value.c_str(), nullptr, 10);
+                        hasSize = true;
+                    }
+                }
+
+                position += recordLength;
+            }
+        }
+    }
+
+    void FormatTarHeader(
+        _In_ const std::string& fileName,
+        _In_ const uint64_t fileSize,
+        _In_ const uint64_t modificationTime,
+        _Out_writes_(TarBlockSize) uint8_t* header)
+    {
+        TarHeader tarHeader;
+
+        CopyStringToTarHeader<100>(fileName, tarHeader.FileName);
+        CopyUInt64ToTarHeaderAsOctets<12>(fileSize, tarHeader.FileSize);
+        CopyUInt64ToTarHeaderAsOctets<12>(modificationTime, tarHeader.LastModificationTime);
+
+        uint64_t checksum = 0;
+
+        for (size_t i = 0; i < sizeof(tarHeader); ++i)
+        {
+            checksum += reinterpret_cast<const uint8_t*>(&tarHeader)[i];
+        }
+
+        CopyUInt64ToTarHeaderAsOctets<7>(checksum, tarHeader.Checksum);
+
+        memcpy(header, &tarHeader, sizeof(tarHeader));
+    }
+
+    TarArchiveWriter::TarArchiveWriter(
+        _In_ const WriteFunction& write)
+        : _write(write)
+        , _stagingBuffer(TarBlockSize * 2 + c_maxStagedSpanSize)
+        , _stagingBufferSize(0)
+        , _writtenSize(0)
+        , _finished(false)
+    {
+    }
+
+    uint64_t TarArchiveWriter::AddFile(
+        _In_ const std::string& fileName,
+        _In_reads_(numberOfFileSpans) const TarballFileSpan* fileSpans,
+        _In_ const size_t numberOfFileSpans,
+        _In_ const uint64_t modificationTime)
+    {
+        REQUIRES(!_finished);
+
+        size_t fileSize = 0;
+
+        for (size_t i = 0; i < numberOfFileSpans; ++i)
+        {
+            fileSize += fileSpans[i].Size;
+        }
+
+        uint8_t header[TarBlockSize];
+
+        FormatTarHeader(
+            fileName,
+            fileSize,
+            modificationTime,
+            header);
+
+        //
+        // The header is written together with the padding of the previous
+        // file and with the small spans that follow it. Win32 has no writev
+        // for buffered handles, so large spans are written in place instead
+        // of being gathered.
+        //
+        Stage(header, sizeof(header));
+
+        const uint64_t dataOffset = _writtenSize + _stagingBufferSize;
+
+        for (size_t i = 0; i < numberOfFileSpans; ++i)
+        {
+            const TarballFileSpan& fileSpan = fileSpans[i];
+
+            if (fileSpan.Size <= c_maxStagedSpanSize)
+            {
+                Stage(fileSpan.Data, fileSpan.Size);
+            }
+            else
+            {
+                FlushStagingBuffer();
+                Write(fileSpan.Data, fileSpan.Size);
+            }
+        }
+
+        FlushStagingBuffer();
+
+        //
+        // Make sure the file is aligned to 512 byes, otherwise pad the file
+        // with zeros. The padding goes out with the next write.
+        //
+        const size_t lastBlockSize = fileSize % TarBlockSize;
+
+        if (lastBlockSize != 0)
+        {
+            Stage(c_zeroBlock, TarBlockSize - lastBlockSize);
+        }
+
+        return dataOffset;
+    }
+
+    void TarArchiveWriter::Finish()
+    {
+        if (_finished)
+        {
+            return;
+        }
+
+        //
+        // The tarball always ends with two 512 byte blocks of zeros.
+        //
+        Stage(c_zeroBlock, TarBlockSize);
+        Stage(c_zeroBlock, TarBlockSize);
+        FlushStagingBuffer();
+
+        _finished = true;
+    }
+
+    void TarArchiveWriter::Stage(
+        _In_reads_(size) const uint8_t* data,
+        _In_ const size_t size)
+    {
+        if (_stagingBufferSize + size > _stagingBuffer.size())
+        {
+            FlushStagingBuffer();
+        }
+
+        ASSERT(_stagingBufferSize + size <= _stagingBuffer.size());
+
+        if (0 != size)
+        {
+            memcpy(_stagingBuffer.data() + _stagingBufferSize, data, size);
+        }
+
+        _stagingBufferSize += size;
+    }
+
+    void TarArchiveWriter::FlushStagingBuffer()
+    {
+        if (0 != _stagingBufferSize)
+        {
+            Write(_stagingBuffer.data(), _stagingBufferSize);
+            _stagingBufferSize = 0;
+        }
+    }
+
+    void TarArchiveWriter::Write(
+        _In_reads_(size) const uint8_t* data,
+        _In_ const size_t size)
+    {
+        _write(data, size);
+
+        _writtenSize += size;
+    }
+
+    TarArchiveScanner::TarArchiveScanner(
+        _In_ const uint64_t archiveSize,
+        _In_ const ReadFunction& read)
+        : _archiveSize(archiveSize)
+        , _read(read)
+        , _nextHeaderOffset(0)
+        , _allEntriesIndexed(false)
+    {
+    }
+
+    bool TarArchiveScanner::ReadNextEntry(
+        _Out_ TarEntry* entry)
+    {
+        std::string longFileName;
+        bool hasLongFileName = false;
+
+        uint64_t paxSize = 0;
+        bool hasPaxSize = false;
+
+        while (_nextHeaderOffset + TarBlockSize <= _archiveSize)
+        {
+            TarHeader header;
+
+            _read(
+                _nextHeaderOffset,
+                &header,
+                sizeof(header));
+
+            const uint8_t* headerBytes =
+                reinterpret_cast<const uint8_t*>(&header);
+
+            //
+            // The archive ends with blocks of zeros.
+            //
+            if (std::all_of(
+                headerBytes,
+                headerBytes + sizeof(header),
+                [](uint8_t b) { return 0 == b; }))
+            {
+                break;
+            }
+
+            //
+            // The checksum is computed with the checksum field set to spaces.
+            // Some old archivers summed signed chars, so accept both.
+            //
+            {
+                const uint64_t expectedChecksum =
+                    ParseTarNumber(header.Checksum, sizeof(header.Checksum) + 1);
+
+                uint64_t unsignedChecksum = 0;
+                int64_t signedChecksum = 0;
+
+                for (size_t i = 0; i < sizeof(header); ++i)
+                {
+                    const bool isChecksumField =
+                        i >= offsetof(TarHeader, Checksum) &&
+                        i < offsetof(TarHeader, Type);
+
+                    const uint8_t b = isChecksumField ? ' ' : headerBytes[i];
+
+                    unsignedChecksum += b;
+                    signedChecksum += static_cast<int8_t>(b);
+                }
+
+                ASSERT(
+                    expectedChecksum == unsignedChecksum ||
+                    static_cast<int64_t>(expectedChecksum) == signedChecksum);
+            }
+
+            const uint64_t headerOffset = _nextHeaderOffset;
+            const uint64_t dataOffset = headerOffset + TarBlockSize;
+
+            uint64_t dataSize =
+                ParseTarNumber(header.FileSize, sizeof(header.FileSize));
+
+            if (hasPaxSize && 'x' != header.Type && 'L' != header.Type)
+            {
+                dataSize = paxSize;
+            }
+
+            ASSERT(dataSize <= _archiveSize - dataOffset);
+
+            _nextHeaderOffset =
+                dataOffset + RoundUpToTarBlockSize(dataSize);
+
+            if ('L' == header.Type)
+            {
+                //
+                // GNU long name: the data holds the name of the next entry.
+                //
+                longFileName = ReadString(dataOffset, dataSize);
+                hasLongFileName = true;
+            }
+            else if ('x' == header.Type)
+            {
+                //
+                // pax extended header for the next entry.
+                //
+                ParsePaxRecords(
+                    ReadString(dataOffset, dataSize),
+                    longFileName,
+                    hasLongFileName,
+                    paxSize,
+                    hasPaxSize);
+            }
+            else if ('g' == header.Type || 'K' == header.Type)
+            {
+                //
+                // Global pax headers and GNU long link names do not affect
+                // how entries are located.
+                //
+            }
+            else
+            {
+                if (hasLongFileName)
+                {
+                    entry->FileName = longFileName;
+                }
+                else
+                {
+                    entry->FileName.assign(
+                        header.FileName,
+                        strnlen(header.FileName, sizeof(header.FileName)));
+
+                    //
+                    // POSIX ustar splits long names into a prefix and a name. GNU
+                    // archives ("ustar  ") use the prefix field for other data.
+                    //
+                    const bool isPosixUStar =
+                        0 == memcmp(header.UStarIndicator, "ustar\0", 6);
+
+                    if (isPosixUStar && '\0' != header.FileNamePrefix[0])
+                    {
+                        entry->FileName =
+                            std::string(
+                                header.FileNamePrefix,
+                                strnlen(header.FileNamePrefix, sizeof(header.FileNamePrefix))) +
+                            "/" + entry->FileName;
+                    }
+                }
+
+                entry->Type = ('\0' == header.Type) ? '0' : header.Type;
+                entry->HeaderOffset = headerOffset;
+                entry->DataOffset = dataOffset;
+                entry->DataSize = dataSize;
+
+                return true;
+            }
+        }
+
+        _nextHeaderOffset = _archiveSize;
+
+        return false;
+    }
+
+    void TarArchiveScanner::Rewind()
+    {
+        _nextHeaderOffset = 0;
+    }
+
+    bool TarArchiveScanner::FindEntry(
+        _In_ const std::string& fileName,
+        _Out_ TarEntry* entry)
+    {
+        if (!_allEntriesIndexed)
+        {
+            const uint64_t nextHeaderOffset = _nextHeaderOffset;
+
+            Rewind();
+
+            TarEntry currentEntry;
+
+            while (ReadNextEntry(&currentEntry))
+            {
+                _entriesByName[NormalizeTarEntryName(currentEntry.FileName)] =
+                    currentEntry;
+            }
+
+            _nextHeaderOffset = nextHeaderOffset;
+            _allEntriesIndexed = true;
+        }
+
+        const auto foundEntry =
+            _entriesByName.find(
+                NormalizeTarEntryName(fileName));
+
+        if (_entriesByName.end() == foundEntry)
+        {
+            return false;
+        }
+
+        *entry = foundEntry->second;
+
+        return true;
+    }
+
+    size_t TarArchiveScanner::ReadEntryData(
+        _In_ const TarEntry& entry,
+        _In_ const uint64_t offset,
+        _Out_writes_(bufferSize) uint8_t* buffer,
+        _In_ const size_t bufferSize)
+    {
+        if (offset >= entry.DataSize)
+        {
+            return 0;
+        }
+
+        const size_t numberOfBytesToRead = static_cast<size_t>(
+            (std::min<uint64_t>)(bufferSize, entry.DataSize - offset));
+
+        _read(
+            entry.DataOffset + offset,
+            buffer,
+            numberOfBytesToRead);
+
+        return numberOfBytesToRead;
+    }
+
+    std::string TarArchiveScanner::ReadString(
+        _In_ const uint64_t offset,
+        _In_ const uint64_t size)
+    {
+        ASSERT(size <= 1024 * 1024);
+
+        std::string value(
+            static_cast<size_t>(size),
+            '\0');
+
+        if (0 != size)
+        {
+            _read(
+                offset,
+                &value[0],
+                value.size());
+        }
+
+        // Strip the NUL terminator GNU tar stores with long names.
+        value.resize(
+            strnlen(value.c_str(), value.size()));
+
+        return value;
+    }
+}
@@ -0,0 +1,180 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Built without the precompiled header; see TarIndex.
+//
+#include <Io/TarIndex.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Io
+{
+    TarIndex::TarIndex()
+    {
+        static_assert(
+            16 == sizeof(TarIndexHeader),
+            "Size of the TarIndexHeader structure must be equal to 16 bytes.");
+
+        static_assert(
+            48 == sizeof(TarIndexRecord),
+            "Size of the TarIndexRecord structure must be equal to 48 bytes.");
+    }
+
+    void TarIndex::Load(
+        _In_reads_(size) const uint8_t* data,
+        _In_ const size_t size)
+    {
+        REQUIRES(size >= sizeof(TarIndexHeader));
+
+        TarIndexHeader header;
+
+        memcpy(&header, data, sizeof(header));
+
+        REQUIRES(TarIndexCookie == header.Cookie);
+        REQUIRES(TarIndexVersionMajor == header.VersionMajor);
+        REQUIRES(sizeof(TarIndexRecord) == header.RecordSize);
+
+        //
+        // Ignore a partially written trailing record.
+        //
+        const size_t numberOfRecords =
+            (size - sizeof(TarIndexHeader)) / sizeof(TarIndexRecord);
+
+        REQUIRES(numberOfRecords <= UINT32_MAX);
+
+        _records.resize(numberOfRecords);
+        _ordinalsByTime.clear();
+
+        if (0 != numberOfRecords)
+        {
+            memcpy(
+                _records.data(),
+                data + sizeof(TarIndexHeader),
+                numberOfRecords * sizeof(TarIndexRecord));
+        }
+
+        bool isSortedByTime = true;
+
+        for (size_t i = 1; i < numberOfRecords && isSortedByTime; ++i)
+        {
+            isSortedByTime =
+                _records[i - 1].Timestamp <= _records[i].Timestamp;
+        }
+
+        if (!isSortedByTime)
+        {
+            _ordinalsByTime.resize(numberOfRecords);
+
+            for (size_t i = 0; i < numberOfRecords; ++i)
+            {
+                _ordinalsByTime[i] = static_cast<uint32_t>(i);
+            }
+
+            std::stable_sort(
+                _ordinalsByTime.begin(),
+                _ordinalsByTime.end(),
+                [this](uint32_t a, uint32_t b)
+            {
+                return _records[a].Timestamp < _records[b].Timestamp;
+            });
+        }
+    }
+
+    const TarIndexRecord& TarIndex::GetRecord(
+        _In_ const size_t ordinal) const
+    {
+        REQUIRES(ordinal < _records.size());
+
+        return _records[ordinal];
+    }
+
+    bool TarIndex::FindRecord(
+        _In_ const uint64_t timestamp,
+        _Out_ size_t* ordinal) const
+    {
+        const size_t position =
+            LowerBound(timestamp);
+
+        if (position == _records.size() ||
+            GetRecordByTime(position).Timestamp != timestamp)
+        {
+            return false;
+        }
+
+        *ordinal = GetOrdinalByTime(
+            position);
+
+        return true;
+    }
+
+    size_t TarIndex::FindNearestRecord(
+        _In_ const uint64_t timestamp) const
+    {
+        REQUIRES(!_records.empty());
+
+        size_t position =
+            LowerBound(timestamp);
+
+        if (position == _records.size())
+        {
+            --position;
+        }
+        else if (position > 0 &&
+            timestamp - GetRecordByTime(position - 1).Timestamp <
+            GetRecordByTime(position).Timestamp - timestamp)
+        {
+            --position;
+        }
+
+        return GetOrdinalByTime(
+            position);
+    }
+
+    const TarIndexRecord& TarIndex::GetRecordByTime(
+        _In_ const size_t position) const
+    {
+        return _records[GetOrdinalByTime(position)];
+    }
+
+    size_t TarIndex::GetOrdinalByTime(
+        _In_ const size_t position) const
+    {
+        return _ordinalsByTime.empty() ? position : _ordinalsByTime[position];
+    }
+
+    size_t TarIndex::LowerBound(
+        _In_ const uint64_t timestamp) const
+    {
+        size_t first = 0;
+        size_t count = _records.size();
+
+        while (count > 0)
+        {
+            const size_t step = count / 2;
+
+            if (GetRecordByTime(first + step).Timestamp < timestamp)
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+
+        return first;
+    }
+}
@@ -0,0 +1,330 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+
+//
+// Built without the precompiled header; see UnprojectionLut.
+//
+#include <Io/UnprojectionLut.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Io
+{
+    namespace
+    {
+        //
+        // Corner (x, y) of a camera space projection, stored column by column.
+        // The corners past the last column and row are extrapolated from the
+        // two before them.
+        //
+        void GetCorner(
+            _In_reads_(2 * imageWidth * imageHeight) const float* cameraSpaceProjection,
+            _In_ const uint32_t imageWidth,
+            _In_ const uint32_t imageHeight,
+            _In_ const uint32_t u,
+            _In_ const uint32_t v,
+            _Out_ float* cornerX,
+            _Out_ float* cornerY)
+        {
+            if (u == imageWidth || v == imageHeight)
+            {
+                const uint32_t du = (u == imageWidth) ? 1 : 0;
+                const uint32_t dv = (u == imageWidth) ? 0 : 1;
+
+                float lastX, lastY, previousX, previousY;
+
+                GetCorner(cameraSpaceProjection, imageWidth, imageHeight, u - du, v - dv, &lastX, &lastY);
+                GetCorner(cameraSpaceProjection, imageWidth, imageHeight, u - 2 * du, v - 2 * dv, &previousX, &previousY);
+
+                *cornerX = 2.0f * lastX - previousX;
+                *cornerY = 2.0f * lastY - previousY;
+
+                return;
+            }
+
+            const size_t index =
+                static_cast<size_t>(u) * imageHeight + v;
+
+            *cornerX = cameraSpaceProjection[2 * index];
+            *cornerY = cameraSpaceProjection[2 * index + 1];
+        }
+    }
+
+    UnprojectionLut::UnprojectionLut()
+        : _imageWidth(0)
+        , _imageHeight(0)
+    {
+    }
+
+    void UnprojectionLut::Resize(
+        _In_ const uint32_t imageWidth,
+        _In_ const uint32_t imageHeight)
+    {
+        const size_t pointCount =
+            static_cast<size_t>(imageWidth) * imageHeight;
+
+        _imageWidth = imageWidth;
+        _imageHeight = imageHeight;
+
+        _x.resize(pointCount);
+        _y.resize(pointCount);
+        _inverseRayLength.resize(pointCount);
+    }
+
+    void UnprojectionLut::SetPoint(
+        _In_ const size_t index,
+        _In_ float x,
+        _In_ float y)
+    {
+        REQUIRES(index < _x.size());
+
+        if (!std::isfinite(x) || !std::isfinite(y))
+        {
+            x = y = std::numeric_limits<float>::quiet_NaN();
+        }
+
+        _x[index] = x;
+        _y[index] = y;
+        _inverseRayLength[index] = 1.0f / std::sqrt(x * x + y * y + 1.0f);
+    }
+
+    void UnprojectionLut::Assign(
+        _In_ const uint32_t imageWidth,
+        _In_ const uint32_t imageHeight,
+        _In_reads_(2 * imageWidth * imageHeight) const float* points)
+    {
+        Resize(
+            imageWidth,
+            imageHeight);
+
+        for (size_t index = 0; index < _x.size(); ++index)
+        {
+            SetPoint(
+                index,
+                points[2 * index],
+                points[2 * index + 1]);
+        }
+    }
+
+    void UnprojectionLut::Sample(
+        _In_ const uint32_t imageWidth,
+        _In_ const uint32_t imageHeight,
+        _In_ const MapImagePointFunction& mapImagePoint)
+    {
+        Resize(
+            imageWidth,
+            imageHeight);
+
+        size_t index = 0;
+
+        for (uint32_t v = 0; v < imageHeight; ++v)
+        {
+            for (uint32_t u = 0; u < imageWidth; ++u)
+            {
+                float x, y;
+
+                if (!mapImagePoint(u + 0.5f, v + 0.5f, &x, &y))
+                {
+                    x = y = std::numeric_limits<float>::quiet_NaN();
+                }
+
+                SetPoint(
+                    index++,
+                    x,
+                    y);
+            }
+        }
+    }
+
+    void UnprojectionLut::AssignCameraSpaceProjection(
+        _In_ const uint32_t imageWidth,
+        _In_ const uint32_t imageHeight,
+        _In_reads_(2 * imageWidth * imageHeight) const float* cameraSpaceProjection)
+    {
+        //
+        // The corners past the last column and row are extrapolated from the
+        // two before them.
+        //
+        REQUIRES(imageWidth >= 2 && imageHeight >= 2);
+
+        Resize(
+            imageWidth,
+            imageHeight);
+
+        for (uint32_t v = 0; v < imageHeight; ++v)
+        {
+            for (uint32_t u = 0; u < imageWidth; ++u)
+            {
+                float x = 0.0f;
+                float y = 0.0f;
+
+                for (uint32_t corner = 0; corner < 4; ++corner)
+                {
+                    float cornerX, cornerY;
+
+                    GetCorner(
+                        cameraSpaceProjection,
+                        imageWidth,
+                        imageHeight,
+                        u + (corner & 1),
+                        v + (corner >> 1),
+                        &cornerX,
+                        &cornerY);
+
+                    x += cornerX;
+                    y += cornerY;
+                }
+
+                SetPoint(
+                    static_cast<size_t>(v) * imageWidth + u,
+                    0.25f * x,
+                    0.25f * y);
+            }
+        }
+    }
+
+    bool UnprojectionLut::MapImagePointToCameraUnitPlane(
+        _In_ const float u,
+        _In_ const float v,
+        _Out_ float* x,
+        _Out_ float* y) const
+    {
+        *x = *y = std::numeric_limits<float>::infinity();
+
+        if (IsEmpty())
+        {
+            return false;
+        }
+
+        //
+        // The LUT is sampled at pixel centers. Interpolate bilinearly between
+        // the four nearest samples, clamping to the border of the image.
+        //
+        const float clampedU =
+            std::min<float>(std::max<float>(u - 0.5f, 0.0f), _imageWidth - 1.0f);
+
+        const float clampedV =
+            std::min<float>(std::max<float>(v - 0.5f, 0.0f), _imageHeight - 1.0f);
+
+        if (std::isnan(clampedU) || std::isnan(clampedV))
+        {
+            return false;
+        }
+
+        const uint32_t u0 = static_cast<uint32_t>(clampedU);
+        const uint32_t v0 = static_cast<uint32_t>(clampedV);
+        const uint32_t u1 = std::min<uint32_t>(u0 + 1, _imageWidth - 1);
+        const uint32_t v1 = std::min<uint32_t>(v0 + 1, _imageHeight - 1);
+
+        const float a = clampedU - u0;
+        const float b = clampedV - v0;
+
+        const size_t i00 = static_cast<size_t>(v0) * _imageWidth + u0;
+        const size_t i01 = static_cast<size_t>(v0) * _imageWidth + u1;
+        const size_t i10 = static_cast<size_t>(v1) * _imageWidth + u0;
+        const size_t i11 = static_cast<size_t>(v1) * _imageWidth + u1;
+
+        const float mappedX =
+            (1.0f - b) * ((1.0f - a) * _x[i00] + a * _x[i01]) +
+            b * ((1.0f - a) * _x[i10] + a * _x[i11]);
+
+        const float mappedY =
+            (1.0f - b) * ((1.0f - a) * _y[i00] + a * _y[i01]) +
+            b * ((1.0f - a) * _y[i10] + a * _y[i11]);
+
+        //
+        // Pixels that do not map to the unit plane are NaN in the LUT.
+        //
+        if (std::isnan(mappedX) || std::isnan(mappedY))
+        {
+            return false;
+        }
+
+        *x = mappedX;
+        *y = mappedY;
+
+        return true;
+    }
+
+    void SampleCameraSpaceProjection(
+        _In_ const uint32_t imageWidth,
+        _In_ const uint32_t imageHeight,
+        _In_ const MapImagePointFunction& mapImagePoint,
+        _Out_ std::vector<float>& cameraSpaceProjection)
+    {
+        cameraSpaceProjection.resize(
+            2 * static_cast<size_t>(imageWidth) * imageHeight);
+
+        float* points =
+            cameraSpaceProjection.data();
+
+        for (uint32_t u = 0; u < imageWidth; ++u)
+        {
+            for (uint32_t v = 0; v < imageHeight; ++v)
+            {
+                float x, y;
+
+                if (!mapImagePoint(static_cast<float>(u), static_cast<float>(v), &x, &y))
+                {
+                    x = y = std::numeric_limits<float>::infinity();
+                }
+
+                *points++ = x;
+                *points++ = y;
+            }
+        }
+    }
+
+    uint64_t HashUnprojectionLut(
+        _In_ const UnprojectionLut& unprojectionLut)
+    {
+        const uint64_t fnvOffsetBasis = 0xcbf29ce484222325ull;
+        const uint64_t fnvPrime = 0x100000001b3ull;
+
+        uint64_t hash = fnvOffsetBasis;
+
+        const auto hashBytes = [&hash, fnvPrime](const void* data, const size_t size)
+        {
+            const uint8_t* bytes =
+                static_cast<const uint8_t*>(data);
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * fnvPrime;
+            }
+        };
+
+        const uint32_t imageWidth = unprojectionLut.GetImageWidth();
+        const uint32_t imageHeight = unprojectionLut.GetImageHeight();
+
+        hashBytes(&imageWidth, sizeof(imageWidth));
+        hashBytes(&imageHeight, sizeof(imageHeight));
+
+        //
+        // Hashed in the order the points are streamed, so that the hash of a
+        // LUT does not depend on how it is stored.
+        //
+        const size_t pointCount =
+            static_cast<size_t>(imageWidth) * imageHeight;
+
+        for (size_t i = 0; i < pointCount; ++i)
+        {
+            hashBytes(unprojectionLut.GetX() + i, sizeof(float));
+            hashBytes(unprojectionLut.GetY() + i, sizeof(float));
+        }
+
+        return hash;
+    }
+}
@@ -13,7 +13,9 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 
+#include <cfloat>
 #include <cstddef>
 #include <cstdlib>
 #include <cstdio>
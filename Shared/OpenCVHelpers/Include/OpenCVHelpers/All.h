@@ -13,3 +13,6 @@
 
 #include <OpenCVHelpers/OpenCVHelpers.h>
 #include <OpenCVHelpers/OpenCVTexture2D.h>
+#include <OpenCVHelpers/OverlayMask.h>
+#include <OpenCVHelpers/OverlayMaskRows.h>
+#include <OpenCVHelpers/UndistortDownscale.h>
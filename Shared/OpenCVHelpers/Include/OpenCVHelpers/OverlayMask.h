@@ -0,0 +1,39 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+#include <opencv2/core/core.hpp>
+
+namespace rmcv
+{
+    //
+    // Paints the pixels of an image whose value in a CV_8UC1 mask of the same
+    // size is above the threshold, e.g. to overlay the edges found by
+    // cv::Canny. The image is CV_8UC4, or CV_8UC1.
+    //
+    // The colour is packed like the BGRA pixels read as uint32_t, i.e.
+    // 0xAARRGGBB; CV_8UC1 images are painted with its gray level, weighted like
+    // cv::cvtColor does it.
+    //
+    // The rows are processed in parallel, and with SSE2 where it is available
+    // (see OverlayMaskRows).
+    // Builds without the precompiled header of the library, like
+    // UndistortDownscaleMap.
+    //
+    void OverlayMask(
+        const cv::Mat& mask,
+        const uint8_t threshold,
+        const uint32_t colorBGRA,
+        cv::Mat& image);
+}
@@ -0,0 +1,60 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rmcv
+{
+    //
+    // Instruction sets of the mask overlay. GetOverlayMaskIsa picks the best
+    // one the build targets; the scalar loop is there for testing.
+    //
+    enum class OverlayMaskIsa
+    {
+        Scalar,
+        Sse2
+    };
+
+    OverlayMaskIsa GetOverlayMaskIsa();
+
+    bool IsOverlayMaskIsaSupported(
+        const OverlayMaskIsa isa);
+
+    //
+    // The gray level CV_8UC1 images are painted with, weighted like
+    // cv::cvtColor does it.
+    //
+    uint8_t GetOverlayGrayLevel(
+        const uint32_t colorBGRA);
+
+    //
+    // The kernel of rmcv::OverlayMask, on the rows of a mask and of an image
+    // of width x height pixels. The image has 4 (BGRA) or 1 (gray) channels of
+    // 8 bits; the strides are in bytes.
+    //
+    // Builds without OpenCV, so that the instruction sets can be checked
+    // against each other on platforms that don't have it.
+    //
+    void OverlayMaskRows(
+        const OverlayMaskIsa isa,
+        const uint8_t* mask,
+        const size_t maskStride,
+        const uint8_t threshold,
+        const uint32_t colorBGRA,
+        const int32_t width,
+        const int32_t height,
+        const int32_t channels,
+        uint8_t* image,
+        const size_t imageStride);
+}
@@ -0,0 +1,102 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace rmcv
+{
+    //
+    // Undistorts a BGRA image and halves its resolution in a single pass over the
+    // image, in place of cv::remap with the maps of cv::initUndistortRectifyMap
+    // (without rectification, and keeping the camera matrix) followed by
+    // cv::resize by 0.5 with cv::INTER_AREA.
+    //
+    // Each pixel of the downscaled image averages the four bilinear samples of
+    // the undistorted image it covers. The map bakes them into a separable 4x4
+    // filter of the distorted image, with the samples at fixed-point positions,
+    // 1/64th of a pixel accurate. Only the shear of the distortion within a
+    // pixel is ignored. Pixels sampled outside of the image are black, like
+    // with cv::remap's default constant border.
+    //
+    // The image is processed in tiles, in parallel over bands of rows.
+    //
+    // Builds without the precompiled header of the library, so that it can be
+    // benchmarked on other platforms too.
+    //
+    class UndistortDownscaleMap
+    {
+    public:
+        UndistortDownscaleMap();
+
+        //
+        // The distortion coefficients are (k1, k2, p1, p2, k3), like OpenCV's.
+        //
+        void Create(
+            const cv::Size& imageSize,
+            const cv::Matx33d& cameraMatrix,
+            const cv::Vec<double, 5>& distortionCoefficients);
+
+        bool IsEmpty() const
+        {
+            return _taps.empty();
+        }
+
+        // Of the distorted images.
+        cv::Size GetImageSize() const
+        {
+            return _imageSize;
+        }
+
+        cv::Size GetDownscaledImageSize() const
+        {
+            return cv::Size(
+                _imageSize.width / 2,
+                _imageSize.height / 2);
+        }
+
+        //
+        // Undistorts and downscales a CV_8UC4 image of the map's size. The
+        // downscaled image is (re)allocated as needed; it may not share its
+        // pixels with the image.
+        //
+        void Apply(
+            const cv::Mat& image,
+            cv::Mat& downscaledImage) const;
+
+    private:
+        class ParallelApply;
+
+        //
+        // Top left pixel of the 4x4 filter of a downscaled pixel, and weights of
+        // its columns, then of its rows, which each sum to 128.
+        //
+        struct Tap
+        {
+            int16_t X;
+            int16_t Y;
+            uint8_t Weights[8];
+        };
+
+        void ApplyToTile(
+            const cv::Mat& image,
+            const cv::Rect& tile,
+            cv::Mat& downscaledImage) const;
+
+    private:
+        cv::Size _imageSize;
+        std::vector<Tap> _taps;
+    };
+}
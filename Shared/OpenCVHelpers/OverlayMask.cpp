@@ -0,0 +1,99 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see OverlayMask.
+//
+#include <OpenCVHelpers/OverlayMask.h>
+#include <OpenCVHelpers/OverlayMaskRows.h>
+
+#include <algorithm>
+
+namespace rmcv
+{
+    namespace
+    {
+        //
+        // Rows processed by each of the parallel tasks; painting a row takes
+        // too little time for it to be worth a task of its own.
+        //
+        const int32_t c_bandHeight = 32;
+
+        class ParallelOverlay
+            : public cv::ParallelLoopBody
+        {
+        public:
+            ParallelOverlay(
+                const cv::Mat& mask,
+                const uint8_t threshold,
+                const uint32_t colorBGRA,
+                cv::Mat& image)
+                : _mask(mask)
+                , _threshold(threshold)
+                , _colorBGRA(colorBGRA)
+                , _isa(GetOverlayMaskIsa())
+                , _image(image)
+            {
+            }
+
+            virtual void operator()(
+                const cv::Range& bands) const override
+            {
+                const int32_t top =
+                    bands.start * c_bandHeight;
+
+                const int32_t bottom =
+                    std::min(bands.end * c_bandHeight, _image.rows);
+
+                OverlayMaskRows(
+                    _isa,
+                    _mask.ptr<uint8_t>(top),
+                    _mask.step,
+                    _threshold,
+                    _colorBGRA,
+                    _image.cols,
+                    bottom - top,
+                    _image.channels(),
+                    _image.ptr<uint8_t>(top),
+                    _image.step);
+            }
+
+            ParallelOverlay& operator=(const ParallelOverlay&) = delete;
+
+        private:
+            const cv::Mat& _mask;
+            const uint8_t _threshold;
+            const uint32_t _colorBGRA;
+            const OverlayMaskIsa _isa;
+            cv::Mat& _image;
+        };
+    }
+
+    void OverlayMask(
+        const cv::Mat& mask,
+        const uint8_t threshold,
+        const uint32_t colorBGRA,
+        cv::Mat& image)
+    {
+        CV_Assert(
+            CV_8UC1 == mask.type() &&
+            (CV_8UC4 == image.type() || CV_8UC1 == image.type()) &&
+            mask.size() == image.size());
+
+        const int32_t bandCount =
+            (image.rows + c_bandHeight - 1) / c_bandHeight;
+
+        cv::parallel_for_(
+            cv::Range(0, bandCount),
+            ParallelOverlay(mask, threshold, colorBGRA, image));
+    }
+}
@@ -0,0 +1,222 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+
+//
+// Built without the precompiled header; see OverlayMaskRows.
+//
+#include <OpenCVHelpers/OverlayMaskRows.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define RMCV_OVERLAY_MASK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace rmcv
+{
+    namespace
+    {
+#if RMCV_OVERLAY_MASK_SSE2
+        //
+        // Selects the mask values above the threshold. SSE2 only compares
+        // signed bytes, hence the flipped sign bits.
+        //
+        __m128i SelectSse2(
+            const uint8_t* mask,
+            const __m128i biasedThreshold)
+        {
+            const __m128i values =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+
+            return _mm_cmpgt_epi8(
+                _mm_xor_si128(values, _mm_set1_epi8(static_cast<char>(0x80))),
+                biasedThreshold);
+        }
+
+        void BlendSse2(
+            uint8_t* pixels,
+            const __m128i selected,
+            const __m128i color)
+        {
+            __m128i* destination =
+                reinterpret_cast<__m128i*>(pixels);
+
+            const __m128i kept =
+                _mm_andnot_si128(selected, _mm_loadu_si128(destination));
+
+            _mm_storeu_si128(
+                destination,
+                _mm_or_si128(kept, _mm_and_si128(selected, color)));
+        }
+#endif /* RMCV_OVERLAY_MASK_SSE2 */
+
+        void OverlayBgraRow(
+            const OverlayMaskIsa isa,
+            const uint8_t* mask,
+            const uint8_t threshold,
+            const uint32_t colorBGRA,
+            const int32_t width,
+            uint32_t* pixels)
+        {
+            int32_t x = 0;
+
+#if RMCV_OVERLAY_MASK_SSE2
+            const __m128i biasedThreshold =
+                _mm_set1_epi8(static_cast<char>(threshold ^ 0x80));
+
+            const __m128i color =
+                _mm_set1_epi32(static_cast<int>(colorBGRA));
+
+            for (; OverlayMaskIsa::Sse2 == isa && x + 16 <= width; x += 16)
+            {
+                const __m128i selected =
+                    SelectSse2(mask + x, biasedThreshold);
+
+                //
+                // Edges are sparse: most groups of pixels are left alone,
+                // without touching their memory.
+                //
+                if (0 == _mm_movemask_epi8(selected))
+                {
+                    continue;
+                }
+
+                // Widens the selection of each pixel to its four channels.
+                const __m128i low = _mm_unpacklo_epi8(selected, selected);
+                const __m128i high = _mm_unpackhi_epi8(selected, selected);
+
+                uint8_t* destination =
+                    reinterpret_cast<uint8_t*>(pixels + x);
+
+                BlendSse2(destination, _mm_unpacklo_epi16(low, low), color);
+                BlendSse2(destination + 16, _mm_unpackhi_epi16(low, low), color);
+                BlendSse2(destination + 32, _mm_unpacklo_epi16(high, high), color);
+                BlendSse2(destination + 48, _mm_unpackhi_epi16(high, high), color);
+            }
+#endif /* RMCV_OVERLAY_MASK_SSE2 */
+
+            for (; x < width; ++x)
+            {
+                if (mask[x] > threshold)
+                {
+                    pixels[x] = colorBGRA;
+                }
+            }
+        }
+
+        void OverlayGrayRow(
+            const OverlayMaskIsa isa,
+            const uint8_t* mask,
+            const uint8_t threshold,
+            const uint8_t grayLevel,
+            const int32_t width,
+            uint8_t* pixels)
+        {
+            int32_t x = 0;
+
+#if RMCV_OVERLAY_MASK_SSE2
+            const __m128i biasedThreshold =
+                _mm_set1_epi8(static_cast<char>(threshold ^ 0x80));
+
+            const __m128i color =
+                _mm_set1_epi8(static_cast<char>(grayLevel));
+
+            for (; OverlayMaskIsa::Sse2 == isa && x + 16 <= width; x += 16)
+            {
+                const __m128i selected =
+                    SelectSse2(mask + x, biasedThreshold);
+
+                if (0 != _mm_movemask_epi8(selected))
+                {
+                    BlendSse2(pixels + x, selected, color);
+                }
+            }
+#endif /* RMCV_OVERLAY_MASK_SSE2 */
+
+            for (; x < width; ++x)
+            {
+                if (mask[x] > threshold)
+                {
+                    pixels[x] = grayLevel;
+                }
+            }
+        }
+    }
+
+    OverlayMaskIsa GetOverlayMaskIsa()
+    {
+#if RMCV_OVERLAY_MASK_SSE2
+        return OverlayMaskIsa::Sse2;
+#else
+        return OverlayMaskIsa::Scalar;
+#endif
+    }
+
+    bool IsOverlayMaskIsaSupported(
+        const OverlayMaskIsa isa)
+    {
+        return OverlayMaskIsa::Scalar == isa || GetOverlayMaskIsa() == isa;
+    }
+
+    uint8_t GetOverlayGrayLevel(
+        const uint32_t colorBGRA)
+    {
+        const uint32_t blue = colorBGRA & 0xFF;
+        const uint32_t green = (colorBGRA >> 8) & 0xFF;
+        const uint32_t red = (colorBGRA >> 16) & 0xFF;
+
+        return static_cast<uint8_t>(
+            (29 * blue + 150 * green + 77 * red + 128) >> 8);
+    }
+
+    void OverlayMaskRows(
+        const OverlayMaskIsa isa,
+        const uint8_t* mask,
+        const size_t maskStride,
+        const uint8_t threshold,
+        const uint32_t colorBGRA,
+        const int32_t width,
+        const int32_t height,
+        const int32_t channels,
+        uint8_t* image,
+        const size_t imageStride)
+    {
+        const uint8_t grayLevel =
+            GetOverlayGrayLevel(colorBGRA);
+
+        for (int32_t y = 0; y < height; ++y)
+        {
+            const uint8_t* maskRow = mask + y * maskStride;
+            uint8_t* imageRow = image + y * imageStride;
+
+            if (4 == channels)
+            {
+                OverlayBgraRow(
+                    isa,
+                    maskRow,
+                    threshold,
+                    colorBGRA,
+                    width,
+                    reinterpret_cast<uint32_t*>(imageRow));
+            }
+            else
+            {
+                OverlayGrayRow(
+                    isa,
+                    maskRow,
+                    threshold,
+                    grayLevel,
+                    width,
+                    imageRow);
+            }
+        }
+    }
+}
@@ -0,0 +1,449 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+//
+// Built without the precompiled header; see UndistortDownscaleMap.
+//
+#include <OpenCVHelpers/UndistortDownscale.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define RMCV_UNDISTORT_DOWNSCALE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace rmcv
+{
+    namespace
+    {
+        //
+        // Positions of the samples are in 1/64th of a pixel. The weights of the
+        // filters, the products of their weights along each axis, sum to 2^14.
+        //
+        const int32_t c_fractionBits = 6;
+        const int32_t c_fractionOne = 1 << c_fractionBits;
+        const int32_t c_weightBits = 2 * (c_fractionBits + 1);
+
+        //
+        // Bands of rows processed in parallel, and width of the tiles they are
+        // processed in, in downscaled pixels. A tile reads about 20 rows of 130
+        // pixels of the image, which fit the L1 cache.
+        //
+        const int32_t c_bandHeight = 8;
+        const int32_t c_tileWidth = 64;
+
+        //
+        // Position in the distorted image of a pixel of the undistorted image;
+        // the model of cv::initUndistortRectifyMap.
+        //
+        cv::Point2d Distort(
+            const cv::Matx33d& cameraMatrix,
+            const cv::Vec<double, 5>& distortionCoefficients,
+            const double u,
+            const double v)
+        {
+            const double fx = cameraMatrix(0, 0);
+            const double fy = cameraMatrix(1, 1);
+            const double cx = cameraMatrix(0, 2);
+            const double cy = cameraMatrix(1, 2);
+
+            const double k1 = distortionCoefficients[0];
+            const double k2 = distortionCoefficients[1];
+            const double p1 = distortionCoefficients[2];
+            const double p2 = distortionCoefficients[3];
+            const double k3 = distortionCoefficients[4];
+
+            const double x = (u - cx) / fx;
+            const double y = (v - cy) / fy;
+
+            const double r2 = x * x + y * y;
+            const double radial = 1.0 + r2 * (k1 + r2 * (k2 + r2 * k3));
+
+            const double distortedX = x * radial + 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+            const double distortedY = y * radial + p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+
+            return cv::Point2d(
+                fx * distortedX + cx,
+                fy * distortedY + cy);
+        }
+
+        //
+        // Weights, along one axis, of the filter that averages two bilinear
+        // samples at the given positions, which must be in order and less than
+        // two pixels apart for the filter to fit four pixels. Positions far
+        // outside of the image are clamped, still outside of it.
+        //
+        void GetFilterWeights(
+            const double firstPosition,
+            const double secondPosition,
+            const int32_t imageSize,
+            int16_t* firstPixel,
+            uint8_t weights[4])
+        {
+            const int32_t first = static_cast<int32_t>(std::lround(
+                std::min(std::max(firstPosition, -5.0), static_cast<double>(imageSize)) * c_fractionOne));
+
+            const int32_t spacing = std::min(std::max(
+                static_cast<int32_t>(std::lround((secondPosition - firstPosition) * c_fractionOne)),
+                0),
+                2 * c_fractionOne - 1);
+
+            // Rounds toward minus infinity.
+            const int32_t pixel = (first >= 0) ? first / c_fractionOne : -((c_fractionOne - 1 - first) / c_fractionOne);
+
+            const int32_t firstFraction = first - pixel * c_fractionOne;
+            const int32_t second = firstFraction + spacing;
+
+            std::fill(
+                weights,
+                weights + 4,
+                static_cast<uint8_t>(0));
+
+            weights[0] = static_cast<uint8_t>(c_fractionOne - firstFraction);
+            weights[1] = static_cast<uint8_t>(firstFraction);
+
+            const int32_t secondPixel = second / c_fractionOne;
+            const int32_t secondFraction = second % c_fractionOne;
+
+            weights[secondPixel] = static_cast<uint8_t>(weights[secondPixel] + c_fractionOne - secondFraction);
+            weights[secondPixel + 1] = static_cast<uint8_t>(weights[secondPixel + 1] + secondFraction);
+
+            *firstPixel = static_cast<int16_t>(pixel);
+        }
+
+#if RMCV_UNDISTORT_DOWNSCALE_SSE2
+        void AddWeightedRowSse2(
+            const uint8_t* row,
+            const __m128i weight,
+            __m128i* columns01,
+            __m128i* columns23)
+        {
+            const __m128i pixels =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+
+            const __m128i zero = _mm_setzero_si128();
+
+            *columns01 = _mm_add_epi16(*columns01, _mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), weight));
+            *columns23 = _mm_add_epi16(*columns23, _mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), weight));
+        }
+
+        //
+        // Filters the 4x4 pixels from topLeft, which must all be in the image:
+        // the rows first, with 16-bit products, then the columns, with madd on
+        // pairs of 16-bit column sums and weights.
+        //
+        void FilterPixelSse2(
+            const uint8_t* topLeft,
+            const size_t stride,
+            const uint8_t weights[8],
+            uint8_t* pixel)
+        {
+            const __m128i zero = _mm_setzero_si128();
+
+            // The weights of the columns, then of the rows, as 16-bit integers.
+            const __m128i weightsXY = _mm_unpacklo_epi8(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weights)),
+                zero);
+
+            const __m128i weightsY = _mm_unpackhi_epi16(weightsXY, weightsXY);
+
+            // Pixels 0 and 1, and pixels 2 and 3, of the rows.
+            __m128i columns01 = zero;
+            __m128i columns23 = zero;
+
+            AddWeightedRowSse2(topLeft, _mm_shuffle_epi32(weightsY, 0x00), &columns01, &columns23);
+            AddWeightedRowSse2(topLeft + stride, _mm_shuffle_epi32(weightsY, 0x55), &columns01, &columns23);
+            AddWeightedRowSse2(topLeft + 2 * stride, _mm_shuffle_epi32(weightsY, 0xaa), &columns01, &columns23);
+            AddWeightedRowSse2(topLeft + 3 * stride, _mm_shuffle_epi32(weightsY, 0xff), &columns01, &columns23);
+
+            //
+            // Channel by channel, (column 0, column 1) and (column 2, column 3)
+            // pairs; the sums of the columns are below 2^15.
+            //
+            const __m128i pairs01 = _mm_unpacklo_epi16(columns01, _mm_srli_si128(columns01, 8));
+            const __m128i pairs23 = _mm_unpacklo_epi16(columns23, _mm_srli_si128(columns23, 8));
+
+            __m128i sums = _mm_add_epi32(
+                _mm_madd_epi16(pairs01, _mm_shuffle_epi32(weightsXY, 0x00)),
+                _mm_madd_epi16(pairs23, _mm_shuffle_epi32(weightsXY, 0x55)));
+
+            sums = _mm_add_epi32(sums, _mm_set1_epi32(1 << (c_weightBits - 1)));
+            sums = _mm_srli_epi32(sums, c_weightBits);
+            sums = _mm_packs_epi32(sums, sums);
+            sums = _mm_packus_epi16(sums, sums);
+
+            const int32_t bgra =
+                _mm_cvtsi128_si32(sums);
+
+            memcpy(
+                pixel,
+                &bgra,
+                sizeof(bgra));
+        }
+#else
+        //
+        // Filters the 4x4 pixels from topLeft, which must all be in the image.
+        //
+        void FilterPixelScalar(
+            const uint8_t* topLeft,
+            const size_t stride,
+            const uint8_t weights[8],
+            uint8_t* pixel)
+        {
+            uint32_t columns[16] = {};
+
+            for (int32_t j = 0; j < 4; ++j)
+            {
+                const uint8_t* row =
+                    topLeft + j * stride;
+
+                for (int32_t k = 0; k < 16; ++k)
+                {
+                    columns[k] += static_cast<uint32_t>(weights[4 + j]) * row[k];
+                }
+            }
+
+            for (int32_t channel = 0; channel < 4; ++channel)
+            {
+                uint32_t sum = 1u << (c_weightBits - 1);
+
+                for (int32_t i = 0; i < 4; ++i)
+                {
+                    sum += weights[i] * columns[4 * i + channel];
+                }
+
+                pixel[channel] = static_cast<uint8_t>(sum >> c_weightBits);
+            }
+        }
+#endif /* RMCV_UNDISTORT_DOWNSCALE_SSE2 */
+
+        void FilterPixel(
+            const uint8_t* topLeft,
+            const size_t stride,
+            const uint8_t weights[8],
+            uint8_t* pixel)
+        {
+#if RMCV_UNDISTORT_DOWNSCALE_SSE2
+            FilterPixelSse2(topLeft, stride, weights, pixel);
+#else
+            FilterPixelScalar(topLeft, stride, weights, pixel);
+#endif /* RMCV_UNDISTORT_DOWNSCALE_SSE2 */
+        }
+
+        //
+        // Filters the 4x4 pixels from (x, y) when they are partly, or entirely,
+        // outside of the image, copying them with black borders first.
+        //
+        void FilterBorderPixel(
+            const cv::Mat& image,
+            const int32_t x,
+            const int32_t y,
+            const uint8_t weights[8],
+            uint8_t* pixel)
+        {
+            uint32_t block[16] = {};
+
+            for (int32_t j = 0; j < 4; ++j)
+            {
+                if (y + j < 0 || y + j >= image.rows)
+                {
+                    continue;
+                }
+
+                for (int32_t i = 0; i < 4; ++i)
+                {
+                    if (x + i >= 0 && x + i < image.cols)
+                    {
+                        block[4 * j + i] = image.ptr<uint32_t>(y + j)[x + i];
+                    }
+                }
+            }
+
+            FilterPixel(
+                reinterpret_cast<const uint8_t*>(block),
+                4 * sizeof(uint32_t),
+                weights,
+                pixel);
+        }
+    }
+
+    //
+    // Applies the map to bands of rows, tile by tile.
+    //
+    class UndistortDownscaleMap::ParallelApply
+        : public cv::ParallelLoopBody
+    {
+    public:
+        ParallelApply(
+            const UndistortDownscaleMap& map,
+            const cv::Mat& image,
+            cv::Mat& downscaledImage)
+            : _map(map)
+            , _image(image)
+            , _downscaledImage(downscaledImage)
+        {
+        }
+
+        virtual void operator()(
+            const cv::Range& bands) const override
+        {
+            for (int32_t band = bands.start; band < bands.end; ++band)
+            {
+                const int32_t top = band * c_bandHeight;
+
+                const int32_t height =
+                    std::min(c_bandHeight, _downscaledImage.rows - top);
+
+                for (int32_t left = 0; left < _downscaledImage.cols; left += c_tileWidth)
+                {
+                    _map.ApplyToTile(
+                        _image,
+                        cv::Rect(left, top, std::min(c_tileWidth, _downscaledImage.cols - left), height),
+                        _downscaledImage);
+                }
+            }
+        }
+
+    private:
+        ParallelApply& operator=(const ParallelApply&) = delete;
+
+    private:
+        const UndistortDownscaleMap& _map;
+        const cv::Mat& _image;
+        cv::Mat& _downscaledImage;
+    };
+
+    UndistortDownscaleMap::UndistortDownscaleMap()
+    {
+    }
+
+    void UndistortDownscaleMap::Create(
+        const cv::Size& imageSize,
+        const cv::Matx33d& cameraMatrix,
+        const cv::Vec<double, 5>& distortionCoefficients)
+    {
+        CV_Assert(
+            imageSize.width >= 2 && imageSize.width < INT16_MAX &&
+            imageSize.height >= 2 && imageSize.height < INT16_MAX);
+
+        _imageSize = imageSize;
+
+        const cv::Size downscaledImageSize =
+            GetDownscaledImageSize();
+
+        _taps.resize(
+            static_cast<size_t>(downscaledImageSize.area()));
+
+        for (int32_t y = 0; y < downscaledImageSize.height; ++y)
+        {
+            for (int32_t x = 0; x < downscaledImageSize.width; ++x)
+            {
+                //
+                // The pixel covers four pixels of the undistorted image, whose
+                // bilinear samples of the distorted image are averaged. Along
+                // each axis, the samples are taken at the average positions of
+                // the pairs of pixels that are side by side.
+                //
+                cv::Point2d samples[4];
+
+                for (int32_t sample = 0; sample < 4; ++sample)
+                {
+                    samples[sample] = Distort(
+                        cameraMatrix,
+                        distortionCoefficients,
+                        2.0 * x + (sample & 1),
+                        2.0 * y + (sample >> 1));
+                }
+
+                Tap& tap =
+                    _taps[static_cast<size_t>(y) * downscaledImageSize.width + x];
+
+                GetFilterWeights(
+                    0.5 * (samples[0].x + samples[2].x),
+                    0.5 * (samples[1].x + samples[3].x),
+                    imageSize.width,
+                    &tap.X,
+                    tap.Weights);
+
+                GetFilterWeights(
+                    0.5 * (samples[0].y + samples[1].y),
+                    0.5 * (samples[2].y + samples[3].y),
+                    imageSize.height,
+                    &tap.Y,
+                    tap.Weights + 4);
+            }
+        }
+    }
+
+    void UndistortDownscaleMap::Apply(
+        const cv::Mat& image,
+        cv::Mat& downscaledImage) const
+    {
+        CV_Assert(
+            !IsEmpty() &&
+            CV_8UC4 == image.type() &&
+            image.size() == _imageSize);
+
+        const cv::Size downscaledImageSize =
+            GetDownscaledImageSize();
+
+        downscaledImage.create(
+            downscaledImageSize,
+            CV_8UC4);
+
+        const int32_t bandCount =
+            (downscaledImageSize.height + c_bandHeight - 1) / c_bandHeight;
+
+        cv::parallel_for_(
+            cv::Range(0, bandCount),
+            ParallelApply(*this, image, downscaledImage));
+    }
+
+    void UndistortDownscaleMap::ApplyToTile(
+        const cv::Mat& image,
+        const cv::Rect& tile,
+        cv::Mat& downscaledImage) const
+    {
+        for (int32_t y = tile.y; y < tile.y + tile.height; ++y)
+        {
+            const Tap* tap =
+                &_taps[static_cast<size_t>(y) * downscaledImage.cols + tile.x];
+
+            uint8_t* pixel =
+                downscaledImage.ptr<uint8_t>(y) + 4 * tile.x;
+
+            for (int32_t x = 0; x < tile.width; ++x, ++tap, pixel += 4)
+            {
+                if (tap->X >= 0 && tap->X + 4 <= image.cols &&
+                    tap->Y >= 0 && tap->Y + 4 <= image.rows)
+                {
+                    FilterPixel(
+                        image.ptr<uint8_t>(tap->Y) + 4 * tap->X,
+                        image.step,
+                        tap->Weights,
+                        pixel);
+                }
+                else
+                {
+                    FilterBorderPixel(
+                        image,
+                        tap->X,
+                        tap->Y,
+                        tap->Weights,
+                        pixel);
+                }
+            }
+        }
+    }
+}